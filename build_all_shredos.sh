@@ -15,12 +15,16 @@ set -euo pipefail
 #  QUICK_BUILD=0|1  - Do not full rebuild for same architecture (default: 0)
 #  FAST_FAIL=0|1    - Exit on first configuration build failure (default: 1)
 #  NEW_VERSION=STR  - Set version string (default: prompts user)
+#  PARALLEL=N       - Build up to N configurations of an architecture at once,
+#                     each in its own output-parallel/<config> directory,
+#                     sharing the download directory and ccache (default: 0)
 #
 # Examples:
 #  ./build_all_shredos.sh x64
 #  ./build_all_shredos.sh all
 #  QUICK_BUILD=1 ./build_all_shredos.sh x32
 #  NEW_VERSION="2024.11_27_x86-64_0.38" ./build_all_shredos.sh x64
+#  PARALLEL=3 ./build_all_shredos.sh all
 ################################################################################
 
 # Location of the version file:
@@ -39,6 +43,9 @@ X32_CONFIGS=(
 	"shredos_iso_extra_i686_lite_defconfig"
 )
 
+# Parent of the per-configuration output directories when building in parallel:
+PARALLEL_OUTPUT_DIR="output-parallel"
+
 # Packages always needing rebuild between runs, even for the same architecture.
 # This only applies when QUICK_BUILD is enabled, otherwise rebuilds everything.
 ALWAYS_REBUILD_PKGS=(
@@ -52,12 +59,16 @@ PRE_CLEAN="${PRE_CLEAN:-1}"
 QUICK_BUILD="${QUICK_BUILD:-0}"
 FAST_FAIL="${FAST_FAIL:-1}"
 NEW_VERSION="${NEW_VERSION:-}"
+PARALLEL="${PARALLEL:-0}"
 
 X64_SUCCESS=0
 X64_FAILED=0
 X32_SUCCESS=0
 X32_FAILED=0
 
+# "<config> <seconds>" for each configuration built in parallel
+BUILD_TIMES=()
+
 GREEN="\033[0;32m"
 YELLOW="\033[0;33m"
 RED="\033[0;31m"
@@ -80,11 +91,13 @@ print_usage() {
 	echo "  QUICK_BUILD=0|1  - Do not full rebuild for same architecture (default: 0)"
 	echo "  FAST_FAIL=0|1    - Exit on first failure (default: 1)"
 	echo "  NEW_VERSION=STR  - Set version string (default: prompts user)"
+	echo "  PARALLEL=N       - Build up to N configurations of an architecture at once (default: 0)"
 	echo ""
 	echo "Examples:"
 	echo "  $0 x64"
 	echo "  $0 all"
 	echo "  QUICK_BUILD=1 PRE_CLEAN=0 $0 x32"
+	echo "  PARALLEL=3 $0 all"
 	echo
 }
 
@@ -165,6 +178,7 @@ display_build_plan() {
 	echo "Pre-Clean:                $PRE_CLEAN"
 	echo "Quick Build:              $QUICK_BUILD"
 	echo "Fast Failure:             $FAST_FAIL"
+	echo "Parallel Builds:          $PARALLEL"
 	echo "Total Configurations:     $total_configs"
 	echo "Building Architectures:   $BUILD_TARGET"
 	echo "==============================================="
@@ -374,6 +388,114 @@ build_config() {
 	fi
 }
 
+# Sum the step times Buildroot records in build-time.log for each package,
+# longest first.
+summarize_build_time() {
+	local build_time_log="$1"
+
+	[ -f "$build_time_log" ] || return 0
+	awk -F: '
+		{
+			gsub(/ /, "", $2); gsub(/ /, "", $3); gsub(/ /, "", $4)
+			key = $4 ":" $3
+		}
+		$2 == "start" { start[key] = $1 }
+		$2 == "end" && (key in start) { total[$4] += $1 - start[key] }
+		END { for (pkg in total) printf "%10.1fs  %s\n", total[pkg], pkg }
+	' "$build_time_log" | sort -rn
+}
+
+# Build one configuration in its own output directory, quietly, leaving
+# "<exit code> <seconds>" in dist/.<config>.status. Runs in the background.
+build_config_parallel() {
+	local config="$1"
+	local jlevel="$2"
+	local output="$PARALLEL_OUTPUT_DIR/$config"
+	local start=$SECONDS
+	local rc=0
+
+	if build_config_parallel_steps "$config" "$jlevel" "$output" > "dist/${config}.log" 2>&1; then
+		rc=0
+	else
+		rc=$?
+	fi
+	summarize_build_time "$output/build/build-time.log" > "dist/${config}-build-time.txt"
+	echo "$rc $((SECONDS - start))" > "dist/.${config}.status"
+}
+
+build_config_parallel_steps() {
+	local config="$1"
+	local jlevel="$2"
+	local output="$3"
+	local fresh=1
+
+	if [ -f "$output/.config" ]; then
+		if [ "$PRE_CLEAN" -eq 1 ]; then
+			run_cmd make O="$output" clean || return 1
+		else
+			fresh=0
+		fi
+	fi
+	run_cmd make O="$output" "$config" || return 1
+	# Share one compiler cache between all the builds
+	run_cmd utils/config --file "$output/.config" --enable BR2_CCACHE || return 1
+	run_cmd make O="$output" olddefconfig || return 1
+	if [ "$fresh" -eq 0 ]; then
+		for pkg in "${ALWAYS_REBUILD_PKGS[@]}"; do
+			run_cmd make O="$output" "${pkg}-reconfigure" || return 1
+		done
+	fi
+	run_cmd make O="$output" BR2_JLEVEL="$jlevel"
+}
+
+# Build the given configurations of one architecture, up to PARALLEL at a
+# time, splitting the processors between the builds running together.
+build_configs_parallel() {
+	local arch="$1"
+	shift
+	local configs=("$@")
+	local slots=$PARALLEL
+	local config rc seconds
+
+	[ "$slots" -gt ${#configs[@]} ] && slots=${#configs[@]}
+	local jlevel=$(( $(nproc) / slots ))
+	[ "$jlevel" -lt 1 ] && jlevel=1
+
+	echo "Building ${#configs[@]} configuration(s) ($arch), $slots at a time with $jlevel job(s) each..."
+	for config in "${configs[@]}"; do
+		while [ "$(jobs -rp | wc -l)" -ge "$slots" ]; do
+			wait -n || true
+		done
+		printf "%b" "$YELLOW"
+		echo "Started: '$config' ($arch), log in 'dist/${config}.log'"
+		printf "%b" "$RESET"
+		if [ "$DRY_RUN" -eq 1 ]; then
+			build_config_parallel_steps "$config" "$jlevel" "$PARALLEL_OUTPUT_DIR/$config"
+		else
+			rm -f "dist/.${config}.status"
+			build_config_parallel "$config" "$jlevel" &
+		fi
+	done
+	wait
+
+	for config in "${configs[@]}"; do
+		rc=1
+		seconds=0
+		if [ "$DRY_RUN" -eq 1 ]; then
+			rc=0
+		elif [ -f "dist/.${config}.status" ]; then
+			read -r rc seconds < "dist/.${config}.status"
+			rm -f "dist/.${config}.status"
+		fi
+		BUILD_TIMES+=("$config $seconds")
+		if [ "$rc" -eq 0 ]; then
+			build_config_success "$config" "$arch" "dist/${config}.log" "$PARALLEL_OUTPUT_DIR/$config" || true
+		else
+			build_config_failed "$config" "$arch" "dist/${config}.log" || true
+		fi
+	done
+}
+
 print_summary_and_exit() {
 	local return_code="$1"
 	local total_success=$((X64_SUCCESS + X32_SUCCESS))
@@ -389,6 +511,15 @@ print_summary_and_exit() {
 	echo "--------------------------------------------"
 	echo "Total:  $total_success succeeded, $total_failed failed (out of $total_builds)"
 	echo "--------------------------------------------"
+	if [ ${#BUILD_TIMES[@]} -gt 0 ]; then
+		local entry
+		for entry in "${BUILD_TIMES[@]}"; do
+			set -- $entry
+			printf "%-40s %4dh %02dm %02ds\n" "$1" $(($2 / 3600)) $(($2 / 60 % 60)) $(($2 % 60))
+		done
+		echo "Per-package times are in 'dist/<config>-build-time.txt'."
+		echo "--------------------------------------------"
+	fi
 	echo "You will find all output files of the builds in the 'dist/' folder."
 	echo "Check 'build_all_shredos.log' for all the commands that were executed."
 	echo "============================================"
@@ -407,17 +538,18 @@ build_config_success() {
 	local config="$1"
 	local arch="$2"
 	local log_file="$3"
+	local output="${4:-output}"
 
 	if [ -f "$log_file" ]; then
 		run_cmd mv "$log_file" "dist/${config}-SUCCESS.log"
 	fi
 
-	rename_and_checksum_images "$config"
+	rename_and_checksum_images "$config" "$output/images"
 
 	run_cmd mkdir -p "dist/$config"
-	run_cmd mv output/images/shredos*.iso "dist/$config/" 2>/dev/null || true
-	run_cmd mv output/images/shredos*.img "dist/$config/" 2>/dev/null || true
-	run_cmd mv output/images/shredos*.sha1 "dist/$config/" 2>/dev/null || true
+	run_cmd mv "$output"/images/shredos*.iso "dist/$config/" 2>/dev/null || true
+	run_cmd mv "$output"/images/shredos*.img "dist/$config/" 2>/dev/null || true
+	run_cmd mv "$output"/images/shredos*.sha1 "dist/$config/" 2>/dev/null || true
 
 	printf "%b" "$GREEN"
 	echo
@@ -480,7 +612,7 @@ insert_suffix() {
 
 rename_and_checksum_images() {
     local config="$1"
-    target_dir="output/images"
+    target_dir="${2:-output/images}"
 
     # If the defconfig contains the string `lite`, i.e a reduced size
     # so it will boot on systems with only 512MB of RAM then insert
@@ -563,6 +695,15 @@ if [ "$DRY_RUN" -eq 1 ]; then
 	printf "%b" "$RESET"
 fi
 
+echo "Checking that all configurations resolve..."
+if ! run_cmd make O="$PARALLEL_OUTPUT_DIR/batchconfig" \
+	BATCH_DEFCONFIGS="${X64_CONFIGS[*]} ${X32_CONFIGS[*]}" batchconfig; then
+	printf "%b" "$RED"
+	echo "Error: Not all configurations could be resolved"
+	printf "%b" "$RESET"
+	exit 1
+fi
+
 if [ "$PRE_CLEAN" -eq 1 ]; then
 	printf "%b" "$RED"
 	echo
@@ -597,7 +738,7 @@ printf "%b" "$RESET"
 
 sleep 10
 
-if [ "$PRE_CLEAN" -eq 1 ]; then
+if [ "$PRE_CLEAN" -eq 1 ] && [ "$PARALLEL" -eq 0 ]; then
 	echo "Running 'make clean' on the building environment..."
 	run_cmd make clean
 fi
@@ -617,15 +758,19 @@ if [ ${#X64_CONFIGS[@]} -gt 0 ]; then
 	echo
 	replace_version "i686" "x86-64"
 
-	CFG_INDEX=0
-	for config in "${X64_CONFIGS[@]}"; do
-		build_config "$CFG_INDEX" "$config" "x64" || true
-		((++CFG_INDEX))
-	done
+	if [ "$PARALLEL" -gt 0 ]; then
+		build_configs_parallel "x64" "${X64_CONFIGS[@]}"
+	else
+		CFG_INDEX=0
+		for config in "${X64_CONFIGS[@]}"; do
+			build_config "$CFG_INDEX" "$config" "x64" || true
+			((++CFG_INDEX))
+		done
+	fi
 fi
 
 if [ ${#X32_CONFIGS[@]} -gt 0 ]; then
-	if [ ${#X64_CONFIGS[@]} -gt 0 ]; then
+	if [ ${#X64_CONFIGS[@]} -gt 0 ] && [ "$PARALLEL" -eq 0 ]; then
 		run_cmd make clean
 		FORCE_CLEAN=1 # Need this for architecture change
 	fi
@@ -637,9 +782,13 @@ if [ ${#X32_CONFIGS[@]} -gt 0 ]; then
 	echo
 	replace_version "x86-64" "i686"
 
-	CFG_INDEX=0
-	for config in "${X32_CONFIGS[@]}"; do
-		build_config "$CFG_INDEX" "$config" "x32" || true
-		((++CFG_INDEX))
-	done
+	if [ "$PARALLEL" -gt 0 ]; then
+		build_configs_parallel "x32" "${X32_CONFIGS[@]}"
+	else
+		CFG_INDEX=0
+		for config in "${X32_CONFIGS[@]}"; do
+			build_config "$CFG_INDEX" "$config" "x32" || true
+			((++CFG_INDEX))
+		done
+	fi
 fi
@@ -34,7 +34,8 @@
 #ifndef __APPLE__
 #include <sys/sysmacros.h>     /* major() and minor() */
 #endif
-#include <ftw.h>
+#include <dirent.h>
+#include <limits.h>
 #ifdef EXTENDED_ATTRIBUTES
 #include <sys/capability.h>
 #endif /* EXTENDED_ATTRIBUTES */
@@ -257,46 +258,111 @@ char *bb_get_chomped_line_from_file(FILE *file)
 	return private_get_line_from_file(file, 1);
 }
 
+/* User and group names, read from etc/passwd and etc/group on the
+ * first lookup of each, rather than rescanning the file for every
+ * line of the table. As with a scan, the first entry of a name wins.
+ */
+#define ID_HASH_SIZE 1024
+
+struct id_entry {
+	struct id_entry *next;
+	long id;
+	char name[];
+};
+
+struct id_table {
+	struct id_entry *hash[ID_HASH_SIZE];
+	int loaded;
+};
+
+struct id_table passwd_ids, group_ids;
+
+unsigned int id_hash(const char *name)
+{
+	unsigned int h = 5381;
+
+	while (*name)
+		h = h * 33 + (unsigned char)*name++;
+	return h % ID_HASH_SIZE;
+}
+
+struct id_entry *id_lookup(struct id_table *table, const char *name)
+{
+	struct id_entry *e;
+
+	for (e = table->hash[id_hash(name)]; e; e = e->next)
+		if (!strcmp(name, e->name))
+			return e;
+	return NULL;
+}
+
+void id_add(struct id_table *table, const char *name, long id)
+{
+	struct id_entry *e;
+	unsigned int h;
+
+	if (id_lookup(table, name))
+		return;
+	e = xmalloc(sizeof(*e) + strlen(name) + 1);
+	strcpy(e->name, name);
+	e->id = id;
+	h = id_hash(name);
+	e->next = table->hash[h];
+	table->hash[h] = e;
+}
+
 long my_getpwnam(const char *name)
 {
 	struct passwd *myuser;
+	struct id_entry *e;
 	FILE *stream;
 
-	stream = bb_xfopen(PASSWD_PATH, "r");
-	while(1) {
-		errno = 0;
-		myuser = fgetpwent(stream);
-		if (myuser == NULL)
-			bb_error_msg_and_die("unknown user name: %s", name);
-		if (errno)
-			bb_perror_msg_and_die("fgetpwent");
-		if (!strcmp(name, myuser->pw_name))
-			break;
+	if (!passwd_ids.loaded) {
+		stream = bb_xfopen(PASSWD_PATH, "r");
+		while(1) {
+			errno = 0;
+			myuser = fgetpwent(stream);
+			if (myuser == NULL)
+				break;
+			if (errno)
+				bb_perror_msg_and_die("fgetpwent");
+			id_add(&passwd_ids, myuser->pw_name, myuser->pw_uid);
+		}
+		fclose(stream);
+		passwd_ids.loaded = 1;
 	}
-	fclose(stream);
 
-	return myuser->pw_uid;
+	e = id_lookup(&passwd_ids, name);
+	if (e == NULL)
+		bb_error_msg_and_die("unknown user name: %s", name);
+	return e->id;
 }
 
 long my_getgrnam(const char *name)
 {
 	struct group *mygroup;
+	struct id_entry *e;
 	FILE *stream;
 
-	stream = bb_xfopen(GROUP_PATH, "r");
-	while(1) {
-		errno = 0;
-		mygroup = fgetgrent(stream);
-		if (mygroup == NULL)
-			bb_error_msg_and_die("unknown group name: %s", name);
-		if (errno)
-			bb_perror_msg_and_die("fgetgrent");
-		if (!strcmp(name, mygroup->gr_name))
-			break;
+	if (!group_ids.loaded) {
+		stream = bb_xfopen(GROUP_PATH, "r");
+		while(1) {
+			errno = 0;
+			mygroup = fgetgrent(stream);
+			if (mygroup == NULL)
+				break;
+			if (errno)
+				bb_perror_msg_and_die("fgetgrent");
+			id_add(&group_ids, mygroup->gr_name, mygroup->gr_gid);
+		}
+		fclose(stream);
+		group_ids.loaded = 1;
 	}
-	fclose(stream);
 
-	return mygroup->gr_gid;
+	e = id_lookup(&group_ids, name);
+	if (e == NULL)
+		bb_error_msg_and_die("unknown group name: %s", name);
+	return e->id;
 }
 
 unsigned long get_ug_id(const char *s, long (*my_getxxnam)(const char *))
@@ -437,24 +503,72 @@ void bb_show_usage(void)
 	exit(1);
 }
 
-int bb_recursive(const char *fpath, const struct stat *sb,
-		int tflag, struct FTW *ftwbuf){
+/* Apply recursive_uid, recursive_gid and recursive_mode to name, in the
+ * directory parent, and everything below it. This walks the tree as
+ * nftw(FTW_MOUNT | FTW_PHYS) did, but through directory fds, so each
+ * chown and chmod resolves a single name rather than the whole path.
+ * path holds name's full path, for messages, and is extended in place
+ * for the entries below it; len is its length.
+ */
+int bb_recursive(int parent, const char *name, char *path, size_t len,
+		const dev_t *dev)
+{
+	struct stat st;
+	struct dirent *de;
+	DIR *dir = NULL;
+	size_t n;
+	int fd, ret = 0;
 
-	if (lchown(fpath, recursive_uid, recursive_gid) == -1) {
-		bb_perror_msg("chown failed for %s", fpath);
+	if (fstatat(parent, name, &st, AT_SYMLINK_NOFOLLOW) < 0)
 		return -1;
+	/* do not cross mount points */
+	if (dev && st.st_dev != *dev)
+		return 0;
+
+	/* Open directories before changing their mode; one that cannot be
+	 * read is still chowned, but not walked */
+	if (S_ISDIR(st.st_mode)) {
+		fd = openat(parent, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+		if (fd >= 0 && (dir = fdopendir(fd)) == NULL)
+			close(fd);
 	}
 
-	/* chmod() is optional, also skip if dangling symlink */
-	if (recursive_mode == -1 || (tflag == FTW_SL && !access(fpath, F_OK)))
-		return 0;
+	if (fchownat(parent, name, recursive_uid, recursive_gid, AT_SYMLINK_NOFOLLOW) == -1) {
+		bb_perror_msg("chown failed for %s", path);
+		ret = -1;
+		goto out;
+	}
 
-	if (chmod(fpath, recursive_mode) < 0) {
-		bb_perror_msg("chmod failed for %s", fpath);
-		return -1;
+	/* chmod() is optional, also skip if dangling symlink */
+	if (recursive_mode != -1 &&
+	    !(S_ISLNK(st.st_mode) && !faccessat(parent, name, F_OK, 0)) &&
+	    fchmodat(parent, name, recursive_mode, 0) < 0) {
+		bb_perror_msg("chmod failed for %s", path);
+		ret = -1;
+		goto out;
 	}
 
-	return 0;
+	while (dir && (de = readdir(dir))) {
+		if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+			continue;
+		n = strlen(de->d_name);
+		if (len + 1 + n >= PATH_MAX) {
+			errno = ENAMETOOLONG;
+			bb_perror_msg("%s/%s", path, de->d_name);
+			ret = -1;
+			break;
+		}
+		path[len] = '/';
+		memcpy(path + len + 1, de->d_name, n + 1);
+		ret = bb_recursive(dirfd(dir), de->d_name, path, len + 1 + n, &st.st_dev);
+		path[len] = '\0';
+		if (ret)
+			break;
+	}
+out:
+	if (dir)
+		closedir(dir);
+	return ret;
 }
 
 int main(int argc, char **argv)
@@ -466,6 +580,7 @@ int main(int argc, char **argv)
 	char *line = NULL;
 	int linenum = 0;
 	int ret = EXIT_SUCCESS;
+	static char path[PATH_MAX];
 
 	bb_applet_name = basename(argv[0]);
 
@@ -597,7 +712,14 @@ int main(int argc, char **argv)
 			recursive_uid = uid;
 			recursive_gid = gid;
 			recursive_mode = mode;
-			if (nftw(full_name, bb_recursive, 20, FTW_MOUNT | FTW_PHYS) < 0) {
+			if (strlen(full_name) >= PATH_MAX) {
+				errno = ENAMETOOLONG;
+				bb_perror_msg("line %d: %s", linenum, full_name);
+				ret = EXIT_FAILURE;
+				goto loop;
+			}
+			strcpy(path, full_name);
+			if (bb_recursive(AT_FDCWD, path, path, strlen(path), NULL) < 0) {
 				bb_perror_msg("line %d: recursive failed for %s", linenum, full_name);
 				ret = EXIT_FAILURE;
 				goto loop;
@@ -606,7 +728,8 @@ int main(int argc, char **argv)
 		{
 			dev_t rdev;
 			unsigned i;
-			char *full_name_inc;
+			char *full_name_inc, *name_inc, *slash;
+			int dir;
 
 			if (type == 'p') {
 				mode |= S_IFIFO;
@@ -622,24 +745,37 @@ int main(int argc, char **argv)
 				goto loop;
 			}
 
+			/* Create the whole range relative to its directory */
+			slash = strrchr(full_name, '/');
+			*slash = '\0';
+			dir = open(*full_name ? full_name : "/", O_RDONLY | O_DIRECTORY);
+			*slash = '/';
+			if (dir < 0) {
+				bb_perror_msg("line %d: can't open directory of %s", linenum, full_name);
+				ret = EXIT_FAILURE;
+				goto loop;
+			}
+
 			full_name_inc = xmalloc(strlen(full_name) + sizeof(int)*3 + 2);
+			name_inc = full_name_inc + (slash + 1 - full_name);
 			if (count)
 				count--;
 			for (i = start; i <= start + count; i++) {
 				sprintf(full_name_inc, count ? "%s%u" : "%s", full_name, i);
 				rdev = makedev(major, minor + (i - start) * increment);
-				if (mknod(full_name_inc, mode, rdev) < 0) {
+				if (mknodat(dir, name_inc, mode, rdev) < 0) {
 					bb_perror_msg("line %d: can't create node %s", linenum, full_name_inc);
 					ret = EXIT_FAILURE;
-				} else if (lchown(full_name_inc, uid, gid) < 0) {
+				} else if (fchownat(dir, name_inc, uid, gid, AT_SYMLINK_NOFOLLOW) < 0) {
 					bb_perror_msg("line %d: can't chown %s", linenum, full_name_inc);
 					ret = EXIT_FAILURE;
-				} else if (chmod(full_name_inc, mode) < 0) {
+				} else if (fchmodat(dir, name_inc, mode, 0) < 0) {
 					bb_perror_msg("line %d: can't chmod %s", linenum, full_name_inc);
 					ret = EXIT_FAILURE;
 				}
 			}
 			free(full_name_inc);
+			close(dir);
 		}
 loop:
 		free(line);
@@ -54,6 +54,14 @@
 #include <crypt.h>
 #endif
 
+/* libxcrypt, for crypt_gensalt() and the methods only it encodes */
+#if defined __GLIBC__ && !defined HAVE_LINUX_CRYPT_GENSALT
+#include <crypt.h>
+#endif
+#ifdef CRYPT_GENSALT_IMPLEMENTS_AUTO_ENTROPY
+#define HAVE_XCRYPT_GENSALT
+#endif
+
 /* Application-specific */
 #include "utils.h"
 
@@ -68,6 +76,8 @@ static const struct option longopts[] = {
     {"stdin",		no_argument,		NULL, 's'},
     {"salt",		required_argument,	NULL, 'S'},
     {"rounds",		required_argument,	NULL, 'R'},
+    {"benchmark",	no_argument,		NULL, 'b'},
+    {"target-ms",	required_argument,	NULL, 't'},
     {"version",		no_argument,		NULL, 'V'},
     {NULL,		0,			NULL, 0  }
 };
@@ -118,6 +128,13 @@ static const struct crypt_method methods[] = {
      */
 #if defined __SVR4 && defined __sun
     { "sunmd5",		"$md5$", 8,	8,	1, "SunMD5" },
+#endif
+#if defined HAVE_XCRYPT_GENSALT && !defined HAVE_LINUX_CRYPT_GENSALT
+    { "bcrypt",		"$2b$", 22,	22,	1, "bcrypt" },
+#endif
+#if defined HAVE_XCRYPT_GENSALT
+    /* the salt and cost are encoded by crypt_gensalt() */
+    { "yescrypt",	"$y$",	0,	0,	1, "yescrypt" },
 #endif
     { NULL,		NULL,	0,	0,	0, NULL }
 };
@@ -127,6 +144,10 @@ void *get_random_bytes(const int len);
 void display_help(int error);
 void display_version(void);
 void display_methods(void);
+double time_crypt(const char *setting);
+char *make_setting(const struct crypt_method *method, unsigned int cost);
+unsigned int calibrate(const struct crypt_method *method, double target_ms,
+	int verbose, double *ms);
 
 int main(int argc, char *argv[])
 {
@@ -138,6 +159,9 @@ int main(int argc, char *argv[])
     const char *salt_prefix = NULL;
     const char *salt_arg = NULL;
     unsigned int rounds = 0;
+    const struct crypt_method *method = NULL;
+    int benchmark = 0;
+    double target_ms = 0;
     char *salt = NULL;
     char rounds_str[30];
     char *password = NULL;
@@ -151,7 +175,7 @@ int main(int argc, char *argv[])
     /* prepend options from environment */
     argv = merge_args(getenv("MKPASSWD_OPTIONS"), argv, &argc);
 
-    while ((ch = GETOPT_LONGISH(argc, argv, "hH:m:5P:R:sS:V", longopts, 0))
+    while ((ch = GETOPT_LONGISH(argc, argv, "bhH:m:5P:R:sS:t:V", longopts, 0))
 	    > 0) {
 	switch (ch) {
 	case '5':
@@ -165,6 +189,7 @@ int main(int argc, char *argv[])
 	    }
 	    for (i = 0; methods[i].method != NULL; i++)
 		if (strcaseeq(methods[i].method, optarg)) {
+		    method = &methods[i];
 		    salt_prefix = methods[i].prefix;
 		    salt_minlen = methods[i].minlen;
 		    salt_maxlen = methods[i].maxlen;
@@ -196,6 +221,19 @@ int main(int argc, char *argv[])
 		}
 	    }
 	    break;
+	case 'b':
+	    benchmark = 1;
+	    break;
+	case 't':
+	    {
+		char *p;
+		target_ms = strtod(optarg, &p);
+		if (p == optarg || *p != '\0' || target_ms <= 0) {
+		    fprintf(stderr, _("Invalid number '%s'.\n"), optarg);
+		    exit(1);
+		}
+	    }
+	    break;
 	case 's':
 	    password_fd = 0;
 	    break;
@@ -226,6 +264,46 @@ int main(int argc, char *argv[])
 	display_help(EXIT_FAILURE);
     }
 
+    /*
+     * Calibration: find the cost of each method with variable rounds, or
+     * of the selected one, that makes crypt() take at least target_ms.
+     * Without a password to hash, print the result for each method.
+     */
+    if (benchmark || target_ms > 0) {
+	if (rounds) {
+	    fprintf(stderr, _("--rounds cannot be used with --target-ms.\n"));
+	    exit(1);
+	}
+	if (method && !method->rounds) {
+	    fprintf(stderr, _("Method '%s' has no variable cost.\n"),
+		    method->method);
+	    exit(1);
+	}
+	if (target_ms <= 0)
+	    target_ms = 250;
+	if (benchmark || (argc == 0 && password_fd == -1)) {
+	    for (i = 0; methods[i].method != NULL; i++) {
+		const struct crypt_method *m = &methods[i];
+		unsigned int cost;
+		double ms;
+		char *setting;
+
+		if (!m->rounds || (method && m != method))
+		    continue;
+		cost = calibrate(m, target_ms, benchmark, &ms);
+		setting = make_setting(m, cost);
+		printf("%s\t-R %u\t%.1f ms\t%s\n", m->method, cost, ms, setting);
+		free(setting);
+	    }
+	    exit(0);
+	}
+	if (!method) {
+	    fprintf(stderr, _("--target-ms needs a --method to hash with.\n"));
+	    exit(1);
+	}
+	rounds = calibrate(method, target_ms, 0, NULL);
+    }
+
     /* default: DES password */
     if (!salt_prefix) {
 	salt_minlen = methods[0].minlen;
@@ -233,7 +311,8 @@ int main(int argc, char *argv[])
 	salt_prefix = methods[0].prefix;
     }
 
-    if (streq(salt_prefix, "$2a$") || streq(salt_prefix, "$2y$")) {
+    if (streq(salt_prefix, "$2a$") || streq(salt_prefix, "$2y$")
+	    || streq(salt_prefix, "$2b$")) {
 	/* OpenBSD Blowfish and derivatives */
 	if (rounds <= 5)
 	    rounds = 5;
@@ -244,6 +323,16 @@ int main(int argc, char *argv[])
     else
 	rounds_str[0] = '\0';
 
+#ifdef HAVE_XCRYPT_GENSALT
+    if (streq(salt_prefix, "$y$")) {
+	if (salt_arg) {
+	    fprintf(stderr, _("Method '%s' does not take a salt.\n"),
+		    "yescrypt");
+	    exit(1);
+	}
+	salt = make_setting(method, rounds);
+    } else
+#endif
     if (salt_arg) {
 	unsigned int c = strlen(salt_arg);
 	if (c < salt_minlen || c > salt_maxlen) {
@@ -423,6 +512,119 @@ void generate_salt(char *const buf, const unsigned int len)
 
 #endif /* RANDOM_DEVICE */
 
+/*
+ * Return the time, in milliseconds, crypt() takes with this setting: the
+ * best of three runs, so that a busy machine does not inflate it.
+ */
+double time_crypt(const char *setting)
+{
+    struct timespec start, end;
+    double ms, best = 0;
+    const char *result;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	result = crypt("benchmark", setting);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (!result || result[0] == '*') {
+	    fprintf(stderr, "crypt failed.\n");
+	    exit(2);
+	}
+	ms = (end.tv_sec - start.tv_sec) * 1e3
+	    + (end.tv_nsec - start.tv_nsec) / 1e6;
+	if (i == 0 || ms < best)
+	    best = ms;
+    }
+    return best;
+}
+
+/*
+ * Return a newly allocated setting (prefix, cost and random salt) for
+ * the method at this cost, as the default code path would build it.
+ */
+char *make_setting(const struct crypt_method *method, unsigned int cost)
+{
+    char *setting;
+
+#ifdef HAVE_XCRYPT_GENSALT
+    if (streq(method->prefix, "$y$")) {
+	const char *p = crypt_gensalt(method->prefix, cost, NULL, 0);
+
+	if (!p) {
+	    fprintf(stderr, "crypt_gensalt failed.\n");
+	    exit(2);
+	}
+	return NOFAIL(strdup(p));
+    }
+#endif
+    setting = NOFAIL(malloc(strlen(method->prefix) + 30 + method->maxlen + 1));
+    if (streq(method->prefix, "$2a$") || streq(method->prefix, "$2y$")
+	    || streq(method->prefix, "$2b$"))
+	sprintf(setting, "%s%02u$", method->prefix, cost);
+    else
+	sprintf(setting, "%srounds=%u$", method->prefix, cost);
+    generate_salt(setting + strlen(setting), method->maxlen);
+    return setting;
+}
+
+/*
+ * Return the lowest cost of the method for which crypt() takes at least
+ * target_ms, or the highest one the method accepts. Costs that are the
+ * logarithm of the work (Blowfish, yescrypt) are tried in turn; round
+ * counts are scaled by the time measured until the target is met.
+ * If verbose, print each step to stderr; if ms, store the time there.
+ */
+unsigned int calibrate(const struct crypt_method *method, double target_ms,
+	int verbose, double *ms)
+{
+    unsigned int cost, min_cost, max_cost;
+    int logarithmic = 1;
+    double t, scale;
+    char *setting;
+
+    if (streq(method->prefix, "$2a$") || streq(method->prefix, "$2y$")
+	    || streq(method->prefix, "$2b$")) {
+	min_cost = 5;
+	max_cost = 31;
+    } else if (streq(method->prefix, "$y$")) {
+	min_cost = 1;
+	max_cost = 11;
+    } else {
+	/* SHA-crypt bounds; scaling starts from the default 5000 */
+	logarithmic = 0;
+	min_cost = 1000;
+	max_cost = 999999999;
+    }
+
+    cost = logarithmic ? min_cost : 5000;
+    while (1) {
+	setting = make_setting(method, cost);
+	t = time_crypt(setting);
+	free(setting);
+	if (verbose)
+	    fprintf(stderr, "%s\t-R %u\t%.1f ms\n", method->method, cost, t);
+	if (t >= target_ms || cost >= max_cost)
+	    break;
+	if (logarithmic) {
+	    cost++;
+	    continue;
+	}
+	/* rounds cost linear time: aim a little over the target, but
+	 * do not trust the scale of a run too short to measure */
+	scale = t > 0.5 ? target_ms / t * 1.02 : 16;
+	if (scale > 16)
+	    scale = 16;
+	if (scale < 1.01)
+	    scale = 1.01;
+	cost = (double)cost * scale > max_cost ? max_cost
+	    : (unsigned int)((double)cost * scale);
+    }
+    if (ms)
+	*ms = t;
+    return cost;
+}
+
 void display_help(int error)
 {
     fprintf((EXIT_SUCCESS == error) ? stdout : stderr,
@@ -433,6 +635,10 @@ void display_help(int error)
 "      -5                    like --method=md5\n"
 "      -S, --salt=SALT       use the specified SALT\n"
 "      -R, --rounds=NUMBER   use the specified NUMBER of rounds\n"
+"      -t, --target-ms=MS    use the rounds that make a hash take MS\n"
+"                            milliseconds to verify on this machine\n"
+"      -b, --benchmark       show the rounds each method needs for\n"
+"                            --target-ms (default 250) and their timings\n"
 "      -P, --password-fd=NUM read the password from file descriptor NUM\n"
 "                            instead of /dev/tty\n"
 "      -s, --stdin           like --password-fd=0\n"
@@ -442,6 +648,8 @@ void display_help(int error)
 "If PASSWORD is missing then it is asked interactively.\n"
 "If no SALT is specified, a random one is generated.\n"
 "If TYPE is 'help', available methods are printed.\n"
+"With --target-ms and no PASSWORD, the rounds and a setting string are\n"
+"printed for each method with variable rounds, or the selected one.\n"
 "\n"
 "Report bugs to %s.\n"), "<md+whois@linux.it>");
     exit(error);
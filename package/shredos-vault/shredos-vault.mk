@@ -11,13 +11,26 @@ SHREDOS_VAULT_SITE_METHOD = local
 SHREDOS_VAULT_DEPENDENCIES = ncurses cryptsetup libconfig nwipe
 SHREDOS_VAULT_LICENSE = GPL-2.0+
 
+# shredos-vault-gate: the lean build the installer deploys to hosts
+SHREDOS_VAULT_CONF_OPTS = --enable-gate
+
 # Optional dependencies
 ifeq ($(BR2_PACKAGE_SHREDOS_VAULT_FINGERPRINT),y)
 SHREDOS_VAULT_DEPENDENCIES += libfprint
+SHREDOS_VAULT_CONF_OPTS += --enable-fingerprint
 endif
 
 ifeq ($(BR2_PACKAGE_SHREDOS_VAULT_VOICE),y)
-SHREDOS_VAULT_DEPENDENCIES += portaudio
+SHREDOS_VAULT_DEPENDENCIES += pocketsphinx portaudio
+SHREDOS_VAULT_CONF_OPTS += --enable-voice
+endif
+
+ifeq ($(BR2_PACKAGE_LIBURING),y)
+SHREDOS_VAULT_DEPENDENCIES += liburing
+endif
+
+ifeq ($(BR2_PACKAGE_LIBXCRYPT),y)
+SHREDOS_VAULT_DEPENDENCIES += libxcrypt
 endif
 
 ifeq ($(BR2_PACKAGE_SHREDOS_VAULT_NTFS),y)
@@ -45,4 +58,17 @@ define SHREDOS_VAULT_INSTALL_VAULTGATE
 endef
 SHREDOS_VAULT_POST_INSTALL_TARGET_HOOKS += SHREDOS_VAULT_INSTALL_VAULTGATE
 
+ifeq ($(BR2_PACKAGE_SHREDOS_VAULT_BENCH),y)
+define SHREDOS_VAULT_BUILD_BENCH
+	$(TARGET_MAKE_ENV) $(MAKE) -C $(@D) vault-wipe-bench vault-auth-bench
+endef
+SHREDOS_VAULT_POST_BUILD_HOOKS += SHREDOS_VAULT_BUILD_BENCH
+
+define SHREDOS_VAULT_INSTALL_BENCH
+	$(INSTALL) -m 755 $(@D)/vault-wipe-bench $(@D)/vault-auth-bench \
+		$(TARGET_DIR)/usr/bin/
+endef
+SHREDOS_VAULT_POST_INSTALL_TARGET_HOOKS += SHREDOS_VAULT_INSTALL_BENCH
+endif
+
 $(eval $(autotools-package))
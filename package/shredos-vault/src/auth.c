@@ -4,42 +4,234 @@
  * Runs the authentication loop, calling TUI for password input
  * and checking against the stored hash. Tracks failed attempts.
  *
+ * A calibrated hash takes hundreds of milliseconds to check, so the
+ * check runs on a worker thread while the TUI animates, and every
+ * attempt is held to the same wall-clock floor whatever its outcome.
+ *
+ * With fingerprints configured, the reader identifies in the
+ * background throughout (see auth_fingerprint.h). The login screen
+ * returns as soon as it has a verdict, and a match that lands while a
+ * password is being checked still wins. The reader is only armed while
+ * the login screen is up: a finger that is not recognised there costs
+ * an attempt, like a wrong password, and one anywhere else is ignored.
+ *
+ * A voice passphrase works the same way once the user presses Tab
+ * (see auth_voice.h), except that an attempt where nothing was heard
+ * is not counted.
+ *
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* clock_gettime, nanosleep */
+#endif
+
 #include "auth.h"
 #include "auth_password.h"
+#include "auth_fingerprint.h"
+#include "auth_voice.h"
+#include "events.h"
 #include "tui.h"
 #include "platform.h"
 
 #include <string.h>
 
+#if defined(VAULT_PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <errno.h>
+  #include <time.h>
+#endif
+
+/* Shortest an attempt may take, and how often the TUI animates */
+#define AUTH_FLOOR_MS   500
+#define AUTH_FRAME_MS   100
+
+static double auth_now_ms(void)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    return (double)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+static void auth_sleep_ms(int ms)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    Sleep((DWORD)ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+#endif
+}
+
+typedef struct {
+    const char   *password;
+    const char   *hash;
+    int           match;
+    int           done;
+    vault_mutex_t lock;
+} verify_job_t;
+
+static void *verify_worker(void *arg)
+{
+    verify_job_t *job = (verify_job_t *)arg;
+    int match = vault_auth_password_verify(job->password, job->hash);
+
+    vault_mutex_lock(&job->lock);
+    job->match = match;
+    job->done = 1;
+    vault_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+/* Check password against hash off the UI thread, animating until the
+ * result is in and floor_ms has passed since the attempt started. */
+static int verify_attempt(const char *password, const char *hash,
+                          int floor_ms)
+{
+    double start = auth_now_ms();
+    verify_job_t job = { .password = password, .hash = hash };
+    vault_mutex_init(&job.lock);
+
+    vault_thread_t worker;
+    int threaded = vault_thread_create(&worker, verify_worker, &job) == 0;
+    if (!threaded)
+        verify_worker(&job);
+
+    for (int frame = 0;; frame++) {
+        vault_mutex_lock(&job.lock);
+        int done = job.done;
+        vault_mutex_unlock(&job.lock);
+        if (done && auth_now_ms() - start >= floor_ms) break;
+        vault_tui_verifying(frame);
+        auth_sleep_ms(AUTH_FRAME_MS);
+    }
+    vault_tui_verifying(-1);
+
+    if (threaded) vault_thread_join(worker);
+    vault_mutex_destroy(&job.lock);
+    return job.match;
+}
+
+static void auth_fingerprint_event(const vault_config_t *cfg, int match)
+{
+    vault_event("auth", ",\"method\":\"fingerprint\",\"result\":\"%s\","
+                "\"attempt\":%d,\"max\":%d",
+                match ? "ok" : "denied", cfg->current_attempts + 1,
+                cfg->max_attempts);
+}
+
+static void auth_backends_stop(void)
+{
+    vault_auth_fingerprint_stop();
+    vault_auth_voice_stop();
+}
+
 auth_result_t vault_auth_run(vault_config_t *cfg)
 {
-    char password[256];
+    char *password = vault_secure_alloc(VAULT_PASSWORD_MAX);
+    if (!password) return AUTH_FAILED;
+
+    /* Well past the calibrated check time, so a fast failure (a hash
+     * crypt() rejects outright) looks like any other */
+    int floor_ms = cfg->password_hash_ms * 2;
+    if (floor_ms < AUTH_FLOOR_MS) floor_ms = AUTH_FLOOR_MS;
+
+    /* Normally already started at TUI init, so the reader is open and
+     * the prints loaded by the time the login screen shows */
+    if (cfg->auth_methods & AUTH_METHOD_FINGERPRINT)
+        vault_auth_fingerprint_start();
+    if (cfg->auth_methods & AUTH_METHOD_VOICE)
+        vault_auth_voice_start(cfg->voice_passphrase);
 
     for (cfg->current_attempts = 0;
          cfg->current_attempts < cfg->max_attempts;
          cfg->current_attempts++) {
 
-        memset(password, 0, sizeof(password));
+        memset(password, 0, VAULT_PASSWORD_MAX);
 
-        int n = vault_tui_login_screen(cfg, password, sizeof(password));
+        vault_auth_fingerprint_arm(1);
+        int n = vault_tui_login_screen(cfg, password, VAULT_PASSWORD_MAX);
+        vault_auth_fingerprint_arm(0);
+        if (n == VAULT_TUI_LOGIN_FINGERPRINT) {
+            int r = vault_auth_fingerprint_result();
+            if (r < 0) {
+                /* No verdict after all; not an attempt */
+                cfg->current_attempts--;
+                continue;
+            }
+            auth_fingerprint_event(cfg, r);
+            if (r) {
+                auth_backends_stop();
+                vault_secure_free(password);
+                return AUTH_SUCCESS;
+            }
+            vault_tui_status("Fingerprint not recognised. Try again.");
+            continue;
+        }
+        if (n == VAULT_TUI_LOGIN_VOICE) {
+            int r = vault_auth_voice_result();
+            if (r < 0) {
+                /* Silence is not a guess; this attempt starts over */
+                vault_tui_status("Nothing heard. Press Tab to try again.");
+                cfg->current_attempts--;
+                continue;
+            }
+            vault_event("auth", ",\"method\":\"voice\",\"result\":\"%s\","
+                        "\"attempt\":%d,\"max\":%d",
+                        r ? "ok" : "denied", cfg->current_attempts + 1,
+                        cfg->max_attempts);
+            if (r) {
+                auth_backends_stop();
+                vault_secure_free(password);
+                return AUTH_SUCCESS;
+            }
+            vault_tui_status("Passphrase not recognised. Try again.");
+            continue;
+        }
         if (n <= 0)
             continue;
 
         /* Check password */
         if (cfg->auth_methods & AUTH_METHOD_PASSWORD) {
-            if (vault_auth_password_verify(password, cfg->password_hash)) {
-                vault_secure_memzero(password, sizeof(password));
+            double t0 = auth_now_ms();
+            int match = verify_attempt(password, cfg->password_hash,
+                                       floor_ms);
+            vault_event("auth", ",\"method\":\"password\",\"result\":\"%s\","
+                        "\"attempt\":%d,\"max\":%d,\"ms\":%.0f",
+                        match ? "ok" : "denied", cfg->current_attempts + 1,
+                        cfg->max_attempts, auth_now_ms() - t0);
+            /* The finger may have won while the hash was checked. A miss
+             * can only have been queued before the screen returned, and
+             * counts as it would have there: an attempt of its own,
+             * while any are left */
+            if (!match) {
+                int r = vault_auth_fingerprint_result();
+                if (r == 0 &&
+                    cfg->current_attempts + 1 < cfg->max_attempts)
+                    cfg->current_attempts++;
+                if (r >= 0) auth_fingerprint_event(cfg, r);
+                match = r == 1;
+            }
+            if (match) {
+                auth_backends_stop();
+                vault_secure_free(password);
                 return AUTH_SUCCESS;
             }
         }
 
-        vault_secure_memzero(password, sizeof(password));
+        vault_secure_memzero(password, VAULT_PASSWORD_MAX);
         vault_tui_status("Authentication failed. Try again.");
     }
 
     /* Threshold exceeded */
+    auth_backends_stop();
+    vault_secure_free(password);
     return AUTH_FAILED;
 }
@@ -0,0 +1,294 @@
+/*
+ * auth_fingerprint.c -- Fingerprint Authentication (libfprint)
+ *
+ * One worker thread owns libfprint. It runs a GLib main context of its
+ * own, opens the first reader, loads the enrolled prints into a
+ * gallery and keeps an asynchronous identify running against it. Each
+ * verdict is one byte down a pipe, '1' a match and '0' no match, sent
+ * from the match callback as soon as the reader knows, before the
+ * operation winds down. No match is only sent while the login screen
+ * has armed the reader. A match ends the identify; no match, or a
+ * touch the reader asks to retry, starts the next one.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "auth_fingerprint.h"
+#include "platform.h"
+
+#include <fprint.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static struct {
+    int             started;
+    vault_thread_t  thread;
+    int             pipe[2];        /* verdicts: worker -> login screen */
+    int             armed;          /* misses are sent, not dropped */
+    GCancellable   *cancel;
+    GMainContext   *ctx;
+    FpContext      *fpctx;
+    FpDevice       *dev;
+    GPtrArray      *gallery;        /* enrolled FpPrint */
+    int             identifying;
+    int             posted;         /* this identify's verdict is sent */
+    int             matched;
+} fp = { .pipe = { -1, -1 } };
+
+static void fp_post(int match)
+{
+    char verdict = match ? '1' : '0';
+    ssize_t n;
+
+    fp.posted = 1;
+    if (!match && !__atomic_load_n(&fp.armed, __ATOMIC_ACQUIRE))
+        return;
+    if (match) fp.matched = 1;
+    do {
+        n = write(fp.pipe[1], &verdict, 1);
+    } while (n < 0 && errno == EINTR);
+}
+
+/* Every "<name>.fpr" in VAULT_FINGERPRINT_DIR this reader can match */
+static GPtrArray *load_gallery(FpDevice *dev)
+{
+    GPtrArray *gallery = g_ptr_array_new_with_free_func(g_object_unref);
+    DIR *dir = opendir(VAULT_FINGERPRINT_DIR);
+    struct dirent *de;
+
+    if (!dir) return gallery;
+    while ((de = readdir(dir)) != NULL) {
+        size_t len = strlen(de->d_name);
+        if (len < 5 || strcmp(de->d_name + len - 4, ".fpr") != 0)
+            continue;
+
+        char path[VAULT_CONFIG_MAX_PATH * 2];
+        gchar *data = NULL;
+        gsize size = 0;
+        snprintf(path, sizeof(path), "%s/%s", VAULT_FINGERPRINT_DIR,
+                 de->d_name);
+        if (!g_file_get_contents(path, &data, &size, NULL))
+            continue;
+
+        FpPrint *print = fp_print_deserialize((const guchar *)data, size,
+                                              NULL);
+        g_free(data);
+        if (print && fp_print_compatible(print, dev))
+            g_ptr_array_add(gallery, print);
+        else if (print)
+            g_object_unref(print);
+    }
+    closedir(dir);
+    return gallery;
+}
+
+static void identify_start(void);
+
+static void identify_match(FpDevice *dev, FpPrint *match, FpPrint *print,
+                           gpointer data, GError *error)
+{
+    (void)dev;
+    (void)data;
+    /* A retry (finger off centre, swiped too fast) is no verdict */
+    if (error || !print || fp.posted) return;
+    fp_post(match != NULL);
+}
+
+static void identify_done(GObject *obj, GAsyncResult *res, gpointer data)
+{
+    FpPrint *match = NULL, *print = NULL;
+    GError *error = NULL;
+    (void)data;
+
+    gboolean ok = fp_device_identify_finish(FP_DEVICE(obj), res, &match,
+                                            &print, &error);
+    if (ok && print && !fp.posted)
+        fp_post(match != NULL);
+    if (match) g_object_unref(match);
+    if (print) g_object_unref(print);
+
+    fp.identifying = 0;
+    if (!fp.matched && !g_cancellable_is_cancelled(fp.cancel) &&
+        (ok || error->domain == FP_DEVICE_RETRY))
+        identify_start();
+    g_clear_error(&error);
+}
+
+static void identify_start(void)
+{
+    fp.posted = 0;
+    fp.identifying = 1;
+    fp_device_identify(fp.dev, fp.gallery, fp.cancel, identify_match,
+                       NULL, NULL, identify_done, NULL);
+}
+
+/* The first reader, open, with a gallery to identify against */
+static int fp_open(void)
+{
+    fp.fpctx = fp_context_new();
+    GPtrArray *devices = fp_context_get_devices(fp.fpctx);
+    if (!devices || devices->len == 0) return -1;
+
+    fp.dev = g_object_ref(g_ptr_array_index(devices, 0));
+    if (!fp_device_has_feature(fp.dev, FP_DEVICE_FEATURE_IDENTIFY))
+        return -1;
+    if (!fp_device_open_sync(fp.dev, fp.cancel, NULL))
+        return -1;
+
+    fp.gallery = load_gallery(fp.dev);
+    if (fp.gallery->len == 0) {
+        fp_device_close_sync(fp.dev, NULL, NULL);
+        return -1;
+    }
+    return 0;
+}
+
+static void *fp_worker(void *arg)
+{
+    (void)arg;
+    g_main_context_push_thread_default(fp.ctx);
+    if (fp_open() == 0) {
+        identify_start();
+        while (fp.identifying)
+            g_main_context_iteration(fp.ctx, TRUE);
+        fp_device_close_sync(fp.dev, NULL, NULL);
+    }
+    g_main_context_pop_thread_default(fp.ctx);
+    return NULL;
+}
+
+int vault_auth_fingerprint_start(void)
+{
+    if (fp.started) return 0;
+    if (pipe(fp.pipe) != 0) return -1;
+    fcntl(fp.pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(fp.pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fp.pipe[1], F_SETFD, FD_CLOEXEC);
+
+    fp.cancel = g_cancellable_new();
+    fp.ctx = g_main_context_new();
+    if (vault_thread_create(&fp.thread, fp_worker, NULL) != 0) {
+        vault_auth_fingerprint_stop();
+        return -1;
+    }
+    fp.started = 1;
+    return 0;
+}
+
+int vault_auth_fingerprint_fd(void)
+{
+    return fp.started ? fp.pipe[0] : -1;
+}
+
+void vault_auth_fingerprint_arm(int on)
+{
+    __atomic_store_n(&fp.armed, on != 0, __ATOMIC_RELEASE);
+}
+
+int vault_auth_fingerprint_result(void)
+{
+    char verdict;
+
+    if (!fp.started) return -1;
+    if (read(fp.pipe[0], &verdict, 1) != 1) return -1;
+    return verdict == '1';
+}
+
+void vault_auth_fingerprint_stop(void)
+{
+    if (fp.started) {
+        g_cancellable_cancel(fp.cancel);
+        g_main_context_wakeup(fp.ctx);
+        vault_thread_join(fp.thread);
+    }
+    if (fp.gallery) g_ptr_array_unref(fp.gallery);
+    if (fp.dev) g_object_unref(fp.dev);
+    if (fp.fpctx) g_object_unref(fp.fpctx);
+    if (fp.ctx) g_main_context_unref(fp.ctx);
+    if (fp.cancel) g_object_unref(fp.cancel);
+    for (int i = 0; i < 2; i++)
+        if (fp.pipe[i] >= 0) close(fp.pipe[i]);
+    memset(&fp, 0, sizeof(fp));
+    fp.pipe[0] = fp.pipe[1] = -1;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Enrollment                                                         */
+/* ------------------------------------------------------------------ */
+
+static void enroll_progress(FpDevice *dev, gint stage, FpPrint *print,
+                            gpointer data, GError *error)
+{
+    (void)print;
+    (void)data;
+    if (error)
+        fprintf(stderr, "  %s, again please\n", error->message);
+    else
+        fprintf(stderr, "  stage %d of %d done\n", stage,
+                fp_device_get_nr_enroll_stages(dev));
+}
+
+int vault_auth_fingerprint_enroll(const char *name)
+{
+    GError *error = NULL;
+    FpPrint *print = NULL;
+    guchar *data = NULL;
+    gsize size = 0;
+    int ret = -1;
+
+    if (!name[0] || strchr(name, '/')) {
+        fprintf(stderr, "vault: bad fingerprint name \"%s\"\n", name);
+        return -1;
+    }
+
+    FpContext *ctx = fp_context_new();
+    GPtrArray *devices = fp_context_get_devices(ctx);
+    if (!devices || devices->len == 0) {
+        fprintf(stderr, "vault: no fingerprint reader found\n");
+        g_object_unref(ctx);
+        return -1;
+    }
+    FpDevice *dev = g_ptr_array_index(devices, 0);
+    if (!fp_device_open_sync(dev, NULL, &error))
+        goto out;
+
+    FpPrint *template = fp_print_new(dev);
+    fp_print_set_description(template, name);
+    fprintf(stderr, "Enrolling \"%s\" on %s: touch the reader %d times\n",
+            name, fp_device_get_name(dev),
+            fp_device_get_nr_enroll_stages(dev));
+    print = fp_device_enroll_sync(dev, template, NULL, enroll_progress,
+                                  NULL, &error);
+    fp_device_close_sync(dev, NULL, NULL);
+    if (!print || !fp_print_serialize(print, &data, &size, &error))
+        goto out;
+
+    char path[VAULT_CONFIG_MAX_PATH * 2];
+    snprintf(path, sizeof(path), "%s/%s.fpr", VAULT_FINGERPRINT_DIR, name);
+    if (g_mkdir_with_parents(VAULT_FINGERPRINT_DIR, 0700) != 0 ||
+        !g_file_set_contents(path, (const gchar *)data, (gssize)size,
+                             &error))
+        goto out;
+    g_chmod(path, 0600);
+    fprintf(stderr, "Saved %s\n", path);
+    ret = 0;
+
+out:
+    if (error) {
+        fprintf(stderr, "vault: enrollment failed: %s\n", error->message);
+        g_error_free(error);
+    } else if (ret != 0) {
+        fprintf(stderr, "vault: cannot create %s\n", VAULT_FINGERPRINT_DIR);
+    }
+    g_free(data);
+    if (print) g_object_unref(print);
+    g_object_unref(ctx);
+    return ret;
+}
@@ -0,0 +1,64 @@
+/*
+ * auth_fingerprint.h -- Fingerprint Authentication (libfprint)
+ *
+ * The reader is opened and the enrolled prints loaded as soon as the
+ * TUI is up, on a thread of their own, so the first touch is matched
+ * straight away. From then on an identify runs against all enrolled
+ * prints for as long as the login loop lasts. Each verdict makes
+ * vault_auth_fingerprint_fd() readable, and the login screen waits on
+ * it together with the keyboard: whichever factor completes first wins.
+ * A match is always reported; a finger that is not recognised only
+ * while the reader is armed, so a touch that lands while nothing is
+ * asking for one is not held against the user.
+ *
+ * Enrolled prints are libfprint's serialised FpPrint, one file each,
+ * "<name>.fpr" in VAULT_FINGERPRINT_DIR.
+ *
+ * Without HAVE_FINGERPRINT these are stubs that report no reader.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_AUTH_FINGERPRINT_H
+#define VAULT_AUTH_FINGERPRINT_H
+
+#include "config.h"
+
+#define VAULT_FINGERPRINT_DIR  VAULT_CONFIG_DIR "/fingerprints"
+
+#ifdef HAVE_FINGERPRINT
+
+/* Start opening the first reader and loading the enrolled prints, then
+ * identify against them, all in the background. Returns 0, or -1 if
+ * the thread could not be started. A reader that turns out to be
+ * missing, unable to identify or without prints leaves the fd quiet. */
+int vault_auth_fingerprint_start(void);
+
+/* Readable while a verdict is waiting; -1 when not started. */
+int vault_auth_fingerprint_fd(void);
+
+/* Report misses from now on (on != 0) or drop them. */
+void vault_auth_fingerprint_arm(int on);
+
+/* Take the next verdict without blocking: 1 a match, 0 an enrolled
+ * finger was not recognised, -1 none waiting. */
+int vault_auth_fingerprint_result(void);
+
+/* Cancel the identify, close the reader and free everything. */
+void vault_auth_fingerprint_stop(void);
+
+/* Enroll a finger on the first reader and save it as name, prompting
+ * on stderr. Returns 0 on success, -1 on failure. */
+int vault_auth_fingerprint_enroll(const char *name);
+
+#else
+
+static inline int vault_auth_fingerprint_start(void) { return -1; }
+static inline int vault_auth_fingerprint_fd(void) { return -1; }
+static inline void vault_auth_fingerprint_arm(int on) { (void)on; }
+static inline int vault_auth_fingerprint_result(void) { return -1; }
+static inline void vault_auth_fingerprint_stop(void) { }
+
+#endif /* HAVE_FINGERPRINT */
+
+#endif /* VAULT_AUTH_FINGERPRINT_H */
@@ -1,11 +1,17 @@
 /*
- * auth_password.c -- Password Authentication (SHA-512 via crypt())
+ * auth_password.c -- Password Authentication (crypt())
  *
- * Uses POSIX crypt() with $6$ (SHA-512) and a 16-byte random salt.
+ * Uses crypt() with yescrypt ($y$) where libxcrypt provides it, else
+ * $6$ (SHA-512), with a 16-byte random salt. Either way the cost is
+ * calibrated at setup to a latency budget on the machine itself.
  *
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* clock_gettime */
+#endif
+
 #include "auth_password.h"
 #include "platform.h"
 
@@ -14,45 +20,137 @@
 #include <stdlib.h>
 
 #if defined(VAULT_PLATFORM_WINDOWS)
-  /* Windows: simple SHA-256 fallback using CryptoAPI */
+  /* Windows: salted PBKDF2-SHA512 through CNG */
   #define WIN32_LEAN_AND_MEAN
   #include <windows.h>
-  #include <wincrypt.h>
+  #include <bcrypt.h>
 #else
   #ifdef HAVE_CRYPT_H
     #include <crypt.h>
   #endif
+  #include <time.h>
   #include <unistd.h>
 #endif
 
+#if !defined(VAULT_PLATFORM_WINDOWS)
+
 /* Base64 alphabet for salt generation */
 static const char salt_chars[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789./";
 
-#if !defined(VAULT_PLATFORM_WINDOWS)
+/* SHA-512 crypt's own default and ceiling */
+#define SHA512_ROUNDS_DEFAULT  5000
+#define SHA512_ROUNDS_MAX      999999999UL
 
-int vault_auth_password_hash(const char *password,
-                              char *hash_out, size_t hash_out_size)
+/* libxcrypt's yescrypt cost range; each step doubles the work */
+#define YESCRYPT_COST_MIN      1
+#define YESCRYPT_COST_MAX      11
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* crypt() the password with setting into hash_out; sets *ms to how
+ * long it took. Returns 0 on success, -1 on failure. */
+static int hash_timed(const char *password, const char *setting,
+                      char *hash_out, size_t hash_out_size, double *ms)
+{
+    double t0 = now_ms();
+    char *result = crypt(password, setting);
+    *ms = now_ms() - t0;
+    if (!result || result[0] == '*' || strlen(result) >= hash_out_size)
+        return -1;
+    strcpy(hash_out, result);
+    return 0;
+}
+
+#ifdef CRYPT_GENSALT_IMPLEMENTS_AUTO_ENTROPY
+
+/* yescrypt: raise the cost step by step while a hash stays within the
+ * budget, keeping the last hash that did */
+static int hash_yescrypt(const char *password, int target_ms,
+                         char *hash_out, size_t hash_out_size)
+{
+    char setting[CRYPT_GENSALT_OUTPUT_SIZE];
+    char trial[CRYPT_OUTPUT_SIZE];
+    int ret = -1;
+
+    for (unsigned long cost = YESCRYPT_COST_MIN;
+         cost <= YESCRYPT_COST_MAX; cost++) {
+        uint8_t raw_salt[16];
+        if (vault_platform_random(raw_salt, sizeof(raw_salt)) != 0)
+            break;
+        char *st = crypt_gensalt_rn("$y$", target_ms > 0 ? cost : 0,
+                                    (const char *)raw_salt,
+                                    sizeof(raw_salt), setting,
+                                    sizeof(setting));
+        if (!st) break;
+
+        double ms;
+        if (hash_timed(password, setting, trial, sizeof(trial), &ms) != 0)
+            break;
+        if (ret == 0 && ms > target_ms) break;
+        if (strlen(trial) >= hash_out_size) break;
+        strcpy(hash_out, trial);
+        ret = 0;
+        if (target_ms <= 0 || ms > target_ms) break;
+    }
+    vault_secure_memzero(trial, sizeof(trial));
+    return ret;
+}
+
+#endif /* CRYPT_GENSALT_IMPLEMENTS_AUTO_ENTROPY */
+
+/* SHA-512 crypt: double the rounds until a hash takes an eighth of the
+ * budget, long enough to time, then scale them to the budget, which is
+ * linear in rounds */
+static int hash_sha512(const char *password, int target_ms,
+                       char *hash_out, size_t hash_out_size)
 {
-    /* Generate 16-byte random salt */
     uint8_t raw_salt[16];
     if (vault_platform_random(raw_salt, sizeof(raw_salt)) != 0)
         return -1;
 
-    char salt[32];
-    snprintf(salt, sizeof(salt), "$6$");
+    char salt[17];
     for (int i = 0; i < 16; i++)
-        salt[3 + i] = salt_chars[raw_salt[i] % (sizeof(salt_chars) - 1)];
-    salt[19] = '$';
-    salt[20] = '\0';
+        salt[i] = salt_chars[raw_salt[i] % (sizeof(salt_chars) - 1)];
+    salt[16] = '\0';
 
-    char *result = crypt(password, salt);
-    if (!result || result[0] == '*')
+    char setting[64];
+    snprintf(setting, sizeof(setting), "$6$%s$", salt);
+    double ms;
+    if (hash_timed(password, setting, hash_out, hash_out_size, &ms) != 0)
         return -1;
+    if (target_ms <= 0) return 0;
 
-    strncpy(hash_out, result, hash_out_size - 1);
-    hash_out[hash_out_size - 1] = '\0';
-    return 0;
+    unsigned long rounds = SHA512_ROUNDS_DEFAULT;
+    while (ms < target_ms / 8.0 && rounds < SHA512_ROUNDS_MAX / 2) {
+        rounds *= 2;
+        snprintf(setting, sizeof(setting), "$6$rounds=%lu$%s$", rounds, salt);
+        if (hash_timed(password, setting, hash_out, hash_out_size, &ms) != 0)
+            return -1;
+    }
+
+    double scaled = ms > 0.0 ? rounds * (target_ms / ms) : rounds;
+    if (scaled <= SHA512_ROUNDS_DEFAULT) scaled = SHA512_ROUNDS_DEFAULT;
+    if (scaled > SHA512_ROUNDS_MAX) scaled = SHA512_ROUNDS_MAX;
+
+    snprintf(setting, sizeof(setting), "$6$rounds=%lu$%s$",
+             (unsigned long)scaled, salt);
+    return hash_timed(password, setting, hash_out, hash_out_size, &ms);
+}
+
+int vault_auth_password_hash(const char *password, int target_ms,
+                              char *hash_out, size_t hash_out_size)
+{
+#ifdef CRYPT_GENSALT_IMPLEMENTS_AUTO_ENTROPY
+    if (hash_yescrypt(password, target_ms, hash_out, hash_out_size) == 0)
+        return 0;
+#endif
+    return hash_sha512(password, target_ms, hash_out, hash_out_size);
 }
 
 int vault_auth_password_verify(const char *password, const char *stored_hash)
@@ -62,50 +160,170 @@ int vault_auth_password_verify(const char *password, const char *stored_hash)
     return strcmp(result, stored_hash) == 0;
 }
 
+/* crypt() keeps no state worth opening early */
+int vault_auth_password_prepare(void)
+{
+    return 0;
+}
+
 #else /* Windows */
 
-int vault_auth_password_hash(const char *password,
-                              char *hash_out, size_t hash_out_size)
+/*
+ * "$pbkdf2-sha512$<iterations>$<salt hex>$<key hex>". Hashes from
+ * before it, a bare unsalted SHA-256 in hex, still verify.
+ */
+#define PBKDF2_PREFIX          "$pbkdf2-sha512$"
+#define PBKDF2_SALT_LEN        16
+#define PBKDF2_KEY_LEN         64
+#define PBKDF2_ITER_MIN        210000      /* OWASP floor for SHA-512 */
+#define PBKDF2_ITER_MAX        100000000UL
+
+/* CNG providers, opened once for the life of the process */
+static INIT_ONCE          providers_once = INIT_ONCE_STATIC_INIT;
+static BCRYPT_ALG_HANDLE  hmac_sha512;
+static BCRYPT_ALG_HANDLE  sha256;
+
+static BOOL CALLBACK open_providers(PINIT_ONCE once, PVOID param,
+                                    PVOID *ctx)
 {
-    HCRYPTPROV prov = 0;
-    HCRYPTHASH hash = 0;
-    int ret = -1;
+    (void)once; (void)param; (void)ctx;
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&hmac_sha512,
+            BCRYPT_SHA512_ALGORITHM, NULL, BCRYPT_ALG_HANDLE_HMAC_FLAG)))
+        hmac_sha512 = NULL;
+    if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&sha256,
+            BCRYPT_SHA256_ALGORITHM, NULL, 0)))
+        sha256 = NULL;
+    return TRUE;
+}
 
-    if (!CryptAcquireContextA(&prov, NULL, NULL, PROV_RSA_AES,
-                               CRYPT_VERIFYCONTEXT))
-        return -1;
+static void hex_encode(const uint8_t *in, size_t len, char *out)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2]     = digits[in[i] >> 4];
+        out[i * 2 + 1] = digits[in[i] & 15];
+    }
+    out[len * 2] = '\0';
+}
 
-    if (!CryptCreateHash(prov, CALG_SHA_256, 0, 0, &hash))
-        goto out;
+static int hex_decode(const char *in, uint8_t *out, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        unsigned v;
+        if (sscanf(in + i * 2, "%2x", &v) != 1) return -1;
+        out[i] = (uint8_t)v;
+    }
+    return 0;
+}
 
-    DWORD pw_len = (DWORD)strlen(password);
-    if (!CryptHashData(hash, (const BYTE *)password, pw_len, 0))
-        goto out;
+static int pbkdf2(const char *password, const uint8_t *salt,
+                  unsigned long iterations, uint8_t *key)
+{
+    InitOnceExecuteOnce(&providers_once, open_providers, NULL, NULL);
+    if (!hmac_sha512) return -1;
+    NTSTATUS st = BCryptDeriveKeyPBKDF2(hmac_sha512,
+                                        (PUCHAR)password,
+                                        (ULONG)strlen(password),
+                                        (PUCHAR)salt, PBKDF2_SALT_LEN,
+                                        iterations, key, PBKDF2_KEY_LEN, 0);
+    return BCRYPT_SUCCESS(st) ? 0 : -1;
+}
 
-    BYTE digest[32];
-    DWORD digest_len = sizeof(digest);
-    if (!CryptGetHashParam(hash, HP_HASHVAL, digest, &digest_len, 0))
-        goto out;
+/* Iterations that take about target_ms here: time a run long enough
+ * to measure, then scale, which is linear in iterations */
+static unsigned long pbkdf2_calibrate(const char *password,
+                                      const uint8_t *salt, int target_ms)
+{
+    uint8_t key[PBKDF2_KEY_LEN];
+    unsigned long iter = 10000;
+    double ms = 0.0;
 
-    /* Format as hex string */
-    if (hash_out_size < 65) goto out;
-    for (DWORD i = 0; i < 32; i++)
-        snprintf(hash_out + i * 2, 3, "%02x", digest[i]);
-    hash_out[64] = '\0';
-    ret = 0;
+    while (iter < PBKDF2_ITER_MAX / 2) {
+        ULONGLONG t0 = GetTickCount64();
+        if (pbkdf2(password, salt, iter, key) != 0) break;
+        ms = (double)(GetTickCount64() - t0);
+        if (ms >= target_ms / 8.0 && ms >= 16.0) break;
+        iter *= 2;
+    }
+    SecureZeroMemory(key, sizeof(key));
 
-out:
-    if (hash) CryptDestroyHash(hash);
-    if (prov) CryptReleaseContext(prov, 0);
-    return ret;
+    double scaled = ms > 0.0 ? iter * (target_ms / ms) : PBKDF2_ITER_MIN;
+    if (scaled < PBKDF2_ITER_MIN) scaled = PBKDF2_ITER_MIN;
+    if (scaled > PBKDF2_ITER_MAX) scaled = PBKDF2_ITER_MAX;
+    return (unsigned long)scaled;
+}
+
+int vault_auth_password_hash(const char *password, int target_ms,
+                              char *hash_out, size_t hash_out_size)
+{
+    uint8_t salt[PBKDF2_SALT_LEN], key[PBKDF2_KEY_LEN];
+    if (vault_platform_random(salt, sizeof(salt)) != 0) return -1;
+
+    unsigned long iter = target_ms > 0
+        ? pbkdf2_calibrate(password, salt, target_ms) : PBKDF2_ITER_MIN;
+    if (pbkdf2(password, salt, iter, key) != 0) return -1;
+
+    char salt_hex[PBKDF2_SALT_LEN * 2 + 1], key_hex[PBKDF2_KEY_LEN * 2 + 1];
+    hex_encode(salt, sizeof(salt), salt_hex);
+    hex_encode(key, sizeof(key), key_hex);
+    SecureZeroMemory(key, sizeof(key));
+
+    int n = snprintf(hash_out, hash_out_size, PBKDF2_PREFIX "%lu$%s$%s",
+                     iter, salt_hex, key_hex);
+    SecureZeroMemory(key_hex, sizeof(key_hex));
+    return (n > 0 && (size_t)n < hash_out_size) ? 0 : -1;
+}
+
+/* Compare without stopping at the first difference */
+static int equal_ct(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+static int verify_sha256_legacy(const char *password, const char *stored)
+{
+    InitOnceExecuteOnce(&providers_once, open_providers, NULL, NULL);
+    uint8_t digest[32], want[32];
+    if (!sha256 || strlen(stored) != 64 || hex_decode(stored, want, 32) != 0)
+        return 0;
+    if (!BCRYPT_SUCCESS(BCryptHash(sha256, NULL, 0, (PUCHAR)password,
+                                   (ULONG)strlen(password),
+                                   digest, sizeof(digest))))
+        return 0;
+    return equal_ct(digest, want, sizeof(digest));
 }
 
 int vault_auth_password_verify(const char *password, const char *stored_hash)
 {
-    char computed[256];
-    if (vault_auth_password_hash(password, computed, sizeof(computed)) != 0)
+    size_t plen = strlen(PBKDF2_PREFIX);
+    if (strncmp(stored_hash, PBKDF2_PREFIX, plen) != 0)
+        return verify_sha256_legacy(password, stored_hash);
+
+    char *end;
+    unsigned long iter = strtoul(stored_hash + plen, &end, 10);
+    if (*end != '$' || iter == 0 || iter > PBKDF2_ITER_MAX) return 0;
+
+    const char *salt_hex = end + 1;
+    const char *key_hex = salt_hex + PBKDF2_SALT_LEN * 2 + 1;
+    uint8_t salt[PBKDF2_SALT_LEN], want[PBKDF2_KEY_LEN], key[PBKDF2_KEY_LEN];
+    if (strlen(salt_hex) != PBKDF2_SALT_LEN * 2 + 1 + PBKDF2_KEY_LEN * 2 ||
+        salt_hex[PBKDF2_SALT_LEN * 2] != '$' ||
+        hex_decode(salt_hex, salt, sizeof(salt)) != 0 ||
+        hex_decode(key_hex, want, sizeof(want)) != 0)
         return 0;
-    return strcmp(computed, stored_hash) == 0;
+
+    if (pbkdf2(password, salt, iter, key) != 0) return 0;
+    int ok = equal_ct(key, want, sizeof(key));
+    SecureZeroMemory(key, sizeof(key));
+    return ok;
+}
+
+int vault_auth_password_prepare(void)
+{
+    InitOnceExecuteOnce(&providers_once, open_providers, NULL, NULL);
+    return hmac_sha512 ? 0 : -1;
 }
 
 #endif /* VAULT_PLATFORM_WINDOWS */
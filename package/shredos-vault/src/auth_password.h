@@ -1,5 +1,5 @@
 /*
- * auth_password.h -- Password Authentication (SHA-512)
+ * auth_password.h -- Password Authentication (yescrypt / SHA-512)
  *
  * Copyright 2025 -- GPL-2.0+
  */
@@ -9,14 +9,23 @@
 
 #include <stddef.h>
 
-/* Hash a password with SHA-512 and random salt.
- * Writes the full $6$salt$hash string into hash_out.
+/* Hash a password with a random salt at the highest cost that still
+ * verifies within target_ms on this machine (0 = the library default
+ * cost). Uses memory-hard yescrypt ($y$) where crypt() has it, else
+ * SHA-512 ($6$) with its rounds scaled to the target. The cost is
+ * part of the string written to hash_out.
  * Returns 0 on success, -1 on failure. */
-int vault_auth_password_hash(const char *password,
+int vault_auth_password_hash(const char *password, int target_ms,
                               char *hash_out, size_t hash_out_size);
 
-/* Verify a password against a stored hash.
+/* Verify a password against a stored hash: $y$, $6$ with or without
+ * rounds=, or anything else crypt() takes.
  * Returns 1 if match, 0 if no match. */
 int vault_auth_password_verify(const char *password, const char *stored_hash);
 
+/* Open whatever the hashes need up front, so the first verify costs no
+ * more than the rest; for long-running verifiers such as the Windows
+ * service. Returns 0, or -1 if hashing is unavailable. */
+int vault_auth_password_prepare(void);
+
 #endif /* VAULT_AUTH_PASSWORD_H */
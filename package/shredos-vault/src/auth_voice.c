@@ -0,0 +1,309 @@
+/*
+ * auth_voice.c -- Voice Passphrase Authentication (PocketSphinx)
+ *
+ * The PortAudio callback only copies samples into a single-producer,
+ * single-consumer ring: no locks, no allocation, no system calls, so
+ * it can never stall the audio thread. A decoder thread drains the
+ * ring 10 ms at a time. While idle it keeps just the last
+ * VOICE_PREROLL samples; once asked to listen it feeds everything to
+ * a keyword-spotting search for the passphrase and reads PocketSphinx's
+ * own voice activity detection to tell when the speaker has stopped.
+ * Each verdict is one byte down a pipe: '1' spotted, '0' an utterance
+ * without it, '-' nothing heard before VOICE_WAIT_MS.
+ *
+ * The ring and the decoder's copy come from the locked secure arena
+ * and every sample is zeroed as soon as it has been consumed.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "auth_voice.h"
+#include "platform.h"
+
+#include <pocketsphinx.h>
+#include <portaudio.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef VOICE_MODEL_DIR
+#define VOICE_MODEL_DIR  "/usr/share/pocketsphinx/model/en-us"
+#endif
+
+#define VOICE_RATE       16000      /* what the en-us model expects */
+#define VOICE_CHUNK      160        /* samples per callback, 10 ms */
+#define VOICE_RING       4096       /* samples, a power of two: 256 ms */
+#define VOICE_MASK       (VOICE_RING - 1)
+#define VOICE_FRAME      512        /* most samples fed per call */
+#define VOICE_PREROLL    3200       /* kept while idle: 200 ms */
+#define VOICE_POLL_MS    10
+#define VOICE_WAIT_MS    5000       /* for speech to start */
+#define VOICE_UTT_MS     10000      /* longest utterance judged */
+
+static struct {
+    int            started;
+    vault_thread_t thread;
+    int            pipe[2];         /* verdicts: worker -> login screen */
+    int            stop;
+    int            armed;           /* vault_auth_voice_listen() called */
+    char          *phrase;          /* normalised, until the search has it */
+
+    /* Ring: head only moves in the callback, tail only in the worker */
+    int16_t       *ring;
+    int16_t       *frame;
+    unsigned long  head;
+    unsigned long  tail;
+
+    cmd_ln_t      *config;
+    ps_decoder_t  *ps;
+    int            pa_ready;
+    PaStream      *stream;
+} vc = { .pipe = { -1, -1 } };
+
+static double voice_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void voice_sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+static void voice_post(char verdict)
+{
+    ssize_t n;
+    do {
+        n = write(vc.pipe[1], &verdict, 1);
+    } while (n < 0 && errno == EINTR);
+}
+
+/* Runs on PortAudio's audio thread */
+static int voice_capture(const void *input, void *output,
+                         unsigned long frames,
+                         const PaStreamCallbackTimeInfo *time,
+                         PaStreamCallbackFlags flags, void *data)
+{
+    const int16_t *in = input;
+    (void)output;
+    (void)time;
+    (void)flags;
+    (void)data;
+
+    unsigned long head = vc.head;
+    unsigned long tail = __atomic_load_n(&vc.tail, __ATOMIC_ACQUIRE);
+    if (!in) return paContinue;
+    /* The decoder fell behind; losing audio beats blocking here */
+    if (frames > VOICE_RING - (head - tail))
+        return paContinue;
+    for (unsigned long i = 0; i < frames; i++)
+        vc.ring[(head + i) & VOICE_MASK] = in[i];
+    __atomic_store_n(&vc.head, head + frames, __ATOMIC_RELEASE);
+    return paContinue;
+}
+
+/* Take n samples off the ring, into out unless it is NULL, zeroing
+ * them behind us. */
+static void ring_take(int16_t *out, unsigned long n)
+{
+    unsigned long tail = vc.tail;
+    for (unsigned long i = 0; i < n; i++) {
+        int16_t *s = &vc.ring[(tail + i) & VOICE_MASK];
+        if (out) out[i] = *s;
+        *s = 0;
+    }
+    __atomic_store_n(&vc.tail, tail + n, __ATOMIC_RELEASE);
+}
+
+/* Lower case, words separated by single spaces, as the dictionary has
+ * them */
+static void voice_normalise(char *dst, const char *src, size_t size)
+{
+    size_t n = 0;
+    int space = 0;
+
+    for (; *src && n + 2 < size; src++) {
+        unsigned char c = (unsigned char)*src;
+        if (isalpha(c) || c == '\'') {
+            if (space && n > 0) dst[n++] = ' ';
+            dst[n++] = (char)tolower(c);
+            space = 0;
+        } else {
+            space = 1;
+        }
+    }
+    dst[n] = '\0';
+}
+
+static int voice_open(void)
+{
+    vc.config = cmd_ln_init(NULL, ps_args(), TRUE,
+                            "-hmm", VOICE_MODEL_DIR "/en-us",
+                            "-dict", VOICE_MODEL_DIR "/cmudict-en-us.dict",
+                            "-logfn", "/dev/null",
+                            NULL);
+    if (!vc.config) return -1;
+    vc.ps = ps_init(vc.config);
+    if (!vc.ps) return -1;
+
+    /* Fails if a word of the passphrase is not in the dictionary */
+    int rc = ps_set_keyphrase(vc.ps, "vault", vc.phrase);
+    vault_secure_free(vc.phrase);
+    vc.phrase = NULL;
+    if (rc < 0 || ps_set_search(vc.ps, "vault") < 0)
+        return -1;
+
+    if (Pa_Initialize() != paNoError) return -1;
+    vc.pa_ready = 1;
+    if (Pa_OpenDefaultStream(&vc.stream, 1, 0, paInt16, VOICE_RATE,
+                             VOICE_CHUNK, voice_capture, NULL) != paNoError) {
+        vc.stream = NULL;
+        return -1;
+    }
+    return Pa_StartStream(vc.stream) == paNoError ? 0 : -1;
+}
+
+static void voice_run(void)
+{
+    int listening = 0, heard = 0;
+    double since = 0;
+
+    while (!__atomic_load_n(&vc.stop, __ATOMIC_ACQUIRE)) {
+        unsigned long avail =
+            __atomic_load_n(&vc.head, __ATOMIC_ACQUIRE) - vc.tail;
+
+        if (!listening) {
+            if (avail > VOICE_PREROLL)
+                ring_take(NULL, avail - VOICE_PREROLL);
+            if (__atomic_exchange_n(&vc.armed, 0, __ATOMIC_ACQ_REL)) {
+                ps_start_utt(vc.ps);
+                listening = 1;
+                heard = 0;
+                since = voice_now_ms();
+                continue;
+            }
+            voice_sleep_ms(VOICE_POLL_MS);
+            continue;
+        }
+
+        /* Stream what has arrived into the search */
+        if (avail > 0) {
+            unsigned long n = avail < VOICE_FRAME ? avail : VOICE_FRAME;
+            ring_take(vc.frame, n);
+            ps_process_raw(vc.ps, vc.frame, n, FALSE, FALSE);
+            vault_secure_memzero(vc.frame, n * sizeof(*vc.frame));
+            if (ps_get_in_speech(vc.ps)) heard = 1;
+        }
+
+        char verdict = 0;
+        double held = voice_now_ms() - since;
+        if (ps_get_hyp(vc.ps, NULL))
+            verdict = '1';                  /* spotted, no need to wait */
+        else if (heard && !ps_get_in_speech(vc.ps))
+            verdict = '0';                  /* spoke, then fell silent */
+        else if (held > (heard ? VOICE_UTT_MS : VOICE_WAIT_MS))
+            verdict = heard ? '0' : '-';
+
+        if (verdict) {
+            ps_end_utt(vc.ps);
+            /* The last frames are only searched once the utterance ends */
+            if (verdict == '0' && ps_get_hyp(vc.ps, NULL))
+                verdict = '1';
+            voice_post(verdict);
+            listening = 0;
+        } else if (avail == 0) {
+            voice_sleep_ms(VOICE_POLL_MS);
+        }
+    }
+    if (listening) ps_end_utt(vc.ps);
+}
+
+static void *voice_worker(void *arg)
+{
+    (void)arg;
+    if (voice_open() == 0)
+        voice_run();
+
+    /* PortAudio is only ever touched from this thread */
+    if (vc.stream) {
+        Pa_StopStream(vc.stream);
+        Pa_CloseStream(vc.stream);
+        vc.stream = NULL;
+    }
+    if (vc.pa_ready) Pa_Terminate();
+    vc.pa_ready = 0;
+    return NULL;
+}
+
+int vault_auth_voice_start(const char *passphrase)
+{
+    if (vc.started) return 0;
+    if (!passphrase || !passphrase[0]) return -1;
+
+    vc.phrase = vault_secure_alloc(VAULT_PASSWORD_MAX);
+    vc.ring = vault_secure_alloc(VOICE_RING * sizeof(*vc.ring));
+    vc.frame = vault_secure_alloc(VOICE_FRAME * sizeof(*vc.frame));
+    if (!vc.phrase || !vc.ring || !vc.frame || pipe(vc.pipe) != 0) {
+        vault_auth_voice_stop();
+        return -1;
+    }
+    voice_normalise(vc.phrase, passphrase, VAULT_PASSWORD_MAX);
+    fcntl(vc.pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(vc.pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(vc.pipe[1], F_SETFD, FD_CLOEXEC);
+
+    if (!vc.phrase[0] ||
+        vault_thread_create(&vc.thread, voice_worker, NULL) != 0) {
+        vault_auth_voice_stop();
+        return -1;
+    }
+    vc.started = 1;
+    return 0;
+}
+
+int vault_auth_voice_fd(void)
+{
+    return vc.started ? vc.pipe[0] : -1;
+}
+
+void vault_auth_voice_listen(void)
+{
+    if (vc.started)
+        __atomic_store_n(&vc.armed, 1, __ATOMIC_RELEASE);
+}
+
+int vault_auth_voice_result(void)
+{
+    char verdict;
+
+    if (!vc.started) return -1;
+    if (read(vc.pipe[0], &verdict, 1) != 1) return -1;
+    if (verdict == '-') return -1;
+    return verdict == '1';
+}
+
+void vault_auth_voice_stop(void)
+{
+    if (vc.started) {
+        __atomic_store_n(&vc.stop, 1, __ATOMIC_RELEASE);
+        vault_thread_join(vc.thread);
+    }
+    if (vc.ps) ps_free(vc.ps);
+    if (vc.config) cmd_ln_free_r(vc.config);
+    vault_secure_free(vc.phrase);
+    vault_secure_free(vc.ring);
+    vault_secure_free(vc.frame);
+    for (int i = 0; i < 2; i++)
+        if (vc.pipe[i] >= 0) close(vc.pipe[i]);
+    memset(&vc, 0, sizeof(vc));
+    vc.pipe[0] = vc.pipe[1] = -1;
+}
@@ -0,0 +1,58 @@
+/*
+ * auth_voice.h -- Voice Passphrase Authentication (PocketSphinx)
+ *
+ * The microphone is opened and the recogniser loaded in the background
+ * as soon as the TUI is up, and the audio is streamed straight into the
+ * decoder. Nothing is judged until the user asks: pressing Tab on the
+ * login screen calls vault_auth_voice_listen(), and the utterance that
+ * follows is checked for voice_passphrase with keyword spotting. The
+ * verdict comes the moment the phrase is spotted, or the moment the
+ * speaker falls silent without it, rather than after a fixed recording
+ * window. Each verdict makes vault_auth_voice_fd() readable, and the
+ * login screen waits on it together with the keyboard.
+ *
+ * Without HAVE_VOICE these are stubs that report no microphone.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_AUTH_VOICE_H
+#define VAULT_AUTH_VOICE_H
+
+#ifdef HAVE_VOICE
+
+/* Start opening the default input device and loading the recogniser
+ * for passphrase, all in the background. Returns 0, or -1 if there is
+ * no passphrase or the thread could not be started. A microphone or
+ * model that turns out to be missing leaves the fd quiet. */
+int vault_auth_voice_start(const char *passphrase);
+
+/* Readable while a verdict is waiting; -1 when not started. */
+int vault_auth_voice_fd(void);
+
+/* Judge the next utterance, starting with the last fraction of a
+ * second already heard so the first syllable is not lost. */
+void vault_auth_voice_listen(void);
+
+/* Take the next verdict without blocking: 1 the passphrase was spoken,
+ * 0 an utterance without it, -1 nothing heard or none waiting. */
+int vault_auth_voice_result(void);
+
+/* Stop the stream, free the recogniser and zero the audio. */
+void vault_auth_voice_stop(void);
+
+#else
+
+static inline int vault_auth_voice_start(const char *passphrase)
+{
+    (void)passphrase;
+    return -1;
+}
+static inline int vault_auth_voice_fd(void) { return -1; }
+static inline void vault_auth_voice_listen(void) { }
+static inline int vault_auth_voice_result(void) { return -1; }
+static inline void vault_auth_voice_stop(void) { }
+
+#endif /* HAVE_VOICE */
+
+#endif /* VAULT_AUTH_VOICE_H */
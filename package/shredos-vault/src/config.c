@@ -6,6 +6,10 @@
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* strcasecmp */
+#endif
+
 #include "config.h"
 #include "platform.h"
 
@@ -29,6 +33,7 @@ static const char *wipe_algorithm_names[] = {
     [WIPE_DOD_SHORT]   = "DoD Short (3-pass)",
     [WIPE_RANDOM]      = "PRNG Stream",
     [WIPE_ZERO]        = "Zero Fill",
+    [WIPE_HW_ERASE]    = "Hardware Erase",
     [WIPE_VERIFY_ONLY] = "Verify Only",
 };
 
@@ -38,11 +43,20 @@ static const char *wipe_algorithm_nwipe_flags[] = {
     [WIPE_DOD_SHORT]   = "--method=dodshort",
     [WIPE_RANDOM]      = "--method=random",
     [WIPE_ZERO]        = "--method=zero",
+    [WIPE_HW_ERASE]    = "--method=random",     /* software fallback */
     [WIPE_VERIFY_ONLY] = "--method=verify",
 };
 
 static const char *wipe_algorithm_config_names[] = {
-    "gutmann", "dod522022m", "dodshort", "random", "zero", "verify"
+    "gutmann", "dod522022m", "dodshort", "random", "zero", "hwerase",
+    "verify"
+};
+
+static const char *wipe_rng_config_names[] = {
+    [WIPE_RNG_AUTO]     = "auto",
+    [WIPE_RNG_CHACHA20] = "chacha20",
+    [WIPE_RNG_AES_CTR]  = "aes-ctr",
+    [WIPE_RNG_KERNEL]   = "kernel",
 };
 
 /* ------------------------------------------------------------------ */
@@ -54,9 +68,25 @@ void vault_config_init(vault_config_t *cfg)
     memset(cfg, 0, sizeof(*cfg));
     cfg->auth_methods      = AUTH_METHOD_PASSWORD;
     cfg->max_attempts      = 3;
+    cfg->password_hash_ms  = 300;
     cfg->wipe_algorithm    = WIPE_GUTMANN;
+    cfg->crypto_erase      = true;
     cfg->encrypt_before_wipe = true;
+    cfg->luks_unlock_ms    = 2000;
+    cfg->luks_pbkdf_memory_kb = 65536;
+    strncpy(cfg->luks_activate_flags, "auto",
+            sizeof(cfg->luks_activate_flags) - 1);
+    strncpy(cfg->luks_mount_options, "auto",
+            sizeof(cfg->luks_mount_options) - 1);
     cfg->verify_passes     = false;
+    cfg->wipe_direct_io    = true;
+    cfg->verify_fused      = true;
+    cfg->wipe_skip_bad     = true;
+    cfg->wipe_offload      = true;
+    cfg->wipe_metadata_first = true;
+    cfg->wipe_numa         = true;
+    cfg->initramfs_append  = true;
+    strncpy(cfg->watchdog, "auto", sizeof(cfg->watchdog) - 1);
     strncpy(cfg->mount_point, VAULT_MOUNT_POINT, sizeof(cfg->mount_point) - 1);
     cfg->current_attempts  = 0;
     cfg->setup_mode        = false;
@@ -76,6 +106,12 @@ const char *vault_wipe_algorithm_nwipe_flag(wipe_algorithm_t alg)
     return wipe_algorithm_nwipe_flags[alg];
 }
 
+const char *vault_wipe_rng_name(wipe_rng_t rng)
+{
+    if (rng >= WIPE_RNG_COUNT) return "auto";
+    return wipe_rng_config_names[rng];
+}
+
 /* ------------------------------------------------------------------ */
 /*  Shared helpers                                                     */
 /* ------------------------------------------------------------------ */
@@ -89,10 +125,141 @@ static wipe_algorithm_t parse_algorithm_string(const char *str)
     if (strcasecmp(str, "schneier") == 0)    return WIPE_DOD_SHORT;
     if (strcasecmp(str, "random") == 0)      return WIPE_RANDOM;
     if (strcasecmp(str, "zero") == 0)        return WIPE_ZERO;
+    if (strcasecmp(str, "hwerase") == 0)     return WIPE_HW_ERASE;
+    if (strcasecmp(str, "sanitize") == 0)    return WIPE_HW_ERASE;
     if (strcasecmp(str, "verify") == 0)      return WIPE_VERIFY_ONLY;
     return WIPE_GUTMANN;
 }
 
+static wipe_rng_t parse_rng_string(const char *str)
+{
+    for (int i = 0; i < WIPE_RNG_COUNT; i++)
+        if (strcasecmp(str, wipe_rng_config_names[i]) == 0)
+            return (wipe_rng_t)i;
+    return WIPE_RNG_AUTO;
+}
+
+/* dm-crypt takes power-of-two sectors from 512 to 4096 bytes. */
+static int valid_sector_size(int n)
+{
+    return n >= 512 && n <= 4096 && (n & (n - 1)) == 0;
+}
+
+/* Comma-separated device list into cfg->wipe_devices. */
+static void parse_device_list(vault_config_t *cfg, const char *str)
+{
+    cfg->wipe_device_count = 0;
+    while (*str && cfg->wipe_device_count < VAULT_CONFIG_MAX_WIPE_DEVICES) {
+        while (*str == ',' || isspace((unsigned char)*str)) str++;
+        size_t n = 0;
+        while (str[n] && str[n] != ',' && !isspace((unsigned char)str[n])) n++;
+        if (n == 0) break;
+        if (n < VAULT_CONFIG_MAX_PATH) {
+            char *dst = cfg->wipe_devices[cfg->wipe_device_count++];
+            memcpy(dst, str, n);
+            dst[n] = '\0';
+        }
+        str += n;
+    }
+}
+
+static void write_device_list(FILE *fp, const vault_config_t *cfg)
+{
+    for (int i = 0; i < cfg->wipe_device_count; i++)
+        fprintf(fp, "%s%s", i ? "," : "", cfg->wipe_devices[i]);
+}
+
+/* A verify mode: none, full or sampled:<percent>. Returns -1, leaving
+ * the outputs alone, for anything else. */
+static int parse_verify_spec(const char *str, bool *verify, double *pct)
+{
+    if (strcasecmp(str, "none") == 0) {
+        *verify = false;
+        *pct = 0;
+    } else if (strcasecmp(str, "full") == 0) {
+        *verify = true;
+        *pct = 0;
+    } else if (strncmp(str, "sampled:", 8) == 0) {
+        char *end;
+        double p = strtod(str + 8, &end);
+        if (*end == '%') end++;
+        if (end == str + 8 || *end || !(p > 0 && p <= 100)) return -1;
+        *verify = true;
+        *pct = (p < 100) ? p : 0;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static void write_verify_spec(FILE *fp, bool verify, double pct)
+{
+    if (!verify)
+        fprintf(fp, "none");
+    else if (pct > 0)
+        fprintf(fp, "sampled:%g", pct);
+    else
+        fprintf(fp, "full");
+}
+
+static void parse_verify_mode(vault_config_t *cfg, const char *str)
+{
+    parse_verify_spec(str, &cfg->verify_passes, &cfg->verify_sample_pct);
+}
+
+static void write_verify_mode(FILE *fp, const vault_config_t *cfg)
+{
+    write_verify_spec(fp, cfg->verify_passes, cfg->verify_sample_pct);
+}
+
+/* A targets entry that follows the global wipe settings. */
+static void target_init(vault_config_target_t *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->algorithm = -1;
+    t->verify    = -1;
+    t->offload   = -1;
+}
+
+static void target_set_verify(vault_config_target_t *t, const char *str)
+{
+    bool verify;
+    double pct;
+    if (parse_verify_spec(str, &verify, &pct) == 0) {
+        t->verify = verify;
+        t->verify_sample_pct = pct;
+    }
+}
+
+/* Priorities outside this range are clamped to it */
+static int clamp_priority(int n)
+{
+    return n < -100 ? -100 : n > 100 ? 100 : n;
+}
+
+/* The settings of a targets entry, one per line, each line starting
+ * with indent and closed by end. */
+static void write_target(FILE *fp, const vault_config_target_t *t,
+                         const char *indent, const char *end)
+{
+    fprintf(fp, "%sdevice = \"%s\"%s", indent, t->device, end);
+    if (t->algorithm >= 0 && t->algorithm < WIPE_COUNT)
+        fprintf(fp, "%salgorithm = \"%s\"%s", indent,
+                wipe_algorithm_config_names[t->algorithm], end);
+    if (t->schedule[0])
+        fprintf(fp, "%sschedule = \"%s\"%s", indent, t->schedule, end);
+    if (t->verify >= 0) {
+        fprintf(fp, "%sverify = \"", indent);
+        write_verify_spec(fp, t->verify, t->verify_sample_pct);
+        fprintf(fp, "\"%s", end);
+    }
+    if (t->priority)
+        fprintf(fp, "%spriority = %d%s", indent, t->priority, end);
+    if (t->offload >= 0)
+        fprintf(fp, "%soffload = %s%s", indent,
+                t->offload ? "true" : "false", end);
+}
+
 #ifndef VAULT_CONFIG_BACKEND_LIBCONFIG
 static int parse_bool_string(const char *str)
 {
@@ -143,6 +310,9 @@ int vault_config_load(vault_config_t *cfg, const char *path)
     int ival;
     if (config_lookup_int(&lc, "max_attempts", &ival))
         cfg->max_attempts = ival;
+    if (config_lookup_int(&lc, "password_hash_ms", &ival) &&
+        ival >= 0 && ival <= 10000)
+        cfg->password_hash_ms = ival;
 
     const char *str;
     if (config_lookup_string(&lc, "password_hash", &str))
@@ -151,16 +321,125 @@ int vault_config_load(vault_config_t *cfg, const char *path)
         strncpy(cfg->voice_passphrase, str, sizeof(cfg->voice_passphrase) - 1);
     if (config_lookup_string(&lc, "target_device", &str))
         strncpy(cfg->target_device, str, sizeof(cfg->target_device) - 1);
+    if (config_lookup_string(&lc, "target_extents", &str))
+        strncpy(cfg->target_extents, str, sizeof(cfg->target_extents) - 1);
+    if (config_lookup_string(&lc, "wipe_devices", &str))
+        parse_device_list(cfg, str);
     if (config_lookup_string(&lc, "mount_point", &str))
         strncpy(cfg->mount_point, str, sizeof(cfg->mount_point) - 1);
+    if (config_lookup_string(&lc, "wipe_report", &str))
+        strncpy(cfg->wipe_report, str, sizeof(cfg->wipe_report) - 1);
+    if (config_lookup_string(&lc, "wipe_io_backend", &str))
+        strncpy(cfg->wipe_io_backend, str, sizeof(cfg->wipe_io_backend) - 1);
     if (config_lookup_string(&lc, "wipe_algorithm", &str))
         cfg->wipe_algorithm = parse_algorithm_string(str);
+    if (config_lookup_string(&lc, "wipe_schedule", &str))
+        strncpy(cfg->wipe_schedule, str, sizeof(cfg->wipe_schedule) - 1);
+    if (config_lookup_string(&lc, "luks_cipher", &str))
+        strncpy(cfg->luks_cipher, str, sizeof(cfg->luks_cipher) - 1);
+    if (config_lookup_string(&lc, "luks_activate_flags", &str))
+        strncpy(cfg->luks_activate_flags, str,
+                sizeof(cfg->luks_activate_flags) - 1);
+    if (config_lookup_string(&lc, "luks_mount_options", &str))
+        strncpy(cfg->luks_mount_options, str,
+                sizeof(cfg->luks_mount_options) - 1);
 
     int bval;
+    if (config_lookup_bool(&lc, "crypto_erase", &bval))
+        cfg->crypto_erase = bval;
     if (config_lookup_bool(&lc, "encrypt_before_wipe", &bval))
         cfg->encrypt_before_wipe = bval;
+    if (config_lookup_bool(&lc, "luks_keyring", &bval))
+        cfg->luks_keyring = bval;
     if (config_lookup_bool(&lc, "verify_passes", &bval))
         cfg->verify_passes = bval;
+    if (config_lookup_bool(&lc, "wipe_direct_io", &bval))
+        cfg->wipe_direct_io = bval;
+    if (config_lookup_bool(&lc, "verify_fused", &bval))
+        cfg->verify_fused = bval;
+    if (config_lookup_bool(&lc, "wipe_probe", &bval))
+        cfg->wipe_probe = bval;
+    if (config_lookup_bool(&lc, "wipe_journal", &bval))
+        cfg->wipe_journal = bval;
+    if (config_lookup_bool(&lc, "wipe_skip_bad", &bval))
+        cfg->wipe_skip_bad = bval;
+    if (config_lookup_bool(&lc, "wipe_offload", &bval))
+        cfg->wipe_offload = bval;
+    if (config_lookup_bool(&lc, "wipe_metadata_first", &bval))
+        cfg->wipe_metadata_first = bval;
+    if (config_lookup_bool(&lc, "wipe_numa", &bval))
+        cfg->wipe_numa = bval;
+    if (config_lookup_bool(&lc, "initramfs_append", &bval))
+        cfg->initramfs_append = bval;
+
+    if (config_lookup_int(&lc, "luks_sector_size", &ival) &&
+        valid_sector_size(ival))
+        cfg->luks_sector_size = ival;
+    if (config_lookup_int(&lc, "luks_unlock_ms", &ival) &&
+        ival >= 100 && ival <= 30000)
+        cfg->luks_unlock_ms = ival;
+    if (config_lookup_int(&lc, "luks_pbkdf_memory_kb", &ival) &&
+        ival >= 32 && ival <= 4194304)
+        cfg->luks_pbkdf_memory_kb = ival;
+    if (config_lookup_int(&lc, "wipe_chunk_kb", &ival) &&
+        ival >= 64 && ival <= 65536)
+        cfg->wipe_chunk_kb = ival;
+    if (config_lookup_int(&lc, "wipe_queue_depth", &ival) &&
+        ival >= 1 && ival <= 64)
+        cfg->wipe_queue_depth = ival;
+    if (config_lookup_int(&lc, "wipe_ring_depth", &ival) &&
+        ival >= 1 && ival <= 128)
+        cfg->wipe_ring_depth = ival;
+    if (config_lookup_int(&lc, "wipe_stripes", &ival) &&
+        ival >= 1 && ival <= 8)
+        cfg->wipe_stripes = ival;
+    if (config_lookup_int(&lc, "wipe_rate_mbps", &ival) &&
+        ival >= 1 && ival <= 100000)
+        cfg->wipe_rate_mbps = ival;
+    if (config_lookup_int(&lc, "wipe_rate_latency_ms", &ival) &&
+        ival >= 1 && ival <= 10000)
+        cfg->wipe_rate_latency_ms = ival;
+    if (config_lookup_int(&lc, "max_wipe_seconds", &ival) &&
+        ival >= 1 && ival <= 604800)
+        cfg->max_wipe_seconds = ival;
+    if (config_lookup_int(&lc, "wipe_plan_mbps", &ival) &&
+        ival >= 1 && ival <= 100000)
+        cfg->wipe_plan_mbps = ival;
+    if (config_lookup_string(&lc, "watchdog", &str))
+        strncpy(cfg->watchdog, str, sizeof(cfg->watchdog) - 1);
+    if (config_lookup_string(&lc, "event_log", &str))
+        strncpy(cfg->event_log, str, sizeof(cfg->event_log) - 1);
+    if (config_lookup_string(&lc, "wipe_rng", &str))
+        cfg->wipe_rng = parse_rng_string(str);
+    if (config_lookup_string(&lc, "verify_mode", &str))
+        parse_verify_mode(cfg, str);
+
+    /* Targets list: entries without a device are skipped */
+    config_setting_t *tl = config_lookup(&lc, "targets");
+    if (tl && config_setting_is_list(tl)) {
+        cfg->target_count = 0;
+        int n = config_setting_length(tl);
+        for (int i = 0; i < n && cfg->target_count < VAULT_CONFIG_MAX_TARGETS;
+             i++) {
+            config_setting_t *e = config_setting_get_elem(tl, (unsigned)i);
+            vault_config_target_t *t = &cfg->targets[cfg->target_count];
+            target_init(t);
+            if (!config_setting_lookup_string(e, "device", &str) || !str[0])
+                continue;
+            strncpy(t->device, str, sizeof(t->device) - 1);
+            if (config_setting_lookup_string(e, "algorithm", &str))
+                t->algorithm = parse_algorithm_string(str);
+            if (config_setting_lookup_string(e, "schedule", &str))
+                strncpy(t->schedule, str, sizeof(t->schedule) - 1);
+            if (config_setting_lookup_string(e, "verify", &str))
+                target_set_verify(t, str);
+            if (config_setting_lookup_int(e, "priority", &ival))
+                t->priority = clamp_priority(ival);
+            if (config_setting_lookup_bool(e, "offload", &bval))
+                t->offload = bval;
+            cfg->target_count++;
+        }
+    }
 
     cfg->config_loaded = true;
     ret = 0;
@@ -193,20 +472,98 @@ int vault_config_save(const vault_config_t *cfg, const char *path)
 
     fprintf(fp, "max_attempts = %d;\n\n", cfg->max_attempts);
 
+    fprintf(fp, "password_hash_ms = %d;\n", cfg->password_hash_ms);
+
     if (cfg->password_hash[0])
         fprintf(fp, "password_hash = \"%s\";\n\n", cfg->password_hash);
     if (cfg->voice_passphrase[0])
         fprintf(fp, "voice_passphrase = \"%s\";\n\n", cfg->voice_passphrase);
 
     fprintf(fp, "target_device = \"%s\";\n", cfg->target_device);
+    if (cfg->target_extents[0])
+        fprintf(fp, "target_extents = \"%s\";\n", cfg->target_extents);
+    if (cfg->wipe_device_count > 0) {
+        fprintf(fp, "wipe_devices = \"");
+        write_device_list(fp, cfg);
+        fprintf(fp, "\";\n");
+    }
     fprintf(fp, "mount_point = \"%s\";\n\n", cfg->mount_point);
 
     fprintf(fp, "wipe_algorithm = \"%s\";\n",
             wipe_algorithm_config_names[cfg->wipe_algorithm]);
+    if (cfg->wipe_schedule[0])
+        fprintf(fp, "wipe_schedule = \"%s\";\n", cfg->wipe_schedule);
+    fprintf(fp, "crypto_erase = %s;\n",
+            cfg->crypto_erase ? "true" : "false");
     fprintf(fp, "encrypt_before_wipe = %s;\n",
             cfg->encrypt_before_wipe ? "true" : "false");
-    fprintf(fp, "verify_passes = %s;\n",
-            cfg->verify_passes ? "true" : "false");
+    if (cfg->luks_cipher[0])
+        fprintf(fp, "luks_cipher = \"%s\";\n", cfg->luks_cipher);
+    if (cfg->luks_sector_size > 0)
+        fprintf(fp, "luks_sector_size = %d;\n", cfg->luks_sector_size);
+    fprintf(fp, "luks_unlock_ms = %d;\n", cfg->luks_unlock_ms);
+    fprintf(fp, "luks_pbkdf_memory_kb = %d;\n", cfg->luks_pbkdf_memory_kb);
+    fprintf(fp, "luks_activate_flags = \"%s\";\n", cfg->luks_activate_flags);
+    if (cfg->luks_keyring)
+        fprintf(fp, "luks_keyring = true;\n");
+    fprintf(fp, "luks_mount_options = \"%s\";\n", cfg->luks_mount_options);
+    fprintf(fp, "verify_mode = \"");
+    write_verify_mode(fp, cfg);
+    fprintf(fp, "\";\n");
+    fprintf(fp, "wipe_direct_io = %s;\n",
+            cfg->wipe_direct_io ? "true" : "false");
+    fprintf(fp, "verify_fused = %s;\n",
+            cfg->verify_fused ? "true" : "false");
+    if (cfg->wipe_probe)
+        fprintf(fp, "wipe_probe = true;\n");
+    if (cfg->wipe_journal)
+        fprintf(fp, "wipe_journal = true;\n");
+    if (!cfg->wipe_skip_bad)
+        fprintf(fp, "wipe_skip_bad = false;\n");
+    if (!cfg->wipe_offload)
+        fprintf(fp, "wipe_offload = false;\n");
+    if (!cfg->wipe_metadata_first)
+        fprintf(fp, "wipe_metadata_first = false;\n");
+    if (!cfg->wipe_numa)
+        fprintf(fp, "wipe_numa = false;\n");
+    if (!cfg->initramfs_append)
+        fprintf(fp, "initramfs_append = false;\n");
+    if (cfg->wipe_report[0])
+        fprintf(fp, "wipe_report = \"%s\";\n", cfg->wipe_report);
+    if (cfg->wipe_chunk_kb > 0)
+        fprintf(fp, "wipe_chunk_kb = %d;\n", cfg->wipe_chunk_kb);
+    if (cfg->wipe_queue_depth > 0)
+        fprintf(fp, "wipe_queue_depth = %d;\n", cfg->wipe_queue_depth);
+    if (cfg->wipe_ring_depth > 0)
+        fprintf(fp, "wipe_ring_depth = %d;\n", cfg->wipe_ring_depth);
+    if (cfg->wipe_io_backend[0])
+        fprintf(fp, "wipe_io_backend = \"%s\";\n", cfg->wipe_io_backend);
+    if (cfg->wipe_stripes > 0)
+        fprintf(fp, "wipe_stripes = %d;\n", cfg->wipe_stripes);
+    if (cfg->wipe_rate_mbps > 0)
+        fprintf(fp, "wipe_rate_mbps = %d;\n", cfg->wipe_rate_mbps);
+    if (cfg->wipe_rate_latency_ms > 0)
+        fprintf(fp, "wipe_rate_latency_ms = %d;\n",
+                cfg->wipe_rate_latency_ms);
+    if (cfg->max_wipe_seconds > 0)
+        fprintf(fp, "max_wipe_seconds = %d;\n", cfg->max_wipe_seconds);
+    if (cfg->wipe_plan_mbps > 0)
+        fprintf(fp, "wipe_plan_mbps = %d;\n", cfg->wipe_plan_mbps);
+    fprintf(fp, "watchdog = \"%s\";\n", cfg->watchdog);
+    if (cfg->event_log[0])
+        fprintf(fp, "event_log = \"%s\";\n", cfg->event_log);
+    if (cfg->wipe_rng != WIPE_RNG_AUTO)
+        fprintf(fp, "wipe_rng = \"%s\";\n", vault_wipe_rng_name(cfg->wipe_rng));
+
+    if (cfg->target_count > 0) {
+        fprintf(fp, "\ntargets = (\n");
+        for (int i = 0; i < cfg->target_count; i++) {
+            fprintf(fp, "  {\n");
+            write_target(fp, &cfg->targets[i], "    ", ";\n");
+            fprintf(fp, "  }%s\n", i + 1 < cfg->target_count ? "," : "");
+        }
+        fprintf(fp, ");\n");
+    }
 
     fclose(fp);
     return 0;
@@ -245,11 +602,80 @@ static unsigned int parse_auth_methods(const char *str)
     return m ? m : AUTH_METHOD_PASSWORD;
 }
 
+/* One key of a [target] section. Returns -1 if it is not a target
+ * key, which then applies globally. */
+static int parse_target_key(vault_config_target_t *t, const char *key,
+                            const char *value)
+{
+    if (strcmp(key, "device") == 0)
+        strncpy(t->device, value, sizeof(t->device) - 1);
+    else if (strcmp(key, "algorithm") == 0)
+        t->algorithm = parse_algorithm_string(value);
+    else if (strcmp(key, "schedule") == 0)
+        strncpy(t->schedule, value, sizeof(t->schedule) - 1);
+    else if (strcmp(key, "verify") == 0)
+        target_set_verify(t, value);
+    else if (strcmp(key, "priority") == 0)
+        t->priority = clamp_priority(atoi(value));
+    else if (strcmp(key, "offload") == 0)
+        t->offload = parse_bool_string(value);
+    else
+        return -1;
+    return 0;
+}
+
+/* Part of a libconfig "targets = ( ... );" list, as the libconfig
+ * backend writes it: "{" and "}" around each entry, "key = value;"
+ * pairs inside, on one line or several. Returns 1 once the list's ")"
+ * has been read. */
+static int ini_targets_list(vault_config_t *cfg, char *s,
+                            vault_config_target_t **target, int *targets)
+{
+    while (*s) {
+        if (isspace((unsigned char)*s) || *s == ',' || *s == ';') {
+            s++;
+        } else if (*s == '{') {
+            *target = NULL;
+            if (*targets < VAULT_CONFIG_MAX_TARGETS) {
+                *target = &cfg->targets[(*targets)++];
+                target_init(*target);
+            }
+            s++;
+        } else if (*s == '}') {
+            *target = NULL;
+            s++;
+        } else if (*s == ')') {
+            *target = NULL;
+            return 1;
+        } else {
+            size_t n = strcspn(s, ";}");
+            char end = s[n];
+            s[n] = '\0';
+            char *eq = strchr(s, '=');
+            if (eq && *target) {
+                *eq = '\0';
+                char *value = ini_trim(eq + 1);
+                ini_strip_quotes(value);
+                parse_target_key(*target, ini_trim(s), value);
+            }
+            s[n] = end;
+            s += n;
+        }
+    }
+    return 0;
+}
+
 int vault_config_load(vault_config_t *cfg, const char *path)
 {
     FILE *fp = fopen(path, "r");
     if (!fp) return -1;
 
+    /* Each [target] header opens a targets entry; any other header
+     * closes it */
+    vault_config_target_t *target = NULL;
+    int targets = 0;
+    int in_list = 0;
+
     char line[1024];
     while (fgets(line, sizeof(line), fp)) {
         line[strcspn(line, "\r\n")] = '\0';
@@ -257,6 +683,21 @@ int vault_config_load(vault_config_t *cfg, const char *path)
 
         if (!*t || *t == '#' || *t == ';') continue;
 
+        if (in_list) {
+            in_list = !ini_targets_list(cfg, t, &target, &targets);
+            continue;
+        }
+
+        if (*t == '[') {
+            target = NULL;
+            if (strcmp(t, "[target]") == 0 &&
+                targets < VAULT_CONFIG_MAX_TARGETS) {
+                target = &cfg->targets[targets++];
+                target_init(target);
+            }
+            continue;
+        }
+
         char *eq = strchr(t, '=');
         if (!eq) continue;
 
@@ -264,6 +705,11 @@ int vault_config_load(vault_config_t *cfg, const char *path)
         char *key   = ini_trim(t);
         char *value = ini_trim(eq + 1);
 
+        if (strcmp(key, "targets") == 0 && value[0] == '(') {
+            in_list = !ini_targets_list(cfg, value + 1, &target, &targets);
+            continue;
+        }
+
         /* Strip trailing semicolons (libconfig compat) */
         size_t vlen = strlen(value);
         if (vlen > 0 && value[vlen - 1] == ';') value[--vlen] = '\0';
@@ -278,29 +724,138 @@ int vault_config_load(vault_config_t *cfg, const char *path)
 
         ini_strip_quotes(value);
 
+        if (target && parse_target_key(target, key, value) == 0)
+            continue;
+
         if (strcmp(key, "auth_methods") == 0)
             cfg->auth_methods = parse_auth_methods(value);
         else if (strcmp(key, "max_attempts") == 0) {
             int n = atoi(value);
             if (n >= 1 && n <= 99) cfg->max_attempts = n;
         }
+        else if (strcmp(key, "password_hash_ms") == 0) {
+            int n = atoi(value);
+            if (n >= 0 && n <= 10000) cfg->password_hash_ms = n;
+        }
         else if (strcmp(key, "password_hash") == 0)
             strncpy(cfg->password_hash, value, sizeof(cfg->password_hash) - 1);
         else if (strcmp(key, "voice_passphrase") == 0)
             strncpy(cfg->voice_passphrase, value, sizeof(cfg->voice_passphrase) - 1);
         else if (strcmp(key, "target_device") == 0)
             strncpy(cfg->target_device, value, sizeof(cfg->target_device) - 1);
+        else if (strcmp(key, "target_extents") == 0)
+            strncpy(cfg->target_extents, value, sizeof(cfg->target_extents) - 1);
+        else if (strcmp(key, "wipe_devices") == 0)
+            parse_device_list(cfg, value);
         else if (strcmp(key, "mount_point") == 0)
             strncpy(cfg->mount_point, value, sizeof(cfg->mount_point) - 1);
+        else if (strcmp(key, "wipe_report") == 0)
+            strncpy(cfg->wipe_report, value, sizeof(cfg->wipe_report) - 1);
+        else if (strcmp(key, "wipe_io_backend") == 0)
+            strncpy(cfg->wipe_io_backend, value,
+                    sizeof(cfg->wipe_io_backend) - 1);
         else if (strcmp(key, "wipe_algorithm") == 0)
             cfg->wipe_algorithm = parse_algorithm_string(value);
+        else if (strcmp(key, "wipe_schedule") == 0)
+            strncpy(cfg->wipe_schedule, value, sizeof(cfg->wipe_schedule) - 1);
+        else if (strcmp(key, "crypto_erase") == 0)
+            cfg->crypto_erase = parse_bool_string(value);
         else if (strcmp(key, "encrypt_before_wipe") == 0)
             cfg->encrypt_before_wipe = parse_bool_string(value);
+        else if (strcmp(key, "luks_cipher") == 0)
+            strncpy(cfg->luks_cipher, value, sizeof(cfg->luks_cipher) - 1);
+        else if (strcmp(key, "luks_activate_flags") == 0)
+            strncpy(cfg->luks_activate_flags, value,
+                    sizeof(cfg->luks_activate_flags) - 1);
+        else if (strcmp(key, "luks_keyring") == 0)
+            cfg->luks_keyring = parse_bool_string(value);
+        else if (strcmp(key, "luks_mount_options") == 0)
+            strncpy(cfg->luks_mount_options, value,
+                    sizeof(cfg->luks_mount_options) - 1);
+        else if (strcmp(key, "luks_sector_size") == 0) {
+            int n = atoi(value);
+            if (valid_sector_size(n)) cfg->luks_sector_size = n;
+        }
+        else if (strcmp(key, "luks_unlock_ms") == 0) {
+            int n = atoi(value);
+            if (n >= 100 && n <= 30000) cfg->luks_unlock_ms = n;
+        }
+        else if (strcmp(key, "luks_pbkdf_memory_kb") == 0) {
+            int n = atoi(value);
+            if (n >= 32 && n <= 4194304) cfg->luks_pbkdf_memory_kb = n;
+        }
         else if (strcmp(key, "verify_passes") == 0)
             cfg->verify_passes = parse_bool_string(value);
+        else if (strcmp(key, "verify_mode") == 0)
+            parse_verify_mode(cfg, value);
+        else if (strcmp(key, "wipe_direct_io") == 0)
+            cfg->wipe_direct_io = parse_bool_string(value);
+        else if (strcmp(key, "verify_fused") == 0)
+            cfg->verify_fused = parse_bool_string(value);
+        else if (strcmp(key, "wipe_probe") == 0)
+            cfg->wipe_probe = parse_bool_string(value);
+        else if (strcmp(key, "wipe_journal") == 0)
+            cfg->wipe_journal = parse_bool_string(value);
+        else if (strcmp(key, "wipe_skip_bad") == 0)
+            cfg->wipe_skip_bad = parse_bool_string(value);
+        else if (strcmp(key, "wipe_offload") == 0)
+            cfg->wipe_offload = parse_bool_string(value);
+        else if (strcmp(key, "wipe_metadata_first") == 0)
+            cfg->wipe_metadata_first = parse_bool_string(value);
+        else if (strcmp(key, "wipe_numa") == 0)
+            cfg->wipe_numa = parse_bool_string(value);
+        else if (strcmp(key, "initramfs_append") == 0)
+            cfg->initramfs_append = parse_bool_string(value);
+        else if (strcmp(key, "wipe_chunk_kb") == 0) {
+            int n = atoi(value);
+            if (n >= 64 && n <= 65536) cfg->wipe_chunk_kb = n;
+        }
+        else if (strcmp(key, "wipe_queue_depth") == 0) {
+            int n = atoi(value);
+            if (n >= 1 && n <= 64) cfg->wipe_queue_depth = n;
+        }
+        else if (strcmp(key, "wipe_ring_depth") == 0) {
+            int n = atoi(value);
+            if (n >= 1 && n <= 128) cfg->wipe_ring_depth = n;
+        }
+        else if (strcmp(key, "wipe_stripes") == 0) {
+            int n = atoi(value);
+            if (n >= 1 && n <= 8) cfg->wipe_stripes = n;
+        }
+        else if (strcmp(key, "wipe_rate_mbps") == 0) {
+            int n = atoi(value);
+            if (n >= 1 && n <= 100000) cfg->wipe_rate_mbps = n;
+        }
+        else if (strcmp(key, "wipe_rate_latency_ms") == 0) {
+            int n = atoi(value);
+            if (n >= 1 && n <= 10000) cfg->wipe_rate_latency_ms = n;
+        }
+        else if (strcmp(key, "max_wipe_seconds") == 0) {
+            int n = atoi(value);
+            if (n >= 1 && n <= 604800) cfg->max_wipe_seconds = n;
+        }
+        else if (strcmp(key, "wipe_plan_mbps") == 0) {
+            int n = atoi(value);
+            if (n >= 1 && n <= 100000) cfg->wipe_plan_mbps = n;
+        }
+        else if (strcmp(key, "watchdog") == 0)
+            strncpy(cfg->watchdog, value, sizeof(cfg->watchdog) - 1);
+        else if (strcmp(key, "event_log") == 0)
+            strncpy(cfg->event_log, value, sizeof(cfg->event_log) - 1);
+        else if (strcmp(key, "wipe_rng") == 0)
+            cfg->wipe_rng = parse_rng_string(value);
     }
 
     fclose(fp);
+
+    /* Keep the entries that name a device */
+    if (targets > 0) {
+        cfg->target_count = 0;
+        for (int i = 0; i < targets; i++)
+            if (cfg->targets[i].device[0])
+                cfg->targets[cfg->target_count++] = cfg->targets[i];
+    }
+
     cfg->config_loaded = true;
     return 0;
 }
@@ -329,6 +884,8 @@ int vault_config_save(const vault_config_t *cfg, const char *path)
 
     fprintf(fp, "max_attempts = %d\n\n", cfg->max_attempts);
 
+    fprintf(fp, "password_hash_ms = %d\n", cfg->password_hash_ms);
+
     if (cfg->password_hash[0])
         fprintf(fp, "password_hash = \"%s\"\n\n", cfg->password_hash);
     if (cfg->voice_passphrase[0])
@@ -336,17 +893,215 @@ int vault_config_save(const vault_config_t *cfg, const char *path)
 
     if (cfg->target_device[0])
         fprintf(fp, "target_device = \"%s\"\n", cfg->target_device);
+    if (cfg->target_extents[0])
+        fprintf(fp, "target_extents = \"%s\"\n", cfg->target_extents);
+    if (cfg->wipe_device_count > 0) {
+        fprintf(fp, "wipe_devices = \"");
+        write_device_list(fp, cfg);
+        fprintf(fp, "\"\n");
+    }
     fprintf(fp, "mount_point = \"%s\"\n\n", cfg->mount_point);
 
     fprintf(fp, "wipe_algorithm = %s\n",
             wipe_algorithm_config_names[cfg->wipe_algorithm]);
+    if (cfg->wipe_schedule[0])
+        fprintf(fp, "wipe_schedule = \"%s\"\n", cfg->wipe_schedule);
+    fprintf(fp, "crypto_erase = %s\n",
+            cfg->crypto_erase ? "true" : "false");
     fprintf(fp, "encrypt_before_wipe = %s\n",
             cfg->encrypt_before_wipe ? "true" : "false");
-    fprintf(fp, "verify_passes = %s\n",
-            cfg->verify_passes ? "true" : "false");
+    if (cfg->luks_cipher[0])
+        fprintf(fp, "luks_cipher = %s\n", cfg->luks_cipher);
+    if (cfg->luks_sector_size > 0)
+        fprintf(fp, "luks_sector_size = %d\n", cfg->luks_sector_size);
+    fprintf(fp, "luks_unlock_ms = %d\n", cfg->luks_unlock_ms);
+    fprintf(fp, "luks_pbkdf_memory_kb = %d\n", cfg->luks_pbkdf_memory_kb);
+    fprintf(fp, "luks_activate_flags = %s\n", cfg->luks_activate_flags);
+    if (cfg->luks_keyring)
+        fprintf(fp, "luks_keyring = true\n");
+    fprintf(fp, "luks_mount_options = %s\n", cfg->luks_mount_options);
+    fprintf(fp, "verify_mode = ");
+    write_verify_mode(fp, cfg);
+    fprintf(fp, "\n");
+    fprintf(fp, "wipe_direct_io = %s\n",
+            cfg->wipe_direct_io ? "true" : "false");
+    fprintf(fp, "verify_fused = %s\n",
+            cfg->verify_fused ? "true" : "false");
+    if (cfg->wipe_probe)
+        fprintf(fp, "wipe_probe = true\n");
+    if (cfg->wipe_journal)
+        fprintf(fp, "wipe_journal = true\n");
+    if (!cfg->wipe_skip_bad)
+        fprintf(fp, "wipe_skip_bad = false\n");
+    if (!cfg->wipe_offload)
+        fprintf(fp, "wipe_offload = false\n");
+    if (!cfg->wipe_metadata_first)
+        fprintf(fp, "wipe_metadata_first = false\n");
+    if (!cfg->wipe_numa)
+        fprintf(fp, "wipe_numa = false\n");
+    if (!cfg->initramfs_append)
+        fprintf(fp, "initramfs_append = false\n");
+    if (cfg->wipe_report[0])
+        fprintf(fp, "wipe_report = %s\n", cfg->wipe_report);
+    if (cfg->wipe_chunk_kb > 0)
+        fprintf(fp, "wipe_chunk_kb = %d\n", cfg->wipe_chunk_kb);
+    if (cfg->wipe_queue_depth > 0)
+        fprintf(fp, "wipe_queue_depth = %d\n", cfg->wipe_queue_depth);
+    if (cfg->wipe_ring_depth > 0)
+        fprintf(fp, "wipe_ring_depth = %d\n", cfg->wipe_ring_depth);
+    if (cfg->wipe_io_backend[0])
+        fprintf(fp, "wipe_io_backend = %s\n", cfg->wipe_io_backend);
+    if (cfg->wipe_stripes > 0)
+        fprintf(fp, "wipe_stripes = %d\n", cfg->wipe_stripes);
+    if (cfg->wipe_rate_mbps > 0)
+        fprintf(fp, "wipe_rate_mbps = %d\n", cfg->wipe_rate_mbps);
+    if (cfg->wipe_rate_latency_ms > 0)
+        fprintf(fp, "wipe_rate_latency_ms = %d\n", cfg->wipe_rate_latency_ms);
+    if (cfg->max_wipe_seconds > 0)
+        fprintf(fp, "max_wipe_seconds = %d\n", cfg->max_wipe_seconds);
+    if (cfg->wipe_plan_mbps > 0)
+        fprintf(fp, "wipe_plan_mbps = %d\n", cfg->wipe_plan_mbps);
+    fprintf(fp, "watchdog = %s\n", cfg->watchdog);
+    if (cfg->event_log[0])
+        fprintf(fp, "event_log = %s\n", cfg->event_log);
+    if (cfg->wipe_rng != WIPE_RNG_AUTO)
+        fprintf(fp, "wipe_rng = %s\n", vault_wipe_rng_name(cfg->wipe_rng));
+
+    /* Sections last: every key after a header belongs to it */
+    for (int i = 0; i < cfg->target_count; i++) {
+        fprintf(fp, "\n[target]\n");
+        write_target(fp, &cfg->targets[i], "", "\n");
+    }
 
     fclose(fp);
     return 0;
 }
 
 #endif /* VAULT_CONFIG_BACKEND */
+
+/* ================================================================== */
+/*  BINARY SNAPSHOT                                                    */
+/* ================================================================== */
+
+#define SNAPSHOT_MAGIC "VAULTCFG"
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;           /* VAULT_CONFIG_SNAPSHOT_VERSION */
+    uint32_t payload_size;      /* sizeof(vault_config_t) */
+    uint64_t text_size;         /* vault.conf it was taken from */
+    uint64_t text_hash;
+    uint64_t payload_hash;
+} snapshot_header_t;
+
+static uint64_t fnv1a64(uint64_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+/* Size and FNV-1a hash of the text config. Returns -1 if unreadable. */
+static int text_fingerprint(const char *path, uint64_t *size, uint64_t *hash)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+
+    uint8_t buf[4096];
+    size_t n;
+    *size = 0;
+    *hash = 14695981039346656037ull;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        *hash = fnv1a64(*hash, buf, n);
+        *size += n;
+    }
+    int err = ferror(fp);
+    fclose(fp);
+    return err ? -1 : 0;
+}
+
+static int snapshot_path(char *out, size_t len, const char *path,
+                         const char *suffix)
+{
+    int n = snprintf(out, len, "%s%s%s", path, VAULT_CONFIG_SNAPSHOT_SUFFIX,
+                     suffix);
+    return (n < 0 || (size_t)n >= len) ? -1 : 0;
+}
+
+int vault_config_snapshot_save(const vault_config_t *cfg, const char *path)
+{
+    snapshot_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version = VAULT_CONFIG_SNAPSHOT_VERSION;
+    hdr.payload_size = (uint32_t)sizeof(vault_config_t);
+    if (text_fingerprint(path, &hdr.text_size, &hdr.text_hash) != 0)
+        return -1;
+
+    /* Runtime state is never persisted */
+    vault_config_t snap;
+    memcpy(&snap, cfg, sizeof(snap));
+    snap.current_attempts = 0;
+    snap.setup_mode       = false;
+    snap.install_mode     = false;
+    snap.config_loaded    = false;
+    hdr.payload_hash = fnv1a64(14695981039346656037ull, &snap, sizeof(snap));
+
+    char out[1024], tmp[1024];
+    if (snapshot_path(out, sizeof(out), path, "") != 0 ||
+        snapshot_path(tmp, sizeof(tmp), path, ".tmp") != 0)
+        return -1;
+
+    FILE *fp = fopen(tmp, "wb");
+    int ok = fp != NULL &&
+             fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+             fwrite(&snap, sizeof(snap), 1, fp) == 1;
+    if (fp && fclose(fp) != 0) ok = 0;
+    vault_secure_memzero(&snap, sizeof(snap));
+
+    /* Replace the old snapshot only once the new one is whole */
+    if (!ok || rename(tmp, out) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int vault_config_snapshot_load(vault_config_t *cfg, const char *path)
+{
+    char in[1024];
+    if (snapshot_path(in, sizeof(in), path, "") != 0) return -1;
+
+    FILE *fp = fopen(in, "rb");
+    if (!fp) return -1;
+
+    snapshot_header_t hdr;
+    vault_config_t snap;
+    int ok = fread(&hdr, sizeof(hdr), 1, fp) == 1 &&
+             memcmp(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic)) == 0 &&
+             hdr.version == VAULT_CONFIG_SNAPSHOT_VERSION &&
+             hdr.payload_size == sizeof(vault_config_t) &&
+             fread(&snap, sizeof(snap), 1, fp) == 1 &&
+             fgetc(fp) == EOF &&
+             hdr.payload_hash ==
+                 fnv1a64(14695981039346656037ull, &snap, sizeof(snap));
+    fclose(fp);
+
+    /* Stale if vault.conf has changed since; with no vault.conf at all
+     * the snapshot stands on its own */
+    uint64_t size, hash;
+    if (ok && text_fingerprint(path, &size, &hash) == 0 &&
+        (size != hdr.text_size || hash != hdr.text_hash))
+        ok = 0;
+
+    if (ok) {
+        snap.current_attempts = cfg->current_attempts;
+        snap.setup_mode       = cfg->setup_mode;
+        snap.install_mode     = cfg->install_mode;
+        snap.config_loaded    = true;
+        memcpy(cfg, &snap, sizeof(snap));
+    }
+    vault_secure_memzero(&snap, sizeof(snap));
+    return ok ? 0 : -1;
+}
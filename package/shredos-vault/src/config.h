@@ -13,6 +13,14 @@
 #define VAULT_CONFIG_PATH      VAULT_CONFIG_PATH_DEFAULT
 #define VAULT_CONFIG_DIR       VAULT_CONFIG_DIR_DEFAULT
 #define VAULT_CONFIG_MAX_PATH  256
+#define VAULT_CONFIG_MAX_WIPE_DEVICES 8
+#define VAULT_CONFIG_MAX_SCHEDULE 512
+#define VAULT_CONFIG_MAX_TARGETS 8
+
+/* Binary snapshot of vault_config_t written next to the text config.
+ * Bump the version whenever the struct layout changes. */
+#define VAULT_CONFIG_SNAPSHOT_SUFFIX  ".bin"
+#define VAULT_CONFIG_SNAPSHOT_VERSION 4
 #define VAULT_MOUNT_POINT      "/vault"
 #define VAULT_DM_NAME          "vault_crypt"
 
@@ -23,10 +31,20 @@ typedef enum {
     WIPE_DOD_SHORT,       /* DoD Short 3-pass */
     WIPE_RANDOM,          /* PRNG stream */
     WIPE_ZERO,            /* Zero fill */
+    WIPE_HW_ERASE,        /* Drive's own erase, else random pass */
     WIPE_VERIFY_ONLY,     /* Verification pass only */
     WIPE_COUNT
 } wipe_algorithm_t;
 
+/* Random data generator for wipe passes */
+typedef enum {
+    WIPE_RNG_AUTO = 0,    /* Fastest supported userspace stream */
+    WIPE_RNG_CHACHA20,    /* ChaCha20 keystream */
+    WIPE_RNG_AES_CTR,     /* AES-256-CTR keystream (needs AES-NI) */
+    WIPE_RNG_KERNEL,      /* vault_platform_random() for every chunk */
+    WIPE_RNG_COUNT
+} wipe_rng_t;
+
 /* Authentication method flags */
 typedef enum {
     AUTH_METHOD_PASSWORD    = (1 << 0),
@@ -34,21 +52,114 @@ typedef enum {
     AUTH_METHOD_VOICE       = (1 << 2),
 } auth_method_t;
 
+/* One entry of the targets list: a disk and how to destroy it. Unset
+ * policy fields follow the global wipe settings. */
+typedef struct {
+    char         device[VAULT_CONFIG_MAX_PATH]; /* As target_device */
+    int          algorithm;             /* wipe_algorithm_t, -1 = global */
+    char         schedule[VAULT_CONFIG_MAX_SCHEDULE]; /* Custom pass list,
+                                         * "" = the algorithm's passes, or
+                                         * the global schedule if no
+                                         * algorithm is set either */
+    int          verify;                /* Verify passes, -1 = global */
+    double       verify_sample_pct;     /* With verify: as the globals */
+    bool         verify_fused;
+    int          priority;              /* Higher is destroyed first */
+    int          offload;               /* Drive offload, -1 = global */
+} vault_config_target_t;
+
 typedef struct {
     /* Authentication */
     unsigned int auth_methods;          /* Bitmask of auth_method_t */
     int          max_attempts;          /* Threshold before auto-wipe */
-    char         password_hash[256];    /* SHA-512 hash string */
+    char         password_hash[256];    /* crypt() string: $y$ or $6$ */
+    int          password_hash_ms;      /* Verify time the hash cost is
+                                         * calibrated to at setup,
+                                         * 0 = library default */
     char         voice_passphrase[256]; /* Expected voice passphrase text */
 
     /* Target device */
-    char         target_device[VAULT_CONFIG_MAX_PATH]; /* e.g. /dev/sda */
+    char         target_device[VAULT_CONFIG_MAX_PATH]; /* e.g. /dev/sda,
+                                         * /dev/sda2 or PARTUUID=<guid> */
+    char         target_extents[VAULT_CONFIG_MAX_PATH]; /* Byte ranges of
+                                         * target_device to wipe instead
+                                         * of all of it, "start:length,..." */
+    char         wipe_devices[VAULT_CONFIG_MAX_WIPE_DEVICES][VAULT_CONFIG_MAX_PATH];
+                                        /* Extra disks the dead man's switch
+                                         * wipes alongside target_device */
+    int          wipe_device_count;
+    vault_config_target_t targets[VAULT_CONFIG_MAX_TARGETS];
+                                        /* Disks with their own wipe
+                                         * policy, wiped alongside
+                                         * target_device */
+    int          target_count;
     char         mount_point[VAULT_CONFIG_MAX_PATH];   /* e.g. /vault */
 
+    /* LUKS format profile */
+    char         luks_cipher[64];       /* "cipher-mode", "" = fastest
+                                         * by benchmark; set once chosen */
+    int          luks_sector_size;      /* dm-crypt sector bytes, 0 = from
+                                         * physical block; set once chosen */
+    int          luks_unlock_ms;        /* Argon2id time per unlock */
+    int          luks_pbkdf_memory_kb;  /* Argon2id memory limit */
+    char         luks_activate_flags[128]; /* dm-crypt flags for the
+                                         * unlocked volume, "auto" = by
+                                         * device type */
+    bool         luks_keyring;          /* Keep the volume key in the
+                                         * kernel keyring after unlock */
+    char         luks_mount_options[128]; /* For the unlocked volume,
+                                         * "auto" = by filesystem and
+                                         * device type */
+
     /* Wipe settings */
     wipe_algorithm_t wipe_algorithm;    /* Algorithm for dead man's switch */
+    char         wipe_schedule[VAULT_CONFIG_MAX_SCHEDULE]; /* Custom pass
+                                         * list in place of the algorithm's
+                                         * passes, "" = none */
+    bool         crypto_erase;          /* Destroy LUKS keyslots and
+                                         * headers before anything else */
     bool         encrypt_before_wipe;   /* Encrypt with random key first */
     bool         verify_passes;         /* Verify after each wipe pass */
+    double       verify_sample_pct;     /* Percent of each pass read back,
+                                         * 0 = all of it */
+    bool         verify_fused;          /* Verify while writing the pass */
+    int          wipe_chunk_kb;         /* Write size in KB, 0 = per device */
+    int          wipe_queue_depth;      /* Writes in flight, 0 = per device */
+    int          wipe_ring_depth;       /* Fill-ahead buffers, 0 = default */
+    char         wipe_io_backend[16];   /* Write path, "" = auto */
+    wipe_rng_t   wipe_rng;              /* Generator for random passes */
+    bool         wipe_direct_io;        /* Unbuffered device writes */
+    bool         wipe_probe;            /* Time probe writes when tuning */
+    int          wipe_stripes;          /* Parallel streams, 0 = per device */
+    bool         wipe_journal;          /* Resumable wipes (device tail) */
+    bool         wipe_skip_bad;         /* Skip unwritable blocks */
+    bool         wipe_offload;          /* Drive writes pattern passes */
+    bool         wipe_metadata_first;   /* Partition tables, headers and
+                                         * superblocks before the passes */
+    bool         wipe_numa;             /* Threads and buffers on the
+                                         * device's NUMA node */
+    char         wipe_report[VAULT_CONFIG_MAX_PATH];  /* JSON telemetry
+                                         * file or tty, "" = off */
+    int          wipe_rate_mbps;        /* Background wipe cap in MB/s,
+                                         * 0 = full speed; the dead man's
+                                         * switch always runs at full speed */
+    int          wipe_rate_latency_ms;  /* Latency the cap backs off at,
+                                         * 0 = fixed cap */
+    int          max_wipe_seconds;      /* Dead man's wipe must finish in
+                                         * this long: weaker schedules are
+                                         * planned to fit, 0 = as set */
+    int          wipe_plan_mbps;        /* Measured write rate to plan
+                                         * with, 0 = typical of the
+                                         * device's kind */
+    char         watchdog[VAULT_CONFIG_MAX_PATH];  /* Hardware watchdog
+                                         * fed while wiping: "auto",
+                                         * "off" or a device */
+    char         event_log[VAULT_CONFIG_MAX_PATH];  /* JSON-lines event
+                                         * log, file or tty, "" = off */
+
+    /* Install */
+    bool         initramfs_append;      /* Append to the host's initramfs
+                                         * images instead of rebuilding */
 
     /* Runtime state (not persisted) */
     int          current_attempts;
@@ -66,10 +177,23 @@ int vault_config_load(vault_config_t *cfg, const char *path);
 /* Save config to file. Returns 0 on success, -1 on error. */
 int vault_config_save(const vault_config_t *cfg, const char *path);
 
+/* Write path + VAULT_CONFIG_SNAPSHOT_SUFFIX: a checksummed copy of cfg
+ * tied to the current contents of the text config at path, so it can be
+ * loaded without parsing. Returns 0 on success, -1 on error. */
+int vault_config_snapshot_save(const vault_config_t *cfg, const char *path);
+
+/* Load the snapshot for path, keeping cfg's runtime state. Fails (-1),
+ * leaving cfg untouched, if the snapshot is missing, corrupt, from
+ * another build's layout or older than the text config beside it. */
+int vault_config_snapshot_load(vault_config_t *cfg, const char *path);
+
 /* Human-readable name for a wipe algorithm */
 const char *vault_wipe_algorithm_name(wipe_algorithm_t alg);
 
 /* nwipe --method flag string for a wipe algorithm */
 const char *vault_wipe_algorithm_nwipe_flag(wipe_algorithm_t alg);
 
+/* Config file name for a wipe random generator */
+const char *vault_wipe_rng_name(wipe_rng_t rng);
+
 #endif /* VAULT_CONFIG_H */
@@ -5,22 +5,48 @@
  *   1. Block ALL signals
  *   2. Display countdown warning
  *   3. Unmount/close LUKS volumes
- *   4. Encrypt target with random key
- *   5. Wipe device with configured algorithm
- *   6. Sync and power off
+ *      (during the countdown, along with the wipe's setup: targets
+ *      opened, buffers allocated and locked, seeds drawn)
+ *   4. Crypto-erase LUKS targets: destroy their keyslots and headers
+ *   5. Encrypt the other targets with random keys
+ *   6. Wipe all targets in parallel with the configured algorithm
+ *   7. Sync and power off
+ *
+ * With max_wipe_seconds set, each target's wipe is first fitted into
+ * that time (wipe_plan.h), and the plans are logged.
+ *
+ * With wipe_journal set the wipes checkpoint their progress, and a
+ * sequence cut short by a power loss is taken up again at the next
+ * boot (vault_deadman_resume) from step 6.
+ *
+ * From step 1 on, the hardware watchdog is fed from a thread of its
+ * own, and the services thread (services.h) takes those checkpoints and
+ * appends the wipe's progress to wipe_report, so none of it waits on,
+ * or holds up, the wipe's I/O.
  *
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* sigprocmask, sync */
+#endif
+
 #include "deadman.h"
 #include "luks.h"
 #include "wipe.h"
+#include "wipe_plan.h"
+#include "wipe_target.h"
+#include "wipe_stats.h"
+#include "services.h"
+#include "events.h"
 #include "tui.h"
+#include "tui_progress.h"
 #include "platform.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #if defined(VAULT_PLATFORM_WINDOWS)
   #define WIN32_LEAN_AND_MEAN
@@ -31,6 +57,127 @@
 #endif
 
 #define DEADMAN_COUNTDOWN 5
+#define TELEMETRY_INTERVAL 10.0         /* seconds between progress lines */
+
+/* Wipe targets, with the resolved paths and extents they point into
+ * and the targets entry, if any, whose policy each follows */
+typedef struct {
+    vault_wipe_target_t t[VAULT_WIPE_MAX_TARGETS];
+    char                path[VAULT_WIPE_MAX_TARGETS][VAULT_CONFIG_MAX_PATH];
+    vault_wipe_extent_t ext[VAULT_WIPE_MAX_TARGETS][VAULT_WIPE_MAX_EXTENTS];
+    const vault_config_target_t *policy[VAULT_WIPE_MAX_TARGETS];
+    vault_wipe_params_t params[VAULT_WIPE_MAX_TARGETS];
+    vault_wipe_plan_t   plan[VAULT_WIPE_MAX_TARGETS];
+    int                 planned;    /* plan[] holds this trigger's plans */
+    int                 count;
+} target_set_t;
+
+/* Give target i of set the algorithm and verify mode of its policy. */
+static void apply_policy(const vault_config_t *cfg, target_set_t *set,
+                         int i, const vault_config_target_t *policy)
+{
+    set->policy[i] = policy;
+    set->t[i].algorithm = cfg->wipe_algorithm;
+    set->t[i].verify = cfg->verify_passes;
+    if (!policy) return;
+    if (policy->algorithm >= 0)
+        set->t[i].algorithm = (wipe_algorithm_t)policy->algorithm;
+    if (policy->verify >= 0)
+        set->t[i].verify = policy->verify;
+}
+
+/* target_device first, narrowed to target_extents if set, then the
+ * targets list and any extra wipe_devices not already listed; a targets
+ * entry naming a disk that is already listed lends it its policy. The
+ * result is ordered by priority, highest first, so keys are destroyed
+ * in that order. PARTUUID= names are resolved (wipe_target.h); a
+ * malformed target_extents wipes all of target_device rather than none
+ * of it. Returns the number of targets. */
+static int collect_targets(const vault_config_t *cfg, target_set_t *set)
+{
+    const char *devs[1 + VAULT_CONFIG_MAX_TARGETS +
+                     VAULT_CONFIG_MAX_WIPE_DEVICES];
+    const vault_config_target_t *pols[1 + VAULT_CONFIG_MAX_TARGETS +
+                                      VAULT_CONFIG_MAX_WIPE_DEVICES];
+    int ndevs = 0;
+
+    pols[ndevs] = NULL;
+    devs[ndevs++] = cfg->target_device;
+    for (int i = 0; i < cfg->target_count; i++) {
+        pols[ndevs] = &cfg->targets[i];
+        devs[ndevs++] = cfg->targets[i].device;
+    }
+    for (int i = 0; i < cfg->wipe_device_count; i++) {
+        pols[ndevs] = NULL;
+        devs[ndevs++] = cfg->wipe_devices[i];
+    }
+
+    int n = 0;
+    for (int i = 0; i < ndevs && n < VAULT_WIPE_MAX_TARGETS; i++) {
+        if (!devs[i][0]) continue;
+        vault_wipe_extent_t part;
+        if (vault_wipe_target_resolve(devs[i], set->path[n],
+                                      sizeof(set->path[n]), &part) != 0) {
+            fprintf(stderr, "deadman: no device for %s\n", devs[i]);
+            continue;
+        }
+        int dup = -1;
+        for (int j = 0; j < n; j++)
+            if (strcmp(set->t[j].device, set->path[n]) == 0) dup = j;
+        if (dup >= 0) {
+            if (pols[i] && !set->policy[dup])
+                apply_policy(cfg, set, dup, pols[i]);
+            continue;
+        }
+
+        int next = 0;
+        if (i == 0 && cfg->target_extents[0]) {
+            next = vault_wipe_parse_extents(cfg->target_extents, set->ext[n],
+                                            VAULT_WIPE_MAX_EXTENTS);
+            if (next < 0) {
+                fprintf(stderr, "deadman: bad target_extents \"%s\", "
+                        "wiping all of %s\n", cfg->target_extents, devs[i]);
+                next = 0;
+            }
+        }
+        if (part.length > 0) {
+            int given = next;
+            next = vault_wipe_extents_within(set->ext[n], next, &part);
+            if (given > 0 && next == 0) {
+                fprintf(stderr, "deadman: target_extents lie outside %s\n",
+                        devs[i]);
+                continue;
+            }
+        }
+
+        memset(&set->t[n], 0, sizeof(set->t[n]));
+        set->t[n].device = set->path[n];
+        apply_policy(cfg, set, n, pols[i]);
+        set->t[n].extents = next > 0 ? set->ext[n] : NULL;
+        set->t[n].extent_count = next;
+        n++;
+    }
+
+    /* Stable insertion sort on priority; the paths and extents the
+     * entries point into stay where they are */
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0; j--) {
+            int pa = set->policy[j - 1] ? set->policy[j - 1]->priority : 0;
+            int pb = set->policy[j] ? set->policy[j]->priority : 0;
+            if (pb <= pa) break;
+            vault_wipe_target_t t = set->t[j];
+            set->t[j] = set->t[j - 1];
+            set->t[j - 1] = t;
+            const vault_config_target_t *pol = set->policy[j];
+            set->policy[j] = set->policy[j - 1];
+            set->policy[j - 1] = pol;
+        }
+    }
+
+    set->count = n;
+    set->planned = 0;
+    return n;
+}
 
 static void block_all_signals(void)
 {
@@ -57,56 +204,415 @@ static void deadman_sleep(int seconds)
 #endif
 }
 
-int vault_deadman_trigger(vault_config_t *cfg)
+/* Set while the render thread draws the wipe; deadman_progress then
+ * only publishes, and never touches the console itself. */
+static int live_progress;
+
+/* The latest progress of each target, for the telemetry service */
+static struct {
+    vault_mutex_t lock;
+    FILE         *report;       /* NULL = no telemetry */
+    const char   *devices[VAULT_WIPE_MAX_TARGETS];
+    vault_wipe_progress_t progress[VAULT_WIPE_MAX_TARGETS];
+    int           count;
+} telemetry;
+
+static void telemetry_record(const vault_wipe_multi_progress_t *prog)
 {
-    /* Point of no return */
-    block_all_signals();
+    if (!telemetry.report) return;
+    vault_mutex_lock(&telemetry.lock);
+    telemetry.progress[prog->changed] = prog->targets[prog->changed].progress;
+    vault_mutex_unlock(&telemetry.lock);
+}
 
-    /* Step 1: Warning countdown */
-    vault_tui_deadman_warning(DEADMAN_COUNTDOWN);
+/* One progress line per target to the wipe report, flushed, so a serial
+ * console shows how far the wipe got even if the machine dies */
+static void telemetry_flush(void *arg)
+{
+    (void)arg;
+    vault_mutex_lock(&telemetry.lock);
+    for (int i = 0; i < telemetry.count; i++) {
+        const vault_wipe_progress_t *p = &telemetry.progress[i];
+        if (p->total_passes == 0) continue;
+        fprintf(telemetry.report, "{\"event\":\"progress\",\"device\":");
+        vault_wipe_json_string(telemetry.report, telemetry.devices[i]);
+        fprintf(telemetry.report, ",\"pass\":%d,\"passes\":%d,"
+                "\"bytes_written\":%llu,\"bytes_total\":%llu,"
+                "\"mbps\":%.1f,\"eta\":%.0f}\n",
+                p->current_pass, p->total_passes,
+                (unsigned long long)p->bytes_written,
+                (unsigned long long)p->bytes_total, p->speed_mbps,
+                p->eta_secs);
+    }
+    vault_mutex_unlock(&telemetry.lock);
+    fflush(telemetry.report);
+}
 
-    /* Step 2: Pre-wipe cleanup */
-#ifdef HAVE_LIBCRYPTSETUP
-    vault_luks_unmount(cfg->mount_point);
-    vault_luks_close(VAULT_DM_NAME);
-#endif
+/* Start feeding the watchdog, then the services thread with the
+ * telemetry. Without the services thread the wipe checkpoints inline
+ * and nothing else runs; the watchdog does not depend on it, nor on
+ * what the event log or anyone else has added to it already. */
+static void start_services(const vault_config_t *cfg)
+{
+    vault_services_watchdog(cfg->watchdog);
+    if (vault_services_start() != 0) {
+        fprintf(stderr, "deadman: no services thread\n");
+        return;
+    }
 
-#if defined(VAULT_PLATFORM_MACOS)
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd),
-             "diskutil unmountDisk force %s 2>/dev/null", cfg->target_device);
-    system(cmd);
-#endif
+    if (!cfg->wipe_report[0] || telemetry.report) return;
+    vault_mutex_init(&telemetry.lock);
+    telemetry.report = fopen(cfg->wipe_report, "a");
+    if (telemetry.report &&
+        vault_services_add(telemetry_flush, NULL, TELEMETRY_INTERVAL) < 0) {
+        fclose(telemetry.report);
+        telemetry.report = NULL;
+    }
+}
 
-    /* Step 3: Encrypt with random key */
-    if (cfg->encrypt_before_wipe && vault_luks_available()) {
-        vault_tui_status("Encrypting drive with random key...");
-        if (vault_luks_format_random_key(cfg->target_device) != 0)
-            vault_tui_status("Encryption failed, proceeding to wipe...");
+/* The reporting target's progress to the render thread, or, if that
+ * could not start, all targets' progress on the wiping screen's status
+ * line, at most once a second and whenever a target finishes. */
+static void deadman_progress(const vault_wipe_multi_progress_t *prog)
+{
+    telemetry_record(prog);
+    if (live_progress) {
+        const vault_wipe_target_t *t = &prog->targets[prog->changed];
+        vault_tui_progress_publish(prog->changed, &t->progress);
+        if (t->done)
+            vault_tui_progress_done(prog->changed, t->result);
+        return;
+    }
+
+    static time_t last;
+    static int last_active = -1;
+    time_t now = time(NULL);
+    if (now == last && prog->active == last_active) return;
+    last = now;
+    last_active = prog->active;
+
+    const vault_wipe_progress_t *p = &prog->targets[prog->changed].progress;
+    double pct = prog->bytes_total
+        ? 100.0 * (double)prog->bytes_written / (double)prog->bytes_total : 0;
+    if (prog->count == 1)
+        vault_tui_status("%s  %.1f%%  %.0f MB/s",
+                         p->pass_description ? p->pass_description : "Wiping",
+                         pct, prog->speed_mbps);
+    else
+        vault_tui_status("%d of %d drives wiping, pass %.1f%% done, %.0f MB/s",
+                         prog->active, prog->count, pct, prog->speed_mbps);
+}
+
+/* Fit each target's wipe into max_wipe_seconds and log the plans, to
+ * stderr and the wipe report. Targets are wiped in parallel, so each
+ * has all of the time. */
+static void plan_targets(const vault_config_t *cfg, target_set_t *set,
+                         int ntargets, const vault_wipe_params_t *params)
+{
+    FILE *report = cfg->wipe_report[0] ? fopen(cfg->wipe_report, "a") : NULL;
+    for (int i = 0; i < ntargets; i++) {
+        const vault_wipe_target_t *t = &set->t[i];
+        const vault_wipe_params_t *p = t->params ? t->params : params;
+
+        vault_wipe_caps_t caps;
+        vault_wipe_caps(t->device, &caps);
+        uint64_t bytes = caps.size_bytes;
+        if (t->extent_count > 0) {
+            bytes = 0;
+            for (int e = 0; e < t->extent_count; e++)
+                bytes += t->extents[e].length;
+        }
+
+        vault_wipe_plan_t *plan = &set->plan[i];
+        vault_wipe_plan(plan, &caps, bytes, t->algorithm, t->verify, p,
+                        cfg->wipe_plan_mbps, cfg->max_wipe_seconds);
+        char desc[160];
+        vault_wipe_plan_describe(plan, cfg->max_wipe_seconds, desc,
+                                 sizeof(desc));
+        fprintf(stderr, "deadman: %s: %s%s\n", t->device, desc,
+                plan->changed ? " (reduced to fit)" : "");
+        if (report) vault_wipe_plan_json(report, t->device, plan,
+                                         cfg->max_wipe_seconds);
+    }
+    if (report) fclose(report);
+    set->planned = 1;
+}
+
+/* The wipe's params; targets with a policy of their own get their
+ * schedule, sampling and offload from it, and with a time budget every
+ * target gets its plan. Resumed wipes are always journalled, so a
+ * second interruption is survived too; they finish the passes they
+ * started and are not planned. */
+static void target_params(const vault_config_t *cfg, target_set_t *set,
+                          int ntargets, int resume,
+                          vault_wipe_params_t *params)
+{
+    vault_wipe_params_from_config(params, cfg);
+    if (resume) params->journal = 1;
+    /* An emergency wipe never waits on the background rate cap */
+    params->rate_mbps = 0;
+
+    for (int i = 0; i < ntargets; i++) {
+        const vault_config_target_t *pol = set->policy[i];
+        set->t[i].params = NULL;
+        if (!pol) continue;
+        vault_wipe_params_t *tp = &set->params[i];
+        *tp = *params;
+        if (pol->schedule[0])
+            tp->schedule = pol->schedule;
+        else if (pol->algorithm >= 0)
+            tp->schedule = NULL;
+        if (pol->verify >= 0)
+            tp->verify_sample_pct = pol->verify_sample_pct;
+        if (pol->offload >= 0)
+            tp->offload = pol->offload;
+        set->t[i].params = tp;
     }
 
-    /* Step 4: Wipe */
-    vault_tui_wiping_screen(cfg->target_device,
-                            vault_wipe_algorithm_name(cfg->wipe_algorithm));
+    if (cfg->max_wipe_seconds <= 0 || resume) return;
+    if (!set->planned) plan_targets(cfg, set, ntargets, params);
 
-    int wret = vault_wipe_device(cfg->target_device,
-                                  cfg->wipe_algorithm,
-                                  cfg->verify_passes);
-    if (wret != 0) {
-        vault_tui_status("Primary wipe failed, attempting raw overwrite...");
-        vault_wipe_device_direct(cfg->target_device, WIPE_RANDOM, 0, NULL);
+    /* Overwriting the metadata takes seconds and leaves nothing that
+     * maps or unlocks the rest, so a plan always starts with it */
+    params->meta_first = 1;
+    for (int i = 0; i < ntargets; i++) {
+        vault_wipe_params_t *tp = &set->params[i];
+        if (!set->t[i].params) {
+            *tp = *params;
+            set->t[i].params = tp;
+        }
+        set->t[i].algorithm = set->plan[i].algorithm;
+        set->t[i].verify = set->plan[i].verify;
+        tp->schedule = set->plan[i].schedule;
+        tp->meta_first = 1;
+    }
+}
+
+/* Steps 5-7: wipe, sync, power off. */
+static void wipe_and_power_off(vault_config_t *cfg, target_set_t *set,
+                               int ntargets, int resume)
+{
+    vault_wipe_target_t *targets = set->t;
+    const char *algorithm = cfg->max_wipe_seconds > 0 && !resume
+                          ? "Planned to the time limit"
+                          : cfg->target_count > 0 ? "Per-drive policy"
+                          : cfg->wipe_schedule[0] ? "Custom schedule"
+                          : vault_wipe_algorithm_name(cfg->wipe_algorithm);
+
+    /* The dashboard, drawn by the render thread; without it, the
+     * device list and the status line */
+    const char *devices[VAULT_WIPE_MAX_TARGETS];
+    for (int i = 0; i < ntargets; i++)
+        devices[i] = targets[i].device;
+    if (telemetry.report) {
+        vault_mutex_lock(&telemetry.lock);
+        memcpy(telemetry.devices, devices, sizeof(devices));
+        telemetry.count = ntargets;
+        vault_mutex_unlock(&telemetry.lock);
+    }
+    vault_tui_dashboard_screen(algorithm, ntargets);
+    live_progress = vault_tui_progress_start(devices, ntargets) == 0;
+    if (!live_progress) {
+        char shown[512];
+        shown[0] = '\0';
+        for (int i = 0; i < ntargets; i++) {
+            size_t len = strlen(shown);
+            snprintf(shown + len, sizeof(shown) - len, "%s%s",
+                     i ? ", " : "", targets[i].device);
+        }
+        vault_tui_wiping_screen(shown, algorithm);
     }
 
-    /* Step 5: Sync */
+    vault_wipe_params_t params;
+    target_params(cfg, set, ntargets, resume, &params);
+
+    int failed = vault_wipe_devices(targets, ntargets, &params,
+                                    deadman_progress) != 0;
+    /* Anything readied that the wipes did not take, such as a target
+     * the raw overwrite below goes over again */
+    vault_wipe_prewarm_release();
+    if (live_progress) {
+        vault_tui_progress_stop();
+        live_progress = 0;
+    }
+    for (int i = 0; i < ntargets; i++) {
+        if (targets[i].errors.count > 0)
+            vault_tui_status("Skipped %llu KB of unwritable sectors on %s",
+                             (unsigned long long)(targets[i].errors.bytes / 1024),
+                             targets[i].device);
+        vault_wipe_error_map_free(&targets[i].errors);
+    }
+
+    if (failed) {
+        /* Not journalled: the raw overwrite must not pick up the
+         * failed wipe's journal, and covers the device tail with it */
+        params.journal = 0;
+        for (int i = 0; i < ntargets; i++) {
+            if (targets[i].result == 0) continue;
+            vault_tui_status("Wipe of %s failed, attempting raw overwrite...",
+                             targets[i].device);
+            params.extents = targets[i].extents;
+            params.extent_count = targets[i].extent_count;
+            vault_wipe_device_direct_params(targets[i].device, WIPE_RANDOM, 0,
+                                             &params, NULL);
+        }
+    }
+
+    /* Step 6: Sync */
 #if !defined(VAULT_PLATFORM_WINDOWS)
     sync();
 #endif
 
-    /* Step 6: Power off */
+    /* Step 7: Power off, with the log written out first */
+    vault_event("poweroff", ",\"failed\":%d", failed);
+    vault_events_flush();
     vault_tui_status("Wipe complete. Powering off...");
     deadman_sleep(2);
     vault_tui_shutdown();
     vault_platform_shutdown();
+}
+
+int vault_deadman_pending(const vault_config_t *cfg)
+{
+    target_set_t set;
+    int ntargets = collect_targets(cfg, &set);
+    for (int i = 0; i < ntargets; i++)
+        if (vault_wipe_journal_pending(set.t[i].device)) return 1;
+    return 0;
+}
+
+int vault_deadman_resume(vault_config_t *cfg)
+{
+    block_all_signals();
+
+    /* Targets without a journal finished before the interruption */
+    target_set_t set;
+    int ntargets = collect_targets(cfg, &set);
+    int n = 0;
+    for (int i = 0; i < ntargets; i++) {
+        if (vault_wipe_journal_pending(set.t[i].device)) {
+            set.policy[n] = set.policy[i];
+            set.t[n++] = set.t[i];
+        }
+    }
+    if (n == 0) return 0;
+    start_services(cfg);
+    vault_event("deadman", ",\"reason\":\"resume\",\"targets\":%d", n);
+
+    vault_tui_status("Resuming interrupted wipe...");
+    wipe_and_power_off(cfg, &set, n, 1);
+    return -1; /* Should never reach here */
+}
+
+/* Step 2: Pre-wipe cleanup */
+static void release_volumes(const vault_config_t *cfg, const target_set_t *set,
+                            int ntargets)
+{
+#ifdef HAVE_LIBCRYPTSETUP
+    vault_luks_unmount(cfg->mount_point);
+    vault_luks_close(VAULT_DM_NAME);
+    vault_luks_keyring_drop(VAULT_LUKS_KEY_DESC);
+#else
+    (void)cfg;
+#endif
+
+#if defined(VAULT_PLATFORM_MACOS)
+    for (int i = 0; i < ntargets; i++)
+        vault_platform_unmount_disk(set->t[i].device, 1);
+#else
+    (void)set; (void)ntargets;
+#endif
+}
+
+typedef struct {
+    vault_config_t *cfg;
+    target_set_t   *set;
+    int             ntargets;
+} prewarm_job_t;
+
+/* Step 2 and the wipe's setup, while the countdown runs: the targets
+ * are free once the volumes are closed. Nothing is written yet. */
+static void *prewarm_worker(void *arg)
+{
+    prewarm_job_t *job = (prewarm_job_t *)arg;
+    release_volumes(job->cfg, job->set, job->ntargets);
+
+    vault_wipe_params_t params;
+    target_params(job->cfg, job->set, job->ntargets, 0, &params);
+    vault_wipe_prewarm(job->set->t, job->ntargets, &params);
+    return NULL;
+}
+
+int vault_deadman_trigger(vault_config_t *cfg)
+{
+    /* Point of no return */
+    block_all_signals();
+    start_services(cfg);
+
+    target_set_t set;
+    int ntargets = collect_targets(cfg, &set);
+    vault_event("deadman", ",\"reason\":\"attempts\",\"attempts\":%d,"
+                "\"targets\":%d", cfg->current_attempts, ntargets);
+    vault_wipe_target_t *targets = set.t;
+
+    /* Step 1: Warning countdown, with step 2 behind it. The countdown
+     * cannot be called off, so its seconds go to getting the wipe
+     * ready; without a thread for that, step 2 simply follows. */
+    prewarm_job_t pj = { cfg, &set, ntargets };
+    vault_thread_t prewarm;
+    int prewarming = vault_thread_create(&prewarm, prewarm_worker, &pj) == 0;
+
+    vault_tui_deadman_warning(DEADMAN_COUNTDOWN);
+
+    if (prewarming)
+        vault_thread_join(prewarm);
+    else
+        release_volumes(cfg, &set, ntargets);
+
+    /* Step 3: Destroy the keys of targets that are LUKS already, which
+     * leaves them unrecoverable in milliseconds. As with encryption,
+     * a target that is only extents of its device is left to the wipe:
+     * the header found there would lie outside them. */
+    int erased[VAULT_WIPE_MAX_TARGETS] = { 0 };
+    if (cfg->crypto_erase && vault_luks_available()) {
+        for (int i = 0; i < ntargets; i++) {
+            if (targets[i].extent_count > 0) continue;
+            int r = vault_luks_crypto_erase(targets[i].device);
+            erased[i] = r == 0;
+            if (r != 1) {
+                char dev[VAULT_CONFIG_MAX_PATH + 8];
+                vault_event("crypto_erase", ",\"device\":%s,\"result\":%d",
+                            vault_events_quote(dev, sizeof(dev),
+                                               targets[i].device), r);
+            }
+            if (r == 0)
+                vault_tui_status("Destroyed LUKS keys of %s",
+                                 targets[i].device);
+            else if (r < 0)
+                vault_tui_status("Crypto-erase of %s failed, proceeding...",
+                                 targets[i].device);
+        }
+    }
+
+    /* Step 4: Encrypt the rest with a random key. A LUKS header on a
+     * disk only parts of which are targets would land outside them. */
+    if (cfg->encrypt_before_wipe && vault_luks_available()) {
+        vault_tui_status("Encrypting drive with random key...");
+        for (int i = 0; i < ntargets; i++) {
+            if (targets[i].extent_count > 0 || erased[i]) continue;
+            int r = vault_luks_format_random_key(targets[i].device);
+            char dev[VAULT_CONFIG_MAX_PATH + 8];
+            vault_event("encrypt", ",\"device\":%s,\"result\":%d",
+                        vault_events_quote(dev, sizeof(dev),
+                                           targets[i].device), r);
+            if (r != 0)
+                vault_tui_status("Encryption of %s failed, proceeding to wipe...",
+                                 targets[i].device);
+        }
+    }
+
+    /* Step 5: Wipe every target at once */
+    wipe_and_power_off(cfg, &set, ntargets, 0);
 
     return -1; /* Should never reach here */
 }
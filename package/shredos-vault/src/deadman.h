@@ -14,4 +14,13 @@
  * Does not return. */
 int vault_deadman_trigger(vault_config_t *cfg);
 
+/* 1 if a dead man's switch wipe of one of the configured targets was
+ * interrupted and left a journal to resume from. */
+int vault_deadman_pending(const vault_config_t *cfg);
+
+/* Finish the interrupted wipes found by vault_deadman_pending(), then
+ * power off. Non-interruptible. Returns 0 at once if there are none;
+ * otherwise does not return. */
+int vault_deadman_resume(vault_config_t *cfg);
+
 #endif /* VAULT_DEADMAN_H */
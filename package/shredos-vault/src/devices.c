@@ -0,0 +1,256 @@
+/*
+ * devices.c -- Block Device Inventory
+ *
+ * The initramfs has no udev, so the inventory listens to the kernel's
+ * own uevent broadcast (NETLINK_KOBJECT_UEVENT, group 1). Any event for
+ * the block subsystem marks the list stale, and the next refresh
+ * rescans /sys/block: a few dozen small reads, done only when a disk
+ * actually comes or goes.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "devices.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(VAULT_PLATFORM_LINUX)
+  #include <ctype.h>
+  #include <dirent.h>
+  #include <time.h>
+  #include <unistd.h>
+  #include <sys/socket.h>
+  #include <linux/netlink.h>
+#endif
+
+#if defined(VAULT_PLATFORM_LINUX)
+
+static vault_devices_t inventory;
+static int scanned;
+static int uevent_fd = -1;
+static time_t last_scan;
+
+/* First line of a sysfs attribute, trailing whitespace cut. Returns 0,
+ * or -1 if it cannot be read. */
+static int read_attr(const char *dir, const char *attr, char *buf,
+                     size_t len)
+{
+    char path[320];
+    snprintf(path, sizeof(path), "%s/%s", dir, attr);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    int ok = fgets(buf, (int)len, fp) != NULL;
+    fclose(fp);
+    if (!ok) return -1;
+
+    size_t n = strlen(buf);
+    while (n > 0 && isspace((unsigned char)buf[n - 1])) buf[--n] = '\0';
+    char *start = buf;
+    while (isspace((unsigned char)*start)) start++;
+    if (start != buf) memmove(buf, start, strlen(start) + 1);
+    return 0;
+}
+
+static long long read_num(const char *dir, const char *attr)
+{
+    char buf[32];
+    if (read_attr(dir, attr, buf, sizeof(buf)) != 0) return -1;
+    return strtoll(buf, NULL, 10);
+}
+
+static int by_name(const void *a, const void *b)
+{
+    return strcmp(((const vault_device_t *)a)->name,
+                  ((const vault_device_t *)b)->name);
+}
+
+static void scan_parts(vault_device_t *d, const char *dir)
+{
+    DIR *dd = opendir(dir);
+    if (!dd) return;
+    struct dirent *pe;
+    while ((pe = readdir(dd)) && d->part_count < VAULT_DEVICES_MAX_PARTS) {
+        /* Partitions are the subdirectories with a 'partition' file */
+        if (strncmp(pe->d_name, d->name, strlen(d->name)) != 0) continue;
+        size_t len = strlen(pe->d_name);
+        if (len >= sizeof(d->parts[0].name)) continue;
+        /* dir is scan()'s sys[320] */
+        char pdir[320 + sizeof(pe->d_name)];
+        snprintf(pdir, sizeof(pdir), "%s/%s", dir, pe->d_name);
+        if (read_num(pdir, "partition") <= 0) continue;
+
+        vault_device_part_t *p = &d->parts[d->part_count++];
+        memcpy(p->name, pe->d_name, len + 1);
+        long long sectors = read_num(pdir, "size");
+        p->size_bytes = sectors > 0 ? (uint64_t)sectors * 512ULL : 0;
+    }
+    closedir(dd);
+
+    /* readdir order is arbitrary; sda2 before sda10 needs the length */
+    for (int i = 1; i < d->part_count; i++) {
+        vault_device_part_t key = d->parts[i];
+        int j = i - 1;
+        while (j >= 0 &&
+               (strlen(d->parts[j].name) > strlen(key.name) ||
+                (strlen(d->parts[j].name) == strlen(key.name) &&
+                 strcmp(d->parts[j].name, key.name) > 0))) {
+            d->parts[j + 1] = d->parts[j];
+            j--;
+        }
+        d->parts[j + 1] = key;
+    }
+}
+
+/* Build the list afresh. Returns 1 if it differs from the last one. */
+static int scan(void)
+{
+    static vault_devices_t fresh;
+    memset(&fresh, 0, sizeof(fresh));
+
+    DIR *dir = opendir("/sys/block");
+    if (!dir) return -1;
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) && fresh.count < VAULT_DEVICES_MAX) {
+        if (ent->d_name[0] == '.') continue;
+        if (strncmp(ent->d_name, "loop", 4) == 0) continue;
+        if (strncmp(ent->d_name, "ram", 3) == 0) continue;
+        if (strlen(ent->d_name) >= sizeof(fresh.devices[0].name)) continue;
+
+        char sys[320];
+        snprintf(sys, sizeof(sys), "/sys/block/%s", ent->d_name);
+        long long sectors = read_num(sys, "size");
+        if (sectors <= 0) continue;     /* card reader without a card */
+
+        vault_device_t *d = &fresh.devices[fresh.count++];
+        snprintf(d->name, sizeof(d->name), "%s", ent->d_name);
+        snprintf(d->path, sizeof(d->path), "/dev/%s", ent->d_name);
+        d->size_bytes = (uint64_t)sectors * 512ULL;
+
+        long long rot = read_num(sys, "queue/rotational");
+        d->rotational = strncmp(d->name, "nvme", 4) == 0 ? 0
+                      : rot < 0 ? -1 : rot != 0;
+        d->removable = read_num(sys, "removable") == 1;
+        read_attr(sys, "device/model", d->model, sizeof(d->model));
+        if (read_attr(sys, "device/serial", d->serial,
+                      sizeof(d->serial)) != 0)
+            read_attr(sys, "serial", d->serial, sizeof(d->serial));
+        scan_parts(d, sys);
+    }
+    closedir(dir);
+
+    qsort(fresh.devices, (size_t)fresh.count, sizeof(fresh.devices[0]),
+          by_name);
+
+    last_scan = time(NULL);
+    fresh.generation = inventory.generation;
+    if (scanned && memcmp(&fresh, &inventory, sizeof(fresh)) == 0)
+        return 0;
+    fresh.generation = inventory.generation + 1;
+    inventory = fresh;
+    scanned = 1;
+    return 1;
+}
+
+static void uevent_open(void)
+{
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) return;
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;                 /* the kernel's own broadcast */
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return;
+    }
+    uevent_fd = fd;
+}
+
+/* Drain the socket. Returns 1 if any event was for a block device. */
+static int uevent_drain(void)
+{
+    char buf[4096];
+    int block = 0;
+    ssize_t n;
+    while ((n = recv(uevent_fd, buf, sizeof(buf) - 1, 0)) > 0) {
+        buf[n] = '\0';
+        /* "add@/devices/...\0ACTION=add\0SUBSYSTEM=block\0..." */
+        for (ssize_t at = 0; at < n; at += (ssize_t)strlen(buf + at) + 1)
+            if (strcmp(buf + at, "SUBSYSTEM=block") == 0) block = 1;
+    }
+    return block;
+}
+
+const vault_devices_t *vault_devices_get(void)
+{
+    if (!scanned) {
+        /* Listen before scanning, so nothing falls in between */
+        if (uevent_fd < 0) uevent_open();
+        if (scan() < 0) return NULL;
+    }
+    return &inventory;
+}
+
+int vault_devices_refresh(void)
+{
+    if (!scanned) return vault_devices_get() ? 1 : 0;
+
+    if (uevent_fd >= 0) {
+        if (!uevent_drain()) return 0;
+    } else if (time(NULL) == last_scan) {
+        return 0;
+    }
+    return scan() == 1;
+}
+
+int vault_devices_fd(void)
+{
+    vault_devices_get();
+    return uevent_fd;
+}
+
+#else /* !VAULT_PLATFORM_LINUX */
+
+const vault_devices_t *vault_devices_get(void)
+{
+    return NULL;
+}
+
+int vault_devices_refresh(void)
+{
+    return 0;
+}
+
+int vault_devices_fd(void)
+{
+    return -1;
+}
+
+#endif
+
+const vault_device_t *vault_devices_find(const char *device)
+{
+    const vault_devices_t *inv = vault_devices_get();
+    if (!inv || !device) return NULL;
+    if (strncmp(device, "/dev/", 5) == 0) device += 5;
+    for (int i = 0; i < inv->count; i++)
+        if (strcmp(inv->devices[i].name, device) == 0)
+            return &inv->devices[i];
+    return NULL;
+}
+
+void vault_devices_label(const vault_device_t *d, char *buf, size_t len)
+{
+    double gb = (double)d->size_bytes / (1024.0 * 1024.0 * 1024.0);
+    snprintf(buf, len, "%-14s %8.1f GB  %s  %s%s",
+             d->path, gb,
+             d->rotational == 0 ? "SSD" : d->rotational == 1 ? "HDD" : "   ",
+             d->model, d->removable ? (d->model[0] ? ", removable"
+                                                   : "removable") : "");
+}
@@ -0,0 +1,67 @@
+/*
+ * devices.h -- Block Device Inventory
+ *
+ * One list of the machine's disks for every screen that offers them:
+ * scanned from /sys/block once, with size, rotational and removable
+ * flags, model, serial and partitions, then kept current from the
+ * kernel's uevents rather than rescanned. A disk plugged in while a
+ * menu is up shows up in it.
+ *
+ * Linux only; elsewhere the inventory is empty.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_DEVICES_H
+#define VAULT_DEVICES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VAULT_DEVICES_MAX       64
+#define VAULT_DEVICES_MAX_PARTS 32
+
+typedef struct {
+    char     name[32];          /* sda1, nvme0n1p2 */
+    uint64_t size_bytes;
+} vault_device_part_t;
+
+typedef struct {
+    char     name[32];          /* sda, nvme0n1 */
+    char     path[48];          /* /dev/sda */
+    uint64_t size_bytes;
+    int      rotational;        /* 1 HDD, 0 SSD, -1 unknown */
+    int      removable;
+    char     model[64];         /* "" where sysfs has none */
+    char     serial[64];
+    vault_device_part_t parts[VAULT_DEVICES_MAX_PARTS];
+    int      part_count;
+} vault_device_t;
+
+typedef struct {
+    vault_device_t devices[VAULT_DEVICES_MAX];   /* sorted by name */
+    int      count;
+    unsigned generation;        /* bumped whenever the list changes */
+} vault_devices_t;
+
+/* The inventory, scanned on first use. Loop and RAM disks and disks
+ * without media are left out. Returns NULL if /sys/block cannot be
+ * read. */
+const vault_devices_t *vault_devices_get(void);
+
+/* Apply the uevents that have arrived since the last call, without
+ * waiting. Returns 1 if the list changed, else 0. */
+int vault_devices_refresh(void);
+
+/* Descriptor that becomes readable when uevents arrive, to poll()
+ * alongside the keyboard; -1 if there is none, in which case
+ * vault_devices_refresh() rescans, at most once a second. */
+int vault_devices_fd(void);
+
+/* "/dev/sda  465.8 GB  SSD  Samsung SSD 860, removable" for menus. */
+void vault_devices_label(const vault_device_t *d, char *buf, size_t len);
+
+/* The inventory entry for a /dev path or disk name, or NULL. */
+const vault_device_t *vault_devices_find(const char *device);
+
+#endif /* VAULT_DEVICES_H */
@@ -0,0 +1,231 @@
+/*
+ * events.c -- Event Log
+ *
+ * The ring is a bounded queue of sequenced slots. A free slot's
+ * sequence equals the position that may claim it; a recorder claims
+ * the position with a compare-and-swap on the head, formats its line
+ * into the slot and publishes it by setting the sequence one past the
+ * position. The writer, on the services thread, takes published slots
+ * in position order and hands each back a lap later. Recorders never
+ * wait: a slot still unwritten a lap on means the ring is full.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* clock_gettime, fileno */
+#endif
+
+#include "events.h"
+#include "services.h"
+#include "platform.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(VAULT_PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+  /* MSVC volatile accesses are acquire loads and release stores */
+  #define EV_LOAD(p)        (*(volatile long *)(p))
+  #define EV_STORE(p, v)    (*(volatile long *)(p) = (v))
+#else
+  #define EV_LOAD(p)        __atomic_load_n((p), __ATOMIC_ACQUIRE)
+  #define EV_STORE(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+#define EVENTS_MASK            (VAULT_EVENTS_RING - 1)
+#define EVENTS_FLUSH_INTERVAL  0.5      /* seconds between writes */
+
+typedef struct {
+    long seq;
+    char line[VAULT_EVENTS_LINE];
+} event_slot_t;
+
+static struct {
+    event_slot_t  slots[VAULT_EVENTS_RING];
+    long          head;         /* next position to claim */
+    long          dropped;      /* events the full ring turned away */
+    long          open;
+
+    /* Writer side, under flush_lock */
+    vault_mutex_t flush_lock;
+    long          tail;         /* next position to write out */
+    long          reported;     /* drops already logged */
+    FILE         *out;
+    double        t0;
+} ev;
+
+static int ev_claim(long *p, long pos)
+{
+#if defined(_MSC_VER)
+    return InterlockedCompareExchange((volatile LONG *)p, pos + 1, pos) == pos;
+#else
+    return __atomic_compare_exchange_n(p, &pos, pos + 1, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+}
+
+static void ev_count(long *p)
+{
+#if defined(_MSC_VER)
+    InterlockedIncrement((volatile LONG *)p);
+#else
+    __atomic_add_fetch(p, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+static double ev_now(void)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    return (double)GetTickCount64() / 1e3;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+int vault_events_enabled(void)
+{
+    return EV_LOAD(&ev.open) != 0;
+}
+
+const char *vault_events_quote(char *buf, size_t size, const char *s)
+{
+    size_t n = 0;
+    if (size < 3) {
+        if (size) buf[0] = '\0';
+        return buf;
+    }
+    buf[n++] = '"';
+    for (const unsigned char *p = (const unsigned char *)(s ? s : "");
+         *p; p++) {
+        char esc[8];
+        int len;
+        if (*p == '"' || *p == '\\')
+            len = snprintf(esc, sizeof(esc), "\\%c", *p);
+        else if (*p < 0x20)
+            len = snprintf(esc, sizeof(esc), "\\u%04x", *p);
+        else
+            len = snprintf(esc, sizeof(esc), "%c", *p);
+        if (n + (size_t)len + 2 > size) break;
+        memcpy(buf + n, esc, (size_t)len);
+        n += (size_t)len;
+    }
+    buf[n++] = '"';
+    buf[n] = '\0';
+    return buf;
+}
+
+void vault_event(const char *event, const char *fields, ...)
+{
+    if (!EV_LOAD(&ev.open)) return;
+
+    long pos = EV_LOAD(&ev.head);
+    event_slot_t *s;
+    for (;;) {
+        s = &ev.slots[pos & EVENTS_MASK];
+        long seq = EV_LOAD(&s->seq);
+        if (seq == pos) {
+            if (ev_claim(&ev.head, pos)) break;
+        } else if (seq < pos) {
+            /* Still holds last lap's line */
+            ev_count(&ev.dropped);
+            return;
+        }
+        pos = EV_LOAD(&ev.head);
+    }
+
+    /* Room is kept for the closing brace and newline */
+    size_t room = sizeof(s->line) - 2;
+    int n = snprintf(s->line, room, "{\"t\":%.3f,\"event\":\"%s\"",
+                     ev_now() - ev.t0, event);
+    if (n < 0 || (size_t)n >= room) n = 0;
+    size_t head_len = (size_t)n;
+    if (n > 0 && fields) {
+        va_list ap;
+        va_start(ap, fields);
+        int m = vsnprintf(s->line + n, room - (size_t)n, fields, ap);
+        va_end(ap);
+        if (m < 0 || (size_t)m >= room - (size_t)n)
+            n = (int)head_len + snprintf(s->line + head_len,
+                                         room - head_len,
+                                         ",\"truncated\":true");
+        else
+            n += m;
+    }
+    if (n > 0) memcpy(s->line + n, "}\n", 3);
+    else s->line[0] = '\0';
+
+    EV_STORE(&s->seq, pos + 1);
+}
+
+/* Write out every published line in order, then a count of any events
+ * dropped since the last write. */
+static void events_drain(void *arg)
+{
+    (void)arg;
+    vault_mutex_lock(&ev.flush_lock);
+    for (;;) {
+        event_slot_t *s = &ev.slots[ev.tail & EVENTS_MASK];
+        if (EV_LOAD(&s->seq) != ev.tail + 1) break;
+        fputs(s->line, ev.out);
+        EV_STORE(&s->seq, ev.tail + VAULT_EVENTS_RING);
+        ev.tail++;
+    }
+    long dropped = EV_LOAD(&ev.dropped);
+    if (dropped != ev.reported) {
+        fprintf(ev.out, "{\"t\":%.3f,\"event\":\"dropped\",\"count\":%ld}\n",
+                ev_now() - ev.t0, dropped - ev.reported);
+        ev.reported = dropped;
+    }
+    fflush(ev.out);
+    vault_mutex_unlock(&ev.flush_lock);
+}
+
+void vault_events_flush(void)
+{
+    if (!EV_LOAD(&ev.open)) return;
+    events_drain(NULL);
+    /* A serial console has nothing to sync */
+#if defined(VAULT_PLATFORM_WINDOWS)
+    _commit(_fileno(ev.out));
+#else
+    fsync(fileno(ev.out));
+#endif
+}
+
+int vault_events_open(const char *path)
+{
+    if (!path || !path[0] || EV_LOAD(&ev.open)) return 0;
+
+    ev.out = fopen(path, "a");
+    if (!ev.out) {
+        fprintf(stderr, "vault: cannot open event log %s\n", path);
+        return -1;
+    }
+    for (long i = 0; i < VAULT_EVENTS_RING; i++)
+        ev.slots[i].seq = i;
+    vault_mutex_init(&ev.flush_lock);
+    ev.t0 = ev_now();
+    EV_STORE(&ev.open, 1);
+
+    /* Usually the first job, ahead of the wipe's; a slow log device
+     * delays those, never the watchdog, which has its own thread */
+    if (vault_services_start() == 0)
+        vault_services_add(events_drain, NULL, EVENTS_FLUSH_INTERVAL);
+    atexit(vault_events_flush);
+
+    vault_event("open", ",\"time\":%lld", (long long)time(NULL));
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * events.h -- Event Log
+ *
+ * An append-only record of what the vault did, one JSON object per
+ * line: authentication attempts, the dead man's switch, each wipe
+ * pass with its throughput, verification results and errors. Every
+ * line carries "t", seconds since the log was opened, and "event".
+ *
+ * Events go into a fixed ring allocated up front; the services thread
+ * (services.h) writes them out. Recording one formats a line and
+ * claims a slot without locks or I/O, so the wipe and auth paths
+ * never wait on the log. When the ring is full the event is dropped
+ * and counted, and the count is logged once there is room.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_EVENTS_H
+#define VAULT_EVENTS_H
+
+#include <stddef.h>
+
+#define VAULT_EVENTS_RING      256      /* slots, a power of two */
+#define VAULT_EVENTS_LINE      240      /* bytes per event line */
+
+/* Start appending events to path: a file, or a serial console such as
+ * /dev/ttyS0. Starts the services thread; without it, events wait in
+ * the ring until vault_events_flush(). "" or NULL leaves the log off.
+ * Returns 0, or -1 if path cannot be opened. */
+int vault_events_open(const char *path);
+
+/* 1 once vault_events_open() has succeeded. */
+int vault_events_enabled(void);
+
+/* Record an event. fields is a printf format for the rest of the
+ * object after "event", starting with a comma, e.g. ",\"pass\":%d";
+ * strings from outside go through vault_events_quote() first. A line
+ * longer than VAULT_EVENTS_LINE keeps only "t" and "event" and gets
+ * "truncated":true. Does nothing while the log is off. */
+void vault_event(const char *event, const char *fields, ...);
+
+/* s as a JSON string, quotes included, in buf; cut to fit. Returns
+ * buf. */
+const char *vault_events_quote(char *buf, size_t size, const char *s);
+
+/* Write out everything recorded so far and sync it, for the moments
+ * before a power-off. Also run at exit. */
+void vault_events_flush(void);
+
+#endif /* VAULT_EVENTS_H */
@@ -0,0 +1,585 @@
+/*
+ * initramfs.c -- Initramfs Append
+ *
+ * The segment is a "newc" cpio archive built in memory once and written
+ * to the end of each image, 4-byte aligned as the kernel's unpacker
+ * requires between archives. Only images whose first archive is plain
+ * cpio (early microcode), gzip, xz or zstd are appended to; those are
+ * the formats whose decompressors report where they stopped, so the
+ * kernel finds the segment behind them.
+ *
+ * Every host path is opened with RESOLVE_IN_ROOT, so absolute symlinks
+ * on the target (/lib64/ld-linux-x86-64.so.2 and the like) point into
+ * the target rather than into the USB system running the installer.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* syscall, fdopendir */
+#endif
+
+#include "initramfs.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <stdint.h>
+
+#if defined(VAULT_PLATFORM_LINUX)
+  #include <dirent.h>
+  #include <elf.h>
+  #include <fcntl.h>
+  #include <link.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/syscall.h>
+  #include <linux/openat2.h>
+#endif
+
+#define SEGMENT_MAX     (64u << 20) /* binary and libraries, uncompressed */
+#define MAX_FILES       64
+#define MAX_DIRS        32
+#define MAX_IMAGES      16
+
+#if defined(VAULT_PLATFORM_LINUX)
+
+typedef struct {
+    uint8_t *buf;
+    size_t   len, cap;
+    unsigned ino;
+    int      failed;
+} segment_t;
+
+typedef struct {
+    char   path[256];           /* on the target, and in the image */
+    mode_t mode;
+} entry_t;
+
+typedef struct {
+    int     rootfd;
+    entry_t files[MAX_FILES];
+    int     nfiles;
+    char    dirs[MAX_DIRS][128];
+    int     ndirs;
+    char    libdirs[16][128];
+    int     nlibdirs;
+    char   *err;
+    size_t  err_len;
+} build_t;
+
+static void set_err(build_t *b, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(b->err, b->err_len, fmt, ap);
+    va_end(ap);
+}
+
+/* Open path as it resolves inside the target. Kernels before 5.6 lack
+ * openat2; there only a relative walk from the root is possible. */
+static int open_in_root(int rootfd, const char *path, int flags)
+{
+    struct open_how how;
+    memset(&how, 0, sizeof(how));
+    how.flags = (uint64_t)(flags | O_CLOEXEC);
+    how.resolve = RESOLVE_IN_ROOT;
+    int fd = (int)syscall(SYS_openat2, rootfd, path, &how, sizeof(how));
+    if (fd < 0 && errno == ENOSYS)
+        fd = openat(rootfd, path[0] == '/' ? path + 1 : path,
+                    flags | O_CLOEXEC);
+    return fd;
+}
+
+/* ------------------------------------------------------------------ */
+/*  cpio "newc"                                                        */
+/* ------------------------------------------------------------------ */
+
+static void seg_put(segment_t *s, const void *data, size_t len)
+{
+    if (s->failed) return;
+    if (s->len + len > s->cap) {
+        size_t cap = s->cap ? s->cap : 1u << 20;
+        while (cap < s->len + len) cap *= 2;
+        uint8_t *nb = cap <= SEGMENT_MAX ? realloc(s->buf, cap) : NULL;
+        if (!nb) {
+            s->failed = 1;
+            return;
+        }
+        s->buf = nb;
+        s->cap = cap;
+    }
+    memcpy(s->buf + s->len, data, len);
+    s->len += len;
+}
+
+static void seg_pad(segment_t *s)
+{
+    static const uint8_t zero[4];
+    seg_put(s, zero, (4 - (s->len & 3)) & 3);
+}
+
+/* A header and name; the caller adds size bytes of data */
+static void cpio_header(segment_t *s, const char *name, mode_t mode,
+                        size_t size)
+{
+    /* Archive names are relative: "usr/sbin/shredos-vault" */
+    while (*name == '/') name++;
+    char hdr[111];
+    snprintf(hdr, sizeof(hdr),
+             "070701%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X%08X",
+             ++s->ino, (unsigned)mode, 0u, 0u, S_ISDIR(mode) ? 2u : 1u,
+             0u, (unsigned)size, 0u, 0u, 0u, 0u,
+             (unsigned)strlen(name) + 1, 0u);
+    seg_put(s, hdr, 110);
+    seg_put(s, name, strlen(name) + 1);
+    seg_pad(s);
+}
+
+/* Target file src into the archive as name */
+static int cpio_file(build_t *b, segment_t *s, const char *src,
+                     const char *name, mode_t mode)
+{
+    int fd = open_in_root(b->rootfd, src, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        set_err(b, "Cannot read %s: %s", src,
+                fd < 0 ? strerror(errno) : "not a file");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    cpio_header(s, name, S_IFREG | mode, (size_t)st.st_size);
+    size_t left = (size_t)st.st_size;
+    uint8_t buf[65536];
+    while (left > 0 && !s->failed) {
+        ssize_t n = read(fd, buf, left < sizeof(buf) ? left : sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            set_err(b, "Cannot read %s: %s", src,
+                    n < 0 ? strerror(errno) : "file shrank");
+            close(fd);
+            return -1;
+        }
+        seg_put(s, buf, (size_t)n);
+        left -= (size_t)n;
+    }
+    close(fd);
+    seg_pad(s);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  What goes in                                                       */
+/* ------------------------------------------------------------------ */
+
+static void add_dirs(build_t *b, const char *path)
+{
+    char dir[128];
+    for (const char *p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+        size_t n = (size_t)(p - path);
+        if (n >= sizeof(dir)) return;
+        memcpy(dir, path, n);
+        dir[n] = '\0';
+        int seen = 0;
+        for (int i = 0; i < b->ndirs && !seen; i++)
+            seen = strcmp(b->dirs[i], dir) == 0;
+        if (!seen && b->ndirs < MAX_DIRS)
+            snprintf(b->dirs[b->ndirs++], sizeof(b->dirs[0]), "%s", dir);
+    }
+}
+
+static int add_file(build_t *b, const char *path, mode_t mode)
+{
+    for (int i = 0; i < b->nfiles; i++)
+        if (strcmp(b->files[i].path, path) == 0) return 0;
+    if (b->nfiles == MAX_FILES) {
+        set_err(b, "More than %d files to add", MAX_FILES);
+        return -1;
+    }
+    entry_t *e = &b->files[b->nfiles++];
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->mode = mode;
+    add_dirs(b, path);
+    return 0;
+}
+
+/* The target's library path: ld.so.conf.d first, as ld.so.cache has it,
+ * then the usual places */
+static void load_libdirs(build_t *b)
+{
+    int dfd = open_in_root(b->rootfd, "/etc/ld.so.conf.d",
+                           O_RDONLY | O_DIRECTORY);
+    DIR *dir = dfd >= 0 ? fdopendir(dfd) : NULL;
+    struct dirent *ent;
+    while (dir && (ent = readdir(dir))) {
+        size_t n = strlen(ent->d_name);
+        if (n < 5 || strcmp(ent->d_name + n - 5, ".conf") != 0) continue;
+        char path[300];
+        snprintf(path, sizeof(path), "/etc/ld.so.conf.d/%s", ent->d_name);
+        int fd = open_in_root(b->rootfd, path, O_RDONLY);
+        FILE *fp = fd >= 0 ? fdopen(fd, "r") : NULL;
+        if (!fp) {
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        char line[sizeof(b->libdirs[0])];
+        while (fgets(line, sizeof(line), fp) && b->nlibdirs < 12) {
+            line[strcspn(line, " \t#\r\n")] = '\0';
+            if (line[0] == '/')
+                snprintf(b->libdirs[b->nlibdirs++], sizeof(b->libdirs[0]),
+                         "%s", line);
+        }
+        fclose(fp);
+    }
+    if (dir) closedir(dir);
+    else if (dfd >= 0) close(dfd);
+
+    static const char *const std[] = { "/lib64", "/usr/lib64", "/lib",
+                                       "/usr/lib" };
+    for (size_t i = 0; i < sizeof(std) / sizeof(std[0]); i++)
+        snprintf(b->libdirs[b->nlibdirs++], sizeof(b->libdirs[0]),
+                 "%s", std[i]);
+}
+
+static int find_lib(build_t *b, const char *name, char *out, size_t len)
+{
+    for (int i = 0; i < b->nlibdirs; i++) {
+        snprintf(out, len, "%s/%s", b->libdirs[i], name);
+        int fd = open_in_root(b->rootfd, out, O_RDONLY);
+        if (fd >= 0) {
+            close(fd);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* File offset of a virtual address, through the PT_LOAD headers */
+static long vaddr_offset(const ElfW(Phdr) *ph, int phnum, ElfW(Addr) va)
+{
+    for (int i = 0; i < phnum; i++)
+        if (ph[i].p_type == PT_LOAD && va >= ph[i].p_vaddr &&
+            va < ph[i].p_vaddr + ph[i].p_filesz)
+            return (long)(va - ph[i].p_vaddr + ph[i].p_offset);
+    return -1;
+}
+
+/* Add the interpreter and DT_NEEDED libraries of ELF file path */
+static int add_deps(build_t *b, const char *path)
+{
+    int fd = open_in_root(b->rootfd, path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 ||
+        (size_t)st.st_size < sizeof(ElfW(Ehdr))) {
+        if (fd >= 0) close(fd);
+        set_err(b, "Cannot read %s", path);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    const uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        set_err(b, "Cannot map %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    int ret = 0;
+    const ElfW(Ehdr) *eh = (const ElfW(Ehdr) *)map;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 ||
+        eh->e_ident[EI_CLASS] != (sizeof(void *) == 8 ? ELFCLASS64
+                                                      : ELFCLASS32) ||
+        eh->e_phoff + (size_t)eh->e_phnum * sizeof(ElfW(Phdr)) > size) {
+        set_err(b, "%s is not an ELF file for this machine", path);
+        munmap((void *)map, size);
+        return -1;
+    }
+    const ElfW(Phdr) *ph = (const ElfW(Phdr) *)(map + eh->e_phoff);
+
+    const ElfW(Dyn) *dyn = NULL;
+    size_t ndyn = 0;
+    for (int i = 0; i < eh->e_phnum && ret == 0; i++) {
+        if (ph[i].p_offset + ph[i].p_filesz > size) continue;
+        if (ph[i].p_type == PT_INTERP) {
+            char interp[256];
+            snprintf(interp, sizeof(interp), "%.*s", (int)ph[i].p_filesz,
+                     (const char *)map + ph[i].p_offset);
+            ret = add_file(b, interp, 0755);
+        } else if (ph[i].p_type == PT_DYNAMIC) {
+            dyn = (const ElfW(Dyn) *)(map + ph[i].p_offset);
+            ndyn = ph[i].p_filesz / sizeof(ElfW(Dyn));
+        }
+    }
+
+    long strtab = -1;
+    for (size_t i = 0; i < ndyn && dyn[i].d_tag != DT_NULL; i++)
+        if (dyn[i].d_tag == DT_STRTAB)
+            strtab = vaddr_offset(ph, eh->e_phnum, dyn[i].d_un.d_ptr);
+
+    for (size_t i = 0; i < ndyn && dyn[i].d_tag != DT_NULL && ret == 0;
+         i++) {
+        if (dyn[i].d_tag != DT_NEEDED || strtab < 0) continue;
+        size_t at = (size_t)strtab + dyn[i].d_un.d_val;
+        if (at >= size || !memchr(map + at, '\0', size - at)) continue;
+        const char *name = (const char *)map + at;
+
+        char lib[256];
+        if (find_lib(b, name, lib, sizeof(lib)) != 0) {
+            set_err(b, "%s needs %s, which the target does not have",
+                    path, name);
+            ret = -1;
+        } else {
+            ret = add_file(b, lib, 0755);
+        }
+    }
+    munmap((void *)map, size);
+    return ret;
+}
+
+/* The file list for kind, with every library the binary pulls in */
+static int collect(build_t *b, vault_initramfs_kind_t kind)
+{
+    if (add_file(b, "/usr/sbin/shredos-vault", 0755) != 0 ||
+        add_file(b, "/etc/shredos-vault/vault.conf", 0600) != 0)
+        return -1;
+    int fd = open_in_root(b->rootfd,
+                          "/etc/shredos-vault/vault.conf.bin", O_RDONLY);
+    if (fd >= 0) {
+        close(fd);
+        if (add_file(b, "/etc/shredos-vault/vault.conf.bin", 0600) != 0)
+            return -1;
+    }
+
+    if (kind == VAULT_INITRAMFS_TOOLS) {
+        if (add_file(b, "/scripts/local-top/shredos-vault", 0755) != 0)
+            return -1;
+    } else if (add_file(b, "/lib/dracut/hooks/pre-mount/"
+                           "10-vault-gate-hook.sh", 0755) != 0) {
+        return -1;
+    }
+
+    /* Breadth first: libraries added while walking are walked too */
+    for (int i = 0; i < b->nfiles; i++) {
+        const char *p = b->files[i].path;
+        if (strncmp(p, "/etc/", 5) == 0 || strncmp(p, "/scripts/", 9) == 0 ||
+            strncmp(p, "/lib/dracut/", 12) == 0)
+            continue;
+        if (add_deps(b, p) != 0) return -1;
+    }
+    return 0;
+}
+
+/* Where each entry comes from on the target, if not the same path */
+static const char *source_path(vault_initramfs_kind_t kind, const char *path)
+{
+    if (strcmp(path, "/scripts/local-top/shredos-vault") == 0)
+        return "/etc/initramfs-tools/scripts/local-top/shredos-vault";
+    if (kind == VAULT_INITRAMFS_DRACUT &&
+        strncmp(path, "/lib/dracut/hooks/", 18) == 0)
+        return "/usr/lib/dracut/modules.d/90shredos-vault/"
+               "vault-gate-hook.sh";
+    return path;
+}
+
+static int build_segment(build_t *b, vault_initramfs_kind_t kind,
+                         segment_t *s)
+{
+    for (int i = 0; i < b->ndirs; i++)
+        cpio_header(s, b->dirs[i], S_IFDIR | 0755, 0);
+    for (int i = 0; i < b->nfiles; i++) {
+        const entry_t *e = &b->files[i];
+        if (cpio_file(b, s, source_path(kind, e->path), e->path,
+                      e->mode) != 0)
+            return -1;
+    }
+    cpio_header(s, "TRAILER!!!", 0, 0);
+    if (s->failed) {
+        set_err(b, "The vault and its libraries exceed %u MB",
+                SEGMENT_MAX >> 20);
+        return -1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Images                                                             */
+/* ------------------------------------------------------------------ */
+
+static int is_image(vault_initramfs_kind_t kind, const char *name)
+{
+    size_t n = strlen(name);
+    if (kind == VAULT_INITRAMFS_TOOLS)
+        return strncmp(name, "initrd.img-", 11) == 0 &&
+               (n < 8 || strcmp(name + n - 8, ".old-dkms") != 0);
+    return strncmp(name, "initramfs-", 10) == 0 && n > 4 &&
+           strcmp(name + n - 4, ".img") == 0 && !strstr(name, "kdump");
+}
+
+/* Whether the kernel can find an archive appended to this image */
+static const char *appendable(const uint8_t *m, size_t n)
+{
+    if (n >= 6 && memcmp(m, "07070", 5) == 0) return "cpio";
+    if (n >= 2 && m[0] == 0x1f && m[1] == 0x8b) return "gzip";
+    if (n >= 6 && memcmp(m, "\xfd" "7zXZ\0", 6) == 0) return "xz";
+    if (n >= 4 && memcmp(m, "\x28\xb5\x2f\xfd", 4) == 0) return "zstd";
+    return NULL;
+}
+
+static int pwrite_all(int fd, const void *data, size_t len, off_t at)
+{
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, at);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+        at += n;
+    }
+    return 0;
+}
+
+/* Names of the images in /boot, all checked. Returns the count, or -1
+ * with the reason one cannot take the segment. */
+static int find_images(build_t *b, int bootfd, vault_initramfs_kind_t kind,
+                       time_t hook_since, char names[][128])
+{
+    int dfd = dup(bootfd);
+    DIR *dir = dfd >= 0 ? fdopendir(dfd) : NULL;
+    if (!dir) {
+        if (dfd >= 0) close(dfd);
+        set_err(b, "Cannot read /boot: %s", strerror(errno));
+        return -1;
+    }
+
+    int count = 0, ret = 0;
+    struct dirent *ent;
+    while (ret == 0 && (ent = readdir(dir))) {
+        if (!is_image(kind, ent->d_name) ||
+            strlen(ent->d_name) >= sizeof(names[0]))
+            continue;
+        struct stat st;
+        if (fstatat(bootfd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 ||
+            !S_ISREG(st.st_mode))
+            continue;
+        if (count == MAX_IMAGES) {
+            set_err(b, "More than %d initramfs images in /boot", MAX_IMAGES);
+            ret = -1;
+            break;
+        }
+
+        uint8_t magic[6] = {0};
+        int fd = openat(bootfd, ent->d_name, O_RDONLY | O_CLOEXEC);
+        ssize_t n = fd >= 0 ? pread(fd, magic, sizeof(magic), 0) : -1;
+        if (fd >= 0) close(fd);
+        if (n < 0 || !appendable(magic, (size_t)n)) {
+            set_err(b, "/boot/%s is not a format that can be appended to",
+                    ent->d_name);
+            ret = -1;
+        } else if (kind == VAULT_INITRAMFS_TOOLS &&
+                   (hook_since == 0 || st.st_mtime < hook_since)) {
+            set_err(b, "/boot/%s was built without the vault's boot script",
+                    ent->d_name);
+            ret = -1;
+        } else {
+            memcpy(names[count++], ent->d_name, strlen(ent->d_name) + 1);
+        }
+    }
+    closedir(dir);
+    if (ret == 0 && count == 0) {
+        set_err(b, "No initramfs images in /boot");
+        ret = -1;
+    }
+    return ret < 0 ? -1 : count;
+}
+
+/* Append s to image name, or leave it as it was */
+static int append_image(build_t *b, int bootfd, const char *name,
+                        const segment_t *s)
+{
+    static const uint8_t zero[4];
+    int fd = openat(bootfd, name, O_WRONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        set_err(b, "Cannot open /boot/%s: %s", name, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    off_t size = st.st_size;
+    size_t pad = (size_t)((4 - (size & 3)) & 3);
+    if (pwrite_all(fd, zero, pad, size) != 0 ||
+        pwrite_all(fd, s->buf, s->len, size + (off_t)pad) != 0 ||
+        fsync(fd) != 0) {
+        set_err(b, "Cannot write /boot/%s: %s", name, strerror(errno));
+        if (ftruncate(fd, size) == 0) fsync(fd);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+int vault_initramfs_append(const char *root, vault_initramfs_kind_t kind,
+                           time_t hook_since, char *err, size_t err_len)
+{
+    build_t *b = calloc(1, sizeof(*b));
+    if (!b) {
+        snprintf(err, err_len, "Out of memory");
+        return -1;
+    }
+    b->err = err;
+    b->err_len = err_len;
+    err[0] = '\0';
+
+    segment_t seg;
+    memset(&seg, 0, sizeof(seg));
+    char names[MAX_IMAGES][128];
+    int ret = 1, count = 0, bootfd = -1;
+
+    b->rootfd = open(root, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (b->rootfd < 0) {
+        set_err(b, "Cannot open %s: %s", root, strerror(errno));
+        goto out;
+    }
+    bootfd = open_in_root(b->rootfd, "/boot", O_RDONLY | O_DIRECTORY);
+    if (bootfd < 0) {
+        set_err(b, "Cannot open /boot: %s", strerror(errno));
+        goto out;
+    }
+
+    /* Everything that could need a rebuild is found out before any
+     * image is written to */
+    count = find_images(b, bootfd, kind, hook_since, names);
+    if (count < 0) goto out;
+    load_libdirs(b);
+    if (collect(b, kind) != 0 || build_segment(b, kind, &seg) != 0)
+        goto out;
+
+    ret = 0;
+    for (int i = 0; i < count && ret == 0; i++)
+        ret = append_image(b, bootfd, names[i], &seg);
+
+out:
+    if (bootfd >= 0) close(bootfd);
+    if (b->rootfd >= 0) close(b->rootfd);
+    free(seg.buf);
+    free(b);
+    return ret;
+}
+
+#else /* !VAULT_PLATFORM_LINUX */
+
+int vault_initramfs_append(const char *root, vault_initramfs_kind_t kind,
+                           time_t hook_since, char *err, size_t err_len)
+{
+    (void)root; (void)kind; (void)hook_since;
+    snprintf(err, err_len, "Not supported on this platform");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * initramfs.h -- Initramfs Append
+ *
+ * Puts the vault into a host's existing initramfs images without
+ * rebuilding them: the binary, the libraries it needs, its config and
+ * boot hook go into one cpio archive appended to each image. The kernel
+ * unpacks concatenated archives in order, later files replacing
+ * earlier ones, so the image boots as before plus the vault.
+ *
+ * Linux only.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_INITRAMFS_H
+#define VAULT_INITRAMFS_H
+
+#include <stddef.h>
+#include <time.h>
+
+typedef enum {
+    VAULT_INITRAMFS_TOOLS,      /* Debian/Ubuntu initramfs-tools */
+    VAULT_INITRAMFS_DRACUT,
+} vault_initramfs_kind_t;
+
+/* Append the vault already installed under root (binary, vault.conf,
+ * its snapshot and the boot hook) to every initramfs image in
+ * root/boot.
+ *
+ * initramfs-tools runs local-top scripts from a list fixed when the
+ * image was built, so an appended script only runs in an image built
+ * with it: hook_since is the mtime the installed local-top script had
+ * before this install (0 if there was none), and older images need a
+ * rebuild. dracut finds hooks by name at boot and needs no such check.
+ *
+ * Returns 0 once every image carries the vault; 1 if a full rebuild is
+ * needed instead, before any image is touched; -1 if an append failed,
+ * with that image cut back to its old size. err says why. */
+int vault_initramfs_append(const char *root, vault_initramfs_kind_t kind,
+                           time_t hook_since, char *err, size_t err_len);
+
+#endif /* VAULT_INITRAMFS_H */
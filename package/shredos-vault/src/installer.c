@@ -7,14 +7,24 @@
  *   3. Copies vault binary and config onto the host drive
  *   4. Hooks into the host boot process (initramfs, LaunchDaemon, etc.)
  *
+ * or, with --install-batch, does the same unattended for every target
+ * a manifest lists.
+ *
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* pread, mkdtemp, sync, copy_file_range */
+#endif
+
 #include "installer.h"
 #include "platform.h"
 #include "config.h"
 #include "auth_password.h"
 #include "wipe.h"
+#include "devices.h"
+#include "initramfs.h"
+#include "wipe_stats.h"
 #include "tui.h"
 
 #include <stdio.h>
@@ -22,18 +32,27 @@
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <time.h>
 
 #if defined(VAULT_PLATFORM_LINUX)
   #include <unistd.h>
   #include <sys/stat.h>
   #include <sys/mount.h>
   #include <sys/wait.h>
-  #include <dirent.h>
+  #include <sys/ioctl.h>
   #include <fcntl.h>
+  #include <dirent.h>
+  #include <sys/sendfile.h>
+  #include <linux/fs.h>
 #endif
 
-#define INSTALLER_MNT       "/tmp/vault-probe"
+#define INSTALLER_MNT       "/tmp/vault-probe-XXXXXX"   /* one per probe */
+#define INSTALLER_SCAN_THREADS 8
+#define INSTALLER_MIN_ROOT  (1ULL << 30)    /* smallest OS root probed */
 #define INSTALLER_TARGET    "/tmp/vault-target"
+#define INSTALLER_BATCH_MNT "/tmp/vault-target-XXXXXX"   /* one per batch job */
+#define INSTALLER_BATCH_THREADS 4
+#define INSTALLER_GATE_BIN  "/usr/bin/shredos-vault-gate"
 
 /* ------------------------------------------------------------------ */
 /*  Helper: run a shell command with printf-style formatting           */
@@ -49,6 +68,202 @@ static int run_cmd(const char *fmt, ...)
     return system(cmd);
 }
 
+/* ------------------------------------------------------------------ */
+/*  Installer file operations                                          */
+/* ------------------------------------------------------------------ */
+
+/*
+ * What the install used to do with cp, chmod, mkdir -p and mount --bind,
+ * done with the system calls themselves: no shell per step, and a
+ * failure names the path and the errno instead of an exit status.
+ * Each returns 0, or -1 with the reason in job->error.
+ *
+ * A job is one install: where its target is mounted, and whether it
+ * talks to the TUI (the wizard) or runs unattended beside others
+ * (--install-batch), printing status to stderr and keeping its error
+ * for the report.
+ */
+
+typedef struct {
+    const char *mnt;            /* the target's mount point */
+    const char *device;         /* prefixes batch status lines */
+    int         batch;
+    char        path[512];      /* target_path() result */
+    char        error[640];     /* why the last step failed */
+} install_job_t;
+
+static int op_fail(install_job_t *job, const char *fmt, ...)
+{
+    int err = errno;
+    char what[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(what, sizeof(what), fmt, ap);
+    va_end(ap);
+    snprintf(job->error, sizeof(job->error), "%s: %s", what, strerror(err));
+    errno = err;
+    return -1;
+}
+
+static void job_status(install_job_t *job, const char *fmt, ...)
+{
+    char msg[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    if (job->batch)
+        fprintf(stderr, "%s: %s\n", job->device, msg);
+    else
+        vault_tui_status("%s", msg);
+}
+
+/* The wizard shows the error; a batch job keeps it for the report */
+static void job_error(install_job_t *job, const char *fmt, ...)
+{
+    char msg[sizeof(job->error)];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    if (job->batch)
+        memcpy(job->error, msg, sizeof(msg));
+    else
+        vault_tui_error("%s", msg);
+}
+
+/* rel under the target's mount point, valid until the next call */
+static const char *target_path(install_job_t *job, const char *rel)
+{
+    snprintf(job->path, sizeof(job->path), "%s%s", job->mnt, rel);
+    return job->path;
+}
+
+/* mkdir -p, with mode applied to the last component even if it existed */
+static int make_dirs(install_job_t *job, const char *path, mode_t mode)
+{
+    char buf[512];
+    if (snprintf(buf, sizeof(buf), "%s", path) >= (int)sizeof(buf)) {
+        errno = ENAMETOOLONG;
+        return op_fail(job, "Cannot create %s", path);
+    }
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST)
+            return op_fail(job, "Cannot create %s", buf);
+        *p = '/';
+    }
+    if (mkdir(buf, mode) != 0 && errno != EEXIST)
+        return op_fail(job, "Cannot create %s", buf);
+    if (chmod(buf, mode) != 0)
+        return op_fail(job, "Cannot set permissions on %s", buf);
+    return 0;
+}
+
+/* Copy src to dst with the given mode. The kernel moves the data:
+ * copy_file_range where both sides allow it, sendfile otherwise. */
+static int copy_file(install_job_t *job, const char *src, const char *dst,
+                     mode_t mode)
+{
+    int in = open(src, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return op_fail(job, "Cannot open %s", src);
+
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        op_fail(job, "Cannot stat %s", src);
+        close(in);
+        return -1;
+    }
+
+    int out = open(dst, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out < 0) {
+        op_fail(job, "Cannot create %s", dst);
+        close(in);
+        return -1;
+    }
+
+    int use_range = 1;
+    off_t left = st.st_size;
+    while (left > 0) {
+        ssize_t n = -1;
+        if (use_range) {
+            n = copy_file_range(in, NULL, out, NULL, (size_t)left, 0);
+            /* Cross-filesystem on older kernels, or no support at all */
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS ||
+                          errno == EINVAL || errno == EOPNOTSUPP)) {
+                use_range = 0;
+                continue;
+            }
+        } else {
+            n = sendfile(out, in, NULL, (size_t)left);
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (n == 0) errno = EIO;    /* source shrank under us */
+            op_fail(job, "Cannot copy %s to %s", src, dst);
+            close(in);
+            close(out);
+            return -1;
+        }
+        left -= n;
+    }
+    close(in);
+
+    /* fchmod, not the open mode: the umask must not weaken 0600 or 0755 */
+    if (fchmod(out, mode) != 0) {
+        op_fail(job, "Cannot set permissions on %s", dst);
+        close(out);
+        return -1;
+    }
+    if (close(out) != 0) return op_fail(job, "Cannot write %s", dst);
+    return 0;
+}
+
+/* Copy every regular file in src_dir into dst_dir, keeping its mode */
+static int copy_dir(install_job_t *job, const char *src_dir,
+                    const char *dst_dir)
+{
+    DIR *dir = opendir(src_dir);
+    if (!dir) return op_fail(job, "Cannot open %s", src_dir);
+
+    int ret = 0;
+    struct dirent *ent;
+    while (ret == 0 && (ent = readdir(dir))) {
+        char src[512], dst[512];
+        snprintf(src, sizeof(src), "%s/%s", src_dir, ent->d_name);
+        snprintf(dst, sizeof(dst), "%s/%s", dst_dir, ent->d_name);
+        struct stat st;
+        if (stat(src, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        ret = copy_file(job, src, dst, st.st_mode & 07777);
+    }
+    closedir(dir);
+    return ret;
+}
+
+static const char *const bind_dirs[] = { "/dev", "/proc", "/sys" };
+#define BIND_DIRS ((int)(sizeof(bind_dirs) / sizeof(bind_dirs[0])))
+
+static void unbind_target(install_job_t *job)
+{
+    for (int i = BIND_DIRS - 1; i >= 0; i--)
+        umount2(target_path(job, bind_dirs[i]), MNT_DETACH);
+}
+
+/* /dev, /proc and /sys into the target, for the chroot rebuild */
+static int bind_target(install_job_t *job)
+{
+    for (int i = 0; i < BIND_DIRS; i++) {
+        const char *dst = target_path(job, bind_dirs[i]);
+        if (mount(bind_dirs[i], dst, NULL, MS_BIND, NULL) != 0) {
+            op_fail(job, "Cannot bind %s to %s", bind_dirs[i], dst);
+            unbind_target(job);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 /* ------------------------------------------------------------------ */
 /*  Helper: check if a file exists under a mount point                 */
 /* ------------------------------------------------------------------ */
@@ -113,22 +328,13 @@ static int read_field(const char *filepath, const char *key,
 /*  Boot USB detection                                                 */
 /* ------------------------------------------------------------------ */
 
-static int is_boot_usb(const char *devname)
+static int is_boot_usb(const vault_device_t *dev)
 {
-    /* Check if device is removable */
-    char rpath[256];
-    snprintf(rpath, sizeof(rpath), "/sys/block/%s/removable", devname);
-    FILE *fp = fopen(rpath, "r");
-    if (!fp) return 0;
-    int removable = 0;
-    if (fscanf(fp, "%d", &removable) != 1) removable = 0;
-    fclose(fp);
-
-    if (!removable) return 0;
+    if (!dev->removable) return 0;
 
     /* Check if our root fs is on this device */
     char cmdline[4096] = {0};
-    fp = fopen("/proc/cmdline", "r");
+    FILE *fp = fopen("/proc/cmdline", "r");
     if (fp) {
         if (fgets(cmdline, sizeof(cmdline), fp))
             ;
@@ -136,57 +342,118 @@ static int is_boot_usb(const char *devname)
     }
 
     /* If boot device is on this disk, it's probably our USB */
-    char devpath[64];
-    snprintf(devpath, sizeof(devpath), "/dev/%s", devname);
-    if (strstr(cmdline, devpath)) return 1;
+    if (strstr(cmdline, dev->path)) return 1;
 
     /* Also check by finding where /mnt/shredos or root is mounted */
-    return removable; /* Assume removable = ShredOS USB as heuristic */
+    return 1; /* Assume removable = ShredOS USB as heuristic */
 }
 
 /* ------------------------------------------------------------------ */
 /*  OS Detection                                                       */
 /* ------------------------------------------------------------------ */
 
-detected_os_t vault_installer_detect_os(const char *partition,
-                                         drive_info_t *info)
-{
-    mkdir(INSTALLER_MNT, 0755);
+/* ------------------------------------------------------------------ */
+/*  Helper: filesystem type from the superblock                        */
+/* ------------------------------------------------------------------ */
 
-    /* Try mounting with various filesystem types */
-    const char *fstypes[] = {
-        "ext4", "ext3", "ext2", "xfs", "btrfs",
-        "ntfs3", "ntfs", "vfat", "hfsplus",
-        NULL
-    };
+/* ext* superblock: s_last_mounted, where the host last mounted it */
+#define EXT_SB_LAST_MOUNTED 0x88
 
-    int mounted = 0;
-    for (int i = 0; fstypes[i]; i++) {
-        if (mount(partition, INSTALLER_MNT, fstypes[i],
-                  MS_RDONLY | MS_NOEXEC | MS_NOSUID, NULL) == 0) {
-            mounted = 1;
-            break;
-        }
+/* Where data lives, never an OS root */
+static const char *const data_mounts[] = {
+    "/home", "/boot", "/var", "/srv", "/opt", "/tmp",
+    "/media", "/mnt", "/run/media", NULL
+};
+
+/* The kernel filesystem type of a partition that could hold an OS
+ * root, from its superblock, or NULL for anything else: swap, LUKS,
+ * FAT (EFI system partitions), partitions too small for an OS, and
+ * ext* filesystems last mounted at a data mount point. */
+static const char *probe_root_fs(const char *partition)
+{
+    int fd = open(partition, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    uint64_t size = 0;
+    uint8_t sb[4096];
+    const char *type = NULL;
+    if (ioctl(fd, BLKGETSIZE64, &size) != 0 || size < INSTALLER_MIN_ROOT ||
+        pread(fd, sb, sizeof(sb), 0) != (ssize_t)sizeof(sb)) {
+        close(fd);
+        return NULL;
     }
 
-    /* Try ntfs-3g as a fallback (userspace FUSE driver) */
-    if (!mounted) {
-        if (run_cmd("mount -t ntfs-3g -o ro '%s' '%s' 2>/dev/null",
-                     partition, INSTALLER_MNT) == 0)
-            mounted = 1;
+    if (memcmp(sb, "XFSB", 4) == 0) {
+        type = "xfs";
+    } else if (memcmp(sb + 3, "NTFS    ", 8) == 0) {
+        type = "ntfs";
+    } else if (sb[1024 + 56] == 0x53 && sb[1024 + 57] == 0xEF) {
+        type = "ext4";              /* also mounts ext2 and ext3 */
+        char last[65];
+        memcpy(last, sb + 1024 + EXT_SB_LAST_MOUNTED, 64);
+        last[64] = '\0';
+        for (int i = 0; data_mounts[i]; i++) {
+            size_t n = strlen(data_mounts[i]);
+            if (strncmp(last, data_mounts[i], n) == 0 &&
+                (last[n] == '\0' || last[n] == '/'))
+                type = NULL;
+        }
+    } else if (sb[1024] == 0x10 && sb[1025] == 0x20 &&
+               sb[1026] == 0xF5 && sb[1027] == 0xF2) {
+        type = "f2fs";
+    } else if (sb[1024] == 'H' && (sb[1025] == '+' || sb[1025] == 'X')) {
+        type = "hfsplus";
+    } else if (pread(fd, sb, sizeof(sb), 65536) == (ssize_t)sizeof(sb) &&
+               memcmp(sb + 64, "_BHRfS_M", 8) == 0) {
+        type = "btrfs";
     }
 
-    if (!mounted) return DETECTED_OS_UNKNOWN;
+    close(fd);
+    return type;
+}
+
+/* Mount partition read-only on mnt as type; NTFS through whichever
+ * driver this kernel or userland has. Returns 0 once mounted. */
+static int mount_probe(const char *partition, const char *type,
+                       const char *mnt)
+{
+    unsigned long flags = MS_RDONLY | MS_NOEXEC | MS_NOSUID;
+    if (strcmp(type, "ntfs") != 0)
+        return mount(partition, mnt, type, flags, NULL);
+
+    if (mount(partition, mnt, "ntfs3", flags, NULL) == 0 ||
+        mount(partition, mnt, "ntfs", flags, NULL) == 0)
+        return 0;
+    /* Userspace FUSE driver */
+    return run_cmd("mount -t ntfs-3g -o ro '%s' '%s' 2>/dev/null",
+                   partition, mnt) == 0 ? 0 : -1;
+}
+
+detected_os_t vault_installer_detect_os(const char *partition,
+                                         drive_info_t *info)
+{
+    /* Read the superblock first and mount only what could be a root,
+     * once, with its own type: no trial mounts, no kernel log noise */
+    const char *type = probe_root_fs(partition);
+    if (!type) return DETECTED_OS_UNKNOWN;
+
+    /* A directory of its own, so probes can run side by side */
+    char mnt[] = INSTALLER_MNT;
+    if (!mkdtemp(mnt)) return DETECTED_OS_UNKNOWN;
+    if (mount_probe(partition, type, mnt) != 0) {
+        rmdir(mnt);
+        return DETECTED_OS_UNKNOWN;
+    }
 
     detected_os_t os = DETECTED_OS_UNKNOWN;
 
     /* --- Linux detection --- */
-    if (file_exists(INSTALLER_MNT, "etc/os-release")) {
+    if (file_exists(mnt, "etc/os-release")) {
         os = DETECTED_OS_LINUX;
 
         char osrelease[256];
         snprintf(osrelease, sizeof(osrelease),
-                 "%s/etc/os-release", INSTALLER_MNT);
+                 "%s/etc/os-release", mnt);
 
         char name[128] = "Linux";
         char version[64] = "";
@@ -203,13 +470,13 @@ detected_os_t vault_installer_detect_os(const char *partition,
                 sizeof(info->root_partition) - 1);
 
         info->has_initramfs_tools =
-            dir_exists(INSTALLER_MNT, "etc/initramfs-tools");
+            dir_exists(mnt, "etc/initramfs-tools");
         info->has_dracut =
-            file_exists(INSTALLER_MNT, "usr/bin/dracut") ||
-            file_exists(INSTALLER_MNT, "usr/sbin/dracut");
+            file_exists(mnt, "usr/bin/dracut") ||
+            file_exists(mnt, "usr/sbin/dracut");
     }
     /* --- macOS detection --- */
-    else if (file_exists(INSTALLER_MNT,
+    else if (file_exists(mnt,
                          "System/Library/CoreServices/SystemVersion.plist")) {
         os = DETECTED_OS_MACOS;
         strncpy(info->os_name, "macOS", sizeof(info->os_name) - 1);
@@ -217,16 +484,17 @@ detected_os_t vault_installer_detect_os(const char *partition,
                 sizeof(info->root_partition) - 1);
     }
     /* --- Windows detection --- */
-    else if (file_exists(INSTALLER_MNT, "Windows/System32/ntoskrnl.exe") ||
-             file_exists(INSTALLER_MNT, "windows/system32/ntoskrnl.exe") ||
-             file_exists(INSTALLER_MNT, "WINDOWS/system32/ntoskrnl.exe")) {
+    else if (file_exists(mnt, "Windows/System32/ntoskrnl.exe") ||
+             file_exists(mnt, "windows/system32/ntoskrnl.exe") ||
+             file_exists(mnt, "WINDOWS/system32/ntoskrnl.exe")) {
         os = DETECTED_OS_WINDOWS;
         strncpy(info->os_name, "Windows", sizeof(info->os_name) - 1);
         strncpy(info->root_partition, partition,
                 sizeof(info->root_partition) - 1);
     }
 
-    umount(INSTALLER_MNT);
+    umount(mnt);
+    rmdir(mnt);
     info->detected_os = os;
     return os;
 }
@@ -235,91 +503,95 @@ detected_os_t vault_installer_detect_os(const char *partition,
 /*  Drive Scanning                                                     */
 /* ------------------------------------------------------------------ */
 
-int vault_installer_scan_drives(drive_info_t *drives, int max_drives)
+/* Drives are probed side by side, one per worker at a time, so each
+ * waits out its own spin-up while the others work; partitions of one
+ * drive are probed in turn, not to make one disk seek between them. */
+typedef struct {
+    const vault_devices_t *inv;
+    drive_info_t  *slots;           /* one per inventory entry */
+    int            next;
+    vault_mutex_t  lock;
+} scan_pool_t;
+
+static void scan_drive(const vault_device_t *dev, drive_info_t *d)
 {
-    DIR *dir = opendir("/sys/block");
-    if (!dir) return 0;
-
-    int count = 0;
-    struct dirent *ent;
+    snprintf(d->device_path, sizeof(d->device_path), "%s", dev->path);
+    d->size_bytes = dev->size_bytes;
+
+    /* SSD detection */
+    d->is_ssd = dev->rotational < 0 ? -1 : !dev->rotational;
+
+    /* Boot USB detection */
+    d->is_boot_usb = is_boot_usb(dev);
+
+    /* Generate label */
+    double gb = (double)d->size_bytes / (1024.0 * 1024.0 * 1024.0);
+    snprintf(d->label, sizeof(d->label), "%s (%.1f GB%s%s)",
+             d->device_path, gb,
+             d->is_ssd == 1 ? ", SSD" : (d->is_ssd == 0 ? ", HDD" : ""),
+             d->is_boot_usb ? ", ShredOS USB" : "");
+
+    /* Detect OS on partitions */
+    if (d->is_boot_usb) return;
+
+    /* Try the device itself first */
+    vault_installer_detect_os(d->device_path, d);
+
+    /* If not found, try partitions */
+    for (int p = 0; p < dev->part_count &&
+                    d->detected_os == DETECTED_OS_UNKNOWN; p++) {
+        if (dev->parts[p].size_bytes < INSTALLER_MIN_ROOT) continue;
+        char partdev[64];
+        snprintf(partdev, sizeof(partdev), "/dev/%s", dev->parts[p].name);
+        vault_installer_detect_os(partdev, d);
+    }
+}
 
-    while ((ent = readdir(dir)) && count < max_drives) {
+static void *scan_worker(void *arg)
+{
+    scan_pool_t *pool = (scan_pool_t *)arg;
+    for (;;) {
+        vault_mutex_lock(&pool->lock);
+        int n = pool->next++;
+        vault_mutex_unlock(&pool->lock);
+        if (n >= pool->inv->count) break;
         /* Skip virtual devices */
-        if (strncmp(ent->d_name, "loop", 4) == 0) continue;
-        if (strncmp(ent->d_name, "ram", 3) == 0) continue;
-        if (strncmp(ent->d_name, "dm-", 3) == 0) continue;
-        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
-            continue;
-
-        drive_info_t *d = &drives[count];
-        memset(d, 0, sizeof(*d));
-
-        snprintf(d->device_path, sizeof(d->device_path),
-                 "/dev/%s", ent->d_name);
-
-        /* Get size */
-        char spath[256];
-        snprintf(spath, sizeof(spath), "/sys/block/%s/size", ent->d_name);
-        FILE *sf = fopen(spath, "r");
-        if (sf) {
-            unsigned long long sectors = 0;
-            if (fscanf(sf, "%llu", &sectors) == 1)
-                d->size_bytes = sectors * 512ULL;
-            fclose(sf);
-        }
-
-        /* Skip zero-size devices */
-        if (d->size_bytes == 0) continue;
-
-        /* SSD detection */
-        d->is_ssd = vault_wipe_is_ssd(d->device_path);
-
-        /* Boot USB detection */
-        d->is_boot_usb = is_boot_usb(ent->d_name);
-
-        /* Generate label */
-        double gb = (double)d->size_bytes / (1024.0 * 1024.0 * 1024.0);
-        snprintf(d->label, sizeof(d->label), "%s (%.1f GB%s%s)",
-                 d->device_path, gb,
-                 d->is_ssd == 1 ? ", SSD" : (d->is_ssd == 0 ? ", HDD" : ""),
-                 d->is_boot_usb ? ", ShredOS USB" : "");
-
-        /* Detect OS on partitions */
-        if (!d->is_boot_usb) {
-            /* Try the device itself first */
-            vault_installer_detect_os(d->device_path, d);
-
-            /* If not found, try partitions */
-            if (d->detected_os == DETECTED_OS_UNKNOWN) {
-                char pdir[256];
-                snprintf(pdir, sizeof(pdir), "/sys/block/%s", ent->d_name);
-                DIR *pdd = opendir(pdir);
-                if (pdd) {
-                    struct dirent *pe;
-                    while ((pe = readdir(pdd))) {
-                        /* Partition entries look like sda1, nvme0n1p1, etc. */
-                        if (strncmp(pe->d_name, ent->d_name,
-                                    strlen(ent->d_name)) != 0)
-                            continue;
-                        if (strcmp(pe->d_name, ent->d_name) == 0)
-                            continue;
-
-                        char partdev[256];
-                        snprintf(partdev, sizeof(partdev),
-                                 "/dev/%s", pe->d_name);
-
-                        vault_installer_detect_os(partdev, d);
-                        if (d->detected_os != DETECTED_OS_UNKNOWN)
-                            break;
-                    }
-                    closedir(pdd);
-                }
-            }
-        }
+        if (strncmp(pool->inv->devices[n].name, "dm-", 3) == 0) continue;
+        scan_drive(&pool->inv->devices[n], &pool->slots[n]);
+    }
+    return NULL;
+}
 
-        count++;
+int vault_installer_scan_drives(drive_info_t *drives, int max_drives)
+{
+    const vault_devices_t *inv = vault_devices_get();
+    if (!inv) return 0;
+
+    static drive_info_t slots[VAULT_DEVICES_MAX];
+    memset(slots, 0, sizeof(slots));
+    scan_pool_t pool;
+    pool.inv = inv;
+    pool.slots = slots;
+    pool.next = 0;
+    vault_mutex_init(&pool.lock);
+
+    vault_thread_t threads[INSTALLER_SCAN_THREADS];
+    int nthreads = 0;
+    while (nthreads < INSTALLER_SCAN_THREADS && nthreads < inv->count &&
+           vault_thread_create(&threads[nthreads], scan_worker, &pool) == 0)
+        nthreads++;
+    /* Without threads, this thread does it all */
+    if (nthreads == 0) scan_worker(&pool);
+    for (int i = 0; i < nthreads; i++)
+        vault_thread_join(threads[i]);
+    vault_mutex_destroy(&pool.lock);
+
+    /* In inventory order, whatever order the probes finished in */
+    int count = 0;
+    for (int n = 0; n < inv->count && count < max_drives; n++) {
+        if (strncmp(inv->devices[n].name, "dm-", 3) == 0) continue;
+        drives[count++] = slots[n];
     }
-    closedir(dir);
     return count;
 }
 
@@ -327,123 +599,152 @@ int vault_installer_scan_drives(drive_info_t *drives, int max_drives)
 /*  Linux Installation                                                 */
 /* ------------------------------------------------------------------ */
 
-int vault_installer_install_linux(const drive_info_t *drive,
-                                   const vault_config_t *cfg)
+static int install_linux(install_job_t *job, const drive_info_t *drive,
+                         const vault_config_t *cfg)
 {
-    mkdir(INSTALLER_TARGET, 0755);
+    mkdir(job->mnt, 0755);
 
     /* Mount the root partition read-write */
-    vault_tui_status("Mounting target filesystem...");
+    job_status(job, "Mounting target filesystem...");
 
     const char *fstypes[] = {"ext4","ext3","ext2","xfs","btrfs",NULL};
     int mounted = 0;
     for (int i = 0; fstypes[i]; i++) {
-        if (mount(drive->root_partition, INSTALLER_TARGET,
+        if (mount(drive->root_partition, job->mnt,
                   fstypes[i], 0, NULL) == 0) {
             mounted = 1;
             break;
         }
     }
     if (!mounted) {
-        vault_tui_error("Failed to mount %s", drive->root_partition);
+        job_error(job, "Failed to mount %s", drive->root_partition);
         return -1;
     }
 
-    /* Copy vault binary */
-    vault_tui_status("Copying vault binary...");
-    run_cmd("mkdir -p '%s/usr/sbin'", INSTALLER_TARGET);
-    if (run_cmd("cp /usr/bin/shredos-vault '%s/usr/sbin/shredos-vault'",
-                INSTALLER_TARGET) != 0) {
-        vault_tui_error("Failed to copy vault binary");
+    /* Copy vault binary: the gate build where there is one, which
+     * leaves out what only the USB needs and keeps the initramfs small */
+    job_status(job, "Copying vault binary...");
+    const char *bin = access(INSTALLER_GATE_BIN, X_OK) == 0
+        ? INSTALLER_GATE_BIN : "/usr/bin/shredos-vault";
+    if (make_dirs(job, target_path(job, "/usr/sbin"), 0755) != 0 ||
+        copy_file(job, bin, target_path(job, "/usr/sbin/shredos-vault"),
+                  0755) != 0) {
+        job_error(job, "Failed to copy vault binary: %s", job->error);
         goto fail;
     }
-    run_cmd("chmod 755 '%s/usr/sbin/shredos-vault'", INSTALLER_TARGET);
 
     /* Write config */
-    vault_tui_status("Writing configuration...");
-    run_cmd("mkdir -p '%s/etc/shredos-vault'", INSTALLER_TARGET);
-    run_cmd("chmod 700 '%s/etc/shredos-vault'", INSTALLER_TARGET);
+    job_status(job, "Writing configuration...");
+    if (make_dirs(job, target_path(job, "/etc/shredos-vault"), 0700) != 0) {
+        job_error(job, "Failed to write config: %s", job->error);
+        goto fail;
+    }
     {
-        char cpath[512];
-        snprintf(cpath, sizeof(cpath),
-                 "%s/etc/shredos-vault/vault.conf", INSTALLER_TARGET);
+        char cpath[512], spath[600];
+        snprintf(cpath, sizeof(cpath), "%s/etc/shredos-vault/vault.conf",
+                 job->mnt);
         if (vault_config_save(cfg, cpath) != 0) {
-            vault_tui_error("Failed to write config");
+            job_error(job, "Failed to write config");
             goto fail;
         }
-        run_cmd("chmod 600 '%s'", cpath);
+        chmod(cpath, 0600);
+
+        /* Early boot loads this instead of parsing vault.conf */
+        snprintf(spath, sizeof(spath), "%s" VAULT_CONFIG_SNAPSHOT_SUFFIX,
+                 cpath);
+        if (vault_config_snapshot_save(cfg, cpath) == 0)
+            chmod(spath, 0600);
     }
 
     /* Install boot hooks */
-    vault_tui_status("Installing boot hooks...");
+    job_status(job, "Installing boot hooks...");
 
+    const char *rebuild;
+    vault_initramfs_kind_t kind;
+    time_t hook_since = 0;
     if (drive->has_initramfs_tools) {
-        run_cmd("cp /usr/share/shredos-vault/initramfs-hook.sh "
-                "'%s/etc/initramfs-tools/hooks/shredos-vault'",
-                INSTALLER_TARGET);
-        run_cmd("chmod 755 '%s/etc/initramfs-tools/hooks/shredos-vault'",
-                INSTALLER_TARGET);
-        run_cmd("cp /usr/share/shredos-vault/initramfs-script.sh "
-                "'%s/etc/initramfs-tools/scripts/local-top/shredos-vault'",
-                INSTALLER_TARGET);
-        run_cmd("chmod 755 '%s/etc/initramfs-tools/scripts/local-top/"
-                "shredos-vault'", INSTALLER_TARGET);
-
-        /* Rebuild initramfs via chroot */
-        vault_tui_status("Rebuilding initramfs (this may take a moment)...");
-        run_cmd("mount --bind /dev '%s/dev'", INSTALLER_TARGET);
-        run_cmd("mount --bind /proc '%s/proc'", INSTALLER_TARGET);
-        run_cmd("mount --bind /sys '%s/sys'", INSTALLER_TARGET);
-
-        int ret = run_cmd("chroot '%s' update-initramfs -u", INSTALLER_TARGET);
-
-        run_cmd("umount '%s/sys' 2>/dev/null", INSTALLER_TARGET);
-        run_cmd("umount '%s/proc' 2>/dev/null", INSTALLER_TARGET);
-        run_cmd("umount '%s/dev' 2>/dev/null", INSTALLER_TARGET);
-
-        if (ret != 0) {
-            vault_tui_error("initramfs rebuild failed");
+        /* Images newer than the script already there were built with it */
+        struct stat st;
+        if (stat(target_path(job, "/etc/initramfs-tools/scripts/local-top/"
+                                  "shredos-vault"), &st) == 0)
+            hook_since = st.st_mtime;
+
+        if (copy_file(job, "/usr/share/shredos-vault/initramfs-hook.sh",
+                      target_path(job,
+                          "/etc/initramfs-tools/hooks/shredos-vault"),
+                      0755) != 0 ||
+            copy_file(job, "/usr/share/shredos-vault/initramfs-script.sh",
+                      target_path(job,
+                          "/etc/initramfs-tools/scripts/local-top/"
+                          "shredos-vault"),
+                      0755) != 0) {
+            job_error(job, "Failed to install boot hooks: %s", job->error);
             goto fail;
         }
+        kind = VAULT_INITRAMFS_TOOLS;
+        rebuild = "update-initramfs -u";
 
     } else if (drive->has_dracut) {
-        run_cmd("mkdir -p '%s/usr/lib/dracut/modules.d/90shredos-vault'",
-                INSTALLER_TARGET);
-        run_cmd("cp /usr/share/shredos-vault/dracut-module/* "
-                "'%s/usr/lib/dracut/modules.d/90shredos-vault/'",
-                INSTALLER_TARGET);
-
-        vault_tui_status("Rebuilding initramfs (dracut)...");
-        run_cmd("mount --bind /dev '%s/dev'", INSTALLER_TARGET);
-        run_cmd("mount --bind /proc '%s/proc'", INSTALLER_TARGET);
-        run_cmd("mount --bind /sys '%s/sys'", INSTALLER_TARGET);
-
-        int ret = run_cmd("chroot '%s' dracut --force", INSTALLER_TARGET);
+        char mod[512];
+        snprintf(mod, sizeof(mod),
+                 "%s/usr/lib/dracut/modules.d/90shredos-vault", job->mnt);
+        if (make_dirs(job, mod, 0755) != 0 ||
+            copy_dir(job, "/usr/share/shredos-vault/dracut-module",
+                     mod) != 0) {
+            job_error(job, "Failed to install dracut module: %s",
+                      job->error);
+            goto fail;
+        }
+        kind = VAULT_INITRAMFS_DRACUT;
+        rebuild = "dracut --force";
 
-        run_cmd("umount '%s/sys' 2>/dev/null", INSTALLER_TARGET);
-        run_cmd("umount '%s/proc' 2>/dev/null", INSTALLER_TARGET);
-        run_cmd("umount '%s/dev' 2>/dev/null", INSTALLER_TARGET);
+    } else {
+        job_error(job, "No supported initramfs system on target");
+        goto fail;
+    }
 
-        if (ret != 0) {
-            vault_tui_error("dracut rebuild failed");
+    /* Seconds instead of minutes: the vault appended to the images
+     * there are, where they allow it */
+    if (cfg->initramfs_append) {
+        job_status(job, "Adding the vault to the initramfs images...");
+        char why[256];
+        int r = vault_initramfs_append(job->mnt, kind, hook_since,
+                                       why, sizeof(why));
+        if (r == 0) goto done;
+        if (r < 0) {
+            job_error(job, "Failed to update initramfs: %s", why);
             goto fail;
         }
+        job_status(job, "%s, so the initramfs is rebuilt", why);
+    }
 
-    } else {
-        vault_tui_error("No supported initramfs system on target");
+    job_status(job, kind == VAULT_INITRAMFS_TOOLS
+               ? "Rebuilding initramfs (this may take a moment)..."
+               : "Rebuilding initramfs (dracut)...");
+
+    /* The one step that needs the target's own tools */
+    if (bind_target(job) != 0) {
+        job_error(job, "Failed to prepare chroot: %s", job->error);
+        goto fail;
+    }
+    int ret = run_cmd("chroot '%s' %s%s", job->mnt, rebuild,
+                      job->batch ? " >/dev/null 2>&1" : "");
+    unbind_target(job);
+    if (ret != 0) {
+        job_error(job, "%s rebuild failed", kind == VAULT_INITRAMFS_TOOLS
+                  ? "initramfs" : "dracut");
         goto fail;
     }
 
-    vault_tui_status("Finalising...");
+done:
+    job_status(job, "Finalising...");
     sync();
-    umount(INSTALLER_TARGET);
+    umount(job->mnt);
     return 0;
 
 fail:
-    run_cmd("umount '%s/sys' 2>/dev/null", INSTALLER_TARGET);
-    run_cmd("umount '%s/proc' 2>/dev/null", INSTALLER_TARGET);
-    run_cmd("umount '%s/dev' 2>/dev/null", INSTALLER_TARGET);
-    umount(INSTALLER_TARGET);
+    unbind_target(job);
+    umount(job->mnt);
     return -1;
 }
 
@@ -451,101 +752,112 @@ fail:
 /*  macOS Installation                                                 */
 /* ------------------------------------------------------------------ */
 
-int vault_installer_install_macos(const drive_info_t *drive,
-                                   const vault_config_t *cfg)
+static int install_macos(install_job_t *job, const drive_info_t *drive,
+                         const vault_config_t *cfg)
 {
-    mkdir(INSTALLER_TARGET, 0755);
+    mkdir(job->mnt, 0755);
 
-    vault_tui_status("Mounting macOS volume...");
-    int mounted = 0;
-    if (mount(drive->root_partition, INSTALLER_TARGET,
-              "hfsplus", 0, NULL) == 0)
-        mounted = 1;
-    if (!mounted && run_cmd("mount -t hfsplus '%s' '%s' 2>/dev/null",
-                             drive->root_partition, INSTALLER_TARGET) == 0)
-        mounted = 1;
-
-    if (!mounted) {
-        vault_tui_error("Failed to mount macOS volume");
+    job_status(job, "Mounting macOS volume...");
+    if (mount(drive->root_partition, job->mnt, "hfsplus", 0, NULL) != 0) {
+        job_error(job, "Failed to mount macOS volume: %s", strerror(errno));
         return -1;
     }
 
-    vault_tui_status("Copying vault binary...");
-    run_cmd("mkdir -p '%s/usr/local/sbin'", INSTALLER_TARGET);
-    run_cmd("cp /usr/bin/shredos-vault '%s/usr/local/sbin/shredos-vault'",
-            INSTALLER_TARGET);
-    run_cmd("chmod 755 '%s/usr/local/sbin/shredos-vault'", INSTALLER_TARGET);
+    job_status(job, "Copying vault binary...");
+    if (make_dirs(job, target_path(job, "/usr/local/sbin"), 0755) != 0 ||
+        copy_file(job, "/usr/bin/shredos-vault",
+                  target_path(job, "/usr/local/sbin/shredos-vault"),
+                  0755) != 0) {
+        job_error(job, "Failed to copy vault binary: %s", job->error);
+        goto fail;
+    }
 
-    vault_tui_status("Writing configuration...");
-    run_cmd("mkdir -p '%s/Library/Application Support/ShredOS-Vault'",
-            INSTALLER_TARGET);
-    {
-        char cpath[512];
-        snprintf(cpath, sizeof(cpath),
-                 "%s/Library/Application Support/ShredOS-Vault/vault.conf",
-                 INSTALLER_TARGET);
-        vault_config_save(cfg, cpath);
+    job_status(job, "Writing configuration...");
+    if (make_dirs(job, target_path(job,
+                  "/Library/Application Support/ShredOS-Vault"), 0700) != 0) {
+        job_error(job, "Failed to write config: %s", job->error);
+        goto fail;
+    }
+    if (vault_config_save(cfg, target_path(job,
+            "/Library/Application Support/ShredOS-Vault/vault.conf")) != 0) {
+        job_error(job, "Failed to write config");
+        goto fail;
     }
 
-    vault_tui_status("Installing LaunchDaemon...");
-    run_cmd("mkdir -p '%s/Library/LaunchDaemons'", INSTALLER_TARGET);
-    run_cmd("cp /usr/share/shredos-vault/com.shredos.vault-gate.plist "
-            "'%s/Library/LaunchDaemons/'", INSTALLER_TARGET);
+    job_status(job, "Installing LaunchDaemon...");
+    if (make_dirs(job, target_path(job, "/Library/LaunchDaemons"),
+                  0755) != 0 ||
+        copy_file(job, "/usr/share/shredos-vault/com.shredos.vault-gate.plist",
+                  target_path(job, "/Library/LaunchDaemons/"
+                                   "com.shredos.vault-gate.plist"),
+                  0644) != 0) {
+        job_error(job, "Failed to install LaunchDaemon: %s", job->error);
+        goto fail;
+    }
 
-    vault_tui_status("Finalising...");
+    job_status(job, "Finalising...");
     sync();
-    umount(INSTALLER_TARGET);
+    umount(job->mnt);
     return 0;
+
+fail:
+    umount(job->mnt);
+    return -1;
 }
 
 /* ------------------------------------------------------------------ */
 /*  Windows Installation                                               */
 /* ------------------------------------------------------------------ */
 
-int vault_installer_install_windows(const drive_info_t *drive,
-                                     const vault_config_t *cfg)
+static int install_windows(install_job_t *job, const drive_info_t *drive,
+                           const vault_config_t *cfg)
 {
-    mkdir(INSTALLER_TARGET, 0755);
+    mkdir(job->mnt, 0755);
 
-    vault_tui_status("Mounting Windows partition...");
+    job_status(job, "Mounting Windows partition...");
+    /* The kernel's own driver first; ntfs-3g is FUSE and has to be
+     * started through its helper */
     int mounted = 0;
-    if (run_cmd("mount -t ntfs-3g '%s' '%s'",
-                drive->root_partition, INSTALLER_TARGET) == 0)
+    if (mount(drive->root_partition, job->mnt, "ntfs3", 0, NULL) == 0)
         mounted = 1;
-    if (!mounted && mount(drive->root_partition, INSTALLER_TARGET,
-                           "ntfs3", 0, NULL) == 0)
+    if (!mounted && run_cmd("mount -t ntfs-3g '%s' '%s'%s",
+                             drive->root_partition, job->mnt,
+                             job->batch ? " 2>/dev/null" : "") == 0)
         mounted = 1;
 
     if (!mounted) {
-        vault_tui_error("Failed to mount NTFS. ntfs-3g required.");
+        job_error(job, "Failed to mount NTFS. ntfs-3g required.");
         return -1;
     }
 
-    vault_tui_status("Copying files...");
-    run_cmd("mkdir -p '%s/Program Files/ShredOS-Vault'", INSTALLER_TARGET);
-    run_cmd("mkdir -p '%s/ProgramData/ShredOS-Vault'", INSTALLER_TARGET);
+    job_status(job, "Copying files...");
+    if (make_dirs(job, target_path(job, "/Program Files/ShredOS-Vault"),
+                  0755) != 0 ||
+        make_dirs(job, target_path(job, "/ProgramData/ShredOS-Vault"),
+                  0755) != 0) {
+        job_error(job, "Failed to create folders: %s", job->error);
+        umount(job->mnt);
+        return -1;
+    }
 
     /* Copy install scripts for the user to run on Windows */
-    run_cmd("cp /usr/share/shredos-vault/windows/* "
-            "'%s/Program Files/ShredOS-Vault/' 2>/dev/null",
-            INSTALLER_TARGET);
-
-    vault_tui_status("Writing configuration...");
-    {
-        char cpath[512];
-        snprintf(cpath, sizeof(cpath),
-                 "%s/ProgramData/ShredOS-Vault/vault.conf", INSTALLER_TARGET);
-        vault_config_save(cfg, cpath);
+    if (copy_dir(job, "/usr/share/shredos-vault/windows",
+                 target_path(job, "/Program Files/ShredOS-Vault")) != 0)
+        job_status(job, "%s", job->error);
+
+    job_status(job, "Writing configuration...");
+    if (vault_config_save(cfg, target_path(job,
+            "/ProgramData/ShredOS-Vault/vault.conf")) != 0) {
+        job_error(job, "Failed to write config");
+        umount(job->mnt);
+        return -1;
     }
 
     /* Create README for the user */
-    vault_tui_status("Creating setup instructions...");
+    job_status(job, "Creating setup instructions...");
     {
-        char rpath[512];
-        snprintf(rpath, sizeof(rpath),
-                 "%s/Program Files/ShredOS-Vault/COMPLETE_SETUP.txt",
-                 INSTALLER_TARGET);
-        FILE *fp = fopen(rpath, "w");
+        FILE *fp = fopen(target_path(job, "/Program Files/ShredOS-Vault/"
+                                          "COMPLETE_SETUP.txt"), "w");
         if (fp) {
             fprintf(fp, "ShredOS Vault - Windows Setup\r\n\r\n");
             fprintf(fp, "Run install.bat as Administrator to complete "
@@ -556,14 +868,315 @@ int vault_installer_install_windows(const drive_info_t *drive,
         }
     }
 
-    vault_tui_status("Finalising...");
+    job_status(job, "Finalising...");
     sync();
-    umount(INSTALLER_TARGET);
+    umount(job->mnt);
+
+    job_status(job, "NOTE: On Windows, run install.bat as Administrator.");
+    return 0;
+}
+
+/* The wizard's installs: one at a time, on the fixed mount point */
+
+int vault_installer_install_linux(const drive_info_t *drive,
+                                   const vault_config_t *cfg)
+{
+    install_job_t job = { .mnt = INSTALLER_TARGET };
+    return install_linux(&job, drive, cfg);
+}
+
+int vault_installer_install_macos(const drive_info_t *drive,
+                                   const vault_config_t *cfg)
+{
+    install_job_t job = { .mnt = INSTALLER_TARGET };
+    return install_macos(&job, drive, cfg);
+}
+
+int vault_installer_install_windows(const drive_info_t *drive,
+                                     const vault_config_t *cfg)
+{
+    install_job_t job = { .mnt = INSTALLER_TARGET };
+    return install_windows(&job, drive, cfg);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Batch Install                                                      */
+/* ------------------------------------------------------------------ */
+
+/*
+ * --install-batch: a manifest of "device config" lines, checked up
+ * front, then installed several targets at a time, each on its own
+ * mount point. The slow part of an install is the target's initramfs
+ * rebuild, which runs in its own chroot and so overlaps freely.
+ */
+
+typedef struct {
+    char           device[256];
+    char           config[512];
+    vault_config_t cfg;
+    drive_info_t   drive;
+    int            ready;       /* passed the checks, to be installed */
+    int            result;      /* 0 installed, -1 not */
+    double         secs;
+    char           mnt[32];
+    install_job_t  job;
+} batch_target_t;
+
+typedef struct {
+    batch_target_t *targets;
+    int             count;
+    int             next;
+    vault_mutex_t   lock;
+} batch_pool_t;
+
+/* Read "device config" lines into t. A relative config is taken from
+ * the manifest's directory. Returns the count, or -1. */
+static int batch_read_manifest(const char *manifest, batch_target_t *t,
+                               int max)
+{
+    FILE *fp = fopen(manifest, "r");
+    if (!fp) {
+        fprintf(stderr, "vault: cannot open %s: %s\n",
+                manifest, strerror(errno));
+        return -1;
+    }
+
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", manifest);
+    char *slash = strrchr(dir, '/');
+    if (slash) *slash = '\0';
+    else snprintf(dir, sizeof(dir), ".");
+
+    char line[1024];
+    int count = 0, lineno = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lineno++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        char device[256], config[512];
+        int n = sscanf(line, "%255s %511s", device, config);
+        if (n <= 0) continue;
+        if (n != 2) {
+            fprintf(stderr, "vault: %s:%d: expected \"device config\"\n",
+                    manifest, lineno);
+            fclose(fp);
+            return -1;
+        }
+        if (count == max) {
+            fprintf(stderr, "vault: %s: more than %d targets\n",
+                    manifest, max);
+            fclose(fp);
+            return -1;
+        }
+        snprintf(t[count].device, sizeof(t[count].device), "%s", device);
+        int len = config[0] == '/'
+            ? snprintf(t[count].config, sizeof(t[count].config), "%s",
+                       config)
+            : snprintf(t[count].config, sizeof(t[count].config), "%s/%s",
+                       dir, config);
+        if (len < 0 || (size_t)len >= sizeof(t[count].config)) {
+            fprintf(stderr, "vault: %s:%d: config path too long\n",
+                    manifest, lineno);
+            fclose(fp);
+            return -1;
+        }
+        count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+/* Everything that can be known before touching a disk. Returns 0 if t
+ * can be installed, else -1 with the reason in t->job.error. */
+static int batch_check(batch_target_t *t, int index,
+                       const drive_info_t *drives, int drive_count)
+{
+    for (int i = 0; i < index; i++) {
+        if (strcmp(t[i].device, t[index].device) == 0) {
+            snprintf(t[index].job.error, sizeof(t[index].job.error),
+                     "Listed twice in the manifest");
+            return -1;
+        }
+    }
+
+    batch_target_t *bt = &t[index];
+    vault_config_init(&bt->cfg);
+    if (vault_config_load(&bt->cfg, bt->config) != 0) {
+        snprintf(bt->job.error, sizeof(bt->job.error),
+                 "Cannot load config %s", bt->config);
+        return -1;
+    }
+    if (!bt->cfg.password_hash[0]) {
+        snprintf(bt->job.error, sizeof(bt->job.error),
+                 "Config %s has no password_hash", bt->config);
+        return -1;
+    }
+
+    const drive_info_t *d = NULL;
+    for (int i = 0; i < drive_count && !d; i++)
+        if (strcmp(drives[i].device_path, bt->device) == 0) d = &drives[i];
+    if (!d) {
+        snprintf(bt->job.error, sizeof(bt->job.error), "No such drive");
+        return -1;
+    }
+    if (d->is_boot_usb) {
+        snprintf(bt->job.error, sizeof(bt->job.error),
+                 "This is the ShredOS USB");
+        return -1;
+    }
+    if (d->detected_os == DETECTED_OS_UNKNOWN) {
+        snprintf(bt->job.error, sizeof(bt->job.error),
+                 "No supported OS detected");
+        return -1;
+    }
 
-    vault_tui_status("NOTE: On Windows, run install.bat as Administrator.");
+    bt->drive = *d;
+    snprintf(bt->cfg.target_device, sizeof(bt->cfg.target_device), "%s",
+             bt->device);
     return 0;
 }
 
+static void batch_install(batch_target_t *t)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    snprintf(t->mnt, sizeof(t->mnt), "%s", INSTALLER_BATCH_MNT);
+    if (!mkdtemp(t->mnt)) {
+        op_fail(&t->job, "Cannot create mount point");
+        return;
+    }
+    t->job.mnt = t->mnt;
+
+    switch (t->drive.detected_os) {
+    case DETECTED_OS_LINUX:
+        t->result = install_linux(&t->job, &t->drive, &t->cfg);
+        break;
+    case DETECTED_OS_MACOS:
+        t->result = install_macos(&t->job, &t->drive, &t->cfg);
+        break;
+    case DETECTED_OS_WINDOWS:
+        t->result = install_windows(&t->job, &t->drive, &t->cfg);
+        break;
+    default:
+        break;
+    }
+    rmdir(t->mnt);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    t->secs = (double)(end.tv_sec - start.tv_sec) +
+              (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    if (t->result == 0)
+        fprintf(stderr, "%s: installed (%.1f s)\n", t->device, t->secs);
+    else
+        fprintf(stderr, "%s: FAILED: %s\n", t->device, t->job.error);
+}
+
+static void *batch_worker(void *arg)
+{
+    batch_pool_t *pool = (batch_pool_t *)arg;
+    for (;;) {
+        vault_mutex_lock(&pool->lock);
+        int n = pool->next++;
+        vault_mutex_unlock(&pool->lock);
+        if (n >= pool->count) break;
+        if (pool->targets[n].ready) batch_install(&pool->targets[n]);
+    }
+    return NULL;
+}
+
+/* One JSON object per line, in manifest order */
+static void batch_report(FILE *fp, const batch_target_t *t, int count)
+{
+    for (int i = 0; i < count; i++) {
+        fprintf(fp, "{\"event\":\"install\",\"device\":");
+        vault_wipe_json_string(fp, t[i].device);
+        fprintf(fp, ",\"config\":");
+        vault_wipe_json_string(fp, t[i].config);
+        if (t[i].ready) {
+            fprintf(fp, ",\"os\":");
+            vault_wipe_json_string(fp, t[i].drive.os_name);
+            fprintf(fp, ",\"root\":");
+            vault_wipe_json_string(fp, t[i].drive.root_partition);
+            fprintf(fp, ",\"seconds\":%.1f", t[i].secs);
+        }
+        fprintf(fp, ",\"result\":\"%s\"",
+                t[i].result == 0 ? "ok" : t[i].ready ? "failed" : "skipped");
+        if (t[i].result != 0) {
+            fprintf(fp, ",\"error\":");
+            vault_wipe_json_string(fp, t[i].job.error);
+        }
+        fprintf(fp, "}\n");
+    }
+    fflush(fp);
+}
+
+int vault_installer_run_batch(const char *manifest, const char *report)
+{
+    batch_target_t *t = calloc(VAULT_DEVICES_MAX, sizeof(*t));
+    drive_info_t *drives = calloc(VAULT_DEVICES_MAX, sizeof(*drives));
+    if (!t || !drives) {
+        free(t);
+        free(drives);
+        return -1;
+    }
+
+    int count = batch_read_manifest(manifest, t, VAULT_DEVICES_MAX);
+    if (count <= 0) {
+        if (count == 0) fprintf(stderr, "vault: %s lists no targets\n",
+                                manifest);
+        free(t);
+        free(drives);
+        return -1;
+    }
+
+    fprintf(stderr, "vault: scanning drives...\n");
+    int drive_count = vault_installer_scan_drives(drives, VAULT_DEVICES_MAX);
+
+    for (int i = 0; i < count; i++) {
+        t[i].result = -1;
+        t[i].job.device = t[i].device;
+        t[i].job.batch = 1;
+        t[i].ready = batch_check(t, i, drives, drive_count) == 0;
+        if (!t[i].ready)
+            fprintf(stderr, "%s: SKIPPED: %s\n", t[i].device, t[i].job.error);
+    }
+
+    batch_pool_t pool;
+    pool.targets = t;
+    pool.count = count;
+    pool.next = 0;
+    vault_mutex_init(&pool.lock);
+
+    vault_thread_t threads[INSTALLER_BATCH_THREADS];
+    int nthreads = 0;
+    while (nthreads < INSTALLER_BATCH_THREADS && nthreads < count &&
+           vault_thread_create(&threads[nthreads], batch_worker, &pool) == 0)
+        nthreads++;
+    if (nthreads == 0) batch_worker(&pool);
+    for (int i = 0; i < nthreads; i++)
+        vault_thread_join(threads[i]);
+    vault_mutex_destroy(&pool.lock);
+
+    FILE *fp = report ? fopen(report, "w") : stdout;
+    if (fp) {
+        batch_report(fp, t, count);
+        if (fp != stdout) fclose(fp);
+    } else {
+        fprintf(stderr, "vault: cannot write %s: %s\n",
+                report, strerror(errno));
+    }
+
+    int failed = 0;
+    for (int i = 0; i < count; i++)
+        if (t[i].result != 0) failed++;
+    fprintf(stderr, "vault: %d of %d targets installed\n",
+            count - failed, count);
+
+    free(t);
+    free(drives);
+    return failed || !fp ? -1 : 0;
+}
+
 /* ------------------------------------------------------------------ */
 /*  Install Wizard (main orchestrator)                                 */
 /* ------------------------------------------------------------------ */
@@ -576,8 +1189,8 @@ int vault_installer_run_wizard(void)
     /* Step 1: Scan drives */
     vault_tui_status("Scanning drives...");
 
-    drive_info_t drives[16];
-    int count = vault_installer_scan_drives(drives, 16);
+    drive_info_t drives[VAULT_DEVICES_MAX];
+    int count = vault_installer_scan_drives(drives, VAULT_DEVICES_MAX);
 
     if (count == 0) {
         vault_tui_error("No target drives found!");
@@ -585,11 +1198,11 @@ int vault_installer_run_wizard(void)
     }
 
     /* Build labels for the menu */
-    const char *labels[16];
-    char label_bufs[16][256];
+    const char *labels[VAULT_DEVICES_MAX];
+    char label_bufs[VAULT_DEVICES_MAX][256];
 
     int selectable_count = 0;
-    int selectable_map[16]; /* maps menu index -> drives index */
+    int selectable_map[VAULT_DEVICES_MAX]; /* maps menu index -> drives index */
 
     for (int i = 0; i < count; i++) {
         if (drives[i].is_boot_usb) continue; /* Skip the ShredOS USB */
@@ -642,14 +1255,17 @@ int vault_installer_run_wizard(void)
     }
 
     /* Step 3: Set password */
-    char password[256];
-    if (vault_tui_new_password(password, sizeof(password)) != 0) {
+    char *password = vault_secure_alloc(VAULT_PASSWORD_MAX);
+    if (!password ||
+        vault_tui_new_password(password, VAULT_PASSWORD_MAX) != 0) {
+        vault_secure_free(password);
         vault_tui_status("Installation cancelled.");
         return -1;
     }
-    vault_auth_password_hash(password, cfg.password_hash,
+    vault_auth_password_hash(password, cfg.password_hash_ms,
+                              cfg.password_hash,
                               sizeof(cfg.password_hash));
-    vault_secure_memzero(password, sizeof(password));
+    vault_secure_free(password);
 
     /* Step 4: Set failure threshold */
     cfg.max_attempts = vault_tui_set_threshold();
@@ -50,6 +50,17 @@ detected_os_t vault_installer_detect_os(const char *partition,
 /* Run the full install wizard TUI. Returns 0 on success. */
 int vault_installer_run_wizard(void);
 
+/* Install without the TUI onto every target in manifest, several at a
+ * time. Each manifest line is a whole-disk device and the vault.conf
+ * to install there (relative to the manifest), '#' starts a comment:
+ *
+ *     /dev/sda      fleet.conf
+ *
+ * The config's target_device is set to the line's device. One JSON
+ * line per target goes to report (stdout if NULL), progress to stderr.
+ * Returns 0 if every target was installed. */
+int vault_installer_run_batch(const char *manifest, const char *report);
+
 /* Platform-specific installation routines */
 int vault_installer_install_linux(const drive_info_t *drive,
                                    const vault_config_t *cfg);
@@ -8,7 +8,9 @@
 
 #include "luks.h"
 #include "platform.h"
+#include "wipe.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -21,7 +23,14 @@
 
 #include <libcryptsetup.h>
 
+#ifdef VAULT_PLATFORM_LINUX
+#include <linux/keyctl.h>
+#include <sys/syscall.h>
+#endif
+
 #ifndef VAULT_PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <sys/ioctl.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -29,20 +38,176 @@
 
 int vault_luks_available(void) { return 1; }
 
-int vault_luks_format(const char *device, const char *passphrase)
+/* ------------------------------------------------------------------ */
+/*  Format profile                                                     */
+/* ------------------------------------------------------------------ */
+
+#ifndef BLKPBSZGET
+#define BLKPBSZGET _IO(0x12, 123)
+#endif
+
+/* Ciphers the profile builder benchmarks */
+static const struct {
+    const char *cipher;
+    const char *mode;
+    size_t      key_size;
+    size_t      iv_size;
+} profile_ciphers[] = {
+    { "aes",           "xts-plain64",      64, 16 },
+    { "xchacha12,aes", "adiantum-plain64", 32, 32 },
+    { "xchacha20,aes", "adiantum-plain64", 32, 32 },
+};
+
+#define PROFILE_BENCH_BYTES (1024 * 1024)
+
+/* Physical block size of device, 512 if unknown */
+static uint32_t device_physical_block(const char *device)
+{
+#ifndef VAULT_PLATFORM_WINDOWS
+    int fd = open(device, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 512;
+    unsigned int pbs = 0;
+    if (ioctl(fd, BLKPBSZGET, &pbs) != 0) pbs = 0;
+    close(fd);
+    return pbs >= 512 ? pbs : 512;
+#else
+    (void)device;
+    return 512;
+#endif
+}
+
+/* Split "cipher-mode" as cryptsetup writes it */
+static int set_cipher(vault_luks_profile_t *p, const char *spec)
+{
+    const char *dash = strchr(spec, '-');
+    if (!dash || dash == spec || !dash[1]) return -1;
+    size_t n = (size_t)(dash - spec);
+    if (n >= sizeof(p->cipher) || strlen(dash + 1) >= sizeof(p->cipher_mode))
+        return -1;
+    memcpy(p->cipher, spec, n);
+    p->cipher[n] = '\0';
+    strcpy(p->cipher_mode, dash + 1);
+    /* Adiantum takes a 256-bit key, XTS two of them */
+    p->key_size = strstr(p->cipher_mode, "xts") ? 64 : 32;
+    return 0;
+}
+
+/* Fastest cipher this kernel supports, by the slower of its encrypt
+ * and decrypt rates. Falls back to AES-XTS. */
+static void pick_cipher(struct crypt_device *cd, vault_luks_profile_t *p)
+{
+    double best = 0.0;
+    int pick = 0;
+    for (size_t i = 0; i < sizeof(profile_ciphers) / sizeof(profile_ciphers[0]); i++) {
+        double enc = 0.0, dec = 0.0;
+        if (crypt_benchmark(cd, profile_ciphers[i].cipher,
+                            profile_ciphers[i].mode,
+                            profile_ciphers[i].key_size,
+                            profile_ciphers[i].iv_size,
+                            PROFILE_BENCH_BYTES, &enc, &dec) < 0)
+            continue;
+        double rate = enc < dec ? enc : dec;
+        if (rate > best) { best = rate; pick = (int)i; }
+    }
+    snprintf(p->cipher, sizeof(p->cipher), "%s", profile_ciphers[pick].cipher);
+    snprintf(p->cipher_mode, sizeof(p->cipher_mode), "%s",
+             profile_ciphers[pick].mode);
+    p->key_size = profile_ciphers[pick].key_size;
+}
+
+/* Memory the keyslot may use: the configured limit, but never more
+ * than half the RAM an initramfs unlock has to work in */
+static uint32_t pbkdf_memory_limit(uint32_t limit_kb)
+{
+#ifndef VAULT_PLATFORM_WINDOWS
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page > 0) {
+        uint64_t half_kb = (uint64_t)pages * (uint64_t)page / 2048;
+        if (half_kb < limit_kb) limit_kb = (uint32_t)half_kb;
+    }
+#endif
+    return limit_kb;
+}
+
+int vault_luks_profile_build(const char *device, vault_config_t *cfg,
+                              vault_luks_profile_t *profile)
+{
+    memset(profile, 0, sizeof(*profile));
+
+    if (cfg->luks_sector_size > 0)
+        profile->sector_size = (uint32_t)cfg->luks_sector_size;
+    else
+        profile->sector_size =
+            device_physical_block(device) >= 4096 ? 4096 : 512;
+
+    struct crypt_device *cd = NULL;
+    if (crypt_init(&cd, NULL) < 0) return -1;
+
+    if (!cfg->luks_cipher[0] || set_cipher(profile, cfg->luks_cipher) != 0)
+        pick_cipher(cd, profile);
+
+    int cpus = vault_platform_cpu_count();
+    struct crypt_pbkdf_type pbkdf = {
+        .type = CRYPT_KDF_ARGON2ID,
+        .hash = "sha256",
+        .time_ms = (uint32_t)cfg->luks_unlock_ms,
+        .max_memory_kb = pbkdf_memory_limit((uint32_t)cfg->luks_pbkdf_memory_kb),
+        .parallel_threads = cpus > 4 ? 4 : (cpus > 0 ? (uint32_t)cpus : 1)
+    };
+    uint8_t salt[32];
+    vault_platform_random(salt, sizeof(salt));
+    int ret = crypt_benchmark_pbkdf(cd, &pbkdf, "vault", 5,
+                                    (const char *)salt, sizeof(salt),
+                                    profile->key_size, NULL, NULL);
+    crypt_free(cd);
+    if (ret < 0) return -1;
+
+    profile->pbkdf_iterations = pbkdf.iterations;
+    profile->pbkdf_memory_kb  = pbkdf.max_memory_kb;
+    profile->pbkdf_threads    = pbkdf.parallel_threads;
+
+    snprintf(cfg->luks_cipher, sizeof(cfg->luks_cipher), "%s-%s",
+             profile->cipher, profile->cipher_mode);
+    cfg->luks_sector_size = (int)profile->sector_size;
+    return 0;
+}
+
+int vault_luks_format(const char *device, const char *passphrase,
+                       const vault_luks_profile_t *profile)
 {
+    vault_luks_profile_t built;
+    if (!profile) {
+        vault_config_t defaults;
+        vault_config_init(&defaults);
+        if (vault_luks_profile_build(device, &defaults, &built) != 0)
+            return -1;
+        profile = &built;
+    }
+
     struct crypt_device *cd = NULL;
     int ret;
 
     ret = crypt_init(&cd, device);
     if (ret < 0) return -1;
 
+    /* Already calibrated: no second benchmark at keyslot time */
+    struct crypt_pbkdf_type pbkdf = {
+        .type = CRYPT_KDF_ARGON2ID,
+        .hash = "sha256",
+        .iterations = profile->pbkdf_iterations,
+        .max_memory_kb = profile->pbkdf_memory_kb,
+        .parallel_threads = profile->pbkdf_threads,
+        .flags = CRYPT_PBKDF_NO_BENCHMARK
+    };
+    if (crypt_set_pbkdf_type(cd, &pbkdf) < 0) { crypt_free(cd); return -1; }
+
     struct crypt_params_luks2 params = {
-        .sector_size = 512
+        .sector_size = profile->sector_size
     };
 
-    ret = crypt_format(cd, CRYPT_LUKS2, "aes", "xts-plain64",
-                       NULL, NULL, 64, &params);
+    ret = crypt_format(cd, CRYPT_LUKS2, profile->cipher, profile->cipher_mode,
+                       NULL, NULL, profile->key_size, &params);
     if (ret < 0) { crypt_free(cd); return -1; }
 
     ret = crypt_keyslot_add_by_volume_key(cd, CRYPT_ANY_SLOT, NULL, 0,
@@ -51,40 +216,112 @@ int vault_luks_format(const char *device, const char *passphrase)
     return (ret >= 0) ? 0 : -1;
 }
 
+/* Fewest iterations the header digest may use; nothing will ever be
+ * checked against it */
+#define VAULT_LUKS_THROWAWAY_ITER 1000
+
 int vault_luks_format_random_key(const char *device)
 {
-    /* Generate a random 64-byte key -- immediately discarded */
-    uint8_t key[64];
-    if (vault_platform_random(key, sizeof(key)) != 0) return -1;
-
-    char passphrase[129];
-    for (int i = 0; i < 64; i++)
-        snprintf(passphrase + i * 2, 3, "%02x", key[i]);
-
-    vault_secure_memzero(key, sizeof(key));
+    /* Generate a random 64-byte volume key -- immediately discarded */
+    const size_t key_size = 64;
+    uint8_t *key = vault_secure_alloc(key_size);
+    if (!key) return -1;
+    if (vault_platform_random(key, key_size) != 0) {
+        vault_secure_free(key);
+        return -1;
+    }
 
     struct crypt_device *cd = NULL;
     int ret = crypt_init(&cd, device);
-    if (ret < 0) { vault_secure_memzero(passphrase, sizeof(passphrase)); return -1; }
+    if (ret < 0) { vault_secure_free(key); return -1; }
+
+    /* No keyslot is added, so no Argon2 benchmark or derivation runs;
+     * the volume key digest gets the minimum PBKDF2 without a
+     * benchmark either */
+    struct crypt_pbkdf_type pbkdf = {
+        .type = CRYPT_KDF_PBKDF2,
+        .hash = "sha256",
+        .iterations = VAULT_LUKS_THROWAWAY_ITER,
+        .flags = CRYPT_PBKDF_NO_BENCHMARK
+    };
+    crypt_set_pbkdf_type(cd, &pbkdf);
 
     struct crypt_params_luks2 params = { .sector_size = 512 };
     ret = crypt_format(cd, CRYPT_LUKS2, "aes", "xts-plain64",
-                       NULL, NULL, 64, &params);
-    if (ret < 0) {
-        crypt_free(cd);
-        vault_secure_memzero(passphrase, sizeof(passphrase));
-        return -1;
+                       NULL, (const char *)key, key_size, &params);
+    crypt_free(cd);
+    vault_secure_free(key);
+    return (ret >= 0) ? 0 : -1;
+}
+
+int vault_luks_crypto_erase(const char *device)
+{
+    struct crypt_device *cd = NULL;
+    int ret = crypt_init(&cd, device);
+    if (ret < 0) return -1;
+
+    ret = crypt_load(cd, CRYPT_LUKS, NULL);
+    if (ret < 0) { crypt_free(cd); return 1; }
+
+    /* Each destroy also overwrites the slot's key material */
+    int failed = 0;
+    int nslots = crypt_keyslot_max(crypt_get_type(cd));
+    for (int i = 0; i < nslots; i++) {
+        crypt_keyslot_info st = crypt_keyslot_status(cd, i);
+        if (st == CRYPT_SLOT_INVALID || st == CRYPT_SLOT_INACTIVE) continue;
+        if (crypt_keyslot_destroy(cd, i) < 0) failed = 1;
     }
 
-    ret = crypt_keyslot_add_by_volume_key(cd, CRYPT_ANY_SLOT, NULL, 0,
-                                           passphrase, strlen(passphrase));
+    /* Everything before the data segment is header: the binary
+     * headers, both JSON areas and the keyslot area */
+    uint64_t hdr = crypt_get_data_offset(cd) * 512;
+    if (hdr > 0 &&
+        crypt_wipe(cd, NULL, CRYPT_WIPE_RANDOM, 0, hdr, 0, 0,
+                   NULL, NULL) < 0)
+        failed = 1;
+
     crypt_free(cd);
-    vault_secure_memzero(passphrase, sizeof(passphrase));
-    return (ret >= 0) ? 0 : -1;
+    return failed ? -1 : 0;
+}
+
+static const struct {
+    const char *name;
+    uint32_t    flag;
+} activate_flag_names[] = {
+    { "no_read_workqueue",      CRYPT_ACTIVATE_NO_READ_WORKQUEUE },
+    { "no_write_workqueue",     CRYPT_ACTIVATE_NO_WRITE_WORKQUEUE },
+    { "allow_discards",         CRYPT_ACTIVATE_ALLOW_DISCARDS },
+    { "same_cpu_crypt",         CRYPT_ACTIVATE_SAME_CPU_CRYPT },
+    { "submit_from_crypt_cpus", CRYPT_ACTIVATE_SUBMIT_FROM_CRYPT_CPUS },
+};
+
+uint32_t vault_luks_activate_flags(const char *spec, const char *device)
+{
+    if (!spec || !spec[0] || strcmp(spec, "auto") == 0) {
+        if (vault_wipe_is_ssd(device) != 1) return 0;
+        return CRYPT_ACTIVATE_NO_READ_WORKQUEUE |
+               CRYPT_ACTIVATE_NO_WRITE_WORKQUEUE |
+               CRYPT_ACTIVATE_ALLOW_DISCARDS;
+    }
+
+    uint32_t flags = 0;
+    const char *p = spec;
+    while (*p) {
+        size_t n = strcspn(p, ", ");
+        for (size_t i = 0; i < sizeof(activate_flag_names) /
+                               sizeof(activate_flag_names[0]); i++) {
+            if (strlen(activate_flag_names[i].name) == n &&
+                strncmp(p, activate_flag_names[i].name, n) == 0)
+                flags |= activate_flag_names[i].flag;
+        }
+        p += n;
+        while (*p == ',' || *p == ' ') p++;
+    }
+    return flags;
 }
 
 int vault_luks_open(const char *device, const char *passphrase,
-                     const char *dm_name)
+                     const char *dm_name, uint32_t flags)
 {
     struct crypt_device *cd = NULL;
     int ret = crypt_init(&cd, device);
@@ -94,11 +331,86 @@ int vault_luks_open(const char *device, const char *passphrase,
     if (ret < 0) { crypt_free(cd); return -1; }
 
     ret = crypt_activate_by_passphrase(cd, dm_name, CRYPT_ANY_SLOT,
-                                        passphrase, strlen(passphrase), 0);
+                                        passphrase, strlen(passphrase), flags);
     crypt_free(cd);
     return (ret >= 0) ? 0 : -1;
 }
 
+/* ------------------------------------------------------------------ */
+/*  Volume key in the kernel keyring                                   */
+/* ------------------------------------------------------------------ */
+
+/* libcryptsetup 2.7 links volume keys into keyrings on request */
+#ifdef CRYPT_KC_TYPE_VK_KEYRING
+
+int vault_luks_unlock_to_keyring(const char *device, const char *passphrase,
+                                  const char *key_desc)
+{
+    struct crypt_device *cd = NULL;
+    int ret = crypt_init(&cd, device);
+    if (ret < 0) return -1;
+
+    ret = crypt_load(cd, CRYPT_LUKS, NULL);
+    if (ret >= 0)
+        ret = crypt_set_keyring_to_link(cd, key_desc, NULL, "user", "@u");
+    /* No name: check the passphrase, link the key, activate nothing */
+    if (ret >= 0)
+        ret = crypt_activate_by_passphrase(cd, NULL, CRYPT_ANY_SLOT,
+                                            passphrase, strlen(passphrase),
+                                            CRYPT_ACTIVATE_KEYRING_KEY);
+    crypt_free(cd);
+    return (ret >= 0) ? 0 : -1;
+}
+
+int vault_luks_open_keyring(const char *device, const char *key_desc,
+                             const char *dm_name, uint32_t flags)
+{
+    struct crypt_device *cd = NULL;
+    int ret = crypt_init(&cd, device);
+    if (ret < 0) return -1;
+
+    ret = crypt_load(cd, CRYPT_LUKS, NULL);
+    if (ret < 0) { crypt_free(cd); return -1; }
+
+    struct crypt_keyslot_context *kc = NULL;
+    ret = crypt_keyslot_context_init_by_vk_in_keyring(cd, key_desc, &kc);
+    if (ret >= 0)
+        ret = crypt_activate_by_keyslot_context(cd, dm_name, CRYPT_ANY_SLOT,
+                                                 kc, CRYPT_ANY_SLOT, NULL,
+                                                 flags);
+    crypt_keyslot_context_free(kc);
+    crypt_free(cd);
+    return (ret >= 0) ? 0 : -1;
+}
+
+#else
+
+int vault_luks_unlock_to_keyring(const char *device, const char *passphrase,
+                                  const char *key_desc)
+{
+    (void)device; (void)passphrase; (void)key_desc; return -1;
+}
+
+int vault_luks_open_keyring(const char *device, const char *key_desc,
+                             const char *dm_name, uint32_t flags)
+{
+    (void)device; (void)key_desc; (void)dm_name; (void)flags; return -1;
+}
+
+#endif /* CRYPT_KC_TYPE_VK_KEYRING */
+
+void vault_luks_keyring_drop(const char *key_desc)
+{
+#ifdef VAULT_PLATFORM_LINUX
+    long id = syscall(SYS_request_key, "user", key_desc, NULL,
+                      KEY_SPEC_USER_KEYRING);
+    if (id >= 0)
+        syscall(SYS_keyctl, KEYCTL_INVALIDATE, id);
+#else
+    (void)key_desc;
+#endif
+}
+
 int vault_luks_close(const char *dm_name)
 {
     struct crypt_device *cd = NULL;
@@ -109,15 +421,142 @@ int vault_luks_close(const char *dm_name)
     return (ret == 0) ? 0 : -1;
 }
 
-int vault_luks_mount(const char *dm_name, const char *mount_point)
+/* ------------------------------------------------------------------ */
+/*  Mount                                                              */
+/* ------------------------------------------------------------------ */
+
+#ifndef VAULT_PLATFORM_WINDOWS
+
+/* Filesystem the superblock on dev_path belongs to, NULL if none of
+ * those the vault mounts */
+static const char *probe_fs_type(const char *dev_path)
+{
+    int fd = open(dev_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    uint8_t sb[4096];
+    const char *type = NULL;
+    if (pread(fd, sb, sizeof(sb), 0) == (ssize_t)sizeof(sb)) {
+        if (memcmp(sb, "XFSB", 4) == 0)
+            type = "xfs";
+        else if (sb[1024 + 56] == 0x53 && sb[1024 + 57] == 0xEF)
+            type = "ext4";          /* also mounts ext2 and ext3 */
+        else if (sb[1024] == 0x10 && sb[1025] == 0x20 &&
+                 sb[1026] == 0xF5 && sb[1027] == 0xF2)
+            type = "f2fs";
+    }
+    if (!type && pread(fd, sb, sizeof(sb), 65536) == (ssize_t)sizeof(sb) &&
+        memcmp(sb + 64, "_BHRfS_M", 8) == 0)
+        type = "btrfs";
+
+    close(fd);
+    return type;
+}
+
+static const struct {
+    const char    *name;
+    unsigned long  flag;
+} mount_flag_names[] = {
+    { "noatime",    MS_NOATIME },
+    { "nodiratime", MS_NODIRATIME },
+    { "relatime",   MS_RELATIME },
+#ifdef MS_LAZYTIME
+    { "lazytime",   MS_LAZYTIME },
+#endif
+    { "nodev",      MS_NODEV },
+    { "nosuid",     MS_NOSUID },
+    { "noexec",     MS_NOEXEC },
+    { "sync",       MS_SYNCHRONOUS },
+    { "ro",         MS_RDONLY },
+};
+
+/* Split mount(8)-style options into mount(2) flags and the
+ * filesystem's own option string */
+static unsigned long split_mount_options(const char *opts, char *data,
+                                         size_t data_len)
+{
+    unsigned long flags = 0;
+    size_t at = 0;
+    data[0] = '\0';
+
+    while (*opts) {
+        size_t n = strcspn(opts, ",");
+        int generic = 0;
+        for (size_t i = 0; i < sizeof(mount_flag_names) /
+                               sizeof(mount_flag_names[0]); i++) {
+            if (strlen(mount_flag_names[i].name) == n &&
+                strncmp(opts, mount_flag_names[i].name, n) == 0) {
+                flags |= mount_flag_names[i].flag;
+                generic = 1;
+            }
+        }
+        if (!generic && n > 0 && at + n + 2 <= data_len) {
+            if (at) data[at++] = ',';
+            memcpy(data + at, opts, n);
+            at += n;
+            data[at] = '\0';
+        }
+        opts += n;
+        if (*opts == ',') opts++;
+    }
+    return flags;
+}
+
+/* The "auto" option set for fs on device */
+static void auto_mount_options(const char *fs, const char *device,
+                               char *opts, size_t len)
+{
+    int ssd = device && vault_wipe_is_ssd(device) == 1;
+    const char *extra = "";
+    if (strcmp(fs, "xfs") == 0)
+        extra = ",inode64";
+    else if (ssd && strcmp(fs, "ext4") == 0)
+        extra = ",commit=30";
+    else if (ssd && strcmp(fs, "btrfs") == 0)
+        extra = ",discard=async,commit=30";
+    snprintf(opts, len, "noatime,lazytime%s", extra);
+}
+
+#endif /* !VAULT_PLATFORM_WINDOWS */
+
+int vault_luks_mount(const char *dm_name, const char *mount_point,
+                      const char *options, const char *device,
+                      char *err, size_t err_len)
 {
 #ifndef VAULT_PLATFORM_WINDOWS
     char dev_path[256];
     snprintf(dev_path, sizeof(dev_path), "/dev/mapper/%s", dm_name);
+
+    const char *fs = probe_fs_type(dev_path);
+    if (!fs) {
+        snprintf(err, err_len, "%s: no ext4, XFS, Btrfs or F2FS "
+                 "filesystem found", dev_path);
+        return -1;
+    }
+
+    char opts[256];
+    if (!options || !options[0] || strcmp(options, "auto") == 0)
+        auto_mount_options(fs, device, opts, sizeof(opts));
+    else if (strcmp(options, "none") == 0)
+        opts[0] = '\0';
+    else
+        snprintf(opts, sizeof(opts), "%s", options);
+
+    char data[256];
+    unsigned long flags = split_mount_options(opts, data, sizeof(data));
+
     mkdir(mount_point, 0700);
-    return mount(dev_path, mount_point, "ext4", 0, NULL);
+    if (mount(dev_path, mount_point, fs, flags,
+              data[0] ? data : NULL) != 0) {
+        snprintf(err, err_len, "mount %s (%s, %s) on %s: %s", dev_path,
+                 fs, opts[0] ? opts : "defaults", mount_point,
+                 strerror(errno));
+        return -1;
+    }
+    return 0;
 #else
-    (void)dm_name; (void)mount_point;
+    (void)dm_name; (void)mount_point; (void)options; (void)device;
+    snprintf(err, err_len, "mounting is not supported on this platform");
     return -1;
 #endif
 }
@@ -136,9 +575,16 @@ int vault_luks_unmount(const char *mount_point)
 
 int vault_luks_available(void) { return 0; }
 
-int vault_luks_format(const char *device, const char *passphrase)
+int vault_luks_profile_build(const char *device, vault_config_t *cfg,
+                              vault_luks_profile_t *profile)
 {
-    (void)device; (void)passphrase; return -1;
+    (void)device; (void)cfg; (void)profile; return -1;
+}
+
+int vault_luks_format(const char *device, const char *passphrase,
+                       const vault_luks_profile_t *profile)
+{
+    (void)device; (void)passphrase; (void)profile; return -1;
 }
 
 int vault_luks_format_random_key(const char *device)
@@ -146,10 +592,37 @@ int vault_luks_format_random_key(const char *device)
     (void)device; return -1;
 }
 
+int vault_luks_crypto_erase(const char *device)
+{
+    (void)device; return -1;
+}
+
+uint32_t vault_luks_activate_flags(const char *spec, const char *device)
+{
+    (void)spec; (void)device; return 0;
+}
+
 int vault_luks_open(const char *device, const char *passphrase,
-                     const char *dm_name)
+                     const char *dm_name, uint32_t flags)
 {
-    (void)device; (void)passphrase; (void)dm_name; return -1;
+    (void)device; (void)passphrase; (void)dm_name; (void)flags; return -1;
+}
+
+int vault_luks_unlock_to_keyring(const char *device, const char *passphrase,
+                                  const char *key_desc)
+{
+    (void)device; (void)passphrase; (void)key_desc; return -1;
+}
+
+int vault_luks_open_keyring(const char *device, const char *key_desc,
+                             const char *dm_name, uint32_t flags)
+{
+    (void)device; (void)key_desc; (void)dm_name; (void)flags; return -1;
+}
+
+void vault_luks_keyring_drop(const char *key_desc)
+{
+    (void)key_desc;
 }
 
 int vault_luks_close(const char *dm_name)
@@ -157,9 +630,13 @@ int vault_luks_close(const char *dm_name)
     (void)dm_name; return -1;
 }
 
-int vault_luks_mount(const char *dm_name, const char *mount_point)
+int vault_luks_mount(const char *dm_name, const char *mount_point,
+                      const char *options, const char *device,
+                      char *err, size_t err_len)
 {
-    (void)dm_name; (void)mount_point; return -1;
+    (void)dm_name; (void)mount_point; (void)options; (void)device;
+    snprintf(err, err_len, "built without libcryptsetup");
+    return -1;
 }
 
 int vault_luks_unmount(const char *mount_point)
@@ -8,33 +8,110 @@
 #define VAULT_LUKS_H
 
 #include "platform.h"
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
 
 #define VAULT_DM_NAME "vault_crypt"
 
+/* User keyring key the volume key is kept under between unlocks */
+#define VAULT_LUKS_KEY_DESC "vault:" VAULT_DM_NAME
+
+/* How a volume is formatted: cipher, dm-crypt sector size and the
+ * Argon2id cost of its keyslot. */
+typedef struct {
+    char     cipher[32];        /* "aes", "xchacha12,aes" */
+    char     cipher_mode[32];   /* "xts-plain64", "adiantum-plain64" */
+    size_t   key_size;          /* volume key bytes */
+    uint32_t sector_size;       /* dm-crypt sector bytes */
+    uint32_t pbkdf_iterations;  /* Argon2id time cost */
+    uint32_t pbkdf_memory_kb;   /* Argon2id memory cost */
+    uint32_t pbkdf_threads;     /* Argon2id lanes */
+} vault_luks_profile_t;
+
 /* Check if LUKS support is compiled in. */
 int vault_luks_available(void);
 
-/* Format a device as LUKS2 with AES-XTS-plain64.
+/* Work out how to format device. The sector size follows the device's
+ * physical block size (4096 on 4Kn drives) unless luks_sector_size
+ * sets it; the cipher is luks_cipher, or else the fastest of
+ * AES-XTS and Adiantum on this CPU by crypt_benchmark(); Argon2id is
+ * calibrated to take luks_unlock_ms within luks_pbkdf_memory_kb.
+ * The cipher and sector size chosen are written back to cfg, so a
+ * saved vault.conf keeps them and later formats skip the benchmark.
  * Returns 0 on success, -1 on failure. */
-int vault_luks_format(const char *device, const char *passphrase);
+int vault_luks_profile_build(const char *device, vault_config_t *cfg,
+                              vault_luks_profile_t *profile);
+
+/* Format a device as LUKS2 with profile, or with one built from
+ * defaults if profile is NULL.
+ * Returns 0 on success, -1 on failure. */
+int vault_luks_format(const char *device, const char *passphrase,
+                       const vault_luks_profile_t *profile);
 
 /* Format a device with a random key (for encrypt-before-wipe).
- * The key is discarded -- data is irrecoverably encrypted.
+ * The key is discarded -- data is irrecoverably encrypted. No keyslot
+ * is added, so there is no PBKDF to run: this takes milliseconds and
+ * no more memory than the header.
  * Returns 0 on success, -1 on failure. */
 int vault_luks_format_random_key(const char *device);
 
-/* Open (unlock) a LUKS device.
+/* Destroy the keys of a LUKS device: every keyslot, then the whole
+ * header area (both LUKS2 header copies and the keyslot area) with
+ * random data. The volume key is gone with them, so the data is
+ * unrecoverable after milliseconds rather than after a full wipe.
+ * Returns 0 on success, 1 if device is not LUKS, -1 on failure. */
+int vault_luks_crypto_erase(const char *device);
+
+/* dm-crypt activation flags for device from a luks_activate_flags
+ * list: "auto", "none", or comma-separated no_read_workqueue,
+ * no_write_workqueue, allow_discards, same_cpu_crypt and
+ * submit_from_crypt_cpus. "auto" bypasses the kcryptd workqueues and
+ * passes discards through on SSDs and NVMe (vault_wipe_is_ssd()), and
+ * keeps the kernel defaults on rotational disks, where the write
+ * workqueue sorts I/O into seek order.
+ * Returns CRYPT_ACTIVATE_* bits, 0 without libcryptsetup. */
+uint32_t vault_luks_activate_flags(const char *spec, const char *device);
+
+/* Open (unlock) a LUKS device with the given activation flags.
  * Returns 0 on success, -1 on failure. */
 int vault_luks_open(const char *device, const char *passphrase,
-                     const char *dm_name);
+                     const char *dm_name, uint32_t flags);
+
+/* Run the keyslot PBKDF once and keep the volume key in the user
+ * keyring as key_desc, without activating anything. Later unlocks --
+ * vault_luks_open_keyring(), or the host initramfs with
+ * "cryptsetup open --volume-key-keyring %user:vault:vault_crypt" --
+ * take the key from there and skip the PBKDF. Needs libcryptsetup 2.7.
+ * Returns 0 on success, -1 on failure. */
+int vault_luks_unlock_to_keyring(const char *device, const char *passphrase,
+                                  const char *key_desc);
+
+/* Open a LUKS device with the volume key kept by
+ * vault_luks_unlock_to_keyring().
+ * Returns 0 on success, -1 if there is no such key or it does not fit. */
+int vault_luks_open_keyring(const char *device, const char *key_desc,
+                             const char *dm_name, uint32_t flags);
+
+/* Invalidate the kept volume key, if any. */
+void vault_luks_keyring_drop(const char *key_desc);
 
 /* Close a LUKS device.
  * Returns 0 on success, -1 on failure. */
 int vault_luks_close(const char *dm_name);
 
-/* Mount a device-mapper device at mount_point.
+/* Mount a device-mapper device at mount_point as whichever of ext4,
+ * XFS, Btrfs or F2FS its superblock says it holds. options is a
+ * luks_mount_options list: "auto" for noatime and lazytime, plus
+ * inode64 on XFS and, when device (the disk under the mapping) is an
+ * SSD or NVMe, commit=30 on ext4 and Btrfs and discard=async on Btrfs;
+ * "none" for the kernel defaults; otherwise mount(8)-style options
+ * passed as they are. On failure the reason is written to err.
  * Returns 0 on success, -1 on failure. */
-int vault_luks_mount(const char *dm_name, const char *mount_point);
+int vault_luks_mount(const char *dm_name, const char *mount_point,
+                      const char *options, const char *device,
+                      char *err, size_t err_len);
 
 /* Unmount a mount point.
  * Returns 0 on success, -1 on failure. */
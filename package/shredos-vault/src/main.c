@@ -5,7 +5,10 @@
  *   (default)          -- Authentication gate
  *   --setup            -- First-run setup wizard
  *   --install-wizard   -- Install vault onto host OS drive
+ *   --install-batch M  -- Install onto every drive manifest M lists
  *   --initramfs        -- Running from initramfs (pre-boot gate)
+ *   --trace-startup    -- Log where the time to the login prompt goes
+ *   --enroll-fingerprint NAME -- Enroll a finger for the gate
  *
  * Kernel command line overrides (Linux):
  *   vault_setup        -- Enter setup mode
@@ -17,16 +20,27 @@
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* clock_gettime, sync */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "platform.h"
 #include "config.h"
 #include "auth.h"
+#include "auth_fingerprint.h"
+#include "auth_voice.h"
 #include "luks.h"
 #include "deadman.h"
+#include "events.h"
+#include "wipe_target.h"
+#ifndef VAULT_GATE_ONLY
 #include "installer.h"
+#endif
 #include "tui.h"
 
 #if !defined(VAULT_PLATFORM_WINDOWS)
@@ -43,10 +57,18 @@ static void print_usage(const char *prog)
     fprintf(stderr, "Usage: %s [OPTIONS]\n\n", prog);
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  --setup            Run first-time setup wizard\n");
+#ifndef VAULT_GATE_ONLY
     fprintf(stderr, "  --install-wizard   Install vault onto host drive\n");
+    fprintf(stderr, "  --install-batch M  Install unattended onto each drive in manifest M\n");
+    fprintf(stderr, "  --report PATH      Write the batch result JSON lines to PATH\n");
+#endif
     fprintf(stderr, "  --config PATH      Use alternate config file\n");
 #if defined(VAULT_PLATFORM_LINUX)
     fprintf(stderr, "  --initramfs        Running from initramfs\n");
+#endif
+    fprintf(stderr, "  --trace-startup    Log startup timings next to the config\n");
+#ifdef HAVE_FINGERPRINT
+    fprintf(stderr, "  --enroll-fingerprint NAME  Enroll a finger for the gate\n");
 #endif
     fprintf(stderr, "  --help             Show this help\n");
 }
@@ -76,14 +98,28 @@ static void parse_kernel_cmdline(vault_config_t *cfg,
     if (strstr(cmdline, "vault_install"))
         *install_wizard_mode = 1;
 
+    /* vault_device=<vault volume>[,<extra disk>...]: the extra disks
+     * replace wipe_devices; targets entries keep their own policies */
     char *p = strstr(cmdline, "vault_device=");
     if (p) {
         p += strlen("vault_device=");
-        int i = 0;
-        while (*p && *p != ' ' && *p != '\n' &&
-               i < (int)sizeof(cfg->target_device) - 1)
-            cfg->target_device[i++] = *p++;
-        cfg->target_device[i] = '\0';
+        int n = 0;
+        cfg->wipe_device_count = 0;
+        while (*p && *p != ' ' && *p != '\n') {
+            char *dst = n == 0 ? cfg->target_device
+                               : cfg->wipe_devices[cfg->wipe_device_count];
+            int i = 0;
+            while (*p && *p != ',' && *p != ' ' && *p != '\n') {
+                if (i < VAULT_CONFIG_MAX_PATH - 1) dst[i++] = *p;
+                p++;
+            }
+            dst[i] = '\0';
+            if (*p == ',') p++;
+            if (i == 0) continue;
+            if (n++ > 0 &&
+                ++cfg->wipe_device_count == VAULT_CONFIG_MAX_WIPE_DEVICES)
+                break;
+        }
     }
 
     p = strstr(cmdline, "vault_threshold=");
@@ -104,6 +140,7 @@ static void parse_kernel_cmdline(vault_config_t *cfg,
         else if (strcmp(alg, "dodshort") == 0) cfg->wipe_algorithm = WIPE_DOD_SHORT;
         else if (strcmp(alg, "random") == 0)  cfg->wipe_algorithm = WIPE_RANDOM;
         else if (strcmp(alg, "zero") == 0)    cfg->wipe_algorithm = WIPE_ZERO;
+        else if (strcmp(alg, "hwerase") == 0) cfg->wipe_algorithm = WIPE_HW_ERASE;
     }
 }
 
@@ -122,6 +159,31 @@ static void ensure_config_dir(void)
 #endif
 }
 
+/* Ask for the volume passphrase and leave its volume key in the kernel
+ * keyring for the host initramfs. A failure only costs the host its
+ * own prompt. */
+static void unlock_to_keyring(const vault_config_t *cfg)
+{
+    char target[VAULT_CONFIG_MAX_PATH];
+    if (vault_wipe_target_resolve(cfg->target_device, target,
+                                  sizeof(target), NULL) != 0)
+        return;
+
+    char *unlock_pass = vault_secure_alloc(VAULT_PASSWORD_MAX);
+    if (!unlock_pass) return;
+    vault_tui_status("Enter password to unlock volume:");
+    int n = vault_tui_login_screen(cfg, unlock_pass, VAULT_PASSWORD_MAX);
+    int r = -1;
+    if (n > 0) {
+        vault_tui_status("Unlocking encrypted volume...");
+        r = vault_luks_unlock_to_keyring(target, unlock_pass,
+                                          VAULT_LUKS_KEY_DESC);
+    }
+    vault_secure_free(unlock_pass);
+    if (r != 0)
+        vault_tui_status("Volume key not kept; boot will ask again.");
+}
+
 static void main_sleep(int seconds)
 {
 #if defined(VAULT_PLATFORM_WINDOWS)
@@ -131,6 +193,119 @@ static void main_sleep(int seconds)
 #endif
 }
 
+/* ------------------------------------------------------------------ */
+/*  Startup trace                                                      */
+/*                                                                     */
+/*  Each step up to the login prompt is timed; with --trace-startup    */
+/*  the breakdown is appended to startup-trace.log beside the config,  */
+/*  since the TUI owns the terminal by then.                           */
+/* ------------------------------------------------------------------ */
+
+#define TRACE_MAX 16
+
+static struct {
+    double      start;
+    double      last;
+    int         count;
+    const char *step[TRACE_MAX];
+    double      ms[TRACE_MAX];
+} trace;
+
+static double main_now_ms(void)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    LARGE_INTEGER freq, cnt;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    return (double)cnt.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+/* Milliseconds from process start to main(): mostly the dynamic loader
+ * mapping and relocating libcryptsetup, libconfig, ncurses and their
+ * dependencies. Linux only, from the start time in /proc; -1 elsewhere. */
+static double start_to_main_ms(void)
+{
+#if defined(VAULT_PLATFORM_LINUX) && defined(CLOCK_BOOTTIME)
+    FILE *fp = fopen("/proc/self/stat", "r");
+    if (!fp) return -1;
+    char buf[1024];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    /* starttime is field 22; the command name before it may hold
+     * spaces, so count from its closing parenthesis (field 2) */
+    char *p = strrchr(buf, ')');
+    if (!p) return -1;
+    unsigned long long start = 0;
+    for (int field = 2; field < 22 && p; field++)
+        p = strchr(p + 1, ' ');
+    if (!p || sscanf(p + 1, "%llu", &start) != 1) return -1;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    long hz = sysconf(_SC_CLK_TCK);
+    if (hz <= 0) return -1;
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6 -
+           (double)start * 1000.0 / (double)hz;
+#else
+    return -1;
+#endif
+}
+
+static void trace_begin(void)
+{
+    trace.start = trace.last = main_now_ms();
+    double before = start_to_main_ms();
+    if (before >= 0) {
+        trace.step[trace.count] = "start to main (loader, libraries)";
+        trace.ms[trace.count++] = before;
+    }
+}
+
+/* Close the step that ran since the previous mark. */
+static void trace_mark(const char *step)
+{
+    double now = main_now_ms();
+    if (trace.count < TRACE_MAX) {
+        trace.step[trace.count] = step;
+        trace.ms[trace.count++] = now - trace.last;
+    }
+    trace.last = now;
+}
+
+static void trace_write(const char *config_path)
+{
+    char path[VAULT_CONFIG_MAX_PATH + 32];
+    const char *slash = strrchr(config_path, '/');
+#if defined(VAULT_PLATFORM_WINDOWS)
+    const char *bslash = strrchr(config_path, '\\');
+    if (bslash && (!slash || bslash > slash)) slash = bslash;
+#endif
+    int dir_len = slash ? (int)(slash - config_path + 1) : 0;
+    snprintf(path, sizeof(path), "%.*sstartup-trace.log",
+             dir_len, config_path);
+
+    FILE *fp = fopen(path, "a");
+    FILE *out = fp ? fp : stderr;
+    time_t now = time(NULL);
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(out, "startup %s\n", when);
+    double total = 0;
+    for (int i = 0; i < trace.count; i++) {
+        fprintf(out, "  %-36s %9.2f ms\n", trace.step[i], trace.ms[i]);
+        total += trace.ms[i];
+    }
+    fprintf(out, "  %-36s %9.2f ms\n", "total to login prompt", total);
+    if (fp) fclose(fp);
+}
+
 /* ------------------------------------------------------------------ */
 /*  Main                                                               */
 /* ------------------------------------------------------------------ */
@@ -141,7 +316,11 @@ int main(int argc, char *argv[])
     const char *config_path = VAULT_CONFIG_PATH;
     int initramfs_mode = 0;
     int install_wizard_mode = 0;
+    const char *install_manifest = NULL;
+    const char *install_report = NULL;
+    int trace_startup = 0;
 
+    trace_begin();
     vault_config_init(&cfg);
 
     /* Parse CLI arguments */
@@ -150,37 +329,93 @@ int main(int argc, char *argv[])
             cfg.setup_mode = 1;
         else if (strcmp(argv[i], "--install-wizard") == 0)
             install_wizard_mode = 1;
+        else if (strcmp(argv[i], "--install-batch") == 0 && i + 1 < argc)
+            install_manifest = argv[++i];
+        else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+            install_report = argv[++i];
         else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc)
             config_path = argv[++i];
         else if (strcmp(argv[i], "--initramfs") == 0)
             initramfs_mode = 1;
+        else if (strcmp(argv[i], "--trace-startup") == 0)
+            trace_startup = 1;
+#ifdef HAVE_FINGERPRINT
+        else if (strcmp(argv[i], "--enroll-fingerprint") == 0 && i + 1 < argc)
+            return vault_auth_fingerprint_enroll(argv[++i]) == 0 ? 0 : 1;
+#endif
         else if (strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
         }
     }
 
+    trace_mark("arguments");
+
+    /* === Batch Install: no TUI, no config of its own === */
+    if (install_manifest) {
+#ifndef VAULT_GATE_ONLY
+        return vault_installer_run_batch(install_manifest,
+                                         install_report) == 0 ? 0 : 1;
+#else
+        (void)install_report;
+        fprintf(stderr, "vault: batch install runs from the ShredOS USB\n");
+        return 1;
+#endif
+    }
+
 #if defined(VAULT_PLATFORM_LINUX)
     parse_kernel_cmdline(&cfg, &install_wizard_mode);
+    trace_mark("/proc/cmdline");
 #endif
 
     /* Lock memory */
     vault_platform_lock_memory();
-
-    /* Try to load config */
-    int config_ok = vault_config_load(&cfg, config_path);
+    trace_mark("lock memory");
+
+    /* Try to load config. Early boot takes the binary snapshot when it
+     * is current and only parses vault.conf without one. */
+    int config_ok = -1;
+    if (initramfs_mode)
+        config_ok = vault_config_snapshot_load(&cfg, config_path);
+    if (config_ok == 0) {
+        trace_mark("config (snapshot)");
+    } else {
+        config_ok = vault_config_load(&cfg, config_path);
+        trace_mark("config (vault.conf, libconfig)");
+    }
 
     /* Init TUI */
     if (vault_tui_init() != 0) {
         fprintf(stderr, "vault: failed to initialise TUI\n");
         return 1;
     }
+    trace_mark("TUI init");
+
+    /* Open the reader, the microphone and their models while the login
+     * screen draws */
+    if (!install_wizard_mode && !cfg.setup_mode && config_ok == 0) {
+        if (cfg.auth_methods & AUTH_METHOD_FINGERPRINT) {
+            vault_auth_fingerprint_start();
+            trace_mark("fingerprint reader");
+        }
+        if (cfg.auth_methods & AUTH_METHOD_VOICE) {
+            vault_auth_voice_start(cfg.voice_passphrase);
+            trace_mark("voice recogniser");
+        }
+    }
 
     /* === Install Wizard Mode === */
     if (install_wizard_mode) {
+#ifndef VAULT_GATE_ONLY
         int wiz = vault_installer_run_wizard();
         vault_tui_shutdown();
         return wiz;
+#else
+        /* The host gate build carries no installer */
+        vault_tui_error("The install wizard runs from the ShredOS USB.");
+        vault_tui_shutdown();
+        return 1;
+#endif
     }
 
     /* === Setup Mode === */
@@ -203,6 +438,7 @@ int main(int argc, char *argv[])
             vault_tui_shutdown();
             return 1;
         }
+        vault_config_snapshot_save(&cfg, config_path);
 
         vault_tui_status("Configuration saved. Rebooting...");
         main_sleep(2);
@@ -224,17 +460,39 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    /* Attempts, the dead man's switch and the wipe are logged from
+     * here on; a log that cannot be opened is no reason to stop */
+    vault_events_open(cfg.event_log);
+
+    /* A dead man's switch wipe cut short by a power loss carries on
+     * before anything else is offered. Only journalled wipes leave
+     * anything to find, so without wipe_journal the disks are not
+     * probed for one. */
+    if (initramfs_mode && cfg.wipe_journal && vault_deadman_pending(&cfg)) {
+        vault_deadman_resume(&cfg);
+        vault_tui_shutdown();
+        return 1;
+    }
+    trace_mark("wipe journal check");
+
     if (!cfg.password_hash[0] && (cfg.auth_methods & AUTH_METHOD_PASSWORD)) {
         vault_tui_error("No password configured! Run with --setup");
         vault_tui_shutdown();
         return 1;
     }
 
+    if (trace_startup)
+        trace_write(config_path);
+
     /* === Authentication Loop === */
     auth_result_t result = vault_auth_run(&cfg);
 
     if (result == AUTH_SUCCESS) {
         if (initramfs_mode) {
+            /* Unlock once here; the host initramfs opens the volume
+             * with the kept key instead of asking and deriving again */
+            if (cfg.luks_keyring && vault_luks_available())
+                unlock_to_keyring(&cfg);
             vault_tui_status("Authentication successful. Resuming boot...");
             main_sleep(1);
             vault_tui_shutdown();
@@ -244,17 +502,32 @@ int main(int argc, char *argv[])
         if (vault_luks_available()) {
             vault_tui_status("Unlocking encrypted volume...");
 
-            char unlock_pass[256];
-            memset(unlock_pass, 0, sizeof(unlock_pass));
-            vault_tui_status("Enter password to unlock volume:");
-            int n = vault_tui_login_screen(&cfg, unlock_pass,
-                                            sizeof(unlock_pass));
-
+            /* A partition named by GUID needs its own node to open */
+            char target[VAULT_CONFIG_MAX_PATH];
             int lr = -1;
-            if (n > 0)
-                lr = vault_luks_open(cfg.target_device, unlock_pass,
-                                      VAULT_DM_NAME);
-            vault_secure_memzero(unlock_pass, sizeof(unlock_pass));
+            int resolved = vault_wipe_target_resolve(cfg.target_device,
+                                                      target, sizeof(target),
+                                                      NULL) == 0;
+            uint32_t flags = resolved
+                ? vault_luks_activate_flags(cfg.luks_activate_flags, target)
+                : 0;
+
+            /* A key kept by an earlier unlock needs no passphrase */
+            if (resolved && cfg.luks_keyring)
+                lr = vault_luks_open_keyring(target, VAULT_LUKS_KEY_DESC,
+                                             VAULT_DM_NAME, flags);
+
+            char *unlock_pass = lr != 0
+                ? vault_secure_alloc(VAULT_PASSWORD_MAX) : NULL;
+            if (unlock_pass) {
+                vault_tui_status("Enter password to unlock volume:");
+                int n = vault_tui_login_screen(&cfg, unlock_pass,
+                                                VAULT_PASSWORD_MAX);
+                if (n > 0 && resolved)
+                    lr = vault_luks_open(target, unlock_pass, VAULT_DM_NAME,
+                                         flags);
+                vault_secure_free(unlock_pass);
+            }
 
             if (lr != 0) {
                 vault_tui_error("Failed to unlock LUKS volume!");
@@ -265,8 +538,11 @@ int main(int argc, char *argv[])
 #if !defined(VAULT_PLATFORM_WINDOWS)
             mkdir(cfg.mount_point, 0700);
 #endif
-            if (vault_luks_mount(VAULT_DM_NAME, cfg.mount_point) != 0) {
-                vault_tui_error("Failed to mount volume!");
+            char why[512];
+            if (vault_luks_mount(VAULT_DM_NAME, cfg.mount_point,
+                                 cfg.luks_mount_options, target,
+                                 why, sizeof(why)) != 0) {
+                vault_tui_error("Failed to mount volume: %s", why);
                 vault_luks_close(VAULT_DM_NAME);
                 vault_tui_shutdown();
                 return 1;
@@ -277,6 +553,7 @@ int main(int argc, char *argv[])
             vault_tui_status("Locking volume...");
             vault_luks_unmount(cfg.mount_point);
             vault_luks_close(VAULT_DM_NAME);
+            vault_luks_keyring_drop(VAULT_LUKS_KEY_DESC);
 #if !defined(VAULT_PLATFORM_WINDOWS)
             sync();
 #endif
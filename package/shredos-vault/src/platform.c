@@ -1,17 +1,27 @@
 /*
  * platform.c -- Platform Abstraction Implementations
  *
- * CSPRNG, memory locking, secure memzero, system shutdown.
+ * CSPRNG, locked memory for secrets, secure memzero, system shutdown,
+ * CPU count, threads, aligned allocation, unmounting a disk on macOS.
  *
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* O_CLOEXEC, MAP_ANONYMOUS, syscall, sync */
+#endif
+
 #include "platform.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(VAULT_PLATFORM_WINDOWS)
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
 /* ------------------------------------------------------------------ */
 /*  Windows                                                            */
 /* ------------------------------------------------------------------ */
@@ -20,7 +30,7 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
-#include <wincrypt.h>
+#include <bcrypt.h>
 
 void vault_platform_shutdown(void)
 {
@@ -28,31 +38,31 @@ void vault_platform_shutdown(void)
     exit(0);
 }
 
-void vault_platform_lock_memory(void)
+/* The system-preferred RNG needs no provider handle to open or close,
+ * which matters for the wipe engine asking for bulk output per chunk */
+int vault_platform_random(uint8_t *buf, size_t len)
 {
-    /* Lock the working set -- best effort */
-    SIZE_T min_ws, max_ws;
-    if (GetProcessWorkingSetSize(GetCurrentProcess(), &min_ws, &max_ws)) {
-        SetProcessWorkingSetSize(GetCurrentProcess(),
-                                 min_ws + 4 * 1024 * 1024,
-                                 max_ws + 4 * 1024 * 1024);
+    while (len > 0) {
+        ULONG n = len > 0x40000000 ? 0x40000000 : (ULONG)len;
+        if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, buf, n,
+                                            BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+            return -1;
+        buf += n;
+        len -= n;
     }
+    return 0;
 }
 
-int vault_platform_random(uint8_t *buf, size_t len)
+void vault_secure_memzero(void *ptr, size_t len)
 {
-    HCRYPTPROV prov;
-    if (!CryptAcquireContextA(&prov, NULL, NULL, PROV_RSA_FULL,
-                               CRYPT_VERIFYCONTEXT))
-        return -1;
-    BOOL ok = CryptGenRandom(prov, (DWORD)len, buf);
-    CryptReleaseContext(prov, 0);
-    return ok ? 0 : -1;
+    SecureZeroMemory(ptr, len);
 }
 
-void vault_secure_memzero(void *ptr, size_t len)
+int vault_platform_cpu_count(void)
 {
-    SecureZeroMemory(ptr, len);
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
 }
 
 /* ------------------------------------------------------------------ */
@@ -64,6 +74,9 @@ void vault_secure_memzero(void *ptr, size_t len)
 #include <unistd.h>
 #include <sys/mman.h>
 #include <Security/Security.h>
+#ifdef HAVE_DISKARBITRATION
+#include <DiskArbitration/DiskArbitration.h>
+#endif
 
 void vault_platform_shutdown(void)
 {
@@ -71,12 +84,6 @@ void vault_platform_shutdown(void)
     _exit(0);
 }
 
-void vault_platform_lock_memory(void)
-{
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
-        fprintf(stderr, "vault: warning: mlockall failed\n");
-}
-
 int vault_platform_random(uint8_t *buf, size_t len)
 {
     return SecRandomCopyBytes(kSecRandomDefault, len, buf) == errSecSuccess
@@ -89,15 +96,97 @@ void vault_secure_memzero(void *ptr, size_t len)
     while (len--) *p++ = 0;
 }
 
+int vault_platform_cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/* BSD name of the disk: "/dev/rdisk2s1" -> "disk2s1" */
+static const char *bsd_name(const char *device)
+{
+    const char *name = strrchr(device, '/');
+    name = name ? name + 1 : device;
+    if (name[0] == 'r' && strncmp(name + 1, "disk", 4) == 0) name++;
+    return name;
+}
+
+#ifdef HAVE_DISKARBITRATION
+
+#define UNMOUNT_TIMEOUT 30.0            /* seconds, as diskutil waits */
+
+typedef struct {
+    int done;
+    int ok;
+} unmount_result_t;
+
+static void unmount_done(DADiskRef disk, DADissenterRef dissenter,
+                         void *context)
+{
+    unmount_result_t *r = context;
+    (void)disk;
+    r->ok = dissenter == NULL;
+    r->done = 1;
+}
+
+/* Ask diskarbitrationd directly rather than through diskutil: no shell,
+ * no child process, and a dissenter says why a volume stayed. */
+int vault_platform_unmount_disk(const char *device, int force)
+{
+    DASessionRef session = DASessionCreate(kCFAllocatorDefault);
+    if (!session) return -1;
+
+    DADiskRef disk = DADiskCreateFromBSDName(kCFAllocatorDefault, session,
+                                             bsd_name(device));
+    DADiskRef whole = disk ? DADiskCopyWholeDisk(disk) : NULL;
+    unmount_result_t r = { 0, 0 };
+
+    if (whole) {
+        DASessionScheduleWithRunLoop(session, CFRunLoopGetCurrent(),
+                                     kCFRunLoopDefaultMode);
+        DADiskUnmount(whole, kDADiskUnmountOptionWhole |
+                      (force ? kDADiskUnmountOptionForce : 0),
+                      unmount_done, &r);
+
+        CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() +
+                                  UNMOUNT_TIMEOUT;
+        while (!r.done) {
+            CFTimeInterval left = deadline - CFAbsoluteTimeGetCurrent();
+            if (left <= 0) break;
+            CFRunLoopRunInMode(kCFRunLoopDefaultMode, left, true);
+        }
+        DASessionUnscheduleFromRunLoop(session, CFRunLoopGetCurrent(),
+                                       kCFRunLoopDefaultMode);
+        CFRelease(whole);
+    }
+    if (disk) CFRelease(disk);
+    CFRelease(session);
+    return r.done && r.ok ? 0 : -1;
+}
+
+#else
+
+int vault_platform_unmount_disk(const char *device, int force)
+{
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "diskutil unmountDisk %s/dev/%s 2>/dev/null",
+             force ? "force " : "", bsd_name(device));
+    return system(cmd) == 0 ? 0 : -1;
+}
+
+#endif /* HAVE_DISKARBITRATION */
+
 /* ------------------------------------------------------------------ */
 /*  Linux                                                              */
 /* ------------------------------------------------------------------ */
 
 #else
 
+#include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 
 void vault_platform_shutdown(void)
 {
@@ -106,31 +195,312 @@ void vault_platform_shutdown(void)
     _exit(0);
 }
 
-void vault_platform_lock_memory(void)
+/* Most getrandom() returns in one call from the urandom pool */
+#define GETRANDOM_MAX (32 * 1024 * 1024 - 1)
+
+/* /dev/urandom for kernels before getrandom(), opened on first use and
+ * kept for the life of the process */
+static pthread_once_t urandom_once = PTHREAD_ONCE_INIT;
+static int urandom_fd = -1;
+
+static void urandom_open(void)
 {
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
-        fprintf(stderr, "vault: warning: mlockall failed\n");
+    urandom_fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
 }
 
-int vault_platform_random(uint8_t *buf, size_t len)
+static int urandom_read(uint8_t *buf, size_t len)
 {
-    int fd = open("/dev/urandom", O_RDONLY);
-    if (fd < 0) return -1;
+    pthread_once(&urandom_once, urandom_open);
+    if (urandom_fd < 0) return -1;
 
     size_t done = 0;
     while (done < len) {
-        ssize_t n = read(fd, buf + done, len - done);
-        if (n <= 0) { close(fd); return -1; }
+        ssize_t n = read(urandom_fd, buf + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
         done += (size_t)n;
     }
-    close(fd);
     return 0;
 }
 
+/* getrandom() needs no file descriptor, so it works before /dev is
+ * populated in an early initramfs, and costs one syscall per 32 MB */
+int vault_platform_random(uint8_t *buf, size_t len)
+{
+#ifdef SYS_getrandom
+    size_t done = 0;
+    while (done < len) {
+        size_t want = len - done;
+        if (want > GETRANDOM_MAX) want = GETRANDOM_MAX;
+        long n = syscall(SYS_getrandom, buf + done, want, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == ENOSYS && done == 0)
+            return urandom_read(buf, len);
+        if (n <= 0) return -1;
+        done += (size_t)n;
+    }
+    return 0;
+#else
+    return urandom_read(buf, len);
+#endif
+}
+
 void vault_secure_memzero(void *ptr, size_t len)
 {
     volatile unsigned char *p = (volatile unsigned char *)ptr;
     while (len--) *p++ = 0;
 }
 
+int vault_platform_cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Aligned allocation                                                 */
+/* ------------------------------------------------------------------ */
+
+#if defined(VAULT_PLATFORM_WINDOWS)
+
+/* VirtualAlloc returns page-aligned memory, which covers any sector size */
+void *vault_aligned_alloc(size_t align, size_t size)
+{
+    (void)align;
+    return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+void vault_aligned_free(void *ptr)
+{
+    if (ptr) VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+#else
+
+void *vault_aligned_alloc(size_t align, size_t size)
+{
+    void *ptr = NULL;
+    if (align < sizeof(void *)) align = sizeof(void *);
+    if (posix_memalign(&ptr, align, size) != 0) return NULL;
+    return ptr;
+}
+
+void vault_aligned_free(void *ptr)
+{
+    free(ptr);
+}
+
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Secure memory                                                      */
+/*                                                                     */
+/*  Secrets live in one small arena: locked so it is never swapped,    */
+/*  kept out of core dumps, and fenced by inaccessible guard pages so  */
+/*  an overrun faults instead of reading or writing its neighbours.    */
+/*  Everything else -- TUI, libcryptsetup's Argon2 memory, wipe        */
+/*  buffers -- stays pageable.                                         */
+/* ------------------------------------------------------------------ */
+
+#define ARENA_SIZE   (16 * 1024)
+#define ARENA_UNIT   64
+#define ARENA_UNITS  (ARENA_SIZE / ARENA_UNIT)
+
+static struct {
+    uint8_t  *base;                 /* NULL until set up, or if it failed */
+    int       tried;
+    uint16_t  run[ARENA_UNITS];     /* units allocated from here, 0 = free */
+    uint8_t   used[ARENA_UNITS];
+} arena;
+
+#if defined(VAULT_PLATFORM_WINDOWS)
+static SRWLOCK arena_lock = SRWLOCK_INIT;
+#define ARENA_LOCK()   AcquireSRWLockExclusive(&arena_lock)
+#define ARENA_UNLOCK() ReleaseSRWLockExclusive(&arena_lock)
+#else
+static pthread_mutex_t arena_lock = PTHREAD_MUTEX_INITIALIZER;
+#define ARENA_LOCK()   pthread_mutex_lock(&arena_lock)
+#define ARENA_UNLOCK() pthread_mutex_unlock(&arena_lock)
+#endif
+
+/* Map guard page, arena, guard page. Called with arena_lock held. */
+static void arena_setup(void)
+{
+    arena.tried = 1;
+#if defined(VAULT_PLATFORM_WINDOWS)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t page = si.dwPageSize;
+    uint8_t *map = (uint8_t *)VirtualAlloc(NULL, ARENA_SIZE + 2 * page,
+                                           MEM_COMMIT | MEM_RESERVE,
+                                           PAGE_READWRITE);
+    if (!map) return;
+    DWORD old;
+    VirtualProtect(map, page, PAGE_NOACCESS, &old);
+    VirtualProtect(map + page + ARENA_SIZE, page, PAGE_NOACCESS, &old);
+    if (!VirtualLock(map + page, ARENA_SIZE))
+        fprintf(stderr, "vault: warning: cannot lock secure memory\n");
+#else
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uint8_t *map = mmap(NULL, ARENA_SIZE + 2 * page, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) return;
+    mprotect(map, page, PROT_NONE);
+    mprotect(map + page + ARENA_SIZE, page, PROT_NONE);
+    if (mlock(map + page, ARENA_SIZE) != 0)
+        fprintf(stderr, "vault: warning: cannot lock secure memory\n");
+  #ifdef MADV_DONTDUMP
+    madvise(map + page, ARENA_SIZE, MADV_DONTDUMP);
+  #endif
+#endif
+    arena.base = map + page;
+}
+
+static int in_arena(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    return arena.base && p >= arena.base && p < arena.base + ARENA_SIZE;
+}
+
+void vault_platform_lock_memory(void)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    /* VirtualLock counts against the working set minimum */
+    SIZE_T min_ws, max_ws;
+    if (GetProcessWorkingSetSize(GetCurrentProcess(), &min_ws, &max_ws))
+        SetProcessWorkingSetSize(GetCurrentProcess(),
+                                 min_ws + 2 * ARENA_SIZE,
+                                 max_ws + 2 * ARENA_SIZE);
+#endif
+    ARENA_LOCK();
+    if (!arena.tried) arena_setup();
+    ARENA_UNLOCK();
+}
+
+void *vault_secure_alloc(size_t size)
+{
+    size_t units = (size + ARENA_UNIT - 1) / ARENA_UNIT;
+    if (units == 0) units = 1;
+
+    ARENA_LOCK();
+    if (!arena.tried) arena_setup();
+    void *ptr = NULL;
+    for (size_t i = 0; arena.base && i + units <= ARENA_UNITS; i++) {
+        size_t n = 0;
+        while (n < units && !arena.used[i + n]) n++;
+        if (n == units) {
+            memset(arena.used + i, 1, units);
+            arena.run[i] = (uint16_t)units;
+            ptr = arena.base + i * ARENA_UNIT;
+            break;
+        }
+        i += n;
+    }
+    ARENA_UNLOCK();
+    if (ptr) return ptr;
+
+    /* Arena full or unavailable: still hand out zeroed memory, wiped
+     * on free, just not locked */
+    fprintf(stderr, "vault: warning: secure memory exhausted\n");
+    size_t *hdr = (size_t *)calloc(1, sizeof(size_t) * 2 + size);
+    if (!hdr) return NULL;
+    hdr[0] = size;
+    return hdr + 2;
+}
+
+void vault_secure_free(void *ptr)
+{
+    if (!ptr) return;
+    if (!in_arena(ptr)) {
+        size_t *hdr = (size_t *)ptr - 2;
+        vault_secure_memzero(ptr, hdr[0]);
+        free(hdr);
+        return;
+    }
+
+    ARENA_LOCK();
+    size_t i = (size_t)((uint8_t *)ptr - arena.base) / ARENA_UNIT;
+    size_t units = arena.run[i];
+    vault_secure_memzero(ptr, units * ARENA_UNIT);
+    memset(arena.used + i, 0, units);
+    arena.run[i] = 0;
+    ARENA_UNLOCK();
+}
+
+/* ------------------------------------------------------------------ */
+/*  Threads                                                            */
+/* ------------------------------------------------------------------ */
+
+#if defined(VAULT_PLATFORM_WINDOWS)
+
+typedef struct {
+    vault_thread_fn fn;
+    void           *arg;
+} thread_start_t;
+
+static DWORD WINAPI thread_trampoline(LPVOID param)
+{
+    thread_start_t st = *(thread_start_t *)param;
+    free(param);
+    st.fn(st.arg);
+    return 0;
+}
+
+int vault_thread_create(vault_thread_t *thread, vault_thread_fn fn, void *arg)
+{
+    thread_start_t *st = (thread_start_t *)malloc(sizeof(*st));
+    if (!st) return -1;
+    st->fn = fn;
+    st->arg = arg;
+    *thread = CreateThread(NULL, 0, thread_trampoline, st, 0, NULL);
+    if (!*thread) { free(st); return -1; }
+    return 0;
+}
+
+void vault_thread_join(vault_thread_t thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+void vault_mutex_init(vault_mutex_t *m)    { InitializeSRWLock(m); }
+void vault_mutex_destroy(vault_mutex_t *m) { (void)m; }
+void vault_mutex_lock(vault_mutex_t *m)    { AcquireSRWLockExclusive(m); }
+void vault_mutex_unlock(vault_mutex_t *m)  { ReleaseSRWLockExclusive(m); }
+
+void vault_cond_init(vault_cond_t *c)      { InitializeConditionVariable(c); }
+void vault_cond_destroy(vault_cond_t *c)   { (void)c; }
+void vault_cond_wait(vault_cond_t *c, vault_mutex_t *m)
+{
+    SleepConditionVariableSRW(c, m, INFINITE, 0);
+}
+void vault_cond_broadcast(vault_cond_t *c) { WakeAllConditionVariable(c); }
+
+#else /* POSIX */
+
+int vault_thread_create(vault_thread_t *thread, vault_thread_fn fn, void *arg)
+{
+    return pthread_create(thread, NULL, fn, arg) == 0 ? 0 : -1;
+}
+
+void vault_thread_join(vault_thread_t thread)
+{
+    pthread_join(thread, NULL);
+}
+
+void vault_mutex_init(vault_mutex_t *m)    { pthread_mutex_init(m, NULL); }
+void vault_mutex_destroy(vault_mutex_t *m) { pthread_mutex_destroy(m); }
+void vault_mutex_lock(vault_mutex_t *m)    { pthread_mutex_lock(m); }
+void vault_mutex_unlock(vault_mutex_t *m)  { pthread_mutex_unlock(m); }
+
+void vault_cond_init(vault_cond_t *c)      { pthread_cond_init(c, NULL); }
+void vault_cond_destroy(vault_cond_t *c)   { pthread_cond_destroy(c); }
+void vault_cond_wait(vault_cond_t *c, vault_mutex_t *m)
+{
+    pthread_cond_wait(c, m);
+}
+void vault_cond_broadcast(vault_cond_t *c) { pthread_cond_broadcast(c); }
+
 #endif
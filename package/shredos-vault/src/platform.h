@@ -36,7 +36,10 @@
 /*  HAVE_FINGERPRINT    -- libfprint fingerprint reader                */
 /*  HAVE_VOICE          -- PocketSphinx + PortAudio voice auth         */
 /*  HAVE_IOKIT          -- macOS IOKit framework                       */
+/*  HAVE_DISKARBITRATION -- macOS DiskArbitration framework            */
 /*  HAVE_CRYPT_H        -- POSIX crypt() function                      */
+/*  HAVE_LIBURING       -- liburing async I/O for the wipe engine      */
+/*  VAULT_GATE_ONLY     -- host gate build: no install wizard          */
 /* ------------------------------------------------------------------ */
 
 /* Config backend selection */
@@ -84,9 +87,21 @@
 /* Initiate system power off. Does not return on success. */
 void vault_platform_shutdown(void);
 
-/* Lock all memory pages to prevent swapping sensitive data. */
+/* Set up the locked, guard-paged arena secrets are kept in. Only the
+ * arena is locked; everything else stays pageable. */
 void vault_platform_lock_memory(void);
 
+/* Bytes in a password buffer, terminator included */
+#define VAULT_PASSWORD_MAX 256
+
+/* Zeroed memory for a secret (password, key) from the locked arena.
+ * If the arena is full or could not be set up, the memory is ordinary
+ * heap, still zeroed on free. Returns NULL only if out of memory. */
+void *vault_secure_alloc(size_t size);
+
+/* Zero and release memory from vault_secure_alloc(). NULL is ignored. */
+void  vault_secure_free(void *ptr);
+
 /* Fill buffer with cryptographically secure random bytes.
  * Returns 0 on success, -1 on failure. */
 int vault_platform_random(uint8_t *buf, size_t len);
@@ -94,4 +109,57 @@ int vault_platform_random(uint8_t *buf, size_t len);
 /* Securely zero memory (prevents compiler optimisation). */
 void vault_secure_memzero(void *ptr, size_t len);
 
+/* Number of online CPUs (at least 1). */
+int vault_platform_cpu_count(void);
+
+/* Allocate size bytes aligned to align (a power of two), suitable for
+ * unbuffered device I/O. Free with vault_aligned_free(). */
+void *vault_aligned_alloc(size_t align, size_t size);
+void  vault_aligned_free(void *ptr);
+
+#if defined(VAULT_PLATFORM_MACOS)
+/* Unmount every volume on the disk holding device (/dev/diskN,
+ * /dev/rdiskNsM, ...), forcibly if force is set, so it can be opened
+ * for writing. Returns 0 once nothing on it is mounted, -1 if a volume
+ * refused or the request timed out. */
+int vault_platform_unmount_disk(const char *device, int force);
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Threads                                                            */
+/*                                                                     */
+/*  Thin wrappers over pthreads / Win32 so worker code stays portable. */
+/* ------------------------------------------------------------------ */
+
+#if defined(VAULT_PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+  typedef HANDLE             vault_thread_t;
+  typedef SRWLOCK            vault_mutex_t;
+  typedef CONDITION_VARIABLE vault_cond_t;
+#else
+  #include <pthread.h>
+  typedef pthread_t          vault_thread_t;
+  typedef pthread_mutex_t    vault_mutex_t;
+  typedef pthread_cond_t     vault_cond_t;
+#endif
+
+typedef void *(*vault_thread_fn)(void *arg);
+
+/* Start a thread running fn(arg). Returns 0 on success, -1 on failure. */
+int  vault_thread_create(vault_thread_t *thread, vault_thread_fn fn, void *arg);
+
+/* Wait for a thread to finish. */
+void vault_thread_join(vault_thread_t thread);
+
+void vault_mutex_init(vault_mutex_t *m);
+void vault_mutex_destroy(vault_mutex_t *m);
+void vault_mutex_lock(vault_mutex_t *m);
+void vault_mutex_unlock(vault_mutex_t *m);
+
+void vault_cond_init(vault_cond_t *c);
+void vault_cond_destroy(vault_cond_t *c);
+void vault_cond_wait(vault_cond_t *c, vault_mutex_t *m);
+void vault_cond_broadcast(vault_cond_t *c);
+
 #endif /* VAULT_PLATFORM_H */
@@ -0,0 +1,247 @@
+/*
+ * services.c -- Periodic Services
+ *
+ * The thread wakes every SERVICES_TICK_MS and runs whatever is due, in
+ * table order. Jobs such as a wipe checkpoint sync to busy disks, and
+ * one that stalls holds up every job behind it, whatever its place in
+ * the table. So the watchdog is not a job: it is fed from a thread of
+ * its own that touches nothing but the watchdog device.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* O_CLOEXEC */
+#endif
+
+#include "services.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(VAULT_PLATFORM_LINUX)
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/ioctl.h>
+  #include <linux/watchdog.h>
+#endif
+
+#define SERVICES_TICK_MS        200
+#define WATCHDOG_TIMEOUT_DEFAULT 30     /* if the driver will not say */
+
+typedef struct {
+    vault_service_fn fn;
+    void    *arg;
+    double   interval;
+    double   next;
+} service_t;
+
+static struct {
+    vault_mutex_t lock;
+    vault_cond_t  idle;         /* busy has changed */
+    vault_thread_t thread;
+    int       running;
+    int       busy;             /* handle being called, -1 = none */
+    service_t jobs[VAULT_SERVICES_MAX];
+} svc;
+
+static double now_secs(void)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    return (double)GetTickCount64() / 1000.0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static void sleep_ms(long ms)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    Sleep((DWORD)ms);
+#else
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+#endif
+}
+
+static void *services_thread(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        double now = now_secs();
+        vault_service_fn fn = NULL;
+        void *fn_arg = NULL;
+
+        vault_mutex_lock(&svc.lock);
+        for (int i = 0; i < VAULT_SERVICES_MAX && !fn; i++) {
+            service_t *s = &svc.jobs[i];
+            if (!s->fn || now < s->next) continue;
+            fn = s->fn;
+            fn_arg = s->arg;
+            s->next = now + s->interval;
+            svc.busy = i;
+        }
+        vault_mutex_unlock(&svc.lock);
+
+        if (!fn) {
+            sleep_ms(SERVICES_TICK_MS);
+            continue;
+        }
+        fn(fn_arg);
+
+        vault_mutex_lock(&svc.lock);
+        svc.busy = -1;
+        vault_cond_broadcast(&svc.idle);
+        vault_mutex_unlock(&svc.lock);
+    }
+    return NULL;
+}
+
+int vault_services_start(void)
+{
+    if (svc.running) return 0;
+    vault_mutex_init(&svc.lock);
+    vault_cond_init(&svc.idle);
+    svc.busy = -1;
+    if (vault_thread_create(&svc.thread, services_thread, NULL) != 0) {
+        vault_cond_destroy(&svc.idle);
+        vault_mutex_destroy(&svc.lock);
+        return -1;
+    }
+    svc.running = 1;
+    return 0;
+}
+
+int vault_services_running(void)
+{
+    return svc.running;
+}
+
+int vault_services_add(vault_service_fn fn, void *arg, double interval)
+{
+    if (!svc.running || !fn) return -1;
+
+    int handle = -1;
+    vault_mutex_lock(&svc.lock);
+    for (int i = 0; i < VAULT_SERVICES_MAX && handle < 0; i++) {
+        if (svc.jobs[i].fn) continue;
+        svc.jobs[i] = (service_t) {
+            .fn = fn, .arg = arg, .interval = interval,
+            .next = now_secs() + interval
+        };
+        handle = i;
+    }
+    vault_mutex_unlock(&svc.lock);
+    return handle;
+}
+
+void vault_services_remove(int handle)
+{
+    if (!svc.running || handle < 0 || handle >= VAULT_SERVICES_MAX) return;
+    vault_mutex_lock(&svc.lock);
+    memset(&svc.jobs[handle], 0, sizeof(svc.jobs[handle]));
+    while (svc.busy == handle)
+        vault_cond_wait(&svc.idle, &svc.lock);
+    vault_mutex_unlock(&svc.lock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Watchdog                                                           */
+/*                                                                     */
+/*  Opening a watchdog device starts it, and closing it without the    */
+/*  magic 'V' leaves it running, so the fd is held for good: if the    */
+/*  vault dies mid-wipe the machine resets, and a journalled wipe      */
+/*  picks up again at the next boot. The thread feeding it is never    */
+/*  joined either, and does no I/O that a busy disk could stall.       */
+/* ------------------------------------------------------------------ */
+
+#if defined(VAULT_PLATFORM_LINUX)
+
+static int watchdog_fd = -1;
+static long watchdog_every_ms;
+static vault_thread_t watchdog_tid;
+
+static void watchdog_feed(void)
+{
+    if (ioctl(watchdog_fd, WDIOC_KEEPALIVE, 0) != 0) {
+        ssize_t n = write(watchdog_fd, "\0", 1);
+        (void)n;
+    }
+}
+
+static void *watchdog_thread(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        sleep_ms(watchdog_every_ms);
+        watchdog_feed();
+    }
+    return NULL;
+}
+
+/* The sysfs state of the first watchdog: 1 if it is already running */
+static int watchdog_active(void)
+{
+    FILE *fp = fopen("/sys/class/watchdog/watchdog0/state", "r");
+    if (!fp) return 0;
+    char state[16] = "";
+    int active = fgets(state, sizeof(state), fp) &&
+                 strncmp(state, "active", 6) == 0;
+    fclose(fp);
+    return active;
+}
+
+int vault_services_watchdog(const char *spec)
+{
+    if (watchdog_fd >= 0) return 1;
+    if (!spec || !spec[0] || strcmp(spec, "off") == 0) return 0;
+
+    const char *path = spec;
+    if (strcmp(spec, "auto") == 0) {
+        if (!watchdog_active()) return 0;
+        path = "/dev/watchdog0";
+    }
+
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "services: cannot open watchdog %s: %s\n", path,
+                strerror(errno));
+        return -1;
+    }
+    int timeout = 0;
+    if (ioctl(fd, WDIOC_GETTIMEOUT, &timeout) != 0 || timeout <= 0)
+        timeout = WATCHDOG_TIMEOUT_DEFAULT;
+
+    watchdog_fd = fd;
+    watchdog_feed();
+    double every = timeout / 3.0;
+    if (every < 1.0) every = 1.0;
+    watchdog_every_ms = (long)(every * 1000.0);
+    if (vault_thread_create(&watchdog_tid, watchdog_thread, NULL) != 0) {
+        /* Left open would reset the machine with nobody feeding it */
+        ssize_t n = write(fd, "V", 1);
+        (void)n;
+        close(fd);
+        watchdog_fd = -1;
+        return -1;
+    }
+    fprintf(stderr, "services: feeding watchdog %s every %.0f s "
+            "(timeout %d s)\n", path, every, timeout);
+    return 1;
+}
+
+#else /* !VAULT_PLATFORM_LINUX */
+
+int vault_services_watchdog(const char *spec)
+{
+    (void)spec;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * services.h -- Periodic Services
+ *
+ * One background thread that runs small jobs on their own schedules
+ * while a wipe holds every other thread in long I/O loops: taking wipe
+ * checkpoints, flushing telemetry and the event log. Nothing here is
+ * on a write path, but a job that blocks delays every other job until
+ * it returns. The hardware watchdog, which must never wait on a disk,
+ * is fed from a thread of its own instead.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_SERVICES_H
+#define VAULT_SERVICES_H
+
+#define VAULT_SERVICES_MAX  16
+
+typedef void (*vault_service_fn)(void *arg);
+
+/* Start the services thread, if not already running. It runs until
+ * the process ends. Returns 0, or -1 if it cannot start; callers then
+ * do their periodic work themselves. */
+int vault_services_start(void);
+
+/* 1 once vault_services_start() has succeeded. */
+int vault_services_running(void);
+
+/* Call fn(arg) on the services thread every interval seconds, the first
+ * time one interval from now. Returns a handle, or -1 if the thread is
+ * not running or the table is full. */
+int vault_services_add(vault_service_fn fn, void *arg, double interval);
+
+/* Stop calling handle. Waits out a call in progress, so whatever arg
+ * points to may go once this returns. -1 is ignored. */
+void vault_services_remove(int handle);
+
+/* Keep a hardware watchdog from resetting the machine. spec is "auto"
+ * (the first watchdog, only if firmware or the kernel has already
+ * started it), "off", or a device such as /dev/watchdog1, which is
+ * started if it was not. Fed at a third of its timeout by a thread of
+ * its own, so it needs neither vault_services_start() nor any job to
+ * be quick. Linux only.
+ * Returns 1 if a watchdog is being fed, 0 if none is, -1 on error. */
+int vault_services_watchdog(const char *spec);
+
+#endif /* VAULT_SERVICES_H */
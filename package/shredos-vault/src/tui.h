@@ -12,6 +12,7 @@
 
 #include "config.h"
 #include <stdarg.h>
+#include <stdint.h>
 
 /* Initialise the TUI. Returns 0 on success. */
 int vault_tui_init(void);
@@ -19,8 +20,14 @@ int vault_tui_init(void);
 /* Shut down the TUI and restore terminal state. */
 void vault_tui_shutdown(void);
 
-/* Show the login screen and read password.
- * Returns number of chars read, or -1 on error. */
+/* Show the login screen and read password, while also waiting on
+ * vault_auth_fingerprint_fd() and vault_auth_voice_fd() when they are
+ * running; with a microphone, Tab starts listening for the passphrase.
+ * Returns number of chars read, -1 on error, or
+ * VAULT_TUI_LOGIN_FINGERPRINT / VAULT_TUI_LOGIN_VOICE if that verdict
+ * came in first; the password typed so far is then discarded. */
+#define VAULT_TUI_LOGIN_FINGERPRINT (-2)
+#define VAULT_TUI_LOGIN_VOICE       (-3)
 int vault_tui_login_screen(const vault_config_t *cfg,
                             char *password_out, size_t password_size);
 
@@ -36,6 +43,43 @@ void vault_tui_deadman_warning(int countdown_seconds);
 /* Show the wipe-in-progress screen. */
 void vault_tui_wiping_screen(const char *device, const char *algorithm_name);
 
+/* Show the wiping dashboard for count targets: the warning, the
+ * algorithm, and column headings for the rows that
+ * vault_tui_dashboard_draw() fills in. */
+void vault_tui_dashboard_screen(const char *algorithm_name, int count);
+
+/* One target's row on the dashboard */
+typedef struct {
+    const char *device;
+    const char *pass;           /* "Pass 3/7: 0x55", "" before the first */
+    double      pass_frac;      /* Of the current pass, 0-1 */
+    double      total_frac;     /* Of the whole wipe, 0-1 */
+    double      mbps;
+    double      eta_secs;       /* Whole wipe, < 0 = unknown */
+    uint64_t    bytes_skipped;  /* Unwritable, left out of the wipe */
+    int         verifying;      /* Reading the pass back */
+    int         state;          /* 0 running, 1 wiped, -1 failed */
+} vault_tui_progress_row_t;
+
+/* One dashboard frame */
+typedef struct {
+    const vault_tui_progress_row_t *rows;
+    int           count;
+    double        total_mbps;   /* Sum over running targets */
+    const float  *history;      /* total_mbps once a second, oldest
+                                 * first; drawn on wide terminals */
+    int           history_len;
+} vault_tui_dashboard_t;
+
+/* Draw the rows under vault_tui_dashboard_screen(), each with a bar for
+ * its current pass. Only tui_progress.c calls this, from its render
+ * thread. */
+void vault_tui_dashboard_draw(const vault_tui_dashboard_t *d);
+
+/* Show that a password is being verified, frame counting up from 0
+ * every ~100 ms to animate it. A negative frame clears it. */
+void vault_tui_verifying(int frame);
+
 /* Display a status message. */
 void vault_tui_status(const char *fmt, ...);
 
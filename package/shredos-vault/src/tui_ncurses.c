@@ -9,7 +9,11 @@
 #ifdef HAVE_NCURSES
 
 #include "tui.h"
+#include "tui_progress.h"
+#include "devices.h"
 #include "auth_password.h"
+#include "auth_fingerprint.h"
+#include "auth_voice.h"
 #include "luks.h"
 
 #include <ncurses.h>
@@ -18,9 +22,9 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <unistd.h>
-#include <dirent.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <poll.h>
 
 /* Colour pairs */
 #define CP_NORMAL   1
@@ -104,7 +108,11 @@ void vault_tui_shutdown(void)
 /*  Masked password input                                              */
 /* ------------------------------------------------------------------ */
 
-static int read_password_masked(int y, int x, char *out, int max_len)
+/* Read a masked password at y, x. At login, give up and return
+ * VAULT_TUI_LOGIN_FINGERPRINT or VAULT_TUI_LOGIN_VOICE as soon as that
+ * backend has a verdict. */
+static int read_password_masked(int y, int x, char *out, int max_len,
+                                int login)
 {
     int pos = 0;
     int ch;
@@ -114,9 +122,30 @@ static int read_password_masked(int y, int x, char *out, int max_len)
     move(y, x);
 
     while (1) {
+        if (login) {
+            /* poll() skips the backends that are not running (fd -1) */
+            struct pollfd fds[3] = {
+                { STDIN_FILENO, POLLIN, 0 },
+                { vault_auth_fingerprint_fd(), POLLIN, 0 },
+                { vault_auth_voice_fd(), POLLIN, 0 },
+            };
+            if (poll(fds, 3, -1) > 0 &&
+                ((fds[1].revents | fds[2].revents) & POLLIN)) {
+                vault_secure_memzero(out, (size_t)max_len + 1);
+                curs_set(0);
+                return (fds[1].revents & POLLIN)
+                    ? VAULT_TUI_LOGIN_FINGERPRINT : VAULT_TUI_LOGIN_VOICE;
+            }
+        }
         ch = getch();
         if (ch == '\n' || ch == '\r' || ch == KEY_ENTER)
             break;
+        if (login && ch == '\t' && vault_auth_voice_fd() >= 0) {
+            vault_auth_voice_listen();
+            vault_tui_status("Listening... say the passphrase");
+            move(y, x + pos);
+            continue;
+        }
         if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {
             if (pos > 0) {
                 pos--;
@@ -168,6 +197,18 @@ int vault_tui_login_screen(const vault_config_t *cfg,
     mvprintw(boxy - 1, boxx, " Password: ");
     attroff(COLOR_PAIR(CP_INPUT));
 
+    const char *hints[2] = { NULL, NULL };
+    int nh = 0;
+    if (vault_auth_fingerprint_fd() >= 0)
+        hints[nh++] = "or touch the fingerprint reader";
+    if (vault_auth_voice_fd() >= 0)
+        hints[nh++] = "or press Tab and say the passphrase";
+    attron(COLOR_PAIR(CP_NORMAL));
+    for (int i = 0; i < nh; i++)
+        mvprintw(boxy + 4 + i, (COLS - (int)strlen(hints[i])) / 2, "%s",
+                 hints[i]);
+    attroff(COLOR_PAIR(CP_NORMAL));
+
     /* Footer */
     int fy = LINES - 2;
     attron(COLOR_PAIR(CP_STATUS));
@@ -179,7 +220,7 @@ int vault_tui_login_screen(const vault_config_t *cfg,
 
     int max = (int)password_size - 1;
     if (max > boxw - 4) max = boxw - 4;
-    return read_password_masked(boxy + 1, boxx + 2, password_out, max);
+    return read_password_masked(boxy + 1, boxx + 2, password_out, max, 1);
 }
 
 /* ------------------------------------------------------------------ */
@@ -206,12 +247,16 @@ int vault_tui_setup_screen(vault_config_t *cfg)
         return -1;
 
     /* Step 2: Set password */
-    char password[256];
-    if (vault_tui_new_password(password, sizeof(password)) != 0)
+    char *password = vault_secure_alloc(VAULT_PASSWORD_MAX);
+    if (!password ||
+        vault_tui_new_password(password, VAULT_PASSWORD_MAX) != 0) {
+        vault_secure_free(password);
         return -1;
-    vault_auth_password_hash(password, cfg->password_hash,
+    }
+    vault_auth_password_hash(password, cfg->password_hash_ms,
+                              cfg->password_hash,
                               sizeof(cfg->password_hash));
-    vault_secure_memzero(password, sizeof(password));
+    vault_secure_free(password);
 
     /* Step 3: Set threshold */
     cfg->max_attempts = vault_tui_set_threshold();
@@ -338,6 +383,75 @@ void vault_tui_wiping_screen(const char *device, const char *algorithm_name)
     refresh();
 }
 
+/* ------------------------------------------------------------------ */
+/*  Wipe Dashboard                                                     */
+/* ------------------------------------------------------------------ */
+
+#define DASH_TOP 6      /* headings; rows below, then the total */
+
+void vault_tui_dashboard_screen(const char *algorithm_name, int count)
+{
+    clear();
+
+    attron(COLOR_PAIR(CP_DANGER) | A_BOLD);
+    const char *msg = "WIPING IN PROGRESS";
+    mvprintw(1, (COLS - (int)strlen(msg)) / 2, "%s", msg);
+    attroff(COLOR_PAIR(CP_DANGER) | A_BOLD);
+
+    mvprintw(3, 2, "Algorithm: %s    Drives: %d", algorithm_name, count);
+    mvprintw(4, 2, "Do NOT power off. This may take a long time.");
+    refresh();
+}
+
+/* Headings, one row per target, then the total with its sparkline on
+ * wide terminals; the rows stop short of the status line */
+void vault_tui_dashboard_draw(const vault_tui_dashboard_t *d)
+{
+    int bar = COLS - 72;
+    if (bar > 40) bar = 40;
+    if (bar < 8) bar = 8;
+
+    attron(A_BOLD);
+    mvprintw(DASH_TOP, 2, "%-12s %-16s %*s %s", "DEVICE", "PASS",
+             bar + 2, "", VAULT_TUI_PROGRESS_COLUMNS);
+    attroff(A_BOLD);
+
+    int y = DASH_TOP + 1;
+    for (int i = 0; i < d->count && y < LINES - 5; i++, y++) {
+        const vault_tui_progress_row_t *r = &d->rows[i];
+        char fill[41], stats[64];
+        vault_tui_progress_bar(r->pass_frac, bar, fill);
+        vault_tui_progress_format(r, stats, sizeof(stats));
+
+        move(y, 0);
+        clrtoeol();
+        mvprintw(y, 2, "%-12.12s %-16.16s [", r->device, r->pass);
+        int cp = r->state < 0 ? CP_ERROR : r->state > 0 ? CP_SUCCESS
+                                                        : CP_DANGER;
+        attron(COLOR_PAIR(cp));
+        printw("%s", fill);
+        attroff(COLOR_PAIR(cp));
+        printw("] ");
+        if (r->state != 0) attron(COLOR_PAIR(cp) | A_BOLD);
+        printw("%s", stats);
+        if (r->state != 0) attroff(COLOR_PAIR(cp) | A_BOLD);
+    }
+
+    move(y + 1, 0);
+    clrtoeol();
+    mvprintw(y + 1, 2, "Total %5.0f MB/s", d->total_mbps);
+    if (COLS >= VAULT_TUI_PROGRESS_WIDE) {
+        char spark[VAULT_TUI_PROGRESS_HISTORY + 1];
+        int w = COLS - 26;
+        if (w > VAULT_TUI_PROGRESS_HISTORY) w = VAULT_TUI_PROGRESS_HISTORY;
+        vault_tui_progress_sparkline(d->history, d->history_len, w, spark);
+        attron(COLOR_PAIR(CP_SUCCESS));
+        printw("   %s", spark);
+        attroff(COLOR_PAIR(CP_SUCCESS));
+    }
+    refresh();
+}
+
 /* ------------------------------------------------------------------ */
 /*  Status / Error                                                     */
 /* ------------------------------------------------------------------ */
@@ -358,6 +472,18 @@ void vault_tui_status(const char *fmt, ...)
     refresh();
 }
 
+void vault_tui_verifying(int frame)
+{
+    static const char spin[] = "|/-\\";
+    int y = LINES - 3;
+    attron(COLOR_PAIR(CP_STATUS));
+    mvhline(y, 0, ' ', COLS);
+    if (frame >= 0)
+        mvprintw(y, 2, "Verifying password... %c", spin[frame % 4]);
+    attroff(COLOR_PAIR(CP_STATUS));
+    refresh();
+}
+
 void vault_tui_error(const char *fmt, ...)
 {
     va_list ap;
@@ -383,77 +509,75 @@ void vault_tui_error(const char *fmt, ...)
 
 int vault_tui_select_device(char *device_out, size_t device_size)
 {
-    DIR *dir = opendir("/sys/block");
-    if (!dir) {
+    const vault_devices_t *inv = vault_devices_get();
+    if (!inv) {
         vault_tui_error("Cannot read /sys/block");
         return -1;
     }
-
-    char devices[32][64];
-    char sizes[32][32];
-    int count = 0;
-
-    struct dirent *ent;
-    while ((ent = readdir(dir)) && count < 32) {
-        if (strncmp(ent->d_name, "loop", 4) == 0) continue;
-        if (strncmp(ent->d_name, "ram", 3) == 0) continue;
-        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
-            continue;
-
-        snprintf(devices[count], sizeof(devices[count]),
-                 "/dev/%s", ent->d_name);
-
-        char spath[256];
-        snprintf(spath, sizeof(spath), "/sys/block/%s/size", ent->d_name);
-        FILE *sf = fopen(spath, "r");
-        if (sf) {
-            unsigned long long sectors = 0;
-            if (fscanf(sf, "%llu", &sectors) == 1) {
-                double gb = (double)(sectors * 512) / (1024.0 * 1024.0 * 1024.0);
-                snprintf(sizes[count], sizeof(sizes[count]), "%.1f GB", gb);
-            }
-            fclose(sf);
-        } else {
-            strncpy(sizes[count], "? GB", sizeof(sizes[count]) - 1);
-        }
-        count++;
-    }
-    closedir(dir);
-
-    if (count == 0) {
+    if (inv->count == 0) {
         vault_tui_error("No block devices found!");
         return -1;
     }
 
-    int sel = 0;
+    /* Wake up now and then to pick up disks plugged in or pulled */
+    timeout(250);
+    int sel = 0, redraw = 1;
+    char chosen[sizeof(inv->devices[0].path)] = "";
     while (1) {
-        clear();
-        draw_banner(1);
-        int y = 9;
-
-        attron(COLOR_PAIR(CP_TITLE) | A_BOLD);
-        mvprintw(y++, 4, "Select target device:");
-        attroff(COLOR_PAIR(CP_TITLE) | A_BOLD);
-        y++;
+        if (redraw) {
+            clear();
+            draw_banner(1);
+            int y = 9;
+
+            attron(COLOR_PAIR(CP_TITLE) | A_BOLD);
+            mvprintw(y++, 4, "Select target device:");
+            attroff(COLOR_PAIR(CP_TITLE) | A_BOLD);
+            y++;
+
+            for (int i = 0; i < inv->count; i++) {
+                char label[160];
+                vault_devices_label(&inv->devices[i], label, sizeof(label));
+                if (i == sel) attron(COLOR_PAIR(CP_INPUT) | A_REVERSE);
+                mvprintw(y + i, 6, "  %-60.60s  ", label);
+                if (i == sel) attroff(COLOR_PAIR(CP_INPUT) | A_REVERSE);
+            }
+            if (inv->count == 0)
+                mvprintw(y, 8, "(no drives attached)");
 
-        for (int i = 0; i < count; i++) {
-            if (i == sel) attron(COLOR_PAIR(CP_INPUT) | A_REVERSE);
-            mvprintw(y + i, 6, "  %-20s  %s  ", devices[i], sizes[i]);
-            if (i == sel) attroff(COLOR_PAIR(CP_INPUT) | A_REVERSE);
+            mvprintw(y + (inv->count ? inv->count : 1) + 2, 4,
+                     "UP/DOWN to select, ENTER to confirm, 'q' to cancel");
+            refresh();
+            redraw = 0;
         }
 
-        mvprintw(y + count + 2, 4,
-                 "UP/DOWN to select, ENTER to confirm, 'q' to cancel");
-        refresh();
-
         int ch = getch();
+        if (ch == ERR) {
+            /* Keep the cursor on the same disk if it is still there */
+            char was[sizeof(inv->devices[0].name)] = "";
+            if (sel < inv->count)
+                snprintf(was, sizeof(was), "%s", inv->devices[sel].name);
+            if (!vault_devices_refresh()) continue;
+            const vault_device_t *d = vault_devices_find(was);
+            sel = d ? (int)(d - inv->devices) : 0;
+            redraw = 1;
+            continue;
+        }
+        redraw = 1;
         if (ch == KEY_UP && sel > 0) sel--;
-        else if (ch == KEY_DOWN && sel < count - 1) sel++;
-        else if (ch == '\n' || ch == '\r' || ch == KEY_ENTER) break;
-        else if (ch == 'q' || ch == 'Q') return -1;
+        else if (ch == KEY_DOWN && sel < inv->count - 1) sel++;
+        else if ((ch == '\n' || ch == '\r' || ch == KEY_ENTER) &&
+                 inv->count > 0) {
+            snprintf(chosen, sizeof(chosen), "%s", inv->devices[sel].path);
+            break;
+        }
+        else if (ch == 'q' || ch == 'Q') {
+            timeout(-1);
+            return -1;
+        }
     }
+    timeout(-1);
 
-    strncpy(device_out, devices[sel], device_size - 1);
+    strncpy(device_out, chosen, device_size - 1);
     device_out[device_size - 1] = '\0';
     return 0;
 }
@@ -464,7 +588,9 @@ int vault_tui_select_device(char *device_out, size_t device_size)
 
 int vault_tui_new_password(char *password_out, size_t password_size)
 {
-    char pass1[256], pass2[256];
+    char *pass1 = vault_secure_alloc(2 * VAULT_PASSWORD_MAX);
+    if (!pass1) return -1;
+    char *pass2 = pass1 + VAULT_PASSWORD_MAX;
 
     while (1) {
         clear();
@@ -472,11 +598,12 @@ int vault_tui_new_password(char *password_out, size_t password_size)
         int y = 10;
 
         mvprintw(y, 4, "Enter new password: ");
-        int n1 = read_password_masked(y, 25, pass1, (int)sizeof(pass1) - 1);
+        int n1 = read_password_masked(y, 25, pass1, VAULT_PASSWORD_MAX - 1,
+                                      0);
 
         y += 2;
         mvprintw(y, 4, "Confirm password:   ");
-        read_password_masked(y, 25, pass2, (int)sizeof(pass2) - 1);
+        read_password_masked(y, 25, pass2, VAULT_PASSWORD_MAX - 1, 0);
 
         if (n1 == 0) {
             vault_tui_error("Password cannot be empty!");
@@ -491,8 +618,7 @@ int vault_tui_new_password(char *password_out, size_t password_size)
         strncpy(password_out, pass1, password_size - 1);
         password_out[password_size - 1] = '\0';
 
-        vault_secure_memzero(pass1, sizeof(pass1));
-        vault_secure_memzero(pass2, sizeof(pass2));
+        vault_secure_free(pass1);
         return 0;
     }
 }
@@ -509,8 +635,9 @@ wipe_algorithm_t vault_tui_select_algorithm(void)
         "DoD Short (3-pass) - Fast government standard",
         "PRNG Stream - Random data overwrite",
         "Zero Fill - Single pass with zeros",
+        "Hardware Erase - Drive's own erase (SSD), else random",
     };
-    int count = 5;
+    int count = 6;
     int sel = 0;
 
     while (1) {
@@ -0,0 +1,284 @@
+/*
+ * tui_progress.c -- Live Wipe Progress
+ *
+ * Each slot is a sequence lock: the writer makes the sequence odd,
+ * copies the snapshot in and makes it even again; the reader copies
+ * the snapshot out and keeps it only if the sequence was even and
+ * unchanged throughout. Writers never wait, and a torn read just
+ * retries, or shows the previous frame's values.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* nanosleep */
+#endif
+
+#include "tui_progress.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(VAULT_PLATFORM_WINDOWS)
+  #include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+  /* MSVC volatile accesses are acquire loads and release stores */
+  #define SEQ_LOAD(p)       (*(volatile long *)(p))
+  #define SEQ_STORE(p, v)   (*(volatile long *)(p) = (v))
+  #define SEQ_FENCE()       MemoryBarrier()
+#else
+  #define SEQ_LOAD(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+  #define SEQ_STORE(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+  #define SEQ_FENCE()       __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+#define READ_TRIES 4
+
+typedef struct {
+    long                  seq;      /* odd while being written */
+    vault_wipe_progress_t prog;
+    char                  pass[128];
+    int                   state;    /* as vault_tui_progress_row_t */
+} progress_slot_t;
+
+static struct {
+    progress_slot_t     slots[VAULT_WIPE_MAX_TARGETS];
+    const char *const  *devices;
+    int                 count;
+    long                stop;
+    int                 running;
+    vault_thread_t      thread;
+} live;
+
+/* Owned by the render thread: the last consistent copy of each slot,
+ * and total MB/s once a second as a ring */
+static progress_slot_t shown[VAULT_WIPE_MAX_TARGETS];
+static float history[VAULT_TUI_PROGRESS_HISTORY];
+static int   history_len, history_at, frames;
+
+static void progress_sleep_ms(int ms)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    Sleep((DWORD)ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static void slot_write_begin(progress_slot_t *s)
+{
+    SEQ_STORE(&s->seq, s->seq + 1);
+    SEQ_FENCE();
+}
+
+static void slot_write_end(progress_slot_t *s)
+{
+    SEQ_STORE(&s->seq, s->seq + 1);
+}
+
+/* Copy slot i into shown[i] if it can be read whole. */
+static void slot_read(int i)
+{
+    progress_slot_t *s = &live.slots[i];
+    progress_slot_t copy;
+    for (int tries = 0; tries < READ_TRIES; tries++) {
+        long before = SEQ_LOAD(&s->seq);
+        if (before & 1) continue;
+        memcpy(&copy, s, sizeof(copy));
+        SEQ_FENCE();
+        if (SEQ_LOAD(&s->seq) != before) continue;
+        copy.pass[sizeof(copy.pass) - 1] = '\0';
+        shown[i] = copy;
+        return;
+    }
+}
+
+static void row_from_slot(vault_tui_progress_row_t *row, int i)
+{
+    const progress_slot_t *s = &shown[i];
+    const vault_wipe_progress_t *p = &s->prog;
+
+    memset(row, 0, sizeof(*row));
+    row->device = live.devices[i];
+    row->pass = s->pass;
+    row->state = s->state;
+    row->mbps = p->speed_mbps;
+    row->bytes_skipped = p->bytes_skipped;
+    row->verifying = p->verifying;
+
+    if (p->bytes_total > 0)
+        row->pass_frac = (double)p->bytes_written / (double)p->bytes_total;
+    if (row->pass_frac > 1) row->pass_frac = 1;
+    if (p->total_passes > 0 && p->current_pass > 0)
+        row->total_frac = ((double)(p->current_pass - 1) + row->pass_frac) /
+                          (double)p->total_passes;
+    else
+        row->total_frac = row->pass_frac;
+
+    /* This pass's remainder, then each pass still to come at the
+     * current rate */
+    row->eta_secs = -1;
+    if (p->speed_mbps > 0 && p->bytes_total > 0) {
+        int left = p->total_passes - p->current_pass;
+        row->eta_secs = p->eta_secs + (left > 0 ? left : 0) *
+            (double)p->bytes_total / (p->speed_mbps * 1024.0 * 1024.0);
+    }
+
+    if (row->state > 0) {
+        row->pass_frac = row->total_frac = 1;
+        row->eta_secs = 0;
+    }
+}
+
+static void draw_frame(void)
+{
+    vault_tui_progress_row_t rows[VAULT_WIPE_MAX_TARGETS];
+    vault_tui_dashboard_t d;
+    memset(&d, 0, sizeof(d));
+    for (int i = 0; i < live.count; i++) {
+        slot_read(i);
+        row_from_slot(&rows[i], i);
+        if (rows[i].state == 0) d.total_mbps += rows[i].mbps;
+    }
+
+    if (frames++ % VAULT_TUI_PROGRESS_FPS == 0) {
+        history[history_at] = (float)d.total_mbps;
+        history_at = (history_at + 1) % VAULT_TUI_PROGRESS_HISTORY;
+        if (history_len < VAULT_TUI_PROGRESS_HISTORY) history_len++;
+    }
+    /* Oldest first */
+    float ordered[VAULT_TUI_PROGRESS_HISTORY];
+    int first = history_at - history_len;
+    if (first < 0) first += VAULT_TUI_PROGRESS_HISTORY;
+    for (int i = 0; i < history_len; i++)
+        ordered[i] = history[(first + i) % VAULT_TUI_PROGRESS_HISTORY];
+
+    d.rows = rows;
+    d.count = live.count;
+    d.history = ordered;
+    d.history_len = history_len;
+    vault_tui_dashboard_draw(&d);
+}
+
+static void *render_thread(void *arg)
+{
+    (void)arg;
+    while (!SEQ_LOAD(&live.stop)) {
+        draw_frame();
+        progress_sleep_ms(1000 / VAULT_TUI_PROGRESS_FPS);
+    }
+    return NULL;
+}
+
+int vault_tui_progress_start(const char *const *devices, int count)
+{
+    if (live.running || count <= 0 || count > VAULT_WIPE_MAX_TARGETS)
+        return -1;
+
+    memset(live.slots, 0, sizeof(live.slots));
+    memset(shown, 0, sizeof(shown));
+    history_len = history_at = frames = 0;
+    live.devices = devices;
+    live.count = count;
+    SEQ_STORE(&live.stop, 0);
+    if (vault_thread_create(&live.thread, render_thread, NULL) != 0)
+        return -1;
+    live.running = 1;
+    return 0;
+}
+
+void vault_tui_progress_publish(int index, const vault_wipe_progress_t *prog)
+{
+    if (!live.running || index < 0 || index >= live.count) return;
+
+    progress_slot_t *s = &live.slots[index];
+    slot_write_begin(s);
+    s->prog = *prog;
+    /* The engine's description buffer only lives for the pass */
+    if (prog->pass_description)
+        snprintf(s->pass, sizeof(s->pass), "%s", prog->pass_description);
+    else
+        s->pass[0] = '\0';
+    s->prog.pass_description = NULL;
+    slot_write_end(s);
+}
+
+void vault_tui_progress_done(int index, int result)
+{
+    if (!live.running || index < 0 || index >= live.count) return;
+
+    progress_slot_t *s = &live.slots[index];
+    slot_write_begin(s);
+    s->state = result == 0 ? 1 : -1;
+    slot_write_end(s);
+}
+
+void vault_tui_progress_stop(void)
+{
+    if (!live.running) return;
+    SEQ_STORE(&live.stop, 1);
+    vault_thread_join(live.thread);
+    live.running = 0;
+    draw_frame();
+}
+
+void vault_tui_progress_format(const vault_tui_progress_row_t *row,
+                                char *buf, size_t len)
+{
+    char eta[32] = "-", skipped[16] = "-";     /* eta: ULONG_MAX hours */
+    if (row->eta_secs >= 0 && row->state == 0) {
+        unsigned long secs = (unsigned long)row->eta_secs;
+        snprintf(eta, sizeof(eta), "%lu:%02lu:%02lu",
+                 secs / 3600, secs / 60 % 60, secs % 60);
+    }
+    if (row->bytes_skipped >= 1024ULL * 1024 * 1024)
+        snprintf(skipped, sizeof(skipped), "%llu GB",
+                 (unsigned long long)(row->bytes_skipped >> 30));
+    else if (row->bytes_skipped >= 1024ULL * 1024)
+        snprintf(skipped, sizeof(skipped), "%llu MB",
+                 (unsigned long long)(row->bytes_skipped >> 20));
+    else if (row->bytes_skipped > 0)
+        snprintf(skipped, sizeof(skipped), "%llu KB",
+                 (unsigned long long)((row->bytes_skipped + 1023) >> 10));
+
+    const char *state = row->state > 0 ? "wiped"
+                      : row->state < 0 ? "FAILED"
+                      : row->verifying ? "verify" : "wipe";
+    snprintf(buf, len, "%5.1f%%  %4.0f %8s %8s %s",
+             row->total_frac * 100.0, row->state == 0 ? row->mbps : 0.0,
+             eta, skipped, state);
+}
+
+void vault_tui_progress_bar(double frac, int width, char *buf)
+{
+    if (frac < 0) frac = 0;
+    if (frac > 1) frac = 1;
+    int fill = (int)(frac * width + 0.5);
+    memset(buf, '#', (size_t)fill);
+    memset(buf + fill, '-', (size_t)(width - fill));
+    buf[width] = '\0';
+}
+
+void vault_tui_progress_sparkline(const float *history, int len, int width,
+                                   char *buf)
+{
+    static const char levels[] = " _.-=+*#";
+    int first = len > width ? len - width : 0;
+    float peak = 0;
+    for (int i = first; i < len; i++)
+        if (history[i] > peak) peak = history[i];
+
+    int n = 0;
+    for (int i = first; i < len; i++) {
+        int lv = peak > 0 ? (int)(history[i] / peak * 7.0f + 0.5f) : 0;
+        buf[n++] = levels[lv];
+    }
+    /* Right-aligned, so the newest sample is always at the end */
+    memmove(buf + (width - n), buf, (size_t)n);
+    memset(buf, ' ', (size_t)(width - n));
+    buf[width] = '\0';
+}
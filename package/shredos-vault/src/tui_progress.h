@@ -0,0 +1,54 @@
+/*
+ * tui_progress.h -- Live Wipe Progress
+ *
+ * Wipe workers publish their progress into one slot per target without
+ * taking a lock; a render thread reads the slots and draws them on the
+ * TUI backend's dashboard (vault_tui_dashboard_draw) at a fixed frame
+ * rate. A slow console then costs frames, never write throughput.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_TUI_PROGRESS_H
+#define VAULT_TUI_PROGRESS_H
+
+#include "tui.h"
+#include "wipe.h"
+
+#define VAULT_TUI_PROGRESS_FPS      5
+#define VAULT_TUI_PROGRESS_HISTORY  120   /* seconds of total MB/s kept */
+#define VAULT_TUI_PROGRESS_WIDE     100   /* columns for the sparkline */
+
+/* Start drawing rows for count targets (at most VAULT_WIPE_MAX_TARGETS)
+ * on the dashboard. devices must outlive the display. Returns
+ * -1 if the render thread cannot be started. */
+int vault_tui_progress_start(const char *const *devices, int count);
+
+/* Latest progress of target index. Never blocks; safe from any thread,
+ * one writer per target at a time. */
+void vault_tui_progress_publish(int index, const vault_wipe_progress_t *prog);
+
+/* Target index has finished: result 0 wiped, -1 failed. */
+void vault_tui_progress_done(int index, int result);
+
+/* Draw a last frame and stop the render thread. */
+void vault_tui_progress_stop(void);
+
+/* Headings over vault_tui_progress_format()'s columns */
+#define VAULT_TUI_PROGRESS_COLUMNS "   PCT  MB/s      ETA  SKIPPED STATE"
+
+/* A row's columns after its bar, as every backend shows them:
+ * " 45.2%   312  1:02:03     64 KB wipe" */
+void vault_tui_progress_format(const vault_tui_progress_row_t *row,
+                                char *buf, size_t len);
+
+/* A bar of width characters, '#' for the done fraction and '-' for the
+ * rest, into buf (width + 1 bytes). */
+void vault_tui_progress_bar(double frac, int width, char *buf);
+
+/* The last width samples of history as a sparkline scaled to their
+ * peak, in ASCII for serial consoles, into buf (width + 1 bytes). */
+void vault_tui_progress_sparkline(const float *history, int len, int width,
+                                   char *buf);
+
+#endif /* VAULT_TUI_PROGRESS_H */
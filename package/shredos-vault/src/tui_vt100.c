@@ -11,16 +11,23 @@
 #if !defined(VAULT_PLATFORM_WINDOWS)
 
 #include "tui.h"
+#include "tui_progress.h"
+#include "devices.h"
 #include "auth_password.h"
+#include "auth_fingerprint.h"
+#include "auth_voice.h"
 #include "platform.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <errno.h>
 #include <unistd.h>
 #include <termios.h>
-#include <dirent.h>
+#include <sys/ioctl.h>
+#include <poll.h>
 #include <signal.h>
 
 static struct termios orig_termios;
@@ -39,14 +46,349 @@ static int raw_mode = 0;
 #define VT_RESET      "\033[0m"
 #define VT_REVERSE    "\033[7m"
 
+/* ------------------------------------------------------------------ */
+/*  Screen model                                                       */
+/* ------------------------------------------------------------------ */
+
+/*
+ * Screens are drawn into a shadow buffer, escape codes and all, by
+ * vt_printf(); vt_flush() compares it with what the terminal shows and
+ * sends only the cells that changed, with the shortest cursor moves,
+ * in one write(). Over a 115200-baud serial console a menu keypress
+ * then costs two short lines instead of a whole screen.
+ */
+
+#define VT_MAX_ROWS   64
+#define VT_MAX_COLS   200
+#define VT_OUT_SIZE   32768
+
+/* Cell attributes: foreground and background as 1 + colour (0 =
+ * default), bold and reverse */
+#define ATTR_FG(a)    ((a) & 0x0F)
+#define ATTR_BG(a)    (((a) >> 4) & 0x0F)
+#define ATTR_BOLD     0x100
+#define ATTR_REVERSE  0x200
+
+typedef struct {
+    char     ch;
+    uint16_t attr;
+} vt_cell_t;
+
+static struct {
+    vt_cell_t back[VT_MAX_ROWS][VT_MAX_COLS];   /* being drawn */
+    vt_cell_t front[VT_MAX_ROWS][VT_MAX_COLS];  /* on the terminal */
+    int       rows, cols;
+    int       row, col;             /* drawing cursor, 0-based */
+    uint16_t  attr;                 /* drawing attribute */
+    int       scrolled;             /* lines scrolled since the flush */
+
+    /* What the terminal has, as far as we know; -1 = unknown */
+    int       term_row, term_col;
+    int       term_attr;
+
+    char      out[VT_OUT_SIZE];
+    size_t    out_len;
+} scr;
+
+static void out_write(void)
+{
+    size_t done = 0;
+    while (done < scr.out_len) {
+        ssize_t n = write(STDOUT_FILENO, scr.out + done, scr.out_len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += (size_t)n;
+    }
+    scr.out_len = 0;
+}
+
+static void out_str(const char *s, size_t len)
+{
+    if (scr.out_len + len > sizeof(scr.out)) out_write();
+    if (len > sizeof(scr.out)) len = sizeof(scr.out);
+    memcpy(scr.out + scr.out_len, s, len);
+    scr.out_len += len;
+}
+
+static void out_fmt(const char *fmt, ...)
+{
+    char buf[64];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n > 0) out_str(buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+static void blank_row(vt_cell_t *row)
+{
+    for (int c = 0; c < VT_MAX_COLS; c++) {
+        row[c].ch = ' ';
+        row[c].attr = 0;
+    }
+}
+
+static void scr_size(void)
+{
+    struct winsize ws;
+    scr.rows = 24;
+    scr.cols = 80;
+    /* Serial consoles often report 0x0 */
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 &&
+        ws.ws_row > 0 && ws.ws_col > 0) {
+        scr.rows = ws.ws_row < VT_MAX_ROWS ? ws.ws_row : VT_MAX_ROWS;
+        scr.cols = ws.ws_col < VT_MAX_COLS ? ws.ws_col : VT_MAX_COLS;
+    }
+}
+
+/* Forget what the terminal shows: clear it, and the next flush sends
+ * every non-blank cell. */
+static void scr_reset(void)
+{
+    for (int r = 0; r < VT_MAX_ROWS; r++)
+        blank_row(scr.front[r]);
+    scr.scrolled = 0;
+    out_str(VT_RESET VT_CLEAR VT_HOME, sizeof(VT_RESET VT_CLEAR VT_HOME) - 1);
+    scr.term_row = scr.term_col = 0;
+    scr.term_attr = 0;
+}
+
+/* The drawing cursor fell off the bottom: scroll the model, and the
+ * terminal with it at the next flush, so pending changes stay put. */
+static void scr_scroll(void)
+{
+    memmove(scr.back[0], scr.back[1],
+            sizeof(scr.back[0]) * (size_t)(scr.rows - 1));
+    memmove(scr.front[0], scr.front[1],
+            sizeof(scr.front[0]) * (size_t)(scr.rows - 1));
+    blank_row(scr.back[scr.rows - 1]);
+    blank_row(scr.front[scr.rows - 1]);
+    scr.row = scr.rows - 1;
+    scr.scrolled++;
+}
+
+static void scr_newline(void)
+{
+    scr.col = 0;
+    if (++scr.row >= scr.rows) scr_scroll();
+}
+
+static void scr_put(char ch)
+{
+    if (scr.col >= scr.cols) scr_newline();
+    scr.back[scr.row][scr.col].ch = ch;
+    scr.back[scr.row][scr.col].attr = scr.attr;
+    scr.col++;
+}
+
+static void scr_clear_line(int from, int to)
+{
+    for (int c = from; c < to; c++) {
+        scr.back[scr.row][c].ch = ' ';
+        scr.back[scr.row][c].attr = scr.attr & 0xF0;
+    }
+}
+
+static void scr_sgr(const int *par, int n)
+{
+    if (n == 0) { scr.attr = 0; return; }
+    for (int i = 0; i < n; i++) {
+        int p = par[i];
+        if (p == 0)                 scr.attr = 0;
+        else if (p == 1)            scr.attr |= ATTR_BOLD;
+        else if (p == 7)            scr.attr |= ATTR_REVERSE;
+        else if (p >= 30 && p <= 37)
+            scr.attr = (uint16_t)((scr.attr & ~0x0F) | (p - 30 + 1));
+        else if (p == 39)           scr.attr &= (uint16_t)~0x0F;
+        else if (p >= 40 && p <= 47)
+            scr.attr = (uint16_t)((scr.attr & ~0xF0) | ((p - 40 + 1) << 4));
+        else if (p == 49)           scr.attr &= (uint16_t)~0xF0;
+    }
+}
+
+/* One CSI sequence starting after "\033[". Returns the text after it. */
+static const char *scr_csi(const char *s)
+{
+    int par[8], n = 0, cur = -1;
+    for (; *s; s++) {
+        if (*s >= '0' && *s <= '9') {
+            cur = (cur < 0 ? 0 : cur * 10) + (*s - '0');
+        } else if (*s == ';') {
+            if (n < 8) par[n++] = cur < 0 ? 0 : cur;
+            cur = -1;
+        } else {
+            break;
+        }
+    }
+    if (cur >= 0 && n < 8) par[n++] = cur;
+    if (!*s) return s;
+
+    switch (*s) {
+    case 'm':
+        scr_sgr(par, n);
+        break;
+    case 'H': {
+        int r = n > 0 && par[0] > 0 ? par[0] : 1;
+        int c = n > 1 && par[1] > 0 ? par[1] : 1;
+        scr.row = r <= scr.rows ? r - 1 : scr.rows - 1;
+        scr.col = c <= scr.cols ? c - 1 : scr.cols - 1;
+        break;
+    }
+    case 'J':
+        if (n > 0 && par[0] == 2)
+            for (int r = 0; r < scr.rows; r++) blank_row(scr.back[r]);
+        break;
+    case 'K':
+        if (n > 0 && par[0] == 2) scr_clear_line(0, scr.cols);
+        else                      scr_clear_line(scr.col, scr.cols);
+        break;
+    }
+    return s + 1;
+}
+
+/* Draw text, with the escape codes above, into the model. */
+static void scr_puts(const char *s)
+{
+    while (*s) {
+        char ch = *s++;
+        if (ch == '\033' && *s == '[') {
+            s = scr_csi(s + 1);
+        } else if (ch == '\n') {
+            scr_newline();
+        } else if (ch == '\r') {
+            scr.col = 0;
+        } else if (ch == '\b') {
+            if (scr.col > 0) scr.col--;
+        } else if ((unsigned char)ch >= 32) {
+            scr_put(ch);
+        }
+    }
+}
+
+static void vt_printf(const char *fmt, ...)
+{
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    scr_puts(buf);
+}
+
+static void vt_vprintf(const char *fmt, va_list ap)
+{
+    char buf[1024];
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    scr_puts(buf);
+}
+
+static void emit_attr(uint16_t attr)
+{
+    if ((int)attr == scr.term_attr) return;
+    out_str("\033[0", 3);
+    if (attr & ATTR_BOLD)    out_str(";1", 2);
+    if (attr & ATTR_REVERSE) out_str(";7", 2);
+    if (ATTR_FG(attr))       out_fmt(";%d", 30 + ATTR_FG(attr) - 1);
+    if (ATTR_BG(attr))       out_fmt(";%d", 40 + ATTR_BG(attr) - 1);
+    out_str("m", 1);
+    scr.term_attr = attr;
+}
+
+/* Move the terminal cursor to row r, column c by the cheapest of an
+ * absolute move, a carriage return or newline, a backspace, a forward
+ * move or resending the unchanged cells in between. */
+static void emit_move(int r, int c)
+{
+    if (scr.term_row == r && scr.term_col == c) return;
+
+    if (scr.term_row == r && scr.term_col >= 0 && c > scr.term_col) {
+        int gap = c - scr.term_col;
+        int same = 1;
+        for (int i = scr.term_col; i < c && same; i++)
+            same = scr.front[r][i].attr == scr.term_attr;
+        if (same && gap <= 4) {
+            for (int i = scr.term_col; i < c; i++)
+                out_str(&scr.front[r][i].ch, 1);
+        } else {
+            out_fmt("\033[%dC", gap);
+        }
+    } else if (scr.term_row == r && c == 0) {
+        out_str("\r", 1);
+    } else if (scr.term_row == r && c == scr.term_col - 1) {
+        out_str("\b", 1);
+    } else if (scr.term_row == r - 1 && c == 0) {
+        out_str("\r\n", 2);
+    } else {
+        out_fmt("\033[%d;%dH", r + 1, c + 1);
+    }
+    scr.term_row = r;
+    scr.term_col = c;
+}
+
+/* Send what changed since the last flush, in one write(). */
+static void vt_flush(void)
+{
+    if (scr.scrolled > 0) {
+        /* Newlines on the last row scroll the terminal as the model
+         * was scrolled */
+        emit_attr(0);
+        out_fmt("\033[%d;1H", scr.rows);
+        for (int i = 0; i < scr.scrolled && i < scr.rows; i++)
+            out_str("\n", 1);
+        scr.term_row = scr.rows - 1;
+        scr.term_col = 0;
+        scr.scrolled = 0;
+    }
+
+    for (int r = 0; r < scr.rows; r++) {
+        vt_cell_t *b = scr.back[r], *f = scr.front[r];
+        /* Writing the bottom-right cell would scroll some terminals */
+        int cols = r == scr.rows - 1 ? scr.cols - 1 : scr.cols;
+        int first = 0, last = cols - 1;
+        while (first < cols && b[first].ch == f[first].ch &&
+               b[first].attr == f[first].attr)
+            first++;
+        if (first == cols) continue;
+        while (b[last].ch == f[last].ch && b[last].attr == f[last].attr)
+            last--;
+
+        /* A blank default tail is cheaper as an erase to end of line */
+        int tail = cols;
+        while (tail > first && b[tail - 1].ch == ' ' &&
+               b[tail - 1].attr == 0)
+            tail--;
+        int erase = last + 1 - tail > 3;
+
+        emit_move(r, first);
+        int end = erase ? tail : last + 1;
+        for (int c = first; c < end; c++) {
+            emit_attr(b[c].attr);
+            out_str(&b[c].ch, 1);
+        }
+        scr.term_col = end < scr.cols ? end : -1;
+        if (erase) {
+            emit_attr(0);
+            out_str("\033[K", 3);
+            last = cols - 1;
+        }
+        memcpy(f + first, b + first,
+               sizeof(*b) * (size_t)(last - first + 1));
+    }
+
+    emit_move(scr.row, scr.col < scr.cols ? scr.col : scr.cols - 1);
+    out_write();
+}
+
 static void vt_goto(int row, int col)
 {
-    printf("\033[%d;%dH", row, col);
+    vt_printf("\033[%d;%dH", row, col);
 }
 
 static void vt_clear(void)
 {
-    printf(VT_CLEAR VT_HOME);
+    vt_printf(VT_CLEAR VT_HOME);
 }
 
 static void enable_raw_mode(void)
@@ -86,15 +428,32 @@ static int read_key(void)
     return c;
 }
 
+/* read_key(), or KEY_DEVICES as soon as the device inventory may have
+ * changed */
+#define KEY_DEVICES 1002
+
+static int read_key_or_devices(void)
+{
+    struct pollfd fds[2] = {
+        { STDIN_FILENO, POLLIN, 0 },
+        { vault_devices_fd(), POLLIN, 0 },
+    };
+    /* Without uevents, look again once a second */
+    int n = fds[1].fd >= 0 ? 2 : 1;
+    int ret = poll(fds, (nfds_t)n, n == 2 ? -1 : 1000);
+    if (ret > 0 && (fds[0].revents & POLLIN)) return read_key();
+    return KEY_DEVICES;
+}
+
 static void draw_banner_vt(void)
 {
-    printf(VT_CYAN VT_BOLD);
-    printf("   ____  _                   _  ___  ____   __     __          _ _\n");
-    printf("  / ___|| |__  _ __ ___  __| |/ _ \\/ ___|  \\ \\   / /_ _ _   _| | |_\n");
-    printf("  \\___ \\| '_ \\| '__/ _ \\/ _` | | | \\___ \\   \\ \\ / / _` | | | | | __|\n");
-    printf("   ___) | | | | | |  __/ (_| | |_| |___) |   \\ V / (_| | |_| | | |_\n");
-    printf("  |____/|_| |_|_|  \\___|\\__,_|\\___/|____/     \\_/ \\__,_|\\__,_|_|\\__|\n");
-    printf(VT_RESET "\n");
+    vt_printf(VT_CYAN VT_BOLD);
+    vt_printf("   ____  _                   _  ___  ____   __     __          _ _\n");
+    vt_printf("  / ___|| |__  _ __ ___  __| |/ _ \\/ ___|  \\ \\   / /_ _ _   _| | |_\n");
+    vt_printf("  \\___ \\| '_ \\| '__/ _ \\/ _` | | | \\___ \\   \\ \\ / / _` | | | | | __|\n");
+    vt_printf("   ___) | | | | | |  __/ (_| | |_| |___) |   \\ V / (_| | |_| | | |_\n");
+    vt_printf("  |____/|_| |_|_|  \\___|\\__,_|\\___/|____/     \\_/ \\__,_|\\__,_|_|\\__|\n");
+    vt_printf(VT_RESET "\n");
 }
 
 /* ------------------------------------------------------------------ */
@@ -106,16 +465,20 @@ int vault_tui_init(void)
     signal(SIGINT, SIG_IGN);
     signal(SIGTSTP, SIG_IGN);
     signal(SIGQUIT, SIG_IGN);
+    fflush(stdout);
     enable_raw_mode();
+    scr_size();
+    scr_reset();
     vt_clear();
+    vt_flush();
     return 0;
 }
 
 void vault_tui_shutdown(void)
 {
     disable_raw_mode();
-    printf(VT_RESET VT_CLEAR VT_HOME);
-    fflush(stdout);
+    scr_reset();
+    out_write();
 }
 
 /* ------------------------------------------------------------------ */
@@ -128,36 +491,63 @@ int vault_tui_login_screen(const vault_config_t *cfg,
     vt_clear();
     draw_banner_vt();
 
-    printf("\n  Secure Vault Authentication\n\n");
+    vt_printf("\n  Secure Vault Authentication\n\n");
 
     if (cfg->current_attempts > 0)
-        printf(VT_RED);
-    printf("  Attempt %d of %d\n", cfg->current_attempts + 1,
+        vt_printf(VT_RED);
+    vt_printf("  Attempt %d of %d\n", cfg->current_attempts + 1,
            cfg->max_attempts);
-    printf(VT_RESET "\n");
-
-    printf("  Password: ");
-    fflush(stdout);
+    vt_printf(VT_RESET "\n");
+
+    int fp_fd = vault_auth_fingerprint_fd();
+    int voice_fd = vault_auth_voice_fd();
+    if (fp_fd >= 0)
+        vt_printf("  (or touch the fingerprint reader)\n");
+    if (voice_fd >= 0)
+        vt_printf("  (or press Tab and say the passphrase)\n");
+    if (fp_fd >= 0 || voice_fd >= 0)
+        vt_printf("\n");
+    vt_printf("  Password: ");
+    vt_flush();
 
     int pos = 0;
     int max = (int)password_size - 1;
 
     while (1) {
+        if (fp_fd >= 0 || voice_fd >= 0) {
+            /* poll() skips the backends that are not running (fd -1) */
+            struct pollfd fds[3] = {
+                { STDIN_FILENO, POLLIN, 0 },
+                { fp_fd, POLLIN, 0 },
+                { voice_fd, POLLIN, 0 },
+            };
+            if (poll(fds, 3, -1) > 0 &&
+                ((fds[1].revents | fds[2].revents) & POLLIN)) {
+                vault_secure_memzero(password_out, password_size);
+                vt_printf("\n");
+                return (fds[1].revents & POLLIN)
+                    ? VAULT_TUI_LOGIN_FINGERPRINT : VAULT_TUI_LOGIN_VOICE;
+            }
+        }
         int ch = read_key();
         if (ch == '\n' || ch == '\r') break;
+        if (ch == '\t' && voice_fd >= 0) {
+            vault_auth_voice_listen();
+            continue;
+        }
         if ((ch == 127 || ch == 8) && pos > 0) {
             pos--;
             password_out[pos] = '\0';
-            printf("\b \b");
-            fflush(stdout);
+            vt_printf("\b \b");
+            vt_flush();
         } else if (pos < max && ch >= 32 && ch <= 126) {
             password_out[pos++] = (char)ch;
-            printf("*");
-            fflush(stdout);
+            vt_printf("*");
+            vt_flush();
         }
     }
     password_out[pos] = '\0';
-    printf("\n");
+    vt_printf("\n");
     return pos;
 }
 
@@ -169,7 +559,7 @@ int vault_tui_setup_screen(vault_config_t *cfg)
 {
     vt_clear();
     draw_banner_vt();
-    printf(VT_BOLD "\n  === First-Run Setup ===\n" VT_RESET "\n");
+    vt_printf(VT_BOLD "\n  === First-Run Setup ===\n" VT_RESET "\n");
 
     /* Select device */
     if (vault_tui_select_device(cfg->target_device,
@@ -177,12 +567,16 @@ int vault_tui_setup_screen(vault_config_t *cfg)
         return -1;
 
     /* Set password */
-    char password[256];
-    if (vault_tui_new_password(password, sizeof(password)) != 0)
+    char *password = vault_secure_alloc(VAULT_PASSWORD_MAX);
+    if (!password ||
+        vault_tui_new_password(password, VAULT_PASSWORD_MAX) != 0) {
+        vault_secure_free(password);
         return -1;
-    vault_auth_password_hash(password, cfg->password_hash,
+    }
+    vault_auth_password_hash(password, cfg->password_hash_ms,
+                              cfg->password_hash,
                               sizeof(cfg->password_hash));
-    vault_secure_memzero(password, sizeof(password));
+    vault_secure_free(password);
 
     /* Set threshold */
     cfg->max_attempts = vault_tui_set_threshold();
@@ -193,14 +587,14 @@ int vault_tui_setup_screen(vault_config_t *cfg)
     /* Confirm */
     vt_clear();
     draw_banner_vt();
-    printf(VT_RED VT_BOLD "\n  WARNING: Vault will be configured for %s\n",
+    vt_printf(VT_RED VT_BOLD "\n  WARNING: Vault will be configured for %s\n",
            cfg->target_device);
-    printf("  Failed auth will trigger the dead man's switch!\n" VT_RESET "\n");
-    printf("  Press 'Y' to confirm, any other key to cancel: ");
-    fflush(stdout);
+    vt_printf("  Failed auth will trigger the dead man's switch!\n" VT_RESET "\n");
+    vt_printf("  Press 'Y' to confirm, any other key to cancel: ");
+    vt_flush();
 
     int ch = read_key();
-    printf("\n");
+    vt_printf("\n");
     if (ch != 'Y' && ch != 'y') return -1;
 
     return 0;
@@ -214,10 +608,10 @@ void vault_tui_success_screen(const vault_config_t *cfg)
 {
     vt_clear();
     draw_banner_vt();
-    printf(VT_GREEN VT_BOLD "\n  AUTHENTICATION SUCCESSFUL\n" VT_RESET "\n");
-    printf("  Volume mounted at: %s\n\n", cfg->mount_point);
-    printf("  Press 'q' to lock and shutdown.\n");
-    fflush(stdout);
+    vt_printf(VT_GREEN VT_BOLD "\n  AUTHENTICATION SUCCESSFUL\n" VT_RESET "\n");
+    vt_printf("  Volume mounted at: %s\n\n", cfg->mount_point);
+    vt_printf("  Press 'q' to lock and shutdown.\n");
+    vt_flush();
 
     while (1) {
         int ch = read_key();
@@ -232,20 +626,20 @@ void vault_tui_success_screen(const vault_config_t *cfg)
 void vault_tui_deadman_warning(int countdown_seconds)
 {
     vt_clear();
-    printf(VT_BG_RED VT_BOLD "\n\n\n");
-    printf("    !!! DEAD MAN'S SWITCH ACTIVATED !!!\n\n");
-    printf("    MAXIMUM AUTHENTICATION ATTEMPTS EXCEEDED\n\n");
-    printf("    Target drive will be ENCRYPTED and WIPED\n\n");
-    printf("    THIS CANNOT BE STOPPED OR REVERSED\n\n");
+    vt_printf(VT_BG_RED VT_BOLD "\n\n\n");
+    vt_printf("    !!! DEAD MAN'S SWITCH ACTIVATED !!!\n\n");
+    vt_printf("    MAXIMUM AUTHENTICATION ATTEMPTS EXCEEDED\n\n");
+    vt_printf("    Target drive will be ENCRYPTED and WIPED\n\n");
+    vt_printf("    THIS CANNOT BE STOPPED OR REVERSED\n\n");
 
     for (int i = countdown_seconds; i > 0; i--) {
-        printf("\r    Starting in %d seconds...  ", i);
-        fflush(stdout);
+        vt_printf("\r    Starting in %d seconds...  ", i);
+        vt_flush();
         sleep(1);
     }
-    printf("\r    INITIATING WIPE SEQUENCE     \n");
-    printf(VT_RESET);
-    fflush(stdout);
+    vt_printf("\r    INITIATING WIPE SEQUENCE     \n");
+    vt_printf(VT_RESET);
+    vt_flush();
     sleep(1);
 }
 
@@ -256,11 +650,81 @@ void vault_tui_deadman_warning(int countdown_seconds)
 void vault_tui_wiping_screen(const char *device, const char *algorithm_name)
 {
     vt_clear();
-    printf(VT_RED VT_BOLD "\n  WIPING IN PROGRESS\n" VT_RESET "\n");
-    printf("  Device:    %s\n", device);
-    printf("  Algorithm: %s\n\n", algorithm_name);
-    printf("  Do NOT power off. This may take a long time.\n");
-    fflush(stdout);
+    vt_printf(VT_RED VT_BOLD "\n  WIPING IN PROGRESS\n" VT_RESET "\n");
+    vt_printf("  Device:    %s\n", device);
+    vt_printf("  Algorithm: %s\n\n", algorithm_name);
+    vt_printf("  Do NOT power off. This may take a long time.\n");
+    vt_flush();
+}
+
+/* ------------------------------------------------------------------ */
+/*  Wipe Dashboard                                                     */
+/* ------------------------------------------------------------------ */
+
+#define DASH_TOP 7      /* headings; rows below, then the total */
+
+static int dash_count;
+
+void vault_tui_dashboard_screen(const char *algorithm_name, int count)
+{
+    vt_clear();
+    vt_printf(VT_RED VT_BOLD "\n  WIPING IN PROGRESS\n" VT_RESET "\n");
+    vt_printf("  Algorithm: %s    Drives: %d\n", algorithm_name, count);
+    vt_printf("  Do NOT power off. This may take a long time.\n");
+    /* Status lines carry on below the total */
+    dash_count = count;
+    vt_goto(DASH_TOP + count + 3, 1);
+    vt_flush();
+}
+
+/* Headings, one row per target, then the total with its sparkline on
+ * wide terminals. The drawing cursor is left where it was, so status
+ * lines are not broken up. */
+void vault_tui_dashboard_draw(const vault_tui_dashboard_t *d)
+{
+    int row = scr.row, col = scr.col;
+    uint16_t attr = scr.attr;
+    int bar = scr.cols - 72;
+    if (bar > 30) bar = 30;
+    if (bar < 8) bar = 8;
+
+    vt_goto(DASH_TOP, 1);
+    vt_printf(VT_BOLD "  %-12s %-16s %*s %s" VT_RESET, "DEVICE", "PASS",
+              bar + 2, "", VAULT_TUI_PROGRESS_COLUMNS);
+
+    int i;
+    for (i = 0; i < d->count; i++) {
+        const vault_tui_progress_row_t *r = &d->rows[i];
+        const char *color = r->state < 0 ? VT_RED
+                          : r->state > 0 ? VT_GREEN : VT_YELLOW;
+        char fill[31], stats[64];
+        vault_tui_progress_bar(r->pass_frac, bar, fill);
+        vault_tui_progress_format(r, stats, sizeof(stats));
+
+        vt_goto(DASH_TOP + 1 + i, 1);
+        vt_printf("\033[2K  %-12.12s %-16.16s [%s%s" VT_RESET "] %s%s"
+                  VT_RESET, r->device, r->pass, color, fill,
+                  r->state ? color : "", stats);
+    }
+
+    vt_goto(DASH_TOP + 2 + i, 1);
+    vt_printf("\033[2K  Total %5.0f MB/s", d->total_mbps);
+    if (scr.cols >= VAULT_TUI_PROGRESS_WIDE) {
+        char spark[VAULT_TUI_PROGRESS_HISTORY + 1];
+        int w = scr.cols - 26;
+        if (w > VAULT_TUI_PROGRESS_HISTORY) w = VAULT_TUI_PROGRESS_HISTORY;
+        vault_tui_progress_sparkline(d->history, d->history_len, w, spark);
+        vt_printf("   " VT_GREEN "%s" VT_RESET, spark);
+    }
+
+    if (row < DASH_TOP + dash_count + 2) {
+        row = DASH_TOP + dash_count + 2;
+        col = 0;
+    }
+    scr.row = row < scr.rows ? row : scr.rows - 1;
+    scr.col = col;
+    scr.attr = attr;
+    vt_flush();
 }
 
 /* ------------------------------------------------------------------ */
@@ -271,25 +735,36 @@ void vault_tui_status(const char *fmt, ...)
 {
     va_list ap;
     va_start(ap, fmt);
-    printf(VT_CYAN "  ");
-    vprintf(fmt, ap);
-    printf(VT_RESET "\n");
+    vt_printf(VT_CYAN "  ");
+    vt_vprintf(fmt, ap);
+    vt_printf(VT_RESET "\n");
     va_end(ap);
-    fflush(stdout);
+    vt_flush();
+}
+
+void vault_tui_verifying(int frame)
+{
+    static const char spin[] = "|/-\\";
+    if (frame >= 0)
+        vt_printf("\r" VT_CYAN "  Verifying password... %c" VT_RESET,
+               spin[frame % 4]);
+    else
+        vt_printf("\r\033[2K");
+    vt_flush();
 }
 
 void vault_tui_error(const char *fmt, ...)
 {
     va_list ap;
     va_start(ap, fmt);
-    printf(VT_RED VT_BOLD "  ERROR: ");
-    vprintf(fmt, ap);
-    printf(VT_RESET "\n");
+    vt_printf(VT_RED VT_BOLD "  ERROR: ");
+    vt_vprintf(fmt, ap);
+    vt_printf(VT_RESET "\n");
     va_end(ap);
-    fflush(stdout);
+    vt_flush();
 
-    printf("  Press any key to continue...\n");
-    fflush(stdout);
+    vt_printf("  Press any key to continue...\n");
+    vt_flush();
     read_key();
 }
 
@@ -299,44 +774,12 @@ void vault_tui_error(const char *fmt, ...)
 
 int vault_tui_select_device(char *device_out, size_t device_size)
 {
-    DIR *dir = opendir("/sys/block");
-    if (!dir) {
+    const vault_devices_t *inv = vault_devices_get();
+    if (!inv) {
         vault_tui_error("Cannot read /sys/block");
         return -1;
     }
-
-    char devices[32][64];
-    char sizes[32][32];
-    int count = 0;
-
-    struct dirent *ent;
-    while ((ent = readdir(dir)) && count < 32) {
-        if (strncmp(ent->d_name, "loop", 4) == 0) continue;
-        if (strncmp(ent->d_name, "ram", 3) == 0) continue;
-        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
-            continue;
-
-        snprintf(devices[count], sizeof(devices[count]),
-                 "/dev/%s", ent->d_name);
-
-        char spath[256];
-        snprintf(spath, sizeof(spath), "/sys/block/%s/size", ent->d_name);
-        FILE *sf = fopen(spath, "r");
-        if (sf) {
-            unsigned long long sectors = 0;
-            if (fscanf(sf, "%llu", &sectors) == 1) {
-                double gb = (double)(sectors * 512) / (1024.0 * 1024.0 * 1024.0);
-                snprintf(sizes[count], sizeof(sizes[count]), "%.1f GB", gb);
-            }
-            fclose(sf);
-        } else {
-            strncpy(sizes[count], "? GB", sizeof(sizes[count]) - 1);
-        }
-        count++;
-    }
-    closedir(dir);
-
-    if (count == 0) {
+    if (inv->count == 0) {
         vault_tui_error("No block devices found!");
         return -1;
     }
@@ -344,25 +787,39 @@ int vault_tui_select_device(char *device_out, size_t device_size)
     int sel = 0;
     while (1) {
         vt_clear();
-        printf(VT_BOLD "\n  Select target device:\n" VT_RESET "\n");
-        for (int i = 0; i < count; i++) {
+        vt_printf(VT_BOLD "\n  Select target device:\n" VT_RESET "\n");
+        for (int i = 0; i < inv->count; i++) {
+            char label[160];
+            vault_devices_label(&inv->devices[i], label, sizeof(label));
             if (i == sel)
-                printf(VT_REVERSE);
-            printf("    %-20s  %s\n", devices[i], sizes[i]);
+                vt_printf(VT_REVERSE);
+            vt_printf("    %s\n", label);
             if (i == sel)
-                printf(VT_RESET);
+                vt_printf(VT_RESET);
         }
-        printf("\n  UP/DOWN to select, ENTER to confirm, 'q' to cancel\n");
-        fflush(stdout);
-
-        int ch = read_key();
-        if (ch == 1000 && sel > 0) sel--;           /* UP */
-        else if (ch == 1001 && sel < count - 1) sel++; /* DOWN */
-        else if (ch == '\n' || ch == '\r') break;
+        if (inv->count == 0)
+            vt_printf("    (no drives attached)\n");
+        vt_printf("\n  UP/DOWN to select, ENTER to confirm, 'q' to cancel\n");
+        vt_flush();
+
+        int ch = read_key_or_devices();
+        if (ch == KEY_DEVICES) {
+            /* Keep the cursor on the same disk if it is still there */
+            char was[sizeof(inv->devices[0].name)] = "";
+            if (sel < inv->count)
+                snprintf(was, sizeof(was), "%s", inv->devices[sel].name);
+            if (vault_devices_refresh()) {
+                const vault_device_t *d = vault_devices_find(was);
+                sel = d ? (int)(d - inv->devices) : 0;
+            }
+        }
+        else if (ch == 1000 && sel > 0) sel--;           /* UP */
+        else if (ch == 1001 && sel < inv->count - 1) sel++; /* DOWN */
+        else if ((ch == '\n' || ch == '\r') && inv->count > 0) break;
         else if (ch == 'q' || ch == 'Q') return -1;
     }
 
-    strncpy(device_out, devices[sel], device_size - 1);
+    strncpy(device_out, inv->devices[sel].path, device_size - 1);
     device_out[device_size - 1] = '\0';
     return 0;
 }
@@ -373,33 +830,35 @@ int vault_tui_select_device(char *device_out, size_t device_size)
 
 int vault_tui_new_password(char *password_out, size_t password_size)
 {
-    char pass1[256], pass2[256];
+    char *pass1 = vault_secure_alloc(2 * VAULT_PASSWORD_MAX);
+    if (!pass1) return -1;
+    char *pass2 = pass1 + VAULT_PASSWORD_MAX;
 
     while (1) {
         vt_clear();
         draw_banner_vt();
-        printf("\n  Enter new password: ");
-        fflush(stdout);
+        vt_printf("\n  Enter new password: ");
+        vt_flush();
 
         int pos = 0;
-        int max = (int)sizeof(pass1) - 1;
+        int max = VAULT_PASSWORD_MAX - 1;
         while (1) {
             int ch = read_key();
             if (ch == '\n' || ch == '\r') break;
             if ((ch == 127 || ch == 8) && pos > 0) {
                 pos--;
-                printf("\b \b");
-                fflush(stdout);
+                vt_printf("\b \b");
+                vt_flush();
             } else if (pos < max && ch >= 32 && ch <= 126) {
                 pass1[pos++] = (char)ch;
-                printf("*");
-                fflush(stdout);
+                vt_printf("*");
+                vt_flush();
             }
         }
         pass1[pos] = '\0';
 
-        printf("\n  Confirm password:   ");
-        fflush(stdout);
+        vt_printf("\n  Confirm password:   ");
+        vt_flush();
 
         int pos2 = 0;
         while (1) {
@@ -407,16 +866,16 @@ int vault_tui_new_password(char *password_out, size_t password_size)
             if (ch == '\n' || ch == '\r') break;
             if ((ch == 127 || ch == 8) && pos2 > 0) {
                 pos2--;
-                printf("\b \b");
-                fflush(stdout);
+                vt_printf("\b \b");
+                vt_flush();
             } else if (pos2 < max && ch >= 32 && ch <= 126) {
                 pass2[pos2++] = (char)ch;
-                printf("*");
-                fflush(stdout);
+                vt_printf("*");
+                vt_flush();
             }
         }
         pass2[pos2] = '\0';
-        printf("\n");
+        vt_printf("\n");
 
         if (pos == 0) {
             vault_tui_error("Password cannot be empty!");
@@ -429,8 +888,7 @@ int vault_tui_new_password(char *password_out, size_t password_size)
 
         strncpy(password_out, pass1, password_size - 1);
         password_out[password_size - 1] = '\0';
-        vault_secure_memzero(pass1, sizeof(pass1));
-        vault_secure_memzero(pass2, sizeof(pass2));
+        vault_secure_free(pass1);
         return 0;
     }
 }
@@ -447,20 +905,21 @@ wipe_algorithm_t vault_tui_select_algorithm(void)
         "DoD Short (3-pass)",
         "PRNG Stream (random)",
         "Zero Fill",
+        "Hardware Erase (SSD)",
     };
-    int count = 5;
+    int count = 6;
     int sel = 0;
 
     while (1) {
         vt_clear();
-        printf(VT_BOLD "\n  Select wipe algorithm:\n" VT_RESET "\n");
+        vt_printf(VT_BOLD "\n  Select wipe algorithm:\n" VT_RESET "\n");
         for (int i = 0; i < count; i++) {
-            if (i == sel) printf(VT_REVERSE);
-            printf("    %s\n", names[i]);
-            if (i == sel) printf(VT_RESET);
+            if (i == sel) vt_printf(VT_REVERSE);
+            vt_printf("    %s\n", names[i]);
+            if (i == sel) vt_printf(VT_RESET);
         }
-        printf("\n  UP/DOWN to select, ENTER to confirm\n");
-        fflush(stdout);
+        vt_printf("\n  UP/DOWN to select, ENTER to confirm\n");
+        vt_flush();
 
         int ch = read_key();
         if (ch == 1000 && sel > 0) sel--;
@@ -480,11 +939,11 @@ int vault_tui_set_threshold(void)
 
     while (1) {
         vt_clear();
-        printf(VT_BOLD "\n  Set failure threshold:\n" VT_RESET "\n");
-        printf("  After this many failed attempts, the drive will be wiped.\n\n");
-        printf(VT_YELLOW VT_BOLD "    [ %2d ]\n" VT_RESET, threshold);
-        printf("\n  UP/DOWN to adjust (1-99), ENTER to confirm\n");
-        fflush(stdout);
+        vt_printf(VT_BOLD "\n  Set failure threshold:\n" VT_RESET "\n");
+        vt_printf("  After this many failed attempts, the drive will be wiped.\n\n");
+        vt_printf(VT_YELLOW VT_BOLD "    [ %2d ]\n" VT_RESET, threshold);
+        vt_printf("\n  UP/DOWN to adjust (1-99), ENTER to confirm\n");
+        vt_flush();
 
         int ch = read_key();
         if (ch == 1000 && threshold < 99) threshold++;
@@ -505,14 +964,14 @@ int vault_tui_menu_select(const char *title, const char **labels,
 
     while (1) {
         vt_clear();
-        printf(VT_BOLD "\n  %s\n" VT_RESET "\n", title);
+        vt_printf(VT_BOLD "\n  %s\n" VT_RESET "\n", title);
         for (int i = 0; i < count; i++) {
-            if (i == sel) printf(VT_REVERSE);
-            printf("    %s\n", labels[i]);
-            if (i == sel) printf(VT_RESET);
+            if (i == sel) vt_printf(VT_REVERSE);
+            vt_printf("    %s\n", labels[i]);
+            if (i == sel) vt_printf(VT_RESET);
         }
-        printf("\n  UP/DOWN to select, ENTER to confirm, 'q' to cancel\n");
-        fflush(stdout);
+        vt_printf("\n  UP/DOWN to select, ENTER to confirm, 'q' to cancel\n");
+        vt_flush();
 
         int ch = read_key();
         if (ch == 1000 && sel > 0) sel--;
@@ -9,6 +9,7 @@
 #ifdef VAULT_PLATFORM_WINDOWS
 
 #include "tui.h"
+#include "tui_progress.h"
 #include "auth_password.h"
 #include "platform.h"
 
@@ -120,12 +121,16 @@ int vault_tui_setup_screen(vault_config_t *cfg)
                                  sizeof(cfg->target_device)) != 0)
         return -1;
 
-    char password[256];
-    if (vault_tui_new_password(password, sizeof(password)) != 0)
+    char *password = vault_secure_alloc(VAULT_PASSWORD_MAX);
+    if (!password ||
+        vault_tui_new_password(password, VAULT_PASSWORD_MAX) != 0) {
+        vault_secure_free(password);
         return -1;
-    vault_auth_password_hash(password, cfg->password_hash,
+    }
+    vault_auth_password_hash(password, cfg->password_hash_ms,
+                              cfg->password_hash,
                               sizeof(cfg->password_hash));
-    vault_secure_memzero(password, sizeof(password));
+    vault_secure_free(password);
 
     cfg->max_attempts = vault_tui_set_threshold();
     cfg->wipe_algorithm = vault_tui_select_algorithm();
@@ -203,6 +208,78 @@ void vault_tui_wiping_screen(const char *device, const char *algorithm_name)
     printf("Do NOT power off.");
 }
 
+/* ------------------------------------------------------------------ */
+/*  Wipe Dashboard                                                     */
+/* ------------------------------------------------------------------ */
+
+#define DASH_TOP 6      /* headings; rows below, then the total */
+
+static int con_width(void)
+{
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    if (!GetConsoleScreenBufferInfo(hConsole, &csbi)) return 80;
+    return csbi.srWindow.Right - csbi.srWindow.Left + 1;
+}
+
+void vault_tui_dashboard_screen(const char *algorithm_name, int count)
+{
+    con_clear();
+    SetConsoleTextAttribute(hConsole, ATTR_ERROR);
+    con_goto(1, 2);
+    printf("WIPING IN PROGRESS");
+    SetConsoleTextAttribute(hConsole, ATTR_NORMAL);
+    con_goto(3, 2);
+    printf("Algorithm: %s    Drives: %d", algorithm_name, count);
+    con_goto(4, 2);
+    printf("Do NOT power off.");
+}
+
+/* Headings, one row per target, then the total with its sparkline on
+ * wide consoles; the rows stop short of the status line */
+void vault_tui_dashboard_draw(const vault_tui_dashboard_t *d)
+{
+    int width = con_width();
+    int bar = width - 72;
+    if (bar > 30) bar = 30;
+    if (bar < 8) bar = 8;
+
+    con_goto(DASH_TOP, 2);
+    printf("%-12s %-16s %*s %s", "DEVICE", "PASS", bar + 2, "",
+           VAULT_TUI_PROGRESS_COLUMNS);
+
+    int row = DASH_TOP + 1;
+    for (int i = 0; i < d->count && row < 21; i++, row++) {
+        const vault_tui_progress_row_t *r = &d->rows[i];
+        WORD attr = r->state < 0 ? ATTR_ERROR
+                  : r->state > 0 ? ATTR_SUCCESS : ATTR_INPUT;
+        char fill[31], stats[64];
+        vault_tui_progress_bar(r->pass_frac, bar, fill);
+        vault_tui_progress_format(r, stats, sizeof(stats));
+
+        con_goto(row, 2);
+        printf("%-12.12s %-16.16s [", r->device, r->pass);
+        SetConsoleTextAttribute(hConsole, attr);
+        printf("%s", fill);
+        SetConsoleTextAttribute(hConsole, ATTR_NORMAL);
+        printf("] ");
+        if (r->state) SetConsoleTextAttribute(hConsole, attr);
+        printf("%-36s", stats);
+        SetConsoleTextAttribute(hConsole, ATTR_NORMAL);
+    }
+
+    con_goto(row + 1, 2);
+    printf("Total %5.0f MB/s", d->total_mbps);
+    if (width >= VAULT_TUI_PROGRESS_WIDE) {
+        char spark[VAULT_TUI_PROGRESS_HISTORY + 1];
+        int w = width - 26;
+        if (w > VAULT_TUI_PROGRESS_HISTORY) w = VAULT_TUI_PROGRESS_HISTORY;
+        vault_tui_progress_sparkline(d->history, d->history_len, w, spark);
+        SetConsoleTextAttribute(hConsole, ATTR_SUCCESS);
+        printf("   %s", spark);
+        SetConsoleTextAttribute(hConsole, ATTR_NORMAL);
+    }
+}
+
 void vault_tui_status(const char *fmt, ...)
 {
     va_list ap;
@@ -216,6 +293,18 @@ void vault_tui_status(const char *fmt, ...)
     SetConsoleTextAttribute(hConsole, ATTR_NORMAL);
 }
 
+void vault_tui_verifying(int frame)
+{
+    static const char spin[] = "|/-\\";
+    SetConsoleTextAttribute(hConsole, ATTR_STATUS);
+    con_goto(23, 0);
+    if (frame >= 0)
+        printf("  Verifying password... %c%-54s", spin[frame % 4], "");
+    else
+        printf("%-79s", "");
+    SetConsoleTextAttribute(hConsole, ATTR_NORMAL);
+}
+
 void vault_tui_error(const char *fmt, ...)
 {
     va_list ap;
@@ -274,7 +363,9 @@ int vault_tui_new_password(char *password_out, size_t password_size)
     printf("Set Password");
     SetConsoleTextAttribute(hConsole, ATTR_NORMAL);
 
-    char pass1[256], pass2[256];
+    char *pass1 = vault_secure_alloc(2 * VAULT_PASSWORD_MAX);
+    if (!pass1) return -1;
+    char *pass2 = pass1 + VAULT_PASSWORD_MAX;
     while (1) {
         con_goto(5, 10);
         printf("Password: ");
@@ -290,7 +381,7 @@ int vault_tui_new_password(char *password_out, size_t password_size)
             ReadConsoleA(hIn, &ch, 1, &nr, NULL);
             if (ch == '\r') break;
             if (ch == '\b' && p > 0) { p--; printf("\b \b"); }
-            else if (p < 255 && ch >= 32) { pass1[p++] = ch; printf("*"); }
+            else if (p < VAULT_PASSWORD_MAX - 1 && ch >= 32) { pass1[p++] = ch; printf("*"); }
         }
         pass1[p] = '\0';
         printf("\n");
@@ -302,7 +393,7 @@ int vault_tui_new_password(char *password_out, size_t password_size)
             ReadConsoleA(hIn, &ch, 1, &nr, NULL);
             if (ch == '\r') break;
             if (ch == '\b' && p2 > 0) { p2--; printf("\b \b"); }
-            else if (p2 < 255 && ch >= 32) { pass2[p2++] = ch; printf("*"); }
+            else if (p2 < VAULT_PASSWORD_MAX - 1 && ch >= 32) { pass2[p2++] = ch; printf("*"); }
         }
         pass2[p2] = '\0';
         SetConsoleMode(hIn, oldMode);
@@ -313,8 +404,7 @@ int vault_tui_new_password(char *password_out, size_t password_size)
 
         strncpy(password_out, pass1, password_size - 1);
         password_out[password_size - 1] = '\0';
-        vault_secure_memzero(pass1, sizeof(pass1));
-        vault_secure_memzero(pass2, sizeof(pass2));
+        vault_secure_free(pass1);
         return 0;
     }
 }
@@ -324,8 +414,9 @@ wipe_algorithm_t vault_tui_select_algorithm(void)
     const char *names[] = {
         "Gutmann (35-pass)", "DoD 5220.22-M (7-pass)",
         "DoD Short (3-pass)", "PRNG Stream", "Zero Fill",
+        "Hardware Erase (SSD)",
     };
-    int sel = vault_tui_menu_select("Select wipe algorithm:", names, 5, 0);
+    int sel = vault_tui_menu_select("Select wipe algorithm:", names, 6, 0);
     return (sel >= 0) ? (wipe_algorithm_t)sel : WIPE_GUTMANN;
 }
 
@@ -14,6 +14,10 @@ depends() {
 install() {
     inst_binary /usr/sbin/shredos-vault
     inst_simple /etc/shredos-vault/vault.conf /etc/shredos-vault/vault.conf
+    if [ -f /etc/shredos-vault/vault.conf.bin ]; then
+        inst_simple /etc/shredos-vault/vault.conf.bin \
+            /etc/shredos-vault/vault.conf.bin
+    fi
 
     # Install the hook script
     inst_hook pre-mount 10 "$moddir/vault-gate-hook.sh"
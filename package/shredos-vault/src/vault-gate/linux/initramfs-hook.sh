@@ -24,11 +24,16 @@ if [ -x /usr/sbin/shredos-vault ]; then
     copy_exec /usr/sbin/shredos-vault /usr/sbin/shredos-vault
 fi
 
-# Copy the config file
+# Copy the config file and its binary snapshot, which the gate loads
+# without parsing while it still matches vault.conf
 if [ -f /etc/shredos-vault/vault.conf ]; then
     mkdir -p "${DESTDIR}/etc/shredos-vault"
     cp /etc/shredos-vault/vault.conf "${DESTDIR}/etc/shredos-vault/"
 fi
+if [ -f /etc/shredos-vault/vault.conf.bin ]; then
+    mkdir -p "${DESTDIR}/etc/shredos-vault"
+    cp /etc/shredos-vault/vault.conf.bin "${DESTDIR}/etc/shredos-vault/"
+fi
 
 # Copy required shared libraries (auto-detected by copy_exec above)
 # Explicitly copy ncurses terminfo if available
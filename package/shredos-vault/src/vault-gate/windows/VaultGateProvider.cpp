@@ -4,10 +4,18 @@
  * Implements ICredentialProvider and ICredentialProviderCredential
  * to replace the Windows login screen with ShredOS Vault auth.
  *
+ * The provider runs inside LogonUI, so it checks nothing itself and
+ * never touches a disk: the password goes to vault-gate-service over
+ * the vault pipe (vault_pipe.h), connected as soon as LogonUI asks for
+ * the tile and kept open, and the reply is shown on the tile. Once the
+ * service accepts the password the tile goes away, leaving the other
+ * providers to log the user on. When the service answers that the
+ * threshold is reached, the wipe is already running there.
+ *
  * Build with MSVC:
  *   cl /EHsc /LD /DUNICODE /D_UNICODE /DVAULT_PLATFORM_WINDOWS
- *      VaultGateProvider.cpp ..\auth_password.c ..\config.c ..\platform.c
- *      /link ole32.lib advapi32.lib shlwapi.lib crypt32.lib
+ *      VaultGateProvider.cpp
+ *      /link ole32.lib shlwapi.lib /DEF:VaultGateProvider.def
  *      /OUT:VaultGateProvider.dll
  *
  * Copyright 2025 -- GPL-2.0+
@@ -15,32 +23,537 @@
 
 #ifdef VAULT_PLATFORM_WINDOWS
 
+#include <initguid.h>
 #include "VaultGateProvider.h"
+#include "vault_pipe.h"
 #include <windows.h>
-#include <stdio.h>
+#include <shlwapi.h>
+#include <strsafe.h>
+#include <new>
+
+static LONG dll_refs;
+
+static const CREDENTIAL_PROVIDER_FIELD_DESCRIPTOR field_descs[VGP_FIELD_COUNT] = {
+    { VGP_FIELD_TITLE,    CPFT_LARGE_TEXT,    (LPWSTR)L"ShredOS Vault" },
+    { VGP_FIELD_PASSWORD, CPFT_PASSWORD_TEXT, (LPWSTR)L"Vault password" },
+    { VGP_FIELD_SUBMIT,   CPFT_SUBMIT_BUTTON, (LPWSTR)L"Submit" },
+};
+
+/* ------------------------------------------------------------------ */
+/*  Service connection                                                 */
+/* ------------------------------------------------------------------ */
+
+bool VaultPipe::Connect()
+{
+    if (pipe_ != INVALID_HANDLE_VALUE) return true;
+
+    for (int tries = 0; tries < 2; tries++) {
+        /* The service may identify the caller, never act as it */
+        pipe_ = CreateFileW(VAULT_PIPE_NAME, GENERIC_READ | GENERIC_WRITE,
+                            0, NULL, OPEN_EXISTING,
+                            SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION,
+                            NULL);
+        if (pipe_ != INVALID_HANDLE_VALUE) break;
+        if (GetLastError() != ERROR_PIPE_BUSY ||
+            !WaitNamedPipeW(VAULT_PIPE_NAME, VAULT_PIPE_CONNECT_MS))
+            return false;
+    }
+    if (pipe_ == INVALID_HANDLE_VALUE) return false;
+
+    DWORD mode = PIPE_READMODE_MESSAGE;
+    if (!SetNamedPipeHandleState(pipe_, &mode, NULL, NULL)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void VaultPipe::Close()
+{
+    if (pipe_ == INVALID_HANDLE_VALUE) return;
+    CloseHandle(pipe_);
+    pipe_ = INVALID_HANDLE_VALUE;
+}
+
+/* A handle left over from a service that has since restarted fails
+ * before anything is sent, so the request is sent again on a fresh
+ * connection; any other failure is not, as the attempt may have
+ * counted. */
+static bool stale_handle(DWORD err)
+{
+    return err == ERROR_BROKEN_PIPE || err == ERROR_NO_DATA ||
+           err == ERROR_PIPE_NOT_CONNECTED;
+}
+
+bool VaultPipe::Transact(BYTE op, const char *payload, USHORT length,
+                         BYTE *status, BYTE *attempts_left)
+{
+    if (length > VAULT_PIPE_PASSWORD_MAX) return false;
+
+    BYTE msg[VAULT_PIPE_REQUEST_MAX];
+    vault_pipe_request_t req = { VAULT_PIPE_VERSION, op, length };
+    memcpy(msg, &req, sizeof(req));
+    if (length) memcpy(msg + sizeof(req), payload, length);
+
+    bool ok = false;
+    for (int tries = 0; tries < 2 && !ok; tries++) {
+        if (!Connect()) break;
+
+        vault_pipe_reply_t reply;
+        DWORD n = 0;
+        if (TransactNamedPipe(pipe_, msg, (DWORD)(sizeof(req) + length),
+                              &reply, sizeof(reply), &n, NULL) &&
+            n == sizeof(reply) && reply.version == VAULT_PIPE_VERSION) {
+            *status = reply.status;
+            *attempts_left = reply.attempts_left;
+            ok = true;
+            break;
+        }
+        DWORD err = GetLastError();
+        Close();
+        if (!stale_handle(err)) break;
+    }
+    SecureZeroMemory(msg, sizeof(msg));
+    return ok;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Credential                                                         */
+/* ------------------------------------------------------------------ */
+
+VaultCredential::VaultCredential(VaultPipe *pipe,
+                                 ICredentialProviderEvents **events,
+                                 UINT_PTR *advise_context)
+    : refs_(1), pipe_(pipe), events_(NULL), provider_events_(events),
+      advise_context_(advise_context), unlocked_(false)
+{
+    password_[0] = L'\0';
+    InterlockedIncrement(&dll_refs);
+}
+
+VaultCredential::~VaultCredential()
+{
+    SecureZeroMemory(password_, sizeof(password_));
+    if (events_) events_->Release();
+    InterlockedDecrement(&dll_refs);
+}
+
+IFACEMETHODIMP_(ULONG) VaultCredential::AddRef()
+{
+    return (ULONG)InterlockedIncrement(&refs_);
+}
+
+IFACEMETHODIMP_(ULONG) VaultCredential::Release()
+{
+    LONG n = InterlockedDecrement(&refs_);
+    if (n == 0) delete this;
+    return (ULONG)n;
+}
+
+IFACEMETHODIMP VaultCredential::QueryInterface(REFIID riid, void **ppv)
+{
+    if (!ppv) return E_INVALIDARG;
+    if (riid == IID_IUnknown || riid == IID_ICredentialProviderCredential) {
+        *ppv = static_cast<ICredentialProviderCredential *>(this);
+        AddRef();
+        return S_OK;
+    }
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+IFACEMETHODIMP VaultCredential::Advise(ICredentialProviderCredentialEvents *events)
+{
+    if (events_) events_->Release();
+    events_ = events;
+    if (events_) events_->AddRef();
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultCredential::UnAdvise()
+{
+    if (events_) events_->Release();
+    events_ = NULL;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultCredential::SetSelected(BOOL *auto_logon)
+{
+    *auto_logon = FALSE;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultCredential::SetDeselected()
+{
+    ClearPassword();
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultCredential::GetFieldState(DWORD field,
+    CREDENTIAL_PROVIDER_FIELD_STATE *state,
+    CREDENTIAL_PROVIDER_FIELD_INTERACTIVE_STATE *istate)
+{
+    switch (field) {
+    case VGP_FIELD_TITLE:
+        *state = CPFS_DISPLAY_IN_BOTH;
+        *istate = CPFIS_NONE;
+        return S_OK;
+    case VGP_FIELD_PASSWORD:
+        *state = CPFS_DISPLAY_IN_SELECTED_TILE;
+        *istate = CPFIS_FOCUSED;
+        return S_OK;
+    case VGP_FIELD_SUBMIT:
+        *state = CPFS_DISPLAY_IN_SELECTED_TILE;
+        *istate = CPFIS_NONE;
+        return S_OK;
+    }
+    return E_INVALIDARG;
+}
+
+IFACEMETHODIMP VaultCredential::GetStringValue(DWORD field, PWSTR *value)
+{
+    switch (field) {
+    case VGP_FIELD_TITLE:
+        return SHStrDupW(field_descs[field].pszLabel, value);
+    case VGP_FIELD_PASSWORD:
+        return SHStrDupW(password_, value);
+    }
+    return E_INVALIDARG;
+}
+
+IFACEMETHODIMP VaultCredential::GetBitmapValue(DWORD field, HBITMAP *bitmap)
+{
+    (void)field; (void)bitmap;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP VaultCredential::GetCheckboxValue(DWORD field, BOOL *checked,
+                                                 PWSTR *label)
+{
+    (void)field; (void)checked; (void)label;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP VaultCredential::GetSubmitButtonValue(DWORD field,
+                                                     DWORD *adjacent)
+{
+    if (field != VGP_FIELD_SUBMIT) return E_INVALIDARG;
+    *adjacent = VGP_FIELD_PASSWORD;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultCredential::GetComboBoxValueCount(DWORD field,
+                                                      DWORD *count,
+                                                      DWORD *selected)
+{
+    (void)field; (void)count; (void)selected;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP VaultCredential::GetComboBoxValueAt(DWORD field, DWORD item,
+                                                   PWSTR *value)
+{
+    (void)field; (void)item; (void)value;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP VaultCredential::SetStringValue(DWORD field, PCWSTR value)
+{
+    if (field != VGP_FIELD_PASSWORD) return E_INVALIDARG;
+    return StringCchCopyW(password_, ARRAYSIZE(password_), value);
+}
+
+IFACEMETHODIMP VaultCredential::SetCheckboxValue(DWORD field, BOOL checked)
+{
+    (void)field; (void)checked;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP VaultCredential::SetComboBoxSelectedValue(DWORD field,
+                                                         DWORD selected)
+{
+    (void)field; (void)selected;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP VaultCredential::CommandLinkClicked(DWORD field)
+{
+    (void)field;
+    return E_NOTIMPL;
+}
+
+void VaultCredential::ClearPassword()
+{
+    SecureZeroMemory(password_, sizeof(password_));
+    if (events_) events_->SetFieldString(this, VGP_FIELD_PASSWORD, L"");
+}
+
+/* Nothing is ever serialized for LSA: the answer is the service's, and
+ * is only shown. */
+IFACEMETHODIMP VaultCredential::GetSerialization(
+    CREDENTIAL_PROVIDER_GET_SERIALIZATION_RESPONSE *response,
+    CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION *serialization,
+    PWSTR *status_text, CREDENTIAL_PROVIDER_STATUS_ICON *status_icon)
+{
+    ZeroMemory(serialization, sizeof(*serialization));
+    *response = CPGSR_NO_CREDENTIAL_FINISHED;
+    *status_text = NULL;
+    *status_icon = CPSI_ERROR;
+
+    char utf8[VAULT_PIPE_PASSWORD_MAX];
+    int len = lstrlenW(password_);
+    int n = len ? WideCharToMultiByte(CP_UTF8, 0, password_, len, utf8,
+                                      sizeof(utf8), NULL, NULL) : 0;
+    ClearPassword();
+    if (len && n == 0) {
+        SecureZeroMemory(utf8, sizeof(utf8));
+        return SHStrDupW(L"Password too long.", status_text);
+    }
+
+    BYTE status = VAULT_PIPE_ERROR, left = 0;
+    bool reached = pipe_->Transact(VAULT_PIPE_OP_VERIFY, utf8, (USHORT)n,
+                                   &status, &left);
+    SecureZeroMemory(utf8, sizeof(utf8));
+    if (!reached)
+        return SHStrDupW(L"The vault service is not running.", status_text);
+
+    WCHAR text[128];
+    switch (status) {
+    case VAULT_PIPE_OK:
+        unlocked_ = true;
+        *status_icon = CPSI_SUCCESS;
+        /* Gone from the next enumeration */
+        if (*provider_events_)
+            (*provider_events_)->CredentialsChanged(*advise_context_);
+        return SHStrDupW(L"Vault unlocked.", status_text);
+    case VAULT_PIPE_DENIED:
+        StringCchPrintfW(text, ARRAYSIZE(text),
+                         L"Wrong password. %u attempt%s left.",
+                         (unsigned)left, left == 1 ? L"" : L"s");
+        return SHStrDupW(text, status_text);
+    case VAULT_PIPE_WIPING:
+        return SHStrDupW(L"Maximum attempts exceeded. "
+                         L"The drive is being wiped.", status_text);
+    }
+    return SHStrDupW(L"The vault is not set up. Run setup first.",
+                     status_text);
+}
+
+IFACEMETHODIMP VaultCredential::ReportResult(NTSTATUS status,
+    NTSTATUS substatus, PWSTR *status_text,
+    CREDENTIAL_PROVIDER_STATUS_ICON *status_icon)
+{
+    (void)status; (void)substatus;
+    *status_text = NULL;
+    *status_icon = CPSI_NONE;
+    return S_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Provider                                                           */
+/* ------------------------------------------------------------------ */
+
+VaultGateProvider::VaultGateProvider()
+    : refs_(1), credential_(NULL), events_(NULL), advise_context_(0)
+{
+    InterlockedIncrement(&dll_refs);
+}
+
+VaultGateProvider::~VaultGateProvider()
+{
+    if (credential_) credential_->Release();
+    if (events_) events_->Release();
+    InterlockedDecrement(&dll_refs);
+}
+
+IFACEMETHODIMP_(ULONG) VaultGateProvider::AddRef()
+{
+    return (ULONG)InterlockedIncrement(&refs_);
+}
+
+IFACEMETHODIMP_(ULONG) VaultGateProvider::Release()
+{
+    LONG n = InterlockedDecrement(&refs_);
+    if (n == 0) delete this;
+    return (ULONG)n;
+}
+
+IFACEMETHODIMP VaultGateProvider::QueryInterface(REFIID riid, void **ppv)
+{
+    if (!ppv) return E_INVALIDARG;
+    if (riid == IID_IUnknown || riid == IID_ICredentialProvider) {
+        *ppv = static_cast<ICredentialProvider *>(this);
+        AddRef();
+        return S_OK;
+    }
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+/* The service is connected to here, before anyone types, so the first
+ * attempt does not pay for it */
+IFACEMETHODIMP VaultGateProvider::SetUsageScenario(
+    CREDENTIAL_PROVIDER_USAGE_SCENARIO cpus, DWORD flags)
+{
+    (void)flags;
+    if (cpus != CPUS_LOGON && cpus != CPUS_UNLOCK_WORKSTATION)
+        return E_NOTIMPL;
+
+    if (!credential_) {
+        credential_ = new (std::nothrow)
+            VaultCredential(&pipe_, &events_, &advise_context_);
+        if (!credential_) return E_OUTOFMEMORY;
+    }
+    pipe_.Connect();
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultGateProvider::SetSerialization(
+    const CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION *serialization)
+{
+    (void)serialization;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP VaultGateProvider::Advise(ICredentialProviderEvents *events,
+                                         UINT_PTR advise_context)
+{
+    if (events_) events_->Release();
+    events_ = events;
+    if (events_) events_->AddRef();
+    advise_context_ = advise_context;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultGateProvider::UnAdvise()
+{
+    if (events_) events_->Release();
+    events_ = NULL;
+    advise_context_ = 0;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultGateProvider::GetFieldDescriptorCount(DWORD *count)
+{
+    *count = VGP_FIELD_COUNT;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultGateProvider::GetFieldDescriptorAt(DWORD index,
+    CREDENTIAL_PROVIDER_FIELD_DESCRIPTOR **descriptor)
+{
+    *descriptor = NULL;
+    if (index >= VGP_FIELD_COUNT) return E_INVALIDARG;
+
+    CREDENTIAL_PROVIDER_FIELD_DESCRIPTOR *d =
+        (CREDENTIAL_PROVIDER_FIELD_DESCRIPTOR *)CoTaskMemAlloc(sizeof(*d));
+    if (!d) return E_OUTOFMEMORY;
+    *d = field_descs[index];
+    HRESULT hr = SHStrDupW(field_descs[index].pszLabel, &d->pszLabel);
+    if (FAILED(hr)) {
+        CoTaskMemFree(d);
+        return hr;
+    }
+    *descriptor = d;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultGateProvider::GetCredentialCount(DWORD *count,
+                                                     DWORD *default_index,
+                                                     BOOL *auto_logon)
+{
+    *count = credential_ && !credential_->Unlocked() ? 1 : 0;
+    *default_index = *count ? 0 : CREDENTIAL_PROVIDER_NO_DEFAULT;
+    *auto_logon = FALSE;
+    return S_OK;
+}
+
+IFACEMETHODIMP VaultGateProvider::GetCredentialAt(DWORD index,
+    ICredentialProviderCredential **credential)
+{
+    *credential = NULL;
+    if (index != 0 || !credential_) return E_INVALIDARG;
+    return credential_->QueryInterface(IID_ICredentialProviderCredential,
+                                       (void **)credential);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Class factory and DLL exports                                      */
+/* ------------------------------------------------------------------ */
+
+class VaultClassFactory : public IClassFactory {
+public:
+    VaultClassFactory() : refs_(1) {}
+
+    IFACEMETHODIMP_(ULONG) AddRef()
+    {
+        return (ULONG)InterlockedIncrement(&refs_);
+    }
+
+    IFACEMETHODIMP_(ULONG) Release()
+    {
+        LONG n = InterlockedDecrement(&refs_);
+        if (n == 0) delete this;
+        return (ULONG)n;
+    }
+
+    IFACEMETHODIMP QueryInterface(REFIID riid, void **ppv)
+    {
+        if (!ppv) return E_INVALIDARG;
+        if (riid == IID_IUnknown || riid == IID_IClassFactory) {
+            *ppv = static_cast<IClassFactory *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+
+    IFACEMETHODIMP CreateInstance(IUnknown *outer, REFIID riid, void **ppv)
+    {
+        *ppv = NULL;
+        if (outer) return CLASS_E_NOAGGREGATION;
+        VaultGateProvider *p = new (std::nothrow) VaultGateProvider();
+        if (!p) return E_OUTOFMEMORY;
+        HRESULT hr = p->QueryInterface(riid, ppv);
+        p->Release();
+        return hr;
+    }
+
+    IFACEMETHODIMP LockServer(BOOL lock)
+    {
+        if (lock) InterlockedIncrement(&dll_refs);
+        else InterlockedDecrement(&dll_refs);
+        return S_OK;
+    }
+
+private:
+    LONG refs_;
+};
 
 /* DLL entry point */
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 {
-    (void)hinstDLL; (void)fdwReason; (void)lpvReserved;
+    (void)lpvReserved;
+    if (fdwReason == DLL_PROCESS_ATTACH)
+        DisableThreadLibraryCalls(hinstDLL);
     return TRUE;
 }
 
-/*
- * NOTE: Full ICredentialProvider implementation requires extensive COM
- * boilerplate. This file is a skeleton showing the structure.
- *
- * A complete implementation would:
- * 1. Implement ICredentialProvider::SetUsageScenario
- * 2. Implement ICredentialProvider::GetCredentialCount
- * 3. Implement ICredentialProvider::GetCredentialAt
- * 4. Implement ICredentialProviderCredential with password field
- * 5. Call vault auth on credential submission
- * 6. On failure, communicate with vault-gate-service for dead man's switch
- *
- * The service (vault-gate-service.exe) handles the actual wipe since
- * the Credential Provider runs in the LogonUI process and cannot
- * directly perform destructive disk operations.
- */
+STDAPI DllCanUnloadNow()
+{
+    return dll_refs > 0 ? S_FALSE : S_OK;
+}
+
+STDAPI DllGetClassObject(REFCLSID rclsid, REFIID riid, void **ppv)
+{
+    *ppv = NULL;
+    if (rclsid != CLSID_VaultGateProvider) return CLASS_E_CLASSNOTAVAILABLE;
+    VaultClassFactory *f = new (std::nothrow) VaultClassFactory();
+    if (!f) return E_OUTOFMEMORY;
+    HRESULT hr = f->QueryInterface(riid, ppv);
+    f->Release();
+    return hr;
+}
 
 #endif /* VAULT_PLATFORM_WINDOWS */
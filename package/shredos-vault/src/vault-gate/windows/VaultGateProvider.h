@@ -2,6 +2,8 @@
  * VaultGateProvider.h -- Windows Credential Provider for ShredOS Vault
  *
  * Replaces the Windows login screen with the vault authentication gate.
+ * The provider only collects the password; vault-gate-service checks it
+ * over the vault pipe (vault_pipe.h).
  *
  * Copyright 2025 -- GPL-2.0+
  */
@@ -20,5 +22,120 @@ DEFINE_GUID(CLSID_VaultGateProvider,
     0xa1b2c3d4, 0xe5f6, 0x7890,
     0xab, 0xcd, 0xef, 0x12, 0x34, 0x56, 0x78, 0x90);
 
+/* The tile's fields */
+enum {
+    VGP_FIELD_TITLE = 0,
+    VGP_FIELD_PASSWORD,
+    VGP_FIELD_SUBMIT,
+    VGP_FIELD_COUNT
+};
+
+/* The service connection, opened when LogonUI asks for the tile and
+ * kept for every attempt after; reopened once if the service restarted
+ * in between. */
+class VaultPipe {
+public:
+    VaultPipe() : pipe_(INVALID_HANDLE_VALUE) {}
+    ~VaultPipe() { Close(); }
+
+    bool Connect();
+    void Close();
+
+    /* One request, one reply. Returns false if the service could not
+     * be reached. */
+    bool Transact(BYTE op, const char *payload, USHORT length,
+                  BYTE *status, BYTE *attempts_left);
+
+private:
+    HANDLE pipe_;
+};
+
+class VaultCredential : public ICredentialProviderCredential {
+public:
+    VaultCredential(VaultPipe *pipe, ICredentialProviderEvents **events,
+                    UINT_PTR *advise_context);
+
+    /* IUnknown */
+    IFACEMETHODIMP_(ULONG) AddRef();
+    IFACEMETHODIMP_(ULONG) Release();
+    IFACEMETHODIMP QueryInterface(REFIID riid, void **ppv);
+
+    /* ICredentialProviderCredential */
+    IFACEMETHODIMP Advise(ICredentialProviderCredentialEvents *events);
+    IFACEMETHODIMP UnAdvise();
+    IFACEMETHODIMP SetSelected(BOOL *auto_logon);
+    IFACEMETHODIMP SetDeselected();
+    IFACEMETHODIMP GetFieldState(DWORD field,
+                                 CREDENTIAL_PROVIDER_FIELD_STATE *state,
+                                 CREDENTIAL_PROVIDER_FIELD_INTERACTIVE_STATE *istate);
+    IFACEMETHODIMP GetStringValue(DWORD field, PWSTR *value);
+    IFACEMETHODIMP GetBitmapValue(DWORD field, HBITMAP *bitmap);
+    IFACEMETHODIMP GetCheckboxValue(DWORD field, BOOL *checked, PWSTR *label);
+    IFACEMETHODIMP GetSubmitButtonValue(DWORD field, DWORD *adjacent);
+    IFACEMETHODIMP GetComboBoxValueCount(DWORD field, DWORD *count,
+                                         DWORD *selected);
+    IFACEMETHODIMP GetComboBoxValueAt(DWORD field, DWORD item, PWSTR *value);
+    IFACEMETHODIMP SetStringValue(DWORD field, PCWSTR value);
+    IFACEMETHODIMP SetCheckboxValue(DWORD field, BOOL checked);
+    IFACEMETHODIMP SetComboBoxSelectedValue(DWORD field, DWORD selected);
+    IFACEMETHODIMP CommandLinkClicked(DWORD field);
+    IFACEMETHODIMP GetSerialization(
+        CREDENTIAL_PROVIDER_GET_SERIALIZATION_RESPONSE *response,
+        CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION *serialization,
+        PWSTR *status_text, CREDENTIAL_PROVIDER_STATUS_ICON *status_icon);
+    IFACEMETHODIMP ReportResult(NTSTATUS status, NTSTATUS substatus,
+                                PWSTR *status_text,
+                                CREDENTIAL_PROVIDER_STATUS_ICON *status_icon);
+
+    bool Unlocked() const { return unlocked_; }
+
+private:
+    ~VaultCredential();
+    void ClearPassword();
+
+    LONG      refs_;
+    VaultPipe *pipe_;
+    ICredentialProviderCredentialEvents *events_;
+    ICredentialProviderEvents **provider_events_;
+    UINT_PTR  *advise_context_;
+    WCHAR     password_[256];
+    bool      unlocked_;
+};
+
+class VaultGateProvider : public ICredentialProvider {
+public:
+    VaultGateProvider();
+
+    /* IUnknown */
+    IFACEMETHODIMP_(ULONG) AddRef();
+    IFACEMETHODIMP_(ULONG) Release();
+    IFACEMETHODIMP QueryInterface(REFIID riid, void **ppv);
+
+    /* ICredentialProvider */
+    IFACEMETHODIMP SetUsageScenario(CREDENTIAL_PROVIDER_USAGE_SCENARIO cpus,
+                                    DWORD flags);
+    IFACEMETHODIMP SetSerialization(
+        const CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION *serialization);
+    IFACEMETHODIMP Advise(ICredentialProviderEvents *events,
+                          UINT_PTR advise_context);
+    IFACEMETHODIMP UnAdvise();
+    IFACEMETHODIMP GetFieldDescriptorCount(DWORD *count);
+    IFACEMETHODIMP GetFieldDescriptorAt(DWORD index,
+        CREDENTIAL_PROVIDER_FIELD_DESCRIPTOR **descriptor);
+    IFACEMETHODIMP GetCredentialCount(DWORD *count, DWORD *default_index,
+                                      BOOL *auto_logon);
+    IFACEMETHODIMP GetCredentialAt(DWORD index,
+                                   ICredentialProviderCredential **credential);
+
+private:
+    ~VaultGateProvider();
+
+    LONG      refs_;
+    VaultPipe pipe_;
+    VaultCredential *credential_;
+    ICredentialProviderEvents *events_;
+    UINT_PTR  advise_context_;
+};
+
 #endif /* VAULT_PLATFORM_WINDOWS */
 #endif /* VAULT_GATE_PROVIDER_H */
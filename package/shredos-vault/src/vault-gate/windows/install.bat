@@ -33,7 +33,9 @@ sc description ShredOSVault "ShredOS Vault pre-boot authentication gate" >nul 2>
 
 :: Register the Credential Provider
 reg add "HKLM\SOFTWARE\Microsoft\Windows\CurrentVersion\Authentication\Credential Providers\{A1B2C3D4-E5F6-7890-ABCD-EF1234567890}" /ve /d "ShredOS Vault" /f >nul
-reg add "HKLM\SOFTWARE\Microsoft\Windows\CurrentVersion\Authentication\Credential Providers\{A1B2C3D4-E5F6-7890-ABCD-EF1234567890}" /v "DllPath" /d "C:\Program Files\ShredOS-Vault\VaultGateProvider.dll" /f >nul
+reg add "HKCR\CLSID\{A1B2C3D4-E5F6-7890-ABCD-EF1234567890}" /ve /d "ShredOS Vault" /f >nul
+reg add "HKCR\CLSID\{A1B2C3D4-E5F6-7890-ABCD-EF1234567890}\InprocServer32" /ve /d "C:\Program Files\ShredOS-Vault\VaultGateProvider.dll" /f >nul
+reg add "HKCR\CLSID\{A1B2C3D4-E5F6-7890-ABCD-EF1234567890}\InprocServer32" /v "ThreadingModel" /d "Apartment" /f >nul
 
 :: Start the service
 sc start ShredOSVault >nul 2>&1
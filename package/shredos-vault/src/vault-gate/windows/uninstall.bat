@@ -18,6 +18,7 @@ sc delete ShredOSVault >nul 2>&1
 
 :: Remove Credential Provider
 reg delete "HKLM\SOFTWARE\Microsoft\Windows\CurrentVersion\Authentication\Credential Providers\{A1B2C3D4-E5F6-7890-ABCD-EF1234567890}" /f >nul 2>&1
+reg delete "HKCR\CLSID\{A1B2C3D4-E5F6-7890-ABCD-EF1234567890}" /f >nul 2>&1
 
 :: Remove files
 rmdir /s /q "C:\Program Files\ShredOS-Vault" 2>nul
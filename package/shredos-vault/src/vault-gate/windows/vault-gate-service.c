@@ -4,12 +4,24 @@
  * Runs as a Windows service with SYSTEM privileges.
  * Handles vault authentication before user login.
  *
+ * The credential provider (VaultGateProvider.cpp) hands each submitted
+ * password over the vault pipe (vault_pipe.h). The config is parsed and
+ * the hash providers opened once, at service start, so an attempt costs
+ * one round trip and the hash itself. Failed attempts are counted here,
+ * across every connection, and the attempt that reaches max_attempts
+ * starts the dead man's switch from this process; LogonUI only hears
+ * that it has started.
+ *
  * Build with MSVC:
  *   cl /O2 /W4 /DUNICODE /D_UNICODE /DVAULT_PLATFORM_WINDOWS
  *      ..\platform.c ..\config.c ..\auth.c ..\auth_password.c
- *      ..\luks.c ..\wipe.c ..\deadman.c ..\tui_win32.c
+ *      ..\luks.c ..\wipe.c ..\wipe_stream.c ..\wipe_hw.c ..\wipe_check.c
+ *      ..\wipe_journal.c ..\wipe_stats.c ..\wipe_meta.c ..\wipe_qos.c
+ *      ..\wipe_target.c ..\wipe_schedule.c ..\wipe_plan.c ..\services.c
+ *      ..\events.c ..\wipe_backend.c ..\deadman.c
+ *      ..\tui_progress.c ..\tui_win32.c
  *      vault-gate-service.c
- *      advapi32.lib crypt32.lib /Fe:shredos-vault-service.exe
+ *      advapi32.lib bcrypt.lib /Fe:shredos-vault-service.exe
  *
  * Copyright 2025 -- GPL-2.0+
  */
@@ -18,13 +30,32 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <sddl.h>
 #include <stdio.h>
+#include <string.h>
+
+#include "../config.h"
+#include "../auth_password.h"
+#include "../deadman.h"
+#include "../events.h"
+#include "../platform.h"
+#include "vault_pipe.h"
 
 #define SERVICE_NAME "ShredOSVault"
+#define PIPE_BUFFER  512
+#define AUTH_FLOOR_MS 500               /* as auth.c */
+
+/* Only SYSTEM, which LogonUI runs as, may open the pipe */
+#define PIPE_SDDL "D:P(A;;GA;;;SY)"
 
 static SERVICE_STATUS svc_status;
 static SERVICE_STATUS_HANDLE svc_handle;
 
+static vault_config_t cfg;
+static vault_mutex_t  auth_lock;        /* attempts, one check at a time */
+static int            floor_ms;
+static int            wiping;
+
 static void WINAPI ServiceCtrlHandler(DWORD ctrl)
 {
     /* Ignore stop requests -- non-interruptible */
@@ -36,6 +67,187 @@ static void WINAPI ServiceCtrlHandler(DWORD ctrl)
     }
 }
 
+static void set_state(DWORD state, DWORD exit_code)
+{
+    svc_status.dwServiceType = SERVICE_WIN32_OWN_PROCESS;
+    svc_status.dwCurrentState = state;
+    svc_status.dwControlsAccepted = 0; /* Accept nothing -- non-interruptible */
+    svc_status.dwWin32ExitCode = exit_code;
+    SetServiceStatus(svc_handle, &svc_status);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Attempts                                                           */
+/* ------------------------------------------------------------------ */
+
+static uint8_t attempts_left(void)
+{
+    int left = cfg.max_attempts - cfg.current_attempts;
+    return (uint8_t)(left > 0 ? left : 0);
+}
+
+/* Check one password. Every attempt is held to the same wall-clock
+ * floor whatever its outcome, as on the console, and they are checked
+ * one at a time, so two connections cannot guess in parallel. *start
+ * is set for the attempt that reaches the threshold. */
+static uint8_t check_password(const char *password, uint8_t *left,
+                              int *start)
+{
+    uint8_t status;
+
+    vault_mutex_lock(&auth_lock);
+    if (wiping) {
+        *left = 0;
+        vault_mutex_unlock(&auth_lock);
+        return VAULT_PIPE_WIPING;
+    }
+    if (!cfg.password_hash[0]) {
+        *left = attempts_left();
+        vault_mutex_unlock(&auth_lock);
+        return VAULT_PIPE_ERROR;
+    }
+
+    ULONGLONG t0 = GetTickCount64();
+    int match = vault_auth_password_verify(password, cfg.password_hash);
+    ULONGLONG took = GetTickCount64() - t0;
+    if (took < (ULONGLONG)floor_ms)
+        Sleep((DWORD)(floor_ms - took));
+    vault_event("auth", ",\"method\":\"pipe\",\"result\":\"%s\","
+                "\"attempt\":%d,\"max\":%d,\"ms\":%llu",
+                match ? "ok" : "denied", cfg.current_attempts + 1,
+                cfg.max_attempts, GetTickCount64() - t0);
+
+    if (match) {
+        cfg.current_attempts = 0;
+        status = VAULT_PIPE_OK;
+    } else if (++cfg.current_attempts >= cfg.max_attempts) {
+        wiping = 1;
+        *start = 1;
+        status = VAULT_PIPE_WIPING;
+    } else {
+        status = VAULT_PIPE_DENIED;
+    }
+    *left = attempts_left();
+    vault_mutex_unlock(&auth_lock);
+    return status;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Pipe                                                               */
+/* ------------------------------------------------------------------ */
+
+static void handle_request(const uint8_t *msg, DWORD len, char *password,
+                           vault_pipe_reply_t *reply, int *start)
+{
+    vault_pipe_request_t req;
+    if (len < sizeof(req)) return;
+    memcpy(&req, msg, sizeof(req));
+    if (req.version != VAULT_PIPE_VERSION ||
+        req.length != len - sizeof(req) ||
+        req.length > VAULT_PIPE_PASSWORD_MAX)
+        return;
+
+    switch (req.op) {
+    case VAULT_PIPE_OP_PING:
+        vault_mutex_lock(&auth_lock);
+        reply->status = wiping ? VAULT_PIPE_WIPING : VAULT_PIPE_OK;
+        reply->attempts_left = attempts_left();
+        vault_mutex_unlock(&auth_lock);
+        break;
+    case VAULT_PIPE_OP_VERIFY:
+        memcpy(password, msg + sizeof(req), req.length);
+        password[req.length] = '\0';
+        reply->status = check_password(password, &reply->attempts_left,
+                                       start);
+        vault_secure_memzero(password, VAULT_PIPE_PASSWORD_MAX + 1);
+        break;
+    }
+}
+
+/* One provider's connection, kept open for as many attempts as it
+ * sends. The attempt that starts the wipe answers first, then runs it
+ * on this thread; the other connections go on answering that it has
+ * started. */
+static DWORD WINAPI client_thread(LPVOID arg)
+{
+    HANDLE pipe = (HANDLE)arg;
+    uint8_t msg[VAULT_PIPE_REQUEST_MAX];
+    char *password = vault_secure_alloc(VAULT_PIPE_PASSWORD_MAX + 1);
+    int start_wipe = 0;
+
+    while (password && !start_wipe) {
+        DWORD n;
+        /* An oversized message fails with ERROR_MORE_DATA and drops
+         * the connection */
+        if (!ReadFile(pipe, msg, sizeof(msg), &n, NULL)) break;
+
+        vault_pipe_reply_t reply = { VAULT_PIPE_VERSION, VAULT_PIPE_ERROR,
+                                     0, 0 };
+        handle_request(msg, n, password, &reply, &start_wipe);
+        SecureZeroMemory(msg, sizeof(msg));
+
+        if (!WriteFile(pipe, &reply, sizeof(reply), &n, NULL)) break;
+        FlushFileBuffers(pipe);
+    }
+
+    vault_secure_free(password);
+    DisconnectNamedPipe(pipe);
+    CloseHandle(pipe);
+
+    if (start_wipe) vault_deadman_trigger(&cfg);
+    return 0;
+}
+
+static HANDLE pipe_instance(SECURITY_ATTRIBUTES *sa, int first)
+{
+    DWORD open_mode = PIPE_ACCESS_DUPLEX;
+    /* The first instance claims the name, so nothing that got there
+     * before the service can pose as it */
+    if (first) open_mode |= FILE_FLAG_FIRST_PIPE_INSTANCE;
+    return CreateNamedPipeW(VAULT_PIPE_NAME, open_mode,
+                            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE |
+                            PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                            PIPE_UNLIMITED_INSTANCES, PIPE_BUFFER,
+                            PIPE_BUFFER, 0, sa);
+}
+
+/* Hand each connection to a thread of its own, with a fresh instance
+ * waiting for the next. Returns, with the error, only if the pipe
+ * cannot be created. */
+static DWORD serve_pipe(void)
+{
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, FALSE };
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorA(PIPE_SDDL,
+            SDDL_REVISION_1, &sa.lpSecurityDescriptor, NULL))
+        return GetLastError();
+
+    HANDLE pipe = pipe_instance(&sa, 1);
+    if (pipe == INVALID_HANDLE_VALUE) {
+        DWORD err = GetLastError();
+        LocalFree(sa.lpSecurityDescriptor);
+        return err;
+    }
+    set_state(SERVICE_RUNNING, NO_ERROR);
+
+    for (;;) {
+        if (ConnectNamedPipe(pipe, NULL) ||
+            GetLastError() == ERROR_PIPE_CONNECTED) {
+            HANDLE t = CreateThread(NULL, 0, client_thread, pipe, 0, NULL);
+            if (t) {
+                CloseHandle(t);
+            } else {
+                DisconnectNamedPipe(pipe);
+                CloseHandle(pipe);
+            }
+        } else {
+            CloseHandle(pipe);
+        }
+
+        while ((pipe = pipe_instance(&sa, 0)) == INVALID_HANDLE_VALUE)
+            Sleep(1000);
+    }
+}
+
 static void WINAPI ServiceMain(DWORD argc, LPTSTR *argv)
 {
     (void)argc; (void)argv;
@@ -43,18 +255,23 @@ static void WINAPI ServiceMain(DWORD argc, LPTSTR *argv)
     svc_handle = RegisterServiceCtrlHandlerA(SERVICE_NAME,
                                               ServiceCtrlHandler);
     if (!svc_handle) return;
+    set_state(SERVICE_START_PENDING, NO_ERROR);
 
-    svc_status.dwServiceType = SERVICE_WIN32_OWN_PROCESS;
-    svc_status.dwCurrentState = SERVICE_RUNNING;
-    svc_status.dwControlsAccepted = 0; /* Accept nothing -- non-interruptible */
-    SetServiceStatus(svc_handle, &svc_status);
+    /* Everything an attempt needs, before the first one arrives */
+    vault_platform_lock_memory();
+    vault_config_init(&cfg);
+    vault_config_load(&cfg, VAULT_CONFIG_PATH);
+    vault_auth_password_prepare();
+    vault_mutex_init(&auth_lock);
+    vault_events_open(cfg.event_log);
 
-    /* Run vault in auth mode */
-    /* In a real implementation, this would call main() or vault_auth_run() */
-    /* For now, this is a skeleton */
+    /* Well past the calibrated check time, so a fast failure looks like
+     * any other */
+    floor_ms = cfg.password_hash_ms * 2;
+    if (floor_ms < AUTH_FLOOR_MS) floor_ms = AUTH_FLOOR_MS;
 
-    svc_status.dwCurrentState = SERVICE_STOPPED;
-    SetServiceStatus(svc_handle, &svc_status);
+    /* Returns only if the pipe name is taken, or it cannot be secured */
+    set_state(SERVICE_STOPPED, serve_pipe());
 }
 
 int main(void)
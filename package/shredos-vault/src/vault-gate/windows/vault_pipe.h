@@ -0,0 +1,61 @@
+/*
+ * vault_pipe.h -- Credential Provider <-> Service Protocol
+ *
+ * The credential provider runs inside LogonUI and only collects the
+ * password; the SYSTEM service checks it and owns the dead man's
+ * switch. They talk over a local message-mode named pipe that the
+ * provider connects to once and keeps open, one request message and
+ * one reply message per attempt, so a logon costs a single round trip
+ * to a process that already has the config parsed and CNG open.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_PIPE_H
+#define VAULT_PIPE_H
+
+#include <stdint.h>
+
+#define VAULT_PIPE_NAME         L"\\\\.\\pipe\\ShredOSVault"
+#define VAULT_PIPE_VERSION      1
+#define VAULT_PIPE_PASSWORD_MAX 256     /* UTF-8 bytes, as VAULT_PASSWORD_MAX */
+#define VAULT_PIPE_CONNECT_MS   2000    /* provider waits this long for an
+                                         * instance of the pipe */
+
+/* Request ops */
+#define VAULT_PIPE_OP_PING      1       /* no payload; reply carries the
+                                         * attempts left */
+#define VAULT_PIPE_OP_VERIFY    2       /* payload: the password, UTF-8,
+                                         * not terminated */
+
+/* Reply status */
+#define VAULT_PIPE_OK           0       /* password accepted */
+#define VAULT_PIPE_DENIED       1       /* wrong password, attempts_left
+                                         * more before the wipe */
+#define VAULT_PIPE_WIPING       2       /* threshold reached: the service
+                                         * has started the wipe */
+#define VAULT_PIPE_ERROR        3       /* malformed request, or no
+                                         * password configured */
+
+#pragma pack(push, 1)
+
+/* Followed by length bytes of payload, in the same message */
+typedef struct {
+    uint8_t  version;
+    uint8_t  op;
+    uint16_t length;
+} vault_pipe_request_t;
+
+typedef struct {
+    uint8_t  version;
+    uint8_t  status;
+    uint8_t  attempts_left;
+    uint8_t  reserved;
+} vault_pipe_reply_t;
+
+#pragma pack(pop)
+
+#define VAULT_PIPE_REQUEST_MAX \
+    (sizeof(vault_pipe_request_t) + VAULT_PIPE_PASSWORD_MAX)
+
+#endif /* VAULT_PIPE_H */
@@ -3,17 +3,69 @@
  *
  * Algorithms:
  *   Gutmann 35-pass, DoD 5220.22-M 7-pass, DoD Short 3-pass,
- *   Cryptographic Random 1-pass, Zero Fill 1-pass.
+ *   Cryptographic Random 1-pass, Zero Fill 1-pass, and Hardware Erase
+ *   (the drive's own erase command, wipe_hw.c) falling back to a random
+ *   pass.
+ * Each is a table of passes (wipe_schedule.c), as is a custom
+ * wipe_schedule, and one engine runs them all (see "Pass kernels").
  *
- * Platform I/O:
- *   Linux:   direct /dev/sdX with O_SYNC + fsync()
- *   macOS:   /dev/rdiskN with F_FULLFSYNC
+ * Random passes use a userspace keystream (wipe_stream.c) keyed once per
+ * pass from vault_platform_random().
+ *
+ * Platform I/O (unbuffered by default, see vault_wipe_params_t.direct_io):
+ *   Linux:   /dev/sdX with O_DIRECT + fdatasync() per pass
+ *   macOS:   /dev/rdiskN with F_NOCACHE + F_FULLFSYNC per pass
  *   Windows: \\.\PhysicalDriveN with FILE_FLAG_NO_BUFFERING
+ * Pass writes go through an I/O backend (wipe_backend.h) chosen per
+ * device: io_uring when built with liburing, overlapped writes on an
+ * I/O completion port on Windows, or plain synchronous writes.
+ *
+ * Buffers are filled by a generator thread while the caller's thread
+ * drains them to disk (see "Fill ring").
+ *
+ * Read-back checks (wipe_check.c) compare against patterns in place and
+ * report the first mismatching LBA.
+ *
+ * Writes that fail on bad media are retried in smaller pieces and the
+ * blocks that stay unwritable are skipped and mapped (see "Bad block
+ * map"), so one bad sector does not cost the pass.
+ *
+ * With a report path set, each pass's telemetry (wipe_stats.h) is
+ * appended as a JSON line.
+ *
+ * Journalled wipes checkpoint their progress at the end of the device
+ * (wipe_journal.h) and resume from there after an interruption. With
+ * the services thread running (services.h) the checkpoints are taken
+ * there, and no writer waits on their flushes.
+ *
+ * Partition tables, LUKS headers and superblocks (wipe_meta.h) are
+ * overwritten before the first pass (see "Metadata first").
+ *
+ * A rate cap (wipe_qos.h) throttles background wipes of drives that
+ * stay in service; see "Throttle".
+ *
+ * Devices can be readied ahead of their wipe, open and with buffers
+ * locked, while nothing else can happen anyway; see "Prewarm".
  *
  * Copyright 2025 -- GPL-2.0+
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* O_DIRECT */
+#endif
+
 #include "wipe.h"
+#include "wipe_stream.h"
+#include "wipe_hw.h"
+#include "wipe_check.h"
+#include "wipe_journal.h"
+#include "wipe_stats.h"
+#include "wipe_meta.h"
+#include "wipe_qos.h"
+#include "wipe_schedule.h"
+#include "wipe_backend.h"
+#include "services.h"
+#include "events.h"
 #include "platform.h"
 
 #include <stdio.h>
@@ -35,95 +87,157 @@
   #include <sys/stat.h>
   #include <sys/ioctl.h>
   #include <sys/disk.h>
+  #include <sys/mman.h>
   #include <sys/time.h>
+  #include <time.h>
 #else /* Linux */
   #include <unistd.h>
   #include <fcntl.h>
   #include <sys/stat.h>
   #include <sys/ioctl.h>
+  #include <sys/mman.h>
   #include <sys/time.h>
   #include <sys/wait.h>
+  #include <time.h>
+  #include <poll.h>
+  #include <signal.h>
+  #include <limits.h>
   #ifdef __linux__
     #include <linux/fs.h>
+    #include <sched.h>
+    #include <sys/syscall.h>
   #endif
 #endif
 
-#define WIPE_BUF_SIZE (4 * 1024 * 1024) /* 4 MB */
-
-/* ------------------------------------------------------------------ */
-/*  Gutmann 35-pass patterns                                           */
-/* ------------------------------------------------------------------ */
-
-typedef struct {
-    int     is_random;
-    size_t  pattern_len;
-    uint8_t pattern[3];
-} gutmann_pass_t;
-
-static const gutmann_pass_t gutmann_passes[35] = {
-    {1,0,{0}}, {1,0,{0}}, {1,0,{0}}, {1,0,{0}},
-    {0,1,{0x55}}, {0,1,{0xAA}}, {0,3,{0x92,0x49,0x24}},
-    {0,3,{0x49,0x24,0x92}}, {0,3,{0x24,0x92,0x49}},
-    {0,1,{0x00}}, {0,1,{0x11}}, {0,1,{0x22}},
-    {0,1,{0x33}}, {0,1,{0x44}},
-    {0,1,{0x55}}, {0,1,{0x66}}, {0,1,{0x77}},
-    {0,1,{0x88}}, {0,1,{0x99}},
-    {0,1,{0xAA}}, {0,1,{0xBB}}, {0,1,{0xCC}},
-    {0,1,{0xDD}}, {0,1,{0xEE}},
-    {0,1,{0xFF}}, {0,3,{0x92,0x49,0x24}},
-    {0,3,{0x49,0x24,0x92}},
-    {0,3,{0x24,0x92,0x49}}, {0,3,{0x6D,0xB6,0xDB}},
-    {0,3,{0xB6,0xDB,0x6D}}, {0,3,{0xDB,0x6D,0xB6}},
-    {1,0,{0}}, {1,0,{0}}, {1,0,{0}}, {1,0,{0}}
-};
-
-/* DoD 5220.22-M 7-pass */
-typedef struct {
-    int     is_random;
-    uint8_t byte;
-} dod_pass_t;
+#define WIPE_BUF_ALIGN 4096             /* minimum buffer alignment */
+#define WIPE_REPORT_BUF (64 * 1024)     /* holds a whole report line */
 
-static const dod_pass_t dod_passes[7] = {
-    {0, 0x00}, {0, 0xFF}, {1, 0},
-    {0, 0x00}, {0, 0xFF}, {1, 0}, {1, 0}
-};
+/* Passes the direct engine writes for alg; nwipe writes as many. */
+static int algorithm_passes(wipe_algorithm_t alg)
+{
+    vault_wipe_schedule_t s;
+    return vault_wipe_schedule_builtin(&s, alg) == 0 ? s.count : 0;
+}
 
 /* ------------------------------------------------------------------ */
 /*  Timing                                                             */
 /* ------------------------------------------------------------------ */
 
-static double now_secs(void)
+/* Monotonic nanoseconds: intervals only, immune to clock steps. */
+static uint64_t now_ns(void)
 {
 #if defined(VAULT_PLATFORM_WINDOWS)
     LARGE_INTEGER freq, cnt;
     QueryPerformanceFrequency(&freq);
     QueryPerformanceCounter(&cnt);
-    return (double)cnt.QuadPart / (double)freq.QuadPart;
+    return (uint64_t)((double)cnt.QuadPart * 1e9 / (double)freq.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 #else
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+    return (uint64_t)tv.tv_sec * 1000000000ULL + (uint64_t)tv.tv_usec * 1000;
+#endif
+}
+
+static double now_secs(void)
+{
+    return (double)now_ns() / 1e9;
+}
+
+static void sleep_ns(uint64_t ns)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    Sleep((DWORD)((ns + 999999) / 1000000));
+#else
+    struct timespec ts = { (time_t)(ns / 1000000000ULL),
+                           (long)(ns % 1000000000ULL) };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
 #endif
 }
 
 /* ------------------------------------------------------------------ */
-/*  Buffer fill                                                        */
+/*  Pass kernels                                                       */
+/*                                                                     */
+/*  Every pass of a schedule is bound, once before it starts, to the   */
+/*  kernel for its kind: random passes generate their keystream chunk  */
+/*  by chunk, zero and one-byte passes memset a buffer and tiled       */
+/*  patterns stamp one, both filled once and reused for every chunk.   */
+/*  Pattern passes also bind their read-back checker (wipe_check.h)    */
+/*  then, so verification picks its loop once per pass. Zero and       */
+/*  short-period passes may go to the drive instead (pass_offload()).  */
 /* ------------------------------------------------------------------ */
 
-static int fill_random(uint8_t *buf, size_t len)
+typedef void (*pattern_fill_fn)(uint8_t *buf, size_t len,
+                                 const uint8_t *pat, size_t pat_len);
+
+static void fill_byte(uint8_t *buf, size_t len,
+                      const uint8_t *pat, size_t pat_len)
 {
-    return vault_platform_random(buf, len);
+    (void)pat_len;
+    memset(buf, pat[0], len);
 }
 
-static void fill_pattern(uint8_t *buf, size_t len,
-                          const uint8_t *pat, size_t pat_len)
+/*
+ * Multi-byte patterns are expanded into a tile whose length is a
+ * multiple of both the pattern and 16 bytes (48 for the 3-byte Gutmann
+ * patterns), stamped across the first few KB with whole-tile copies the
+ * compiler turns into vector stores, then doubled with memcpy. Doubling
+ * keeps the phase because every copied prefix is a whole number of tiles.
+ */
+#define PATTERN_TILE_MAX   (VAULT_WIPE_PATTERN_MAX * 16)
+#define PATTERN_STAMP_LEN  4096
+
+static void fill_tile(uint8_t *buf, size_t len,
+                      const uint8_t *pat, size_t pat_len)
 {
-    if (pat_len == 1) {
-        memset(buf, pat[0], len);
-    } else {
-        for (size_t i = 0; i < len; i++)
-            buf[i] = pat[i % pat_len];
+    size_t tile_len = pat_len * 16;
+    uint8_t tile[PATTERN_TILE_MAX];
+    for (size_t i = 0; i < tile_len; i++)
+        tile[i] = pat[i % pat_len];
+
+    size_t done = 0;
+    while (done + tile_len <= len && done < PATTERN_STAMP_LEN) {
+        memcpy(buf + done, tile, tile_len);
+        done += tile_len;
+    }
+    if (done < tile_len) {
+        memcpy(buf, tile, len);
+        return;
+    }
+    while (done < len) {
+        size_t n = (done < len - done) ? done : len - done;
+        memcpy(buf + done, buf, n);
+        done += n;
+    }
+}
+
+/* A pass bound to its kernel */
+typedef struct {
+    vault_wipe_pass_kind_t kind;
+    const vault_wipe_stream_t *stream;  /* random passes, else NULL */
+    const uint8_t  *pat;        /* pattern passes: one period */
+    size_t          pat_len;
+    pattern_fill_fn fill;       /* fill_byte() or fill_tile() */
+    vault_wipe_checker_t check; /* pattern passes: read-back compare */
+} pass_kernel_t;
+
+static void kernel_bind(pass_kernel_t *k, const vault_wipe_pass_t *pass,
+                        const vault_wipe_stream_t *stream)
+{
+    memset(k, 0, sizeof(*k));
+    k->kind = pass->kind;
+    if (pass->kind == VAULT_WIPE_PASS_RANDOM) {
+        k->stream = stream;
+        return;
     }
+    k->pat = pass->pattern;
+    k->pat_len = pass->pattern_len;
+    k->fill = pass->kind == VAULT_WIPE_PASS_TILE ? fill_tile : fill_byte;
+    vault_wipe_checker_init(&k->check, k->pat, k->pat_len);
 }
 
 /* ------------------------------------------------------------------ */
@@ -164,6 +278,10 @@ uint64_t vault_wipe_get_device_size(const char *device)
   #ifdef BLKGETSIZE64
     if (ioctl(fd, BLKGETSIZE64, &size) < 0) size = 0;
   #endif
+    /* Image files (loop-back testing) */
+    struct stat st;
+    if (size == 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        size = (uint64_t)st.st_size;
     close(fd);
     return size;
 #endif
@@ -175,33 +293,74 @@ uint64_t vault_wipe_get_device_size(const char *device)
 
 #if defined(VAULT_PLATFORM_LINUX)
 
-int vault_wipe_is_ssd(const char *device)
+/* Whole-disk name under /sys/block for a device or partition node. */
+static void sysfs_disk_name(const char *device, char *base, size_t size)
 {
     const char *name = strrchr(device, '/');
     name = name ? name + 1 : device;
 
-    /* Strip partition number */
-    char base[64];
-    strncpy(base, name, sizeof(base) - 1);
-    base[sizeof(base) - 1] = '\0';
+    strncpy(base, name, size - 1);
+    base[size - 1] = '\0';
+
+    /* Whole disks (loop0, mmcblk0 and nvme0n1 included) are listed
+     * as they are; a partition's sysfs node sits in its disk's. */
+    char path[256], real[PATH_MAX];
+    snprintf(path, sizeof(path), "/sys/block/%s", base);
+    if (access(path, F_OK) == 0) return;
+    snprintf(path, sizeof(path), "/sys/class/block/%s/..", base);
+    if (realpath(path, real)) {
+        const char *disk = strrchr(real, '/');
+        snprintf(path, sizeof(path), "/sys/block/%s", disk ? disk + 1 : "");
+        if (disk && access(path, F_OK) == 0) {
+            strncpy(base, disk + 1, size - 1);
+            base[size - 1] = '\0';
+            return;
+        }
+    }
+
+    /* No sysfs entry: strip the partition number */
     size_t len = strlen(base);
     while (len > 0 && base[len - 1] >= '0' && base[len - 1] <= '9') {
         if (len >= 2 && base[len - 2] == 'n') break;
         base[--len] = '\0';
     }
+}
 
-    if (strncmp(base, "nvme", 4) == 0) return 1;
+/* Read a numeric /sys/block/<disk>/<attr>. Returns -1 if unavailable. */
+static long long sysfs_disk_attr(const char *device, const char *attr)
+{
+    char base[64], path[256];
+    sysfs_disk_name(device, base, sizeof(base));
+    snprintf(path, sizeof(path), "/sys/block/%s/%s", base, attr);
 
-    char path[256];
-    snprintf(path, sizeof(path), "/sys/block/%s/queue/rotational", base);
     FILE *fp = fopen(path, "r");
     if (!fp) return -1;
-    int val = -1;
-    if (fscanf(fp, "%d", &val) != 1) val = -1;
+    long long val = -1;
+    if (fscanf(fp, "%lld", &val) != 1) val = -1;
     fclose(fp);
+    return val;
+}
+
+int vault_wipe_is_ssd(const char *device)
+{
+    char base[64];
+    sysfs_disk_name(device, base, sizeof(base));
+    if (strncmp(base, "nvme", 4) == 0) return 1;
+
+    long long val = sysfs_disk_attr(device, "queue/rotational");
+    if (val < 0) return -1;
     return (val == 0) ? 1 : 0;
 }
 
+/* Largest WRITE ZEROES (or WRITE SAME of zeroes) the device takes in
+ * one command, 0 if it has none. Without one BLKZEROOUT would only
+ * write zero pages from the host, no better than a zero-fill pass. */
+static uint64_t zeroout_max_bytes(const char *device)
+{
+    long long val = sysfs_disk_attr(device, "queue/write_zeroes_max_bytes");
+    return val > 0 ? (uint64_t)val : 0;
+}
+
 #else
 
 int vault_wipe_is_ssd(const char *device)
@@ -210,6 +369,169 @@ int vault_wipe_is_ssd(const char *device)
     return -1;
 }
 
+static uint64_t zeroout_max_bytes(const char *device)
+{
+    (void)device;
+    return 0;
+}
+
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  NUMA placement                                                     */
+/*                                                                     */
+/*  On multi-socket machines every thread of a device's wipe runs on   */
+/*  the cores of the node its controller is attached to, and its pass  */
+/*  buffers prefer that node's memory, so data is generated, held and  */
+/*  DMA'd without crossing the interconnect. Single-node machines and  */
+/*  devices whose node sysfs does not report are left alone.           */
+/* ------------------------------------------------------------------ */
+
+#define WIPE_MPOL_PREFERRED 1           /* <linux/mempolicy.h> */
+
+typedef struct {
+    int node;                   /* -1 = no placement */
+#if defined(VAULT_PLATFORM_LINUX) && defined(CPU_SETSIZE)
+    cpu_set_t cpus;             /* the node's cores we may run on */
+    cpu_set_t saved;            /* caller's placement, for numa_leave() */
+    int       entered;
+#endif
+} wipe_numa_t;
+
+#if defined(VAULT_PLATFORM_LINUX) && defined(CPU_SETSIZE)
+
+/* Parse a sysfs list such as "0-3,8-11" into set. Returns the count. */
+static int parse_cpulist(const char *s, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    while (*s) {
+        char *end;
+        long a = strtol(s, &end, 10), b = a;
+        if (end == s) break;
+        if (*end == '-') b = strtol(end + 1, &end, 10);
+        for (long i = a; i <= b && i < CPU_SETSIZE; i++)
+            if (i >= 0) CPU_SET((int)i, set);
+        if (*end != ',') break;
+        s = end + 1;
+    }
+    return CPU_COUNT(set);
+}
+
+static int read_cpulist(const char *path, cpu_set_t *set)
+{
+    char buf[1024];
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    int n = fgets(buf, sizeof(buf), fp) ? parse_cpulist(buf, set) : 0;
+    fclose(fp);
+    return n;
+}
+
+/* The node of the first ancestor of the disk's device that has one:
+ * the PCI function of its NVMe or HBA controller. -1 if unknown. */
+static int device_numa_node(const char *device)
+{
+    char base[64], path[PATH_MAX], real[PATH_MAX];
+    sysfs_disk_name(device, base, sizeof(base));
+    snprintf(path, sizeof(path), "/sys/block/%s/device", base);
+    if (!realpath(path, real)) return -1;
+
+    size_t len = strlen(real);
+    while (len > strlen("/sys/devices")) {
+        snprintf(path, sizeof(path), "%.*s/numa_node", (int)len, real);
+        FILE *fp = fopen(path, "r");
+        if (fp) {
+            int node = -1;
+            if (fscanf(fp, "%d", &node) != 1) node = -1;
+            fclose(fp);
+            return node;
+        }
+        while (len > 0 && real[len - 1] != '/') len--;
+        if (len > 0) len--;
+    }
+    return -1;
+}
+
+/* Find the device's node; a NULL device gets no placement. */
+static void numa_probe(const char *device, wipe_numa_t *n)
+{
+    memset(n, 0, sizeof(*n));
+    n->node = -1;
+
+    if (!device ||
+        read_cpulist("/sys/devices/system/node/online", &n->cpus) < 2)
+        return;
+    int node = device_numa_node(device);
+    if (node < 0) return;
+
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+    if (read_cpulist(path, &n->cpus) == 0) return;
+
+    /* Only cores this process may use (taskset, cgroups) */
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    CPU_AND(&n->cpus, &n->cpus, &allowed);
+    if (CPU_COUNT(&n->cpus) == 0) return;
+
+    n->node = node;
+    fprintf(stderr, "wipe: %s: NUMA node %d, %d CPU%s\n", device, node,
+            CPU_COUNT(&n->cpus), CPU_COUNT(&n->cpus) == 1 ? "" : "s");
+}
+
+/* Run the calling thread of the wipe on the node until numa_leave(). */
+static void numa_enter(wipe_numa_t *n)
+{
+    if (n->node < 0) return;
+    n->entered = sched_getaffinity(0, sizeof(n->saved), &n->saved) == 0 &&
+                 sched_setaffinity(0, sizeof(n->cpus), &n->cpus) == 0;
+}
+
+static void numa_leave(wipe_numa_t *n)
+{
+    if (n->entered) sched_setaffinity(0, sizeof(n->saved), &n->saved);
+    n->entered = 0;
+}
+
+/* Start of a generator, writer or reader thread of the wipe. */
+static void numa_pin(const wipe_numa_t *n)
+{
+    if (n && n->node >= 0)
+        sched_setaffinity(0, sizeof(n->cpus), &n->cpus);
+}
+
+/* Prefer the node's memory for buf, which nothing has touched yet. */
+static void numa_membind(const wipe_numa_t *n, void *buf, size_t len)
+{
+#ifdef SYS_mbind
+    if (!n || n->node < 0 || n->node >= 64) return;
+    /* maxnode counts one bit past the mask */
+    unsigned long mask = 1UL << n->node;
+    syscall(SYS_mbind, buf, len, WIPE_MPOL_PREFERRED, &mask,
+            (unsigned long)(sizeof(mask) * 8 + 1), 0);
+#else
+    (void)n; (void)buf; (void)len;
+#endif
+}
+
+#else
+
+static void numa_probe(const char *device, wipe_numa_t *n)
+{
+    (void)device;
+    n->node = -1;
+}
+
+static void numa_enter(wipe_numa_t *n) { (void)n; }
+static void numa_leave(wipe_numa_t *n) { (void)n; }
+static void numa_pin(const wipe_numa_t *n) { (void)n; }
+
+static void numa_membind(const wipe_numa_t *n, void *buf, size_t len)
+{
+    (void)n; (void)buf; (void)len;
+}
+
 #endif
 
 /* ------------------------------------------------------------------ */
@@ -221,38 +543,121 @@ int vault_wipe_is_ssd(const char *device)
 typedef HANDLE disk_handle_t;
 #define INVALID_DISK_HANDLE INVALID_HANDLE_VALUE
 
-static disk_handle_t disk_open_write(const char *path)
+/* Open for writing. *direct asks for unbuffered I/O; it is cleared
+ * when the device cannot provide it. */
+static disk_handle_t disk_open_write(const char *path, int *direct)
 {
+    DWORD flags = FILE_FLAG_WRITE_THROUGH;
+    if (*direct) flags |= FILE_FLAG_NO_BUFFERING;
     return CreateFileA(path, GENERIC_WRITE,
                        FILE_SHARE_READ | FILE_SHARE_WRITE,
-                       NULL, OPEN_EXISTING,
-                       FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH,
-                       NULL);
+                       NULL, OPEN_EXISTING, flags, NULL);
 }
 
-static disk_handle_t disk_open_read(const char *path)
+/* Open for reading; *direct as for disk_open_write(). */
+static disk_handle_t disk_open_read(const char *path, int *direct)
 {
     return CreateFileA(path, GENERIC_READ,
                        FILE_SHARE_READ | FILE_SHARE_WRITE,
-                       NULL, OPEN_EXISTING, 0, NULL);
+                       NULL, OPEN_EXISTING,
+                       *direct ? FILE_FLAG_NO_BUFFERING : 0, NULL);
 }
 
-static int disk_seek_begin(disk_handle_t h)
+/* Write at an explicit offset, leaving the file pointer alone. */
+static int disk_pwrite(disk_handle_t h, const uint8_t *buf, size_t len,
+                       uint64_t offset)
 {
-    LARGE_INTEGER li; li.QuadPart = 0;
-    return SetFilePointerEx(h, li, NULL, FILE_BEGIN) ? 0 : -1;
+    OVERLAPPED ov;
+    DWORD written;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    return WriteFile(h, buf, (DWORD)len, &written, &ov) ? (int)written : -1;
 }
 
-static int disk_write(disk_handle_t h, const uint8_t *buf, size_t len)
+static int disk_pread(disk_handle_t h, uint8_t *buf, size_t len,
+                      uint64_t offset)
 {
-    DWORD written;
-    return WriteFile(h, buf, (DWORD)len, &written, NULL) ? (int)written : -1;
+    OVERLAPPED ov;
+    DWORD nread;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    return ReadFile(h, buf, (DWORD)len, &nread, &ov) ? (int)nread : -1;
 }
 
-static int disk_read(disk_handle_t h, uint8_t *buf, size_t len)
+/* Logical and physical sector sizes from the storage stack's access
+ * alignment descriptor; 0 where the driver does not report them. */
+static void disk_alignment(disk_handle_t h, size_t *logical,
+                           size_t *physical)
 {
-    DWORD nread;
-    return ReadFile(h, buf, (DWORD)len, &nread, NULL) ? (int)nread : -1;
+    STORAGE_PROPERTY_QUERY q;
+    STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR d;
+    DWORD out;
+    memset(&q, 0, sizeof(q));
+    q.PropertyId = StorageAccessAlignmentProperty;
+    q.QueryType = PropertyStandardQuery;
+    *logical = *physical = 0;
+    if (DeviceIoControl(h, IOCTL_STORAGE_QUERY_PROPERTY, &q, sizeof(q),
+                        &d, sizeof(d), &out, NULL) && out >= sizeof(d)) {
+        *logical = d.BytesPerLogicalSector;
+        *physical = d.BytesPerPhysicalSector;
+    }
+}
+
+/* Logical sector size: the unit unbuffered writes must come in. */
+static size_t disk_block_size(disk_handle_t h)
+{
+    size_t logical, physical;
+    disk_alignment(h, &logical, &physical);
+    if (logical > 0) return logical;
+
+    DISK_GEOMETRY geo;
+    DWORD out;
+    if (DeviceIoControl(h, IOCTL_DISK_GET_DRIVE_GEOMETRY, NULL, 0,
+                        &geo, sizeof(geo), &out, NULL) &&
+        geo.BytesPerSector > 0)
+        return (size_t)geo.BytesPerSector;
+    return 512;
+}
+
+/* Physical sector size, which 512e drives rewrite whole for any
+ * smaller write; 0 if unknown. */
+static size_t disk_physical_block(disk_handle_t h)
+{
+    size_t logical, physical;
+    disk_alignment(h, &logical, &physical);
+    return physical;
+}
+
+static int disk_write_all(disk_handle_t h, const uint8_t *buf, size_t len,
+                          uint64_t offset);
+
+/* Physical drives are always a whole number of logical sectors, so
+ * the part past the last whole physical sector is still written
+ * unbuffered; anything smaller than a logical sector cannot be. */
+static int disk_write_tail(disk_handle_t h, uint64_t offset,
+                           const uint8_t *buf, size_t len)
+{
+    if (len % disk_block_size(h) != 0) return -1;
+    return disk_write_all(h, buf, len, offset);
+}
+
+/* No raw-disk zeroing command is exposed; zero passes are written. */
+static int disk_zeroout(disk_handle_t h, uint64_t offset, uint64_t len)
+{
+    (void)h; (void)offset; (void)len;
+    return -1;
+}
+
+/* 1 if the last failed call hit sectors the drive cannot write or
+ * read, rather than a missing device or a bad request. */
+static int disk_media_error(void)
+{
+    DWORD err = GetLastError();
+    return err == ERROR_CRC || err == ERROR_SECTOR_NOT_FOUND ||
+           err == ERROR_WRITE_FAULT || err == ERROR_READ_FAULT ||
+           err == ERROR_IO_DEVICE;
 }
 
 static void disk_sync(disk_handle_t h) { FlushFileBuffers(h); }
@@ -263,172 +668,2079 @@ static void disk_close(disk_handle_t h) { CloseHandle(h); }
 typedef int disk_handle_t;
 #define INVALID_DISK_HANDLE (-1)
 
-static disk_handle_t disk_open_write(const char *path)
+/* Open for writing. *direct asks for unbuffered I/O; it is cleared
+ * when the device cannot provide it and writes fall back to O_SYNC. */
+static disk_handle_t disk_open_write(const char *path, int *direct)
 {
+#if defined(VAULT_PLATFORM_MACOS)
+    if (*direct) {
+        int fd = open(path, O_WRONLY);
+        if (fd < 0) return -1;
+        if (fcntl(fd, F_NOCACHE, 1) == 0) return fd;
+        close(fd);
+        *direct = 0;
+    }
+#elif defined(O_DIRECT)
+    if (*direct) {
+        int fd = open(path, O_WRONLY | O_DIRECT);
+        if (fd >= 0 || errno != EINVAL) return fd;
+        *direct = 0;    /* e.g. tmpfs */
+    }
+#else
+    *direct = 0;
+#endif
     return open(path, O_WRONLY | O_SYNC);
 }
 
-static disk_handle_t disk_open_read(const char *path)
+/* Open for reading; *direct as for disk_open_write(), without the
+ * O_SYNC fallback. */
+static disk_handle_t disk_open_read(const char *path, int *direct)
 {
+#if defined(VAULT_PLATFORM_MACOS)
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0 && *direct && fcntl(fd, F_NOCACHE, 1) != 0) *direct = 0;
+    return fd;
+#elif defined(O_DIRECT)
+    if (*direct) {
+        int fd = open(path, O_RDONLY | O_DIRECT);
+        if (fd >= 0 || errno != EINVAL) return fd;
+        *direct = 0;
+    }
     return open(path, O_RDONLY);
+#else
+    *direct = 0;
+    return open(path, O_RDONLY);
+#endif
 }
 
-static int disk_seek_begin(disk_handle_t h)
-{
-    return (lseek(h, 0, SEEK_SET) == 0) ? 0 : -1;
-}
-
-static int disk_write(disk_handle_t h, const uint8_t *buf, size_t len)
+/* Write at an explicit offset, leaving the file position alone. */
+static int disk_pwrite(disk_handle_t h, const uint8_t *buf, size_t len,
+                       uint64_t offset)
 {
-    return (int)write(h, buf, len);
+    return (int)pwrite(h, buf, len, (off_t)offset);
 }
 
-static int disk_read(disk_handle_t h, uint8_t *buf, size_t len)
+static int disk_pread(disk_handle_t h, uint8_t *buf, size_t len,
+                      uint64_t offset)
 {
-    return (int)read(h, buf, len);
+    return (int)pread(h, buf, len, (off_t)offset);
 }
 
-static void disk_sync(disk_handle_t h)
+/* Logical block size: the unit unbuffered writes must come in. */
+static size_t disk_block_size(disk_handle_t h)
 {
 #if defined(VAULT_PLATFORM_MACOS)
-    if (fcntl(h, F_FULLFSYNC) != 0) fsync(h);
+    uint32_t bs = 0;
+    if (ioctl(h, DKIOCGETBLOCKSIZE, &bs) == 0 && bs > 0) return bs;
 #else
-    fsync(h);
+  #ifdef BLKSSZGET
+    int ss = 0;
+    if (ioctl(h, BLKSSZGET, &ss) == 0 && ss > 0) return (size_t)ss;
+  #endif
 #endif
+    struct stat st;
+    if (fstat(h, &st) == 0 && st.st_blksize > 0) return (size_t)st.st_blksize;
+    return 512;
 }
 
-static void disk_close(disk_handle_t h) { close(h); }
+#if defined(VAULT_PLATFORM_MACOS)
+/* Physical block size, which 512e drives rewrite whole for any smaller
+ * write; 0 if unknown. */
+static size_t disk_physical_block(disk_handle_t h)
+{
+    uint32_t bs = 0;
+    return ioctl(h, DKIOCGETPHYSICALBLOCKSIZE, &bs) == 0 ? bs : 0;
+}
 
+/* Largest single write the driver passes down unsplit; 0 if unknown. */
+static size_t disk_max_write(disk_handle_t h)
+{
+    uint64_t n = 0;
+    if (ioctl(h, DKIOCGETMAXBYTECOUNTWRITE, &n) != 0 || n == 0) return 0;
+    return n > VAULT_WIPE_CHUNK_MAX ? VAULT_WIPE_CHUNK_MAX : (size_t)n;
+}
 #endif
 
-/* ------------------------------------------------------------------ */
-/*  macOS raw device path                                              */
-/* ------------------------------------------------------------------ */
-
-#if defined(VAULT_PLATFORM_MACOS)
-static void make_raw_path(const char *dev, char *raw, size_t size)
+/* Write the part of the device past the last whole block, which
+ * O_DIRECT cannot reach, through the page cache. */
+static int disk_write_tail(disk_handle_t h, uint64_t offset,
+                           const uint8_t *buf, size_t len)
 {
-    const char *sl = strrchr(dev, '/');
-    if (!sl) { snprintf(raw, size, "/dev/r%s", dev); return; }
-    if (sl[1] == 'r' && strncmp(sl + 2, "disk", 4) == 0) {
-        strncpy(raw, dev, size - 1);
-        raw[size - 1] = '\0';
-        return;
-    }
-    size_t plen = (size_t)(sl - dev + 1);
-    snprintf(raw, size, "%.*sr%s", (int)plen, dev, sl + 1);
-}
+#if defined(O_DIRECT) && !defined(VAULT_PLATFORM_MACOS)
+    int fl = fcntl(h, F_GETFL);
+    if (fl < 0 || fcntl(h, F_SETFL, fl & ~O_DIRECT) < 0) return -1;
+    ssize_t wr = pwrite(h, buf, len, (off_t)offset);
+    int ok = wr == (ssize_t)len && fdatasync(h) == 0;
+    fcntl(h, F_SETFL, fl);
+    return ok ? 0 : -1;
+#else
+    return pwrite(h, buf, len, (off_t)offset) == (ssize_t)len ? 0 : -1;
 #endif
+}
 
-static const char *resolve_device_path(const char *device,
-                                        char *resolved, size_t size)
+/* Have the device zero [offset, offset + len) itself; both must be
+ * whole logical blocks. */
+static int disk_zeroout(disk_handle_t h, uint64_t offset, uint64_t len)
 {
-#if defined(VAULT_PLATFORM_MACOS)
-    make_raw_path(device, resolved, size);
-    return resolved;
+#if defined(BLKZEROOUT) && !defined(VAULT_PLATFORM_MACOS)
+    uint64_t range[2] = { offset, len };
+    return ioctl(h, BLKZEROOUT, range) == 0 ? 0 : -1;
 #else
-    (void)resolved; (void)size;
-    return device;
+    (void)h; (void)offset; (void)len;
+    return -1;
 #endif
 }
 
-/* ------------------------------------------------------------------ */
-/*  nwipe availability                                                 */
-/* ------------------------------------------------------------------ */
+/* 1 if the last failed call hit sectors the drive cannot write or
+ * read, rather than a missing device or a bad request. */
+static int disk_media_error(void)
+{
+#ifdef ENODATA
+    if (errno == ENODATA) return 1;     /* Linux: BLK_STS_MEDIUM */
+#endif
+    return errno == EIO;
+}
 
-int vault_wipe_nwipe_available(void)
+static void disk_sync(disk_handle_t h)
 {
-#if defined(VAULT_PLATFORM_LINUX)
-    return access("/usr/bin/nwipe", X_OK) == 0 ||
-           access("/usr/sbin/nwipe", X_OK) == 0;
+#if defined(VAULT_PLATFORM_MACOS)
+    if (fcntl(h, F_FULLFSYNC) != 0) fsync(h);
 #else
-    return 0;
+    fdatasync(h);
 #endif
 }
 
+static void disk_close(disk_handle_t h) { close(h); }
+
+#endif
+
 /* ------------------------------------------------------------------ */
-/*  Single write pass                                                  */
+/*  Bad block map                                                      */
+/*                                                                     */
+/*  Ranges the write queues gave up on, shared by every queue and      */
+/*  verifier of one wipe. Extents are kept sorted and merged, so a     */
+/*  bad sector hit again by a later pass costs nothing extra.          */
 /* ------------------------------------------------------------------ */
 
-static int do_direct_pass(disk_handle_t fd, uint64_t disk_size, uint8_t *buf,
-                           size_t buf_size, int is_random,
-                           const uint8_t *pat, size_t pat_len,
-                           int pass_num, int total_passes,
-                           const char *desc,
-                           vault_wipe_progress_cb progress_cb)
-{
-    if (!is_random && (!pat || pat_len == 0)) return -1;
+typedef struct {
+    vault_mutex_t lock;
+    const char   *dev;          /* for log lines */
+    vault_wipe_extent_t *ext;
+    int           count;
+    int           cap;
+    uint64_t      bytes;
+    int           full;         /* a limit was hit, skipping has stopped */
+} bad_map_t;
 
-    double start = now_secs();
-    double last_report = start;
-    uint64_t written = 0;
+static void bad_map_init(bad_map_t *m, const char *dev)
+{
+    memset(m, 0, sizeof(*m));
+    vault_mutex_init(&m->lock);
+    m->dev = dev;
+}
 
-    if (disk_seek_begin(fd) != 0) return -1;
+static void bad_map_destroy(bad_map_t *m)
+{
+    free(m->ext);
+    vault_mutex_destroy(&m->lock);
+    memset(m, 0, sizeof(*m));
+}
 
-    while (written < disk_size) {
-        size_t chunk = buf_size;
-        if (written + chunk > disk_size)
-            chunk = (size_t)(disk_size - written);
+/* Index of the first extent ending after offset. Caller holds lock. */
+static int bad_map_find(const bad_map_t *m, uint64_t offset)
+{
+    int lo = 0, hi = m->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m->ext[mid].offset + m->ext[mid].length <= offset) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
 
-#if defined(VAULT_PLATFORM_WINDOWS)
-        if (chunk % 512 != 0) chunk = (chunk / 512) * 512;
-        if (chunk == 0) break;
-#endif
+/* Record [offset, offset + len) as unwritable, merging it with any
+ * extent it touches. Returns -1 once the map would pass
+ * VAULT_WIPE_BAD_EXTENTS_MAX extents or VAULT_WIPE_BAD_BYTES_MAX bytes:
+ * the drive is failing outright and the write should fail with it. */
+static int bad_map_add(bad_map_t *m, uint64_t offset, uint64_t len)
+{
+    vault_mutex_lock(&m->lock);
+    uint64_t end = offset + len;
+    int i = m->count;
+    if (!m->full) {
+        /* Extents [i, j) overlap or abut the new one */
+        i = bad_map_find(m, offset ? offset - 1 : 0);
+        int j = i;
+        uint64_t lo = offset, hi = end, merged = 0;
+        while (j < m->count && m->ext[j].offset <= end) {
+            if (m->ext[j].offset < lo) lo = m->ext[j].offset;
+            if (m->ext[j].offset + m->ext[j].length > hi)
+                hi = m->ext[j].offset + m->ext[j].length;
+            merged += m->ext[j].length;
+            j++;
+        }
 
-        if (is_random) {
-            if (fill_random(buf, chunk) != 0) return -1;
+        int count = m->count - (j - i) + 1;
+        uint64_t bytes = m->bytes - merged + (hi - lo);
+        if (count > VAULT_WIPE_BAD_EXTENTS_MAX ||
+            bytes > VAULT_WIPE_BAD_BYTES_MAX) {
+            m->full = 1;
+        } else if (count > m->cap) {
+            int cap = m->cap ? m->cap * 2 : 16;
+            vault_wipe_extent_t *ext = (vault_wipe_extent_t *)
+                realloc(m->ext, (size_t)cap * sizeof(*ext));
+            if (ext) { m->ext = ext; m->cap = cap; }
+            else m->full = 1;
+        }
+        if (!m->full) {
+            if (count > m->count)
+                fprintf(stderr, "wipe: %s: skipping unwritable bytes "
+                        "at %llu\n", m->dev, (unsigned long long)offset);
+            memmove(&m->ext[i + 1], &m->ext[j],
+                    (size_t)(m->count - j) * sizeof(*m->ext));
+            m->ext[i].offset = lo;
+            m->ext[i].length = hi - lo;
+            m->count = count;
+            m->bytes = bytes;
         } else {
-            fill_pattern(buf, chunk, pat, pat_len);
+            fprintf(stderr, "wipe: %s: more than %d bad ranges or %llu MB "
+                    "unwritable, giving up\n", m->dev,
+                    VAULT_WIPE_BAD_EXTENTS_MAX,
+                    (unsigned long long)(VAULT_WIPE_BAD_BYTES_MAX >> 20));
         }
+    }
+    int ret = m->full ? -1 : 0;
+    vault_mutex_unlock(&m->lock);
+    return ret;
+}
 
-        int wr = disk_write(fd, buf, chunk);
-        if (wr < 0) {
-#if !defined(VAULT_PLATFORM_WINDOWS)
-            if (errno == EINTR) continue;
+/* End of the extent holding offset, or 0 if offset is writable. */
+static uint64_t bad_map_end(bad_map_t *m, uint64_t offset)
+{
+    if (!m) return 0;
+    vault_mutex_lock(&m->lock);
+    uint64_t end = 0;
+    int i = bad_map_find(m, offset);
+    if (i < m->count && m->ext[i].offset <= offset)
+        end = m->ext[i].offset + m->ext[i].length;
+    vault_mutex_unlock(&m->lock);
+    return end;
+}
+
+static uint64_t bad_map_bytes(bad_map_t *m)
+{
+    if (!m) return 0;
+    vault_mutex_lock(&m->lock);
+    uint64_t bytes = m->bytes;
+    vault_mutex_unlock(&m->lock);
+    return bytes;
+}
+
+/* Copy the map out for the caller, moved to device offsets by base.
+ * Returns -1 if out of memory. */
+static int bad_map_export(bad_map_t *m, uint64_t base,
+                          vault_wipe_error_map_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    vault_mutex_lock(&m->lock);
+    int ret = 0;
+    if (m->count > 0) {
+        out->extents = (vault_wipe_extent_t *)
+            malloc((size_t)m->count * sizeof(*out->extents));
+        if (out->extents) {
+            for (int i = 0; i < m->count; i++) {
+                out->extents[i].offset = base + m->ext[i].offset;
+                out->extents[i].length = m->ext[i].length;
+            }
+            out->count = m->count;
+            out->bytes = m->bytes;
+        } else {
+            ret = -1;
+        }
+    }
+    vault_mutex_unlock(&m->lock);
+    return ret;
+}
+
+void vault_wipe_error_map_free(vault_wipe_error_map_t *map)
+{
+    if (!map) return;
+    free(map->extents);
+    memset(map, 0, sizeof(*map));
+}
+
+/* ------------------------------------------------------------------ */
+/*  Throttle                                                           */
+/*                                                                     */
+/*  With a rate cap every write and verification read of a device      */
+/*  first takes its length from the device's token bucket              */
+/*  (wipe_qos.h), sleeping off any deficit, and reports its completion */
+/*  latency afterwards so the cap can follow the device. Pattern       */
+/*  passes are not offloaded then: the drive's own writes cannot be    */
+/*  metered.                                                           */
+/* ------------------------------------------------------------------ */
+
+/* Wait until len bytes may be issued. NULL q = unthrottled. */
+static void qos_wait(vault_wipe_qos_t *q, uint64_t len,
+                     vault_wipe_stats_t *stats)
+{
+    if (!q) return;
+    uint64_t wait = vault_wipe_qos_take(q, len, now_ns());
+    if (wait == 0) return;
+    sleep_ns(wait);
+    if (stats) stats->throttle_ns += wait;
+}
+
+/* An I/O issued at t0 has completed. */
+static void qos_done(vault_wipe_qos_t *q, uint64_t t0)
+{
+    if (!q) return;
+    uint64_t now = now_ns();
+    vault_wipe_qos_done(q, now - t0, now);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Write queue                                                        */
+/*                                                                     */
+/*  Owns the pass buffers and keeps up to `depth` of them in flight.   */
+/*  Every buffer is written at an explicit offset through the queue's  */
+/*  I/O backend (wipe_backend.h): io_uring, overlapped writes reaped   */
+/*  from an I/O completion port, or a synchronous pwrite(). A write    */
+/*  that fails on bad media is redone synchronously in halves until    */
+/*  the unwritable blocks are isolated and can be skipped.             */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    vault_wipe_io_t io;         /* the write in flight; first, so a
+                                 * reaped write is its slot */
+    uint8_t  *buf;
+    size_t    len;
+    size_t    done;             /* bytes of a short write already on disk */
+    uint64_t  offset;
+    int       busy;             /* submitted to the backend, not reaped */
+    uint64_t  submit_ns;        /* for the latency histogram */
+} wq_slot_t;
+
+typedef struct {
+    disk_handle_t fd;
+    int        depth;           /* max writes in flight */
+    int        nbufs;           /* buffers owned by the queue */
+    size_t     buf_size;
+    int        direct;          /* unbuffered: writes must be whole blocks */
+    size_t     block;           /* logical block size */
+    wq_slot_t *slots;
+    int        inflight;        /* writes submitted but not reaped */
+    uint64_t   offset;          /* offset of the next submitted write */
+    uint64_t   completed;       /* bytes confirmed written */
+    uint64_t   base;            /* device offset of offset 0 */
+    bad_map_t *bad;             /* NULL = any write error is fatal */
+    vault_wipe_stats_t *stats;  /* owner thread's counters, NULL = none */
+    uint64_t   zeroout;         /* device WRITE ZEROES limit, 0 = none */
+    const vault_wipe_same_t *same;  /* WRITE SAME path, NULL = none */
+    const char *dev;            /* for log lines */
+    vault_wipe_qos_t *qos;      /* rate cap, NULL = full speed */
+    const wipe_numa_t *numa;    /* device's node, NULL = no placement */
+    const vault_wipe_backend_t *be;
+    void      *io;              /* be's queue */
+    unsigned   caps;            /* VAULT_WIPE_IO_* of io */
+} write_queue_t;
+
+static void wq_destroy(write_queue_t *wq)
+{
+    /* The backend waits out its writes before the buffers go */
+    if (wq->io) wq->be->close(wq->io);
+    if (wq->slots) {
+        for (int i = 0; i < wq->nbufs; i++)
+            vault_aligned_free(wq->slots[i].buf);
+    }
+    free(wq->slots);
+    memset(wq, 0, sizeof(*wq));
+}
+
+static int wq_init(write_queue_t *wq, disk_handle_t fd,
+                    const vault_wipe_backend_t *be, int depth,
+                    int nbufs, size_t buf_size, int direct, size_t block)
+{
+    memset(wq, 0, sizeof(*wq));
+    wq->fd = fd;
+    wq->buf_size = buf_size;
+    wq->direct = direct;
+    wq->block = block;
+
+    if (depth < 1) depth = 1;
+    if (depth > VAULT_WIPE_QUEUE_DEPTH_MAX) depth = VAULT_WIPE_QUEUE_DEPTH_MAX;
+
+    /* A backend the system refuses (no io_uring in the kernel, say)
+     * leaves the writes synchronous */
+    const vault_wipe_backend_t *sync_be = vault_wipe_backend_auto(1);
+    wq->io = be->open(fd, direct, &depth);
+    if (!wq->io && be != sync_be) {
+        be = sync_be;
+        wq->io = be->open(fd, direct, &depth);
+    }
+    if (!wq->io) return -1;
+    wq->be = be;
+    wq->caps = be->capabilities(wq->io);
+
+    if (nbufs > VAULT_WIPE_RING_DEPTH_MAX) nbufs = VAULT_WIPE_RING_DEPTH_MAX;
+    if (nbufs < depth) nbufs = depth;
+    wq->depth = depth;
+    wq->nbufs = nbufs;
+
+    wq->slots = (wq_slot_t *)calloc((size_t)nbufs, sizeof(wq_slot_t));
+    if (!wq->slots) { wq_destroy(wq); return -1; }
+
+    size_t align = block > WIPE_BUF_ALIGN ? block : WIPE_BUF_ALIGN;
+    for (int i = 0; i < nbufs; i++) {
+        wq->slots[i].buf = (uint8_t *)vault_aligned_alloc(align, buf_size);
+        if (!wq->slots[i].buf) { wq_destroy(wq); return -1; }
+    }
+    return 0;
+}
+
+/* Write all of buf at offset, retrying short and interrupted writes.
+ * On failure the platform error is left for disk_media_error(). */
+static int disk_write_all(disk_handle_t h, const uint8_t *buf, size_t len,
+                          uint64_t offset)
+{
+    size_t done = 0;
+    while (done < len) {
+        int wr = disk_pwrite(h, buf + done, len - done, offset + done);
+        if (wr < 0) {
+#if !defined(VAULT_PLATFORM_WINDOWS)
+            if (errno == EINTR) continue;
 #endif
             return -1;
         }
-        written += (uint64_t)wr;
+        if (wr == 0) return -1;
+        done += (size_t)wr;
+    }
+    return 0;
+}
+
+/* Redo a write that failed on bad media: each half is written again,
+ * and a half that fails too is split further, down to single blocks,
+ * which go into the bad map. Costs a couple of writes per halving
+ * rather than the pass. Returns 0 once all of [offset, offset + len)
+ * is either written or mapped. */
+static int wq_salvage(write_queue_t *wq, const uint8_t *buf, size_t len,
+                       uint64_t offset)
+{
+    if (!wq->bad || !disk_media_error()) return -1;
+    if (len <= wq->block) return bad_map_add(wq->bad, offset, len);
+
+    size_t half = (len / 2) / wq->block * wq->block;
+    if (half == 0) half = wq->block;
+    if (disk_write_all(wq->fd, buf, half, wq->base + offset) != 0 &&
+        wq_salvage(wq, buf, half, offset) != 0)
+        return -1;
+    if (disk_write_all(wq->fd, buf + half, len - half,
+                       wq->base + offset + half) != 0 &&
+        wq_salvage(wq, buf + half, len - half, offset + half) != 0)
+        return -1;
+    return 0;
+}
+
+/* Hand the unwritten rest of slot to the backend. */
+static int wq_queue_slot(write_queue_t *wq, wq_slot_t *slot)
+{
+    slot->io.buf = slot->buf + slot->done;
+    slot->io.len = slot->len - slot->done;
+    slot->io.offset = wq->base + slot->offset + slot->done;
+    return wq->be->submit(wq->io, &slot->io);
+}
+
+/* Start a new pass with the next write at offset start. */
+static void wq_rewind(write_queue_t *wq, uint64_t start)
+{
+    wq->offset = start;
+    wq->completed = 0;
+}
+
+/* 1 if another write can be submitted without reaping first. */
+static int wq_has_room(const write_queue_t *wq)
+{
+    return wq->inflight < wq->depth;
+}
+
+/* Account for a reaped write of res bytes of slot; res < 0 is a
+ * failure, with the platform error set. Returns 1 if the rest of the
+ * slot went back in flight, 0 once the slot is idle, -1 on failure. */
+static int wq_finish(write_queue_t *wq, wq_slot_t *slot, long res)
+{
+    if (res < 0) {
+        /* The rest of the slot, rewritten piece by piece */
+        if (wq_salvage(wq, slot->buf + slot->done, slot->len - slot->done,
+                       slot->offset + slot->done) != 0)
+            goto failed;
+        res = (long)(slot->len - slot->done);
+        if (wq->stats) wq->stats->salvaged++;
+    }
+    if (res == 0) goto failed;
+
+    if ((size_t)res < slot->len - slot->done) {
+        /* Short write: push the remainder back in flight. The buffer
+         * is left intact since pattern slots are reused. */
+        slot->done += (size_t)res;
+        wq->completed += (uint64_t)res;
+        if (wq_queue_slot(wq, slot) != 0) goto failed;
+        return 1;
+    }
+
+    wq->completed += (uint64_t)res;
+    wq->inflight--;
+    slot->busy = 0;
+    qos_done(wq->qos, slot->submit_ns);
+    if (wq->stats) {
+        vault_wipe_hist_add(&wq->stats->write_lat,
+                            now_ns() - slot->submit_ns);
+        wq->stats->writes++;
+    }
+    return 0;
+
+failed:
+    wq->inflight--;
+    slot->busy = 0;
+    return -1;
+}
+
+/* Wait for one in-flight write to finish. Returns the index of the
+ * slot that is now idle, or -1 on I/O error. */
+static int wq_reap(write_queue_t *wq)
+{
+    while (wq->inflight > 0) {
+        vault_wipe_io_t *io;
+        long res;
+        uint64_t t0 = wq->stats ? now_ns() : 0;
+        int r = wq->be->reap(wq->io, &io, &res);
+        if (wq->stats) wq->stats->write_ns += now_ns() - t0;
+        if (r != 0) return -1;
+
+        wq_slot_t *slot = (wq_slot_t *)io;
+        int done = wq_finish(wq, slot, res);
+        if (done > 0) continue;
+        return done == 0 ? (int)(slot - wq->slots) : -1;
+    }
+    return -1;
+}
+
+/* Submit slot idx holding len bytes. With a synchronous backend the
+ * write has completed (and the slot is reusable) when this returns. */
+static int wq_submit(write_queue_t *wq, int idx, size_t len)
+{
+    wq_slot_t *slot = &wq->slots[idx];
+    slot->len = len;
+    slot->done = 0;
+    slot->offset = wq->offset;
+    wq->offset += len;
+    qos_wait(wq->qos, len, wq->stats);
+
+    if (wq->stats || wq->qos) slot->submit_ns = now_ns();
+    if (wq_queue_slot(wq, slot) != 0) return -1;
+    slot->busy = 1;
+    wq->inflight++;
+    if (wq->caps & VAULT_WIPE_IO_ASYNC) return 0;
+
+    /* Already written: the time went on the submit */
+    if (wq->stats) wq->stats->write_ns += now_ns() - slot->submit_ns;
+    return wq_reap(wq) == idx ? 0 : -1;
+}
+
+/* Flush the queue's completed writes to the media. */
+static void wq_sync(write_queue_t *wq)
+{
+    wq->be->sync(wq->io);
+}
+
+/* End of the written prefix of the pass: the start of the oldest
+ * write still in flight, else the next offset to be written. */
+static uint64_t wq_durable(const write_queue_t *wq)
+{
+    uint64_t low = wq->offset;
+    for (int i = 0; wq->inflight > 0 && i < wq->nbufs; i++)
+        if (wq->slots[i].busy && wq->slots[i].offset < low)
+            low = wq->slots[i].offset;
+    return low;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Device tuning                                                      */
+/*                                                                     */
+/*  Chunk size and queue depth are picked per device: chunks are a     */
+/*  few of the largest requests the block layer will issue (rounded    */
+/*  to the optimal I/O size), and the queue keeps a per-class amount   */
+/*  of data in flight -- more for NVMe, little for USB sticks that     */
+/*  stall on deep queues. Flash devices are also split into several   */
+/*  stripes written in parallel. Probe writes optionally compare       */
+/*  neighbouring chunk sizes on the device itself.                     */
+/* ------------------------------------------------------------------ */
+
+#define WIPE_INFLIGHT_NVME  (64 * 1024 * 1024)
+#define WIPE_INFLIGHT_SSD   (32 * 1024 * 1024)
+#define WIPE_INFLIGHT_HDD   (16 * 1024 * 1024)
+#define WIPE_INFLIGHT_USB   (4 * 1024 * 1024)
+#define WIPE_PROBE_BYTES    (64 * 1024 * 1024)
+#define WIPE_STRIPES_NVME   8
+#define WIPE_STRIPES_SSD    4
+#define WIPE_STRIPE_MIN_CHUNKS 16   /* smallest stripe worth a thread */
+#define WIPE_OFFLOAD_RANGE  (1024ULL * 1024 * 1024)  /* per offload call */
+
+typedef struct {
+    size_t      chunk;
+    int         depth;
+    int         stripes;        /* parallel streams over the LBA range */
+    const vault_wipe_backend_t *backend;
+    const char *source;         /* what decided the values, for the log */
+} wipe_tuning_t;
+
+static size_t round_up(size_t v, size_t unit)
+{
+    return unit ? ((v + unit - 1) / unit) * unit : v;
+}
+
+static size_t clamp_chunk(size_t chunk, size_t unit)
+{
+    if (chunk < VAULT_WIPE_CHUNK_MIN) chunk = VAULT_WIPE_CHUNK_MIN;
+    if (chunk > VAULT_WIPE_CHUNK_MAX) chunk = VAULT_WIPE_CHUNK_MAX;
+    chunk = round_up(chunk, unit);
+    if (chunk > VAULT_WIPE_CHUNK_MAX) chunk -= unit;
+    return chunk;
+}
+
+/* Defaults from the block layer's view of the device. */
+static void tune_from_sysfs(const char *device, size_t unit, wipe_tuning_t *t)
+{
+    t->chunk  = VAULT_WIPE_CHUNK_DEFAULT;
+    t->depth  = VAULT_WIPE_QUEUE_DEPTH_DEFAULT;
+    t->stripes = 1;
+    t->source = "default";
+
+#if defined(VAULT_PLATFORM_LINUX)
+    long long max_kb = sysfs_disk_attr(device, "queue/max_sectors_kb");
+    if (max_kb <= 0) return;
+
+    long long opt  = sysfs_disk_attr(device, "queue/optimal_io_size");
+    long long phys = sysfs_disk_attr(device, "queue/physical_block_size");
+    long long nr   = sysfs_disk_attr(device, "queue/nr_requests");
+    long long rem  = sysfs_disk_attr(device, "removable");
+    int ssd = vault_wipe_is_ssd(device);
+
+    char base[64];
+    sysfs_disk_name(device, base, sizeof(base));
+
+    size_t inflight = WIPE_INFLIGHT_HDD;
+    if (strncmp(base, "nvme", 4) == 0) inflight = WIPE_INFLIGHT_NVME;
+    else if (rem == 1)                 inflight = WIPE_INFLIGHT_USB;
+    else if (ssd == 1)                 inflight = WIPE_INFLIGHT_SSD;
+
+    if (phys > 0 && (size_t)phys > unit) unit = (size_t)phys;
+
+    /* Four maximum-size requests per chunk, at least 1 MB */
+    size_t req = (size_t)max_kb * 1024;
+    size_t chunk = req * 4;
+    if (chunk < 1024 * 1024) chunk = round_up(1024 * 1024, req);
+    if (chunk > inflight) chunk = inflight;
+    if (opt > 0 && (size_t)opt <= VAULT_WIPE_CHUNK_MAX)
+        chunk = round_up(chunk, (size_t)opt);
+    t->chunk = clamp_chunk(chunk, unit);
+
+    int depth = (int)(inflight / t->chunk);
+    if (depth < 2) depth = 2;
+    if (nr > 0 && depth > nr) depth = (int)nr;
+    if (depth > VAULT_WIPE_QUEUE_DEPTH_MAX) depth = VAULT_WIPE_QUEUE_DEPTH_MAX;
+    t->depth  = depth;
+
+    /* Flash takes one stream per core up to what its queues absorb;
+     * a spinning disk only wants one sequential stream. */
+    int cap = 1;
+    if (strncmp(base, "nvme", 4) == 0) cap = WIPE_STRIPES_NVME;
+    else if (ssd == 1 && rem != 1)     cap = WIPE_STRIPES_SSD;
+    int cpus = vault_platform_cpu_count();
+    t->stripes = cpus < cap ? cpus : cap;
+    t->source = "sysfs";
+#else
+    (void)device; (void)unit;
+#endif
+}
+
+/* Write WIPE_PROBE_BYTES of zeros from base with chunk size `chunk`
+ * and return the rate in bytes/s, or 0 on failure. The first pass
+ * overwrites the probe region. */
+static double probe_rate(disk_handle_t fd, const vault_wipe_backend_t *be,
+                          int direct, size_t block, uint64_t base, int depth,
+                          size_t chunk)
+{
+    write_queue_t wq;
+    if (wq_init(&wq, fd, be, depth, depth, chunk, direct, block) != 0)
+        return 0;
+    wq.base = base;
+    for (int i = 0; i < wq.nbufs; i++)
+        memset(wq.slots[i].buf, 0, chunk);
+    wq_rewind(&wq, 0);
+
+    double start = now_secs();
+    uint64_t queued = 0;
+    int next = 0, ok = 1;
+
+    while (ok && queued < WIPE_PROBE_BYTES) {
+        int idx = 0;
+        if (next < wq.nbufs)
+            idx = next++;
+        else if (wq.inflight > 0 && (idx = wq_reap(&wq)) < 0)
+            ok = 0;
+        if (ok && wq_submit(&wq, idx, chunk) != 0) ok = 0;
+        queued += chunk;
+    }
+    while (wq.inflight > 0)
+        if (wq_reap(&wq) < 0) ok = 0;
+    wq_sync(&wq);
+
+    double elapsed = now_secs() - start;
+    wq_destroy(&wq);
+    return (ok && elapsed > 0) ? (double)queued / elapsed : 0;
+}
+
+/* Settle chunk size, queue depth, stripe count and I/O backend for one
+ * device: sysfs (or disk driver) defaults, optionally refined by probe
+ * writes, then explicit overrides. */
+static void tune_device(const char *device, disk_handle_t fd, int direct,
+                        size_t block, uint64_t base, uint64_t disk_size,
+                        const vault_wipe_params_t *params, wipe_tuning_t *t)
+{
+    size_t unit = block > WIPE_BUF_ALIGN ? block : WIPE_BUF_ALIGN;
+#if defined(VAULT_PLATFORM_WINDOWS) || defined(VAULT_PLATFORM_MACOS)
+    /* No sysfs: chunks in whole physical sectors, as it would give */
+    size_t phys = disk_physical_block(fd);
+    if (phys > unit && phys <= VAULT_WIPE_CHUNK_MIN) unit = phys;
+#endif
+
+    tune_from_sysfs(device, unit, t);
+#if defined(VAULT_PLATFORM_MACOS)
+    /* The disk driver's limits stand in for sysfs: four of its largest
+     * writes per chunk, at least 1 MB, as on Linux. Every write is
+     * synchronous here, so the chunk is all there is to tune. */
+    size_t req = disk_max_write(fd);
+    if (req > 0 && direct) {
+        size_t chunk = req * 4;
+        if (chunk < 1024 * 1024) chunk = round_up(1024 * 1024, req);
+        if (chunk > WIPE_INFLIGHT_HDD) chunk = WIPE_INFLIGHT_HDD;
+        t->chunk  = clamp_chunk(chunk, unit);
+        t->source = "disk";
+    }
+#endif
+    if (params->queue_depth > 0) t->depth = params->queue_depth;
+    if (params->stripes > 0) t->stripes = params->stripes;
+    if (t->stripes > VAULT_WIPE_STRIPES_MAX)
+        t->stripes = VAULT_WIPE_STRIPES_MAX;
+
+    /* Stripes keep at least two writes in flight when the device
+     * does (stripe_layout()), so the tuned depth decides for them */
+    t->backend = NULL;
+    if (params->io_backend && strcmp(params->io_backend, "auto") != 0) {
+        t->backend = vault_wipe_backend_find(params->io_backend);
+        if (!t->backend)
+            fprintf(stderr, "wipe: %s: no \"%s\" I/O backend in this "
+                    "build\n", device, params->io_backend);
+    }
+    if (!t->backend) t->backend = vault_wipe_backend_auto(t->depth);
+
+    if (params->chunk_size > 0) {
+        t->chunk  = clamp_chunk(params->chunk_size, unit);
+        t->source = "config";
+    } else if (params->probe && disk_size >= 16 * (uint64_t)WIPE_PROBE_BYTES) {
+        size_t cand[3] = { t->chunk / 4, t->chunk, t->chunk * 4 };
+        double best = 0;
+        for (int i = 0; i < 3; i++) {
+            size_t c = clamp_chunk(cand[i], unit);
+            double rate = probe_rate(fd, t->backend, direct, block, base,
+                                     t->depth, c);
+            if (rate > best) { best = rate; t->chunk = c; t->source = "probe"; }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Fill ring                                                          */
+/*                                                                     */
+/*  A generator thread fills idle write-queue buffers while the        */
+/*  calling thread drains filled ones to disk, so RNG/pattern work     */
+/*  overlaps the I/O. Stall counters show which side is the            */
+/*  bottleneck: generator stalls mean the disk is slower, I/O stalls   */
+/*  mean the fill is.                                                  */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    write_queue_t *wq;
+    uint64_t       start;       /* range this queue writes in the pass */
+    uint64_t       end;
+    const pass_kernel_t *k;
+
+    vault_mutex_t  lock;
+    vault_cond_t   cond;
+    int           *free_q;      /* stack of idle slot indices */
+    int            nfree;
+    int           *ready_q;     /* FIFO of filled slot indices */
+    int            rhead;
+    int            rcount;
+    int            stop;        /* writer gave up, generator must exit */
+    int            gen_failed;  /* generator could not fill a buffer */
+    uint64_t       gen_stalls;  /* generator waited for a free buffer */
+    uint64_t       io_stalls;   /* writer waited for a filled buffer */
+    uint64_t       fill_ns;     /* spent in ring_fill(), by whichever
+                                 * thread fills */
+} fill_ring_t;
+
+/* Length of the chunk starting at offset within a pass that ends at
+ * end (already rounded to whole blocks for unbuffered I/O). */
+static size_t pass_chunk(size_t buf_size, uint64_t end, uint64_t offset)
+{
+    size_t chunk = buf_size;
+    if (offset + chunk > end)
+        chunk = (size_t)(end - offset);
+    return chunk;
+}
+
+/* Fill the buffer for the chunk at offset within the pass. Pattern
+ * passes restart the pattern at every chunk, so their slots are filled
+ * once by ring_init() and left alone here. */
+static int ring_fill(fill_ring_t *r, uint8_t *buf, uint64_t offset,
+                      size_t len)
+{
+    if (!r->k->stream) return 0;
+    uint64_t t0 = now_ns();
+    int ret = vault_wipe_stream_generate(r->k->stream, offset, buf, len);
+    r->fill_ns += now_ns() - t0;
+    return ret;
+}
+
+/* Return an idle slot to the generator. */
+static void ring_release(fill_ring_t *r, int idx)
+{
+    vault_mutex_lock(&r->lock);
+    r->free_q[r->nfree++] = idx;
+    vault_cond_broadcast(&r->cond);
+    vault_mutex_unlock(&r->lock);
+}
+
+static void *ring_generator(void *arg)
+{
+    fill_ring_t *r = (fill_ring_t *)arg;
+    uint64_t offset = r->start;
+    numa_pin(r->wq->numa);
+
+    while (offset < r->end) {
+        size_t chunk = pass_chunk(r->wq->buf_size, r->end, offset);
+        if (chunk == 0) break;
+
+        vault_mutex_lock(&r->lock);
+        if (r->nfree == 0 && !r->stop) r->gen_stalls++;
+        while (r->nfree == 0 && !r->stop)
+            vault_cond_wait(&r->cond, &r->lock);
+        if (r->stop) { vault_mutex_unlock(&r->lock); break; }
+        int idx = r->free_q[--r->nfree];
+        vault_mutex_unlock(&r->lock);
+
+        wq_slot_t *slot = &r->wq->slots[idx];
+        int ok = ring_fill(r, slot->buf, offset, chunk) == 0;
+
+        vault_mutex_lock(&r->lock);
+        if (ok) {
+            slot->len = chunk;
+            r->ready_q[(r->rhead + r->rcount) % r->wq->nbufs] = idx;
+            r->rcount++;
+        } else {
+            r->gen_failed = 1;
+        }
+        vault_cond_broadcast(&r->cond);
+        vault_mutex_unlock(&r->lock);
+
+        if (!ok) break;
+        offset += chunk;
+    }
+    return NULL;
+}
+
+/* Take the next filled slot, reaping completions while waiting.
+ * Returns the slot index or -1 on failure. */
+static int ring_next_ready(fill_ring_t *r)
+{
+    write_queue_t *wq = r->wq;
+
+    vault_mutex_lock(&r->lock);
+    while (r->rcount == 0 && !r->gen_failed) {
+        if (wq->inflight > 0) {
+            vault_mutex_unlock(&r->lock);
+            int done = wq_reap(wq);
+            if (done < 0) return -1;
+            ring_release(r, done);
+            vault_mutex_lock(&r->lock);
+            continue;
+        }
+        r->io_stalls++;
+        while (r->rcount == 0 && !r->gen_failed)
+            vault_cond_wait(&r->cond, &r->lock);
+    }
+    int idx = -1;
+    if (r->rcount > 0) {
+        idx = r->ready_q[r->rhead];
+        r->rhead = (r->rhead + 1) % wq->nbufs;
+        r->rcount--;
+    }
+    vault_mutex_unlock(&r->lock);
+    return idx;
+}
+
+static int ring_init(fill_ring_t *r, write_queue_t *wq,
+                      uint64_t start, uint64_t end, const pass_kernel_t *k)
+{
+    memset(r, 0, sizeof(*r));
+    r->wq = wq;
+    r->start = start;
+    r->end = end;
+    r->k = k;
+
+    r->free_q = (int *)calloc((size_t)wq->nbufs, sizeof(int));
+    r->ready_q = (int *)calloc((size_t)wq->nbufs, sizeof(int));
+    if (!r->free_q || !r->ready_q) {
+        free(r->free_q); free(r->ready_q);
+        return -1;
+    }
+    for (int i = 0; i < wq->nbufs; i++)
+        r->free_q[r->nfree++] = i;
+
+    if (!k->stream) {
+        k->fill(wq->slots[0].buf, wq->buf_size, k->pat, k->pat_len);
+        for (int i = 1; i < wq->nbufs; i++)
+            memcpy(wq->slots[i].buf, wq->slots[0].buf, wq->buf_size);
+    }
+
+    vault_mutex_init(&r->lock);
+    vault_cond_init(&r->cond);
+    return 0;
+}
+
+static void ring_destroy(fill_ring_t *r)
+{
+    vault_cond_destroy(&r->cond);
+    vault_mutex_destroy(&r->lock);
+    free(r->free_q);
+    free(r->ready_q);
+}
+
+/* ------------------------------------------------------------------ */
+/*  macOS raw device path                                              */
+/* ------------------------------------------------------------------ */
+
+#if defined(VAULT_PLATFORM_MACOS)
+static void make_raw_path(const char *dev, char *raw, size_t size)
+{
+    const char *sl = strrchr(dev, '/');
+    if (!sl) { snprintf(raw, size, "/dev/r%s", dev); return; }
+    if (sl[1] == 'r' && strncmp(sl + 2, "disk", 4) == 0) {
+        strncpy(raw, dev, size - 1);
+        raw[size - 1] = '\0';
+        return;
+    }
+    size_t plen = (size_t)(sl - dev + 1);
+    snprintf(raw, size, "%.*sr%s", (int)plen, dev, sl + 1);
+}
+#endif
+
+static const char *resolve_device_path(const char *device,
+                                        char *resolved, size_t size)
+{
+#if defined(VAULT_PLATFORM_MACOS)
+    make_raw_path(device, resolved, size);
+    return resolved;
+#else
+    (void)resolved; (void)size;
+    return device;
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/*  nwipe backend                                                      */
+/*                                                                     */
+/*  nwipe --nogui logs to stdout, and on SIGUSR1 adds a status line    */
+/*  for each drive:                                                    */
+/*    "/dev/sda: 12.34%, round 1 of 1, pass 2 of 3 [writing]"          */
+/*  Its output is read through a pipe that is polled once a second,   */
+/*  with a SIGUSR1 each time, and the status lines are turned into     */
+/*  the same progress reports the direct engine makes. The last one    */
+/*  also tells the direct engine where to take over if nwipe fails.    */
+/* ------------------------------------------------------------------ */
+
+int vault_wipe_nwipe_available(void)
+{
+#if defined(VAULT_PLATFORM_LINUX)
+    return access("/usr/bin/nwipe", X_OK) == 0 ||
+           access("/usr/sbin/nwipe", X_OK) == 0;
+#else
+    return 0;
+#endif
+}
+
+#if defined(VAULT_PLATFORM_LINUX)
+
+#define NWIPE_POLL_MS   1000
+#define NWIPE_LINE_MAX  512
+
+typedef struct {
+    vault_wipe_progress_cb cb;
+    uint64_t disk_size;
+    int      ready;             /* nwipe is wiping, so handles SIGUSR1 */
+    double   first_t;           /* first status line, for the rate */
+    double   first_pct;
+    char     desc[64];
+
+    /* Last status seen: pass P of `passes`, `pass_done` bytes into it */
+    int      pass;
+    int      passes;
+    uint64_t pass_done;
+} nwipe_watch_t;
+
+/* Parse "<pct>%, round R of N, pass P of M [status]" out of a log line.
+ * Returns 0 and fills the fields if the line is a status line. */
+static int nwipe_parse_status(const char *line, double *pct,
+                               int *pass, int *passes,
+                               char *status, size_t status_size)
+{
+    const char *p = strstr(line, "%, round ");
+    if (!p) return -1;
+    const char *num = p;
+    while (num > line && ((num[-1] >= '0' && num[-1] <= '9') ||
+                          num[-1] == '.'))
+        num--;
+    if (num == p) return -1;
+    *pct = strtod(num, NULL);
+
+    int round, rounds, n = 0;
+    if (sscanf(p, "%%, round %d of %d, pass %d of %d%n",
+               &round, &rounds, pass, passes, &n) != 4)
+        return -1;
+
+    /* "[writing]", ", writing" or nothing */
+    const char *st = p + n;
+    while (*st == ' ' || *st == ',' || *st == '[') st++;
+    size_t len = 0;
+    while (st[len] && st[len] != ']' && st[len] != '\n' &&
+           len + 1 < status_size) {
+        status[len] = st[len];
+        len++;
+    }
+    status[len] = '\0';
+    return 0;
+}
+
+static void nwipe_line(nwipe_watch_t *w, const char *line)
+{
+    double pct;
+    int pass, passes;
+    char status[32];
+    if (nwipe_parse_status(line, &pct, &pass, &passes,
+                           status, sizeof(status)) != 0) {
+        /* The method log line comes from the wipe thread, after
+         * nwipe's own signal handling is in place */
+        if (strstr(line, "Invoking method")) w->ready = 1;
+        fprintf(stderr, "nwipe: %s\n", line);
+        return;
+    }
+    w->ready = 1;
+    if (passes < 1 || pass < 1 || pass > passes) return;
+
+    /* The percentage covers the whole round, including nwipe's verify
+     * and blanking passes; counting write passes only gives a per-pass
+     * position that is never ahead of the real one. */
+    double in_pass = pct / 100.0 * passes - (pass - 1);
+    if (in_pass < 0) in_pass = 0;
+    if (in_pass > 1) in_pass = 1;
+    w->pass = pass;
+    w->passes = passes;
+    w->pass_done = (uint64_t)(in_pass * (double)w->disk_size);
+    if (!w->cb) return;
+
+    double now = now_secs();
+    if (w->first_t == 0) { w->first_t = now; w->first_pct = pct; }
+    double rate = now > w->first_t
+        ? (pct - w->first_pct) / (now - w->first_t) : 0;
+    double speed = rate / 100.0 * (double)w->disk_size * passes;
+
+    snprintf(w->desc, sizeof(w->desc), "Pass %d/%d: %s (nwipe)",
+             pass, passes, status[0] ? status : "wiping");
+    vault_wipe_progress_t prog = {
+        .current_pass = pass,
+        .total_passes = passes,
+        .bytes_written = w->pass_done,
+        .bytes_total = w->disk_size,
+        .speed_mbps = speed / (1024.0 * 1024.0),
+        .eta_secs = rate > 0 ? (100.0 - pct) / rate : 0,
+        .pass_description = w->desc,
+        .verifying = strstr(status, "verif") != NULL,
+        .combined_mbps = speed / (1024.0 * 1024.0)
+    };
+    w->cb(&prog);
+}
+
+/* Read nwipe's output from fd until it exits, asking it for a status
+ * line every NWIPE_POLL_MS, then reap it into *status. *w is left with
+ * the last status seen. Returns 0, or -1 if nwipe could not be
+ * reaped. */
+static int nwipe_watch(pid_t pid, int fd, uint64_t disk_size,
+                        vault_wipe_progress_cb cb, nwipe_watch_t *w,
+                        int *status)
+{
+    memset(w, 0, sizeof(*w));
+    w->cb = cb;
+    w->disk_size = disk_size;
+
+    char line[NWIPE_LINE_MAX];
+    size_t len = 0;
+    double last_ask = now_secs();
+    for (;;) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int r = poll(&pfd, 1, NWIPE_POLL_MS);
+        if (r < 0 && errno != EINTR) break;
+        if (r > 0) {
+            char buf[1024];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n == 0) break;                      /* nwipe has exited */
+            if (n < 0 && errno != EINTR && errno != EAGAIN) break;
+            for (ssize_t i = 0; i < n; i++) {
+                if (buf[i] != '\n' && buf[i] != '\r' &&
+                    len + 1 < sizeof(line)) {
+                    line[len++] = buf[i];
+                    continue;
+                }
+                line[len] = '\0';
+                if (len > 0) nwipe_line(w, line);
+                len = 0;
+                if (buf[i] != '\n' && buf[i] != '\r') line[len++] = buf[i];
+            }
+        }
+
+        double now = now_secs();
+        if (w->ready && now - last_ask >= NWIPE_POLL_MS / 1000.0) {
+            kill(pid, SIGUSR1);
+            last_ask = now;
+        }
+    }
+
+    while (waitpid(pid, status, 0) < 0)
+        if (errno != EINTR) return -1;
+    return 0;
+}
+
+#endif /* VAULT_PLATFORM_LINUX */
+
+/* ------------------------------------------------------------------ */
+/*  Checkpoint journal                                                 */
+/*                                                                     */
+/*  Passes of a journalled wipe stop short of the reserved area at     */
+/*  the end of the device, which holds the record. It is rewritten at  */
+/*  the start of every pass and then every WIPE_JOURNAL_INTERVAL,      */
+/*  each time after a device flush, so the offsets it gives are on     */
+/*  stable media. The final pass fills the area in last.               */
+/* ------------------------------------------------------------------ */
+
+#define WIPE_JOURNAL_INTERVAL 30.0      /* seconds between checkpoints */
+#define WIPE_CHECKPOINT_TICK  1.0       /* services thread looks this often */
+
+typedef struct {
+    disk_handle_t fd;           /* buffered, synchronous writes */
+    uint64_t      offset;       /* record; passes end here */
+    uint64_t      disk_size;
+    vault_wipe_journal_t rec;
+    int           first_pass;   /* earlier passes finished before */
+    int           resume;       /* rec.done[] continues rec.pass */
+    double        last;         /* time of the latest checkpoint */
+} journal_t;
+
+/* Read back the record of an interrupted wipe. Returns 0 if there is
+ * one and it belongs to a device of this size. */
+static int journal_read(const char *dev, uint64_t disk_size,
+                         vault_wipe_journal_t *rec)
+{
+    uint64_t off = vault_wipe_journal_offset(disk_size);
+    if (off == 0) return -1;
+
+    int direct = 0;
+    disk_handle_t fd = disk_open_read(dev, &direct);
+    if (fd == INVALID_DISK_HANDLE) return -1;
+    uint8_t buf[VAULT_WIPE_JOURNAL_LEN];
+    int ok = disk_pread(fd, buf, sizeof(buf), off) == (int)sizeof(buf) &&
+             vault_wipe_journal_decode(rec, buf) == 0 &&
+             rec->disk_size == disk_size;
+    vault_secure_memzero(buf, sizeof(buf));
+    disk_close(fd);
+    return ok ? 0 : -1;
+}
+
+static int journal_open(journal_t *jn, const char *dev, uint64_t disk_size)
+{
+    memset(jn, 0, sizeof(*jn));
+    jn->offset = vault_wipe_journal_offset(disk_size);
+    if (jn->offset == 0) return -1;
+
+    int direct = 0;
+    jn->fd = disk_open_write(dev, &direct);
+    if (jn->fd == INVALID_DISK_HANDLE) return -1;
+    jn->disk_size = disk_size;
+    jn->rec.disk_size = disk_size;
+    jn->first_pass = 1;
+    return 0;
+}
+
+/* Flush what the passes have written, then store the record. A failed
+ * checkpoint only costs progress on resume, so callers carry on. */
+static int journal_write(journal_t *jn)
+{
+    uint8_t buf[VAULT_WIPE_JOURNAL_LEN];
+    jn->rec.seq++;
+    vault_wipe_journal_encode(&jn->rec, buf);
+
+    disk_sync(jn->fd);
+    int ok = disk_pwrite(jn->fd, buf, sizeof(buf), jn->offset) ==
+             (int)sizeof(buf);
+    disk_sync(jn->fd);
+    vault_secure_memzero(buf, sizeof(buf));
+    jn->last = now_secs();
+    return ok ? 0 : -1;
+}
+
+static void journal_close(journal_t *jn)
+{
+    disk_close(jn->fd);
+    vault_secure_memzero(&jn->rec, sizeof(jn->rec));
+}
+
+int vault_wipe_journal_pending(const char *device)
+{
+    char resolved_path[256];
+    const char *dev = resolve_device_path(device, resolved_path,
+                                           sizeof(resolved_path));
+    uint64_t disk_size = vault_wipe_get_device_size(dev);
+    vault_wipe_journal_t rec;
+    int found = disk_size > 0 && journal_read(dev, disk_size, &rec) == 0;
+    vault_secure_memzero(&rec, sizeof(rec));
+    return found;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Metadata first                                                     */
+/*                                                                     */
+/*  Before the first pass, partition tables, LUKS headers and          */
+/*  filesystem superblocks (wipe_meta.h) are overwritten with random   */
+/*  data, so a wipe cut short early still leaves nothing that locates  */
+/*  or unlocks the data. Every pass overwrites them again in order.    */
+/* ------------------------------------------------------------------ */
+
+#define WIPE_META_BUF (1024 * 1024)
+
+typedef struct {
+    disk_handle_t fd;
+    uint64_t      base;
+} meta_dev_t;
+
+static int meta_read(void *ctx, uint64_t offset, void *buf, size_t len)
+{
+    const meta_dev_t *md = (const meta_dev_t *)ctx;
+    return disk_pread(md->fd, buf, len, md->base + offset) == (int)len
+           ? 0 : -1;
+}
+
+/* Overwrite the metadata of the limit bytes from base; the journal's
+ * area, if any, is above them. Failures are logged and left to the
+ * passes. */
+static void meta_phase(const char *name, const char *dev, uint64_t base,
+                        uint64_t limit, wipe_rng_t rng)
+{
+    uint64_t t0 = now_ns();
+
+    int direct = 0;
+    meta_dev_t rd = { disk_open_read(dev, &direct), base };
+    if (rd.fd == INVALID_DISK_HANDLE) return;
+    direct = 1;
+    disk_handle_t fd = disk_open_write(dev, &direct);
+    if (fd == INVALID_DISK_HANDLE) {
+        disk_close(rd.fd);
+        return;
+    }
+    size_t block = disk_block_size(fd);
+    size_t align = block > WIPE_BUF_ALIGN ? block : WIPE_BUF_ALIGN;
+
+    vault_wipe_extent_t ext[VAULT_WIPE_META_MAX];
+    int n = vault_wipe_meta_regions(meta_read, &rd, limit, align,
+                                    ext, VAULT_WIPE_META_MAX);
+    disk_close(rd.fd);
+
+    uint8_t seed[VAULT_WIPE_STREAM_SEED_LEN];
+    vault_wipe_stream_t stream;
+    int seeded = vault_platform_random(seed, sizeof(seed)) == 0 &&
+                 vault_wipe_stream_init(&stream, rng, seed) == 0;
+    vault_secure_memzero(seed, sizeof(seed));
+    uint8_t *buf = (uint8_t *)vault_aligned_alloc(align, WIPE_META_BUF);
+
+    uint64_t bytes = 0;
+    int failed = 0;
+    for (int i = 0; seeded && buf && i < n; i++) {
+        for (uint64_t off = ext[i].offset;
+             off < ext[i].offset + ext[i].length; off += WIPE_META_BUF) {
+            uint64_t left = ext[i].offset + ext[i].length - off;
+            size_t len = left < WIPE_META_BUF ? (size_t)left : WIPE_META_BUF;
+            if (vault_wipe_stream_generate(&stream, off, buf, len) != 0 ||
+                disk_pwrite(fd, buf, len, base + off) != (int)len)
+                failed++;
+            else
+                bytes += len;
+        }
+    }
+    if (bytes > 0) disk_sync(fd);
+    disk_close(fd);
+    vault_aligned_free(buf);
+    if (seeded) vault_wipe_stream_destroy(&stream);
+
+    fprintf(stderr, "wipe: %s: metadata first: %d region%s, %llu KB in "
+            "%.0f ms%s\n", name, n, n == 1 ? "" : "s",
+            (unsigned long long)(bytes / 1024),
+            (double)(now_ns() - t0) / 1e6,
+            failed || !seeded || !buf ? ", some left to the passes" : "");
+}
+
+/* ------------------------------------------------------------------ */
+/*  Single write pass                                                  */
+/*                                                                     */
+/*  A pass is split into stripes: chunk-aligned LBA ranges, each       */
+/*  written through its own fd and write queue. Stripe 0 runs on the   */
+/*  calling thread and reports progress; any others get a worker       */
+/*  thread each, so SSDs with several hardware queues see several      */
+/*  independent streams. Rotational disks use a single stripe.         */
+/*                                                                     */
+/*  With fused verification each stripe also gets a reader thread      */
+/*  that reads back, through its own unbuffered fd, every chunk once   */
+/*  the queue reports it written, staying at most a bounded window     */
+/*  behind the write head.                                             */
+/* ------------------------------------------------------------------ */
+
+#define WIPE_VERIFY_WINDOW_CHUNKS 16    /* max read-back lag per stripe */
+
+/* State shared by the stripes of one pass */
+typedef struct {
+    vault_mutex_t lock;
+    vault_cond_t  cond;
+    uint64_t      completed;    /* bytes on disk, all stripes */
+    uint64_t      verified;     /* bytes read back and matched */
+    uint64_t      gen_stalls;
+    uint64_t      io_stalls;
+    int           running;      /* worker stripes still writing */
+    int           failed;       /* a stripe failed, the rest give up */
+} stripe_set_t;
+
+typedef struct {
+    write_queue_t *wq;
+    stripe_set_t  *set;
+    int            threaded;
+    const pass_kernel_t *k;
+    uint64_t       start;
+    uint64_t       end;
+    uint64_t       published;   /* part of wq->completed added to set */
+    int            ret;
+
+    /* Fused verification, under set->lock */
+    const char    *verify_dev;  /* NULL = write only */
+    uint64_t       durable;     /* [start, durable) is on disk */
+    uint64_t       checked;     /* [start, checked) read back */
+    int            verify_ret;
+    vault_wipe_stats_t *vstats; /* reader thread's counters, or NULL */
+} stripe_t;
+
+/* Progress reporting for the calling thread */
+typedef struct {
+    vault_wipe_progress_cb cb;
+    int         pass_num;
+    int         total_passes;
+    uint64_t    disk_size;
+    const char *desc;
+    double      start;
+    double      last_report;
+    bad_map_t  *bad;            /* for bytes_skipped */
+
+    /* Checkpoints, NULL journal = none */
+    journal_t  *journal;
+    stripe_set_t *set;
+    const stripe_t *stripes;
+    int         nstripes;
+    int         offpath;        /* taken on the services thread */
+} pass_report_t;
+
+static void pass_report(pass_report_t *rep, uint64_t written,
+                         uint64_t verified, uint64_t gen_stalls,
+                         uint64_t io_stalls, int final)
+{
+    double now = now_secs();
+    if (!rep->cb || (!final && now - rep->last_report <= 0.5)) return;
+
+    double elapsed = now - rep->start;
+    double speed = (elapsed > 0) ? ((double)written / elapsed) : 0;
+    double both = (elapsed > 0) ? ((double)(written + verified) / elapsed) : 0;
+    vault_wipe_progress_t prog = {
+        .current_pass = rep->pass_num,
+        .total_passes = rep->total_passes,
+        .bytes_written = written,
+        .bytes_total = rep->disk_size,
+        .speed_mbps = speed / (1024.0 * 1024.0),
+        .eta_secs = (!final && speed > 0)
+            ? ((double)(rep->disk_size - written) / speed) : 0,
+        .pass_description = rep->desc,
+        .verifying = 0,
+        .gen_stalls = gen_stalls,
+        .io_stalls = io_stalls,
+        .bytes_verified = verified,
+        .combined_mbps = both / (1024.0 * 1024.0),
+        .bytes_skipped = bad_map_bytes(rep->bad)
+    };
+    rep->cb(&prog);
+    rep->last_report = now;
+}
+
+/* Record how far each stripe has got, at most every
+ * WIPE_JOURNAL_INTERVAL. A stripe being read back resumes from what has
+ * been checked, so nothing goes unverified. */
+static void checkpoint_due(pass_report_t *rep)
+{
+    journal_t *jn = rep->journal;
+    if (!jn || now_secs() - jn->last < WIPE_JOURNAL_INTERVAL) return;
+
+    vault_mutex_lock(&rep->set->lock);
+    for (int i = 0; i < rep->nstripes; i++) {
+        const stripe_t *st = &rep->stripes[i];
+        jn->rec.done[i] = st->verify_dev ? st->checked : st->durable;
+    }
+    vault_mutex_unlock(&rep->set->lock);
+    journal_write(jn);
+}
+
+/* From the pass's own threads, which then wait out the journal's
+ * device flushes; unless the services thread takes the checkpoints. */
+static void pass_checkpoint(pass_report_t *rep)
+{
+    if (!rep->offpath) checkpoint_due(rep);
+}
+
+static void checkpoint_service(void *arg)
+{
+    checkpoint_due((pass_report_t *)arg);
+}
+
+/* Move newly completed bytes into the shared total and wake the
+ * reporter. Returns 1 if another stripe has failed. */
+static int stripe_publish(stripe_t *st)
+{
+    stripe_set_t *set = st->set;
+    vault_mutex_lock(&set->lock);
+    set->completed += st->wq->completed - st->published;
+    st->published = st->wq->completed;
+    st->durable = wq_durable(st->wq);
+    int failed = set->failed;
+    vault_cond_broadcast(&set->cond);
+    vault_mutex_unlock(&set->lock);
+    return failed;
+}
+
+/* Read len bytes at offset from base. With a bad map, a read that
+ * fails is retried block by block, and blocks the wipe had to skip are
+ * zeroed rather than read; check_chunk() passes over them. */
+static int read_range(disk_handle_t fd, uint64_t base, uint8_t *buf,
+                       size_t len, uint64_t offset, size_t block,
+                       bad_map_t *bad)
+{
+    size_t got = 0;
+    while (got < len) {
+        int rd = disk_pread(fd, buf + got, len - got, base + offset + got);
+        if (rd <= 0) break;
+        got += (size_t)rd;
+    }
+    if (got == len) return 0;
+    if (bad_map_bytes(bad) == 0) return -1;
+
+    for (size_t at = 0; at < len; at += block) {
+        size_t n = len - at < block ? len - at : block;
+        if (bad_map_end(bad, offset + at))
+            memset(buf + at, 0, n);
+        else if (disk_pread(fd, buf + at, n, base + offset + at) != (int)n)
+            return -1;
+    }
+    return 0;
+}
+
+/* First byte of buf from `from` on that differs from ref, or from the
+ * checker's pattern repeated from buf[0]; len if none does. */
+static size_t chunk_mismatch(const uint8_t *buf, size_t len, size_t from,
+                              const vault_wipe_checker_t *check,
+                              const uint8_t *ref)
+{
+    if (ref)
+        return from + vault_wipe_check_equal(buf + from, ref + from,
+                                             len - from);
+    /* Bytewise back into phase, then the fast check */
+    const uint8_t *pat = check->pat;
+    size_t pat_len = check->pat_len;
+    for (; from < len && from % pat_len; from++)
+        if (buf[from] != pat[from % pat_len]) return from;
+    if (from >= len) return len;
+    return from + vault_wipe_checker_find(check, buf + from, len - from);
+}
+
+/* Compare a chunk read back from offset against the pattern, or the
+ * keystream regenerated into ref, and name the first bad block if it
+ * differs. Differences inside ranges of the bad map are expected and
+ * passed over. Returns 0 if the chunk matches. */
+static int check_chunk(const char *dev, uint64_t base,
+                        const uint8_t *buf, size_t len,
+                        uint64_t offset, size_t block,
+                        const pass_kernel_t *k, uint8_t *ref,
+                        bad_map_t *bad)
+{
+    if (k->stream) {
+        if (vault_wipe_stream_generate(k->stream, offset, ref, len) != 0)
+            return -1;
+    } else {
+        ref = NULL;
+    }
+
+    size_t at = chunk_mismatch(buf, len, 0, &k->check, ref);
+    while (at < len) {
+        uint64_t skip = bad_map_end(bad, offset + at);
+        if (skip == 0) {
+            uint64_t pos = base + offset + at;
+            fprintf(stderr, "wipe: %s: verify mismatch at byte %llu "
+                    "(LBA %llu)\n", dev, (unsigned long long)pos,
+                    (unsigned long long)(pos / (block ? block : 512)));
+            char qdev[VAULT_CONFIG_MAX_PATH + 8];
+            vault_event("verify_mismatch", ",\"device\":%s,\"offset\":%llu,"
+                        "\"lba\":%llu",
+                        vault_events_quote(qdev, sizeof(qdev), dev),
+                        (unsigned long long)pos,
+                        (unsigned long long)(pos / (block ? block : 512)));
+            return -1;
+        }
+        if (skip >= offset + len) break;
+        at = chunk_mismatch(buf, len, (size_t)(skip - offset), &k->check,
+                            ref);
+    }
+    return 0;
+}
 
-        double now = now_secs();
-        if (progress_cb && (now - last_report > 0.5)) {
-            double elapsed = now - start;
-            double speed = (elapsed > 0) ? ((double)written / elapsed) : 0;
-            vault_wipe_progress_t prog = {
-                .current_pass = pass_num,
-                .total_passes = total_passes,
-                .bytes_written = written,
-                .bytes_total = disk_size,
-                .speed_mbps = speed / (1024.0 * 1024.0),
-                .eta_secs = (speed > 0) ? ((double)(disk_size - written) / speed) : 0,
-                .pass_description = desc,
-                .verifying = 0
-            };
-            progress_cb(&prog);
-            last_report = now;
+/* Read back [start, end) of a stripe chunk by chunk as the writer
+ * makes it durable, comparing against the pattern or the regenerated
+ * keystream. */
+static void *stripe_verifier(void *arg)
+{
+    stripe_t *st = (stripe_t *)arg;
+    stripe_set_t *set = st->set;
+    size_t buf_size = st->wq->buf_size;
+    size_t align = st->wq->block > WIPE_BUF_ALIGN ? st->wq->block
+                                                  : WIPE_BUF_ALIGN;
+    numa_pin(st->wq->numa);
+
+    int direct = 1;
+    disk_handle_t fd = disk_open_read(st->verify_dev, &direct);
+    uint8_t *buf = (uint8_t *)vault_aligned_alloc(align, buf_size);
+    uint8_t *ref = st->k->stream
+        ? (uint8_t *)vault_aligned_alloc(align, buf_size) : NULL;
+    int ret = (fd != INVALID_DISK_HANDLE && buf &&
+               (ref || !st->k->stream)) ? 0 : -1;
+
+    uint64_t off = st->start;
+    while (ret == 0 && off < st->end) {
+        size_t chunk = pass_chunk(buf_size, st->end, off);
+
+        vault_mutex_lock(&set->lock);
+        while (!set->failed && st->durable < off + chunk)
+            vault_cond_wait(&set->cond, &set->lock);
+        int stop = set->failed;
+        vault_mutex_unlock(&set->lock);
+        if (stop) { ret = -1; break; }
+
+        qos_wait(st->wq->qos, chunk, st->vstats);
+        uint64_t t0 = st->vstats || st->wq->qos ? now_ns() : 0;
+        if (read_range(fd, st->wq->base, buf, chunk, off, st->wq->block,
+                       st->wq->bad) != 0) {
+            ret = -1;
+            break;
+        }
+        qos_done(st->wq->qos, t0);
+        uint64_t t1 = st->vstats ? now_ns() : 0;
+        if (check_chunk(st->verify_dev, st->wq->base, buf, chunk, off,
+                        st->wq->block, st->k, ref, st->wq->bad) != 0) {
+            ret = -1;
+            break;
         }
+        if (st->vstats) {
+            vault_wipe_hist_add(&st->vstats->read_lat, t1 - t0);
+            st->vstats->verify_ns += now_ns() - t0;
+        }
+
+        off += chunk;
+        vault_mutex_lock(&set->lock);
+        st->checked = off;
+        set->verified += chunk;
+        vault_cond_broadcast(&set->cond);
+        vault_mutex_unlock(&set->lock);
     }
 
-    disk_sync(fd);
-    return 0;
+    if (ret != 0) {
+        vault_mutex_lock(&set->lock);
+        set->failed = 1;
+        vault_cond_broadcast(&set->cond);
+        vault_mutex_unlock(&set->lock);
+    }
+    vault_aligned_free(buf);
+    vault_aligned_free(ref);
+    if (fd != INVALID_DISK_HANDLE) disk_close(fd);
+    st->verify_ret = ret;
+    return NULL;
+}
+
+/* Write [start, end) of the pass. rep is non-NULL only for the stripe
+ * running on the calling thread. */
+static int stripe_write(stripe_t *st, pass_report_t *rep)
+{
+    write_queue_t *wq = st->wq;
+    stripe_set_t *set = st->set;
+
+    fill_ring_t ring;
+    if (ring_init(&ring, wq, st->start, st->end, st->k) != 0)
+        return -1;
+    wq_rewind(wq, st->start);
+    st->published = 0;
+
+    /* Only random passes have per-chunk work worth a generator thread */
+    vault_thread_t gen;
+    int have_gen = st->threaded && st->k->stream && wq->nbufs > 1 &&
+                   vault_thread_create(&gen, ring_generator, &ring) == 0;
+
+    vault_thread_t reader;
+    int have_reader = 0;
+    if (st->verify_dev) {
+        have_reader = vault_thread_create(&reader, stripe_verifier, st) == 0;
+        if (!have_reader) {
+            vault_mutex_lock(&set->lock);
+            set->failed = 1;
+            vault_mutex_unlock(&set->lock);
+        }
+    }
+    uint64_t window = (uint64_t)WIPE_VERIFY_WINDOW_CHUNKS * wq->buf_size;
+
+    uint64_t queued = st->start;
+    int ret = 0;
+
+    while (queued < st->end) {
+        size_t chunk = pass_chunk(wq->buf_size, st->end, queued);
+        if (chunk == 0) break;
+
+        /* Stay within the queue depth */
+        if (!wq_has_room(wq)) {
+            int done = wq_reap(wq);
+            if (done < 0) { ret = -1; break; }
+            ring_release(&ring, done);
+        }
+
+        int idx;
+        if (have_gen) {
+            idx = ring_next_ready(&ring);
+            if (idx < 0) { ret = -1; break; }
+        } else {
+            if (ring.nfree == 0) { ret = -1; break; }
+            idx = ring.free_q[--ring.nfree];
+            if (ring_fill(&ring, wq->slots[idx].buf, queued, chunk) != 0) {
+                ret = -1;
+                break;
+            }
+        }
+
+        if (wq_submit(wq, idx, chunk) != 0) { ret = -1; break; }
+        if (wq->inflight == 0)
+            ring_release(&ring, idx);   /* synchronous: already on disk */
+        queued += chunk;
+
+        if (stripe_publish(st)) { ret = -1; break; }
+
+        /* Let the reader catch up before running further ahead */
+        if (have_reader) {
+            vault_mutex_lock(&set->lock);
+            while (!set->failed && st->durable - st->checked > window)
+                vault_cond_wait(&set->cond, &set->lock);
+            int failed = set->failed;
+            vault_mutex_unlock(&set->lock);
+            if (failed) { ret = -1; break; }
+        }
+
+        if (rep) {
+            vault_mutex_lock(&set->lock);
+            uint64_t written = set->completed, verified = set->verified;
+            vault_mutex_unlock(&set->lock);
+            vault_mutex_lock(&ring.lock);
+            uint64_t gs = ring.gen_stalls, is = ring.io_stalls;
+            vault_mutex_unlock(&ring.lock);
+            pass_report(rep, written, verified, gs, is, 0);
+            pass_checkpoint(rep);
+        }
+    }
+
+    /* Drain even after a failure, so no buffer is still owned by the
+     * kernel when the next pass refills it. */
+    while (wq->inflight > 0) {
+        int done = wq_reap(wq);
+        if (done < 0) ret = -1;
+        else ring_release(&ring, done);
+    }
+
+    if (have_gen) {
+        vault_mutex_lock(&ring.lock);
+        ring.stop = 1;
+        vault_cond_broadcast(&ring.cond);
+        vault_mutex_unlock(&ring.lock);
+        vault_thread_join(gen);
+    }
+
+    stripe_publish(st);
+    if (wq->stats) wq->stats->fill_ns += ring.fill_ns;
+    vault_mutex_lock(&set->lock);
+    set->gen_stalls += ring.gen_stalls;
+    set->io_stalls += ring.io_stalls;
+    if (ret != 0) set->failed = 1;
+    vault_cond_broadcast(&set->cond);
+    vault_mutex_unlock(&set->lock);
+
+    /* The reader finishes the rest of the stripe on its own */
+    if (have_reader) {
+        vault_thread_join(reader);
+        if (st->verify_ret != 0) ret = -1;
+    }
+    if (st->verify_dev && !have_reader) ret = -1;
+
+    ring_destroy(&ring);
+    return ret;
+}
+
+static void *stripe_worker(void *arg)
+{
+    stripe_t *st = (stripe_t *)arg;
+    numa_pin(st->wq->numa);
+    st->ret = stripe_write(st, NULL);
+
+    vault_mutex_lock(&st->set->lock);
+    st->set->running--;
+    vault_cond_broadcast(&st->set->cond);
+    vault_mutex_unlock(&st->set->lock);
+    return NULL;
+}
+
+/* Read back the ragged end written by disk_write_tail(). Unbuffered
+ * reads cannot reach it either, so this goes through the page cache,
+ * which disk_write_tail() has already flushed. */
+static int verify_tail(const char *dev, uint64_t offset,
+                        const uint8_t *expect, size_t len)
+{
+    int direct = 0;
+    disk_handle_t fd = disk_open_read(dev, &direct);
+    if (fd == INVALID_DISK_HANDLE) return -1;
+    uint8_t *buf = (uint8_t *)malloc(len);
+    int ok = buf && disk_pread(fd, buf, len, offset) == (int)len &&
+             memcmp(buf, expect, len) == 0;
+    free(buf);
+    disk_close(fd);
+    return ok ? 0 : -1;
+}
+
+/* How a pass can be left to the drive: a zero pass as WRITE ZEROES,
+ * else any pattern that repeats within a logical block as WRITE SAME
+ * of one block. Never with read-back fused into the writes or a
+ * journal, whose checkpoints follow the stripes. */
+enum { OFFLOAD_NONE, OFFLOAD_ZEROOUT, OFFLOAD_SAME };
+
+static int pass_offload(const write_queue_t *wq, const pass_kernel_t *k,
+                         int fused, const journal_t *jn)
+{
+    if (k->kind == VAULT_WIPE_PASS_RANDOM || fused || jn)
+        return OFFLOAD_NONE;
+    if (k->kind == VAULT_WIPE_PASS_ZERO && wq->zeroout)
+        return OFFLOAD_ZEROOUT;
+    if (wq->same && wq->block % k->pat_len == 0) return OFFLOAD_SAME;
+    return OFFLOAD_NONE;
+}
+
+/* Have the drive write from `from` to the last whole block, a range at
+ * a time so progress keeps moving. Returns how far it got: a range the
+ * drive fails, bad sectors included, ends the offload and the caller
+ * writes the rest. A drive that rejects WRITE SAME outright is not
+ * asked again. */
+static uint64_t offload_pass(write_queue_t *wq, int method,
+                              const pass_kernel_t *k,
+                              uint64_t disk_size, uint64_t from,
+                              pass_report_t *rep)
+{
+    /* Slot 0 is idle until the stripes start; one block of it is the
+     * WRITE SAME payload, in the same phase as every written chunk */
+    uint8_t *block = wq->slots[0].buf;
+    if (method == OFFLOAD_SAME)
+        k->fill(block, wq->block, k->pat, k->pat_len);
+
+    uint64_t end = disk_size - disk_size % wq->block;
+    uint64_t off = from - from % wq->block;
+    while (off < end) {
+        uint64_t len = end - off;
+        if (len > WIPE_OFFLOAD_RANGE) len = WIPE_OFFLOAD_RANGE;
+        uint64_t t0 = now_ns();
+        int refused = 0;
+        int ret = method == OFFLOAD_ZEROOUT
+                ? disk_zeroout(wq->fd, wq->base + off, len)
+                : vault_wipe_same_write(wq->same, wq->base + off, len, block,
+                                        &refused);
+        if (ret != 0) {
+            fprintf(stderr, "wipe: %s: %s %s at %llu MB, writing the "
+                    "rest\n", wq->dev,
+                    method == OFFLOAD_ZEROOUT ? "write zeroes" : "write same",
+                    refused ? "refused" : "failed",
+                    (unsigned long long)(off >> 20));
+            if (refused) wq->same = NULL;
+            break;
+        }
+        if (wq->stats) {
+            uint64_t ns = now_ns() - t0;
+            vault_wipe_hist_add(&wq->stats->write_lat, ns);
+            wq->stats->write_ns += ns;
+            wq->stats->writes++;
+            wq->stats->bytes_offloaded += len;
+        }
+        off += len;
+        pass_report(rep, off, 0, 0, 0, 0);
+    }
+    return off > from ? off : from;
+}
+
+/* Write one pass over the whole device through nstripes queues. All
+ * queues must share one buffer size. k is the pass's kernel: a keyed
+ * stream for a random pass, else a pattern and its fill. A non-NULL verify_dev reads the pass back from
+ * that path while it is being written. A journal gets checkpoints, and
+ * may hand in where an interrupted run of this pass got to; failing
+ * that, `from` says how much of the pass another engine has written.
+ * Pattern passes the drive can write itself (pass_offload()) go to it
+ * as WRITE ZEROES or WRITE SAME. Non-NULL stats gets the pass's counters added to it. */
+static int do_direct_pass(write_queue_t *wqs, int nstripes, int threaded,
+                           uint64_t disk_size, const pass_kernel_t *k,
+                           const char *verify_dev, journal_t *jn,
+                           uint64_t from, vault_wipe_stats_t *stats,
+                           int pass_num, int total_passes,
+                           const char *desc,
+                           vault_wipe_progress_cb progress_cb)
+{
+    if (nstripes < 1 || nstripes > VAULT_WIPE_STRIPES_MAX) return -1;
+
+    /* Unbuffered writes must be whole blocks; a ragged end is written
+     * separately once the rest of the pass is down. */
+    write_queue_t *wq = &wqs[0];
+    uint64_t body = disk_size;
+    if (wq->direct) body -= disk_size % wq->block;
+
+    /* Stripes start on chunk boundaries so every chunk -- and so every
+     * pattern repeat -- lands where a single stream would put it. */
+    uint64_t nchunks = (body + wq->buf_size - 1) / wq->buf_size;
+    if (nchunks < (uint64_t)nstripes * WIPE_STRIPE_MIN_CHUNKS)
+        nstripes = 1;
+    uint64_t per = (nchunks / (uint64_t)nstripes) * wq->buf_size;
+
+    /* Writer and reader counters for each stripe, merged at the end */
+    vault_wipe_stats_t *ts = NULL;
+    if (stats) {
+        ts = (vault_wipe_stats_t *)calloc((size_t)nstripes * 2, sizeof(*ts));
+        if (!ts) return -1;
+    }
+
+    stripe_set_t set;
+    memset(&set, 0, sizeof(set));
+    vault_mutex_init(&set.lock);
+    vault_cond_init(&set.cond);
+
+    stripe_t st[VAULT_WIPE_STRIPES_MAX];
+    vault_thread_t workers[VAULT_WIPE_STRIPES_MAX];
+    int started[VAULT_WIPE_STRIPES_MAX] = { 0 };
+    for (int i = 0; i < nstripes; i++) {
+        st[i] = (stripe_t) {
+            .wq = &wqs[i], .set = &set, .threaded = threaded, .k = k,
+            .start = (uint64_t)i * per,
+            .end = (i == nstripes - 1) ? body : (uint64_t)(i + 1) * per,
+            .ret = -1,
+            .verify_dev = verify_dev,
+            .vstats = ts ? &ts[2 * i + 1] : NULL
+        };
+        st[i].durable = st[i].checked = st[i].start;
+        wqs[i].stats = ts ? &ts[2 * i] : NULL;
+    }
+
+    double start = now_secs();
+    int offload = pass_offload(wq, k, verify_dev != NULL, jn);
+    if (offload != OFFLOAD_NONE) {
+        pass_report_t orep = {
+            .cb = progress_cb, .pass_num = pass_num,
+            .total_passes = total_passes, .disk_size = disk_size,
+            .desc = desc, .start = start, .last_report = start,
+            .bad = wq->bad
+        };
+        from = offload_pass(wq, offload, k, disk_size, from, &orep);
+    }
+
+    /* Whole chunks below `from` are done, so every stripe still
+     * starts on a chunk boundary */
+    if (from < body) from -= from % wq->buf_size;
+    for (int i = 0; !jn && from > 0 && i < nstripes; i++) {
+        uint64_t at = from < st[i].start ? st[i].start
+                    : from > st[i].end   ? st[i].end : from;
+        set.completed += at - st[i].start;
+        st[i].start = st[i].durable = st[i].checked = at;
+    }
+
+    /* Carry on from the journal if the pass is laid out as it was */
+    if (jn) {
+        int keep = jn->resume && jn->rec.nstripes == nstripes &&
+                   jn->rec.chunk == wq->buf_size;
+        for (int i = 0; keep && i < nstripes; i++)
+            if (jn->rec.done[i] < st[i].start || jn->rec.done[i] > st[i].end)
+                keep = 0;
+        for (int i = 0; keep && i < nstripes; i++) {
+            set.completed += jn->rec.done[i] - st[i].start;
+            st[i].start = st[i].durable = st[i].checked = jn->rec.done[i];
+        }
+        memset(jn->rec.done, 0, sizeof(jn->rec.done));
+        for (int i = 0; i < nstripes; i++)
+            jn->rec.done[i] = st[i].start;
+        jn->resume = 0;
+        jn->rec.nstripes = nstripes;
+        jn->rec.chunk = wq->buf_size;
+        journal_write(jn);
+    }
+
+    pass_report_t rep = {
+        .cb = progress_cb, .pass_num = pass_num,
+        .total_passes = total_passes, .disk_size = disk_size,
+        .desc = desc, .start = start, .bad = wq->bad,
+        .journal = jn, .set = &set, .stripes = st, .nstripes = nstripes
+    };
+    rep.last_report = rep.start;
+    int service = jn ? vault_services_add(checkpoint_service, &rep,
+                                          WIPE_CHECKPOINT_TICK) : -1;
+    rep.offpath = service >= 0;
+
+    /* A stripe whose thread will not start is written after stripe 0 */
+    for (int i = 1; i < nstripes; i++) {
+        vault_mutex_lock(&set.lock);
+        set.running++;
+        vault_mutex_unlock(&set.lock);
+        started[i] = vault_thread_create(&workers[i], stripe_worker,
+                                         &st[i]) == 0;
+        if (!started[i]) {
+            vault_mutex_lock(&set.lock);
+            set.running--;
+            vault_mutex_unlock(&set.lock);
+        }
+    }
+
+    int ret = stripe_write(&st[0], &rep);
+    for (int i = 1; i < nstripes && ret == 0; i++)
+        if (!started[i]) ret = stripe_write(&st[i], &rep);
+    if (ret != 0) {
+        vault_mutex_lock(&set.lock);
+        set.failed = 1;
+        vault_mutex_unlock(&set.lock);
+    }
+
+    /* Keep reporting while the workers finish their stripes */
+    vault_mutex_lock(&set.lock);
+    while (set.running > 0) {
+        vault_cond_wait(&set.cond, &set.lock);
+        uint64_t written = set.completed, verified = set.verified;
+        uint64_t gs = set.gen_stalls, is = set.io_stalls;
+        vault_mutex_unlock(&set.lock);
+        pass_report(&rep, written, verified, gs, is, 0);
+        pass_checkpoint(&rep);
+        vault_mutex_lock(&set.lock);
+    }
+    vault_mutex_unlock(&set.lock);
+
+    for (int i = 1; i < nstripes; i++) {
+        if (!started[i]) continue;
+        vault_thread_join(workers[i]);
+        if (st[i].ret != 0) ret = -1;
+    }
+    vault_services_remove(service);
+
+    /* All slots are idle now, so slot 0 can stage the tail */
+    uint64_t written = set.completed;
+    if (ret == 0 && body < disk_size) {
+        size_t tail = (size_t)(disk_size - body);
+        uint8_t *src = wq->slots[0].buf;
+        if (k->stream)
+            ret = vault_wipe_stream_generate(k->stream, body, src, tail);
+        else
+            src += body % wq->buf_size;     /* continue the last chunk */
+        if (ret == 0)
+            ret = disk_write_tail(wq->fd, wq->base + body, src, tail);
+        if (ret == 0)
+            written += tail;
+        if (ret == 0 && verify_dev) {
+            ret = verify_tail(verify_dev, wq->base + body, src, tail);
+            if (ret == 0) set.verified += tail;
+        }
+    }
+
+    if (ret == 0)
+        pass_report(&rep, written, set.verified, set.gen_stalls,
+                    set.io_stalls, 1);
+
+    vault_cond_destroy(&set.cond);
+    vault_mutex_destroy(&set.lock);
+    if (ret == 0) {
+        for (int i = 0; i < nstripes; i++)
+            wq_sync(&wqs[i]);
+    }
+
+    if (ts) {
+        for (int i = 0; i < nstripes; i++) {
+            wqs[i].stats = NULL;
+            vault_wipe_stats_merge(stats, &ts[2 * i]);
+            vault_wipe_stats_merge(stats, &ts[2 * i + 1]);
+        }
+        stats->bytes_written += written;
+        stats->bytes_verified += set.verified;
+        stats->gen_stalls += set.gen_stalls;
+        stats->io_stalls += set.io_stalls;
+        free(ts);
+    }
+    return ret;
 }
 
 /* ------------------------------------------------------------------ */
 /*  Single verify pass                                                 */
 /* ------------------------------------------------------------------ */
 
-static int do_direct_verify(const char *device, uint64_t disk_size,
+/* Read the device back and compare it with what the pass wrote. A
+ * random pass is checked against its keystream regenerated from the
+ * same stream state, so nothing written needs to be kept. */
+static int do_direct_verify(const char *device, uint64_t base,
+                              uint64_t disk_size,
                               uint8_t *wbuf, uint8_t *vbuf,
-                              size_t buf_size, int is_random,
-                              const uint8_t *pat, size_t pat_len,
+                              size_t buf_size, const pass_kernel_t *k,
+                              bad_map_t *bad, vault_wipe_qos_t *qos,
+                              vault_wipe_stats_t *stats,
                               int pass_num, int total_passes,
                               vault_wipe_progress_cb progress_cb)
 {
-    if (!is_random && (!pat || pat_len == 0)) return -1;
-
-    disk_handle_t fd = disk_open_read(device);
+    int direct = 0;
+    disk_handle_t fd = disk_open_read(device, &direct);
     if (fd == INVALID_DISK_HANDLE) return -1;
 
+    size_t block = disk_block_size(fd);
+
     double start = now_secs();
     double last_report = start;
     uint64_t verified = 0;
@@ -444,15 +2756,26 @@ static int do_direct_verify(const char *device, uint64_t disk_size,
         if (chunk == 0) break;
 #endif
 
-        int rd = disk_read(fd, vbuf, chunk);
-        if (rd < 0) { ret = -1; break; }
-
-        if (!is_random) {
-            fill_pattern(wbuf, chunk, pat, pat_len);
-            if (memcmp(wbuf, vbuf, chunk) != 0) { ret = -1; break; }
+        /* Whole chunks only, so the pattern phase lines up */
+        qos_wait(qos, chunk, stats);
+        uint64_t t0 = stats || qos ? now_ns() : 0;
+        if (read_range(fd, base, vbuf, chunk, verified, block, bad) != 0) {
+            ret = -1;
+            break;
+        }
+        qos_done(qos, t0);
+        if (stats) vault_wipe_hist_add(&stats->read_lat, now_ns() - t0);
+        if (check_chunk(device, base, vbuf, chunk, verified, block, k,
+                        wbuf, bad) != 0) {
+            ret = -1;
+            break;
         }
 
-        verified += (uint64_t)rd;
+        verified += chunk;
+        if (stats) {
+            stats->verify_ns += now_ns() - t0;
+            stats->bytes_verified += chunk;
+        }
 
         double now = now_secs();
         if (progress_cb && (now - last_report > 0.5)) {
@@ -473,7 +2796,323 @@ static int do_direct_verify(const char *device, uint64_t disk_size,
         }
     }
 
-    disk_close(fd);
+    disk_close(fd);
+    return ret;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Sampled verify pass                                                */
+/* ------------------------------------------------------------------ */
+
+/* Sampled verification reads ranges of this size, or of one chunk if
+ * chunks are smaller, so every range lies inside one written chunk. */
+#define WIPE_SAMPLE_LEN (1024 * 1024)
+
+/* splitmix64: sample placement only has to be spread evenly, not be
+ * unpredictable, so one platform-random seed is enough. */
+static uint64_t sample_next(uint64_t *s)
+{
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Read back sample_pct percent of the device and compare it with what
+ * the pass wrote. The device is cut into as many equal strata as there
+ * are samples and one range at a random position is read from each, so
+ * samples are random but never bunch up. With no mismatch in n ranges,
+ * fewer than 3/n of all ranges differ at 95% confidence (rule of
+ * three), which is logged with the coverage and time taken. */
+static int do_sampled_verify(const char *device, uint64_t base,
+                              uint64_t disk_size,
+                              uint8_t *wbuf, uint8_t *vbuf,
+                              size_t buf_size, double sample_pct,
+                              const pass_kernel_t *k,
+                              bad_map_t *bad, vault_wipe_qos_t *qos,
+                              vault_wipe_stats_t *stats,
+                              int pass_num, int total_passes,
+                              vault_wipe_progress_cb progress_cb)
+{
+    size_t unit = buf_size < WIPE_SAMPLE_LEN ? buf_size : WIPE_SAMPLE_LEN;
+    uint64_t units = disk_size / unit;
+    uint64_t want = (uint64_t)((double)units * sample_pct / 100.0);
+    if ((double)want < (double)units * sample_pct / 100.0) want++;
+    if (want == 0 || want >= units)
+        return do_direct_verify(device, base, disk_size, wbuf, vbuf,
+                                buf_size, k, bad, qos, stats, pass_num,
+                                total_passes, progress_cb);
+
+    uint64_t seed;
+    if (vault_platform_random((uint8_t *)&seed, sizeof(seed)) != 0)
+        return -1;
+
+    /* Whole ranges only, so unbuffered reads stay block-aligned and
+     * every sample reaches the media rather than readahead */
+    int direct = 1;
+    disk_handle_t fd = disk_open_read(device, &direct);
+    if (fd == INVALID_DISK_HANDLE) return -1;
+    size_t block = disk_block_size(fd);
+
+    uint64_t q = units / want, r = units % want;
+    uint64_t total = want * (uint64_t)unit;
+    double start = now_secs();
+    double last_report = start;
+    uint64_t verified = 0;
+    int ret = 0;
+
+    for (uint64_t i = 0; i < want; i++) {
+        uint64_t first = i * q + (i < r ? i : r);
+        uint64_t span = q + (i < r ? 1 : 0);
+        uint64_t off = (first + sample_next(&seed) % span) * unit;
+
+        qos_wait(qos, unit, stats);
+        uint64_t t0 = stats || qos ? now_ns() : 0;
+        if (read_range(fd, base, vbuf, unit, off, block, bad) != 0) {
+            ret = -1;
+            break;
+        }
+        qos_done(qos, t0);
+        if (stats) vault_wipe_hist_add(&stats->read_lat, now_ns() - t0);
+
+        /* Patterns restart at every chunk; line this range up with it */
+        uint8_t rot[VAULT_WIPE_PATTERN_MAX];
+        pass_kernel_t rk = *k;
+        if (!k->stream) {
+            size_t phase = (size_t)((off % buf_size) % k->pat_len);
+            for (size_t j = 0; j < k->pat_len; j++)
+                rot[j] = k->pat[(phase + j) % k->pat_len];
+            rk.pat = rot;
+            vault_wipe_checker_init(&rk.check, rot, k->pat_len);
+        }
+        if (check_chunk(device, base, vbuf, unit, off, block, &rk,
+                        wbuf, bad) != 0) {
+            ret = -1;
+            break;
+        }
+
+        verified += unit;
+        if (stats) {
+            stats->verify_ns += now_ns() - t0;
+            stats->bytes_verified += unit;
+        }
+
+        double now = now_secs();
+        if (progress_cb && (now - last_report > 0.5)) {
+            double elapsed = now - start;
+            double speed = (elapsed > 0) ? ((double)verified / elapsed) : 0;
+            vault_wipe_progress_t prog = {
+                .current_pass = pass_num,
+                .total_passes = total_passes,
+                .bytes_written = verified,
+                .bytes_total = total,
+                .speed_mbps = speed / (1024.0 * 1024.0),
+                .eta_secs = (speed > 0) ? ((double)(total - verified) / speed) : 0,
+                .pass_description = "Verifying (sampled)",
+                .verifying = 1
+            };
+            progress_cb(&prog);
+            last_report = now;
+        }
+    }
+
+    disk_close(fd);
+    if (ret == 0) {
+        double bound = 300.0 / (double)want;
+        fprintf(stderr, "wipe: %s: pass %d sampled %.2f%% (%llu x %zu KB) "
+                "in %.1f s, under %.3g%% of ranges differ at 95%% "
+                "confidence\n", device, pass_num,
+                100.0 * (double)total / (double)disk_size,
+                (unsigned long long)want, unit / 1024,
+                now_secs() - start, bound < 100 ? bound : 100);
+    }
+    return ret;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Pass with verification                                             */
+/* ------------------------------------------------------------------ */
+
+/* A random pass's seed drawn ahead of the wipe (see "Prewarm") */
+typedef struct {
+    uint8_t seed[VAULT_WIPE_STREAM_SEED_LEN];
+    int     ready;
+} wipe_preseed_t;
+
+/* Everything a device's passes share */
+typedef struct {
+    write_queue_t *wq;
+    int            nstripes;
+    int            threaded;
+    wipe_rng_t     rng;
+    const char    *dev;         /* resolved path, for verify reads */
+    uint64_t       base;        /* device offset of the wiped range */
+    uint64_t       disk_size;   /* its length */
+    int            verify;
+    int            fused;       /* verify while writing, not after */
+    double         sample_pct;  /* read back this percent, 0 = all */
+    uint8_t       *wbuf;        /* keystream reference, chunk bytes */
+    uint8_t       *vbuf;        /* verify read-back, chunk bytes */
+    size_t         chunk;
+    bad_map_t     *bad;         /* NULL = not skipping bad blocks */
+    journal_t     *journal;     /* NULL = not journalled */
+    int            first_pass;  /* earlier passes were done elsewhere */
+    uint64_t       first_offset;    /* and this much of first_pass */
+    const char    *name;        /* device as given, for the report */
+    FILE          *report;      /* JSON lines, NULL = no telemetry */
+    vault_wipe_stats_t *total;  /* all passes so far */
+    wipe_preseed_t *preseed;    /* first random pass's, NULL = none */
+    vault_wipe_progress_cb progress_cb;
+} wipe_job_t;
+
+/* One JSON line per pass, flushed at once so a serial console or a
+ * file shared by several targets gets whole lines. */
+static void report_pass(const wipe_job_t *job, int pass_num,
+                         int total_passes, const char *desc,
+                         const pass_kernel_t *k, int ret,
+                         const vault_wipe_stats_t *ps)
+{
+    FILE *fp = job->report;
+    fprintf(fp, "{\"event\":\"pass\",\"device\":");
+    vault_wipe_json_string(fp, job->name);
+    fprintf(fp, ",\"pass\":%d,\"passes\":%d,\"description\":",
+            pass_num, total_passes);
+    vault_wipe_json_string(fp, desc);
+    fprintf(fp, ",\"data\":\"%s\",\"result\":%d,",
+            k->stream ? vault_wipe_rng_name(k->stream->rng) : "pattern", ret);
+    vault_wipe_stats_json(fp, ps);
+    fprintf(fp, "}\n");
+    fflush(fp);
+}
+
+/* Fill the reserved area, record included, with what the final pass
+ * would have put there; afterwards nothing is left to resume. */
+static int journal_finish(journal_t *jn, size_t chunk,
+                           const pass_kernel_t *k, const char *verify_dev)
+{
+    size_t len = (size_t)(jn->disk_size - jn->offset);
+    uint8_t *buf = (uint8_t *)malloc(len);
+    if (!buf) return -1;
+
+    int ret = 0;
+    if (k->stream)
+        ret = vault_wipe_stream_generate(k->stream, jn->offset, buf, len);
+    else
+        for (size_t i = 0; i < len; i++)
+            buf[i] = k->pat[((jn->offset + i) % chunk) % k->pat_len];
+
+    if (ret == 0 && disk_pwrite(jn->fd, buf, len, jn->offset) != (int)len)
+        ret = -1;
+    if (ret == 0) disk_sync(jn->fd);
+    if (ret == 0 && verify_dev)
+        ret = verify_tail(verify_dev, jn->offset, buf, len);
+    free(buf);
+    return ret;
+}
+
+/* Write one pass and, if asked, verify it: fused into the write when
+ * the job allows, else as a separate read-back pass. Random passes get
+ * a fresh key here and keep it until verification has regenerated the
+ * stream; the kernel generator cannot be replayed, so its passes go
+ * unchecked. In a journalled wipe, passes finished before an
+ * interruption are skipped and the one it stopped in continues with
+ * its original key. Passes another engine finished are skipped too. */
+static int run_pass(const wipe_job_t *job, const vault_wipe_pass_t *pass,
+                     int pass_num, int total_passes, const char *desc)
+{
+    int is_random = pass->kind == VAULT_WIPE_PASS_RANDOM;
+    journal_t *jn = job->journal;
+    if (jn && pass_num < jn->first_pass) return 0;
+    if (pass_num < job->first_pass) return 0;
+    uint64_t from = pass_num == job->first_pass ? job->first_offset : 0;
+    if (jn && (jn->rec.pass != pass_num || jn->rec.random != is_random))
+        jn->resume = 0;
+
+    vault_wipe_stream_t stream;
+    if (is_random) {
+        uint8_t seed[VAULT_WIPE_STREAM_SEED_LEN];
+        int seeded = 0;
+        if (jn && jn->resume) {
+            memcpy(seed, jn->rec.seed, sizeof(seed));
+            seeded = vault_wipe_stream_init(&stream, jn->rec.rng, seed) == 0;
+            if (!seeded) jn->resume = 0;
+        }
+        if (!seeded && job->preseed && job->preseed->ready) {
+            memcpy(seed, job->preseed->seed, sizeof(seed));
+            vault_secure_memzero(job->preseed, sizeof(*job->preseed));
+            seeded = vault_wipe_stream_init(&stream, job->rng, seed) == 0;
+        }
+        if (!seeded)
+            seeded = vault_platform_random(seed, sizeof(seed)) == 0 &&
+                     vault_wipe_stream_init(&stream, job->rng, seed) == 0;
+        if (seeded && jn) {
+            memcpy(jn->rec.seed, seed, sizeof(seed));
+            jn->rec.rng = stream.rng;
+        }
+        vault_secure_memzero(seed, sizeof(seed));
+        if (!seeded) return -1;
+    } else if (jn) {
+        memset(jn->rec.seed, 0, sizeof(jn->rec.seed));
+        jn->rec.rng = WIPE_RNG_AUTO;
+    }
+    if (jn) {
+        jn->rec.pass = pass_num;
+        jn->rec.random = is_random;
+    }
+    pass_kernel_t k;
+    kernel_bind(&k, pass, is_random ? &stream : NULL);
+
+    int check = job->verify && !(is_random && stream.rng == WIPE_RNG_KERNEL);
+    int fused = check && job->fused && !pass_offload(job->wq, &k, 0, jn);
+
+    char qdev[VAULT_CONFIG_MAX_PATH + 8];
+    vault_events_quote(qdev, sizeof(qdev), job->name);
+    vault_event("pass_start", ",\"device\":%s,\"pass\":%d,\"passes\":%d,"
+                "\"pattern\":\"%s\",\"verify\":%d", qdev, pass_num,
+                total_passes, is_random ? "random" : "pattern", check);
+
+    vault_wipe_stats_t *ps = NULL;
+    if (job->total)
+        ps = (vault_wipe_stats_t *)calloc(1, sizeof(*ps));
+    uint64_t t0 = now_ns();
+
+    int ret = do_direct_pass(job->wq, job->nstripes, job->threaded,
+                             job->disk_size, &k,
+                             fused ? job->dev : NULL, jn, from, ps,
+                             pass_num, total_passes, desc,
+                             job->progress_cb);
+    if (ret == 0 && check && !fused && job->sample_pct > 0)
+        ret = do_sampled_verify(job->dev, job->base, job->disk_size,
+                                job->wbuf, job->vbuf, job->chunk,
+                                job->sample_pct, &k,
+                                job->bad, job->wq->qos, ps, pass_num,
+                                total_passes, job->progress_cb);
+    else if (ret == 0 && check && !fused)
+        ret = do_direct_verify(job->dev, job->base, job->disk_size,
+                               job->wbuf, job->vbuf, job->chunk, &k,
+                               job->bad, job->wq->qos, ps,
+                               pass_num, total_passes, job->progress_cb);
+    if (ret == 0 && jn && pass_num == total_passes)
+        ret = journal_finish(jn, job->chunk, &k, check ? job->dev : NULL);
+
+    uint64_t elapsed = now_ns() - t0;
+    uint64_t bytes = job->disk_size - from;
+    double secs = (double)elapsed / 1e9;
+    vault_event("pass_end", ",\"device\":%s,\"pass\":%d,\"result\":%d,"
+                "\"bytes\":%llu,\"seconds\":%.3f,\"mbps\":%.1f,"
+                "\"skipped_bytes\":%llu", qdev, pass_num, ret,
+                (unsigned long long)bytes, secs,
+                secs > 0 ? (double)bytes / secs / (1024.0 * 1024.0) : 0.0,
+                (unsigned long long)(job->bad ? job->bad->bytes : 0));
+
+    if (ps) {
+        ps->elapsed_ns = elapsed;
+        if (job->report)
+            report_pass(job, pass_num, total_passes, desc, &k, ret, ps);
+        vault_wipe_stats_merge(job->total, ps);
+        free(ps);
+    }
+    if (is_random) vault_wipe_stream_destroy(&stream);
     return ret;
 }
 
@@ -481,19 +3120,60 @@ static int do_direct_verify(const char *device, uint64_t disk_size,
 /*  vault_wipe_device -- top-level dispatcher                          */
 /* ------------------------------------------------------------------ */
 
+#if defined(VAULT_PLATFORM_LINUX)
+/* Whether vault_wipe_device() hands a whole-device wipe to nwipe, which
+ * cannot sample, journal or run a custom schedule. */
+static int wipe_by_nwipe(int verify, const vault_wipe_params_t *params)
+{
+    int sampled = verify && params && params->verify_sample_pct > 0;
+    int journal = params && params->journal;
+    int custom = params && params->schedule && params->schedule[0];
+    return !sampled && !journal && !custom && vault_wipe_nwipe_available();
+}
+#endif
+
 int vault_wipe_device(const char *device, wipe_algorithm_t algorithm,
-                       int verify)
+                       int verify, const vault_wipe_params_t *params,
+                       vault_wipe_progress_cb progress_cb)
 {
+    /* nwipe and the drive's own erase only take whole devices */
+    if (params && params->extents && params->extent_count > 0)
+        return vault_wipe_device_direct_params(device, algorithm, verify,
+                                                params, progress_cb);
+
+    if (algorithm == WIPE_HW_ERASE) {
+        if (vault_wipe_hw_erase(device, progress_cb) == 0) return 0;
+        algorithm = WIPE_RANDOM;
+    }
+
 #if defined(VAULT_PLATFORM_LINUX)
-    if (!vault_wipe_nwipe_available())
-        return vault_wipe_device_direct(device, algorithm, verify, NULL);
+    if (!wipe_by_nwipe(verify, params))
+        return vault_wipe_device_direct_params(device, algorithm, verify,
+                                                params, progress_cb);
 
     const char *mflag = vault_wipe_algorithm_nwipe_flag(algorithm);
 
+    uint64_t disk_size = vault_wipe_get_device_size(device);
+    if (disk_size > 0 && (!params || params->meta_first))
+        meta_phase(device, device, 0, disk_size,
+                   params ? params->rng : WIPE_RNG_AUTO);
+
+    /* nwipe's log, and so its progress, comes back through a pipe */
+    int out[2];
+    if (pipe(out) != 0) return -1;
+
     pid_t pid = fork();
-    if (pid < 0) return -1;
+    if (pid < 0) {
+        close(out[0]);
+        close(out[1]);
+        return -1;
+    }
 
     if (pid == 0) {
+        dup2(out[1], STDOUT_FILENO);
+        dup2(out[1], STDERR_FILENO);
+        close(out[0]);
+        close(out[1]);
         const char *argv[9];
         int ac = 0;
         argv[ac++] = "nwipe";
@@ -508,133 +3188,1011 @@ int vault_wipe_device(const char *device, wipe_algorithm_t algorithm,
         _exit(127);
     }
 
+    close(out[1]);
+    nwipe_watch_t w;
     int status;
-    if (waitpid(pid, &status, 0) < 0) return -1;
+    int reaped = nwipe_watch(pid, out[0], disk_size, progress_cb,
+                             &w, &status) == 0;
+    close(out[0]);
+    if (!reaped) return -1;
 
     if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return 0;
 
-    return vault_wipe_device_direct(device, algorithm, verify, NULL);
+    /* Take over where nwipe stopped: the passes it finished stand. A
+     * pass to be verified is rewritten whole, since what nwipe wrote
+     * cannot be checked against this engine's data. */
+    vault_wipe_params_t cont;
+    if (params) cont = *params;
+    else vault_wipe_params_init(&cont);
+    cont.meta_first = 0;
+    if (w.pass > 0 && w.passes == algorithm_passes(algorithm)) {
+        cont.start_pass = w.pass;
+        cont.start_offset = verify ? 0 : w.pass_done;
+        fprintf(stderr, "wipe: %s: nwipe stopped in pass %d/%d, "
+                "continuing at %llu MB\n", device, w.pass, w.passes,
+                (unsigned long long)(cont.start_offset >> 20));
+    }
+    return vault_wipe_device_direct_params(device, algorithm, verify,
+                                            &cont, progress_cb);
 #else
-    return vault_wipe_device_direct(device, algorithm, verify, NULL);
+    return vault_wipe_device_direct_params(device, algorithm, verify,
+                                            params, progress_cb);
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/*  Engine parameters                                                  */
+/* ------------------------------------------------------------------ */
+
+void vault_wipe_params_init(vault_wipe_params_t *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->direct_io = 1;
+    params->verify_fused = 1;
+    params->skip_bad = 1;
+    params->offload = 1;
+    params->meta_first = 1;
+    params->numa = 1;
+}
+
+void vault_wipe_params_from_config(vault_wipe_params_t *params,
+                                    const vault_config_t *cfg)
+{
+    vault_wipe_params_init(params);
+    if (cfg->wipe_chunk_kb > 0)
+        params->chunk_size = (size_t)cfg->wipe_chunk_kb * 1024;
+    if (cfg->wipe_queue_depth > 0)
+        params->queue_depth = cfg->wipe_queue_depth;
+    if (cfg->wipe_ring_depth > 0)
+        params->ring_depth = cfg->wipe_ring_depth;
+    params->rng = cfg->wipe_rng;
+    params->direct_io = cfg->wipe_direct_io;
+    params->probe = cfg->wipe_probe;
+    params->verify_fused = cfg->verify_fused;
+    params->verify_sample_pct = cfg->verify_sample_pct;
+    params->journal = cfg->wipe_journal;
+    params->skip_bad = cfg->wipe_skip_bad;
+    params->offload = cfg->wipe_offload;
+    params->meta_first = cfg->wipe_metadata_first;
+    params->numa = cfg->wipe_numa;
+    params->report_path = cfg->wipe_report[0] ? cfg->wipe_report : NULL;
+    params->schedule = cfg->wipe_schedule[0] ? cfg->wipe_schedule : NULL;
+    if (cfg->wipe_stripes > 0)
+        params->stripes = cfg->wipe_stripes;
+    params->rate_mbps = cfg->wipe_rate_mbps;
+    params->rate_latency_ms = cfg->wipe_rate_latency_ms;
+    params->io_backend = cfg->wipe_io_backend[0] ? cfg->wipe_io_backend
+                                                 : NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Device capabilities                                                */
+/* ------------------------------------------------------------------ */
+
+/* Sustained write rates typical of each kind of device, on the low
+ * side: plans made with them err towards finishing in time. */
+#define WIPE_MBPS_NVME  1000
+#define WIPE_MBPS_SSD   350
+#define WIPE_MBPS_HDD   120
+#define WIPE_MBPS_USB   25
+
+int vault_wipe_caps(const char *device, vault_wipe_caps_t *caps)
+{
+    memset(caps, 0, sizeof(*caps));
+    char resolved_path[256];
+    const char *dev = resolve_device_path(device, resolved_path,
+                                           sizeof(resolved_path));
+    caps->size_bytes = vault_wipe_get_device_size(dev);
+
+    int ssd = vault_wipe_is_ssd(device);
+    caps->flash = ssd == 1;
+    caps->kind = ssd == 1 ? "ssd" : "hdd";
+    caps->write_mbps = ssd == 1 ? WIPE_MBPS_SSD : WIPE_MBPS_HDD;
+#if defined(VAULT_PLATFORM_LINUX)
+    char base[64];
+    sysfs_disk_name(device, base, sizeof(base));
+    if (strncmp(base, "nvme", 4) == 0) {
+        caps->kind = "nvme";
+        caps->write_mbps = WIPE_MBPS_NVME;
+    } else if (sysfs_disk_attr(device, "removable") == 1) {
+        caps->kind = "usb";
+        caps->write_mbps = WIPE_MBPS_USB;
+    }
 #endif
+
+    caps->zeroout = zeroout_max_bytes(device) > 0;
+    vault_wipe_same_t same;
+    if (vault_wipe_same_open(&same, dev) == 0) {
+        caps->write_same = 1;
+        vault_wipe_same_close(&same);
+    }
+    return caps->size_bytes > 0 ? 0 : -1;
 }
 
 /* ------------------------------------------------------------------ */
 /*  vault_wipe_device_direct -- full direct I/O wipe                   */
 /* ------------------------------------------------------------------ */
 
+/* Stripes share the tuned queue depth. Each ring holds every buffer
+ * of its stripe: those in flight plus those being filled ahead of the
+ * writer. */
+static void stripe_layout(const wipe_tuning_t *tune,
+                          const vault_wipe_params_t *params,
+                          int *depth, int *nbufs)
+{
+    int nstripes = tune->stripes;
+    *depth = tune->depth / nstripes;
+    if (*depth < 2 && tune->depth >= 2) *depth = 2;
+    *nbufs = params->ring_depth > 0 ? params->ring_depth / nstripes
+                                    : *depth + 2;
+    if (*nbufs < 1) *nbufs = 1;
+}
+
+/* One fd and queue per stripe, fd being stripe 0's; settle for fewer
+ * stripes if the extra opens fail or come back in another I/O mode.
+ * Returns the number of stripes opened; with none, fd is still the
+ * caller's to close. */
+static int stripes_open(write_queue_t *wq, int nstripes, const char *dev,
+                        disk_handle_t fd, const vault_wipe_backend_t *be,
+                        int direct, size_t block, int depth, int nbufs,
+                        size_t chunk)
+{
+    int nq = 0;
+    while (nq < nstripes) {
+        disk_handle_t sfd = fd;
+        if (nq > 0) {
+            int sdirect = direct;
+            sfd = disk_open_write(dev, &sdirect);
+            if (sfd == INVALID_DISK_HANDLE) break;
+            if (sdirect != direct) { disk_close(sfd); break; }
+        }
+        if (wq_init(&wq[nq], sfd, be, depth, nbufs, chunk, direct,
+                    block) != 0) {
+            if (nq > 0) disk_close(sfd);
+            break;
+        }
+        nq++;
+    }
+    return nq;
+}
+
+/* Release the stripe queues and their fds. */
+static void stripes_close(write_queue_t *wqs, int n)
+{
+    for (int i = 0; i < n; i++) {
+        disk_handle_t fd = wqs[i].fd;
+        wq_destroy(&wqs[i]);
+        disk_close(fd);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Prewarm                                                            */
+/*                                                                     */
+/*  What wipe_range() sets up before its first write, done ahead for   */
+/*  a device and kept until its wipe takes it: the open fds, tuning,   */
+/*  stripe queues with their buffers faulted in and locked, the        */
+/*  offload lookups and the first random pass's seed, drawn while the  */
+/*  kernel pool may still be filling. Nothing is written, so probe     */
+/*  tuning, which writes, is left to the wipe.                         */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    char          device[256];  /* as the wipe will name it */
+    int           direct_io;    /* the params->direct_io opened for */
+    disk_handle_t fd;           /* stripe 0's; the queues own the rest */
+    int           direct;
+    size_t        block;
+    wipe_tuning_t tune;
+    int           tuned;        /* tune is final: no probe would run */
+    wipe_numa_t   numa;
+    write_queue_t wq[VAULT_WIPE_STRIPES_MAX];
+    int           nq;
+    int           depth, nbufs; /* the stripe_layout() they were built for */
+    int           offload;      /* zeroout and same were looked up */
+    uint64_t      zeroout;
+    vault_wipe_same_t same;
+    int           have_same;
+    wipe_preseed_t preseed;
+} wipe_prewarm_t;
+
+static wipe_prewarm_t *prewarmed[VAULT_WIPE_MAX_TARGETS];
+static vault_mutex_t prewarm_lock;
+static int prewarm_init;        /* set before any wipe thread starts */
+
+/* Fault buf in and keep it resident, so the first pass takes no page
+ * faults; best effort. */
+static void buf_lock(void *buf, size_t len)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    if (VirtualLock(buf, len)) return;
+#else
+    if (mlock(buf, len) == 0) return;
+#endif
+    memset(buf, 0, len);
+}
+
+/* Free the queues, and the extra stripes' fds; stripe 0's is pw->fd. */
+static void prewarm_drop_queues(wipe_prewarm_t *pw)
+{
+    for (int i = 0; i < pw->nq; i++) {
+        disk_handle_t fd = pw->wq[i].fd;
+        wq_destroy(&pw->wq[i]);
+        if (i > 0) disk_close(fd);
+    }
+    pw->nq = 0;
+}
+
+static void prewarm_free(wipe_prewarm_t *pw)
+{
+    if (!pw) return;
+    prewarm_drop_queues(pw);
+    if (pw->fd != INVALID_DISK_HANDLE) disk_close(pw->fd);
+    if (pw->have_same) vault_wipe_same_close(&pw->same);
+    vault_secure_memzero(pw, sizeof(*pw));
+    free(pw);
+}
+
+static wipe_prewarm_t *prewarm_device(const char *device,
+                                      const vault_wipe_params_t *params)
+{
+    wipe_prewarm_t *pw = (wipe_prewarm_t *)calloc(1, sizeof(*pw));
+    if (!pw) return NULL;
+    snprintf(pw->device, sizeof(pw->device), "%s", device);
+    pw->direct_io = params->direct_io;
+
+    char resolved_path[256];
+    const char *dev = resolve_device_path(device, resolved_path,
+                                           sizeof(resolved_path));
+    uint64_t disk_size = vault_wipe_get_device_size(dev);
+
+    pw->direct = params->direct_io;
+    pw->fd = disk_open_write(dev, &pw->direct);
+    if (pw->fd == INVALID_DISK_HANDLE) {
+        free(pw);
+        return NULL;
+    }
+    pw->block = disk_block_size(pw->fd);
+
+    vault_wipe_params_t noprobe = *params;
+    noprobe.probe = 0;
+    tune_device(device, pw->fd, pw->direct, pw->block, 0, disk_size,
+                &noprobe, &pw->tune);
+    pw->tuned = params->chunk_size > 0 || !params->probe ||
+                disk_size < 16 * (uint64_t)WIPE_PROBE_BYTES;
+
+    /* Placed on the device's node before the first touch */
+    numa_probe(params->numa ? device : NULL, &pw->numa);
+    stripe_layout(&pw->tune, params, &pw->depth, &pw->nbufs);
+    pw->nq = stripes_open(pw->wq, pw->tune.stripes, dev, pw->fd,
+                          pw->tune.backend, pw->direct, pw->block,
+                          pw->depth, pw->nbufs, pw->tune.chunk);
+    for (int i = 0; i < pw->nq; i++) {
+        for (int j = 0; j < pw->wq[i].nbufs; j++) {
+            numa_membind(&pw->numa, pw->wq[i].slots[j].buf,
+                         pw->wq[i].buf_size);
+            buf_lock(pw->wq[i].slots[j].buf, pw->wq[i].buf_size);
+        }
+    }
+
+    /* As wipe_range() decides it: a throttled wipe offloads nothing */
+    if (params->offload && params->rate_mbps <= 0) {
+        pw->offload = 1;
+        pw->zeroout = zeroout_max_bytes(device);
+        pw->have_same = vault_wipe_same_open(&pw->same, dev) == 0;
+    }
+
+    pw->preseed.ready = vault_platform_random(pw->preseed.seed,
+                                              sizeof(pw->preseed.seed)) == 0;
+    return pw;
+}
+
+/* The state prewarmed for device, if any and opened for params' I/O
+ * mode; the caller owns it from then on. */
+static wipe_prewarm_t *prewarm_take(const char *device,
+                                    const vault_wipe_params_t *params)
+{
+    if (!prewarm_init) return NULL;
+
+    wipe_prewarm_t *pw = NULL;
+    vault_mutex_lock(&prewarm_lock);
+    for (int i = 0; i < VAULT_WIPE_MAX_TARGETS && !pw; i++) {
+        if (prewarmed[i] && strcmp(prewarmed[i]->device, device) == 0) {
+            pw = prewarmed[i];
+            prewarmed[i] = NULL;
+        }
+    }
+    vault_mutex_unlock(&prewarm_lock);
+
+    if (pw && pw->direct_io != params->direct_io) {
+        prewarm_free(pw);
+        pw = NULL;
+    }
+    return pw;
+}
+
+int vault_wipe_prewarm(const vault_wipe_target_t *targets, int count,
+                       const vault_wipe_params_t *params)
+{
+    if (!prewarm_init) {
+        vault_mutex_init(&prewarm_lock);
+        prewarm_init = 1;
+    }
+    vault_wipe_prewarm_release();
+
+    vault_wipe_params_t defaults;
+    if (!params) {
+        vault_wipe_params_init(&defaults);
+        params = &defaults;
+    }
+
+    int ready = 0;
+    for (int i = 0; i < count && i < VAULT_WIPE_MAX_TARGETS; i++) {
+        const vault_wipe_target_t *t = &targets[i];
+        const vault_wipe_params_t *p = t->params ? t->params : params;
+        if (t->algorithm == WIPE_HW_ERASE) continue;
+#if defined(VAULT_PLATFORM_LINUX)
+        if (t->extent_count == 0 && wipe_by_nwipe(t->verify, p)) continue;
+#endif
+        wipe_prewarm_t *pw = prewarm_device(t->device, p);
+        if (!pw) continue;
+        fprintf(stderr, "wipe: %s: ready, %d stripe%s and %d buffers "
+                "locked\n", t->device, pw->nq, pw->nq == 1 ? "" : "s",
+                pw->nq * pw->nbufs);
+        vault_mutex_lock(&prewarm_lock);
+        prewarmed[i] = pw;
+        vault_mutex_unlock(&prewarm_lock);
+        ready++;
+    }
+    return ready;
+}
+
+void vault_wipe_prewarm_release(void)
+{
+    if (!prewarm_init) return;
+    vault_mutex_lock(&prewarm_lock);
+    for (int i = 0; i < VAULT_WIPE_MAX_TARGETS; i++) {
+        prewarm_free(prewarmed[i]);
+        prewarmed[i] = NULL;
+    }
+    vault_mutex_unlock(&prewarm_lock);
+}
+
 int vault_wipe_device_direct(const char *device, wipe_algorithm_t algorithm,
                               int verify, vault_wipe_progress_cb progress_cb)
 {
+    return vault_wipe_device_direct_params(device, algorithm, verify,
+                                            NULL, progress_cb);
+}
+
+/* Wipe the length bytes of the device from base (0 = to the end) as
+ * if they were all of it. */
+static int wipe_range(const char *device, wipe_algorithm_t algorithm,
+                      int verify, const vault_wipe_params_t *params,
+                      uint64_t base, uint64_t length,
+                      vault_wipe_progress_cb progress_cb)
+{
+    if (params->error_map)
+        memset(params->error_map, 0, sizeof(*params->error_map));
+    if (params->stats)
+        memset(params->stats, 0, sizeof(*params->stats));
+
     char resolved_path[256];
     const char *dev = resolve_device_path(device, resolved_path,
                                            sizeof(resolved_path));
 
+    uint64_t disk_size = vault_wipe_get_device_size(dev);
+    if (base > 0) {
+        if (base >= disk_size) {
+            fprintf(stderr, "wipe: %s: range at %llu is past the end of "
+                    "the device\n", device, (unsigned long long)base);
+            return -1;
+        }
+        disk_size -= base;
+    }
+    if (length > 0 && (disk_size == 0 || length < disk_size))
+        disk_size = length;
+    if (disk_size == 0) return -1;
+
+    /* A custom pass list stands in for the algorithm's passes; one
+     * that does not parse leaves them in place rather than fail */
+    vault_wipe_schedule_t sched;
+    int custom = params->schedule && params->schedule[0];
+    if (custom && vault_wipe_schedule_parse(&sched, params->schedule) < 0) {
+        fprintf(stderr, "wipe: %s: bad wipe schedule \"%s\", writing the "
+                "%s passes\n", device, params->schedule,
+                vault_wipe_algorithm_name(algorithm));
+        custom = 0;
+    }
+
+    /* An interrupted journalled wipe is finished the way it started,
+     * if it was writing the same passes. The journal lives at the end
+     * of the device, which a wipe of part of it never reaches. */
+    int journal = params->journal && base == 0 && length == 0;
+    vault_wipe_journal_t prev;
+    int resuming = journal &&
+                   journal_read(dev, disk_size, &prev) == 0;
+    if (resuming && prev.schedule != (custom ? sched.id : 0)) {
+        fprintf(stderr, "wipe: %s: interrupted wipe had another pass "
+                "schedule, starting over\n", device);
+        resuming = 0;
+    }
+    if (resuming) {
+        algorithm = prev.algorithm;
+        fprintf(stderr, "wipe: %s: resuming interrupted %s wipe at "
+                "pass %d\n", device, vault_wipe_algorithm_name(algorithm),
+                prev.pass);
+    }
+
+    if (algorithm == WIPE_HW_ERASE) {
+        if (vault_wipe_hw_erase(device, progress_cb) == 0) return 0;
+        fprintf(stderr, "wipe: %s: no hardware erase, falling back to "
+                "a random pass\n", device);
+        algorithm = WIPE_RANDOM;
+    }
+    if (!custom && vault_wipe_schedule_builtin(&sched, algorithm) != 0)
+        return -1;
+
     int ssd = vault_wipe_is_ssd(device);
     if (ssd == 1) {
         fprintf(stderr,
             "WARNING: %s is SSD. Software wiping cannot guarantee\n"
-            "complete erasure due to wear-levelling.\n", device);
+            "complete erasure due to wear-levelling; the hwerase\n"
+            "algorithm uses the drive's own erase instead.\n", device);
     }
 
 #if defined(VAULT_PLATFORM_MACOS)
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd), "diskutil unmountDisk %s 2>/dev/null", device);
-    system(cmd);
+    vault_platform_unmount_disk(device, 0);
 #endif
 
-    uint64_t disk_size = vault_wipe_get_device_size(dev);
-    if (disk_size == 0) return -1;
+    /* Whatever was readied ahead is used as far as it still fits */
+    wipe_prewarm_t *pw = prewarm_take(device, params);
+    int direct = params->direct_io;
+    disk_handle_t fd;
+    if (pw) {
+        direct = pw->direct;
+        fd = pw->fd;
+        pw->fd = INVALID_DISK_HANDLE;
+    } else {
+        fd = disk_open_write(dev, &direct);
+        if (fd == INVALID_DISK_HANDLE) return -1;
+    }
 
-    disk_handle_t fd = disk_open_write(dev);
-    if (fd == INVALID_DISK_HANDLE) return -1;
+    size_t block = pw ? pw->block : disk_block_size(fd);
+    if (base % block != 0) {
+        fprintf(stderr, "wipe: %s: range at %llu is not aligned to "
+                "%zu-byte blocks\n", device, (unsigned long long)base,
+                block);
+        disk_close(fd);
+        prewarm_free(pw);
+        return -1;
+    }
+
+    /* From here the calling thread is on the device's node too */
+    wipe_numa_t numa;
+    if (pw) numa = pw->numa;
+    else numa_probe(params->numa ? device : NULL, &numa);
+    numa_enter(&numa);
+
+    wipe_tuning_t tune;
+    if (pw && pw->tuned)
+        tune = pw->tune;
+    else
+        tune_device(device, fd, direct, block, base, disk_size, params,
+                    &tune);
+    if (resuming) {
+        /* Same layout, so the stripes' offsets still apply */
+        if (prev.chunk % block == 0 && prev.chunk <= VAULT_WIPE_CHUNK_MAX)
+            tune.chunk = (size_t)prev.chunk;
+        tune.stripes = prev.nstripes;
+    }
+    size_t chunk = tune.chunk;
+
+    int nstripes = tune.stripes;
+    int depth, nbufs;
+    stripe_layout(&tune, params, &depth, &nbufs);
+    int threaded = nbufs > 1;
 
-    uint8_t *wbuf = (uint8_t *)malloc(WIPE_BUF_SIZE);
-    uint8_t *vbuf = verify ? (uint8_t *)malloc(WIPE_BUF_SIZE) : NULL;
-    if (!wbuf || (verify && !vbuf)) {
-        free(wbuf); free(vbuf);
+    /* Prewarmed queues are taken over if built for this layout; a
+     * resumed or probed wipe may have chosen another */
+    write_queue_t own[VAULT_WIPE_STRIPES_MAX], *wq = own;
+    int nq;
+    if (pw && pw->nq > 0 && pw->tune.stripes == nstripes &&
+        pw->depth == depth && pw->nbufs == nbufs &&
+        pw->wq[0].buf_size == chunk && pw->tune.backend == tune.backend) {
+        wq = pw->wq;
+        nq = pw->nq;
+        pw->nq = 0;
+    } else {
+        if (pw) prewarm_drop_queues(pw);
+        nq = stripes_open(wq, nstripes, dev, fd, tune.backend, direct,
+                          block, depth, nbufs, chunk);
+    }
+    if (nq == 0) {
         disk_close(fd);
+        prewarm_free(pw);
+        numa_leave(&numa);
+        return -1;
+    }
+    nstripes = nq;
+    for (int i = 0; i < nstripes; i++) {
+        wq[i].numa = &numa;
+        for (int j = 0; j < wq[i].nbufs; j++)
+            numa_membind(&numa, wq[i].slots[j].buf, wq[i].buf_size);
+    }
+
+    /* One bad block map for every queue and verifier of the wipe */
+    bad_map_t bad;
+    bad_map_init(&bad, device);
+    for (int i = 0; params->skip_bad && i < nstripes; i++)
+        wq[i].bad = &bad;
+
+    /* A rate cap is one bucket for every queue and verifier */
+    vault_wipe_qos_t qos, *qp = NULL;
+    if (params->rate_mbps > 0) {
+        vault_wipe_qos_init(&qos, params->rate_mbps,
+                            params->rate_latency_ms, now_ns());
+        qp = &qos;
+    }
+
+    /* Pattern passes are offloaded where the drive can write them by
+     * itself, unless throttled. Only writing is: a verified pass still
+     * reads back. */
+    int offload = params->offload && !qp;
+    uint64_t zeroout = 0;
+    vault_wipe_same_t same;
+    int have_same = 0;
+    if (offload && pw && pw->offload) {
+        zeroout = pw->zeroout;
+        same = pw->same;
+        have_same = pw->have_same;
+        pw->have_same = 0;
+    } else if (offload) {
+        zeroout = zeroout_max_bytes(device);
+        have_same = vault_wipe_same_open(&same, dev) == 0;
+    }
+    if (have_same && same.block != block) {
+        vault_wipe_same_close(&same);
+        have_same = 0;
+    }
+    for (int i = 0; i < nstripes; i++) {
+        wq[i].zeroout = zeroout;
+        wq[i].same = have_same ? &same : NULL;
+        wq[i].dev = device;
+        wq[i].base = base;
+        wq[i].qos = qp;
+    }
+
+    fprintf(stderr, "wipe: %s: %zu KB chunks, %d stripe%s, queue depth %d, "
+            "%d buffers, %s I/O via %s (%s)\n", device, chunk / 1024,
+            nstripes, nstripes == 1 ? "" : "s", wq[0].depth, wq[0].nbufs,
+            direct ? "direct" : "synchronous", wq[0].be->name, tune.source);
+    if (qp && params->rate_latency_ms > 0)
+        fprintf(stderr, "wipe: %s: throttled to %g MB/s, backing off above "
+                "%g ms latency\n", device, params->rate_mbps,
+                params->rate_latency_ms);
+    else if (qp)
+        fprintf(stderr, "wipe: %s: throttled to %g MB/s\n", device,
+                params->rate_mbps);
+    int qdepth = wq[0].depth, qbufs = wq[0].nbufs;  /* for the report */
+    const char *backend = wq[0].be->name;
+    if (zeroout)
+        fprintf(stderr, "wipe: %s: zero passes offloaded to the device "
+                "(write zeroes, %llu KB per command)\n", device,
+                (unsigned long long)(zeroout / 1024));
+    if (have_same)
+        fprintf(stderr, "wipe: %s: pattern passes offloaded to the device "
+                "(write same, %u blocks per command)\n", device,
+                same.max_blocks);
+
+    /* Fused verification reads back behind the writers with its own
+     * buffers. It needs unbuffered writes: through the page cache the
+     * read-back would only ever see the cache. A separate pass needs a
+     * read-back buffer, plus a keystream reference if any pass is
+     * random; patterns are checked in place. Sampling reads back after
+     * the pass, so it never fuses, and neither do offloaded zero passes,
+     * which have no writes to fuse with. */
+    double sample_pct = params->verify_sample_pct;
+    if (sample_pct >= 100) sample_pct = 0;
+    int fused = verify && sample_pct <= 0 && params->verify_fused && direct;
+    int need_ref = 0;
+    for (int p = 0; p < sched.count; p++)
+        if (sched.passes[p].kind == VAULT_WIPE_PASS_RANDOM) need_ref = 1;
+    uint8_t *wbuf = NULL, *vbuf = NULL;
+    int readback = verify && (!fused || zeroout || have_same);
+    if (verify && !fused && need_ref)
+        wbuf = (uint8_t *)vault_aligned_alloc(WIPE_BUF_ALIGN, chunk);
+    if (readback)
+        vbuf = (uint8_t *)vault_aligned_alloc(WIPE_BUF_ALIGN, chunk);
+    if ((verify && !fused && need_ref && !wbuf) || (readback && !vbuf)) {
+        vault_aligned_free(wbuf); vault_aligned_free(vbuf);
+        stripes_close(wq, nstripes);
+        if (have_same) vault_wipe_same_close(&same);
+        if (qp) vault_wipe_qos_destroy(qp);
+        bad_map_destroy(&bad);
+        prewarm_free(pw);
+        numa_leave(&numa);
         return -1;
     }
 
+    /* Without a usable journal the wipe simply runs unjournalled */
+    journal_t jn, *jp = NULL;
+    if (journal && journal_open(&jn, dev, disk_size) == 0) {
+        jp = &jn;
+        if (resuming) {
+            jn.rec = prev;
+            jn.first_pass = prev.pass;
+            jn.resume = 1;
+        }
+        jn.rec.algorithm = algorithm;
+        jn.rec.schedule = custom ? sched.id : 0;
+    }
+    vault_secure_memzero(&prev, sizeof(prev));
+
+    wipe_job_t job = {
+        .wq = wq, .nstripes = nstripes, .threaded = threaded,
+        .rng = params->rng, .dev = dev, .base = base,
+        .disk_size = jp ? jn.offset : disk_size,
+        .verify = verify, .fused = fused, .sample_pct = sample_pct,
+        .wbuf = wbuf, .vbuf = vbuf, .chunk = chunk,
+        .bad = params->skip_bad ? &bad : NULL, .journal = jp,
+        .first_pass = jp ? 0 : params->start_pass,
+        .first_offset = jp || verify ? 0 : params->start_offset,
+        .name = device,
+        .preseed = pw ? &pw->preseed : NULL,
+        .progress_cb = progress_cb
+    };
+
+    /* Telemetry goes wherever report_path points, a file or a serial
+     * console; a report that cannot be opened does not stop the wipe */
+    int reporting = params->report_path && params->report_path[0];
+    vault_wipe_stats_t *total = NULL;
+    if (reporting || params->stats) {
+        total = (vault_wipe_stats_t *)calloc(1, sizeof(*total));
+        job.total = total;
+    }
+    if (reporting) {
+        job.report = total ? fopen(params->report_path, "a") : NULL;
+        if (job.report) {
+            setvbuf(job.report, NULL, _IOFBF, WIPE_REPORT_BUF);
+        } else {
+            fprintf(stderr, "wipe: %s: cannot open report %s\n", device,
+                    params->report_path);
+        }
+    }
+
+    /* Continued wipes already got past the metadata, and overwriting
+     * it again would leave random data in their finished ranges */
+    if (params->meta_first && !resuming && params->start_pass == 0)
+        meta_phase(device, dev, base, jp ? jn.offset : disk_size,
+                   params->rng);
+
     int ret = 0;
-    int total;
     char desc[128];
 
-    switch (algorithm) {
-    case WIPE_GUTMANN:
-        total = 35;
-        for (int p = 0; p < 35 && ret == 0; p++) {
-            const gutmann_pass_t *gp = &gutmann_passes[p];
-            if (gp->is_random)
-                snprintf(desc, sizeof(desc), "Pass %d/35: random", p + 1);
-            else if (gp->pattern_len == 1)
-                snprintf(desc, sizeof(desc), "Pass %d/35: 0x%02X", p + 1, gp->pattern[0]);
-            else
-                snprintf(desc, sizeof(desc), "Pass %d/35: 0x%02X%02X%02X",
-                         p + 1, gp->pattern[0], gp->pattern[1], gp->pattern[2]);
-
-            ret = do_direct_pass(fd, disk_size, wbuf, WIPE_BUF_SIZE,
-                                  gp->is_random, gp->pattern, gp->pattern_len,
-                                  p + 1, total, desc, progress_cb);
-            if (ret == 0 && verify && !gp->is_random)
-                ret = do_direct_verify(dev, disk_size, wbuf, vbuf,
-                                        WIPE_BUF_SIZE, gp->is_random,
-                                        gp->pattern, gp->pattern_len,
-                                        p + 1, total, progress_cb);
-        }
-        break;
-
-    case WIPE_DOD_522022:
-        total = 7;
-        for (int p = 0; p < 7 && ret == 0; p++) {
-            const dod_pass_t *dp = &dod_passes[p];
-            uint8_t pat[1] = { dp->byte };
-            snprintf(desc, sizeof(desc), "Pass %d/7: %s",
-                     p + 1, dp->is_random ? "random" : "pattern");
-            ret = do_direct_pass(fd, disk_size, wbuf, WIPE_BUF_SIZE,
-                                  dp->is_random, pat, 1,
-                                  p + 1, total, desc, progress_cb);
-            if (ret == 0 && verify && !dp->is_random)
-                ret = do_direct_verify(dev, disk_size, wbuf, vbuf,
-                                        WIPE_BUF_SIZE, dp->is_random,
-                                        pat, 1, p + 1, total, progress_cb);
-        }
-        break;
-
-    case WIPE_DOD_SHORT:
-        total = 3;
-        for (int p = 0; p < 3 && ret == 0; p++) {
-            snprintf(desc, sizeof(desc), "Pass %d/3: random", p + 1);
-            ret = do_direct_pass(fd, disk_size, wbuf, WIPE_BUF_SIZE,
-                                  1, NULL, 0, p + 1, total, desc, progress_cb);
-        }
-        break;
-
-    case WIPE_RANDOM:
-        total = 1;
-        ret = do_direct_pass(fd, disk_size, wbuf, WIPE_BUF_SIZE,
-                              1, NULL, 0, 1, 1, "Pass 1/1: random", progress_cb);
-        break;
-
-    case WIPE_ZERO: {
-        total = 1;
-        uint8_t zero = 0x00;
-        ret = do_direct_pass(fd, disk_size, wbuf, WIPE_BUF_SIZE,
-                              0, &zero, 1, 1, 1, "Pass 1/1: zero", progress_cb);
-        if (ret == 0 && verify)
-            ret = do_direct_verify(dev, disk_size, wbuf, vbuf,
-                                    WIPE_BUF_SIZE, 0, &zero, 1, 1, 1,
-                                    progress_cb);
-        break;
-    }
-
-    default:
+    for (int p = 0; p < sched.count && ret == 0; p++) {
+        vault_wipe_pass_describe(&sched.passes[p], p + 1, sched.count,
+                                 desc, sizeof(desc));
+        ret = run_pass(&job, &sched.passes[p], p + 1, sched.count, desc);
+    }
+
+    if (jp) journal_close(jp);
+    vault_aligned_free(wbuf);
+    vault_aligned_free(vbuf);
+    stripes_close(wq, nstripes);
+    if (have_same) vault_wipe_same_close(&same);
+    prewarm_free(pw);
+
+    double rate = qp ? vault_wipe_qos_mbps(qp) : 0;
+    if (qp && qos.cuts > 0)
+        fprintf(stderr, "wipe: %s: throttle backed off %llu time%s, "
+                "ending at %.1f MB/s\n", device,
+                (unsigned long long)qos.cuts, qos.cuts == 1 ? "" : "s",
+                rate);
+    if (qp) vault_wipe_qos_destroy(qp);
+
+    if (bad.count > 0)
+        fprintf(stderr, "wipe: %s: %d unwritable range%s, %llu KB "
+                "skipped\n", device, bad.count, bad.count == 1 ? "" : "s",
+                (unsigned long long)(bad.bytes / 1024));
+    if (params->error_map &&
+        bad_map_export(&bad, base, params->error_map) != 0)
         ret = -1;
+
+    char qdev[VAULT_CONFIG_MAX_PATH + 8];
+    vault_event("wipe", ",\"device\":%s,\"algorithm\":\"%s\",\"passes\":%d,"
+                "\"result\":%d,\"skipped_ranges\":%d,\"skipped_bytes\":%llu",
+                vault_events_quote(qdev, sizeof(qdev), device),
+                custom ? "custom" : vault_wipe_algorithm_name(algorithm),
+                sched.count, ret, bad.count, (unsigned long long)bad.bytes);
+
+    if (job.report) {
+        FILE *fp = job.report;
+        fprintf(fp, "{\"event\":\"wipe\",\"device\":");
+        vault_wipe_json_string(fp, device);
+        fprintf(fp, ",\"algorithm\":\"%s\",\"passes\":%d,\"result\":%d,"
+                "\"verify\":\"%s\",\"offset\":%llu,\"disk_size\":%llu,"
+                "\"chunk_kb\":%zu,"
+                "\"stripes\":%d,\"queue_depth\":%d,\"buffers\":%d,"
+                "\"io\":\"%s\",\"io_backend\":\"%s\",\"tuning\":\"%s\","
+                "\"skipped_ranges\":%d,"
+                "\"skipped_bytes\":%llu,\"rate_mbps\":%.1f,",
+                custom ? "custom" : vault_wipe_algorithm_name(algorithm),
+                sched.count, ret,
+                !verify ? "none" : sample_pct > 0 ? "sampled"
+                               : fused ? "fused" : "full",
+                (unsigned long long)base, (unsigned long long)disk_size,
+                chunk / 1024, nstripes,
+                qdepth, qbufs, direct ? "direct" : "synchronous", backend,
+                tune.source, bad.count, (unsigned long long)bad.bytes,
+                rate);
+        vault_wipe_stats_json(fp, total);
+        fprintf(fp, "}\n");
+        fclose(fp);
     }
+    if (params->stats && total) *params->stats = *total;
+    free(total);
+    bad_map_destroy(&bad);
+    numa_leave(&numa);
+    return ret;
+}
 
-    free(wbuf);
-    free(vbuf);
-    disk_close(fd);
+static int extent_cmp(const void *a, const void *b)
+{
+    const vault_wipe_extent_t *x = a, *y = b;
+    return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+/* Add the extents of src, which all lie past those of dst, to dst.
+ * Returns -1 if out of memory. */
+static int error_map_append(vault_wipe_error_map_t *dst,
+                            const vault_wipe_error_map_t *src)
+{
+    if (src->count == 0) return 0;
+    vault_wipe_extent_t *ext = (vault_wipe_extent_t *)
+        realloc(dst->extents,
+                (size_t)(dst->count + src->count) * sizeof(*ext));
+    if (!ext) return -1;
+    memcpy(ext + dst->count, src->extents,
+           (size_t)src->count * sizeof(*ext));
+    dst->extents = ext;
+    dst->count += src->count;
+    dst->bytes += src->bytes;
+    return 0;
+}
+
+/* Each extent is wiped in turn as a device of its own, every pass of
+ * it before the next. One that fails does not stop the rest; skipped
+ * ranges and totals are gathered over all of them. */
+static int wipe_extents(const char *device, wipe_algorithm_t algorithm,
+                        int verify, const vault_wipe_params_t *params,
+                        vault_wipe_progress_cb progress_cb)
+{
+    int n = params->extent_count;
+    if (n > VAULT_WIPE_MAX_EXTENTS) return -1;
+    vault_wipe_extent_t ext[VAULT_WIPE_MAX_EXTENTS];
+    memcpy(ext, params->extents, (size_t)n * sizeof(ext[0]));
+    qsort(ext, (size_t)n, sizeof(ext[0]), extent_cmp);
+    for (int i = 0; i < n; i++) {
+        if (ext[i].length == 0 ||
+            (i > 0 && ext[i].offset < ext[i - 1].offset + ext[i - 1].length)) {
+            fprintf(stderr, "wipe: %s: empty or overlapping extents\n",
+                    device);
+            return -1;
+        }
+    }
+
+    /* The drive's own erase would take all of it */
+    if (algorithm == WIPE_HW_ERASE) {
+        fprintf(stderr, "wipe: %s: hardware erase covers the whole drive, "
+                "using a random pass for its extents\n", device);
+        algorithm = WIPE_RANDOM;
+    }
+
+    vault_wipe_params_t p = *params;
+    vault_wipe_error_map_t map;
+    p.error_map = params->error_map ? &map : NULL;
+    p.stats = params->stats
+        ? (vault_wipe_stats_t *)calloc(1, sizeof(*p.stats)) : NULL;
+    if (params->error_map)
+        memset(params->error_map, 0, sizeof(*params->error_map));
+    if (params->stats)
+        memset(params->stats, 0, sizeof(*params->stats));
+
+    uint64_t total = 0;
+    for (int i = 0; i < n; i++) total += ext[i].length;
+    fprintf(stderr, "wipe: %s: %d extent%s, %llu MB\n", device, n,
+            n == 1 ? "" : "s", (unsigned long long)(total >> 20));
+
+    int ret = 0;
+    for (int i = 0; i < n; i++) {
+        if (wipe_range(device, algorithm, verify, &p, ext[i].offset,
+                       ext[i].length, progress_cb) != 0) {
+            fprintf(stderr, "wipe: %s: extent at %llu failed\n", device,
+                    (unsigned long long)ext[i].offset);
+            ret = -1;
+        }
+        if (p.stats)
+            vault_wipe_stats_merge(params->stats, p.stats);
+        if (p.error_map) {
+            if (error_map_append(params->error_map, &map) != 0) ret = -1;
+            vault_wipe_error_map_free(&map);
+        }
+    }
+    free(p.stats);
+    return ret;
+}
+
+int vault_wipe_device_direct_params(const char *device,
+                                     wipe_algorithm_t algorithm, int verify,
+                                     const vault_wipe_params_t *params,
+                                     vault_wipe_progress_cb progress_cb)
+{
+    vault_wipe_params_t defaults;
+    if (!params) {
+        vault_wipe_params_init(&defaults);
+        params = &defaults;
+    }
+    if (params->extents && params->extent_count > 0)
+        return wipe_extents(device, algorithm, verify, params, progress_cb);
+    return wipe_range(device, algorithm, verify, params, 0, params->length,
+                      progress_cb);
+}
+
+/* ------------------------------------------------------------------ */
+/*  vault_wipe_devices -- parallel multi-device wipe                   */
+/*                                                                     */
+/*  One worker per target. The single-device progress callback has no */
+/*  context argument, so each worker records itself in a thread-local  */
+/*  and a shared trampoline folds its reports into the aggregate.      */
+/* ------------------------------------------------------------------ */
+
+#if defined(_MSC_VER)
+  #define WIPE_THREAD_LOCAL __declspec(thread)
+#else
+  #define WIPE_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct multi_wipe multi_wipe_t;
+
+typedef struct {
+    multi_wipe_t        *multi;
+    int                  index;
+    vault_thread_t       thread;
+    int                  started;
+} multi_worker_t;
+
+struct multi_wipe {
+    vault_wipe_target_t        *targets;
+    int                         count;
+    const vault_wipe_params_t  *params;
+    vault_wipe_multi_progress_cb progress_cb;
+    vault_mutex_t               lock;
+    multi_worker_t              workers[VAULT_WIPE_MAX_TARGETS];
+};
+
+static WIPE_THREAD_LOCAL multi_worker_t *current_worker;
+
+/* Caller holds m->lock. */
+static void multi_report(multi_wipe_t *m, int changed)
+{
+    if (!m->progress_cb) return;
+
+    vault_wipe_multi_progress_t agg;
+    memset(&agg, 0, sizeof(agg));
+    agg.targets = m->targets;
+    agg.count = m->count;
+    agg.changed = changed;
+
+    for (int i = 0; i < m->count; i++) {
+        const vault_wipe_target_t *t = &m->targets[i];
+        if (!t->done) {
+            agg.active++;
+            agg.speed_mbps += t->progress.speed_mbps;
+        } else if (t->result != 0) {
+            agg.failed++;
+        }
+        agg.bytes_written += t->progress.bytes_written;
+        agg.bytes_total += t->progress.bytes_total;
+    }
+    m->progress_cb(&agg);
+}
+
+static void multi_progress(const vault_wipe_progress_t *prog)
+{
+    multi_worker_t *w = current_worker;
+    if (!w) return;
+    multi_wipe_t *m = w->multi;
+    vault_wipe_target_t *t = &m->targets[w->index];
+
+    vault_mutex_lock(&m->lock);
+    t->progress = *prog;
+    /* The engine's description buffer only lives for the pass */
+    if (prog->pass_description) {
+        strncpy(t->pass_description, prog->pass_description,
+                sizeof(t->pass_description) - 1);
+        t->pass_description[sizeof(t->pass_description) - 1] = '\0';
+    } else {
+        t->pass_description[0] = '\0';
+    }
+    t->progress.pass_description = t->pass_description;
+    multi_report(m, w->index);
+    vault_mutex_unlock(&m->lock);
+}
+
+static void *multi_worker(void *arg)
+{
+    multi_worker_t *w = (multi_worker_t *)arg;
+    multi_wipe_t *m = w->multi;
+    vault_wipe_target_t *t = &m->targets[w->index];
+
+    vault_wipe_params_t params;
+    if (t->params) params = *t->params;
+    else if (m->params) params = *m->params;
+    else vault_wipe_params_init(&params);
+    params.error_map = &t->errors;
+    if (t->extent_count > 0) {
+        params.extents = t->extents;
+        params.extent_count = t->extent_count;
+    }
+
+    current_worker = w;
+    int ret = vault_wipe_device(t->device, t->algorithm, t->verify,
+                                 &params, multi_progress);
+    current_worker = NULL;
+
+    vault_mutex_lock(&m->lock);
+    t->result = ret;
+    t->done = 1;
+    multi_report(m, w->index);
+    vault_mutex_unlock(&m->lock);
+    return NULL;
+}
+
+int vault_wipe_devices(vault_wipe_target_t *targets, int count,
+                        const vault_wipe_params_t *params,
+                        vault_wipe_multi_progress_cb progress_cb)
+{
+    if (!targets || count <= 0 || count > VAULT_WIPE_MAX_TARGETS) return -1;
+
+    multi_wipe_t m;
+    memset(&m, 0, sizeof(m));
+    m.targets = targets;
+    m.count = count;
+    m.params = params;
+    m.progress_cb = progress_cb;
+    vault_mutex_init(&m.lock);
+
+    for (int i = 0; i < count; i++) {
+        targets[i].result = -1;
+        targets[i].done = 0;
+        memset(&targets[i].progress, 0, sizeof(targets[i].progress));
+        memset(&targets[i].errors, 0, sizeof(targets[i].errors));
+        targets[i].pass_description[0] = '\0';
+    }
+
+    /* A single target, or a worker that cannot be started, runs on the
+     * calling thread; the rest keep going in parallel. */
+    for (int i = 0; i < count; i++) {
+        multi_worker_t *w = &m.workers[i];
+        w->multi = &m;
+        w->index = i;
+        if (count > 1)
+            w->started = vault_thread_create(&w->thread, multi_worker, w) == 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!m.workers[i].started)
+            multi_worker(&m.workers[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        if (m.workers[i].started)
+            vault_thread_join(m.workers[i].thread);
+    }
+
+    vault_mutex_destroy(&m.lock);
+
+    int ret = 0;
+    for (int i = 0; i < count; i++)
+        if (targets[i].result != 0) ret = -1;
     return ret;
 }
@@ -8,6 +8,7 @@
 #define VAULT_WIPE_H
 
 #include "config.h"
+#include "wipe_stats.h"
 #include <stdint.h>
 
 /* Progress callback data */
@@ -20,22 +21,230 @@ typedef struct {
     double   eta_secs;
     const char *pass_description;
     int      verifying;
+    uint64_t gen_stalls;        /* Times the fill thread waited on the disk */
+    uint64_t io_stalls;         /* Times the disk waited on the fill thread */
+    uint64_t bytes_verified;    /* Read back so far by fused verification */
+    double   combined_mbps;     /* Writes plus read-back, MB/s */
+    uint64_t bytes_skipped;     /* Unwritable, left out of the wipe */
 } vault_wipe_progress_t;
 
 typedef void (*vault_wipe_progress_cb)(const vault_wipe_progress_t *prog);
 
+/* A byte range of the device */
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+} vault_wipe_extent_t;
+
+/* Ranges a wipe could not write even one block at a time, sorted and
+ * merged. Release with vault_wipe_error_map_free(). */
+typedef struct {
+    vault_wipe_extent_t *extents;
+    int      count;
+    uint64_t bytes;             /* Sum of the extent lengths */
+} vault_wipe_error_map_t;
+
+/* Engine tuning. Initialise with vault_wipe_params_init() and override
+ * individual fields; a value of 0 selects the built-in default, or the
+ * value tuned for the device where noted. */
+typedef struct {
+    size_t chunk_size;          /* Bytes per write, 0 = tuned */
+    int queue_depth;            /* Writes kept in flight (1 = synchronous),
+                                 * 0 = tuned */
+    int ring_depth;             /* Pass buffers, 0 = queue_depth + 2,
+                                 * 1 = fill and write on one thread */
+    wipe_rng_t rng;             /* Random-pass generator, AUTO = fastest */
+    int direct_io;              /* Bypass the page cache (default 1) */
+    int probe;                  /* Time probe writes when tuning chunk_size */
+    int stripes;                /* Parallel streams per device, each on its
+                                 * own fd and thread, 0 = tuned */
+    int verify_fused;           /* Verify each pass while writing it
+                                 * (default 1) instead of re-reading after */
+    double verify_sample_pct;   /* Read back only this percent of each
+                                 * pass, at random, after writing it;
+                                 * 0 = all of it */
+    int journal;                /* Checkpoint progress at the end of the
+                                 * device and resume an interrupted wipe
+                                 * found there (see wipe_journal.h) */
+    int skip_bad;               /* Rewrite a failed write in ever smaller
+                                 * pieces, down to one block, and skip
+                                 * blocks that still fail (default 1) */
+    vault_wipe_error_map_t *error_map;  /* If set, receives the skipped
+                                 * ranges; overwritten, not freed */
+    int meta_first;             /* Overwrite partition tables, LUKS
+                                 * headers and superblocks (wipe_meta.h)
+                                 * before the first pass (default 1) */
+    int numa;                   /* Run the device's threads on the cores
+                                 * of its controller's NUMA node and
+                                 * keep its buffers in that node's
+                                 * memory; no-op on single-node machines
+                                 * (default 1) */
+    const char *schedule;       /* Custom pass list (wipe_schedule.h)
+                                 * written in place of the algorithm's
+                                 * passes, NULL = the algorithm's. Direct
+                                 * engine only; with WIPE_HW_ERASE it is
+                                 * the fallback if the erase fails */
+    int offload;                /* Let the drive write zero passes (WRITE
+                                 * ZEROES) and single-block patterns
+                                 * (WRITE SAME) itself (default 1) */
+    int start_pass;             /* Passes before this one (1-based) were
+                                 * written by another engine, 0 = none */
+    uint64_t start_offset;      /* Bytes of start_pass it wrote; ignored
+                                 * when verifying or journalled */
+    const char *report_path;    /* Append JSON telemetry here, one line
+                                 * per pass and a summary (see
+                                 * wipe_stats.h); a file or a serial
+                                 * console such as /dev/ttyS0, NULL = off */
+    vault_wipe_stats_t *stats;  /* If set, receives the totals over all
+                                 * passes; overwritten */
+    uint64_t length;            /* Wipe only the first length bytes, 0 =
+                                 * all; for benchmarks, and devices with
+                                 * no size such as /dev/null. Journalling
+                                 * is off when set */
+    const vault_wipe_extent_t *extents; /* Wipe only these byte ranges
+                                 * of the device, each in turn with all
+                                 * its passes, NULL = all of it. Starts
+                                 * must be block-aligned; length and
+                                 * journalling are ignored when set */
+    int extent_count;           /* at most VAULT_WIPE_MAX_EXTENTS */
+    double rate_mbps;           /* Cap the device's writes and reads
+                                 * together at this many MB/s, for wipes
+                                 * of drives left in service (wipe_qos.h);
+                                 * pattern passes are then not offloaded.
+                                 * 0 = full speed */
+    double rate_latency_ms;     /* Lower the cap while I/O takes longer
+                                 * than this to complete, raise it back
+                                 * once it is well under; 0 = fixed cap */
+    const char *io_backend;     /* Write path by name (wipe_backend.h),
+                                 * NULL or "auto" = io_uring or
+                                 * overlapped I/O where built and more
+                                 * than one write is in flight, else
+                                 * "sync" */
+} vault_wipe_params_t;
+
+#define VAULT_WIPE_CHUNK_DEFAULT        (4 * 1024 * 1024)
+#define VAULT_WIPE_CHUNK_MIN            (64 * 1024)
+#define VAULT_WIPE_CHUNK_MAX            (64 * 1024 * 1024)
+#define VAULT_WIPE_QUEUE_DEPTH_DEFAULT  8
+#define VAULT_WIPE_QUEUE_DEPTH_MAX      64
+#define VAULT_WIPE_RING_DEPTH_MAX       128
+#define VAULT_WIPE_STRIPES_MAX          8
+#define VAULT_WIPE_BAD_EXTENTS_MAX      1024
+#define VAULT_WIPE_BAD_BYTES_MAX        (64ULL * 1024 * 1024)
+#define VAULT_WIPE_MAX_EXTENTS          16
+
+/* Fill params with built-in defaults. */
+void vault_wipe_params_init(vault_wipe_params_t *params);
+
+/* Fill params from the wipe settings in a loaded config. */
+void vault_wipe_params_from_config(vault_wipe_params_t *params,
+                                    const vault_config_t *cfg);
+
+/* Release the extents of an error map and reset it to empty. */
+void vault_wipe_error_map_free(vault_wipe_error_map_t *map);
+
 /* Wipe using the best available method.
- * Linux: tries nwipe first, falls back to direct I/O.
+ * WIPE_HW_ERASE: the drive's own erase command (see wipe_hw.h); if the
+ * drive has none, or it fails, a software random pass instead.
+ * Linux: tries nwipe first, falls back to direct I/O, which takes
+ * over at the pass (and, unverified, the offset) nwipe got to. Sampled
+ * verification, journalled wipes and custom schedules go straight to
+ * direct I/O, as nwipe only verifies whole passes, cannot resume and
+ * writes only its own methods.
  * macOS/Windows: direct I/O only.
+ * Unwritable blocks are skipped as long as there are no more than
+ * VAULT_WIPE_BAD_EXTENTS_MAX ranges and VAULT_WIPE_BAD_BYTES_MAX bytes
+ * of them; the wipe still succeeds, and params->error_map says where.
+ * params tunes the direct engine and may be NULL for defaults; stats
+ * and length apply to it only. A wipe of extents always uses it, and
+ * WIPE_HW_ERASE becomes a random pass over them.
+ * progress_cb may be NULL.
  * Returns 0 on success, -1 on failure. */
 int vault_wipe_device(const char *device, wipe_algorithm_t algorithm,
-                       int verify);
+                       int verify, const vault_wipe_params_t *params,
+                       vault_wipe_progress_cb progress_cb);
 
 /* Wipe using direct I/O (no nwipe dependency).
  * Returns 0 on success, -1 on failure. */
 int vault_wipe_device_direct(const char *device, wipe_algorithm_t algorithm,
                               int verify, vault_wipe_progress_cb progress_cb);
 
+/* As vault_wipe_device_direct(), with explicit engine tuning.
+ * params may be NULL for defaults. */
+int vault_wipe_device_direct_params(const char *device,
+                                     wipe_algorithm_t algorithm, int verify,
+                                     const vault_wipe_params_t *params,
+                                     vault_wipe_progress_cb progress_cb);
+
+/* ------------------------------------------------------------------ */
+/*  Multi-device wipe                                                  */
+/* ------------------------------------------------------------------ */
+
+#define VAULT_WIPE_MAX_TARGETS 16
+
+typedef struct {
+    const char      *device;
+    wipe_algorithm_t algorithm;
+    int              verify;
+    const vault_wipe_extent_t *extents; /* NULL = the whole device, as
+                                         * for params->extents */
+    int              extent_count;
+    const vault_wipe_params_t *params;  /* This target's own tuning,
+                                         * NULL = the shared params */
+
+    /* Filled in by vault_wipe_devices() */
+    int              result;        /* 0 wiped, -1 failed */
+    int              done;          /* worker has finished */
+    vault_wipe_progress_t progress; /* latest report from this target */
+    char             pass_description[128];
+    vault_wipe_error_map_t errors;  /* skipped ranges, caller frees */
+} vault_wipe_target_t;
+
+/* Aggregate view passed to the multi-device callback. targets[] holds
+ * the latest per-target snapshot; only `changed` was updated since the
+ * previous call. */
+typedef struct {
+    const vault_wipe_target_t *targets;
+    int      count;
+    int      changed;               /* index of the target that reported */
+    int      active;                /* workers still running */
+    int      failed;                /* workers that finished with an error */
+    uint64_t bytes_written;         /* sum over targets, current passes */
+    uint64_t bytes_total;
+    double   speed_mbps;            /* sum over running targets */
+} vault_wipe_multi_progress_t;
+
+typedef void (*vault_wipe_multi_progress_cb)(const vault_wipe_multi_progress_t *prog);
+
+/* Wipe several devices at once, one worker thread per target, each via
+ * vault_wipe_device() with its own params or else the shared ones.
+ * Calls to progress_cb are serialised. Per-target outcomes are left in
+ * targets[i].result and targets[i].errors; error_map in either params
+ * is ignored.
+ * Returns 0 if every target was wiped, -1 otherwise. */
+int vault_wipe_devices(vault_wipe_target_t *targets, int count,
+                        const vault_wipe_params_t *params,
+                        vault_wipe_multi_progress_cb progress_cb);
+
+/* Ready targets for a vault_wipe_devices() call with the same params
+ * without writing to them: open each device, tune it, allocate its
+ * buffers and lock them in memory, look up its offload commands and
+ * draw the seed of its first random pass. The wipe then takes all of
+ * it over and starts writing at once. For idle time before a wipe
+ * that cannot be called off, such as the dead man's countdown; targets
+ * going to nwipe or the drive's own erase are left alone.
+ * Returns the number of targets readied. */
+int vault_wipe_prewarm(const vault_wipe_target_t *targets, int count,
+                       const vault_wipe_params_t *params);
+
+/* Close and free whatever vault_wipe_prewarm() readied and no wipe took
+ * over. */
+void vault_wipe_prewarm_release(void);
+
+/* 1 if device holds the journal of an interrupted wipe, which a
+ * journalled vault_wipe_device() call will resume. */
+int vault_wipe_journal_pending(const char *device);
+
 /* Check if nwipe is available. */
 int vault_wipe_nwipe_available(void);
 
@@ -45,4 +254,17 @@ int vault_wipe_is_ssd(const char *device);
 /* Get device size in bytes. Returns 0 on failure. */
 uint64_t vault_wipe_get_device_size(const char *device);
 
+/* What a device offers a wipe, for planning one (wipe_plan.h) */
+typedef struct {
+    uint64_t    size_bytes;
+    const char *kind;           /* "nvme", "ssd", "usb" or "hdd" */
+    double      write_mbps;     /* typical sustained writes of its kind */
+    int         flash;          /* 1 if not rotational */
+    int         zeroout;        /* zero passes can be offloaded */
+    int         write_same;     /* pattern passes can be offloaded */
+} vault_wipe_caps_t;
+
+/* Fill caps for device. Returns 0, or -1 if its size is unknown. */
+int vault_wipe_caps(const char *device, vault_wipe_caps_t *caps);
+
 #endif /* VAULT_WIPE_H */
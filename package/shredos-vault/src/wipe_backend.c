@@ -0,0 +1,367 @@
+/*
+ * wipe_backend.c -- Wipe I/O Backends
+ *
+ * Each backend keeps its own count of writes in flight, so closing a
+ * queue never frees or unmaps buffers the kernel may still be reading.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* fdatasync */
+#endif
+
+#include "wipe_backend.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(VAULT_PLATFORM_WINDOWS)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <unistd.h>
+  #include <fcntl.h>
+  #ifdef HAVE_LIBURING
+    #include <liburing.h>
+  #endif
+#endif
+
+/* Flush the device's write cache behind fd. */
+static int fd_sync(vault_wipe_fd_t fd)
+{
+#if defined(VAULT_PLATFORM_WINDOWS)
+    return FlushFileBuffers(fd) ? 0 : -1;
+#elif defined(VAULT_PLATFORM_MACOS)
+    if (fcntl(fd, F_FULLFSYNC) == 0) return 0;
+    return fsync(fd);
+#else
+    return fdatasync(fd);
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/*  sync                                                               */
+/*                                                                     */
+/*  The write happens inside submit; its result, with the platform     */
+/*  error, is held for the reap that follows.                          */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    vault_wipe_fd_t  fd;
+    vault_wipe_io_t *done;      /* written, not yet reaped */
+    long             res;
+#if defined(VAULT_PLATFORM_WINDOWS)
+    DWORD            err;
+#else
+    int              err;
+#endif
+} sync_queue_t;
+
+static void *sync_open(vault_wipe_fd_t fd, int direct, int *depth)
+{
+    (void)direct;
+    sync_queue_t *q = (sync_queue_t *)calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->fd = fd;
+    *depth = 1;
+    return q;
+}
+
+static unsigned sync_capabilities(void *q)
+{
+    (void)q;
+    return 0;
+}
+
+static int sync_submit(void *queue, vault_wipe_io_t *io)
+{
+    sync_queue_t *q = (sync_queue_t *)queue;
+    if (q->done) return -1;
+#if defined(VAULT_PLATFORM_WINDOWS)
+    OVERLAPPED ov;
+    DWORD n;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)io->offset;
+    ov.OffsetHigh = (DWORD)(io->offset >> 32);
+    q->res = WriteFile(q->fd, io->buf, (DWORD)io->len, &n, &ov) ? (long)n : -1;
+    q->err = q->res < 0 ? GetLastError() : 0;
+#else
+    ssize_t n;
+    do {
+        n = pwrite(q->fd, io->buf, io->len, (off_t)io->offset);
+    } while (n < 0 && errno == EINTR);
+    q->res = (long)n;
+    q->err = n < 0 ? errno : 0;
+#endif
+    q->done = io;
+    return 0;
+}
+
+static int sync_reap(void *queue, vault_wipe_io_t **io, long *res)
+{
+    sync_queue_t *q = (sync_queue_t *)queue;
+    if (!q->done) return -1;
+    *io = q->done;
+    *res = q->res;
+    q->done = NULL;
+#if defined(VAULT_PLATFORM_WINDOWS)
+    if (q->res < 0) SetLastError(q->err);
+#else
+    if (q->res < 0) errno = q->err;
+#endif
+    return 0;
+}
+
+static int sync_sync(void *queue)
+{
+    return fd_sync(((sync_queue_t *)queue)->fd);
+}
+
+static void sync_close(void *queue)
+{
+    free(queue);
+}
+
+static const vault_wipe_backend_t backend_sync = {
+    "sync", sync_open, sync_capabilities, sync_submit, sync_reap,
+    sync_sync, sync_close
+};
+
+/* ------------------------------------------------------------------ */
+/*  uring                                                              */
+/* ------------------------------------------------------------------ */
+
+#ifdef HAVE_LIBURING
+
+typedef struct {
+    struct io_uring ring;
+    vault_wipe_fd_t fd;
+    int             inflight;
+} uring_queue_t;
+
+static void *uring_open(vault_wipe_fd_t fd, int direct, int *depth)
+{
+    (void)direct;
+    uring_queue_t *q = (uring_queue_t *)calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    if (io_uring_queue_init((unsigned)*depth, &q->ring, 0) != 0) {
+        free(q);
+        return NULL;
+    }
+    q->fd = fd;
+    return q;
+}
+
+static unsigned uring_capabilities(void *q)
+{
+    (void)q;
+    return VAULT_WIPE_IO_ASYNC;
+}
+
+static int uring_submit(void *queue, vault_wipe_io_t *io)
+{
+    uring_queue_t *q = (uring_queue_t *)queue;
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&q->ring);
+    if (!sqe) return -1;
+    io_uring_prep_write(sqe, q->fd, io->buf, (unsigned)io->len, io->offset);
+    io_uring_sqe_set_data(sqe, io);
+    if (io_uring_submit(&q->ring) < 0) return -1;
+    q->inflight++;
+    return 0;
+}
+
+static int uring_reap(void *queue, vault_wipe_io_t **io, long *res)
+{
+    uring_queue_t *q = (uring_queue_t *)queue;
+    while (q->inflight > 0) {
+        struct io_uring_cqe *cqe;
+        int r = io_uring_wait_cqe(&q->ring, &cqe);
+        if (r == -EINTR) continue;
+        if (r < 0) return -1;
+
+        vault_wipe_io_t *done = (vault_wipe_io_t *)io_uring_cqe_get_data(cqe);
+        int n = cqe->res;
+        io_uring_cqe_seen(&q->ring, cqe);
+        q->inflight--;
+
+        /* Interrupted or refused for now: the same write again */
+        if ((n == -EINTR || n == -EAGAIN) && uring_submit(q, done) == 0)
+            continue;
+        if (n < 0) errno = -n;
+        *io = done;
+        *res = n < 0 ? -1 : n;
+        return 0;
+    }
+    return -1;
+}
+
+static int uring_sync(void *queue)
+{
+    return fd_sync(((uring_queue_t *)queue)->fd);
+}
+
+static void uring_close(void *queue)
+{
+    uring_queue_t *q = (uring_queue_t *)queue;
+    while (q->inflight > 0) {
+        struct io_uring_cqe *cqe;
+        if (io_uring_wait_cqe(&q->ring, &cqe) < 0) break;
+        io_uring_cqe_seen(&q->ring, cqe);
+        q->inflight--;
+    }
+    io_uring_queue_exit(&q->ring);
+    free(q);
+}
+
+static const vault_wipe_backend_t backend_uring = {
+    "uring", uring_open, uring_capabilities, uring_submit, uring_reap,
+    uring_sync, uring_close
+};
+
+#endif /* HAVE_LIBURING */
+
+/* ------------------------------------------------------------------ */
+/*  iocp                                                               */
+/*                                                                     */
+/*  A second handle, so synchronous writes (salvage, the tail) and     */
+/*  device I/O controls keep one of their own. Even a write that       */
+/*  completes at once queues its completion, so every write is reaped  */
+/*  through the port. The OVERLAPPED lives in the write's priv.        */
+/* ------------------------------------------------------------------ */
+
+#if defined(VAULT_PLATFORM_WINDOWS)
+
+typedef char iocp_overlapped_fits[
+    sizeof(OVERLAPPED) <= sizeof(((vault_wipe_io_t *)0)->priv) ? 1 : -1];
+
+typedef struct {
+    HANDLE fd;                  /* the caller's, for flushes */
+    HANDLE ovfd;                /* reopened for overlapped writes */
+    HANDLE port;
+    int    inflight;
+} iocp_queue_t;
+
+static void iocp_close(void *queue);
+
+static void *iocp_open(vault_wipe_fd_t fd, int direct, int *depth)
+{
+    iocp_queue_t *q = (iocp_queue_t *)calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->fd = fd;
+
+    DWORD flags = FILE_FLAG_OVERLAPPED | FILE_FLAG_WRITE_THROUGH;
+    if (direct) flags |= FILE_FLAG_NO_BUFFERING;
+    q->ovfd = ReOpenFile(fd, GENERIC_WRITE,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE, flags);
+    if (q->ovfd != INVALID_HANDLE_VALUE)
+        q->port = CreateIoCompletionPort(q->ovfd, NULL, 0, 1);
+    if (!q->port) {
+        iocp_close(q);
+        return NULL;
+    }
+    (void)depth;
+    return q;
+}
+
+static unsigned iocp_capabilities(void *q)
+{
+    (void)q;
+    return VAULT_WIPE_IO_ASYNC;
+}
+
+static int iocp_submit(void *queue, vault_wipe_io_t *io)
+{
+    iocp_queue_t *q = (iocp_queue_t *)queue;
+    OVERLAPPED *ov = (OVERLAPPED *)&io->priv;
+    memset(ov, 0, sizeof(*ov));
+    ov->Offset = (DWORD)io->offset;
+    ov->OffsetHigh = (DWORD)(io->offset >> 32);
+    if (!WriteFile(q->ovfd, io->buf, (DWORD)io->len, NULL, ov) &&
+        GetLastError() != ERROR_IO_PENDING)
+        return -1;
+    q->inflight++;
+    return 0;
+}
+
+static int iocp_reap(void *queue, vault_wipe_io_t **io, long *res)
+{
+    iocp_queue_t *q = (iocp_queue_t *)queue;
+    if (q->inflight == 0) return -1;
+
+    DWORD n = 0;
+    ULONG_PTR key;
+    OVERLAPPED *ov = NULL;
+    BOOL ok = GetQueuedCompletionStatus(q->port, &n, &key, &ov, INFINITE);
+    if (!ov) return -1;
+    q->inflight--;
+
+    *io = (vault_wipe_io_t *)((char *)ov - offsetof(vault_wipe_io_t, priv));
+    *res = ok ? (long)n : -1;
+    return 0;
+}
+
+static int iocp_sync(void *queue)
+{
+    return fd_sync(((iocp_queue_t *)queue)->fd);
+}
+
+static void iocp_close(void *queue)
+{
+    iocp_queue_t *q = (iocp_queue_t *)queue;
+    if (q->inflight > 0) CancelIoEx(q->ovfd, NULL);
+    while (q->port && q->inflight > 0) {
+        DWORD n;
+        ULONG_PTR key;
+        OVERLAPPED *ov = NULL;
+        GetQueuedCompletionStatus(q->port, &n, &key, &ov, INFINITE);
+        if (!ov) break;
+        q->inflight--;
+    }
+    if (q->port) CloseHandle(q->port);
+    if (q->ovfd && q->ovfd != INVALID_HANDLE_VALUE) CloseHandle(q->ovfd);
+    free(q);
+}
+
+static const vault_wipe_backend_t backend_iocp = {
+    "iocp", iocp_open, iocp_capabilities, iocp_submit, iocp_reap,
+    iocp_sync, iocp_close
+};
+
+#endif /* VAULT_PLATFORM_WINDOWS */
+
+/* ------------------------------------------------------------------ */
+/*  Lookup                                                             */
+/* ------------------------------------------------------------------ */
+
+static const vault_wipe_backend_t *const backends[] = {
+    &backend_sync,
+#ifdef HAVE_LIBURING
+    &backend_uring,
+#endif
+#if defined(VAULT_PLATFORM_WINDOWS)
+    &backend_iocp,
+#endif
+    NULL
+};
+
+const vault_wipe_backend_t *vault_wipe_backend_get(int i)
+{
+    int n = (int)(sizeof(backends) / sizeof(backends[0])) - 1;
+    return i >= 0 && i < n ? backends[i] : NULL;
+}
+
+const vault_wipe_backend_t *vault_wipe_backend_find(const char *name)
+{
+    for (int i = 0; name && backends[i]; i++)
+        if (strcmp(backends[i]->name, name) == 0) return backends[i];
+    return NULL;
+}
+
+const vault_wipe_backend_t *vault_wipe_backend_auto(int depth)
+{
+    /* The asynchronous backend, if any, follows sync */
+    if (depth > 1 && backends[1]) return backends[1];
+    return &backend_sync;
+}
@@ -0,0 +1,96 @@
+/*
+ * wipe_backend.h -- Wipe I/O Backends
+ *
+ * The wipe engine's write queues hand every write to a backend: a
+ * table of operations that set up a queue on an open device, submit
+ * writes at explicit offsets, reap their completions, flush the device
+ * and tear the queue down. The engine keeps the buffers, the bad-media
+ * salvage, throttling and telemetry; a backend only moves bytes.
+ *
+ * Built in:
+ *   "sync"   one write per submit on the engine's own handle, done
+ *            before submit returns (pwrite() or WriteFile()); any
+ *            platform, any target including regular files
+ *   "uring"  an io_uring submission queue (Linux, with liburing)
+ *   "iocp"   overlapped writes on a second handle, completed through an
+ *            I/O completion port (Windows)
+ *
+ * The backend is chosen per device: by name through
+ * vault_wipe_params_t.io_backend, otherwise the platform's
+ * asynchronous one wherever more than one write may be in flight.
+ * vault-wipe-bench runs each in turn with -b.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_BACKEND_H
+#define VAULT_WIPE_BACKEND_H
+
+#include "platform.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* A device opened by the engine */
+#if defined(VAULT_PLATFORM_WINDOWS)
+typedef void *vault_wipe_fd_t;          /* HANDLE */
+#else
+typedef int vault_wipe_fd_t;
+#endif
+
+/* Capabilities of an open queue */
+#define VAULT_WIPE_IO_ASYNC   0x1       /* submit returns at once; writes
+                                         * complete later, in any order */
+
+/* One write. The caller fills buf, len and offset and keeps the whole
+ * structure in place until the write is reaped; priv is the backend's
+ * meanwhile. */
+typedef struct {
+    const uint8_t *buf;
+    size_t   len;
+    uint64_t offset;            /* device offset in bytes */
+    union {
+        uint64_t u[6];
+        void    *p;
+    } priv;
+} vault_wipe_io_t;
+
+typedef struct {
+    const char *name;
+
+    /* Set up a queue for up to *depth writes on fd, which stays the
+     * caller's. direct says fd bypasses the page cache. *depth is
+     * lowered to what the backend will keep in flight. Returns the
+     * queue, or NULL if the backend cannot run here. */
+    void    *(*open)(vault_wipe_fd_t fd, int direct, int *depth);
+
+    /* VAULT_WIPE_IO_* flags of an open queue. */
+    unsigned (*capabilities)(void *q);
+
+    /* Start a write. Returns 0, or -1 if it could not be queued; a
+     * write that fails on the device is reported by reap instead. */
+    int      (*submit)(void *q, vault_wipe_io_t *io);
+
+    /* Wait for a submitted write. Sets *io to it and *res to the bytes
+     * written, which may be short, or -1 with the platform error
+     * (errno or GetLastError()) set. Returns 0, or -1 if nothing could
+     * be reaped. */
+    int      (*reap)(void *q, vault_wipe_io_t **io, long *res);
+
+    /* Make completed writes durable. Returns 0 or -1. */
+    int      (*sync)(void *q);
+
+    /* Wait out or cancel writes still in flight and free the queue. */
+    void     (*close)(void *q);
+} vault_wipe_backend_t;
+
+/* The backend called name in this build, or NULL. */
+const vault_wipe_backend_t *vault_wipe_backend_find(const char *name);
+
+/* The default for a queue of depth writes: "uring" or "iocp" where
+ * built and depth > 1, otherwise "sync". */
+const vault_wipe_backend_t *vault_wipe_backend_auto(int depth);
+
+/* The i-th backend in this build, from 0; NULL past the last. */
+const vault_wipe_backend_t *vault_wipe_backend_get(int i);
+
+#endif /* VAULT_WIPE_BACKEND_H */
@@ -0,0 +1,284 @@
+/*
+ * wipe_check.c -- Read-Back Comparison Kernels
+ *
+ * A repeating pattern is compared against the read buffer one "tile"
+ * at a time: the pattern unrolled to a whole number of vectors (at
+ * least 128 bytes, e.g. 192 for a 3-byte pattern), so every tile
+ * starts at pattern phase 0 and the vectors can be loaded once.
+ *   AVX2  -- 32-byte XOR/OR accumulate per tile
+ *   NEON  -- 16-byte, AArch64
+ *   C     -- 8-byte words
+ * A tile that differs is rescanned bytewise for the exact offset.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_check.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WIPE_CHECK_X86 1
+#include <immintrin.h>
+#define WIPE_CHECK_TARGET(t) __attribute__((target(t)))
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define WIPE_CHECK_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define TILE_MIN 128
+#define TILE_MAX VAULT_WIPE_CHECK_TILE_MAX
+
+/* ------------------------------------------------------------------ */
+/*  Tiles                                                              */
+/* ------------------------------------------------------------------ */
+
+static size_t gcd(size_t a, size_t b)
+{
+    while (b) { size_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+/* Unroll pat into tile as a whole number of `width`-byte vectors and
+ * pattern repeats, at least TILE_MIN bytes. Returns the tile length,
+ * or 0 if it would not fit in TILE_MAX. */
+static size_t build_tile(uint8_t *tile, const uint8_t *pat, size_t pat_len,
+                          size_t width)
+{
+    size_t period = pat_len / gcd(pat_len, width) * width;
+    if (period > TILE_MAX) return 0;
+    while (period < TILE_MIN && period * 2 <= TILE_MAX) period *= 2;
+    for (size_t i = 0; i < period; i++)
+        tile[i] = pat[i % pat_len];
+    return period;
+}
+
+/* Bytewise from offset `from`, which must be a multiple of pat_len. */
+static size_t check_bytes(const uint8_t *buf, size_t len,
+                           const uint8_t *pat, size_t pat_len, size_t from)
+{
+    size_t j = 0;
+    for (size_t i = from; i < len; i++) {
+        if (buf[i] != pat[j]) return i;
+        if (++j == pat_len) j = 0;
+    }
+    return len;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Kernels                                                            */
+/*                                                                     */
+/*  Each loop body is written once, inline, and instanced for the two  */
+/*  tile lengths every built-in pattern unrolls to -- 128 bytes for    */
+/*  1-, 2- and 4-byte patterns, 192 for the 3-byte ones -- so those    */
+/*  get a constant trip count the compiler unrolls into straight-line  */
+/*  vector code. Other lengths take the instance with a run-time       */
+/*  period.                                                            */
+/* ------------------------------------------------------------------ */
+
+#define CHECK_PERIOD_A 128
+#define CHECK_PERIOD_B 192
+
+static inline size_t check_words(const uint8_t *buf, size_t len,
+                                  const uint8_t *tile, size_t period)
+{
+    uint64_t w[TILE_MAX / 8];
+    size_t nw = period / 8;
+    memcpy(w, tile, period);
+
+    size_t i = 0;
+    for (; i + period <= len; i += period) {
+        uint64_t acc = 0;
+        for (size_t k = 0; k < nw; k++) {
+            uint64_t v;
+            memcpy(&v, buf + i + k * 8, 8);
+            acc |= v ^ w[k];
+        }
+        if (acc) break;
+    }
+    return i;
+}
+
+static size_t check_words_any(const uint8_t *buf, size_t len,
+                               const uint8_t *tile, size_t period)
+{
+    return check_words(buf, len, tile, period);
+}
+
+static size_t check_words_a(const uint8_t *buf, size_t len,
+                             const uint8_t *tile, size_t period)
+{
+    (void)period;
+    return check_words(buf, len, tile, CHECK_PERIOD_A);
+}
+
+static size_t check_words_b(const uint8_t *buf, size_t len,
+                             const uint8_t *tile, size_t period)
+{
+    (void)period;
+    return check_words(buf, len, tile, CHECK_PERIOD_B);
+}
+
+#ifdef WIPE_CHECK_X86
+
+WIPE_CHECK_TARGET("avx2")
+static inline size_t check_avx2(const uint8_t *buf, size_t len,
+                                 const uint8_t *tile, size_t period)
+{
+    __m256i v[TILE_MAX / 32];
+    size_t nv = period / 32;
+    for (size_t k = 0; k < nv; k++)
+        v[k] = _mm256_loadu_si256((const __m256i *)(tile + k * 32));
+
+    size_t i = 0;
+    for (; i + period <= len; i += period) {
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t k = 0; k < nv; k++) {
+            __m256i d = _mm256_loadu_si256((const __m256i *)(buf + i + k * 32));
+            acc = _mm256_or_si256(acc, _mm256_xor_si256(d, v[k]));
+        }
+        if (!_mm256_testz_si256(acc, acc)) break;
+    }
+    return i;
+}
+
+WIPE_CHECK_TARGET("avx2")
+static size_t check_avx2_any(const uint8_t *buf, size_t len,
+                              const uint8_t *tile, size_t period)
+{
+    return check_avx2(buf, len, tile, period);
+}
+
+WIPE_CHECK_TARGET("avx2")
+static size_t check_avx2_a(const uint8_t *buf, size_t len,
+                            const uint8_t *tile, size_t period)
+{
+    (void)period;
+    return check_avx2(buf, len, tile, CHECK_PERIOD_A);
+}
+
+WIPE_CHECK_TARGET("avx2")
+static size_t check_avx2_b(const uint8_t *buf, size_t len,
+                            const uint8_t *tile, size_t period)
+{
+    (void)period;
+    return check_avx2(buf, len, tile, CHECK_PERIOD_B);
+}
+
+#endif /* WIPE_CHECK_X86 */
+
+#ifdef WIPE_CHECK_NEON
+
+static inline size_t check_neon(const uint8_t *buf, size_t len,
+                                 const uint8_t *tile, size_t period)
+{
+    uint8x16_t v[TILE_MAX / 16];
+    size_t nv = period / 16;
+    for (size_t k = 0; k < nv; k++)
+        v[k] = vld1q_u8(tile + k * 16);
+
+    size_t i = 0;
+    for (; i + period <= len; i += period) {
+        uint8x16_t acc = vdupq_n_u8(0);
+        for (size_t k = 0; k < nv; k++)
+            acc = vorrq_u8(acc, veorq_u8(vld1q_u8(buf + i + k * 16), v[k]));
+        if (vmaxvq_u8(acc)) break;
+    }
+    return i;
+}
+
+static size_t check_neon_any(const uint8_t *buf, size_t len,
+                              const uint8_t *tile, size_t period)
+{
+    return check_neon(buf, len, tile, period);
+}
+
+static size_t check_neon_a(const uint8_t *buf, size_t len,
+                            const uint8_t *tile, size_t period)
+{
+    (void)period;
+    return check_neon(buf, len, tile, CHECK_PERIOD_A);
+}
+
+static size_t check_neon_b(const uint8_t *buf, size_t len,
+                            const uint8_t *tile, size_t period)
+{
+    (void)period;
+    return check_neon(buf, len, tile, CHECK_PERIOD_B);
+}
+
+#endif /* WIPE_CHECK_NEON */
+
+typedef size_t (*check_fn)(const uint8_t *buf, size_t len,
+                           const uint8_t *tile, size_t period);
+
+/* The instance of one ISA's kernels for period */
+static check_fn pick(size_t period, check_fn any, check_fn a, check_fn b)
+{
+    if (period == CHECK_PERIOD_A) return a;
+    if (period == CHECK_PERIOD_B) return b;
+    return any;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Entry points                                                       */
+/* ------------------------------------------------------------------ */
+
+void vault_wipe_checker_init(vault_wipe_checker_t *c, const uint8_t *pat,
+                              size_t pat_len)
+{
+    memset(c, 0, sizeof(*c));
+    if (pat_len > TILE_MAX) pat_len = TILE_MAX;
+    memcpy(c->pat, pat, pat_len);
+    c->pat_len = pat_len;
+    if (pat_len == 0) return;
+
+#if defined(WIPE_CHECK_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") &&
+        (c->period = build_tile(c->tile, pat, pat_len, 32)) != 0) {
+        c->scan = pick(c->period, check_avx2_any, check_avx2_a,
+                       check_avx2_b);
+        return;
+    }
+#elif defined(WIPE_CHECK_NEON)
+    if ((c->period = build_tile(c->tile, pat, pat_len, 16)) != 0) {
+        c->scan = pick(c->period, check_neon_any, check_neon_a,
+                       check_neon_b);
+        return;
+    }
+#endif
+    if ((c->period = build_tile(c->tile, pat, pat_len, 8)) != 0)
+        c->scan = pick(c->period, check_words_any, check_words_a,
+                       check_words_b);
+}
+
+size_t vault_wipe_checker_find(const vault_wipe_checker_t *c,
+                                const uint8_t *buf, size_t len)
+{
+    if (c->pat_len == 0) return 0;
+    size_t i = c->scan ? c->scan(buf, len, c->tile, c->period) : 0;
+
+    /* The rest of the buffer, or the tile that differed */
+    return check_bytes(buf, len, c->pat, c->pat_len, i);
+}
+
+size_t vault_wipe_check_pattern(const uint8_t *buf, size_t len,
+                                 const uint8_t *pat, size_t pat_len)
+{
+    if (pat_len > TILE_MAX) return check_bytes(buf, len, pat, pat_len, 0);
+    vault_wipe_checker_t c;
+    vault_wipe_checker_init(&c, pat, pat_len);
+    return vault_wipe_checker_find(&c, buf, len);
+}
+
+size_t vault_wipe_check_equal(const uint8_t *a, const uint8_t *b,
+                               size_t len)
+{
+    if (memcmp(a, b, len) == 0) return len;
+    size_t i = 0;
+    while (i < len && a[i] == b[i]) i++;
+    return i;
+}
@@ -0,0 +1,49 @@
+/*
+ * wipe_check.h -- Read-Back Comparison Kernels
+ *
+ * Checks verification reads without building a reference buffer for
+ * pattern passes, and reports where the first difference is. A pass
+ * binds a checker to its pattern once; the CPU features, the unrolled
+ * tile and the loop for its length are settled then, not per chunk.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_CHECK_H
+#define VAULT_WIPE_CHECK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VAULT_WIPE_CHECK_TILE_MAX  256
+
+/* A pattern bound to its comparison loop */
+typedef struct {
+    size_t (*scan)(const uint8_t *buf, size_t len, const uint8_t *tile,
+                   size_t period);          /* NULL = bytewise only */
+    uint8_t tile[VAULT_WIPE_CHECK_TILE_MAX]; /* pattern unrolled */
+    size_t  period;
+    uint8_t pat[VAULT_WIPE_CHECK_TILE_MAX];  /* one period, as given */
+    size_t  pat_len;
+} vault_wipe_checker_t;
+
+/* Bind c to pat, pat_len bytes long (1 to VAULT_WIPE_CHECK_TILE_MAX). */
+void vault_wipe_checker_init(vault_wipe_checker_t *c, const uint8_t *pat,
+                              size_t pat_len);
+
+/* Offset of the first byte of buf that differs from c's pattern
+ * repeated from buf[0], or len if all of buf matches. */
+size_t vault_wipe_checker_find(const vault_wipe_checker_t *c,
+                                const uint8_t *buf, size_t len);
+
+/* vault_wipe_checker_find() with a checker bound for this call only.
+ * Any pat_len >= 1 works; short patterns (the 1- and 3-byte wipe
+ * patterns) take the SIMD path. */
+size_t vault_wipe_check_pattern(const uint8_t *buf, size_t len,
+                                 const uint8_t *pat, size_t pat_len);
+
+/* Offset of the first byte where a and b differ, or len. */
+size_t vault_wipe_check_equal(const uint8_t *a, const uint8_t *b,
+                               size_t len);
+
+#endif /* VAULT_WIPE_CHECK_H */
@@ -0,0 +1,677 @@
+/*
+ * wipe_hw.c -- Drive-Native Secure Erase
+ *
+ * Methods, strongest first:
+ *   NVMe:  Sanitize (crypto erase, else block erase), polled through
+ *          the Sanitize Status log; else Format NVM with Secure Erase
+ *   SATA:  SECURITY ERASE UNIT (enhanced when supported) over SG_IO
+ *          ATA PASS-THROUGH(16)
+ *   Any:   BLKSECDISCARD; else BLKDISCARD, accepted only when a
+ *          read-back sample shows the discarded range returns zeroes
+ *
+ * Also WRITE SAME(16) for the engine's single-block pattern passes.
+ *
+ * Linux only. Other platforms report no support and the engine falls
+ * back to software passes.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* O_DIRECT */
+#endif
+
+#include "wipe_hw.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(VAULT_PLATFORM_LINUX)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include <linux/nvme_ioctl.h>
+#include <scsi/sg.h>
+
+/* ------------------------------------------------------------------ */
+/*  Helpers                                                            */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char *device;
+    uint64_t    size;
+    vault_wipe_progress_cb cb;
+    double      start;
+    const char *desc;           /* method in use, for progress reports */
+} hw_erase_t;
+
+static double hw_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void hw_sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+static uint16_t le16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Report progress as a fraction of the drive; eta < 0 if unknown. */
+static void hw_report(const hw_erase_t *h, double frac, double eta)
+{
+    if (!h->cb) return;
+    if (frac < 0) frac = 0;
+    if (frac > 1) frac = 1;
+
+    double elapsed = hw_now() - h->start;
+    uint64_t done = (uint64_t)(frac * (double)h->size);
+    vault_wipe_progress_t prog = {
+        .current_pass = 1,
+        .total_passes = 1,
+        .bytes_written = done,
+        .bytes_total = h->size,
+        .speed_mbps = (elapsed > 0)
+            ? ((double)done / elapsed) / (1024.0 * 1024.0) : 0,
+        .eta_secs = eta > 0 ? eta : 0,
+        .pass_description = h->desc,
+        .verifying = 0
+    };
+    h->cb(&prog);
+}
+
+/* 1 if device is a partition rather than a whole disk. */
+static int hw_is_partition(const char *device)
+{
+    char real[PATH_MAX], path[PATH_MAX + 64];
+    if (!realpath(device, real)) return 0;
+    const char *name = strrchr(real, '/');
+    name = name ? name + 1 : real;
+    snprintf(path, sizeof(path), "/sys/class/block/%s/partition", name);
+    return access(path, F_OK) == 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  NVMe                                                               */
+/* ------------------------------------------------------------------ */
+
+#define NVME_ADMIN_GET_LOG_PAGE  0x02
+#define NVME_ADMIN_IDENTIFY      0x06
+#define NVME_ADMIN_FORMAT_NVM    0x80
+#define NVME_ADMIN_SANITIZE      0x84
+
+#define NVME_LOG_SANITIZE        0x81
+
+#define NVME_SANACT_EXIT_FAILURE 1
+#define NVME_SANACT_BLOCK        2
+#define NVME_SANACT_CRYPTO       4
+
+#define NVME_SSTAT_NEVER         0
+#define NVME_SSTAT_DONE          1
+#define NVME_SSTAT_IN_PROGRESS   2
+#define NVME_SSTAT_FAILED        3
+#define NVME_SSTAT_DONE_NO_DEALLOC 4
+
+static int nvme_admin(int fd, uint8_t opcode, uint32_t nsid, uint32_t cdw10,
+                       void *data, uint32_t len, uint32_t timeout_ms)
+{
+    struct nvme_admin_cmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = opcode;
+    cmd.nsid = nsid;
+    cmd.cdw10 = cdw10;
+    cmd.addr = (uint64_t)(uintptr_t)data;
+    cmd.data_len = len;
+    cmd.timeout_ms = timeout_ms;
+    /* Positive returns are NVMe status codes */
+    return ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd) == 0 ? 0 : -1;
+}
+
+/* Sanitize Status log: returns SSTAT bits 2:0 and the progress
+ * numerator (of 65536), or -1. */
+static int nvme_sanitize_status(int fd, uint16_t *sprog)
+{
+    uint8_t log[512];
+    uint32_t numd = sizeof(log) / 4 - 1;
+    if (nvme_admin(fd, NVME_ADMIN_GET_LOG_PAGE, 0xFFFFFFFFu,
+                   NVME_LOG_SANITIZE | (numd << 16),
+                   log, sizeof(log), 0) != 0)
+        return -1;
+    *sprog = le16(log);
+    return le16(log + 2) & 0x7;
+}
+
+static int nvme_sanitize(hw_erase_t *h, int fd, const uint8_t *idctrl)
+{
+    uint32_t sanicap = le32(idctrl + 328);
+    uint32_t sanact;
+    if (sanicap & 0x1) {
+        sanact = NVME_SANACT_CRYPTO;
+        h->desc = "Hardware erase: NVMe sanitize (crypto)";
+    } else if (sanicap & 0x2) {
+        sanact = NVME_SANACT_BLOCK;
+        h->desc = "Hardware erase: NVMe sanitize (block)";
+    } else {
+        return -1;
+    }
+
+    /* An erase already running (e.g. from an interrupted attempt) is
+     * simply waited for. */
+    uint16_t sprog;
+    if (nvme_sanitize_status(fd, &sprog) != NVME_SSTAT_IN_PROGRESS) {
+        fprintf(stderr, "wipe: %s: %s\n", h->device, h->desc);
+        if (nvme_admin(fd, NVME_ADMIN_SANITIZE, 0, sanact, NULL, 0, 0) != 0)
+            return -1;
+    }
+    hw_report(h, 0, -1);
+
+    int errors = 0, idle = 0;
+    for (;;) {
+        hw_sleep_ms(1000);
+        int st = nvme_sanitize_status(fd, &sprog);
+        if (st < 0) {
+            if (++errors >= 10) return -1;
+            continue;
+        }
+        errors = 0;
+
+        switch (st) {
+        case NVME_SSTAT_IN_PROGRESS: {
+            double frac = (double)sprog / 65536.0;
+            double elapsed = hw_now() - h->start;
+            double eta = frac > 0 ? elapsed * (1 - frac) / frac : -1;
+            hw_report(h, frac, eta);
+            break;
+        }
+        case NVME_SSTAT_DONE:
+        case NVME_SSTAT_DONE_NO_DEALLOC:
+            hw_report(h, 1, 0);
+            return 0;
+        case NVME_SSTAT_FAILED:
+            /* Leave failure mode so software passes can still write */
+            nvme_admin(fd, NVME_ADMIN_SANITIZE, 0,
+                       NVME_SANACT_EXIT_FAILURE, NULL, 0, 0);
+            return -1;
+        default:
+            /* Not started yet; give the controller a few seconds */
+            if (++idle >= 10) return -1;
+            break;
+        }
+    }
+}
+
+static int nvme_format(hw_erase_t *h, int fd, const uint8_t *idctrl)
+{
+    uint16_t oacs = le16(idctrl + 256);
+    if (!(oacs & 0x2)) return -1;           /* Format NVM unsupported */
+
+    int nsid = ioctl(fd, NVME_IOCTL_ID);
+    if (nsid <= 0) return -1;
+
+    uint8_t *idns = (uint8_t *)vault_aligned_alloc(4096, 4096);
+    if (!idns) return -1;
+    int ok = nvme_admin(fd, NVME_ADMIN_IDENTIFY, (uint32_t)nsid, 0,
+                        idns, 4096, 0) == 0;
+    uint8_t flbas = idns[26], dps = idns[29];
+    vault_aligned_free(idns);
+    if (!ok) return -1;
+
+    /* Keep the current LBA format and protection settings */
+    uint32_t lbaf = (flbas & 0xF) | (((uint32_t)flbas >> 5 & 0x3) << 4);
+    uint32_t ses = (idctrl[524] & 0x4) ? 2 : 1;     /* crypto, else user data */
+    uint32_t cdw10 = (lbaf & 0xF) |
+                     (((uint32_t)flbas >> 4 & 0x1) << 4) |   /* MSET */
+                     ((uint32_t)(dps & 0x7) << 5) |           /* PI */
+                     (((uint32_t)dps >> 3 & 0x1) << 8) |     /* PIL */
+                     (ses << 9) |
+                     ((lbaf >> 4) << 12);
+
+    h->desc = ses == 2 ? "Hardware erase: NVMe format (crypto)"
+                       : "Hardware erase: NVMe format (user data)";
+    fprintf(stderr, "wipe: %s: %s\n", h->device, h->desc);
+    hw_report(h, 0, -1);
+
+    if (nvme_admin(fd, NVME_ADMIN_FORMAT_NVM, (uint32_t)nsid, cdw10,
+                   NULL, 0, 60 * 60 * 1000) != 0)
+        return -1;
+    hw_report(h, 1, 0);
+    return 0;
+}
+
+static int hw_nvme(hw_erase_t *h, int fd)
+{
+    uint8_t *idctrl = (uint8_t *)vault_aligned_alloc(4096, 4096);
+    if (!idctrl) return -1;
+
+    int ret = -1;
+    if (nvme_admin(fd, NVME_ADMIN_IDENTIFY, 0, 1, idctrl, 4096, 0) == 0) {
+        ret = nvme_sanitize(h, fd, idctrl);
+        if (ret != 0)
+            ret = nvme_format(h, fd, idctrl);
+    }
+    vault_aligned_free(idctrl);
+    return ret;
+}
+
+/* ------------------------------------------------------------------ */
+/*  ATA                                                                */
+/* ------------------------------------------------------------------ */
+
+#define ATA_PASS_THROUGH_16      0x85
+
+#define ATA_IDENTIFY_DEVICE      0xEC
+#define ATA_SEC_SET_PASSWORD     0xF1
+#define ATA_SEC_UNLOCK           0xF2
+#define ATA_SEC_ERASE_PREPARE    0xF3
+#define ATA_SEC_ERASE_UNIT       0xF4
+#define ATA_SEC_DISABLE_PASSWORD 0xF6
+
+#define ATA_SEC_SUPPORTED        0x0001     /* IDENTIFY word 128 */
+#define ATA_SEC_ENABLED          0x0002
+#define ATA_SEC_LOCKED           0x0004
+#define ATA_SEC_FROZEN           0x0008
+#define ATA_SEC_ENHANCED         0x0020
+
+/* Temporary user password; the erase clears it again. A known value
+ * lets a failed erase be undone so software passes can still write. */
+#define ATA_ERASE_PASSWORD       "shredos-vault"
+
+enum { ATA_DATA_NONE, ATA_DATA_IN, ATA_DATA_OUT };
+
+/* Issue an ATA command with at most one 512-byte data sector. */
+static int ata_cmd(int fd, uint8_t command, int dir, void *data,
+                    unsigned int timeout_ms)
+{
+    uint8_t cdb[16] = { 0 };
+    uint8_t sense[32];
+    sg_io_hdr_t io;
+
+    cdb[0] = ATA_PASS_THROUGH_16;
+    switch (dir) {
+    case ATA_DATA_IN:
+        cdb[1] = 4 << 1;        /* PIO data-in */
+        cdb[2] = 0x0E;          /* T_DIR in, blocks, length in count */
+        cdb[6] = 1;
+        break;
+    case ATA_DATA_OUT:
+        cdb[1] = 5 << 1;        /* PIO data-out */
+        cdb[2] = 0x06;
+        cdb[6] = 1;
+        break;
+    default:
+        cdb[1] = 3 << 1;        /* non-data */
+        break;
+    }
+    cdb[14] = command;
+
+    memset(&io, 0, sizeof(io));
+    io.interface_id = 'S';
+    io.cmdp = cdb;
+    io.cmd_len = sizeof(cdb);
+    io.sbp = sense;
+    io.mx_sb_len = sizeof(sense);
+    io.timeout = timeout_ms;
+    io.dxfer_direction = dir == ATA_DATA_IN  ? SG_DXFER_FROM_DEV :
+                         dir == ATA_DATA_OUT ? SG_DXFER_TO_DEV : SG_DXFER_NONE;
+    if (dir != ATA_DATA_NONE) {
+        io.dxferp = data;
+        io.dxfer_len = 512;
+    }
+
+    if (ioctl(fd, SG_IO, &io) < 0) return -1;
+    return (io.status == 0 && io.host_status == 0) ? 0 : -1;
+}
+
+/* Security command payload: control word then the 32-byte password. */
+static void ata_password_block(uint8_t *buf, uint16_t control)
+{
+    memset(buf, 0, 512);
+    buf[0] = (uint8_t)(control & 0xFF);
+    buf[1] = (uint8_t)(control >> 8);
+    memcpy(buf + 2, ATA_ERASE_PASSWORD, strlen(ATA_ERASE_PASSWORD));
+}
+
+static int hw_ata(hw_erase_t *h, int fd)
+{
+    uint8_t id[512], pw[512];
+    if (ata_cmd(fd, ATA_IDENTIFY_DEVICE, ATA_DATA_IN, id, 10000) != 0)
+        return -1;
+
+    uint16_t sec = le16(id + 128 * 2);
+    if (!(sec & ATA_SEC_SUPPORTED)) return -1;
+    if (sec & ATA_SEC_FROZEN) {
+        fprintf(stderr, "wipe: %s: ATA security is frozen, "
+                "cannot secure erase\n", h->device);
+        return -1;
+    }
+    if (sec & (ATA_SEC_ENABLED | ATA_SEC_LOCKED)) return -1;
+
+    /* Erase time estimate in 2-minute units, 0 = not reported */
+    int enhanced = (sec & ATA_SEC_ENHANCED) != 0;
+    uint16_t w = le16(id + (enhanced ? 90 : 89) * 2);
+    unsigned int minutes = (w & 0x8000) ? (w & 0x7FFFu) * 2 : (w & 0xFFu) * 2;
+    unsigned long long tmo = minutes ? (minutes * 2ULL + 10) * 60000ULL
+                                     : 24ULL * 3600 * 1000;
+    if (tmo > UINT_MAX) tmo = UINT_MAX;
+
+    h->desc = enhanced ? "Hardware erase: ATA enhanced secure erase"
+                       : "Hardware erase: ATA secure erase";
+    fprintf(stderr, "wipe: %s: %s\n", h->device, h->desc);
+
+    ata_password_block(pw, 0x0000);         /* user password, high */
+    if (ata_cmd(fd, ATA_SEC_SET_PASSWORD, ATA_DATA_OUT, pw, 10000) != 0)
+        return -1;
+
+    hw_report(h, 0, minutes ? minutes * 60.0 : -1);
+
+    int ret = -1;
+    ata_password_block(pw, enhanced ? 0x0002 : 0x0000);
+    if (ata_cmd(fd, ATA_SEC_ERASE_PREPARE, ATA_DATA_NONE, NULL, 10000) == 0 &&
+        ata_cmd(fd, ATA_SEC_ERASE_UNIT, ATA_DATA_OUT, pw,
+                (unsigned int)tmo) == 0)
+        ret = 0;
+
+    if (ret != 0) {
+        /* Drop the temporary password; best effort */
+        ata_password_block(pw, 0x0000);
+        ata_cmd(fd, ATA_SEC_UNLOCK, ATA_DATA_OUT, pw, 10000);
+        ata_cmd(fd, ATA_SEC_DISABLE_PASSWORD, ATA_DATA_OUT, pw, 10000);
+        return -1;
+    }
+    hw_report(h, 1, 0);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Block-layer discard                                                */
+/* ------------------------------------------------------------------ */
+
+#define HW_DISCARD_SAMPLES 64
+
+/* 1 if evenly spread 4 KB samples of the device all read as zero. */
+static int hw_reads_zero(const char *device, uint64_t size)
+{
+    int fd = open(device, O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    uint8_t *buf = (uint8_t *)vault_aligned_alloc(4096, 4096);
+    int zero = buf != NULL;
+    uint64_t blocks = size / 4096;
+    for (int i = 0; zero && blocks > 0 && i < HW_DISCARD_SAMPLES; i++) {
+        uint64_t off = (blocks - 1) * (uint64_t)i / (HW_DISCARD_SAMPLES - 1);
+        if (pread(fd, buf, 4096, (off_t)(off * 4096)) != 4096) {
+            zero = 0;
+            break;
+        }
+        for (int j = 0; j < 4096; j++)
+            if (buf[j]) { zero = 0; break; }
+    }
+    vault_aligned_free(buf);
+    close(fd);
+    return zero;
+}
+
+static int hw_discard(hw_erase_t *h, int fd)
+{
+    uint64_t range[2] = { 0, h->size };
+
+    h->desc = "Hardware erase: secure discard";
+    hw_report(h, 0, -1);
+    if (ioctl(fd, BLKSECDISCARD, range) == 0) {
+        fprintf(stderr, "wipe: %s: %s\n", h->device, h->desc);
+        hw_report(h, 1, 0);
+        return 0;
+    }
+
+    /* Plain discard only unmaps blocks; trust it only if the drive
+     * reads them back as zeroes. */
+    h->desc = "Hardware erase: discard";
+    if (ioctl(fd, BLKDISCARD, range) != 0) return -1;
+    if (!hw_reads_zero(h->device, h->size)) {
+        fprintf(stderr, "wipe: %s: discarded blocks still readable\n",
+                h->device);
+        return -1;
+    }
+    fprintf(stderr, "wipe: %s: %s\n", h->device, h->desc);
+    hw_report(h, 1, 0);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  WRITE SAME                                                         */
+/* ------------------------------------------------------------------ */
+
+#define SCSI_INQUIRY             0x12
+#define SCSI_MAINTENANCE_IN      0xA3
+#define SCSI_WRITE_SAME_16       0x93
+#define SCSI_RSOC                0x0C    /* REPORT SUPPORTED OP CODES */
+#define SCSI_VPD_BLOCK_LIMITS    0xB0
+#define SCSI_SENSE_ILLEGAL_REQUEST 0x05
+
+#define SAME_TIMEOUT_MS          (120 * 1000)
+#define SAME_BLOCKS_DEFAULT      0xFFFF  /* when the drive states no limit */
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (24 - 8 * i));
+}
+
+static uint64_t get_be(const uint8_t *p, int n)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+/* Issue a SCSI command. Returns 0 on GOOD status; on CHECK CONDITION
+ * *key (if set) gets the sense key. */
+static int scsi_cmd(int fd, uint8_t *cdb, int cdb_len, int dir,
+                     void *data, unsigned int len, unsigned int timeout_ms,
+                     int *key)
+{
+    uint8_t sense[32] = { 0 };
+    sg_io_hdr_t io;
+
+    memset(&io, 0, sizeof(io));
+    io.interface_id = 'S';
+    io.cmdp = cdb;
+    io.cmd_len = (unsigned char)cdb_len;
+    io.sbp = sense;
+    io.mx_sb_len = sizeof(sense);
+    io.timeout = timeout_ms;
+    io.dxfer_direction = dir;
+    io.dxferp = data;
+    io.dxfer_len = len;
+
+    if (key) *key = -1;
+    if (ioctl(fd, SG_IO, &io) < 0) return -1;
+    if (io.status == 0 && io.host_status == 0 && io.driver_status == 0)
+        return 0;
+    if (key && io.sb_len_wr > 2)      /* fixed or descriptor format */
+        *key = (sense[0] & 0x7F) >= 0x72 ? sense[1] & 0x0F
+                                         : sense[2] & 0x0F;
+    return -1;
+}
+
+/* 1 supported, 0 not, -1 if the drive cannot say */
+static int same_reported(int fd)
+{
+    uint8_t cdb[12] = { SCSI_MAINTENANCE_IN, SCSI_RSOC, 1,
+                        SCSI_WRITE_SAME_16 };
+    uint8_t buf[64] = { 0 };
+    put_be32(cdb + 6, sizeof(buf));
+    if (scsi_cmd(fd, cdb, sizeof(cdb), SG_DXFER_FROM_DEV, buf,
+                 sizeof(buf), 5000, NULL) != 0)
+        return -1;
+    int support = buf[1] & 0x07;
+    return support == 3 || support == 5;
+}
+
+/* MAXIMUM WRITE SAME LENGTH in blocks, 0 if not stated */
+static uint64_t same_limit(int fd)
+{
+    uint8_t cdb[6] = { SCSI_INQUIRY, 1, SCSI_VPD_BLOCK_LIMITS, 0, 64 };
+    uint8_t buf[64] = { 0 };
+    if (scsi_cmd(fd, cdb, sizeof(cdb), SG_DXFER_FROM_DEV, buf,
+                 sizeof(buf), 5000, NULL) != 0 ||
+        buf[1] != SCSI_VPD_BLOCK_LIMITS || get_be(buf + 2, 2) < 0x3C)
+        return 0;
+    return get_be(buf + 36, 8);
+}
+
+int vault_wipe_same_open(vault_wipe_same_t *ws, const char *device)
+{
+    memset(ws, 0, sizeof(*ws));
+    ws->fd = -1;
+
+    struct stat st;
+    if (stat(device, &st) != 0 || !S_ISBLK(st.st_mode)) return -1;
+    if (hw_is_partition(device)) return -1;
+    const char *name = strrchr(device, '/');
+    name = name ? name + 1 : device;
+    if (strncmp(name, "nvme", 4) == 0) return -1;   /* no SCSI layer */
+
+    int fd = open(device, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int bs = 0;
+    if (ioctl(fd, BLKSSZGET, &bs) != 0 || bs <= 0) {
+        close(fd);
+        return -1;
+    }
+
+    int reported = same_reported(fd);
+    uint64_t limit = same_limit(fd);
+    if (reported == 0 || (reported < 0 && limit == 0)) {
+        close(fd);
+        return -1;
+    }
+
+    ws->fd = fd;
+    ws->block = (uint32_t)bs;
+    ws->max_blocks = limit > 0 && limit < SAME_BLOCKS_DEFAULT
+                   ? (uint32_t)limit : SAME_BLOCKS_DEFAULT;
+    return 0;
+}
+
+int vault_wipe_same_write(const vault_wipe_same_t *ws, uint64_t offset,
+                           uint64_t len, const uint8_t *block, int *refused)
+{
+    *refused = 0;
+    if (offset % ws->block || len % ws->block) return -1;
+
+    uint64_t lba = offset / ws->block, end = lba + len / ws->block;
+    int ret = 0;
+    while (lba < end && ret == 0) {
+        uint64_t n = end - lba;
+        if (n > ws->max_blocks) n = ws->max_blocks;
+
+        uint8_t cdb[16] = { SCSI_WRITE_SAME_16 };
+        for (int i = 0; i < 8; i++)
+            cdb[2 + i] = (uint8_t)(lba >> (56 - 8 * i));
+        put_be32(cdb + 10, (uint32_t)n);
+
+        int key;
+        ret = scsi_cmd(ws->fd, cdb, sizeof(cdb), SG_DXFER_TO_DEV,
+                       (void *)block, ws->block, SAME_TIMEOUT_MS, &key);
+        if (ret != 0 && key == SCSI_SENSE_ILLEGAL_REQUEST) *refused = 1;
+        lba += n;
+    }
+
+    /* The page cache never saw these writes */
+    ioctl(ws->fd, BLKFLSBUF, 0);
+    return ret;
+}
+
+void vault_wipe_same_close(vault_wipe_same_t *ws)
+{
+    if (ws->fd >= 0) close(ws->fd);
+    ws->fd = -1;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Entry point                                                        */
+/* ------------------------------------------------------------------ */
+
+int vault_wipe_hw_erase(const char *device,
+                         vault_wipe_progress_cb progress_cb)
+{
+    struct stat st;
+    if (stat(device, &st) != 0 || !S_ISBLK(st.st_mode)) return -1;
+    if (hw_is_partition(device)) {
+        fprintf(stderr, "wipe: %s: hardware erase needs a whole disk\n",
+                device);
+        return -1;
+    }
+
+    /* Exclusive open fails if anything still has the disk mounted */
+    int fd = open(device, O_RDWR | O_EXCL | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    hw_erase_t h = {
+        .device = device, .cb = progress_cb, .start = hw_now()
+    };
+    if (ioctl(fd, BLKGETSIZE64, &h.size) != 0) h.size = 0;
+
+    const char *name = strrchr(device, '/');
+    name = name ? name + 1 : device;
+
+    int ret = (strncmp(name, "nvme", 4) == 0) ? hw_nvme(&h, fd)
+                                              : hw_ata(&h, fd);
+    if (ret != 0 && h.size > 0)
+        ret = hw_discard(&h, fd);
+
+    /* Nothing cached from before the erase may be read back */
+    if (ret == 0) ioctl(fd, BLKFLSBUF, 0);
+    close(fd);
+    return ret;
+}
+
+#else /* !VAULT_PLATFORM_LINUX */
+
+int vault_wipe_hw_erase(const char *device,
+                         vault_wipe_progress_cb progress_cb)
+{
+    (void)device; (void)progress_cb;
+    return -1;
+}
+
+int vault_wipe_same_open(vault_wipe_same_t *ws, const char *device)
+{
+    (void)device;
+    memset(ws, 0, sizeof(*ws));
+    ws->fd = -1;
+    return -1;
+}
+
+int vault_wipe_same_write(const vault_wipe_same_t *ws, uint64_t offset,
+                           uint64_t len, const uint8_t *block, int *refused)
+{
+    (void)ws; (void)offset; (void)len; (void)block;
+    *refused = 1;
+    return -1;
+}
+
+void vault_wipe_same_close(vault_wipe_same_t *ws)
+{
+    (void)ws;
+}
+
+#endif
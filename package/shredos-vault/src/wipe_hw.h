@@ -0,0 +1,52 @@
+/*
+ * wipe_hw.h -- Drive-Native Secure Erase
+ *
+ * Asks the drive to erase itself instead of overwriting it from the
+ * host: NVMe Sanitize or Format with Secure Erase, ATA SECURITY ERASE
+ * UNIT, or a block-layer secure discard. On flash these reach cells
+ * that software passes cannot because of wear-levelling, and finish in
+ * seconds to minutes.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_HW_H
+#define VAULT_WIPE_HW_H
+
+#include "wipe.h"
+
+/* Erase the whole of device with the strongest method it supports,
+ * reporting progress where the drive provides it. Partitions are
+ * refused, since every method works on the whole drive (NVMe Sanitize
+ * covers every namespace on the controller).
+ * Returns 0 on success, -1 if the device has no usable erase command
+ * or the erase failed; the caller then falls back to software passes. */
+int vault_wipe_hw_erase(const char *device,
+                         vault_wipe_progress_cb progress_cb);
+
+/* WRITE SAME(16) over SG_IO: the drive repeats one logical block
+ * across a range, so a single-block pattern pass costs the host one
+ * block per command. SCSI/SAS drives, and SATA drives whose
+ * translation layer passes it on. */
+typedef struct {
+    int      fd;
+    uint32_t block;             /* logical block size */
+    uint32_t max_blocks;        /* per command */
+} vault_wipe_same_t;
+
+/* Open device for WRITE SAME if the drive reports supporting it (REPORT
+ * SUPPORTED OPERATION CODES, else a Block Limits maximum). Partitions
+ * are refused: SG_IO addresses the whole disk.
+ * Returns 0 on success, -1 if the drive offers no WRITE SAME. */
+int vault_wipe_same_open(vault_wipe_same_t *ws, const char *device);
+
+/* Fill len bytes at offset, both whole blocks, with copies of block.
+ * Cached reads of the range are dropped afterwards.
+ * Returns 0 on success, -1 on failure, with *refused set if the drive
+ * rejected the command itself rather than failing to write. */
+int vault_wipe_same_write(const vault_wipe_same_t *ws, uint64_t offset,
+                           uint64_t len, const uint8_t *block, int *refused);
+
+void vault_wipe_same_close(vault_wipe_same_t *ws);
+
+#endif /* VAULT_WIPE_HW_H */
@@ -0,0 +1,117 @@
+/*
+ * wipe_journal.c -- Wipe Checkpoint Records
+ *
+ * Record layout, all integers little-endian:
+ *   0   magic "SVWJRNL1"     8
+ *   8   algorithm, rng,      4 x u32
+ *       pass, random
+ *   24  nstripes             u32
+ *   28  schedule             u32
+ *   32  disk_size, chunk,    3 x u64
+ *       seq
+ *   56  seed                 40
+ *   96  done[8]              8 x u64
+ *   160 CRC-32 of [0, 160)   u32
+ * The rest of the block is zero.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_journal.h"
+
+#include <string.h>
+
+#define JOURNAL_MAGIC     "SVWJRNL1"
+#define JOURNAL_BODY_LEN  160
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put64(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+/* CRC-32 (IEEE 802.3), bitwise: records are a few hundred bytes */
+static uint32_t crc32(const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+uint64_t vault_wipe_journal_offset(uint64_t disk_size)
+{
+    if (disk_size < 4 * (uint64_t)VAULT_WIPE_JOURNAL_ALIGN) return 0;
+    uint64_t off = disk_size - VAULT_WIPE_JOURNAL_LEN;
+    return off - off % VAULT_WIPE_JOURNAL_ALIGN;
+}
+
+void vault_wipe_journal_encode(const vault_wipe_journal_t *j,
+                                uint8_t out[VAULT_WIPE_JOURNAL_LEN])
+{
+    memset(out, 0, VAULT_WIPE_JOURNAL_LEN);
+    memcpy(out, JOURNAL_MAGIC, 8);
+    put32(out + 8,  (uint32_t)j->algorithm);
+    put32(out + 12, (uint32_t)j->rng);
+    put32(out + 16, (uint32_t)j->pass);
+    put32(out + 20, (uint32_t)j->random);
+    put32(out + 24, (uint32_t)j->nstripes);
+    put32(out + 28, j->schedule);
+    put64(out + 32, j->disk_size);
+    put64(out + 40, j->chunk);
+    put64(out + 48, j->seq);
+    memcpy(out + 56, j->seed, VAULT_WIPE_STREAM_SEED_LEN);
+    for (int i = 0; i < VAULT_WIPE_STRIPES_MAX; i++)
+        put64(out + 96 + 8 * i, j->done[i]);
+    put32(out + JOURNAL_BODY_LEN, crc32(out, JOURNAL_BODY_LEN));
+}
+
+int vault_wipe_journal_decode(vault_wipe_journal_t *j,
+                               const uint8_t in[VAULT_WIPE_JOURNAL_LEN])
+{
+    if (memcmp(in, JOURNAL_MAGIC, 8) != 0) return -1;
+    if (get32(in + JOURNAL_BODY_LEN) != crc32(in, JOURNAL_BODY_LEN))
+        return -1;
+
+    memset(j, 0, sizeof(*j));
+    uint32_t alg = get32(in + 8), rng = get32(in + 12);
+    if (alg >= WIPE_COUNT || rng >= WIPE_RNG_COUNT) return -1;
+    j->algorithm = (wipe_algorithm_t)alg;
+    j->rng       = (wipe_rng_t)rng;
+    j->pass      = (int)get32(in + 16);
+    j->random    = (int)get32(in + 20);
+    j->nstripes  = (int)get32(in + 24);
+    j->schedule  = get32(in + 28);
+    j->disk_size = get64(in + 32);
+    j->chunk     = get64(in + 40);
+    j->seq       = get64(in + 48);
+    memcpy(j->seed, in + 56, VAULT_WIPE_STREAM_SEED_LEN);
+    for (int i = 0; i < VAULT_WIPE_STRIPES_MAX; i++)
+        j->done[i] = get64(in + 96 + 8 * i);
+
+    if (j->pass < 1 || j->nstripes < 1 ||
+        j->nstripes > VAULT_WIPE_STRIPES_MAX || j->chunk == 0)
+        return -1;
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * wipe_journal.h -- Wipe Checkpoint Records
+ *
+ * A journalled wipe keeps its progress in a small area reserved at the
+ * end of the device being wiped: the pass in progress, how far each
+ * stripe of it has got, and the seed of a random pass, so a wipe cut
+ * short by a power loss or reboot picks up where it stopped. Passes
+ * leave the area alone; once the last pass is done it is overwritten
+ * with that pass's data, which also clears the record.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_JOURNAL_H
+#define VAULT_WIPE_JOURNAL_H
+
+#include "wipe.h"
+#include "wipe_stream.h"
+#include <stdint.h>
+
+#define VAULT_WIPE_JOURNAL_LEN    4096          /* record, zero padded */
+#define VAULT_WIPE_JOURNAL_ALIGN  (64 * 1024)   /* reserved area start */
+
+typedef struct {
+    wipe_algorithm_t algorithm;
+    uint64_t   disk_size;
+    uint64_t   chunk;                           /* pass layout */
+    int        nstripes;
+    uint32_t   schedule;                        /* custom pass list id,
+                                                 * 0 = the algorithm's */
+    int        pass;                            /* 1-based, in progress */
+    int        random;                          /* pass is random */
+    wipe_rng_t rng;                             /* its resolved generator */
+    uint8_t    seed[VAULT_WIPE_STREAM_SEED_LEN];
+    uint64_t   done[VAULT_WIPE_STRIPES_MAX];    /* per stripe: written up
+                                                 * to here and flushed */
+    uint64_t   seq;                             /* bumped on every write */
+} vault_wipe_journal_t;
+
+/* Start of the reserved area for a device of disk_size bytes, aligned
+ * to VAULT_WIPE_JOURNAL_ALIGN. Returns 0 if the device is too small to
+ * journal. */
+uint64_t vault_wipe_journal_offset(uint64_t disk_size);
+
+/* Serialise j (little-endian, CRC-32 protected) into out. */
+void vault_wipe_journal_encode(const vault_wipe_journal_t *j,
+                                uint8_t out[VAULT_WIPE_JOURNAL_LEN]);
+
+/* Parse a record. Returns 0 if in holds a valid one, -1 otherwise. */
+int vault_wipe_journal_decode(vault_wipe_journal_t *j,
+                               const uint8_t in[VAULT_WIPE_JOURNAL_LEN]);
+
+#endif /* VAULT_WIPE_JOURNAL_H */
@@ -0,0 +1,352 @@
+/*
+ * wipe_meta.c -- Metadata Locations
+ *
+ * Only what the on-disk formats place at fixed or header-given
+ * offsets is found; structures reached through trees (the ext4
+ * journal inode, Btrfs chunk trees, APFS object maps) are left to the
+ * passes. Every read is bounds-checked against the disk, so a damaged
+ * or hostile table can add wrong regions but not unbounded work.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_meta.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define META_BUF        (64 * 1024)     /* scratch, holds a LUKS2 JSON area */
+#define META_GPT_MAX    256             /* partition entries followed */
+#define META_EBR_MAX    64              /* logical partitions followed */
+#define META_AG_MAX     4096            /* XFS allocation groups */
+
+typedef struct {
+    vault_wipe_meta_read_fn read;
+    void     *ctx;
+    uint64_t  disk_size;
+    size_t    align;
+    vault_wipe_extent_t *out;
+    int       max;
+    int       count;
+    uint8_t  *buf;
+} meta_scan_t;
+
+static uint16_t le16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t le64(const uint8_t *p)
+{
+    return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+static uint64_t be(const uint8_t *p, int n)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+/* Read into the scratch buffer; fails past the end of the disk. */
+static int meta_read(meta_scan_t *s, uint64_t offset, size_t len)
+{
+    if (len > META_BUF || offset > s->disk_size ||
+        len > s->disk_size - offset)
+        return -1;
+    return s->read(s->ctx, offset, s->buf, len);
+}
+
+static void meta_add(meta_scan_t *s, uint64_t offset, uint64_t len)
+{
+    if (len == 0 || offset >= s->disk_size || s->count == s->max) return;
+    if (len > VAULT_WIPE_META_REGION) len = VAULT_WIPE_META_REGION;
+    uint64_t limit = s->disk_size - s->disk_size % s->align;
+    uint64_t start = offset - offset % s->align;
+    uint64_t end = len > s->disk_size - offset ? s->disk_size : offset + len;
+    end = (end + s->align - 1) / s->align * s->align;
+    if (end > limit) end = limit;
+    if (start >= end) return;
+    s->out[s->count].offset = start;
+    s->out[s->count].length = end - start;
+    s->count++;
+}
+
+/* ------------------------------------------------------------------ */
+/*  LUKS                                                               */
+/* ------------------------------------------------------------------ */
+
+/* Start of a LUKS2 device's data: the first segment's offset in the
+ * JSON area after the 4 KB binary header. 0 if it cannot be read. */
+static uint64_t luks2_data_offset(meta_scan_t *s, uint64_t base,
+                                   uint64_t hdr_size)
+{
+    if (hdr_size < 16384 || hdr_size > 4 * 1024 * 1024) return 0;
+    size_t len = (size_t)(hdr_size - 4096);
+    if (len > META_BUF - 1) len = META_BUF - 1;
+    if (meta_read(s, base + 4096, len) != 0) return 0;
+    s->buf[len] = '\0';
+
+    const char *seg = strstr((const char *)s->buf, "\"segments\"");
+    const char *off = seg ? strstr(seg, "\"offset\":\"") : NULL;
+    return off ? strtoull(off + 10, NULL, 10) : 0;
+}
+
+/* Header and keyslots: everything before the encrypted data */
+static int scan_luks(meta_scan_t *s, uint64_t base, const uint8_t *hdr)
+{
+    if (memcmp(hdr, "LUKS\xba\xbe", 6) != 0) return 0;
+    uint64_t data = 0;
+    if (be(hdr + 6, 2) == 1)
+        data = be(hdr + 104, 4) * 512;          /* payload offset */
+    else
+        data = luks2_data_offset(s, base, be(hdr + 8, 8));
+    meta_add(s, base, data ? data : 16 * 1024 * 1024);
+    return 1;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Filesystems                                                        */
+/* ------------------------------------------------------------------ */
+
+static int ext_backup_group(uint64_t g)
+{
+    if (g <= 1) return 1;
+    for (uint64_t p = 3; p <= 7; p += 2) {
+        uint64_t n = g;
+        while (n % p == 0) n /= p;
+        if (n == 1) return 1;
+    }
+    return 0;
+}
+
+/* Backup superblocks and group descriptor tables */
+static void scan_ext(meta_scan_t *s, uint64_t base, uint64_t size,
+                      const uint8_t *sb)
+{
+    uint32_t log = le32(sb + 24);
+    if (log > 6) return;
+    uint64_t bs = 1024ULL << log;
+    uint64_t bpg = le32(sb + 32);
+    uint64_t first = le32(sb + 20);
+    uint32_t incompat = le32(sb + 0x60), ro_compat = le32(sb + 0x64);
+    uint64_t blocks = le32(sb + 4);
+    uint64_t desc = 32;
+    if (incompat & 0x80) {                      /* 64bit */
+        blocks |= (uint64_t)le32(sb + 0x150) << 32;
+        if (le16(sb + 0xFE) >= 32) desc = le16(sb + 0xFE);
+    }
+    if (bpg == 0 || blocks <= first || blocks > size / bs) return;
+
+    uint64_t groups = (blocks - first + bpg - 1) / bpg;
+    uint64_t len = bs + groups * desc;
+    for (uint64_t g = 1; g < groups && s->count < s->max; g++)
+        if (!(ro_compat & 1) || ext_backup_group(g))   /* sparse_super */
+            meta_add(s, base + (first + g * bpg) * bs, len);
+}
+
+/* Secondary superblocks at every allocation group, and the log */
+static void scan_xfs(meta_scan_t *s, uint64_t base, uint64_t size,
+                      const uint8_t *sb)
+{
+    uint64_t bs = be(sb + 4, 4);
+    uint64_t agblocks = be(sb + 84, 4), agcount = be(sb + 88, 4);
+    if (bs < 512 || bs > 65536 || agblocks == 0 || agcount == 0 ||
+        agblocks * bs > size)
+        return;
+
+    for (uint64_t ag = 1; ag < agcount && ag < META_AG_MAX; ag++)
+        meta_add(s, base + ag * agblocks * bs, 64 * 1024);
+
+    uint64_t logstart = be(sb + 48, 8), logblocks = be(sb + 96, 4);
+    unsigned agblklog = sb[124];
+    if (logstart && agblklog < 32) {
+        uint64_t agno = logstart >> agblklog;
+        uint64_t agbno = logstart & ((1ULL << agblklog) - 1);
+        meta_add(s, base + (agno * agblocks + agbno) * bs, logblocks * bs);
+    }
+}
+
+/* The MFT, which holds every file's name and small files whole, and
+ * its mirror; the backup boot sector is in the volume's tail. */
+static void scan_ntfs(meta_scan_t *s, uint64_t base, const uint8_t *boot)
+{
+    uint64_t bps = le16(boot + 0x0B);
+    unsigned spc = boot[0x0D];
+    if (bps < 256 || bps > 4096 || (bps & (bps - 1))) return;
+    uint64_t cluster = spc <= 0x80 ? bps * spc
+                     : spc >= 0xF4 ? bps << (256 - spc) : 0;
+    if (cluster == 0) return;
+    meta_add(s, base + le64(boot + 0x30) * cluster, VAULT_WIPE_META_REGION);
+    meta_add(s, base + le64(boot + 0x38) * cluster, 64 * 1024);
+}
+
+/* Superblock copies at 64 KB, 64 MB and 256 GB */
+static void scan_btrfs(meta_scan_t *s, uint64_t base, uint64_t size)
+{
+    static const uint64_t mirrors[] = {
+        64ULL * 1024, 64ULL * 1024 * 1024, 256ULL * 1024 * 1024 * 1024
+    };
+    for (int i = 0; i < 3; i++)
+        if (mirrors[i] + 4096 <= size)
+            meta_add(s, base + mirrors[i], 4096);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Volumes and partition tables                                       */
+/* ------------------------------------------------------------------ */
+
+static void scan_volume(meta_scan_t *s, uint64_t base, uint64_t size,
+                         int whole_disk);
+
+/* GPT with 512- or 4096-byte sectors. Returns 1 if one was found. */
+static int scan_gpt(meta_scan_t *s)
+{
+    for (uint64_t ss = 512; ss <= 4096; ss *= 8) {
+        if (meta_read(s, ss, 512) != 0 ||
+            memcmp(s->buf, "EFI PART", 8) != 0)
+            continue;
+        uint64_t alt = le64(s->buf + 32);
+        uint64_t lba = le64(s->buf + 72);
+        uint32_t n = le32(s->buf + 80), esz = le32(s->buf + 84);
+        if (esz < 128 || esz > 4096 || esz % 8 || n == 0 || n > 1024)
+            return 0;
+        meta_add(s, lba * ss, (uint64_t)n * esz);
+        meta_add(s, alt * ss, ss);
+        if (alt * ss >= (uint64_t)n * esz)
+            meta_add(s, alt * ss - (uint64_t)n * esz, (uint64_t)n * esz);
+
+        for (uint32_t i = 0; i < n && i < META_GPT_MAX; i++) {
+            if (meta_read(s, lba * ss + (uint64_t)i * esz, esz) != 0) break;
+            static const uint8_t unused[16];
+            if (memcmp(s->buf, unused, 16) == 0) continue;
+            uint64_t first = le64(s->buf + 32), last = le64(s->buf + 40);
+            if (first > 0 && last >= first)
+                scan_volume(s, first * ss, (last - first + 1) * ss, 0);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static int mbr_extended(uint8_t type)
+{
+    return type == 0x05 || type == 0x0F || type == 0x85;
+}
+
+/* Logical partitions: a chain of EBRs, each giving one partition
+ * relative to itself and the next EBR relative to the first. */
+static void scan_ebr(meta_scan_t *s, uint64_t first)
+{
+    uint64_t ebr = first;
+    for (int i = 0; i < META_EBR_MAX; i++) {
+        if (meta_read(s, ebr * 512, 512) != 0 ||
+            s->buf[510] != 0x55 || s->buf[511] != 0xAA)
+            return;
+        meta_add(s, ebr * 512, 512);
+        const uint8_t *e = s->buf + 446;
+        uint64_t start = ebr + le32(e + 8), count = le32(e + 12);
+        uint8_t next_type = e[16 + 4];
+        uint64_t next = first + le32(e + 16 + 8);
+        if (e[4] && count)
+            scan_volume(s, start * 512, count * 512, 0);
+        if (!mbr_extended(next_type) || next <= ebr) return;
+        ebr = next;
+    }
+}
+
+static void scan_mbr(meta_scan_t *s, const uint8_t *mbr)
+{
+    if (mbr[510] != 0x55 || mbr[511] != 0xAA) return;
+    /* FAT and NTFS boot sectors carry the signature too */
+    if (memcmp(mbr + 3, "NTFS    ", 8) == 0 ||
+        memcmp(mbr + 0x36, "FAT", 3) == 0 || memcmp(mbr + 0x52, "FAT", 3) == 0)
+        return;
+
+    uint64_t sectors = s->disk_size / 512;
+    struct { uint8_t type; uint64_t start, count; } part[4];
+    for (int i = 0; i < 4; i++) {
+        const uint8_t *e = mbr + 446 + 16 * i;
+        part[i].type = e[4];
+        part[i].start = le32(e + 8);
+        part[i].count = le32(e + 12);
+        if ((e[0] != 0 && e[0] != 0x80) || part[i].start >= sectors)
+            part[i].type = 0;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (part[i].type == 0 || part[i].type == 0xEE || !part[i].count)
+            continue;
+        if (mbr_extended(part[i].type))
+            scan_ebr(s, part[i].start);
+        else
+            scan_volume(s, part[i].start * 512, part[i].count * 512, 0);
+    }
+}
+
+static void scan_volume(meta_scan_t *s, uint64_t base, uint64_t size,
+                         int whole_disk)
+{
+    if (size == 0 || base >= s->disk_size) return;
+    if (size > s->disk_size - base) size = s->disk_size - base;
+
+    uint64_t edge = size < VAULT_WIPE_META_EDGE ? size : VAULT_WIPE_META_EDGE;
+    meta_add(s, base, edge);
+    meta_add(s, base + size - edge, edge);
+
+    uint8_t head[4096];
+    if (size < sizeof(head) || meta_read(s, base, sizeof(head)) != 0) return;
+    memcpy(head, s->buf, sizeof(head));
+
+    /* Everything past a LUKS header is ciphertext */
+    if (scan_luks(s, base, head)) return;
+
+    if (whole_disk && !scan_gpt(s)) scan_mbr(s, head);
+
+    if (memcmp(head, "XFSB", 4) == 0)
+        scan_xfs(s, base, size, head);
+    else if (memcmp(head + 3, "NTFS    ", 8) == 0)
+        scan_ntfs(s, base, head);
+    else if (le16(head + 1024 + 56) == 0xEF53)
+        scan_ext(s, base, size, head + 1024);
+
+    if (size >= 65536 + 4096 && meta_read(s, base + 65536, 4096) == 0 &&
+        memcmp(s->buf + 64, "_BHRfS_M", 8) == 0)
+        scan_btrfs(s, base, size);
+}
+
+static int extent_cmp(const void *a, const void *b)
+{
+    const vault_wipe_extent_t *x = a, *y = b;
+    return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+int vault_wipe_meta_regions(vault_wipe_meta_read_fn read_fn, void *ctx,
+                             uint64_t disk_size, size_t align,
+                             vault_wipe_extent_t *out, int max)
+{
+    if (align == 0 || max <= 0) return 0;
+    meta_scan_t s = {
+        .read = read_fn, .ctx = ctx, .disk_size = disk_size,
+        .align = align, .out = out, .max = max
+    };
+    s.buf = (uint8_t *)malloc(META_BUF);
+    if (!s.buf) return 0;
+    scan_volume(&s, 0, disk_size, 1);
+    free(s.buf);
+
+    qsort(out, (size_t)s.count, sizeof(*out), extent_cmp);
+    int n = 0;
+    for (int i = 0; i < s.count; i++) {
+        if (n > 0 && out[i].offset <= out[n - 1].offset + out[n - 1].length) {
+            uint64_t end = out[i].offset + out[i].length;
+            if (end > out[n - 1].offset + out[n - 1].length)
+                out[n - 1].length = end - out[n - 1].offset;
+        } else {
+            out[n++] = out[i];
+        }
+    }
+    return n;
+}
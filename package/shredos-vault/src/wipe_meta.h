@@ -0,0 +1,42 @@
+/*
+ * wipe_meta.h -- Metadata Locations
+ *
+ * Finds where a disk keeps the structures that make the rest of it
+ * recoverable: partition tables, LUKS headers and keyslots, and
+ * filesystem superblocks with their backups. Wiping those first, in a
+ * few milliseconds, leaves an interrupted wipe far less to give away
+ * than a pass that only gets to them when it reaches their offset.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_META_H
+#define VAULT_WIPE_META_H
+
+#include "wipe.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define VAULT_WIPE_META_MAX     256                 /* regions per disk */
+#define VAULT_WIPE_META_EDGE    (1024 * 1024)       /* head and tail */
+#define VAULT_WIPE_META_REGION  (64 * 1024 * 1024)  /* largest region */
+
+/* Read len bytes at offset. Returns 0 if all of them were read. */
+typedef int (*vault_wipe_meta_read_fn)(void *ctx, uint64_t offset,
+                                        void *buf, size_t len);
+
+/* Find the metadata of a disk of disk_size bytes by reading it through
+ * read_fn: the first and last VAULT_WIPE_META_EDGE bytes of the disk
+ * and of every MBR or GPT partition (partition tables, backup GPT,
+ * boot sectors, MD/ZFS labels, HFS+ headers), LUKS1/LUKS2 headers up
+ * to the start of their data, ext2/3/4 and XFS backup superblocks, the
+ * XFS log, the NTFS MFT and its mirror, and Btrfs superblock mirrors.
+ * Regions are aligned out to align, clipped to the disk, sorted and
+ * merged into out[], at most max of them, none longer than
+ * VAULT_WIPE_META_REGION.
+ * Returns the number of regions. */
+int vault_wipe_meta_regions(vault_wipe_meta_read_fn read_fn, void *ctx,
+                             uint64_t disk_size, size_t align,
+                             vault_wipe_extent_t *out, int max);
+
+#endif /* VAULT_WIPE_META_H */
@@ -0,0 +1,201 @@
+/*
+ * wipe_plan.c -- Time-Budgeted Wipe Planning
+ *
+ * A pass costs its bytes at the device's write rate, or a quarter of
+ * that on flash when the drive writes it itself; verification reads
+ * everything (or its sample) back once more. The candidates run from
+ * the configured schedule down the built-in ladder by pass count, so a
+ * budget only ever weakens a plan, never strengthens it.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_plan.h"
+#include "wipe_schedule.h"
+#include "wipe_stats.h"
+
+#include <string.h>
+
+/* Offloaded passes on flash: WRITE ZEROES and WRITE SAME mostly end in
+ * unmapping, far quicker than the data they stand for. Spinning disks
+ * still write every sector. */
+#define WIPE_PLAN_OFFLOAD_GAIN 4.0
+
+/* Strongest first */
+static const wipe_algorithm_t ladder[] = {
+    WIPE_GUTMANN, WIPE_DOD_522022, WIPE_DOD_SHORT, WIPE_RANDOM, WIPE_ZERO,
+};
+#define LADDER_LEN (int)(sizeof(ladder) / sizeof(ladder[0]))
+
+typedef struct {
+    wipe_algorithm_t      algorithm;
+    const char           *schedule;
+    vault_wipe_schedule_t sched;
+} candidate_t;
+
+static int offloaded(const vault_wipe_pass_t *p, const vault_wipe_caps_t *caps,
+                     int offload)
+{
+    if (!offload || p->kind == VAULT_WIPE_PASS_RANDOM) return 0;
+    if (p->kind == VAULT_WIPE_PASS_ZERO && caps->zeroout) return 1;
+    /* WRITE SAME repeats one block, which only whole periods tile */
+    return caps->write_same &&
+           (p->pattern_len & (p->pattern_len - 1)) == 0;
+}
+
+static double schedule_seconds(const vault_wipe_schedule_t *s,
+                               const vault_wipe_caps_t *caps, double mb,
+                               double mbps, int offload, double readback)
+{
+    double secs = 0;
+    for (int i = 0; i < s->count; i++) {
+        double rate = mbps;
+        if (caps->flash && offloaded(&s->passes[i], caps, offload))
+            rate *= WIPE_PLAN_OFFLOAD_GAIN;
+        secs += mb / rate + mb * readback / mbps;
+    }
+    return secs;
+}
+
+void vault_wipe_plan(vault_wipe_plan_t *plan, const vault_wipe_caps_t *caps,
+                     uint64_t bytes, wipe_algorithm_t algorithm, int verify,
+                     const vault_wipe_params_t *params, double mbps,
+                     int budget)
+{
+    const char *custom = params->schedule && params->schedule[0]
+                       ? params->schedule : NULL;
+
+    memset(plan, 0, sizeof(*plan));
+    plan->algorithm = algorithm;
+    plan->schedule = custom;
+    plan->verify = verify;
+    plan->mbps = mbps > 0 ? mbps : caps->write_mbps;
+    plan->rate_source = mbps > 0 ? "config" : caps->kind;
+    plan->fits = 1;
+    if (algorithm == WIPE_HW_ERASE || algorithm == WIPE_VERIFY_ONLY ||
+        plan->mbps <= 0)
+        return;
+
+    /* The configured schedule, then the built-in ones below it: after
+     * the algorithm on the ladder, or with fewer passes than a custom
+     * list */
+    candidate_t cand[1 + LADDER_LEN];
+    int n = 0, below = 0;
+    if (custom && vault_wipe_schedule_parse(&cand[n].sched, custom) > 0) {
+        cand[n].algorithm = algorithm;
+        cand[n].schedule = custom;
+        n++;
+    } else if (vault_wipe_schedule_builtin(&cand[n].sched, algorithm) == 0) {
+        cand[n].algorithm = algorithm;
+        cand[n].schedule = NULL;
+        n++;
+    }
+    for (int i = 0; i < LADDER_LEN; i++) {
+        if (n == 1 && !cand[0].schedule && !below) {
+            below = ladder[i] == algorithm;
+            continue;
+        }
+        if (vault_wipe_schedule_builtin(&cand[n].sched, ladder[i]) != 0)
+            continue;
+        if (n > 0 && cand[0].schedule &&
+            cand[n].sched.count >= cand[0].sched.count)
+            continue;
+        cand[n].algorithm = ladder[i];
+        cand[n].schedule = NULL;
+        n++;
+    }
+    if (n == 0) return;
+
+    double mb = (double)bytes / (1024.0 * 1024.0);
+    int offload = params->offload && params->rate_mbps <= 0;
+    double sample = params->verify_sample_pct;
+    double readback = sample > 0 && sample < 100 ? sample / 100.0 : 1.0;
+
+    /* Strongest that fits, verified as configured before unverified */
+    int best = -1, best_verify = 0;
+    double best_secs = 0;
+    for (int v = verify; v >= 0 && best < 0; v--) {
+        for (int i = 0; i < n; i++) {
+            double secs = schedule_seconds(&cand[i].sched, caps, mb,
+                                           plan->mbps, offload,
+                                           v ? readback : 0);
+            if (secs <= budget) {
+                best = i;
+                best_verify = v;
+                best_secs = secs;
+                break;
+            }
+        }
+    }
+    plan->fits = best >= 0;
+
+    /* Nothing fits: the quickest, so as much as possible is gone */
+    if (best < 0) {
+        for (int i = 0; i < n; i++) {
+            double secs = schedule_seconds(&cand[i].sched, caps, mb,
+                                           plan->mbps, offload, 0);
+            if (best < 0 || secs < best_secs) {
+                best = i;
+                best_secs = secs;
+            }
+        }
+    }
+
+    plan->algorithm = cand[best].algorithm;
+    plan->schedule = cand[best].schedule;
+    plan->passes = cand[best].sched.count;
+    plan->verify = best_verify;
+    plan->seconds = best_secs;
+    plan->changed = best != 0 || best_verify != verify;
+}
+
+static void format_duration(double secs, char *buf, size_t len)
+{
+    long s = (long)(secs + 0.5);
+    if (s >= 3600)
+        snprintf(buf, len, "%ldh%02ldm", s / 3600, (s % 3600) / 60);
+    else if (s >= 60)
+        snprintf(buf, len, "%ldm%02lds", s / 60, s % 60);
+    else
+        snprintf(buf, len, "%lds", s);
+}
+
+static const char *plan_name(const vault_wipe_plan_t *plan)
+{
+    return plan->schedule ? "custom schedule"
+                          : vault_wipe_algorithm_name(plan->algorithm);
+}
+
+void vault_wipe_plan_describe(const vault_wipe_plan_t *plan, int budget,
+                              char *buf, size_t len)
+{
+    if (plan->passes == 0) {
+        snprintf(buf, len, "%s, not estimated", plan_name(plan));
+        return;
+    }
+    char est[32], lim[32];
+    format_duration(plan->seconds, est, sizeof(est));
+    format_duration(budget, lim, sizeof(lim));
+    snprintf(buf, len, "%s, %d pass%s%s, ~%s at %.0f MB/s (%s), %s %s",
+             plan_name(plan), plan->passes, plan->passes == 1 ? "" : "es",
+             plan->verify ? ", verified" : "", est, plan->mbps,
+             plan->rate_source, plan->fits ? "within" : "over", lim);
+}
+
+void vault_wipe_plan_json(FILE *fp, const char *device,
+                          const vault_wipe_plan_t *plan, int budget)
+{
+    fprintf(fp, "{\"event\":\"plan\",\"device\":");
+    vault_wipe_json_string(fp, device);
+    fprintf(fp, ",\"algorithm\":");
+    vault_wipe_json_string(fp, plan->schedule
+                               ? "custom"
+                               : vault_wipe_algorithm_name(plan->algorithm));
+    fprintf(fp, ",\"passes\":%d,\"verify\":%s,\"seconds\":%.0f,"
+            "\"budget\":%d,\"mbps\":%.0f,\"rate_source\":",
+            plan->passes, plan->verify ? "true" : "false", plan->seconds,
+            budget, plan->mbps);
+    vault_wipe_json_string(fp, plan->rate_source);
+    fprintf(fp, ",\"fits\":%s,\"changed\":%s}\n",
+            plan->fits ? "true" : "false", plan->changed ? "true" : "false");
+}
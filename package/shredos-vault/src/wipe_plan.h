@@ -0,0 +1,51 @@
+/*
+ * wipe_plan.h -- Time-Budgeted Wipe Planning
+ *
+ * Estimates how long each wipe schedule takes on a device, from its
+ * size, its write rate (measured with vault-wipe-bench and configured,
+ * or typical of its kind) and the passes it can offload, and picks the
+ * strongest schedule that finishes within a time budget: the dead
+ * man's switch may not get hours.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_PLAN_H
+#define VAULT_WIPE_PLAN_H
+
+#include "wipe.h"
+#include <stdio.h>
+
+typedef struct {
+    wipe_algorithm_t algorithm; /* to run */
+    const char *schedule;       /* the configured pass list if kept,
+                                 * NULL = the algorithm's passes */
+    int      passes;
+    int      verify;            /* kept, or dropped to fit */
+    double   seconds;           /* estimated */
+    double   mbps;              /* write rate the estimate assumes */
+    const char *rate_source;    /* "config" or the device's kind */
+    int      fits;              /* within the budget */
+    int      changed;           /* differs from what was configured */
+} vault_wipe_plan_t;
+
+/* Plan a wipe of bytes of the device described by caps, configured as
+ * algorithm (or params->schedule) with verify, within budget seconds.
+ * Weaker schedules are tried in turn, strongest first, then the same
+ * without verification; if nothing fits, the quickest is chosen.
+ * mbps is the measured write rate, 0 = caps->write_mbps. The drive's
+ * own erase is left as it is: nothing is quicker. */
+void vault_wipe_plan(vault_wipe_plan_t *plan, const vault_wipe_caps_t *caps,
+                     uint64_t bytes, wipe_algorithm_t algorithm, int verify,
+                     const vault_wipe_params_t *params, double mbps,
+                     int budget);
+
+/* "DoD Short 3-pass, verified, ~1h52m at 350 MB/s (ssd), within 2h" */
+void vault_wipe_plan_describe(const vault_wipe_plan_t *plan, int budget,
+                              char *buf, size_t len);
+
+/* The plan as a JSON line for the wipe report (wipe_stats.h). */
+void vault_wipe_plan_json(FILE *fp, const char *device,
+                          const vault_wipe_plan_t *plan, int budget);
+
+#endif /* VAULT_WIPE_PLAN_H */
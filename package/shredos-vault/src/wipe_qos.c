@@ -0,0 +1,93 @@
+/*
+ * wipe_qos.c -- Wipe I/O Throttle
+ *
+ * The rate adapts once per window, on the mean latency of the I/Os
+ * that completed in it: above the target it is cut by a quarter,
+ * below three quarters of the target it grows by a sixteenth of the
+ * cap. The cut is steep and the growth slow so that a busy host gets
+ * its latency back fast and the wipe creeps up on the limit again.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_qos.h"
+
+#include <string.h>
+
+#define QOS_MB          (1024.0 * 1024.0)
+#define QOS_BURST_NS    50000000ULL     /* credit an idle bucket keeps */
+#define QOS_WINDOW_NS   100000000ULL    /* latency averaging window */
+#define QOS_FLOOR_DIV   64              /* lowest rate, as cap / this */
+
+void vault_wipe_qos_init(vault_wipe_qos_t *q, double mbps, double latency_ms,
+                         uint64_t now)
+{
+    memset(q, 0, sizeof(*q));
+    vault_mutex_init(&q->lock);
+    q->cap = mbps * QOS_MB;
+    q->rate = q->cap;
+    q->tokens = q->rate * (double)QOS_BURST_NS / 1e9;
+    q->target_ns = latency_ms > 0 ? (uint64_t)(latency_ms * 1e6) : 0;
+    q->last_ns = now;
+    q->window_ns = now;
+}
+
+void vault_wipe_qos_destroy(vault_wipe_qos_t *q)
+{
+    vault_mutex_destroy(&q->lock);
+}
+
+uint64_t vault_wipe_qos_take(vault_wipe_qos_t *q, uint64_t len, uint64_t now)
+{
+    vault_mutex_lock(&q->lock);
+    if (now > q->last_ns) {
+        double burst = q->rate * (double)QOS_BURST_NS / 1e9;
+        q->tokens += q->rate * (double)(now - q->last_ns) / 1e9;
+        if (q->tokens > burst) q->tokens = burst;
+        q->last_ns = now;
+    }
+    /* Taken at once and paid off by waiting, so a chunk larger than
+     * the burst still goes through and callers queue up in order */
+    q->tokens -= (double)len;
+    uint64_t wait = q->tokens < 0 ? (uint64_t)(-q->tokens / q->rate * 1e9) : 0;
+    vault_mutex_unlock(&q->lock);
+    return wait;
+}
+
+void vault_wipe_qos_done(vault_wipe_qos_t *q, uint64_t lat, uint64_t now)
+{
+    if (q->target_ns == 0) return;
+
+    vault_mutex_lock(&q->lock);
+    q->win_sum += lat;
+    q->win_n++;
+    if (now - q->window_ns >= QOS_WINDOW_NS) {
+        q->lat_ns = q->win_sum / q->win_n;
+        if (q->hold) {
+            q->hold = 0;
+        } else if (q->lat_ns > q->target_ns) {
+            /* cap / 64, but never under 1 MB/s unless the cap is */
+            double floor = q->cap / QOS_FLOOR_DIV;
+            double low = q->cap < QOS_MB ? q->cap : QOS_MB;
+            if (floor < low) floor = low;
+            q->rate = q->rate * 0.75 > floor ? q->rate * 0.75 : floor;
+            q->cuts++;
+            q->hold = 1;
+        } else if (q->lat_ns < q->target_ns / 4 * 3) {
+            q->rate += q->cap / 16;
+            if (q->rate > q->cap) q->rate = q->cap;
+        }
+        q->window_ns = now;
+        q->win_sum = 0;
+        q->win_n = 0;
+    }
+    vault_mutex_unlock(&q->lock);
+}
+
+double vault_wipe_qos_mbps(vault_wipe_qos_t *q)
+{
+    vault_mutex_lock(&q->lock);
+    double r = q->rate / QOS_MB;
+    vault_mutex_unlock(&q->lock);
+    return r;
+}
@@ -0,0 +1,57 @@
+/*
+ * wipe_qos.h -- Wipe I/O Throttle
+ *
+ * A token bucket that caps the bytes a wipe moves per second, for
+ * sanitizing secondary drives on machines that stay in use. With a
+ * latency target the cap also follows the device: it is cut when the
+ * average completion latency rises above the target and grows back
+ * towards the configured cap once latency has settled below it.
+ *
+ * Every write and verification read of a device draws on one bucket,
+ * shared by all its stripes. The caller keeps the clock and does the
+ * waiting, so nothing here sleeps with the lock held.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_QOS_H
+#define VAULT_WIPE_QOS_H
+
+#include "platform.h"
+#include <stdint.h>
+
+typedef struct {
+    vault_mutex_t lock;
+    double   cap;               /* configured rate, bytes/s */
+    double   rate;              /* current rate, bytes/s */
+    double   tokens;            /* bytes that may be issued now; may go
+                                 * negative while a caller waits it off */
+    uint64_t last_ns;           /* tokens were last added */
+    uint64_t target_ns;         /* latency target, 0 = fixed rate */
+    uint64_t window_ns;         /* start of the current adapt window */
+    uint64_t win_sum;           /* completion latencies in the window */
+    uint64_t win_n;
+    uint64_t lat_ns;            /* mean latency of the last window */
+    int      hold;              /* skip a window after a cut, while the
+                                 * I/O issued before it drains */
+    uint64_t cuts;              /* times the rate was lowered */
+} vault_wipe_qos_t;
+
+/* Start a bucket for mbps MB/s, adapting to latency_ms (0 = fixed).
+ * now is the caller's monotonic clock in ns. */
+void vault_wipe_qos_init(vault_wipe_qos_t *q, double mbps, double latency_ms,
+                         uint64_t now);
+
+void vault_wipe_qos_destroy(vault_wipe_qos_t *q);
+
+/* Take len bytes ahead of an I/O. Returns how long, in ns, the caller
+ * must wait before issuing it; 0 = at once. */
+uint64_t vault_wipe_qos_take(vault_wipe_qos_t *q, uint64_t len, uint64_t now);
+
+/* Record an I/O that took lat ns to complete. */
+void vault_wipe_qos_done(vault_wipe_qos_t *q, uint64_t lat, uint64_t now);
+
+/* Current rate in MB/s. */
+double vault_wipe_qos_mbps(vault_wipe_qos_t *q);
+
+#endif /* VAULT_WIPE_QOS_H */
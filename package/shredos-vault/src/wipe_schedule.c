@@ -0,0 +1,219 @@
+/*
+ * wipe_schedule.c -- Wipe Pass Schedules
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_schedule.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ------------------------------------------------------------------ */
+/*  Built-in algorithms                                                */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    int     is_random;
+    size_t  pattern_len;
+    uint8_t pattern[3];
+} builtin_pass_t;
+
+/* Gutmann 35-pass */
+static const builtin_pass_t gutmann_passes[35] = {
+    {1,0,{0}}, {1,0,{0}}, {1,0,{0}}, {1,0,{0}},
+    {0,1,{0x55}}, {0,1,{0xAA}}, {0,3,{0x92,0x49,0x24}},
+    {0,3,{0x49,0x24,0x92}}, {0,3,{0x24,0x92,0x49}},
+    {0,1,{0x00}}, {0,1,{0x11}}, {0,1,{0x22}},
+    {0,1,{0x33}}, {0,1,{0x44}},
+    {0,1,{0x55}}, {0,1,{0x66}}, {0,1,{0x77}},
+    {0,1,{0x88}}, {0,1,{0x99}},
+    {0,1,{0xAA}}, {0,1,{0xBB}}, {0,1,{0xCC}},
+    {0,1,{0xDD}}, {0,1,{0xEE}},
+    {0,1,{0xFF}}, {0,3,{0x92,0x49,0x24}},
+    {0,3,{0x49,0x24,0x92}},
+    {0,3,{0x24,0x92,0x49}}, {0,3,{0x6D,0xB6,0xDB}},
+    {0,3,{0xB6,0xDB,0x6D}}, {0,3,{0xDB,0x6D,0xB6}},
+    {1,0,{0}}, {1,0,{0}}, {1,0,{0}}, {1,0,{0}}
+};
+
+/* DoD 5220.22-M 7-pass */
+static const builtin_pass_t dod_passes[7] = {
+    {0,1,{0x00}}, {0,1,{0xFF}}, {1,0,{0}},
+    {0,1,{0x00}}, {0,1,{0xFF}}, {1,0,{0}}, {1,0,{0}}
+};
+
+static const builtin_pass_t dod_short_passes[3] = {
+    {1,0,{0}}, {1,0,{0}}, {1,0,{0}}
+};
+
+static const builtin_pass_t random_passes[1] = { {1,0,{0}} };
+static const builtin_pass_t zero_passes[1] = { {0,1,{0x00}} };
+
+/* Store pat as p's pattern, cut to its shortest period, and class it. */
+static void set_pattern(vault_wipe_pass_t *p, const uint8_t *pat, size_t len)
+{
+    size_t period = len;
+    for (size_t n = 1; n < len; n++) {
+        if (len % n != 0) continue;
+        size_t i = n;
+        while (i < len && pat[i] == pat[i % n]) i++;
+        if (i == len) { period = n; break; }
+    }
+
+    memset(p, 0, sizeof(*p));
+    memcpy(p->pattern, pat, period);
+    p->pattern_len = period;
+    if (period > 1)
+        p->kind = VAULT_WIPE_PASS_TILE;
+    else
+        p->kind = pat[0] ? VAULT_WIPE_PASS_BYTE : VAULT_WIPE_PASS_ZERO;
+}
+
+static void set_random(vault_wipe_pass_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->kind = VAULT_WIPE_PASS_RANDOM;
+}
+
+int vault_wipe_schedule_builtin(vault_wipe_schedule_t *s,
+                                 wipe_algorithm_t alg)
+{
+    const builtin_pass_t *table;
+    int n;
+    switch (alg) {
+    case WIPE_GUTMANN:    table = gutmann_passes;   n = 35; break;
+    case WIPE_DOD_522022: table = dod_passes;       n = 7;  break;
+    case WIPE_DOD_SHORT:  table = dod_short_passes; n = 3;  break;
+    case WIPE_RANDOM:     table = random_passes;    n = 1;  break;
+    case WIPE_ZERO:       table = zero_passes;      n = 1;  break;
+    default:              return -1;
+    }
+
+    memset(s, 0, sizeof(*s));
+    for (int i = 0; i < n; i++) {
+        if (table[i].is_random)
+            set_random(&s->passes[i]);
+        else
+            set_pattern(&s->passes[i], table[i].pattern,
+                        table[i].pattern_len);
+    }
+    s->count = n;
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Custom schedules                                                   */
+/* ------------------------------------------------------------------ */
+
+/* FNV-1a over what each pass writes; never 0, which marks built-ins */
+static uint32_t schedule_id(const vault_wipe_schedule_t *s)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < s->count; i++) {
+        const vault_wipe_pass_t *p = &s->passes[i];
+        uint8_t bytes[2 + VAULT_WIPE_PATTERN_MAX];
+        bytes[0] = (uint8_t)p->kind;
+        bytes[1] = (uint8_t)p->pattern_len;
+        memcpy(bytes + 2, p->pattern, p->pattern_len);
+        for (size_t k = 0; k < 2 + p->pattern_len; k++)
+            h = (h ^ bytes[k]) * 16777619u;
+    }
+    return h ? h : 1;
+}
+
+/* Length of word if s starts with it, in any case; else 0. */
+static size_t match_word(const char *s, const char *word)
+{
+    size_t n = 0;
+    for (; word[n]; n++)
+        if (tolower((unsigned char)s[n]) != word[n]) return 0;
+    return n;
+}
+
+/* One pass, without its repeat count. Returns the text after it, or
+ * NULL if malformed. */
+static const char *parse_pass(const char *s, vault_wipe_pass_t *p)
+{
+    size_t n = match_word(s, "random");
+    if (n) {
+        set_random(p);
+        return s + n;
+    }
+    if ((n = match_word(s, "zero")) != 0) {
+        uint8_t zero = 0;
+        set_pattern(p, &zero, 1);
+        return s + n;
+    }
+    if (s[0] != '0' || (s[1] != 'x' && s[1] != 'X')) return NULL;
+    s += 2;
+
+    uint8_t pat[VAULT_WIPE_PATTERN_MAX];
+    n = 0;
+    while (isxdigit((unsigned char)s[0])) {
+        if (!isxdigit((unsigned char)s[1]) || n == sizeof(pat))
+            return NULL;
+        char hex[3] = { s[0], s[1], 0 };
+        pat[n++] = (uint8_t)strtoul(hex, NULL, 16);
+        s += 2;
+    }
+    if (n == 0) return NULL;
+    set_pattern(p, pat, n);
+    return s;
+}
+
+int vault_wipe_schedule_parse(vault_wipe_schedule_t *s, const char *spec)
+{
+    memset(s, 0, sizeof(*s));
+    const char *p = spec;
+
+    for (;;) {
+        while (isspace((unsigned char)*p)) p++;
+        vault_wipe_pass_t pass;
+        p = parse_pass(p, &pass);
+        if (!p) return -1;
+
+        long repeat = 1;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '*') {
+            char *end;
+            repeat = strtol(p + 1, &end, 10);
+            if (end == p + 1 || repeat < 1) return -1;
+            p = end;
+        }
+        if (repeat > VAULT_WIPE_SCHEDULE_MAX - s->count) return -1;
+        while (repeat-- > 0)
+            s->passes[s->count++] = pass;
+
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+        if (*p != ',') return -1;
+        p++;
+    }
+
+    s->id = schedule_id(s);
+    return s->count;
+}
+
+void vault_wipe_pass_describe(const vault_wipe_pass_t *p, int n, int total,
+                               char *buf, size_t len)
+{
+    int at = snprintf(buf, len, "Pass %d/%d: ", n, total);
+    if (at < 0 || (size_t)at >= len) return;
+
+    switch (p->kind) {
+    case VAULT_WIPE_PASS_RANDOM:
+        snprintf(buf + at, len - (size_t)at, "random");
+        break;
+    case VAULT_WIPE_PASS_ZERO:
+        snprintf(buf + at, len - (size_t)at, "zero");
+        break;
+    default:
+        at += snprintf(buf + at, len - (size_t)at, "0x");
+        for (size_t i = 0; i < p->pattern_len && (size_t)at < len; i++)
+            at += snprintf(buf + at, len - (size_t)at, "%02X", p->pattern[i]);
+        break;
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * wipe_schedule.h -- Wipe Pass Schedules
+ *
+ * Every algorithm the direct engine writes is a list of pass
+ * descriptors, and so is a custom wipe_schedule from vault.conf. Each
+ * descriptor says what a pass writes: a random keystream or a short
+ * repeating pattern. Patterns are reduced to their shortest period and
+ * classed as zero, one byte or a tile of several, which is what the
+ * engine picks its fill kernel and drive offload by.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_SCHEDULE_H
+#define VAULT_WIPE_SCHEDULE_H
+
+#include "config.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define VAULT_WIPE_SCHEDULE_MAX   64    /* passes per schedule */
+#define VAULT_WIPE_PATTERN_MAX    16    /* bytes per pattern period */
+
+typedef enum {
+    VAULT_WIPE_PASS_RANDOM = 0,   /* keystream, keyed per pass */
+    VAULT_WIPE_PASS_ZERO,         /* zero bytes */
+    VAULT_WIPE_PASS_BYTE,         /* one byte repeated */
+    VAULT_WIPE_PASS_TILE          /* a 2-16 byte pattern repeated */
+} vault_wipe_pass_kind_t;
+
+typedef struct {
+    vault_wipe_pass_kind_t kind;
+    size_t  pattern_len;        /* shortest period, 0 for random */
+    uint8_t pattern[VAULT_WIPE_PATTERN_MAX];
+} vault_wipe_pass_t;
+
+typedef struct {
+    vault_wipe_pass_t passes[VAULT_WIPE_SCHEDULE_MAX];
+    int      count;
+    uint32_t id;                /* fingerprint of a custom schedule,
+                                 * 0 for an algorithm's own */
+} vault_wipe_schedule_t;
+
+/* The passes the direct engine writes for alg. Returns -1 for
+ * algorithms that are not a list of passes (WIPE_HW_ERASE,
+ * WIPE_VERIFY_ONLY). */
+int vault_wipe_schedule_builtin(vault_wipe_schedule_t *s,
+                                 wipe_algorithm_t alg);
+
+/* Parse a wipe_schedule list: comma-separated passes, each "random",
+ * "zero" or a pattern of 1 to 16 bytes in hex ("0x55", "0x924924"),
+ * optionally followed by "*N" to repeat it N times. Returns the number
+ * of passes, or -1 if the list is empty, malformed or longer than
+ * VAULT_WIPE_SCHEDULE_MAX. */
+int vault_wipe_schedule_parse(vault_wipe_schedule_t *s, const char *spec);
+
+/* "Pass n/total: random", "...: zero" or "...: 0x924924". */
+void vault_wipe_pass_describe(const vault_wipe_pass_t *p, int n, int total,
+                               char *buf, size_t len);
+
+#endif /* VAULT_WIPE_SCHEDULE_H */
@@ -0,0 +1,162 @@
+/*
+ * wipe_stats.c -- Wipe Telemetry
+ *
+ * Histograms report count, mean, p50/p90/p99/p99.9 and max in
+ * microseconds, followed by the non-empty buckets as [upper_us, count]
+ * pairs so the full distribution can be rebuilt and merged offline.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_stats.h"
+
+#include <string.h>
+
+/* ------------------------------------------------------------------ */
+/*  Histogram                                                          */
+/* ------------------------------------------------------------------ */
+
+#define SUB_BITS 3                      /* log2(VAULT_WIPE_HIST_SUB) */
+
+static int msb64(uint64_t v)
+{
+    int n = 0;
+    while (v >>= 1) n++;
+    return n;
+}
+
+static int hist_index(uint64_t ns)
+{
+    if (ns < VAULT_WIPE_HIST_SUB) return (int)ns;
+    int msb = msb64(ns);
+    int idx = (msb - SUB_BITS + 1) * VAULT_WIPE_HIST_SUB +
+              (int)(ns >> (msb - SUB_BITS)) - VAULT_WIPE_HIST_SUB;
+    return idx < VAULT_WIPE_HIST_BUCKETS ? idx : VAULT_WIPE_HIST_BUCKETS - 1;
+}
+
+/* Largest value that lands in bucket idx */
+static uint64_t hist_upper(int idx)
+{
+    if (idx < VAULT_WIPE_HIST_SUB) return (uint64_t)idx;
+    int shift = idx / VAULT_WIPE_HIST_SUB - 1;
+    uint64_t m = (uint64_t)(idx % VAULT_WIPE_HIST_SUB + VAULT_WIPE_HIST_SUB);
+    return ((m + 1) << shift) - 1;
+}
+
+void vault_wipe_hist_add(vault_wipe_hist_t *h, uint64_t ns)
+{
+    h->count[hist_index(ns)]++;
+    h->n++;
+    h->sum_ns += ns;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+uint64_t vault_wipe_hist_quantile(const vault_wipe_hist_t *h, double q)
+{
+    if (h->n == 0) return 0;
+    uint64_t want = (uint64_t)(q * (double)h->n);
+    if (want >= h->n) want = h->n - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < VAULT_WIPE_HIST_BUCKETS; i++) {
+        seen += h->count[i];
+        if (seen > want) {
+            uint64_t up = hist_upper(i);
+            return up < h->max_ns ? up : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+static void hist_merge(vault_wipe_hist_t *dst, const vault_wipe_hist_t *src)
+{
+    for (int i = 0; i < VAULT_WIPE_HIST_BUCKETS; i++)
+        dst->count[i] += src->count[i];
+    dst->n               += src->n;
+    dst->sum_ns          += src->sum_ns;
+    if (src->max_ns > dst->max_ns) dst->max_ns = src->max_ns;
+}
+
+void vault_wipe_stats_merge(vault_wipe_stats_t *dst,
+                             const vault_wipe_stats_t *src)
+{
+    hist_merge(&dst->write_lat, &src->write_lat);
+    hist_merge(&dst->read_lat, &src->read_lat);
+    dst->fill_ns         += src->fill_ns;
+    dst->write_ns        += src->write_ns;
+    dst->verify_ns       += src->verify_ns;
+    dst->throttle_ns     += src->throttle_ns;
+    dst->elapsed_ns      += src->elapsed_ns;
+    dst->bytes_written   += src->bytes_written;
+    dst->bytes_verified  += src->bytes_verified;
+    dst->bytes_offloaded += src->bytes_offloaded;
+    dst->writes          += src->writes;
+    dst->salvaged        += src->salvaged;
+    dst->gen_stalls      += src->gen_stalls;
+    dst->io_stalls       += src->io_stalls;
+}
+
+/* ------------------------------------------------------------------ */
+/*  JSON                                                               */
+/* ------------------------------------------------------------------ */
+
+void vault_wipe_json_string(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (const unsigned char *p = (const unsigned char *)(str ? str : "");
+         *p; p++) {
+        if (*p == '"' || *p == '\\') fprintf(fp, "\\%c", *p);
+        else if (*p < 0x20) fprintf(fp, "\\u%04x", *p);
+        else fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+static void hist_json(FILE *fp, const char *name, const vault_wipe_hist_t *h)
+{
+    fprintf(fp, "\"%s\":{\"count\":%llu", name, (unsigned long long)h->n);
+    if (h->n > 0) {
+        fprintf(fp, ",\"mean\":%.1f,\"p50\":%.1f,\"p90\":%.1f,"
+                "\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f",
+                (double)h->sum_ns / (double)h->n / 1e3,
+                (double)vault_wipe_hist_quantile(h, 0.5) / 1e3,
+                (double)vault_wipe_hist_quantile(h, 0.9) / 1e3,
+                (double)vault_wipe_hist_quantile(h, 0.99) / 1e3,
+                (double)vault_wipe_hist_quantile(h, 0.999) / 1e3,
+                (double)h->max_ns / 1e3);
+    }
+    fprintf(fp, ",\"buckets\":[");
+    int first = 1;
+    for (int i = 0; i < VAULT_WIPE_HIST_BUCKETS; i++) {
+        if (!h->count[i]) continue;
+        fprintf(fp, "%s[%.3f,%llu]", first ? "" : ",",
+                (double)hist_upper(i) / 1e3,
+                (unsigned long long)h->count[i]);
+        first = 0;
+    }
+    fprintf(fp, "]}");
+}
+
+void vault_wipe_stats_json(FILE *fp, const vault_wipe_stats_t *s)
+{
+    double secs = (double)s->elapsed_ns / 1e9;
+    fprintf(fp, "\"seconds\":%.3f,\"bytes_written\":%llu,"
+            "\"bytes_verified\":%llu,\"bytes_offloaded\":%llu,"
+            "\"mbps\":%.1f,"
+            "\"writes\":%llu,\"salvaged\":%llu,"
+            "\"fill_seconds\":%.3f,\"write_seconds\":%.3f,"
+            "\"verify_seconds\":%.3f,\"throttle_seconds\":%.3f,"
+            "\"gen_stalls\":%llu,\"io_stalls\":%llu,",
+            secs, (unsigned long long)s->bytes_written,
+            (unsigned long long)s->bytes_verified,
+            (unsigned long long)s->bytes_offloaded,
+            secs > 0 ? (double)s->bytes_written / secs / (1024.0 * 1024.0) : 0,
+            (unsigned long long)s->writes,
+            (unsigned long long)s->salvaged,
+            (double)s->fill_ns / 1e9, (double)s->write_ns / 1e9,
+            (double)s->verify_ns / 1e9, (double)s->throttle_ns / 1e9,
+            (unsigned long long)s->gen_stalls,
+            (unsigned long long)s->io_stalls);
+    hist_json(fp, "write_latency_us", &s->write_lat);
+    fputc(',', fp);
+    hist_json(fp, "read_latency_us", &s->read_lat);
+}
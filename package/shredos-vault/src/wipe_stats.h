@@ -0,0 +1,67 @@
+/*
+ * wipe_stats.h -- Wipe Telemetry
+ *
+ * Per-pass counters for the direct engine: I/O latency histograms,
+ * time spent generating data versus writing it, stall counts and
+ * throughput. Every thread of a pass (stripe writer, generator,
+ * read-back) fills its own copy and the pass merges them once the
+ * threads are joined, so nothing on the I/O path takes a lock.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_STATS_H
+#define VAULT_WIPE_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Log-linear buckets: values below VAULT_WIPE_HIST_SUB ns get one
+ * bucket each, every doubling above that is split VAULT_WIPE_HIST_SUB
+ * ways (12.5% resolution). The top bucket, from about 8.6 s, also
+ * takes anything longer. */
+#define VAULT_WIPE_HIST_SUB      8
+#define VAULT_WIPE_HIST_OCTAVES  32
+#define VAULT_WIPE_HIST_BUCKETS  (VAULT_WIPE_HIST_SUB * VAULT_WIPE_HIST_OCTAVES)
+
+typedef struct {
+    uint64_t count[VAULT_WIPE_HIST_BUCKETS];
+    uint64_t n;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+} vault_wipe_hist_t;
+
+typedef struct {
+    vault_wipe_hist_t write_lat;    /* per write, submit to completion */
+    vault_wipe_hist_t read_lat;     /* per verification read */
+    uint64_t fill_ns;               /* generating pass data */
+    uint64_t write_ns;              /* in write calls or waiting on them */
+    uint64_t verify_ns;             /* reading back and comparing */
+    uint64_t throttle_ns;           /* held back by the rate cap */
+    uint64_t elapsed_ns;            /* wall time of the pass */
+    uint64_t bytes_written;
+    uint64_t bytes_verified;
+    uint64_t bytes_offloaded;       /* zeroed by the device itself */
+    uint64_t writes;
+    uint64_t salvaged;              /* writes redone piecewise */
+    uint64_t gen_stalls;
+    uint64_t io_stalls;
+} vault_wipe_stats_t;
+
+/* Record one latency sample. */
+void vault_wipe_hist_add(vault_wipe_hist_t *h, uint64_t ns);
+
+/* Upper bound, in ns, of the bucket holding quantile q (0..1). */
+uint64_t vault_wipe_hist_quantile(const vault_wipe_hist_t *h, double q);
+
+/* Add src's counters to dst. */
+void vault_wipe_stats_merge(vault_wipe_stats_t *dst,
+                             const vault_wipe_stats_t *src);
+
+/* Write s as JSON object members (no braces), for a report line. */
+void vault_wipe_stats_json(FILE *fp, const vault_wipe_stats_t *s);
+
+/* Write str as a quoted JSON string. */
+void vault_wipe_json_string(FILE *fp, const char *str);
+
+#endif /* VAULT_WIPE_STATS_H */
@@ -0,0 +1,578 @@
+/*
+ * wipe_stream.c -- Keyed Random Stream for Wipe Passes
+ *
+ * Counter-mode generators keyed once per pass:
+ *   AES-256-CTR   -- AES-NI, 8 blocks in flight
+ *   ChaCha20      -- AVX2 (8 blocks), SSE2 / NEON (4 blocks), portable C
+ *
+ * Block i of the keystream is a pure function of (key, nonce, i), so a
+ * chunk at any device offset can be produced without touching the
+ * chunks before it. The implementation is picked at init time from the
+ * CPU features reported at runtime.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#include "wipe_stream.h"
+#include "platform.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WIPE_STREAM_X86 1
+#include <immintrin.h>
+#define WIPE_STREAM_TARGET(t) __attribute__((target(t)))
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define WIPE_STREAM_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define CHACHA_BLOCK 64
+#define AES_BLOCK    16
+
+static inline uint32_t load32_le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32_le(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* ------------------------------------------------------------------ */
+/*  ChaCha20 -- portable                                               */
+/* ------------------------------------------------------------------ */
+
+/*
+ * Original 64-bit counter / 64-bit nonce layout: words 12-13 hold the
+ * block counter, so a single key covers 2^70 bytes.
+ */
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define CHACHA_QR(a, b, c, d)                   \
+    do {                                        \
+        a += b; d ^= a; d = ROTL32(d, 16);      \
+        c += d; b ^= c; b = ROTL32(b, 12);      \
+        a += b; d ^= a; d = ROTL32(d, 8);       \
+        c += d; b ^= c; b = ROTL32(b, 7);       \
+    } while (0)
+
+static void chacha_block_scalar(const uint32_t in[16], uint64_t block,
+                                uint8_t out[CHACHA_BLOCK])
+{
+    uint32_t x[16], j[16];
+
+    memcpy(j, in, sizeof(j));
+    j[12] = (uint32_t)block;
+    j[13] = (uint32_t)(block >> 32);
+    memcpy(x, j, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        CHACHA_QR(x[0], x[4], x[8],  x[12]);
+        CHACHA_QR(x[1], x[5], x[9],  x[13]);
+        CHACHA_QR(x[2], x[6], x[10], x[14]);
+        CHACHA_QR(x[3], x[7], x[11], x[15]);
+        CHACHA_QR(x[0], x[5], x[10], x[15]);
+        CHACHA_QR(x[1], x[6], x[11], x[12]);
+        CHACHA_QR(x[2], x[7], x[8],  x[13]);
+        CHACHA_QR(x[3], x[4], x[9],  x[14]);
+    }
+
+    for (int i = 0; i < 16; i++)
+        store32_le(out + 4 * i, x[i] + j[i]);
+}
+
+static void chacha_blocks_scalar(const vault_wipe_stream_t *s, uint64_t block,
+                                 uint8_t *out, size_t nblocks)
+{
+    for (size_t i = 0; i < nblocks; i++)
+        chacha_block_scalar(s->chacha, block + i, out + i * CHACHA_BLOCK);
+}
+
+/* ------------------------------------------------------------------ */
+/*  ChaCha20 -- SSE2 / AVX2                                            */
+/* ------------------------------------------------------------------ */
+
+/*
+ * Vectorised across blocks: vector word i holds state word i of 4 (or 8)
+ * consecutive blocks, so the rounds are plain lane-wise arithmetic and a
+ * 4x4 transpose at the end puts each block's bytes back in order.
+ */
+
+#ifdef WIPE_STREAM_X86
+
+#define SSE_ROTL(v, n) \
+    _mm_or_si128(_mm_slli_epi32((v), (n)), _mm_srli_epi32((v), 32 - (n)))
+
+#define SSE_QR(a, b, c, d)                                               \
+    do {                                                                 \
+        a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = SSE_ROTL(d, 16); \
+        c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL(b, 12); \
+        a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = SSE_ROTL(d, 8);  \
+        c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL(b, 7);  \
+    } while (0)
+
+WIPE_STREAM_TARGET("sse2")
+static void chacha_4blocks_sse2(const uint32_t in[16], uint64_t block,
+                                uint8_t *out)
+{
+    __m128i x[16], j[16];
+
+    for (int i = 0; i < 16; i++)
+        j[i] = _mm_set1_epi32((int)in[i]);
+
+    uint64_t c0 = block, c1 = block + 1, c2 = block + 2, c3 = block + 3;
+    j[12] = _mm_set_epi32((int)(uint32_t)c3, (int)(uint32_t)c2,
+                          (int)(uint32_t)c1, (int)(uint32_t)c0);
+    j[13] = _mm_set_epi32((int)(uint32_t)(c3 >> 32), (int)(uint32_t)(c2 >> 32),
+                          (int)(uint32_t)(c1 >> 32), (int)(uint32_t)(c0 >> 32));
+    memcpy(x, j, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        SSE_QR(x[0], x[4], x[8],  x[12]);
+        SSE_QR(x[1], x[5], x[9],  x[13]);
+        SSE_QR(x[2], x[6], x[10], x[14]);
+        SSE_QR(x[3], x[7], x[11], x[15]);
+        SSE_QR(x[0], x[5], x[10], x[15]);
+        SSE_QR(x[1], x[6], x[11], x[12]);
+        SSE_QR(x[2], x[7], x[8],  x[13]);
+        SSE_QR(x[3], x[4], x[9],  x[14]);
+    }
+
+    for (int i = 0; i < 16; i++)
+        x[i] = _mm_add_epi32(x[i], j[i]);
+
+    for (int g = 0; g < 4; g++) {
+        __m128i t0 = _mm_unpacklo_epi32(x[4 * g],     x[4 * g + 1]);
+        __m128i t1 = _mm_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+        __m128i t2 = _mm_unpackhi_epi32(x[4 * g],     x[4 * g + 1]);
+        __m128i t3 = _mm_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+        uint8_t *o = out + 16 * g;
+        _mm_storeu_si128((__m128i *)(o),       _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)(o + 64),  _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)(o + 128), _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128((__m128i *)(o + 192), _mm_unpackhi_epi64(t2, t3));
+    }
+}
+
+WIPE_STREAM_TARGET("sse2")
+static void chacha_blocks_sse2(const vault_wipe_stream_t *s, uint64_t block,
+                               uint8_t *out, size_t nblocks)
+{
+    while (nblocks >= 4) {
+        chacha_4blocks_sse2(s->chacha, block, out);
+        block += 4;
+        out += 4 * CHACHA_BLOCK;
+        nblocks -= 4;
+    }
+    chacha_blocks_scalar(s, block, out, nblocks);
+}
+
+#define AVX_ROTL(v, n) \
+    _mm256_or_si256(_mm256_slli_epi32((v), (n)), _mm256_srli_epi32((v), 32 - (n)))
+
+#define AVX_QR(a, b, c, d)                                                      \
+    do {                                                                        \
+        a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = AVX_ROTL(d, 16); \
+        c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL(b, 12); \
+        a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = AVX_ROTL(d, 8);  \
+        c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL(b, 7);  \
+    } while (0)
+
+WIPE_STREAM_TARGET("avx2")
+static void chacha_8blocks_avx2(const uint32_t in[16], uint64_t block,
+                                uint8_t *out)
+{
+    __m256i x[16], j[16];
+    uint32_t lo[8], hi[8];
+
+    for (int i = 0; i < 16; i++)
+        j[i] = _mm256_set1_epi32((int)in[i]);
+
+    for (int i = 0; i < 8; i++) {
+        lo[i] = (uint32_t)(block + (uint64_t)i);
+        hi[i] = (uint32_t)((block + (uint64_t)i) >> 32);
+    }
+    j[12] = _mm256_loadu_si256((const __m256i *)lo);
+    j[13] = _mm256_loadu_si256((const __m256i *)hi);
+    memcpy(x, j, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        AVX_QR(x[0], x[4], x[8],  x[12]);
+        AVX_QR(x[1], x[5], x[9],  x[13]);
+        AVX_QR(x[2], x[6], x[10], x[14]);
+        AVX_QR(x[3], x[7], x[11], x[15]);
+        AVX_QR(x[0], x[5], x[10], x[15]);
+        AVX_QR(x[1], x[6], x[11], x[12]);
+        AVX_QR(x[2], x[7], x[8],  x[13]);
+        AVX_QR(x[3], x[4], x[9],  x[14]);
+    }
+
+    for (int i = 0; i < 16; i++)
+        x[i] = _mm256_add_epi32(x[i], j[i]);
+
+    /* Unpacks stay within 128-bit halves: the low half transposes
+     * blocks 0-3 and the high half blocks 4-7. */
+    for (int g = 0; g < 4; g++) {
+        __m256i t0 = _mm256_unpacklo_epi32(x[4 * g],     x[4 * g + 1]);
+        __m256i t1 = _mm256_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+        __m256i t2 = _mm256_unpackhi_epi32(x[4 * g],     x[4 * g + 1]);
+        __m256i t3 = _mm256_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+        __m256i r[4] = {
+            _mm256_unpacklo_epi64(t0, t1), _mm256_unpackhi_epi64(t0, t1),
+            _mm256_unpacklo_epi64(t2, t3), _mm256_unpackhi_epi64(t2, t3),
+        };
+        uint8_t *o = out + 16 * g;
+        for (int b = 0; b < 4; b++) {
+            _mm_storeu_si128((__m128i *)(o + 64 * b),
+                             _mm256_castsi256_si128(r[b]));
+            _mm_storeu_si128((__m128i *)(o + 64 * (b + 4)),
+                             _mm256_extracti128_si256(r[b], 1));
+        }
+    }
+}
+
+WIPE_STREAM_TARGET("avx2")
+static void chacha_blocks_avx2(const vault_wipe_stream_t *s, uint64_t block,
+                               uint8_t *out, size_t nblocks)
+{
+    while (nblocks >= 8) {
+        chacha_8blocks_avx2(s->chacha, block, out);
+        block += 8;
+        out += 8 * CHACHA_BLOCK;
+        nblocks -= 8;
+    }
+    chacha_blocks_scalar(s, block, out, nblocks);
+}
+
+#endif /* WIPE_STREAM_X86 */
+
+/* ------------------------------------------------------------------ */
+/*  ChaCha20 -- NEON                                                   */
+/* ------------------------------------------------------------------ */
+
+#ifdef WIPE_STREAM_NEON
+
+#define NEON_ROTL(v, n) vsriq_n_u32(vshlq_n_u32((v), (n)), (v), 32 - (n))
+
+#define NEON_QR(a, b, c, d)                                           \
+    do {                                                              \
+        a = vaddq_u32(a, b); d = veorq_u32(d, a); d = NEON_ROTL(d, 16); \
+        c = vaddq_u32(c, d); b = veorq_u32(b, c); b = NEON_ROTL(b, 12); \
+        a = vaddq_u32(a, b); d = veorq_u32(d, a); d = NEON_ROTL(d, 8);  \
+        c = vaddq_u32(c, d); b = veorq_u32(b, c); b = NEON_ROTL(b, 7);  \
+    } while (0)
+
+static void chacha_4blocks_neon(const uint32_t in[16], uint64_t block,
+                                uint8_t *out)
+{
+    uint32x4_t x[16], j[16];
+    uint32_t lo[4], hi[4];
+
+    for (int i = 0; i < 16; i++)
+        j[i] = vdupq_n_u32(in[i]);
+
+    for (int i = 0; i < 4; i++) {
+        lo[i] = (uint32_t)(block + (uint64_t)i);
+        hi[i] = (uint32_t)((block + (uint64_t)i) >> 32);
+    }
+    j[12] = vld1q_u32(lo);
+    j[13] = vld1q_u32(hi);
+    memcpy(x, j, sizeof(x));
+
+    for (int i = 0; i < 10; i++) {
+        NEON_QR(x[0], x[4], x[8],  x[12]);
+        NEON_QR(x[1], x[5], x[9],  x[13]);
+        NEON_QR(x[2], x[6], x[10], x[14]);
+        NEON_QR(x[3], x[7], x[11], x[15]);
+        NEON_QR(x[0], x[5], x[10], x[15]);
+        NEON_QR(x[1], x[6], x[11], x[12]);
+        NEON_QR(x[2], x[7], x[8],  x[13]);
+        NEON_QR(x[3], x[4], x[9],  x[14]);
+    }
+
+    for (int i = 0; i < 16; i++)
+        x[i] = vaddq_u32(x[i], j[i]);
+
+    for (int g = 0; g < 4; g++) {
+        uint32x4x2_t ab = vtrnq_u32(x[4 * g],     x[4 * g + 1]);
+        uint32x4x2_t cd = vtrnq_u32(x[4 * g + 2], x[4 * g + 3]);
+        uint8_t *o = out + 16 * g;
+        vst1q_u32((uint32_t *)(o),
+                  vcombine_u32(vget_low_u32(ab.val[0]),  vget_low_u32(cd.val[0])));
+        vst1q_u32((uint32_t *)(o + 64),
+                  vcombine_u32(vget_low_u32(ab.val[1]),  vget_low_u32(cd.val[1])));
+        vst1q_u32((uint32_t *)(o + 128),
+                  vcombine_u32(vget_high_u32(ab.val[0]), vget_high_u32(cd.val[0])));
+        vst1q_u32((uint32_t *)(o + 192),
+                  vcombine_u32(vget_high_u32(ab.val[1]), vget_high_u32(cd.val[1])));
+    }
+}
+
+static void chacha_blocks_neon(const vault_wipe_stream_t *s, uint64_t block,
+                               uint8_t *out, size_t nblocks)
+{
+    while (nblocks >= 4) {
+        chacha_4blocks_neon(s->chacha, block, out);
+        block += 4;
+        out += 4 * CHACHA_BLOCK;
+        nblocks -= 4;
+    }
+    chacha_blocks_scalar(s, block, out, nblocks);
+}
+
+#endif /* WIPE_STREAM_NEON */
+
+/* ------------------------------------------------------------------ */
+/*  AES-256-CTR -- AES-NI                                              */
+/* ------------------------------------------------------------------ */
+
+/*
+ * Counter block = nonce (high 64 bits) || block index (low 64 bits).
+ * Eight independent blocks are kept in flight to cover the aesenc
+ * latency; on AES-NI parts this outruns ChaCha20 even with AVX2.
+ */
+
+#ifdef WIPE_STREAM_X86
+
+WIPE_STREAM_TARGET("aes,sse2")
+static __m128i aes256_expand_a(__m128i k, __m128i assist)
+{
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    return _mm_xor_si128(k, assist);
+}
+
+WIPE_STREAM_TARGET("aes,sse2")
+static __m128i aes256_expand_b(__m128i prev, __m128i k)
+{
+    __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(prev, 0), 0xaa);
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    return _mm_xor_si128(k, assist);
+}
+
+#define AES256_ROUND_A(i, rcon) \
+    rk[i] = aes256_expand_a(rk[(i) - 2], _mm_aeskeygenassist_si128(rk[(i) - 1], rcon))
+#define AES256_ROUND_B(i) \
+    rk[i] = aes256_expand_b(rk[(i) - 1], rk[(i) - 2])
+
+WIPE_STREAM_TARGET("aes,sse2")
+static void aes256_key_expand_aesni(const uint8_t key[32], uint8_t out[240])
+{
+    __m128i rk[15];
+
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    rk[1] = _mm_loadu_si128((const __m128i *)(key + 16));
+    AES256_ROUND_A(2,  0x01); AES256_ROUND_B(3);
+    AES256_ROUND_A(4,  0x02); AES256_ROUND_B(5);
+    AES256_ROUND_A(6,  0x04); AES256_ROUND_B(7);
+    AES256_ROUND_A(8,  0x08); AES256_ROUND_B(9);
+    AES256_ROUND_A(10, 0x10); AES256_ROUND_B(11);
+    AES256_ROUND_A(12, 0x20); AES256_ROUND_B(13);
+    AES256_ROUND_A(14, 0x40);
+
+    for (int i = 0; i < 15; i++)
+        _mm_storeu_si128((__m128i *)(out + 16 * i), rk[i]);
+    vault_secure_memzero(rk, sizeof(rk));
+}
+
+WIPE_STREAM_TARGET("aes,sse2")
+static void aes_ctr_blocks_aesni(const vault_wipe_stream_t *s, uint64_t block,
+                                 uint8_t *out, size_t nblocks)
+{
+    __m128i rk[15];
+
+    for (int i = 0; i < 15; i++)
+        rk[i] = _mm_loadu_si128((const __m128i *)(s->aes_rk + 16 * i));
+
+    while (nblocks >= 8) {
+        __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+#define AES_CTR(i) \
+        _mm_xor_si128(_mm_set_epi64x((long long)s->nonce, (long long)(block + (i))), rk[0])
+        b0 = AES_CTR(0); b1 = AES_CTR(1); b2 = AES_CTR(2); b3 = AES_CTR(3);
+        b4 = AES_CTR(4); b5 = AES_CTR(5); b6 = AES_CTR(6); b7 = AES_CTR(7);
+#undef AES_CTR
+
+        for (int r = 1; r < 14; r++) {
+            __m128i k = rk[r];
+            b0 = _mm_aesenc_si128(b0, k); b1 = _mm_aesenc_si128(b1, k);
+            b2 = _mm_aesenc_si128(b2, k); b3 = _mm_aesenc_si128(b3, k);
+            b4 = _mm_aesenc_si128(b4, k); b5 = _mm_aesenc_si128(b5, k);
+            b6 = _mm_aesenc_si128(b6, k); b7 = _mm_aesenc_si128(b7, k);
+        }
+
+        __m128i *o = (__m128i *)out;
+        _mm_storeu_si128(o + 0, _mm_aesenclast_si128(b0, rk[14]));
+        _mm_storeu_si128(o + 1, _mm_aesenclast_si128(b1, rk[14]));
+        _mm_storeu_si128(o + 2, _mm_aesenclast_si128(b2, rk[14]));
+        _mm_storeu_si128(o + 3, _mm_aesenclast_si128(b3, rk[14]));
+        _mm_storeu_si128(o + 4, _mm_aesenclast_si128(b4, rk[14]));
+        _mm_storeu_si128(o + 5, _mm_aesenclast_si128(b5, rk[14]));
+        _mm_storeu_si128(o + 6, _mm_aesenclast_si128(b6, rk[14]));
+        _mm_storeu_si128(o + 7, _mm_aesenclast_si128(b7, rk[14]));
+        block += 8;
+        out += 8 * AES_BLOCK;
+        nblocks -= 8;
+    }
+
+    for (; nblocks > 0; nblocks--, block++, out += AES_BLOCK) {
+        __m128i b = _mm_xor_si128(
+            _mm_set_epi64x((long long)s->nonce, (long long)block), rk[0]);
+        for (int r = 1; r < 14; r++)
+            b = _mm_aesenc_si128(b, rk[r]);
+        _mm_storeu_si128((__m128i *)out, _mm_aesenclast_si128(b, rk[14]));
+    }
+
+    vault_secure_memzero(rk, sizeof(rk));
+}
+
+#endif /* WIPE_STREAM_X86 */
+
+/* ------------------------------------------------------------------ */
+/*  Dispatch                                                           */
+/* ------------------------------------------------------------------ */
+
+static int cpu_has_aesni(void)
+{
+#ifdef WIPE_STREAM_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse2");
+#else
+    return 0;
+#endif
+}
+
+static void select_chacha(vault_wipe_stream_t *s)
+{
+    s->blocks = chacha_blocks_scalar;
+    s->impl   = "chacha20/c";
+
+#if defined(WIPE_STREAM_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        s->blocks = chacha_blocks_avx2;
+        s->impl   = "chacha20/avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        s->blocks = chacha_blocks_sse2;
+        s->impl   = "chacha20/sse2";
+    }
+#elif defined(WIPE_STREAM_NEON)
+    s->blocks = chacha_blocks_neon;
+    s->impl   = "chacha20/neon";
+#endif
+}
+
+int vault_wipe_stream_init(vault_wipe_stream_t *s, wipe_rng_t rng,
+                            const uint8_t seed[VAULT_WIPE_STREAM_SEED_LEN])
+{
+    if (!s) return -1;
+    memset(s, 0, sizeof(*s));
+
+    if (rng == WIPE_RNG_AUTO)
+        rng = cpu_has_aesni() ? WIPE_RNG_AES_CTR : WIPE_RNG_CHACHA20;
+
+    /* Without AES-NI a table-driven AES would be slower than ChaCha20 */
+    if (rng == WIPE_RNG_AES_CTR && !cpu_has_aesni())
+        rng = WIPE_RNG_CHACHA20;
+
+    s->rng = rng;
+
+    switch (rng) {
+    case WIPE_RNG_KERNEL:
+        s->impl       = "kernel";
+        s->block_size = 1;
+        return 0;
+
+    case WIPE_RNG_AES_CTR:
+#ifdef WIPE_STREAM_X86
+        if (!seed) return -1;
+        aes256_key_expand_aesni(seed, s->aes_rk);
+        memcpy(&s->nonce, seed + 32, sizeof(s->nonce));
+        s->blocks     = aes_ctr_blocks_aesni;
+        s->impl       = "aes-256-ctr/aesni";
+        s->block_size = AES_BLOCK;
+        return 0;
+#else
+        return -1;
+#endif
+
+    case WIPE_RNG_CHACHA20:
+    default:
+        if (!seed) return -1;
+        s->rng = WIPE_RNG_CHACHA20;
+        /* "expand 32-byte k" */
+        s->chacha[0] = 0x61707865;
+        s->chacha[1] = 0x3320646e;
+        s->chacha[2] = 0x79622d32;
+        s->chacha[3] = 0x6b206574;
+        for (int i = 0; i < 8; i++)
+            s->chacha[4 + i] = load32_le(seed + 4 * i);
+        s->chacha[14] = load32_le(seed + 32);
+        s->chacha[15] = load32_le(seed + 36);
+        select_chacha(s);
+        s->block_size = CHACHA_BLOCK;
+        return 0;
+    }
+}
+
+int vault_wipe_stream_generate(const vault_wipe_stream_t *s, uint64_t offset,
+                                uint8_t *buf, size_t len)
+{
+    uint8_t tmp[CHACHA_BLOCK];
+
+    if (!s || !buf) return -1;
+    if (len == 0) return 0;
+    if (s->rng == WIPE_RNG_KERNEL)
+        return vault_platform_random(buf, len);
+
+    size_t   bs    = s->block_size;
+    uint64_t block = offset / bs;
+    size_t   skip  = (size_t)(offset % bs);
+
+    /* Leading partial block */
+    if (skip) {
+        size_t n = bs - skip;
+        if (n > len) n = len;
+        s->blocks(s, block, tmp, 1);
+        memcpy(buf, tmp + skip, n);
+        buf += n;
+        len -= n;
+        block++;
+    }
+
+    size_t whole = len / bs;
+    if (whole) {
+        s->blocks(s, block, buf, whole);
+        buf += whole * bs;
+        len -= whole * bs;
+        block += whole;
+    }
+
+    /* Trailing partial block */
+    if (len) {
+        s->blocks(s, block, tmp, 1);
+        memcpy(buf, tmp, len);
+    }
+
+    vault_secure_memzero(tmp, sizeof(tmp));
+    return 0;
+}
+
+void vault_wipe_stream_destroy(vault_wipe_stream_t *s)
+{
+    if (!s) return;
+    vault_secure_memzero(s, sizeof(*s));
+}
@@ -0,0 +1,54 @@
+/*
+ * wipe_stream.h -- Keyed Random Stream for Wipe Passes
+ *
+ * Expands a per-pass seed from vault_platform_random() into a
+ * cryptographically strong keystream in userspace, so random passes
+ * are not bound by the kernel RNG.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_STREAM_H
+#define VAULT_WIPE_STREAM_H
+
+#include "config.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* Seed: 32-byte key followed by an 8-byte nonce */
+#define VAULT_WIPE_STREAM_SEED_LEN 40
+
+typedef struct vault_wipe_stream vault_wipe_stream_t;
+
+typedef void (*vault_wipe_stream_blocks_fn)(const vault_wipe_stream_t *s,
+                                            uint64_t block, uint8_t *out,
+                                            size_t nblocks);
+
+struct vault_wipe_stream {
+    wipe_rng_t       rng;           /* Resolved generator (never AUTO) */
+    const char      *impl;          /* e.g. "aes-256-ctr/aesni" */
+    size_t           block_size;    /* Keystream block size in bytes */
+    vault_wipe_stream_blocks_fn blocks;
+    uint32_t         chacha[16];    /* ChaCha20 input state */
+    uint8_t          aes_rk[240];   /* AES-256 round keys */
+    uint64_t         nonce;
+};
+
+/* Key a stream from seed using the requested generator. WIPE_RNG_AUTO
+ * picks the fastest one this CPU supports.
+ * Returns 0 on success, -1 on failure. */
+int vault_wipe_stream_init(vault_wipe_stream_t *s, wipe_rng_t rng,
+                            const uint8_t seed[VAULT_WIPE_STREAM_SEED_LEN]);
+
+/* Write len keystream bytes starting at stream position offset.
+ * The output depends only on seed and offset, so any range can be
+ * regenerated independently and from several threads at once.
+ * WIPE_RNG_KERNEL streams are not reproducible.
+ * Returns 0 on success, -1 on failure. */
+int vault_wipe_stream_generate(const vault_wipe_stream_t *s, uint64_t offset,
+                                uint8_t *buf, size_t len);
+
+/* Erase key material. */
+void vault_wipe_stream_destroy(vault_wipe_stream_t *s);
+
+#endif /* VAULT_WIPE_STREAM_H */
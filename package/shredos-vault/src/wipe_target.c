@@ -0,0 +1,268 @@
+/*
+ * wipe_target.c -- Wipe Targets
+ *
+ * The initramfs has no udev, so /dev/disk/by-partuuid is usually
+ * missing there; partitions are then found by reading the GPT of each
+ * disk directly and matched to their kernel device through the
+ * 'partition' number in sysfs, which for GPT is the entry index + 1.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE             /* realpath */
+#endif
+
+#include "wipe_target.h"
+#include "platform.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(VAULT_PLATFORM_LINUX)
+  #include <dirent.h>
+  #include <fcntl.h>
+  #include <limits.h>
+  #include <unistd.h>
+#endif
+
+#define TARGET_GPT_MAX 256              /* partition entries searched */
+
+/* ------------------------------------------------------------------ */
+/*  Extent lists                                                       */
+/* ------------------------------------------------------------------ */
+
+/* A size with an optional binary suffix. Returns the text after it,
+ * or NULL if there is no number or it overflows. */
+static const char *parse_size(const char *s, uint64_t *out)
+{
+    while (isspace((unsigned char)*s)) s++;
+    if (!isdigit((unsigned char)*s)) return NULL;
+    char *end;
+    unsigned long long v = strtoull(s, &end, 0);
+    int shift = 0;
+    switch (toupper((unsigned char)*end)) {
+    case 'K': shift = 10; break;
+    case 'M': shift = 20; break;
+    case 'G': shift = 30; break;
+    case 'T': shift = 40; break;
+    }
+    if (shift) {
+        if (v > (~0ULL >> shift)) return NULL;
+        v <<= shift;
+        end++;
+    }
+    while (isspace((unsigned char)*end)) end++;
+    *out = (uint64_t)v;
+    return end;
+}
+
+int vault_wipe_parse_extents(const char *spec, vault_wipe_extent_t *out,
+                              int max)
+{
+    int n = 0;
+    const char *p = spec;
+    while (isspace((unsigned char)*p)) p++;
+    if (!*p) return 0;
+
+    for (;;) {
+        uint64_t start, len;
+        p = parse_size(p, &start);
+        if (!p || *p != ':') return -1;
+        p = parse_size(p + 1, &len);
+        if (!p || len == 0 || start + len < start || n == max) return -1;
+        out[n].offset = start;
+        out[n].length = len;
+        n++;
+        if (!*p) return n;
+        if (*p != ',') return -1;
+        p++;
+    }
+}
+
+int vault_wipe_extents_within(vault_wipe_extent_t *ext, int n,
+                               const vault_wipe_extent_t *part)
+{
+    if (n == 0) {
+        ext[0] = *part;
+        return 1;
+    }
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (ext[i].offset >= part->length) continue;
+        uint64_t len = ext[i].length;
+        if (len > part->length - ext[i].offset)
+            len = part->length - ext[i].offset;
+        ext[kept].offset = part->offset + ext[i].offset;
+        ext[kept].length = len;
+        kept++;
+    }
+    return kept;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Partition GUIDs                                                    */
+/* ------------------------------------------------------------------ */
+
+/* Text GUID to its on-disk form, whose first three fields are little
+ * endian. Returns -1 if malformed. */
+static int parse_guid(const char *s, uint8_t guid[16])
+{
+    static const int order[16] = { 3, 2, 1, 0, 5, 4, 7, 6,
+                                   8, 9, 10, 11, 12, 13, 14, 15 };
+    uint8_t raw[16];
+    int n = 0;
+    for (; *s && n < 16; s++) {
+        if (*s == '-' && (n == 4 || n == 6 || n == 8 || n == 10)) continue;
+        if (!isxdigit((unsigned char)s[0]) || !isxdigit((unsigned char)s[1]))
+            return -1;
+        char hex[3] = { s[0], s[1], 0 };
+        raw[n++] = (uint8_t)strtoul(hex, NULL, 16);
+        s++;
+    }
+    if (n != 16 || *s) return -1;
+    for (int i = 0; i < 16; i++) guid[i] = raw[order[i]];
+    return 0;
+}
+
+#if defined(VAULT_PLATFORM_LINUX)
+
+static uint32_t le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t le64(const uint8_t *p)
+{
+    return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+/* Find guid in the GPT of disk, with 512- or 4096-byte sectors.
+ * Returns the partition number, or 0 if it is not there. */
+static int gpt_find(const char *disk, const uint8_t guid[16],
+                    vault_wipe_extent_t *part)
+{
+    int fd = open(disk, O_RDONLY);
+    if (fd < 0) return 0;
+
+    int found = 0;
+    uint8_t buf[4096];
+    for (uint64_t ss = 512; ss <= 4096 && !found; ss *= 8) {
+        if (pread(fd, buf, 512, (off_t)ss) != 512 ||
+            memcmp(buf, "EFI PART", 8) != 0)
+            continue;
+        uint64_t lba = le64(buf + 72);
+        uint32_t n = le32(buf + 80), esz = le32(buf + 84);
+        if (esz < 128 || esz > sizeof(buf) || esz % 8) break;
+        for (uint32_t i = 0; i < n && i < TARGET_GPT_MAX; i++) {
+            if (pread(fd, buf, esz, (off_t)(lba * ss + (uint64_t)i * esz))
+                != (ssize_t)esz)
+                break;
+            if (memcmp(buf + 16, guid, 16) != 0) continue;
+            uint64_t first = le64(buf + 32), last = le64(buf + 40);
+            if (last < first) break;
+            part->offset = first * ss;
+            part->length = (last - first + 1) * ss;
+            found = (int)i + 1;
+            break;
+        }
+    }
+    close(fd);
+    return found;
+}
+
+/* The node of partition number partno of /sys/block/<disk>. */
+static int partition_node(const char *disk, int partno, char *path,
+                          size_t path_len)
+{
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "/sys/block/%s", disk);
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+
+    int ret = -1;
+    struct dirent *e;
+    while (ret != 0 && (e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        char attr[PATH_MAX];
+        snprintf(attr, sizeof(attr), "/sys/block/%s/%s/partition", disk,
+                 e->d_name);
+        FILE *fp = fopen(attr, "r");
+        if (!fp) continue;
+        int n = 0;
+        if (fscanf(fp, "%d", &n) == 1 && n == partno) {
+            snprintf(path, path_len, "/dev/%s", e->d_name);
+            if (access(path, F_OK) == 0) ret = 0;
+        }
+        fclose(fp);
+    }
+    closedir(d);
+    return ret;
+}
+
+static int partuuid_resolve(const char *guid_str, char *path,
+                            size_t path_len, vault_wipe_extent_t *part)
+{
+    uint8_t guid[16];
+    if (parse_guid(guid_str, guid) != 0) return -1;
+
+    /* udev's links, when there are any */
+    char link[PATH_MAX], lower[40];
+    size_t i;
+    for (i = 0; guid_str[i] && i < sizeof(lower) - 1; i++)
+        lower[i] = (char)tolower((unsigned char)guid_str[i]);
+    lower[i] = '\0';
+    snprintf(link, sizeof(link), "/dev/disk/by-partuuid/%s", lower);
+    char real[PATH_MAX];
+    if (realpath(link, real) && strlen(real) < path_len) {
+        snprintf(path, path_len, "%s", real);
+        return 0;
+    }
+
+    DIR *d = opendir("/sys/block");
+    if (!d) return -1;
+    int ret = -1;
+    struct dirent *e;
+    while (ret != 0 && (e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        char disk[PATH_MAX];
+        snprintf(disk, sizeof(disk), "/dev/%s", e->d_name);
+        vault_wipe_extent_t ext;
+        int partno = gpt_find(disk, guid, &ext);
+        if (partno == 0) continue;
+
+        if (partition_node(e->d_name, partno, path, path_len) == 0) {
+            ret = 0;
+        } else if (part && strlen(disk) < path_len) {
+            /* No node for it: the disk, narrowed to the partition */
+            snprintf(path, path_len, "%s", disk);
+            *part = ext;
+            ret = 0;
+        }
+    }
+    closedir(d);
+    return ret;
+}
+
+#endif /* VAULT_PLATFORM_LINUX */
+
+int vault_wipe_target_resolve(const char *spec, char *path, size_t path_len,
+                               vault_wipe_extent_t *part)
+{
+    if (part) memset(part, 0, sizeof(*part));
+    size_t plen = strlen(VAULT_WIPE_PARTUUID_PREFIX);
+    if (strncmp(spec, VAULT_WIPE_PARTUUID_PREFIX, plen) != 0) {
+        if (strlen(spec) >= path_len) return -1;
+        snprintf(path, path_len, "%s", spec);
+        return 0;
+    }
+#if defined(VAULT_PLATFORM_LINUX)
+    return partuuid_resolve(spec + plen, path, path_len, part);
+#else
+    (void)parse_guid;
+    return -1;
+#endif
+}
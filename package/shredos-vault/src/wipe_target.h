@@ -0,0 +1,45 @@
+/*
+ * wipe_target.h -- Wipe Targets
+ *
+ * What vault.conf can point a wipe at besides a whole disk: a
+ * partition by path, a GPT partition by its unique GUID, and byte
+ * extents of either. A 50 GB secrets partition on a 4 TB disk then
+ * costs 50 GB of writes per pass, not 4 TB.
+ *
+ * Copyright 2025 -- GPL-2.0+
+ */
+
+#ifndef VAULT_WIPE_TARGET_H
+#define VAULT_WIPE_TARGET_H
+
+#include "wipe.h"
+#include <stddef.h>
+
+#define VAULT_WIPE_PARTUUID_PREFIX "PARTUUID="
+
+/* Turn a target_device value into a device path. Paths come back as
+ * they are. "PARTUUID=<guid>" is looked for in /dev/disk/by-partuuid,
+ * then in the GPT of every disk under /sys/block; path receives the
+ * partition's device node or, where it has none, its disk's, with
+ * *part set to where on the disk the partition lies. part->length is
+ * 0 when path is the target itself. part may be NULL, in which case a
+ * partition without a node is not found.
+ * GUID lookups are Linux only.
+ * Returns 0, or -1 if no partition has that GUID. */
+int vault_wipe_target_resolve(const char *spec, char *path, size_t path_len,
+                               vault_wipe_extent_t *part);
+
+/* Parse a target_extents list: comma-separated "start:length" pairs,
+ * each a byte count or a number with a K, M, G or T suffix (powers of
+ * 1024). Returns the number of extents, 0 for an empty list, or -1 if
+ * the list is malformed or holds more than max. */
+int vault_wipe_parse_extents(const char *spec, vault_wipe_extent_t *out,
+                              int max);
+
+/* Move extents given relative to part (a partition) onto its disk,
+ * clipping them to it; those wholly outside are dropped. With n == 0
+ * the result is part itself. Returns the new count. */
+int vault_wipe_extents_within(vault_wipe_extent_t *ext, int n,
+                               const vault_wipe_extent_t *part);
+
+#endif /* VAULT_WIPE_TARGET_H */
@@ -0,0 +1,708 @@
+/*
+ * Released under the terms of the GNU GPL v2.0.
+ *
+ * A cache of the parsed Kconfig tree.
+ *
+ * With KCONFIG_CACHE set to a path, conf_parse() saves what it built
+ * there as a single image: the symbols, properties, expressions, menus
+ * and files, with every pointer turned into an offset into the image.
+ * A later conf_parse() of the same tree maps the image privately,
+ * checks it against the files it was parsed from, turns the offsets
+ * back into pointers in place and uses it as is instead of parsing.
+ *
+ * A file whose size and mtime are unchanged is taken as is; otherwise
+ * its contents must still hash to what they did. The image is also
+ * keyed on the top-level file, the working directory, the kernel
+ * release and the variables read through "option env". Bump
+ * CACHE_VERSION whenever one of the structures saved here changes.
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lkc.h"
+
+#define CACHE_VERSION	1
+#define CACHE_ALIGN	8
+
+enum cache_kind {
+	CK_NONE,	/* derived or front end data, saved as NULL */
+	CK_STRING,
+	CK_SYMBOL,
+	CK_PROPERTY,
+	CK_EXPR,
+	CK_MENU,
+	CK_FILE,
+};
+
+/* Offsets below CACHE_STATICS stand for objects outside the image */
+enum {
+	CS_NULL,
+	CS_YES,
+	CS_MOD,
+	CS_NO,
+	CS_EMPTY,
+	CS_ROOTMENU,
+	CACHE_STATICS
+};
+
+struct cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t layout[6];		/* pointer and structure sizes */
+	uint64_t key;
+	uint64_t env;			/* hash of the "option env" values */
+	uint64_t size;			/* of the whole image */
+	uint64_t objects, nobjects;	/* struct cache_object[] */
+	uint64_t files, nfiles;		/* struct cache_file[] */
+	uint64_t syms, hash;		/* the symbol table */
+	uint32_t table_size, table_count;
+	uint64_t rootmenu;		/* a copy of rootmenu */
+	/* relocated like the objects' own pointers */
+	struct file *file_list;
+	struct symbol *modules_sym;
+	struct symbol *defconfig_list;
+	struct expr *env_list;
+};
+
+struct cache_object {
+	uint64_t off;
+	uint32_t kind;
+	uint32_t pad;
+};
+
+struct cache_file {
+	uint64_t name;
+	uint64_t size;
+	int64_t mtime;			/* -1: always compare the hash */
+	uint64_t hash;
+};
+
+static const char cache_magic[8] = "KCCACHE";
+
+static void (*cache_fix)(void **p, enum cache_kind kind);
+
+/* Saving: the objects found so far, and a map from their address */
+static struct cache_item {
+	const void *ptr;
+	size_t off;
+	size_t size;
+	enum cache_kind kind;
+} *cache_items;
+static int cache_nitems, cache_items_alloc;
+static const void **cache_map_ptr;
+static size_t *cache_map_off;
+static size_t cache_map_size, cache_map_count;
+static size_t cache_size;
+static bool cache_failed;
+
+/* Loading: the mapped image */
+static char *cache_base;
+
+static uint64_t cache_hash(uint64_t h, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	/* FNV-1a */
+	while (len--)
+		h = (h ^ *p++) * 0x100000001b3ULL;
+	return h;
+}
+
+#define CACHE_HASH_INIT	0xcbf29ce484222325ULL
+
+static uint64_t cache_hash_str(uint64_t h, const char *s)
+{
+	return cache_hash(h, s ? s : "", s ? strlen(s) + 1 : 1);
+}
+
+static bool cache_hash_file(const char *name, uint64_t *hash)
+{
+	char buf[16384];
+	uint64_t h = CACHE_HASH_INIT;
+	size_t n;
+	FILE *f;
+
+	f = fopen(name, "r");
+	if (!f)
+		return false;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		h = cache_hash(h, buf, n);
+	n = ferror(f);
+	fclose(f);
+	*hash = h;
+	return !n;
+}
+
+static uint64_t cache_key(const char *name)
+{
+	char cwd[PATH_MAX];
+	struct utsname uts;
+	uint64_t h = CACHE_HASH_INIT;
+
+	h = cache_hash_str(h, name);
+	h = cache_hash_str(h, getcwd(cwd, sizeof(cwd)) ? cwd : NULL);
+	h = cache_hash_str(h, uname(&uts) ? NULL : uts.release);
+	return h;
+}
+
+static uint64_t cache_env_hash(struct expr *env_list)
+{
+	struct property *prop;
+	struct symbol *sym;
+	struct expr *e;
+	uint64_t h = CACHE_HASH_INIT;
+
+	expr_list_for_each_sym(env_list, e, sym) {
+		for_all_properties(sym, prop, P_ENV) {
+			const char *env = prop_get_symbol(prop)->name;
+
+			h = cache_hash_str(h, env);
+			h = cache_hash_str(h, getenv(env));
+		}
+	}
+	return h;
+}
+
+/*
+ * Every pointer an object holds, with the kind of what it points to.
+ * The same walk collects the objects to save, turns their pointers into
+ * offsets and, on loading, back into pointers.
+ */
+static void cache_walk_symbol(struct symbol *sym)
+{
+	int i;
+
+	cache_fix((void **)&sym->name, CK_STRING);
+	cache_fix(&sym->curr.val, CK_NONE);
+	for (i = 0; i < S_DEF_COUNT; i++)
+		cache_fix(&sym->def[i].val, CK_NONE);
+	cache_fix((void **)&sym->prop, CK_PROPERTY);
+	cache_fix((void **)&sym->dir_dep.expr, CK_EXPR);
+	cache_fix((void **)&sym->rev_dep.expr, CK_EXPR);
+	cache_fix((void **)&sym->implied.expr, CK_EXPR);
+	cache_fix((void **)&sym->dependents, CK_NONE);
+}
+
+static void cache_walk_property(struct property *prop)
+{
+	cache_fix((void **)&prop->next, CK_PROPERTY);
+	cache_fix((void **)&prop->sym, CK_SYMBOL);
+	cache_fix((void **)&prop->text, CK_STRING);
+	cache_fix((void **)&prop->visible.expr, CK_EXPR);
+	cache_fix((void **)&prop->expr, CK_EXPR);
+	cache_fix((void **)&prop->menu, CK_MENU);
+	cache_fix((void **)&prop->file, CK_FILE);
+}
+
+static void cache_walk_expr(struct expr *e)
+{
+	switch (e->type) {
+	case E_OR:
+	case E_AND:
+		cache_fix((void **)&e->left.expr, CK_EXPR);
+		cache_fix((void **)&e->right.expr, CK_EXPR);
+		break;
+	case E_NOT:
+		cache_fix((void **)&e->left.expr, CK_EXPR);
+		break;
+	case E_LIST:
+		cache_fix((void **)&e->left.expr, CK_EXPR);
+		cache_fix((void **)&e->right.sym, CK_SYMBOL);
+		break;
+	case E_EQUAL:
+	case E_UNEQUAL:
+	case E_LTH:
+	case E_LEQ:
+	case E_GTH:
+	case E_GEQ:
+	case E_RANGE:
+		cache_fix((void **)&e->left.sym, CK_SYMBOL);
+		cache_fix((void **)&e->right.sym, CK_SYMBOL);
+		break;
+	case E_SYMBOL:
+		cache_fix((void **)&e->left.sym, CK_SYMBOL);
+		break;
+	default:
+		break;
+	}
+}
+
+static void cache_walk_menu(struct menu *menu)
+{
+	cache_fix((void **)&menu->next, CK_MENU);
+	cache_fix((void **)&menu->parent, CK_MENU);
+	cache_fix((void **)&menu->list, CK_MENU);
+	cache_fix((void **)&menu->sym, CK_SYMBOL);
+	cache_fix((void **)&menu->prompt, CK_PROPERTY);
+	cache_fix((void **)&menu->visibility, CK_EXPR);
+	cache_fix((void **)&menu->dep, CK_EXPR);
+	cache_fix((void **)&menu->help, CK_STRING);
+	cache_fix((void **)&menu->file, CK_FILE);
+	cache_fix(&menu->data, CK_NONE);
+}
+
+static void cache_walk_file(struct file *file)
+{
+	cache_fix((void **)&file->next, CK_FILE);
+	cache_fix((void **)&file->parent, CK_FILE);
+	cache_fix((void **)&file->name, CK_STRING);
+}
+
+static void cache_walk(void *obj, enum cache_kind kind)
+{
+	switch (kind) {
+	case CK_SYMBOL:
+		cache_walk_symbol(obj);
+		break;
+	case CK_PROPERTY:
+		cache_walk_property(obj);
+		break;
+	case CK_EXPR:
+		cache_walk_expr(obj);
+		break;
+	case CK_MENU:
+		cache_walk_menu(obj);
+		break;
+	case CK_FILE:
+		cache_walk_file(obj);
+		break;
+	default:
+		break;
+	}
+}
+
+static size_t cache_kind_size(const void *ptr, enum cache_kind kind)
+{
+	switch (kind) {
+	case CK_STRING:
+		return strlen(ptr) + 1;
+	case CK_SYMBOL:
+		return sizeof(struct symbol);
+	case CK_PROPERTY:
+		return sizeof(struct property);
+	case CK_EXPR:
+		return sizeof(struct expr);
+	case CK_MENU:
+		return sizeof(struct menu);
+	case CK_FILE:
+		return sizeof(struct file);
+	default:
+		return 0;
+	}
+}
+
+/* ------------------------------------------------------------------ */
+
+static size_t cache_map_slot(const void *ptr)
+{
+	size_t mask = cache_map_size - 1;
+	size_t i = (size_t)(((uintptr_t)ptr >> 3) * 0x9e3779b97f4a7c15ULL) & mask;
+
+	while (cache_map_ptr[i] && cache_map_ptr[i] != ptr)
+		i = (i + 1) & mask;
+	return i;
+}
+
+static void cache_map_put(const void *ptr, size_t off)
+{
+	size_t i;
+
+	if (2 * (cache_map_count + 1) > cache_map_size) {
+		const void **old_ptr = cache_map_ptr;
+		size_t *old_off = cache_map_off;
+		size_t old_size = cache_map_size;
+
+		cache_map_size = old_size ? 2 * old_size : 65536;
+		cache_map_ptr = xcalloc(cache_map_size, sizeof(*cache_map_ptr));
+		cache_map_off = xcalloc(cache_map_size, sizeof(*cache_map_off));
+		for (i = 0; i < old_size; i++) {
+			if (old_ptr[i]) {
+				size_t j = cache_map_slot(old_ptr[i]);
+
+				cache_map_ptr[j] = old_ptr[i];
+				cache_map_off[j] = old_off[i];
+			}
+		}
+		free(old_ptr);
+		free(old_off);
+	}
+	i = cache_map_slot(ptr);
+	cache_map_ptr[i] = ptr;
+	cache_map_off[i] = off;
+	cache_map_count++;
+}
+
+static bool cache_map_get(const void *ptr, size_t *off)
+{
+	size_t i = cache_map_slot(ptr);
+
+	if (!cache_map_ptr[i])
+		return false;
+	*off = cache_map_off[i];
+	return true;
+}
+
+static size_t cache_reserve(size_t size, size_t align)
+{
+	size_t off = (cache_size + align - 1) & ~(align - 1);
+
+	cache_size = off + size;
+	return off;
+}
+
+static size_t cache_add(const void *ptr, enum cache_kind kind)
+{
+	struct cache_item *item;
+
+	if (cache_nitems == cache_items_alloc) {
+		cache_items_alloc = cache_items_alloc ? 2 * cache_items_alloc : 4096;
+		cache_items = xrealloc(cache_items,
+				       cache_items_alloc * sizeof(*cache_items));
+	}
+	item = &cache_items[cache_nitems++];
+	item->ptr = ptr;
+	item->kind = kind;
+	item->size = cache_kind_size(ptr, kind);
+	item->off = cache_reserve(item->size,
+				  kind == CK_STRING ? 1 : CACHE_ALIGN);
+	return item->off;
+}
+
+/* Saving, first pass: find everything reachable */
+static void cache_collect(void **p, enum cache_kind kind)
+{
+	size_t off;
+
+	if (kind == CK_NONE || !*p || cache_map_get(*p, &off))
+		return;
+	cache_map_put(*p, cache_add(*p, kind));
+}
+
+/* Saving, second pass: pointers to offsets, in the image's copy */
+static void cache_to_offset(void **p, enum cache_kind kind)
+{
+	size_t off = 0;
+
+	if (kind != CK_NONE && *p && !cache_map_get(*p, &off))
+		cache_failed = true;
+	*p = (void *)(uintptr_t)off;
+}
+
+/* Loading: offsets to pointers, in place */
+static void cache_to_pointer(void **p, enum cache_kind kind)
+{
+	static void *const statics[CACHE_STATICS] = {
+		[CS_YES] = &symbol_yes,
+		[CS_MOD] = &symbol_mod,
+		[CS_NO] = &symbol_no,
+		[CS_EMPTY] = &symbol_empty,
+		[CS_ROOTMENU] = &rootmenu,
+	};
+	uintptr_t off = (uintptr_t)*p;
+
+	if (kind == CK_NONE || off < CACHE_STATICS) {
+		*p = kind == CK_NONE ? NULL : statics[off];
+	} else if (off >= ((struct cache_header *)cache_base)->size) {
+		cache_failed = true;
+		*p = NULL;
+	} else {
+		*p = cache_base + off;
+	}
+}
+
+static void cache_reset(void)
+{
+	free(cache_items);
+	free(cache_map_ptr);
+	free(cache_map_off);
+	cache_items = NULL;
+	cache_nitems = cache_items_alloc = 0;
+	cache_map_ptr = NULL;
+	cache_map_off = NULL;
+	cache_map_size = cache_map_count = 0;
+	cache_size = 0;
+	cache_failed = false;
+}
+
+static bool cache_write(const char *path, const char *image, size_t size)
+{
+	char tmp[PATH_MAX];
+	FILE *f;
+	bool ok;
+
+	if (snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid()) >= (int)sizeof(tmp))
+		return false;
+	f = fopen(tmp, "w");
+	if (!f)
+		return false;
+	ok = fwrite(image, 1, size, f) == size;
+	ok = !fclose(f) && ok;
+	if (ok && !rename(tmp, path))
+		return true;
+	unlink(tmp);
+	return false;
+}
+
+/* Save the tree conf_parse() has just built, if KCONFIG_CACHE asks for it */
+void conf_cache_save(const char *name)
+{
+	const char *path = getenv("KCONFIG_CACHE");
+	struct cache_header *hdr;
+	struct cache_object *objects;
+	struct cache_file *files;
+	struct file *file;
+	void **syms;
+	size_t menu_off, objects_off, files_off, syms_off, hash_off;
+	int i, nobjects, nfiles;
+	time_t now;
+	char *image;
+
+	if (!path || !*path)
+		return;
+
+	cache_reset();
+	cache_reserve(sizeof(*hdr), CACHE_ALIGN);
+	cache_map_put(&symbol_yes, CS_YES);
+	cache_map_put(&symbol_mod, CS_MOD);
+	cache_map_put(&symbol_no, CS_NO);
+	cache_map_put(&symbol_empty, CS_EMPTY);
+	cache_map_put(&rootmenu, CS_ROOTMENU);
+
+	cache_fix = cache_collect;
+	menu_off = cache_add(&rootmenu, CK_MENU);
+	cache_fix((void **)&file_list, CK_FILE);
+	cache_fix((void **)&modules_sym, CK_SYMBOL);
+	cache_fix((void **)&sym_defconfig_list, CK_SYMBOL);
+	cache_fix((void **)&sym_env_list, CK_EXPR);
+	for (i = 0; i < symbol_table.size; i++)
+		cache_fix((void **)&symbol_table.syms[i], CK_SYMBOL);
+	/* the list grows as it is walked */
+	for (i = 0; i < cache_nitems; i++)
+		cache_walk((void *)cache_items[i].ptr, cache_items[i].kind);
+
+	nobjects = 0;
+	for (i = 0; i < cache_nitems; i++)
+		nobjects += cache_items[i].kind != CK_STRING;
+	nfiles = 0;
+	for (file = file_list; file; file = file->next)
+		nfiles++;
+	objects_off = cache_reserve(nobjects * sizeof(*objects), CACHE_ALIGN);
+	files_off = cache_reserve(nfiles * sizeof(*files), CACHE_ALIGN);
+	syms_off = cache_reserve(symbol_table.size * sizeof(*syms), CACHE_ALIGN);
+	hash_off = cache_reserve(symbol_table.size * sizeof(*symbol_table.hash),
+				 CACHE_ALIGN);
+
+	image = xcalloc(1, cache_size);
+	hdr = (struct cache_header *)image;
+	objects = (struct cache_object *)(image + objects_off);
+	files = (struct cache_file *)(image + files_off);
+	syms = (void **)(image + syms_off);
+
+	cache_fix = cache_to_offset;
+	for (i = 0; i < cache_nitems; i++) {
+		struct cache_item *item = &cache_items[i];
+		void *copy = image + item->off;
+
+		memcpy(copy, item->ptr, item->size);
+		if (item->kind == CK_STRING)
+			continue;
+		cache_walk(copy, item->kind);
+		if (item->kind == CK_SYMBOL) {
+			struct symbol *sym = copy;
+
+			sym->curr.tri = no;
+			sym->flags &= ~SYMBOL_VALID;
+			sym->dependents_count = 0;
+			sym->clear_gen = 0;
+		} else if (item->kind == CK_EXPR) {
+			((struct expr *)copy)->val_gen = 0;
+		}
+		objects->off = item->off;
+		objects->kind = item->kind;
+		objects++;
+	}
+
+	/* a file changed in the second it is saved in must be hashed */
+	now = time(NULL);
+	i = 0;
+	for (file = file_list; file; file = file->next, i++) {
+		struct stat st;
+		size_t off;
+
+		if (!file->name || !cache_map_get(file->name, &off) ||
+		    stat(file->name, &st) ||
+		    !cache_hash_file(file->name, &files[i].hash)) {
+			cache_failed = true;
+			break;
+		}
+		files[i].name = off;
+		files[i].size = st.st_size;
+		files[i].mtime = st.st_mtime < now ? st.st_mtime : -1;
+	}
+
+	memcpy(hdr->magic, cache_magic, sizeof(hdr->magic));
+	hdr->version = CACHE_VERSION;
+	hdr->layout[0] = sizeof(void *);
+	hdr->layout[1] = sizeof(struct symbol);
+	hdr->layout[2] = sizeof(struct property);
+	hdr->layout[3] = sizeof(struct expr);
+	hdr->layout[4] = sizeof(struct menu);
+	hdr->layout[5] = sizeof(struct file);
+	hdr->key = cache_key(name);
+	hdr->env = cache_env_hash(sym_env_list);
+	hdr->size = cache_size;
+	hdr->objects = objects_off;
+	hdr->nobjects = nobjects;
+	hdr->files = files_off;
+	hdr->nfiles = nfiles;
+	hdr->syms = syms_off;
+	hdr->hash = hash_off;
+	hdr->table_size = symbol_table.size;
+	hdr->table_count = symbol_table.count;
+	hdr->rootmenu = menu_off;
+	hdr->file_list = file_list;
+	hdr->modules_sym = modules_sym;
+	hdr->defconfig_list = sym_defconfig_list;
+	hdr->env_list = sym_env_list;
+	cache_fix((void **)&hdr->file_list, CK_FILE);
+	cache_fix((void **)&hdr->modules_sym, CK_SYMBOL);
+	cache_fix((void **)&hdr->defconfig_list, CK_SYMBOL);
+	cache_fix((void **)&hdr->env_list, CK_EXPR);
+	for (i = 0; i < symbol_table.size; i++) {
+		syms[i] = symbol_table.syms[i];
+		cache_fix(&syms[i], CK_SYMBOL);
+	}
+	memcpy(image + hash_off, symbol_table.hash,
+	       symbol_table.size * sizeof(*symbol_table.hash));
+
+	if (!cache_failed)
+		cache_write(path, image, cache_size);
+	free(image);
+	cache_reset();
+}
+
+static bool cache_check_files(const struct cache_header *hdr)
+{
+	const struct cache_file *files;
+	uint64_t i, hash;
+
+	files = (const struct cache_file *)(cache_base + hdr->files);
+	for (i = 0; i < hdr->nfiles; i++) {
+		const char *name;
+		struct stat st;
+
+		if (files[i].name >= hdr->size)
+			return false;
+		name = cache_base + files[i].name;
+		if (stat(name, &st) || (uint64_t)st.st_size != files[i].size)
+			return false;
+		if (files[i].mtime >= 0 && st.st_mtime == files[i].mtime)
+			continue;
+		if (!cache_hash_file(name, &hash) || hash != files[i].hash)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Take the tree conf_parse() would build for name from KCONFIG_CACHE, if
+ * that holds an image of it that is still current. Returns false, with
+ * nothing changed, otherwise.
+ */
+bool conf_cache_load(const char *name)
+{
+	const char *path = getenv("KCONFIG_CACHE");
+	struct cache_header *hdr;
+	const struct cache_object *objects;
+	struct stat st;
+	void **syms;
+	uint64_t i;
+	int fd;
+
+	if (!path || !*path)
+		return false;
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &st) || (size_t)st.st_size < sizeof(*hdr)) {
+		close(fd);
+		return false;
+	}
+	/* private: the offsets are turned into pointers in place */
+	cache_base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+			  fd, 0);
+	close(fd);
+	if (cache_base == MAP_FAILED)
+		return false;
+
+	hdr = (struct cache_header *)cache_base;
+	if (memcmp(hdr->magic, cache_magic, sizeof(hdr->magic)) ||
+	    hdr->version != CACHE_VERSION ||
+	    hdr->layout[0] != sizeof(void *) ||
+	    hdr->layout[1] != sizeof(struct symbol) ||
+	    hdr->layout[2] != sizeof(struct property) ||
+	    hdr->layout[3] != sizeof(struct expr) ||
+	    hdr->layout[4] != sizeof(struct menu) ||
+	    hdr->layout[5] != sizeof(struct file) ||
+	    hdr->size != (uint64_t)st.st_size ||
+	    hdr->objects + hdr->nobjects * sizeof(*objects) > hdr->size ||
+	    hdr->files + hdr->nfiles * sizeof(struct cache_file) > hdr->size ||
+	    hdr->syms + hdr->table_size * sizeof(*syms) > hdr->size ||
+	    hdr->hash + hdr->table_size * sizeof(*symbol_table.hash) > hdr->size ||
+	    hdr->rootmenu + sizeof(struct menu) > hdr->size ||
+	    hdr->key != cache_key(name) ||
+	    !cache_check_files(hdr))
+		goto fail;
+
+	cache_failed = false;
+	cache_fix = cache_to_pointer;
+	objects = (const struct cache_object *)(cache_base + hdr->objects);
+	for (i = 0; i < hdr->nobjects; i++) {
+		if (objects[i].kind <= CK_STRING || objects[i].kind > CK_FILE ||
+		    objects[i].off + cache_kind_size(cache_base, objects[i].kind) > hdr->size) {
+			cache_failed = true;
+			break;
+		}
+		cache_walk(cache_base + objects[i].off, objects[i].kind);
+	}
+	cache_fix((void **)&hdr->file_list, CK_FILE);
+	cache_fix((void **)&hdr->modules_sym, CK_SYMBOL);
+	cache_fix((void **)&hdr->defconfig_list, CK_SYMBOL);
+	cache_fix((void **)&hdr->env_list, CK_EXPR);
+	syms = (void **)(cache_base + hdr->syms);
+	for (i = 0; i < hdr->table_size; i++)
+		cache_fix(&syms[i], CK_SYMBOL);
+	if (cache_failed || hdr->env != cache_env_hash(hdr->env_list))
+		goto fail;
+
+	/* the symbol table is reallocated as it grows, so not left mapped */
+	symbol_table.size = hdr->table_size;
+	symbol_table.count = hdr->table_count;
+	symbol_table.syms = xmalloc(hdr->table_size * sizeof(*symbol_table.syms));
+	symbol_table.hash = xmalloc(hdr->table_size * sizeof(*symbol_table.hash));
+	memcpy(symbol_table.syms, syms, hdr->table_size * sizeof(*syms));
+	memcpy(symbol_table.hash, cache_base + hdr->hash,
+	       hdr->table_size * sizeof(*symbol_table.hash));
+	rootmenu = *(struct menu *)(cache_base + hdr->rootmenu);
+	file_list = hdr->file_list;
+	modules_sym = hdr->modules_sym;
+	sym_defconfig_list = hdr->defconfig_list;
+	sym_env_list = hdr->env_list;
+	/* everything else stays in the mapping for good */
+	return true;
+
+fail:
+	munmap(cache_base, st.st_size);
+	cache_base = NULL;
+	return false;
+}
@@ -14,6 +14,7 @@
 #include <getopt.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <errno.h>
 
 #include "lkc.h"
@@ -34,6 +35,7 @@ enum input_mode {
 	savedefconfig,
 	listnewconfig,
 	olddefconfig,
+	batchconfig,
 };
 static enum input_mode input_mode = oldaskconfig;
 
@@ -461,6 +463,7 @@ static struct option long_opts[] = {
 	{"randconfig",      no_argument,       NULL, randconfig},
 	{"listnewconfig",   no_argument,       NULL, listnewconfig},
 	{"olddefconfig",    no_argument,       NULL, olddefconfig},
+	{"batchconfig",     required_argument, NULL, batchconfig},
 	/*
 	 * oldnoconfig is an alias of olddefconfig, because people already
 	 * are dependent on its behavior(sets new symbols to their default
@@ -489,6 +492,79 @@ static void conf_usage(const char *progname)
 	printf("  --allmodconfig          New config where all options are answered with mod\n");
 	printf("  --alldefconfig          New config with all symbols set to default\n");
 	printf("  --randconfig            New config with random answer to all options\n");
+	printf("  --batchconfig <dir>     New config with defaults from each [NAME=value...] <file>\n"
+	       "                          given after <kconfig-file>, written to <dir>/<file>\n");
+}
+
+/* Write the configuration defined by a defconfig to dir. */
+static int conf_batch_one(const char *dir, const char *defconfig_file)
+{
+	char path[PATH_MAX];
+	const char *base = strrchr(defconfig_file, '/');
+
+	snprintf(path, sizeof(path), "%s/%s", dir,
+		 base ? base + 1 : defconfig_file);
+	sym_env_reload();
+	if (conf_read(defconfig_file)) {
+		fprintf(stderr,
+			_("***\n"
+			  "*** Can't find default configuration \"%s\"!\n"
+			  "***\n"),
+			defconfig_file);
+		return 1;
+	}
+	conf_set_all_new_symbols(def_default);
+	if (conf_write(path)) {
+		fprintf(stderr, _("\n*** Error during writing of the configuration.\n\n"));
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Evaluate each defconfig in a child of its own, so that all start from
+ * the one parse, with as many running at a time as there are processors.
+ * NAME=value arguments set the environment of the defconfigs after them.
+ */
+static int conf_batch(const char *dir, int ac, char **av)
+{
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	int i, running = 0, failed = 0, status;
+	pid_t pid;
+
+	if (jobs < 1)
+		jobs = 1;
+	if (mkdir(dir, 0755) && errno != EEXIST) {
+		fprintf(stderr, _("%s: %s\n"), dir, strerror(errno));
+		return 1;
+	}
+	fflush(stdout);
+	for (i = 0; i < ac || running; ) {
+		if (i < ac && strchr(av[i], '=')) {
+			putenv(av[i++]);
+			continue;
+		}
+		if (i < ac && running < jobs) {
+			pid = fork();
+			if (pid == 0)
+				exit(conf_batch_one(dir, av[i]));
+			if (pid > 0) {
+				running++;
+				i++;
+				continue;
+			}
+			if (!running) {
+				perror("fork");
+				return 1;
+			}
+		}
+		if (wait(&status) < 0)
+			return 1;
+		running--;
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			failed++;
+	}
+	return failed ? 1 : 0;
 }
 
 int main(int ac, char **av)
@@ -516,6 +592,7 @@ int main(int ac, char **av)
 			break;
 		case defconfig:
 		case savedefconfig:
+		case batchconfig:
 			defconfig_file = optarg;
 			break;
 		case randconfig:
@@ -565,6 +642,8 @@ int main(int ac, char **av)
 	}
 	name = av[optind];
 	conf_parse(name);
+	if (input_mode == batchconfig)
+		return conf_batch(defconfig_file, ac - optind - 1, av + optind + 1);
 	if (sync_kconfig) {
 		name = conf_get_configname();
 		if (stat(name, &tmpstat)) {
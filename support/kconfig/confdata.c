@@ -13,6 +13,7 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <utime.h>
 #include <libgen.h>
 
 #include "lkc.h"
@@ -192,66 +193,36 @@ static int conf_set_sym_val(struct symbol *sym, int def, int def_flags, char *p)
 	return 0;
 }
 
-#define LINE_GROWTH 16
-static int add_byte(int c, char **lineptr, size_t slen, size_t *n)
-{
-	char *nline;
-	size_t new_size = slen + 1;
-	if (new_size > *n) {
-		new_size += LINE_GROWTH - 1;
-		new_size *= 2;
-		nline = xrealloc(*lineptr, new_size);
-		if (!nline)
-			return -1;
-
-		*lineptr = nline;
-		*n = new_size;
-	}
-
-	(*lineptr)[slen] = c;
-
-	return 0;
-}
-
-static ssize_t compat_getline(char **lineptr, size_t *n, FILE *stream)
+/*
+ * Read a whole configuration file into one NUL-terminated buffer, so
+ * that its lines can be split and edited in place.
+ */
+static char *conf_read_file(FILE *in, size_t *len)
 {
-	char *line = *lineptr;
-	size_t slen = 0;
-
-	for (;;) {
-		int c = getc(stream);
-
-		switch (c) {
-		case '\n':
-			if (add_byte(c, &line, slen, n) < 0)
-				goto e_out;
-			slen++;
-			/* fall through */
-		case EOF:
-			if (add_byte('\0', &line, slen, n) < 0)
-				goto e_out;
-			*lineptr = line;
-			if (slen == 0)
-				return -1;
-			return slen;
-		default:
-			if (add_byte(c, &line, slen, n) < 0)
-				goto e_out;
-			slen++;
+	struct stat st;
+	size_t size = 4096, n = 0, r;
+	char *buf;
+
+	if (!fstat(fileno(in), &st) && S_ISREG(st.st_mode) && st.st_size > 0)
+		size = st.st_size + 1;
+	buf = xmalloc(size);
+	while ((r = fread(buf + n, 1, size - n - 1, in)) > 0) {
+		n += r;
+		if (n + 1 == size) {
+			size *= 2;
+			buf = xrealloc(buf, size);
 		}
 	}
-
-e_out:
-	line[slen-1] = '\0';
-	*lineptr = line;
-	return -1;
+	buf[n] = 0;
+	*len = n;
+	return buf;
 }
 
 int conf_read_simple(const char *name, int def)
 {
 	FILE *in = NULL;
-	char   *line = NULL;
-	size_t  line_asize = 0;
+	char *buf, *line, *next, *end;
+	size_t len, prefix = strlen(CONFIG_);
 	char *p, *p2;
 	struct symbol *sym;
 	int i, def_flags;
@@ -308,27 +279,37 @@ load:
 			sym->def[def].tri = no;
 		}
 	}
+	expr_invalidate_values();
+
+	buf = conf_read_file(in, &len);
+	fclose(in);
+	end = buf + len;
 
-	while (compat_getline(&line, &line_asize, in) != -1) {
+	for (line = buf; line < end; line = next) {
+		next = memchr(line, '\n', end - line);
+		if (!next)
+			next = end;
+		*next++ = 0;
 		conf_lineno++;
 		sym = NULL;
 		if (line[0] == '#') {
-			if (memcmp(line + 2, CONFIG_, strlen(CONFIG_)))
+			/* line + 2 of a bare "#" is the next line */
+			if (line[1] != ' ' || strncmp(line + 2, CONFIG_, prefix))
 				continue;
-			p = strchr(line + 2 + strlen(CONFIG_), ' ');
+			p = strchr(line + 2 + prefix, ' ');
 			if (!p)
 				continue;
 			*p++ = 0;
 			if (strncmp(p, "is not set", 10))
 				continue;
 			if (def == S_DEF_USER) {
-				sym = sym_find(line + 2 + strlen(CONFIG_));
+				sym = sym_find(line + 2 + prefix);
 				if (!sym) {
 					sym_add_change_count(1);
 					goto setsym;
 				}
 			} else {
-				sym = sym_lookup(line + 2 + strlen(CONFIG_), 0);
+				sym = sym_lookup(line + 2 + prefix, 0);
 				if (sym->type == S_UNKNOWN)
 					sym->type = S_BOOLEAN;
 			}
@@ -344,25 +325,22 @@ load:
 			default:
 				;
 			}
-		} else if (memcmp(line, CONFIG_, strlen(CONFIG_)) == 0) {
-			p = strchr(line + strlen(CONFIG_), '=');
+		} else if (memcmp(line, CONFIG_, prefix) == 0) {
+			p = strchr(line + prefix, '=');
 			if (!p)
 				continue;
 			*p++ = 0;
-			p2 = strchr(p, '\n');
-			if (p2) {
-				*p2-- = 0;
-				if (*p2 == '\r')
-					*p2 = 0;
-			}
+			p2 = next - 2;
+			if (p2 >= p && *p2 == '\r')
+				*p2 = 0;
 			if (def == S_DEF_USER) {
-				sym = sym_find(line + strlen(CONFIG_));
+				sym = sym_find(line + prefix);
 				if (!sym) {
 					sym_add_change_count(1);
 					goto setsym;
 				}
 			} else {
-				sym = sym_lookup(line + strlen(CONFIG_), 0);
+				sym = sym_lookup(line + prefix, 0);
 				if (sym->type == S_UNKNOWN)
 					sym->type = S_OTHER;
 			}
@@ -372,9 +350,9 @@ load:
 			if (conf_set_sym_val(sym, def, def_flags, p))
 				continue;
 		} else {
-			if (line[0] != '\r' && line[0] != '\n')
+			if (line[0] && line[0] != '\r')
 				conf_warning("unexpected data: %.*s",
-					     (int)strcspn(line, "\r\n"), line);
+					     (int)strcspn(line, "\r"), line);
 
 			continue;
 		}
@@ -399,8 +377,7 @@ setsym:
 			cs->def[def].tri = EXPR_OR(cs->def[def].tri, sym->def[def].tri);
 		}
 	}
-	free(line);
-	fclose(in);
+	free(buf);
 	return 0;
 }
 
@@ -462,6 +439,7 @@ int conf_read(const char *name)
 				if (sym_string_within_range(sym, sym->def[S_DEF_USER].val))
 					break;
 				sym->flags &= ~(SYMBOL_VALID|SYMBOL_DEF_USER);
+				expr_invalidate_values();
 				conf_unsaved++;
 				break;
 			default:
@@ -1034,26 +1012,37 @@ int conf_write_autoconf(void)
 	fclose(tristate);
 	fclose(out_h);
 
+	/*
+	 * Files whose content did not change are left alone, so that
+	 * whatever depends on them is not rebuilt for nothing.
+	 */
 	name = getenv("KCONFIG_AUTOHEADER");
 	if (!name)
 		name = "include/generated/autoconf.h";
 	sprintf(buf, "%s.tmpconfig.h", dir);
-	if (rename(buf, name))
+	if (file_replace(buf, name) < 0)
 		return 1;
 	name = getenv("KCONFIG_TRISTATE");
 	if (!name)
 		name = "include/config/tristate.conf";
 	sprintf(buf, "%s.tmpconfig_tristate", dir);
-	if (rename(buf, name))
+	if (file_replace(buf, name) < 0)
 		return 1;
 	name = conf_get_autoconfig_name();
 	/*
 	 * This must be the last step, kbuild has a dependency on auto.conf
 	 * and this marks the successful completion of the previous steps.
+	 * So an unchanged auto.conf is still touched.
 	 */
 	sprintf(buf, "%s.tmpconfig", dir);
-	if (rename(buf, name))
+	switch (file_replace(buf, name)) {
+	case -1:
 		return 1;
+	case 0:
+		if (utime(name, NULL))
+			return 1;
+		break;
+	}
 
 	return 0;
 }
@@ -1129,6 +1118,7 @@ static bool randomize_choice_values(struct symbol *csym)
 	csym->flags |= SYMBOL_DEF_USER;
 	/* clear VALID to get value calculated */
 	csym->flags &= ~(SYMBOL_VALID);
+	expr_invalidate_values();
 
 	return true;
 }
@@ -1151,6 +1141,7 @@ void set_all_choice_values(struct symbol *csym)
 	csym->flags |= SYMBOL_DEF_USER;
 	/* clear VALID to get value calculated */
 	csym->flags &= ~(SYMBOL_VALID | SYMBOL_NEED_SET_CHOICE_VALUES);
+	expr_invalidate_values();
 }
 
 bool conf_set_all_new_symbols(enum conf_def_mode mode)
@@ -71,6 +71,7 @@ struct expr *expr_copy(const struct expr *org)
 
 	e = xmalloc(sizeof(*org));
 	memcpy(e, org, sizeof(*org));
+	e->val_gen = 0;
 	switch (org->type) {
 	case E_SYMBOL:
 		e->left = org->left;
@@ -1023,7 +1024,36 @@ static enum string_value_kind expr_parse_string(const char *str,
 	       ? kind : k_string;
 }
 
+/*
+ * Values of expressions are kept until the next call of
+ * expr_invalidate_values(), which must follow any change of a symbol's
+ * value and any clearing of SYMBOL_VALID: a kept value is returned
+ * without calculating the symbols it was calculated from.
+ */
+static unsigned int expr_calc_gen = 1;
+
+void expr_invalidate_values(void)
+{
+	expr_calc_gen++;
+}
+
+static tristate __expr_calc_value(struct expr *e);
+
 tristate expr_calc_value(struct expr *e)
+{
+	unsigned int gen = expr_calc_gen;
+
+	if (!e)
+		return yes;
+	if (e->val_gen != gen) {
+		/* if the generation moves on meanwhile, val is not kept */
+		e->val = __expr_calc_value(e);
+		e->val_gen = gen;
+	}
+	return e->val;
+}
+
+static tristate __expr_calc_value(struct expr *e)
 {
 	tristate val1, val2;
 	const char *str1, *str2;
@@ -1031,9 +1061,6 @@ tristate expr_calc_value(struct expr *e)
 	union string_value lval = {}, rval = {};
 	int res;
 
-	if (!e)
-		return yes;
-
 	switch (e->type) {
 	case E_SYMBOL:
 		sym_calc_value(e->left.sym);
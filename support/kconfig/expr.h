@@ -42,6 +42,8 @@ union expr_data {
 struct expr {
 	enum expr_type type;
 	union expr_data left, right;
+	tristate val;			/* last value, see expr_calc_value() */
+	unsigned int val_gen;		/* generation val was calculated in */
 };
 
 #define EXPR_OR(dep1, dep2)	(((dep1)>(dep2))?(dep1):(dep2))
@@ -81,9 +83,6 @@ enum {
  * SYMBOL_CHOICE bit set in 'flags'.
  */
 struct symbol {
-	/* The next symbol in the same bucket in the symbol hash table */
-	struct symbol *next;
-
 	/* The name of the symbol, e.g. "FOO" for 'config FOO' */
 	char *name;
 
@@ -129,9 +128,33 @@ struct symbol {
 	 * "Weak" reverse dependencies through being implied by other symbols
 	 */
 	struct expr_value implied;
+
+	/*
+	 * Symbols whose value is calculated from this one, through their
+	 * properties, dependencies or choice. Filled in by
+	 * sym_init_dependents() once parsing is done, and walked by
+	 * sym_clear_valid() when this symbol's user value changes.
+	 */
+	struct symbol **dependents;
+	int dependents_count;
+
+	/* The last sym_clear_valid() pass that reached this symbol */
+	unsigned int clear_gen;
+};
+
+/*
+ * The symbol table: open addressing with linear probing, grown to stay at
+ * most half full. hash[i] caches the name hash of syms[i], so probes only
+ * compare names on a full hash match.
+ */
+struct symbol_table {
+	struct symbol **syms;
+	unsigned int *hash;
+	int size;		/* a power of two, 0 until the first symbol */
+	int count;
 };
 
-#define for_all_symbols(i, sym) for (i = 0; i < SYMBOL_HASHSIZE; i++) for (sym = symbol_hash[i]; sym; sym = sym->next) if (sym->type != S_OTHER)
+#define for_all_symbols(i, sym) for (i = 0; i < symbol_table.size; i++) if ((sym = symbol_table.syms[i]) && sym->type != S_OTHER)
 
 #define SYMBOL_CONST      0x0001  /* symbol is const */
 #define SYMBOL_CHECK      0x0008  /* used during dependency checking */
@@ -159,7 +182,7 @@ struct symbol {
 #define SYMBOL_ALLNOCONFIG_Y 0x200000
 
 #define SYMBOL_MAXLENGTH	256
-#define SYMBOL_HASHSIZE		9973
+#define SYMBOL_TABLE_MIN	4096
 
 /* A property represent the config options that can be associated
  * with a config "symbol".
@@ -299,6 +322,7 @@ struct expr *expr_copy(const struct expr *org);
 void expr_free(struct expr *e);
 void expr_eliminate_eq(struct expr **ep1, struct expr **ep2);
 tristate expr_calc_value(struct expr *e);
+void expr_invalidate_values(void);
 struct expr *expr_trans_bool(struct expr *e);
 struct expr *expr_eliminate_dups(struct expr *e);
 struct expr *expr_transform(struct expr *e);
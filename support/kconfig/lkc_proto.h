@@ -27,13 +27,14 @@ struct gstr get_relations_str(struct symbol **sym_arr, struct list_head *head);
 void menu_get_ext_help(struct menu *menu, struct gstr *help);
 
 /* symbol.c */
-extern struct symbol * symbol_hash[SYMBOL_HASHSIZE];
+extern struct symbol_table symbol_table;
 
 struct symbol * sym_lookup(const char *name, int flags);
 struct symbol * sym_find(const char *name);
 char *sym_expand_string_value(const char *in);
 const char * sym_escape_string_value(const char *in);
 struct symbol ** sym_re_search(const char *pattern);
+struct symbol ** sym_search(const char *text, int max, int *count);
 const char * sym_type_name(enum symbol_type type);
 void sym_calc_value(struct symbol *sym);
 enum symbol_type sym_get_type(struct symbol *sym);
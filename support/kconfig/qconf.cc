@@ -25,8 +25,10 @@
 #include <qmessagebox.h>
 #include <qregexp.h>
 #include <qevent.h>
+#include <QScrollBar>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "lkc.h"
 #include "qconf.h"
@@ -250,8 +252,12 @@ void ConfigItem::init(void)
 		nextItem = (ConfigItem*)menu->data;
 		menu->data = this;
 
-		if (list->mode != fullMode)
+		if (list->mode != fullMode) {
+			/* filled in by the update creating this item */
+			bool blocked = list->blockSignals(true);
 			setExpanded(true);
+			list->blockSignals(blocked);
+		}
 		sym_calc_value(menu->sym);
 	}
 	updateMenu();
@@ -331,6 +337,8 @@ ConfigList::ConfigList(ConfigView* p, const char *name)
 
 	connect(this, SIGNAL(itemSelectionChanged(void)),
 		SLOT(updateSelection(void)));
+	connect(this, SIGNAL(itemExpanded(QTreeWidgetItem *)),
+		SLOT(populateItem(QTreeWidgetItem *)));
 
 	if (name) {
 		configSettings->beginGroup(name);
@@ -403,6 +411,24 @@ ConfigItem* ConfigList::findConfigItem(struct menu *menu)
 	return item;
 }
 
+/*
+ * Find the item for a menu entry, expanding its parents first: the
+ * children of a collapsed entry are only created once it is expanded.
+ */
+ConfigItem* ConfigList::revealConfigItem(struct menu *menu)
+{
+	ConfigItem* item = findConfigItem(menu);
+	ConfigItem* parent;
+
+	if (item || !menu->parent || menu->parent == rootEntry)
+		return item;
+	parent = revealConfigItem(menu->parent);
+	if (!parent)
+		return NULL;
+	parent->setExpanded(true);
+	return findConfigItem(menu);
+}
+
 void ConfigList::updateSelection(void)
 {
 	struct menu *menu;
@@ -576,9 +602,36 @@ void ConfigList::setParentMenu(void)
 	}
 }
 
+/*
+ * whether the children of a menu entry are listed below its item,
+ * rather than in a list of their own
+ */
+bool ConfigList::menuHasChildItems(struct menu *menu)
+{
+	enum prop_type type = menu->prompt ? menu->prompt->type : P_UNKNOWN;
+
+	return mode == fullMode || mode == menuMode || type != P_MENU;
+}
+
+/*
+ * create or refresh the children of an item as it is expanded; those of
+ * collapsed items are left alone by updates until then
+ */
+void ConfigList::populateItem(QTreeWidgetItem *i)
+{
+	ConfigItem* item = (ConfigItem*)i;
+
+	if (!item->menu || !menuHasChildItems(item->menu))
+		return;
+	item->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+	updateMenuList(item, item->menu);
+	resizeColumnToContents(0);
+}
+
 /*
  * update all the children of a menu entry
  *   removes/adds the entries from the parent widget as necessary
+ *   the children of collapsed entries are only created once expanded
  *
  * parent: either the menu list widget or a menu entry widget
  * menu: entry to be updated
@@ -589,7 +642,6 @@ void ConfigList::updateMenuList(ConfigItem *parent, struct menu* menu)
 	ConfigItem* item;
 	ConfigItem* last;
 	bool visible;
-	enum prop_type type;
 
 	if (!menu) {
 		while (parent->childCount() > 0)
@@ -605,7 +657,6 @@ void ConfigList::updateMenuList(ConfigItem *parent, struct menu* menu)
 		last = 0;
 	for (child = menu->list; child; child = child->next) {
 		item = last ? last->nextSibling() : parent->firstChild();
-		type = child->prompt ? child->prompt->type : P_UNKNOWN;
 
 		switch (mode) {
 		case menuMode:
@@ -629,10 +680,14 @@ void ConfigList::updateMenuList(ConfigItem *parent, struct menu* menu)
 			else
 				item->testUpdateMenu(visible);
 
-			if (mode == fullMode || mode == menuMode || type != P_MENU)
+			if (!menuHasChildItems(child))
+				updateMenuList(item, 0);
+			else if (item->isExpanded())
 				updateMenuList(item, child);
 			else
-				updateMenuList(item, 0);
+				item->setChildIndicatorPolicy(child->list ?
+					QTreeWidgetItem::ShowIndicator :
+					QTreeWidgetItem::DontShowIndicatorWhenChildless);
 			last = item;
 			continue;
 		}
@@ -654,7 +709,6 @@ void ConfigList::updateMenuList(ConfigList *parent, struct menu* menu)
 	ConfigItem* item;
 	ConfigItem* last;
 	bool visible;
-	enum prop_type type;
 
 	if (!menu) {
 		while (parent->topLevelItemCount() > 0)
@@ -670,7 +724,6 @@ void ConfigList::updateMenuList(ConfigList *parent, struct menu* menu)
 		last = 0;
 	for (child = menu->list; child; child = child->next) {
 		item = last ? last->nextSibling() : (ConfigItem*)parent->topLevelItem(0);
-		type = child->prompt ? child->prompt->type : P_UNKNOWN;
 
 		switch (mode) {
 		case menuMode:
@@ -694,10 +747,14 @@ void ConfigList::updateMenuList(ConfigList *parent, struct menu* menu)
 			else
 				item->testUpdateMenu(visible);
 
-			if (mode == fullMode || mode == menuMode || type != P_MENU)
+			if (!menuHasChildItems(child))
+				updateMenuList(item, 0);
+			else if (item->isExpanded())
 				updateMenuList(item, child);
 			else
-				updateMenuList(item, 0);
+				item->setChildIndicatorPolicy(child->list ?
+					QTreeWidgetItem::ShowIndicator :
+					QTreeWidgetItem::DontShowIndicatorWhenChildless);
 			last = item;
 			continue;
 		}
@@ -1249,8 +1306,12 @@ void ConfigInfoView::contextMenuEvent(QContextMenuEvent *e)
 	Parent::contextMenuEvent(e);
 }
 
+/* Matches listed at most, and added to the list at a time */
+static const int searchMax = 1000;
+static const int searchBatch = 100;
+
 ConfigSearchWindow::ConfigSearchWindow(ConfigMainWindow* parent, const char *name)
-	: Parent(parent), result(NULL)
+	: Parent(parent), result(NULL), next(NULL), lastItem(NULL)
 {
 	setObjectName(name);
 	setWindowTitle("Search Config");
@@ -1271,6 +1332,14 @@ ConfigSearchWindow::ConfigSearchWindow(ConfigMainWindow* parent, const char *nam
 	layout2->addWidget(searchButton);
 	layout1->addLayout(layout2);
 
+	/* search as you type, once typing pauses */
+	searchTimer = new QTimer(this);
+	searchTimer->setSingleShot(true);
+	searchTimer->setInterval(150);
+	connect(searchTimer, SIGNAL(timeout()), SLOT(search()));
+	connect(editField, SIGNAL(textChanged(const QString &)),
+		searchTimer, SLOT(start()));
+
 	split = new QSplitter(this);
 	split->setOrientation(Qt::Vertical);
 	list = new ConfigView(split, name);
@@ -1280,6 +1349,8 @@ ConfigSearchWindow::ConfigSearchWindow(ConfigMainWindow* parent, const char *nam
 		info, SLOT(setInfo(struct menu *)));
 	connect(list->list, SIGNAL(menuChanged(struct menu *)),
 		parent, SLOT(setMenuLink(struct menu *)));
+	connect(list->list->verticalScrollBar(), SIGNAL(valueChanged(int)),
+		SLOT(scrolled(int)));
 
 	layout1->addWidget(split);
 
@@ -1317,26 +1388,58 @@ void ConfigSearchWindow::saveSettings(void)
 	}
 }
 
+/*
+ * Plain text is looked up in the search index, best matches first;
+ * anything that looks like a regular expression is matched against
+ * symbol names as before. Items are only created for the first
+ * matches, and for more as the list is scrolled to its end.
+ */
 void ConfigSearchWindow::search(void)
 {
-	struct symbol **p;
-	struct property *prop;
-	ConfigItem *lastItem = NULL;
+	QByteArray text = editField->text().toLatin1();
+	int count = 0;
 
+	searchTimer->stop();
 	free(result);
+	result = next = NULL;
+	lastItem = NULL;
 	list->list->clear();
 	info->clear();
 
-	result = sym_re_search(editField->text().toLatin1());
-	if (!result)
-		return;
-	for (p = result; *p; p++) {
-		for_all_prompts((*p), prop)
+	if (strpbrk(text.constData(), "^$.*+?()[]{}|\\")) {
+		result = sym_re_search(text.constData());
+		while (result && result[count])
+			count++;
+	} else {
+		result = sym_search(text.constData(), searchMax, &count);
+	}
+	if (text.isEmpty())
+		setWindowTitle("Search Config");
+	else
+		setWindowTitle(QString("Search Config (%1 found)").arg(count));
+
+	next = result;
+	showMore();
+}
+
+void ConfigSearchWindow::showMore(void)
+{
+	struct property *prop;
+	int n;
+
+	for (n = 0; next && *next && n < searchBatch; next++, n++) {
+		for_all_prompts((*next), prop)
 			lastItem = new ConfigItem(list->list, lastItem, prop->menu,
 						  menu_is_visible(prop->menu));
 	}
 }
 
+void ConfigSearchWindow::scrolled(int value)
+{
+	if (value == list->list->verticalScrollBar()->maximum())
+		showMore();
+}
+
 /*
  * Construct the complete config widget
  */
@@ -1614,7 +1717,7 @@ void ConfigMainWindow::setMenuLink(struct menu *menu)
 	}
 
 	if (list) {
-		item = list->findConfigItem(menu);
+		item = list->revealConfigItem(menu);
 		if (item) {
 			item->setSelected(true);
 			list->scrollToItem(item);
@@ -14,6 +14,7 @@
 #include <QSplitter>
 #include <QCheckBox>
 #include <QDialog>
+#include <QTimer>
 #include "expr.h"
 
 class ConfigView;
@@ -50,6 +51,7 @@ public:
 		return (ConfigView*)Parent::parent();
 	}
 	ConfigItem* findConfigItem(struct menu *);
+	ConfigItem* revealConfigItem(struct menu *);
 
 protected:
 	void keyPressEvent(QKeyEvent *e);
@@ -68,6 +70,7 @@ public slots:
 	void changeValue(ConfigItem* item);
 	void updateSelection(void);
 	void saveSettings(void);
+	void populateItem(QTreeWidgetItem *item);
 signals:
 	void menuChanged(struct menu *menu);
 	void menuSelected(struct menu *menu);
@@ -102,6 +105,7 @@ public:
 
 	bool menuSkip(struct menu *);
 
+	bool menuHasChildItems(struct menu *);
 	void updateMenuList(ConfigItem *parent, struct menu*);
 	void updateMenuList(ConfigList *parent, struct menu*);
 
@@ -277,15 +281,20 @@ public:
 public slots:
 	void saveSettings(void);
 	void search(void);
+	void showMore(void);
+	void scrolled(int value);
 
 protected:
 	QLineEdit* editField;
 	QPushButton* searchButton;
+	QTimer* searchTimer;
 	QSplitter* split;
 	ConfigView* list;
 	ConfigInfoView* info;
 
 	struct symbol **result;
+	struct symbol **next;
+	ConfigItem *lastItem;
 };
 
 class ConfigMainWindow : public QMainWindow {
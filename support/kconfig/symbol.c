@@ -495,6 +495,12 @@ void sym_calc_value(struct symbol *sym)
 
 	if (sym->flags & SYMBOL_NEED_SET_CHOICE_VALUES)
 		set_all_choice_values(sym);
+
+	/*
+	 * Values calculated meanwhile may have seen curr before it was
+	 * final, or symbols that were valid then and are not anymore.
+	 */
+	expr_invalidate_values();
 }
 
 void sym_clear_all_valid(void)
@@ -504,10 +510,134 @@ void sym_clear_all_valid(void)
 
 	for_all_symbols(i, sym)
 		sym->flags &= ~SYMBOL_VALID;
+	expr_invalidate_values();
 	sym_add_change_count(1);
 	sym_calc_value(modules_sym);
 }
 
+/* Record that dep's value is calculated from sym's */
+static void sym_add_dependent(struct symbol *sym, struct symbol *dep)
+{
+	int n;
+
+	if (!sym || sym == dep || sym->flags & SYMBOL_CONST)
+		return;
+	n = sym->dependents_count;
+	/* dep's references are all added in a row */
+	if (n && sym->dependents[n - 1] == dep)
+		return;
+	/* grow to the next power of two when full */
+	if (!(n & (n - 1)))
+		sym->dependents = xrealloc(sym->dependents,
+					   (n ? 2 * n : 1) * sizeof(*sym->dependents));
+	sym->dependents[n] = dep;
+	sym->dependents_count = n + 1;
+}
+
+static void sym_expr_add_dependents(struct expr *e, struct symbol *dep)
+{
+	if (!e)
+		return;
+	switch (e->type) {
+	case E_OR:
+	case E_AND:
+		sym_expr_add_dependents(e->left.expr, dep);
+		sym_expr_add_dependents(e->right.expr, dep);
+		break;
+	case E_NOT:
+		sym_expr_add_dependents(e->left.expr, dep);
+		break;
+	case E_LIST:
+		sym_add_dependent(e->right.sym, dep);
+		sym_expr_add_dependents(e->left.expr, dep);
+		break;
+	case E_EQUAL:
+	case E_UNEQUAL:
+	case E_LTH:
+	case E_LEQ:
+	case E_GTH:
+	case E_GEQ:
+	case E_RANGE:
+		sym_add_dependent(e->left.sym, dep);
+		sym_add_dependent(e->right.sym, dep);
+		break;
+	case E_SYMBOL:
+		sym_add_dependent(e->left.sym, dep);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Build the reverse of everything sym_calc_value() reads: the
+ * expressions of a symbol's prompts, defaults and ranges, its direct,
+ * reverse and implied dependencies, and its choice, whose P_CHOICE
+ * property lists the values while each value's names the choice.
+ * Selects and implies are left out; they are already folded into their
+ * targets' rev_dep and implied.
+ */
+void sym_init_dependents(void)
+{
+	struct symbol *sym;
+	struct property *prop;
+	int i;
+
+	for_all_symbols(i, sym) {
+		sym_expr_add_dependents(sym->dir_dep.expr, sym);
+		sym_expr_add_dependents(sym->rev_dep.expr, sym);
+		sym_expr_add_dependents(sym->implied.expr, sym);
+		for (prop = sym->prop; prop; prop = prop->next) {
+			if (prop->type == P_SELECT || prop->type == P_IMPLY)
+				continue;
+			sym_expr_add_dependents(prop->visible.expr, sym);
+			sym_expr_add_dependents(prop->expr, sym);
+		}
+	}
+}
+
+static unsigned int sym_clear_gen;
+
+static void sym_clear_dependents_valid(struct symbol *sym)
+{
+	int i;
+
+	if (sym->clear_gen == sym_clear_gen)
+		return;
+	sym->clear_gen = sym_clear_gen;
+	sym->flags &= ~SYMBOL_VALID;
+	for (i = 0; i < sym->dependents_count; i++)
+		sym_clear_dependents_valid(sym->dependents[i]);
+}
+
+/*
+ * The user value of sym changed: invalidate it and everything calculated
+ * from it, transitively. A change that reaches the modules symbol still
+ * invalidates everything, as every tristate depends on it. Setting
+ * KCONFIG_FULL_RECALC in the environment always does, to cross-check
+ * the dependency graph against a full recalculation.
+ */
+void sym_clear_valid(struct symbol *sym)
+{
+	static int full_recalc = -1;
+
+	if (full_recalc < 0)
+		full_recalc = getenv("KCONFIG_FULL_RECALC") != NULL;
+	if (full_recalc) {
+		sym_clear_all_valid();
+		return;
+	}
+
+	sym_clear_gen++;
+	sym_clear_dependents_valid(sym);
+	if (modules_sym->clear_gen == sym_clear_gen) {
+		sym_clear_all_valid();
+		return;
+	}
+	expr_invalidate_values();
+	sym_add_change_count(1);
+}
+
 bool sym_tristate_within_range(struct symbol *sym, tristate val)
 {
 	int type = sym_get_type(sym);
@@ -560,7 +690,7 @@ bool sym_set_tristate_value(struct symbol *sym, tristate val)
 
 	sym->def[S_DEF_USER].tri = val;
 	if (oldval != val)
-		sym_clear_all_valid();
+		sym_clear_valid(sym);
 
 	return true;
 }
@@ -717,7 +847,7 @@ bool sym_set_string_value(struct symbol *sym, const char *newval)
 
 	strcpy(val, newval);
 	free((void *)oldval);
-	sym_clear_all_valid();
+	sym_clear_valid(sym);
 
 	return true;
 }
@@ -838,11 +968,42 @@ static unsigned strhash(const char *s)
 	return hash;
 }
 
+static void sym_table_insert(struct symbol *sym, unsigned hash)
+{
+	unsigned mask = symbol_table.size - 1;
+	unsigned i = hash & mask;
+
+	while (symbol_table.syms[i])
+		i = (i + 1) & mask;
+	symbol_table.syms[i] = sym;
+	symbol_table.hash[i] = hash;
+}
+
+/* Double the table (or create it) and rehash every symbol into it */
+static void sym_table_grow(void)
+{
+	struct symbol **syms = symbol_table.syms;
+	unsigned *hash = symbol_table.hash;
+	int i, size = symbol_table.size;
+
+	symbol_table.size = size ? size * 2 : SYMBOL_TABLE_MIN;
+	symbol_table.syms = xcalloc(symbol_table.size, sizeof(*syms));
+	symbol_table.hash = xcalloc(symbol_table.size, sizeof(*hash));
+	for (i = 0; i < size; i++)
+		if (syms[i])
+			sym_table_insert(syms[i], hash[i]);
+	free(syms);
+	free(hash);
+}
+
 struct symbol *sym_lookup(const char *name, int flags)
 {
 	struct symbol *symbol;
-	char *new_name;
-	int hash;
+	char *new_name = NULL;
+	unsigned hash = 0, mask, i;
+
+	if (!symbol_table.size)
+		sym_table_grow();
 
 	if (name) {
 		if (name[0] && !name[1]) {
@@ -852,19 +1013,25 @@ struct symbol *sym_lookup(const char *name, int flags)
 			case 'n': return &symbol_no;
 			}
 		}
-		hash = strhash(name) % SYMBOL_HASHSIZE;
-
-		for (symbol = symbol_hash[hash]; symbol; symbol = symbol->next) {
-			if (symbol->name &&
-			    !strcmp(symbol->name, name) &&
-			    (flags ? symbol->flags & flags
-				   : !(symbol->flags & (SYMBOL_CONST|SYMBOL_CHOICE))))
+		hash = strhash(name);
+		mask = symbol_table.size - 1;
+
+		for (i = hash & mask; (symbol = symbol_table.syms[i]);
+		     i = (i + 1) & mask) {
+			if (symbol_table.hash[i] != hash || !symbol->name ||
+			    strcmp(symbol->name, name))
+				continue;
+			if (flags ? symbol->flags & flags
+				  : !(symbol->flags & (SYMBOL_CONST|SYMBOL_CHOICE)))
 				return symbol;
+			/* Same name, other kind: share the name */
+			new_name = symbol->name;
 		}
-		new_name = xstrdup(name);
+		if (!new_name)
+			new_name = xstrdup(name);
 	} else {
-		new_name = NULL;
-		hash = 0;
+		/* Nameless choices are spread out rather than all at 0 */
+		hash = symbol_table.count * 0x9e3779b9U;
 	}
 
 	symbol = xmalloc(sizeof(*symbol));
@@ -873,18 +1040,20 @@ struct symbol *sym_lookup(const char *name, int flags)
 	symbol->type = S_UNKNOWN;
 	symbol->flags |= flags;
 
-	symbol->next = symbol_hash[hash];
-	symbol_hash[hash] = symbol;
+	if (2 * (symbol_table.count + 1) > symbol_table.size)
+		sym_table_grow();
+	sym_table_insert(symbol, hash);
+	symbol_table.count++;
 
 	return symbol;
 }
 
 struct symbol *sym_find(const char *name)
 {
-	struct symbol *symbol = NULL;
-	int hash = 0;
+	struct symbol *symbol;
+	unsigned hash, mask, i;
 
-	if (!name)
+	if (!name || !symbol_table.size)
 		return NULL;
 
 	if (name[0] && !name[1]) {
@@ -894,16 +1063,18 @@ struct symbol *sym_find(const char *name)
 		case 'n': return &symbol_no;
 		}
 	}
-	hash = strhash(name) % SYMBOL_HASHSIZE;
+	hash = strhash(name);
+	mask = symbol_table.size - 1;
 
-	for (symbol = symbol_hash[hash]; symbol; symbol = symbol->next) {
-		if (symbol->name &&
+	for (i = hash & mask; (symbol = symbol_table.syms[i]);
+	     i = (i + 1) & mask) {
+		if (symbol_table.hash[i] == hash && symbol->name &&
 		    !strcmp(symbol->name, name) &&
 		    !(symbol->flags & SYMBOL_CONST))
-				break;
+			return symbol;
 	}
 
-	return symbol;
+	return NULL;
 }
 
 /*
@@ -1090,6 +1261,233 @@ sym_re_search_free:
 	return sym_arr;
 }
 
+/*
+ * Literal, case-insensitive search over symbol names, prompts and help
+ * texts. The first search indexes every symbol by the trigrams of its
+ * text; later ones only check the symbols listed under the query's
+ * rarest trigram.
+ */
+struct sym_search_entry {
+	struct symbol *sym;
+	char *text;		/* lower case: name \n prompts \n help */
+	int name_len;
+	int prompts_end;
+};
+
+struct sym_search_posting {
+	unsigned int trigram;	/* 0 for an empty slot */
+	int count;
+	int *entries;		/* ascending */
+};
+
+static struct sym_search_entry *sym_search_entries;
+static int sym_search_nentries;
+static struct sym_search_posting *sym_search_table;
+static unsigned int sym_search_size;	/* a power of two */
+
+static unsigned int sym_search_trigram(const char *p)
+{
+	return (unsigned char)p[0] << 16 | (unsigned char)p[1] << 8 |
+	       (unsigned char)p[2];
+}
+
+static struct sym_search_posting *sym_search_slot(unsigned int trigram)
+{
+	unsigned int i = (trigram * 0x9e3779b9U) & (sym_search_size - 1);
+
+	while (sym_search_table[i].trigram &&
+	       sym_search_table[i].trigram != trigram)
+		i = (i + 1) & (sym_search_size - 1);
+	return &sym_search_table[i];
+}
+
+static void sym_search_add(unsigned int trigram, int entry)
+{
+	struct sym_search_posting *post = sym_search_slot(trigram);
+	int n = post->count;
+
+	if (!post->trigram)
+		post->trigram = trigram;
+	else if (post->entries[n - 1] == entry)
+		return;
+	/* grow to the next power of two when full */
+	if (!(n & (n - 1)))
+		post->entries = xrealloc(post->entries,
+					 (n ? 2 * n : 1) * sizeof(*post->entries));
+	post->entries[n] = entry;
+	post->count = n + 1;
+}
+
+static void sym_search_append(struct gstr *gs, const char *s)
+{
+	str_append(gs, "\n");
+	str_append(gs, s);
+}
+
+static void sym_search_init(void)
+{
+	struct symbol *sym;
+	struct property *prop;
+	struct gstr gs;
+	char *p;
+	int i, n;
+
+	sym_search_entries = xcalloc(symbol_table.count + 1,
+				     sizeof(*sym_search_entries));
+	for_all_symbols(i, sym) {
+		struct sym_search_entry *ent;
+
+		if (sym->flags & SYMBOL_CONST || !sym->name)
+			continue;
+		ent = &sym_search_entries[sym_search_nentries++];
+		ent->sym = sym;
+		ent->name_len = strlen(sym->name);
+		gs = str_new();
+		str_append(&gs, sym->name);
+		for_all_prompts(sym, prop)
+			sym_search_append(&gs, prop->text);
+		ent->prompts_end = strlen(str_get(&gs));
+		for_all_prompts(sym, prop)
+			if (prop->menu && prop->menu->help)
+				sym_search_append(&gs, prop->menu->help);
+		ent->text = xstrdup(str_get(&gs));
+		str_free(&gs);
+		for (p = ent->text; *p; p++)
+			*p = tolower((unsigned char)*p);
+	}
+
+	/* at most one posting per three bytes of text, kept half empty */
+	for (n = 0, i = 0; i < sym_search_nentries; i++)
+		n += strlen(sym_search_entries[i].text) / 3;
+	for (sym_search_size = 1024; sym_search_size < 2U * n; sym_search_size *= 2)
+		;
+	sym_search_table = xcalloc(sym_search_size, sizeof(*sym_search_table));
+	for (i = 0; i < sym_search_nentries; i++) {
+		for (p = sym_search_entries[i].text; p[0] && p[1] && p[2]; p++) {
+			if (p[0] == '\n' || p[1] == '\n' || p[2] == '\n')
+				continue;
+			sym_search_add(sym_search_trigram(p), i);
+		}
+	}
+}
+
+struct sym_search_hit {
+	struct symbol *sym;
+	int rank;
+};
+
+/*
+ * Rank a match, best first: the whole name; whole words of the name,
+ * between underscores; the start of a word; elsewhere in the name; a
+ * prompt; the help text.
+ */
+static int sym_search_rank(const struct sym_search_entry *ent, const char *text)
+{
+	const char *name = ent->text, *p = strstr(name, text);
+	int len = strlen(text), rank = 3;
+
+	if (!p)
+		return -1;
+	if (p - name >= ent->name_len)
+		return p - name < ent->prompts_end ? 4 : 5;
+	if (len == ent->name_len)
+		return 0;
+	for (; p && p - name + len <= ent->name_len; p = strstr(p + 1, text)) {
+		if (p != name && p[-1] != '_')
+			continue;
+		if (p[len] == '_' || p - name + len == ent->name_len)
+			return 1;
+		rank = 2;
+	}
+	return rank;
+}
+
+static int sym_search_comp(const void *hit1, const void *hit2)
+{
+	const struct sym_search_hit *h1 = hit1;
+	const struct sym_search_hit *h2 = hit2;
+	int len1, len2;
+
+	if (h1->rank != h2->rank)
+		return h1->rank - h2->rank;
+	len1 = strlen(h1->sym->name);
+	len2 = strlen(h2->sym->name);
+	if (len1 != len2)
+		return len1 - len2;
+	return strcmp(h1->sym->name, h2->sym->name);
+}
+
+/*
+ * Look for text in symbol names, prompts and help texts. Returns the
+ * best ranked max matching symbols, or all of them when max is 0, as a
+ * NULL terminated array to free(); NULL when there are none. *count,
+ * if given, is set to the number of matching symbols.
+ */
+struct symbol **sym_search(const char *text, int max, int *count)
+{
+	struct sym_search_posting *post = NULL;
+	struct sym_search_hit *hits;
+	struct symbol **sym_arr = NULL;
+	char *query, *p;
+	int i, n, len, cnt = 0;
+
+	if (count)
+		*count = 0;
+	len = strlen(text);
+	if (!len)
+		return NULL;
+	if (!sym_search_entries)
+		sym_search_init();
+
+	query = xstrdup(text);
+	for (p = query; *p; p++)
+		*p = tolower((unsigned char)*p);
+
+	/* the query's rarest trigram; shorter ones check every symbol */
+	for (i = 0; i + 3 <= len; i++) {
+		struct sym_search_posting *q = sym_search_slot(sym_search_trigram(query + i));
+
+		if (!q->trigram) {
+			free(query);
+			return NULL;
+		}
+		if (!post || q->count < post->count)
+			post = q;
+	}
+	n = post ? post->count : sym_search_nentries;
+
+	hits = xmalloc((n ? n : 1) * sizeof(*hits));
+	for (i = 0; i < n; i++) {
+		struct sym_search_entry *ent;
+		int rank;
+
+		ent = &sym_search_entries[post ? post->entries[i] : i];
+		rank = sym_search_rank(ent, query);
+		if (rank < 0)
+			continue;
+		hits[cnt].sym = ent->sym;
+		hits[cnt++].rank = rank;
+	}
+	free(query);
+
+	if (count)
+		*count = cnt;
+	if (cnt) {
+		qsort(hits, cnt, sizeof(*hits), sym_search_comp);
+		if (max > 0 && cnt > max)
+			cnt = max;
+		sym_arr = xmalloc((cnt + 1) * sizeof(*sym_arr));
+		for (i = 0; i < cnt; i++) {
+			sym_calc_value(hits[i].sym);
+			sym_arr[i] = hits[i].sym;
+		}
+		sym_arr[cnt] = NULL;
+	}
+	free(hits);
+
+	return sym_arr;
+}
+
 /*
  * When we check for recursive dependencies we use a stack to save
  * current state so we can print out relevant info to user.
@@ -1430,3 +1828,35 @@ static void prop_add_env(const char *env)
 	else
 		menu_warn(current_entry, "environment variable %s undefined", env);
 }
+
+/*
+ * Take the values of environment symbols from the environment again, as
+ * if the Kconfig files had been parsed under the current one
+ */
+void sym_env_reload(void)
+{
+	struct symbol *sym;
+	struct property *env, *prop, *def;
+	struct menu *entry;
+	struct expr *e;
+	const char *p;
+
+	expr_list_for_each_sym(sym_env_list, e, sym) {
+		env = sym_get_env_prop(sym);
+		p = getenv(prop_get_symbol(env)->name);
+		def = NULL;
+		/* prop_add_env() gave it its default along with the env */
+		for_all_defaults(sym, prop)
+			if (prop->menu == env->menu)
+				def = prop;
+		if (def) {
+			def->expr->left.sym = sym_lookup(p ? p : "", SYMBOL_CONST);
+		} else if (p) {
+			entry = current_entry;
+			current_entry = env->menu;
+			sym_add_default(sym, p);
+			current_entry = entry;
+		}
+	}
+	sym_clear_all_valid();
+}
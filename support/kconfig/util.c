@@ -31,6 +31,40 @@ struct file *file_lookup(const char *name)
 	return file;
 }
 
+/*
+ * move a freshly written file over name, unless name already has the
+ * same content: then the new one is dropped and name keeps its mtime
+ * returns 1 if name was replaced, 0 if it was kept, -1 on error
+ */
+int file_replace(const char *tmp, const char *name)
+{
+	char buf[4096], old[4096];
+	FILE *in, *cur;
+	size_t n;
+	int same;
+
+	in = fopen(tmp, "r");
+	if (!in)
+		return -1;
+	cur = fopen(name, "r");
+	same = cur != NULL;
+	while (same) {
+		n = fread(buf, 1, sizeof(buf), in);
+		if (fread(old, 1, sizeof(old), cur) != n ||
+		    memcmp(buf, old, n))
+			same = 0;
+		else if (n < sizeof(buf))
+			break;
+	}
+	fclose(in);
+	if (cur)
+		fclose(cur);
+
+	if (same)
+		return unlink(tmp) ? -1 : 0;
+	return rename(tmp, name) ? -1 : 1;
+}
+
 /* write a dependency file as used by kbuild to track dependencies */
 int file_write_dep(const char *name)
 {
@@ -84,7 +118,7 @@ int file_write_dep(const char *name)
 	fprintf(out, "\n$(deps_config): ;\n");
 	fclose(out);
 	sprintf(buf2, "%s%s", dir, name);
-	rename(buf, buf2);
+	file_replace(buf, buf2);
 	return 0;
 }
 
@@ -26,7 +26,7 @@ static void zconfprint(const char *err, ...);
 static void zconf_error(const char *err, ...);
 static bool zconf_endtoken(const struct kconf_id *id, int starttoken, int endtoken);
 
-struct symbol *symbol_hash[SYMBOL_HASHSIZE];
+struct symbol_table symbol_table;
 
 static struct menu *current_menu, *current_entry;
 
@@ -532,6 +532,12 @@ void conf_parse(const char *name)
 	struct symbol *sym;
 	int i;
 
+	if (conf_cache_load(name)) {
+		sym_init_dependents();
+		sym_set_change_count(1);
+		return;
+	}
+
 	zconf_initscan(name);
 
 	sym_init();
@@ -557,6 +563,8 @@ void conf_parse(const char *name)
 	}
 	if (yynerrs)
 		exit(1);
+	conf_cache_save(name);
+	sym_init_dependents();
 	sym_set_change_count(1);
 }
 
@@ -780,3 +788,4 @@ void zconfdump(FILE *out)
 #include "expr.c"
 #include "symbol.c"
 #include "menu.c"
+#include "cache.c"
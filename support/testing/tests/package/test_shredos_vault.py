@@ -0,0 +1,157 @@
+import json
+import os
+import subprocess
+import time
+
+import infra.basetest
+
+
+class TestShredOSVault(infra.basetest.BRTest):
+    # Performance regression test for shredos-vault: boot time, password
+    # check latency, LUKS format time and wipe throughput per algorithm
+    # on a virtio-blk and an NVMe scratch disk, each compared against
+    # test_shredos_vault/baseline.json.
+    # - The kernel fragment adds NVMe and dm-crypt to the x86_64 config,
+    # - libxcrypt provides crypt() for the password hash,
+    # - the benchmark tools are installed with the package's BENCH
+    #   option.
+    kern_frag = \
+        infra.filepath("tests/package/test_shredos_vault/linux-shredos-vault.fragment")
+    baseline_file = \
+        infra.filepath("tests/package/test_shredos_vault/baseline.json")
+    config = \
+        f"""
+        BR2_x86_64=y
+        BR2_x86_corei7=y
+        BR2_TOOLCHAIN_EXTERNAL=y
+        BR2_LINUX_KERNEL=y
+        BR2_LINUX_KERNEL_CUSTOM_VERSION=y
+        BR2_LINUX_KERNEL_CUSTOM_VERSION_VALUE="6.1.148"
+        BR2_LINUX_KERNEL_USE_CUSTOM_CONFIG=y
+        BR2_LINUX_KERNEL_CUSTOM_CONFIG_FILE="board/qemu/x86_64/linux.config"
+        BR2_LINUX_KERNEL_CONFIG_FRAGMENT_FILES="{kern_frag}"
+        BR2_LINUX_KERNEL_NEEDS_HOST_OPENSSL=y
+        BR2_LINUX_KERNEL_NEEDS_HOST_LIBELF=y
+        BR2_PACKAGE_LIBXCRYPT=y
+        BR2_PACKAGE_SHREDOS_VAULT=y
+        BR2_PACKAGE_SHREDOS_VAULT_BENCH=y
+        BR2_TARGET_ROOTFS_CPIO=y
+        BR2_TARGET_ROOTFS_CPIO_GZIP=y
+        # BR2_TARGET_ROOTFS_TAR is not set
+        """
+
+    disk_size_mb = 256
+    wipe_size_mb = 64
+    algorithms = ["zero", "random", "dodshort"]
+    auth_names = ["hash", "verify_p50", "verify_max", "luks_profile",
+                  "luks_format", "luks_total"]
+
+    def make_disk(self, name):
+        disk_file = os.path.join(self.builddir, "images", name)
+        self.emulator.logfile.write(f"Creating disk image: {disk_file}\n")
+        subprocess.check_call(
+            ["truncate", "-s", f"{self.disk_size_mb}M", disk_file],
+            stdout=self.emulator.logfile,
+            stderr=self.emulator.logfile)
+        return disk_file
+
+    def bench_lines(self, cmd, timeout):
+        out, ret = self.emulator.run(cmd, timeout=timeout)
+        self.assertEqual(ret, 0, "\n".join(out))
+        return out
+
+    def wipe_rate(self, dev, algorithm):
+        # vault-wipe-bench prints a header, then one line per run with
+        # the throughput in MB/s in its sixth column; the engine's
+        # warnings share the console.
+        cmd = f"vault-wipe-bench -y -s {self.wipe_size_mb} -a {algorithm} {dev}"
+        out = self.bench_lines(cmd, timeout=600)
+        runs = [line.split() for line in out
+                if line.split()[:1] == [algorithm]]
+        self.assertEqual(len(runs), 1, "\n".join(out))
+        return float(runs[0][5])
+
+    def auth_metrics(self, dev):
+        # vault-auth-bench prints "name milliseconds" lines.
+        cmd = f"vault-auth-bench -n 10 -y -l {dev}"
+        out = self.bench_lines(cmd, timeout=300)
+        metrics = {}
+        for line in out:
+            fields = line.split()
+            if len(fields) == 2 and fields[0] in self.auth_names:
+                metrics[fields[0]] = float(fields[1])
+        self.assertEqual(sorted(metrics), sorted(self.auth_names),
+                         "\n".join(out))
+        return metrics
+
+    def check_baselines(self, results):
+        with open(self.baseline_file) as f:
+            baselines = json.load(f)
+
+        if os.environ.get("VAULT_PERF_RECORD"):
+            for name, value in results.items():
+                baselines[name]["baseline"] = round(value, 1)
+            with open(self.baseline_file, "w") as f:
+                json.dump(baselines, f, indent=4)
+                f.write("\n")
+
+        # Slow runners get the same slack as their timeouts.
+        slack = self.timeout_multiplier
+        failures = []
+        for name, value in sorted(results.items()):
+            ref = baselines[name]
+            base = ref["baseline"]
+            msg = f"{name}: {value:.1f} (baseline {base})"
+            self.emulator.logfile.write(msg + "\n")
+            if base is None:
+                continue
+            if ref["better"] == "lower":
+                limit = base * (1 + ref["tolerance"]) * slack
+                if value > limit:
+                    failures.append(f"{msg}, limit {limit:.1f}")
+            else:
+                limit = base * (1 - ref["tolerance"]) / slack
+                if value < limit:
+                    failures.append(f"{msg}, limit {limit:.1f}")
+
+        self.assertEqual(failures, [], "performance regression:\n" +
+                         "\n".join(failures))
+
+    def test_run(self):
+        virtio_disk = self.make_disk("vault-virtio.img")
+        nvme_disk = self.make_disk("vault-nvme.img")
+
+        img = os.path.join(self.builddir, "images", "rootfs.cpio.gz")
+        kern = os.path.join(self.builddir, "images", "bzImage")
+
+        bootargs = ["console=ttyS0"]
+        qemu_opts = ["-M", "pc", "-cpu", "Nehalem", "-smp", "2",
+                     "-m", "512M", "-initrd", img,
+                     "-drive", f"file={virtio_disk},if=none,id=vd,format=raw",
+                     "-device", "virtio-blk-pci,drive=vd",
+                     "-drive", f"file={nvme_disk},if=none,id=nv,format=raw",
+                     "-device", "nvme,serial=vault,drive=nv"]
+
+        results = {}
+        start = time.monotonic()
+        self.emulator.boot(arch="x86_64",
+                           kernel=kern,
+                           kernel_cmdline=bootargs,
+                           options=qemu_opts)
+        self.emulator.login()
+        results["boot_s"] = time.monotonic() - start
+
+        self.assertRunOk("shredos-vault --help")
+
+        disks = {"virtio": "/dev/vda", "nvme": "/dev/nvme0n1"}
+        for name, dev in disks.items():
+            for algorithm in self.algorithms:
+                results[f"wipe_{name}_{algorithm}"] = \
+                    self.wipe_rate(dev, algorithm)
+
+        # Last: it leaves a LUKS header on the disk.
+        metrics = self.auth_metrics(disks["virtio"])
+        results["verify_p50_ms"] = metrics["verify_p50"]
+        results["luks_total_ms"] = metrics["luks_total"]
+
+        self.check_baselines(results)
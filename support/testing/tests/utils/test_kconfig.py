@@ -0,0 +1,50 @@
+"""Test cases for the kconfig .config reader.
+
+It does not inherit from infra.basetest.BRTest and therefore does not generate
+a logfile. Only when the tests fail there will be output to the console.
+
+A full .config, generated from a defconfig, is read back by olddefconfig: the
+result must be identical and the reader must not warn about any line. The
+defconfig sets strings, such as the GRUB2 builtin modules, that differ from
+their defaults, so a value lost while reading shows up in the comparison.
+"""
+import filecmp
+import os
+import shutil
+import subprocess
+import tempfile
+import unittest
+
+import infra
+
+
+class TestKconfigRoundTrip(unittest.TestCase):
+    defconfig = "shredos_defconfig"
+
+    def setUp(self):
+        self.output = tempfile.mkdtemp(prefix="test-kconfig-")
+
+    def tearDown(self):
+        shutil.rmtree(self.output)
+
+    def make(self, target):
+        """Run a make target in the test's output directory and return its
+        output as a list of lines."""
+        out = subprocess.check_output(["make", "O=" + self.output, target],
+                                      cwd=infra.basepath(),
+                                      stderr=subprocess.STDOUT,
+                                      universal_newlines=True)
+        return out.splitlines()
+
+    def test_olddefconfig_round_trip(self):
+        config = os.path.join(self.output, ".config")
+        generated = os.path.join(self.output, "generated.config")
+
+        self.make(self.defconfig)
+        shutil.copyfile(config, generated)
+        out = self.make("olddefconfig")
+
+        warnings = [line for line in out if "warning:" in line]
+        self.assertEqual(warnings, [])
+        self.assertTrue(filecmp.cmp(generated, config, shallow=False),
+                        "olddefconfig changed the generated .config")
@@ -24,6 +24,10 @@
 #include <errno.h>
 #include <time.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
 
 #ifdef BR_CCACHE
 static char ccache_path[PATH_MAX];
@@ -43,6 +47,9 @@ static char _date_[sizeof("-D__DATE__=\"MMM DD YYYY\"")];
 static char *predef_args[] = {
 #ifdef BR_CCACHE
 	ccache_path,
+#endif
+#ifdef BR_DISTCC
+	BR_DISTCC,
 #endif
 	path,
 	"--sysroot", sysroot,
@@ -228,13 +235,137 @@ bool parse_source_date_epoch_from_env(void)
 }
 #endif
 
+/* Returns the first argument that names a source file, or "-". */
+static const char *telemetry_source(char **args)
+{
+	static const char *const exts[] = {
+		".c", ".cc", ".cpp", ".cxx", ".C", ".S", ".s", ".m", NULL
+	};
+	const char *ext;
+	int i, j;
+
+	for (i = 1; args[i]; i++) {
+		if (args[i][0] == '-') {
+			/* Options whose value is a separate argument */
+			if (!strcmp(args[i], "-o") || !strcmp(args[i], "-MF") ||
+			    !strcmp(args[i], "-MT") || !strcmp(args[i], "-MQ") ||
+			    !strcmp(args[i], "-include") || !strcmp(args[i], "-x"))
+				i++;
+			if (!args[i])
+				break;
+			continue;
+		}
+		ext = strrchr(args[i], '.');
+		if (!ext)
+			continue;
+		for (j = 0; exts[j]; j++)
+			if (!strcmp(ext, exts[j]))
+				return args[i];
+	}
+	return "-";
+}
+
+/* Run the real compiler as a child and append one record about it to
+ * the log named by BR2_COMPILE_TELEMETRY:
+ *
+ *   cwd  source  wall-ms  user-ms  sys-ms  maxrss-kB  ccache  status
+ *
+ * tab-separated, one line per invocation. The log is opened O_APPEND
+ * and every record goes out in a single write(), so concurrent
+ * wrappers never interleave and no lock is needed. ccache is "hit",
+ * "miss", or "-" when ccache was not used or could not tell.
+ *
+ * Returns the exit status to pass on, as the shell would report it.
+ */
+static int run_with_telemetry(const char *log, char **exec_args, bool ccache)
+{
+	char statslog[PATH_MAX], cwd[PATH_MAX], rec[2 * PATH_MAX + 256];
+	const char *cache = "-";
+	struct timespec start, end;
+	struct rusage ru;
+	pid_t pid;
+	int status, fd, len;
+	long wall_ms;
+
+	if (ccache) {
+		/* ccache logs the counters of each call to CCACHE_STATSLOG */
+		snprintf(statslog, sizeof(statslog), "%s.ccache.%d", log, (int)getpid());
+		setenv("CCACHE_STATSLOG", statslog, 1);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pid = fork();
+	if (pid < 0) {
+		perror(__FILE__ ": fork");
+		return 2;
+	}
+	if (pid == 0) {
+		execvp(exec_args[0], exec_args);
+		perror(exec_args[0]);
+		_exit(2);
+	}
+	while (wait4(pid, &status, 0, &ru) < 0) {
+		if (errno != EINTR) {
+			perror(__FILE__ ": wait4");
+			return 2;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (ccache) {
+		char buf[4096], *line;
+		ssize_t n;
+
+		fd = open(statslog, O_RDONLY);
+		if (fd >= 0) {
+			n = read(fd, buf, sizeof(buf) - 1);
+			close(fd);
+			/* One counter per line, after a "# <file>" header */
+			buf[n > 0 ? n : 0] = '\0';
+			for (line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+				if (line[0] == '#')
+					continue;
+				if (strstr(line, "_hit"))
+					cache = "hit";
+				else if (!strcmp(line, "cache_miss"))
+					cache = "miss";
+			}
+			unlink(statslog);
+		}
+	}
+
+	if (!getcwd(cwd, sizeof(cwd)))
+		strcpy(cwd, "-");
+	wall_ms = (end.tv_sec - start.tv_sec) * 1000 +
+		(end.tv_nsec - start.tv_nsec) / 1000000;
+	len = snprintf(rec, sizeof(rec), "%s\t%s\t%ld\t%ld\t%ld\t%ld\t%s\t%d\n",
+		cwd, telemetry_source(exec_args), wall_ms,
+		(long)ru.ru_utime.tv_sec * 1000 + ru.ru_utime.tv_usec / 1000,
+		(long)ru.ru_stime.tv_sec * 1000 + ru.ru_stime.tv_usec / 1000,
+		ru.ru_maxrss,
+		cache,
+		WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+	if (len > 0 && (size_t)len < sizeof(rec)) {
+		fd = open(log, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+		if (fd >= 0) {
+			if (write(fd, rec, len) != len)
+				perror(__FILE__ ": write");
+			close(fd);
+		}
+	}
+
+	if (WIFEXITED(status))
+		return WEXITSTATUS(status);
+	return 128 + WTERMSIG(status);
+}
+
 int main(int argc, char **argv)
 {
 	char **args, **cur, **exec_args;
 	char *relbasedir, *absbasedir;
 	char *progpath = argv[0];
 	char *basename;
-	char *env_debug;
+	char *env_debug, *env_telemetry;
 	int ret, i, count = 0, debug = 0, found_shared = 0, found_nonoption = 0;
 	size_t n_args;
 
@@ -524,12 +655,44 @@ int main(int argc, char **argv)
 	} else
 		/* ccache is disabled, skip it */
 		exec_args++;
+#endif
+#ifdef BR_DISTCC
+	/* If BR2_USE_DISTCC is set and its value is 1, hand compilations
+	 * to the distributed compiler, after the sysroot and flags above
+	 * have been added */
+	char *br_use_distcc = getenv("BR2_USE_DISTCC");
+	bool distcc_enabled = br_use_distcc && !strncmp(br_use_distcc, "1", strlen("1"));
+
+#ifdef BR_CCACHE
+	if (ccache_enabled) {
+		/* ccache runs the dispatcher itself, through CCACHE_PREFIX,
+		 * and only on a cache miss; allow it to be overridden
+		 * through the environment */
+		if (distcc_enabled && setenv("CCACHE_PREFIX", BR_DISTCC, 0)) {
+			perror(__FILE__ ": Failed to set CCACHE_PREFIX");
+			return 3;
+		}
+		exec_args[1] = exec_args[0];
+		exec_args++;
+	} else
+#endif
+	if (!distcc_enabled)
+		/* distributed compilation is disabled, skip it */
+		exec_args++;
+#ifdef BR_CCACHE_HASH
+	/* Identify the toolchain to the dispatcher and the build farm, as
+	 * CCACHE_COMPILERCHECK does to ccache */
+	if (distcc_enabled && setenv("BR2_TOOLCHAIN_HASH", BR_CCACHE_HASH, 1)) {
+		perror(__FILE__ ": Failed to set BR2_TOOLCHAIN_HASH");
+		return 3;
+	}
+#endif
 #endif
 
 	/* Debug the wrapper to see final arguments passed to the real compiler. */
 	if (debug > 0) {
 		fprintf(stderr, "Toolchain wrapper executing:");
-#ifdef BR_CCACHE_HASH
+#if defined(BR_CCACHE) && defined(BR_CCACHE_HASH)
 		if (ccache_enabled)
 			fprintf(stderr, "%sCCACHE_COMPILERCHECK='string:" BR_CCACHE_HASH "'",
 				(debug == 2) ? "\n    " : " ");
@@ -538,6 +701,11 @@ int main(int argc, char **argv)
 		if (ccache_enabled)
 			fprintf(stderr, "%sCCACHE_BASEDIR='" BR_CCACHE_BASEDIR "'",
 				(debug == 2) ? "\n    " : " ");
+#endif
+#if defined(BR_DISTCC) && defined(BR_CCACHE)
+		if (ccache_enabled && distcc_enabled)
+			fprintf(stderr, "%sCCACHE_PREFIX='%s'",
+				(debug == 2) ? "\n    " : " ", getenv("CCACHE_PREFIX"));
 #endif
 		for (i = 0; exec_args[i]; i++)
 			fprintf(stderr, "%s'%s'",
@@ -545,8 +713,23 @@ int main(int argc, char **argv)
 		fprintf(stderr, "\n");
 	}
 
-	if (execv(exec_args[0], exec_args))
-		perror(path);
+	/* Time the real compiler if BR2_COMPILE_TELEMETRY names a log
+	 * file, by absolute path since packages build in their own
+	 * directories; see run_with_telemetry(). */
+	env_telemetry = getenv("BR2_COMPILE_TELEMETRY");
+	if (env_telemetry && env_telemetry[0] == '/') {
+#ifdef BR_CCACHE
+		ret = run_with_telemetry(env_telemetry, exec_args, ccache_enabled);
+#else
+		ret = run_with_telemetry(env_telemetry, exec_args, false);
+#endif
+		free(args);
+		return ret;
+	}
+
+	/* execvp(), as the distributed compiler may be looked up in PATH */
+	if (execvp(exec_args[0], exec_args))
+		perror(exec_args[0]);
 
 	free(args);
 
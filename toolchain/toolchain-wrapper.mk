@@ -54,6 +54,10 @@ ifeq ($(BR2_CCACHE),y)
 TOOLCHAIN_WRAPPER_ARGS += -DBR_CCACHE
 endif
 
+ifeq ($(BR2_DISTCC),y)
+TOOLCHAIN_WRAPPER_ARGS += -DBR_DISTCC='"$(call qstrip,$(BR2_DISTCC_COMMAND))"'
+endif
+
 ifeq ($(BR2_x86_x1000),y)
 TOOLCHAIN_WRAPPER_ARGS += -DBR_OMIT_LOCK_PREFIX
 endif